@@ -27,6 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkGIFGrayLevelRunLength.h>
 #include <mitkGIFFirstOrderStatistics.h>
 #include <mitkGIFVolumetricStatistics.h>
+#include <mitkGIFTextureEngine.h>
 
 typedef itk::Image< double, 3 >                 FloatImageType;
 typedef itk::Image< unsigned char, 3 >          MaskImageType;
@@ -62,6 +63,7 @@ int main(int argc, char* argv[])
   parser.addArgument("description","d",mitkCommandLineParser::String,"Text","Description that is added to the output",us::Any());
   parser.addArgument("same-space", "sp", mitkCommandLineParser::String, "Bool", "Set the spacing of all images to equal. Otherwise an error will be thrown. ", us::Any());
   parser.addArgument("direction", "dir", mitkCommandLineParser::String, "Int", "Allows to specify the direction for Cooc and RL. 0: All directions, 1: Only single direction (Test purpose), 2,3,4... Without dimension 0,1,2... ", us::Any());
+  parser.addArgument("threads", "t", mitkCommandLineParser::Int, "Int", "Number of threads used for the texture features. 0: Default of the system", us::Any());
 
   // Miniapp Infos
   parser.setCategory("Classification Tools");
@@ -117,17 +119,21 @@ int main(int argc, char* argv[])
     direction = splitDouble(parsedArgs["direction"].ToString(), ';')[0];
   }
 
-  mitk::AbstractGlobalImageFeature::FeatureListType stats;
+  unsigned int numberOfThreads = 0;
+  if (parsedArgs.count("threads"))
+  {
+    numberOfThreads = us::any_cast<int>(parsedArgs["threads"]);
+  }
+
+  // All features are collected and calculated together, so that the texture features
+  // share the quantization of the image and are calculated in parallel.
+  std::vector<mitk::AbstractGlobalImageFeature::Pointer> features;
   ////////////////////////////////////////////////////////////////
   // CAlculate First Order Features
   ////////////////////////////////////////////////////////////////
   if (parsedArgs.count("first-order"))
   {
-    MITK_INFO << "Start calculating first order statistics....";
-    mitk::GIFFirstOrderStatistics::Pointer firstOrderCalculator = mitk::GIFFirstOrderStatistics::New();
-    auto localResults = firstOrderCalculator->CalculateFeatures(image, mask);
-    stats.insert(stats.end(), localResults.begin(), localResults.end());
-    MITK_INFO << "Finished calculating first order statistics....";
+    features.push_back(mitk::GIFFirstOrderStatistics::New().GetPointer());
   }
 
   ////////////////////////////////////////////////////////////////
@@ -135,11 +141,7 @@ int main(int argc, char* argv[])
   ////////////////////////////////////////////////////////////////
   if (parsedArgs.count("volume"))
   {
-    MITK_INFO << "Start calculating volumetric ....";
-    mitk::GIFVolumetricStatistics::Pointer volCalculator = mitk::GIFVolumetricStatistics::New();
-    auto localResults = volCalculator->CalculateFeatures(image, mask);
-    stats.insert(stats.end(), localResults.begin(), localResults.end());
-    MITK_INFO << "Finished calculating volumetric....";
+    features.push_back(mitk::GIFVolumetricStatistics::New().GetPointer());
   }
 
   ////////////////////////////////////////////////////////////////
@@ -149,15 +151,12 @@ int main(int argc, char* argv[])
   {
     auto ranges = splitDouble(parsedArgs["cooccurence"].ToString(),';');
 
-    for (int i = 0; i < ranges.size(); ++i)
+    for (std::size_t i = 0; i < ranges.size(); ++i)
     {
-      MITK_INFO << "Start calculating coocurence with range " << ranges[i] << "....";
       mitk::GIFCooccurenceMatrix::Pointer coocCalculator = mitk::GIFCooccurenceMatrix::New();
       coocCalculator->SetRange(ranges[i]);
       coocCalculator->SetDirection(direction);
-      auto localResults = coocCalculator->CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
-      MITK_INFO << "Finished calculating coocurence with range " << ranges[i] << "....";
+      features.push_back(coocCalculator.GetPointer());
     }
   }
 
@@ -168,17 +167,18 @@ int main(int argc, char* argv[])
   {
     auto ranges = splitDouble(parsedArgs["run-length"].ToString(),';');
 
-    for (int i = 0; i < ranges.size(); ++i)
+    for (std::size_t i = 0; i < ranges.size(); ++i)
     {
-      MITK_INFO << "Start calculating run-length with number of bins " << ranges[i] << "....";
       mitk::GIFGrayLevelRunLength::Pointer calculator = mitk::GIFGrayLevelRunLength::New();
       calculator->SetRange(ranges[i]);
-
-      auto localResults = calculator->CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
-      MITK_INFO << "Finished calculating run-length with number of bins " << ranges[i] << "....";
+      features.push_back(calculator.GetPointer());
     }
   }
+
+  MITK_INFO << "Start calculating " << features.size() << " feature classes....";
+  mitk::AbstractGlobalImageFeature::FeatureListType stats = mitk::GIFTextureEngine::CalculateFeatures(image, mask, features, numberOfThreads);
+  MITK_INFO << "Finished calculating " << features.size() << " feature classes....";
+
   for (int i = 0; i < stats.size(); ++i)
   {
     std::cout << stats[i].first << " - " << stats[i].second <<std::endl;
@@ -34,8 +34,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkCommandLineParser.h"
 
 
-
-
 int main(int argc, char* argv[])
 {
   // Setup CLI Module parsable interface
@@ -200,21 +198,11 @@ int main(int argc, char* argv[])
   forest->Train(trainDataX, trainDataY);
 
 
-  // prepare feature matrix for test case
-  auto testDataX = mitk::DCUtilities::DC3dDToMatrixXd(testCollection,features, classMap);
-  auto testDataNewY = forest->Predict(testDataX);
-
-
-  mitk::DCUtilities::MatrixToDC3d(testDataNewY, testCollection, "RESULT", classMap);
-
-  Eigen::MatrixXd Probs = forest->GetPointWiseProbabilities();
-
-
-  Eigen::MatrixXd prob0 = Probs.col(0);
-  Eigen::MatrixXd prob1 = Probs.col(1);
-
-  mitk::DCUtilities::MatrixToDC3d(prob0, testCollection,"prob0", classMap);
-  mitk::DCUtilities::MatrixToDC3d(prob1, testCollection,"prob1", classMap);
+  // classify the test case block by block
+  std::vector<std::string> probabilityNames;
+  probabilityNames.push_back("prob0");
+  probabilityNames.push_back("prob1");
+  mitk::DCUtilities::ClassifyVoxels(testCollection, forest, features, classMap, "RESULT", probabilityNames);
 
 
   std::vector<std::string> outputFilter;
@@ -338,11 +338,7 @@ int main(int argc, char* argv[])
     //////////////////////////////////////////////////////////////////////////////
     // If required do test
     //////////////////////////////////////////////////////////////////////////////
-    auto testDataX = mitk::DCUtilities::DC3dDToMatrixXd(testCollection,modalities, testMask);
-    auto testDataNewY = forest->Predict(testDataX);
-    //MITK_INFO << testDataNewY;
-
-    mitk::DCUtilities::MatrixToDC3d(testDataNewY, testCollection, resultMask, testMask);
+    mitk::DCUtilities::ClassifyVoxels(testCollection, forest, modalities, testMask, resultMask, std::vector<std::string>());
     //forest.SetMaskName(testMask);
     //forest.SetCollection(testCollection);
     //forest.Test();
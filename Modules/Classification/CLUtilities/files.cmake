@@ -11,6 +11,7 @@ set(CPP_FILES
   GlobalImageFeatures/mitkGIFGrayLevelRunLength.cpp
   GlobalImageFeatures/mitkGIFFirstOrderStatistics.cpp
   GlobalImageFeatures/mitkGIFVolumetricStatistics.cpp
+  GlobalImageFeatures/mitkGIFTextureEngine.cpp
   #GlobalImageFeatures/itkEnhancedScalarImageToRunLengthFeaturesFilter.hxx
   #GlobalImageFeatures/itkEnhancedScalarImageToRunLengthMatrixFilter.hxx
   #GlobalImageFeatures/itkEnhancedHistogramToRunLengthFeaturesFilter.hxx
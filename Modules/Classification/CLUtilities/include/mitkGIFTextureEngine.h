@@ -0,0 +1,100 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkGIFTextureEngine_h
+#define mitkGIFTextureEngine_h
+
+#include <mitkAbstractGlobalImageFeature.h>
+#include <mitkImage.h>
+#include <MitkCLUtilitiesExports.h>
+
+#include <itkObject.h>
+
+namespace mitk
+{
+  /**
+  * \brief Calculates the co-occurrence and run-length features of several global image features in one pass.
+  *
+  * The mask is cast and its bounding box, the image range and the quantization of the masked region are computed
+  * once and shared by all requests. The matrices of all requests and offset directions are then built in parallel,
+  * each from the quantized bounding box instead of a neighborhood iteration of the whole image. The features are
+  * computed by the same histogram filters as before, so the results equal those of the single feature classes.
+  *
+  * GIFCooccurenceMatrix and GIFGrayLevelRunLength use the engine with a single request. To calculate several
+  * features of the same image and mask, use CalculateFeatures() with all of them.
+  */
+  class MITKCLUTILITIES_EXPORT GIFTextureEngine : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(GIFTextureEngine, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    typedef AbstractGlobalImageFeature::FeatureListType FeatureListType;
+
+    enum RequestType { Cooccurrence, RunLength };
+
+    struct Request
+    {
+      RequestType m_Type;
+      double m_Range;             ///< distance of the co-occurrence offsets, number of bins of the run-length matrix
+      bool m_UseCtRange;          ///< run-length only, bins cover -1024.5 to 3096.5
+      unsigned int m_Direction;   ///< 0: all directions, 1: only (0,0,1), 2,3,...: without dimension 0,1,...
+      FeatureListType m_Features;
+    };
+
+    void SetImage(const Image::Pointer & image);
+    void SetMask(const Image::Pointer & mask);
+
+    /** \brief Number of threads, 0 uses the default of itk::MultiThreader. */
+    itkSetMacro(NumberOfThreads, unsigned int);
+    itkGetConstMacro(NumberOfThreads, unsigned int);
+
+    /** \brief Requests the features of GIFCooccurenceMatrix, returns the id of the request. */
+    unsigned int AddCooccurrenceRequest(double range, unsigned int direction);
+    /** \brief Requests the features of GIFGrayLevelRunLength, returns the id of the request. */
+    unsigned int AddRunLengthRequest(double range, bool useCtRange, unsigned int direction);
+    void ClearRequests();
+
+    /**
+    * \brief Calculates the features of all requests.
+    * @throw mitk::Exception Throws an exception if image or mask are missing or the calculation fails.
+    */
+    void Update();
+
+    const FeatureListType & GetFeatures(unsigned int request) const;
+
+    /**
+    * \brief Calculates the features of all given feature classes for the same image and mask.
+    *
+    * Co-occurrence and run-length features are calculated together by one engine, all other features
+    * by their own CalculateFeatures(). The result is in the order of the given features.
+    */
+    static FeatureListType CalculateFeatures(const Image::Pointer & image, const Image::Pointer & mask,
+                                             const std::vector<AbstractGlobalImageFeature::Pointer> & features,
+                                             unsigned int numberOfThreads = 0);
+
+  protected:
+    GIFTextureEngine();
+    virtual ~GIFTextureEngine();
+
+    Image::Pointer m_Image;
+    Image::Pointer m_Mask;
+    unsigned int m_NumberOfThreads;
+    std::vector<Request> m_Requests;
+  };
+}
+
+#endif //mitkGIFTextureEngine_h
@@ -0,0 +1,746 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkGIFTextureEngine.h>
+
+// MITK
+#include <mitkGIFCooccurenceMatrix.h>
+#include <mitkGIFGrayLevelRunLength.h>
+#include <mitkExceptionMacro.h>
+#include <mitkImageCast.h>
+#include <mitkImageAccessByItk.h>
+
+// ITK
+#include <itkEnhancedScalarImageToTextureFeaturesFilter.h>
+#include <itkEnhancedScalarImageToRunLengthFeaturesFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkMinimumMaximumImageCalculator.h>
+#include <itkMultiThreader.h>
+#include <itkNeighborhood.h>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+  // names of the requested features, in the order of the feature enums of the histogram filters
+  const char * const CooccurrenceFeatureNames[] = {
+    "Energy", "Entropy", "Correlation", "InverseDifferenceMoment", "Inertia", "ClusterShade", "ClusterProminence",
+    "HaralickCorrelation", "Autocorrelation", "Contrast", "Dissimilarity", "MaximumProbability", "InverseVariance",
+    "Homogeneity1", "ClusterTendency", "Variance", "SumAverage", "SumEntropy", "SumVariance", "DifferenceAverage",
+    "DifferenceEntropy", "DifferenceVariance", "InverseDifferenceMomentNormalized", "InverseDifferenceNormalized",
+    "InverseDifference" };
+  const unsigned int NumberOfCooccurrenceFeatures = sizeof(CooccurrenceFeatureNames) / sizeof(CooccurrenceFeatureNames[0]);
+
+  const char * const RunLengthFeatureNames[] = {
+    "ShortRunEmphasis", "LongRunEmphasis", "GreyLevelNonuniformity", "RunLengthNonuniformity", "LowGreyLevelRunEmphasis",
+    "HighGreyLevelRunEmphasis", "ShortRunLowGreyLevelEmphasis", "ShortRunHighGreyLevelEmphasis",
+    "LongRunLowGreyLevelEmphasis", "LongRunHighGreyLevelEmphasis", "RunPercentage", "NumberOfRuns" };
+  const unsigned int NumberOfRunLengthFeatures = sizeof(RunLengthFeatureNames) / sizeof(RunLengthFeatureNames[0]);
+
+  struct TaskList
+  {
+    std::function<void(std::size_t)> m_Task;
+    std::size_t m_NumberOfTasks;
+    std::atomic<std::size_t> m_NextTask;
+    std::mutex m_ErrorMutex;
+    std::string m_Error;
+  };
+
+  ITK_THREAD_RETURN_TYPE RunTasksCallback(void * arg)
+  {
+    typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+    TaskList * tasks = static_cast<TaskList *>(infoStruct->UserData);
+
+    for (std::size_t task = tasks->m_NextTask++; task < tasks->m_NumberOfTasks; task = tasks->m_NextTask++)
+    {
+      try
+      {
+        tasks->m_Task(task);
+      }
+      catch (const std::exception & e)
+      {
+        std::lock_guard<std::mutex> lock(tasks->m_ErrorMutex);
+        if (tasks->m_Error.empty())
+          tasks->m_Error = e.what();
+      }
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  // runs the tasks on the threads of an itk::MultiThreader, each thread takes the next open task
+  void RunTasks(std::size_t numberOfTasks, unsigned int numberOfThreads, const std::function<void(std::size_t)> & task)
+  {
+    if (numberOfTasks == 0)
+      return;
+
+    TaskList tasks;
+    tasks.m_Task = task;
+    tasks.m_NumberOfTasks = numberOfTasks;
+    tasks.m_NextTask = 0;
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    if (numberOfThreads > 0)
+      threader->SetNumberOfThreads(numberOfThreads);
+    if (static_cast<std::size_t>(threader->GetNumberOfThreads()) > numberOfTasks)
+      threader->SetNumberOfThreads(static_cast<itk::ThreadIdType>(numberOfTasks));
+    threader->SetSingleMethod(RunTasksCallback, &tasks);
+    threader->SingleMethodExecute();
+
+    if (!tasks.m_Error.empty())
+    {
+      mitkThrow() << "Calculation of texture features failed: " << tasks.m_Error;
+    }
+  }
+
+  // the default offsets of the ITK texture filters (all "previous" neighbors), scaled by range and
+  // restricted to the requested direction
+  template <typename TPixel, unsigned int VImageDimension>
+  std::vector< itk::Offset<VImageDimension> > CalculateOffsets(double range, unsigned int direction)
+  {
+    typedef itk::Offset<VImageDimension> OffsetType;
+
+    itk::Neighborhood<TPixel, VImageDimension> hood;
+    hood.SetRadius(1);
+    const unsigned int centerIndex = hood.GetCenterNeighborhoodIndex();
+
+    std::vector<OffsetType> offsets;
+    for (unsigned int d = 0; d < centerIndex; ++d)
+    {
+      OffsetType offset = hood.GetOffset(d);
+      if (direction == 1)
+      {
+        offset.Fill(0);
+        offset[VImageDimension - 1] = 1;
+        offsets.push_back(offset);
+        break;
+      }
+
+      bool skipOffset = false;
+      for (unsigned int i = 0; i < VImageDimension; ++i)
+      {
+        offset[i] *= range;
+        if (direction == i + 2 && offset[i] != 0)
+          skipOffset = true;
+      }
+      if (!skipOffset)
+        offsets.push_back(offset);
+    }
+    return offsets;
+  }
+
+  // like EnhancedScalarImageToRunLengthMatrixFilter, the last non-zero component of a run direction is positive,
+  // so the run starts at its first voxel in raster order
+  template <unsigned int VImageDimension>
+  itk::Offset<VImageDimension> NormalizeOffsetDirection(itk::Offset<VImageDimension> offset)
+  {
+    int sign = 1;
+    bool metLastNonZero = false;
+    for (int i = VImageDimension - 1; i >= 0; i--)
+    {
+      if (metLastNonZero)
+      {
+        offset[i] *= sign;
+      }
+      else if (offset[i] != 0)
+      {
+        sign = (offset[i] > 0) ? 1 : -1;
+        metLastNonZero = true;
+        offset[i] *= sign;
+      }
+    }
+    return offset;
+  }
+
+  // bounding box of the mask, the voxels of the box are stored in raster order
+  template <unsigned int VImageDimension>
+  struct BoundingBox
+  {
+    typedef itk::ImageRegion<VImageDimension> RegionType;
+    typedef itk::Index<VImageDimension> IndexType;
+
+    void SetRegion(const RegionType & region)
+    {
+      m_Region = region;
+      m_NumberOfVoxels = region.GetNumberOfPixels();
+      itk::OffsetValueType stride = 1;
+      for (unsigned int d = 0; d < VImageDimension; ++d)
+      {
+        m_Strides[d] = stride;
+        stride *= region.GetSize(d);
+      }
+    }
+
+    std::size_t LinearIndex(const IndexType & index) const
+    {
+      itk::OffsetValueType linearIndex = 0;
+      for (unsigned int d = 0; d < VImageDimension; ++d)
+        linearIndex += (index[d] - m_Region.GetIndex(d)) * m_Strides[d];
+      return static_cast<std::size_t>(linearIndex);
+    }
+
+    // steps through the box in raster order
+    void NextIndex(IndexType & index) const
+    {
+      for (unsigned int d = 0; d < VImageDimension; ++d)
+      {
+        if (++index[d] < m_Region.GetIndex(d) + static_cast<itk::IndexValueType>(m_Region.GetSize(d)))
+          return;
+        index[d] = m_Region.GetIndex(d);
+      }
+    }
+
+    RegionType m_Region;
+    itk::OffsetValueType m_Strides[VImageDimension];
+    std::size_t m_NumberOfVoxels;
+  };
+}
+
+template<typename TPixel, unsigned int VImageDimension>
+void
+CalculateTextureFeatures(itk::Image<TPixel, VImageDimension>* itkImage, mitk::Image::Pointer mask, std::vector<mitk::GIFTextureEngine::Request> & requests, unsigned int numberOfThreads)
+{
+  typedef itk::Image<TPixel, VImageDimension> ImageType;
+  typedef itk::Image<TPixel, VImageDimension> MaskType;
+  typedef typename ImageType::IndexType IndexType;
+  typedef typename ImageType::OffsetType OffsetType;
+  typedef typename ImageType::RegionType RegionType;
+  typedef typename ImageType::PointType PointType;
+  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
+
+  typedef itk::Statistics::EnhancedScalarImageToTextureFeaturesFilter<ImageType> CooccurrenceFilterType;
+  typedef typename CooccurrenceFilterType::HistogramType CooccurrenceHistogramType;
+  typedef typename CooccurrenceFilterType::TextureFeaturesFilterType CooccurrenceFeaturesFilterType;
+  typedef itk::Statistics::EnhancedScalarImageToRunLengthFeaturesFilter<ImageType> RunLengthFilterType;
+  typedef typename RunLengthFilterType::HistogramType RunLengthHistogramType;
+  typedef typename RunLengthFilterType::RunLengthFeaturesFilterType RunLengthFeaturesFilterType;
+
+  typename MaskType::Pointer maskImage = MaskType::New();
+  mitk::CastToItkImage(mask, maskImage);
+
+  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
+  minMaxComputer->SetImage(itkImage);
+  minMaxComputer->Compute();
+
+  const RegionType imageRegion = itkImage->GetLargestPossibleRegion();
+
+  // like in the ITK filters, voxels with value 1 are inside the mask; the run percentage counts all voxels > 0
+  const TPixel insideValue = itk::NumericTraits<TPixel>::OneValue();
+  unsigned long numberOfMaskVoxels = 0;
+  bool hasInsideVoxels = false;
+  IndexType lower, upper;
+  lower.Fill(0);
+  upper.Fill(0);
+  for (itk::ImageRegionConstIteratorWithIndex<MaskType> maskIter(maskImage, maskImage->GetLargestPossibleRegion()); !maskIter.IsAtEnd(); ++maskIter)
+  {
+    if (maskIter.Get() > 0)
+      ++numberOfMaskVoxels;
+    if (maskIter.Get() != insideValue)
+      continue;
+
+    const IndexType & index = maskIter.GetIndex();
+    if (!hasInsideVoxels)
+    {
+      lower = index;
+      upper = index;
+      hasInsideVoxels = true;
+    }
+    for (unsigned int d = 0; d < VImageDimension; ++d)
+    {
+      lower[d] = std::min(lower[d], index[d]);
+      upper[d] = std::max(upper[d], index[d]);
+    }
+  }
+
+  BoundingBox<VImageDimension> box;
+  {
+    RegionType region;
+    region.SetIndex(lower);
+    for (unsigned int d = 0; d < VImageDimension; ++d)
+      region.SetSize(d, hasInsideVoxels ? upper[d] - lower[d] + 1 : 0);
+    if (hasInsideVoxels && !region.Crop(imageRegion))
+      region.SetSize(RegionType::SizeType::Filled(0));
+    box.SetRegion(region);
+  }
+
+  // copy the box once, all matrices are built from these buffers
+  std::vector<char> inside(box.m_NumberOfVoxels, 0);
+  std::vector<TPixel> values(box.m_NumberOfVoxels);
+  if (box.m_NumberOfVoxels > 0)
+  {
+    itk::ImageRegionConstIterator<ImageType> imageIter(itkImage, box.m_Region);
+    itk::ImageRegionConstIterator<MaskType> maskIter(maskImage, box.m_Region);
+    for (std::size_t i = 0; i < box.m_NumberOfVoxels; ++i, ++imageIter, ++maskIter)
+    {
+      values[i] = imageIter.Get();
+      inside[i] = maskIter.Get() == insideValue;
+    }
+  }
+
+  // ---------------- co-occurrence quantization, shared by all co-occurrence requests ----------------
+  const TPixel cooccurrenceMin = static_cast<TPixel>(minMaxComputer->GetMinimum() - 0.5);
+  const TPixel cooccurrenceMax = static_cast<TPixel>(minMaxComputer->GetMaximum() + 0.5);
+  const unsigned int cooccurrenceNumberOfBins = CooccurrenceFilterType::CooccurrenceMatrixFilterType::DefaultBinsPerAxis;
+
+  auto createCooccurrenceHistogram = [&]() -> typename CooccurrenceHistogramType::Pointer
+  {
+    // same binning as ScalarImageToCooccurrenceMatrixFilter
+    typename CooccurrenceHistogramType::Pointer histogram = CooccurrenceHistogramType::New();
+    histogram->SetMeasurementVectorSize(2);
+    typename CooccurrenceHistogramType::SizeType size(2);
+    size.Fill(cooccurrenceNumberOfBins);
+    typename CooccurrenceHistogramType::MeasurementVectorType lowerBound(2), upperBound(2);
+    lowerBound.Fill(cooccurrenceMin);
+    upperBound.Fill(cooccurrenceMax + 1);
+    histogram->Initialize(size, lowerBound, upperBound);
+    return histogram;
+  };
+
+  // bin of each voxel of the box, -1 if the voxel is outside of the mask or the range
+  std::vector<int> cooccurrenceBins;
+  bool hasCooccurrenceRequests = false;
+  for (const auto & request : requests)
+    hasCooccurrenceRequests = hasCooccurrenceRequests || request.m_Type == mitk::GIFTextureEngine::Cooccurrence;
+  if (hasCooccurrenceRequests)
+  {
+    typename CooccurrenceHistogramType::Pointer binning = createCooccurrenceHistogram();
+    typename CooccurrenceHistogramType::MeasurementVectorType measurement(2);
+    typename CooccurrenceHistogramType::IndexType binIndex(2);
+    cooccurrenceBins.assign(box.m_NumberOfVoxels, -1);
+    for (std::size_t i = 0; i < box.m_NumberOfVoxels; ++i)
+    {
+      if (!inside[i] || values[i] < cooccurrenceMin || values[i] > cooccurrenceMax)
+        continue;
+      measurement.Fill(values[i]);
+      if (binning->GetIndex(measurement, binIndex))
+        cooccurrenceBins[i] = static_cast<int>(binIndex[0]);
+    }
+  }
+
+  // ---------------- run-length quantization, shared by requests with the same binning ----------------
+  struct RunLengthBinning
+  {
+    TPixel m_Min;
+    TPixel m_Max;
+    unsigned int m_NumberOfBins;
+    int m_Range;
+    typename RunLengthHistogramType::Pointer m_Histogram;
+    std::vector<int> m_Bins; ///< bin of each voxel of the box, -1 if outside of the range
+  };
+  std::vector<RunLengthBinning> runLengthBinnings;
+  std::vector<std::size_t> binningOfRequest(requests.size(), 0);
+
+  auto createRunLengthHistogram = [](const RunLengthBinning & binning) -> typename RunLengthHistogramType::Pointer
+  {
+    // same binning as EnhancedScalarImageToRunLengthMatrixFilter
+    typename RunLengthHistogramType::Pointer histogram = RunLengthHistogramType::New();
+    histogram->SetMeasurementVectorSize(2);
+    typename RunLengthHistogramType::SizeType size(2);
+    size.Fill(binning.m_NumberOfBins);
+    typename RunLengthHistogramType::MeasurementVectorType lowerBound(2), upperBound(2);
+    lowerBound[0] = binning.m_Min;
+    lowerBound[1] = 0;
+    upperBound[0] = binning.m_Max;
+    upperBound[1] = binning.m_Range;
+    histogram->Initialize(size, lowerBound, upperBound);
+    return histogram;
+  };
+
+  auto runLengthBin = [](const RunLengthBinning & binning, TPixel value) -> int
+  {
+    if (value < binning.m_Min || value > binning.m_Max)
+      return -1;
+    typename RunLengthHistogramType::MeasurementVectorType measurement(2);
+    measurement[0] = value;
+    measurement[1] = 0;
+    typename RunLengthHistogramType::IndexType binIndex(2);
+    return binning.m_Histogram->GetIndex(measurement, binIndex) ? static_cast<int>(binIndex[0]) : -1;
+  };
+
+  for (std::size_t r = 0; r < requests.size(); ++r)
+  {
+    if (requests[r].m_Type != mitk::GIFTextureEngine::RunLength)
+      continue;
+
+    // parameters as set by GIFGrayLevelRunLength
+    RunLengthBinning binning;
+    binning.m_Range = static_cast<int>(requests[r].m_Range);
+    if (binning.m_Range < 2)
+      binning.m_Range = 256;
+    if (requests[r].m_UseCtRange)
+    {
+      binning.m_Min = static_cast<TPixel>(-1024.5);
+      binning.m_Max = static_cast<TPixel>(3096.5);
+      binning.m_NumberOfBins = static_cast<unsigned int>(3096.5 + 1024.5);
+    }
+    else
+    {
+      binning.m_Min = minMaxComputer->GetMinimum();
+      binning.m_Max = minMaxComputer->GetMaximum();
+      binning.m_NumberOfBins = binning.m_Range;
+    }
+
+    std::size_t b = 0;
+    while (b < runLengthBinnings.size() && !(runLengthBinnings[b].m_Min == binning.m_Min && runLengthBinnings[b].m_Max == binning.m_Max
+      && runLengthBinnings[b].m_NumberOfBins == binning.m_NumberOfBins && runLengthBinnings[b].m_Range == binning.m_Range))
+    {
+      ++b;
+    }
+    if (b == runLengthBinnings.size())
+    {
+      binning.m_Histogram = createRunLengthHistogram(binning);
+      binning.m_Bins.resize(box.m_NumberOfVoxels);
+      for (std::size_t i = 0; i < box.m_NumberOfVoxels; ++i)
+        binning.m_Bins[i] = runLengthBin(binning, values[i]);
+      runLengthBinnings.push_back(binning);
+    }
+    binningOfRequest[r] = b;
+  }
+
+  // ---------------- one task per request and offset ----------------
+  struct Task
+  {
+    std::size_t m_Request;
+    OffsetType m_Offset;
+    std::vector<double> m_Features;
+  };
+  std::vector<Task> tasks;
+  for (std::size_t r = 0; r < requests.size(); ++r)
+  {
+    const bool isCooccurrence = requests[r].m_Type == mitk::GIFTextureEngine::Cooccurrence;
+    auto offsets = CalculateOffsets<TPixel, VImageDimension>(isCooccurrence ? requests[r].m_Range : 1.0, requests[r].m_Direction);
+    for (const auto & offset : offsets)
+    {
+      Task task;
+      task.m_Request = r;
+      task.m_Offset = offset;
+      tasks.push_back(task);
+    }
+  }
+
+  auto calculateCooccurrenceFeatures = [&](Task & task)
+  {
+    std::vector<unsigned long long> counts(cooccurrenceNumberOfBins * cooccurrenceNumberOfBins, 0);
+
+    IndexType index = box.m_Region.GetIndex();
+    for (std::size_t i = 0; i < box.m_NumberOfVoxels; ++i, box.NextIndex(index))
+    {
+      const int centerBin = cooccurrenceBins[i];
+      if (centerBin < 0)
+        continue;
+      const IndexType neighbor = index + task.m_Offset;
+      if (!box.m_Region.IsInside(neighbor))
+        continue; // outside of the box is outside of the mask
+      const int neighborBin = cooccurrenceBins[box.LinearIndex(neighbor)];
+      if (neighborBin < 0)
+        continue;
+
+      // both combinations, like ScalarImageToCooccurrenceMatrixFilter
+      ++counts[centerBin + neighborBin * cooccurrenceNumberOfBins];
+      ++counts[neighborBin + centerBin * cooccurrenceNumberOfBins];
+    }
+
+    typename CooccurrenceHistogramType::Pointer histogram = createCooccurrenceHistogram();
+    typename CooccurrenceHistogramType::IndexType histogramIndex(2);
+    for (unsigned int j = 0; j < cooccurrenceNumberOfBins; ++j)
+    {
+      for (unsigned int i = 0; i < cooccurrenceNumberOfBins; ++i)
+      {
+        const unsigned long long count = counts[i + j * cooccurrenceNumberOfBins];
+        if (count == 0)
+          continue;
+        histogramIndex[0] = i;
+        histogramIndex[1] = j;
+        histogram->SetFrequencyOfIndex(histogramIndex, count);
+      }
+    }
+
+    typename CooccurrenceFeaturesFilterType::Pointer featuresFilter = CooccurrenceFeaturesFilterType::New();
+    featuresFilter->SetInput(histogram);
+    featuresFilter->Update();
+    for (unsigned int f = 0; f < NumberOfCooccurrenceFeatures; ++f)
+      task.m_Features.push_back(featuresFilter->GetFeature(static_cast<typename CooccurrenceFeaturesFilterType::TextureFeatureName>(f)));
+  };
+
+  auto calculateRunLengthFeatures = [&](Task & task)
+  {
+    const RunLengthBinning & binning = runLengthBinnings[binningOfRequest[task.m_Request]];
+    const OffsetType offset = NormalizeOffsetDirection<VImageDimension>(task.m_Offset);
+
+    // runs may leave the box, the voxels outside are binned on demand
+    auto binAt = [&](const IndexType & index) -> int
+    {
+      if (box.m_Region.IsInside(index))
+        return binning.m_Bins[box.LinearIndex(index)];
+      return runLengthBin(binning, itkImage->GetPixel(index));
+    };
+
+    typename RunLengthHistogramType::Pointer histogram = createRunLengthHistogram(binning);
+    typename RunLengthHistogramType::MeasurementVectorType run(2);
+    typename RunLengthHistogramType::IndexType histogramIndex(2);
+
+    // like EnhancedScalarImageToRunLengthMatrixFilter, a voxel is part of at most one run per offset and a
+    // run is dropped as soon as a walk meets a visited voxel, whatever its bin. The walks only reach the
+    // voxels along the offset from the box, so the visited voxels are tracked in this part of the image.
+    RegionType walkRegion = box.m_Region;
+    for (unsigned int d = 0; d < VImageDimension; ++d)
+    {
+      if (offset[d] == 0)
+        continue;
+      walkRegion.SetIndex(d, imageRegion.GetIndex(d));
+      walkRegion.SetSize(d, imageRegion.GetSize(d));
+    }
+    BoundingBox<VImageDimension> walkBox;
+    walkBox.SetRegion(walkRegion);
+    std::vector<char> visited(walkBox.m_NumberOfVoxels, 0);
+    OffsetType backward;
+    for (unsigned int d = 0; d < VImageDimension; ++d)
+      backward[d] = -offset[d];
+
+    // walks from the center along the step, marks the voxels of the run and returns false if a visited voxel was met
+    auto walk = [&](const IndexType & center, const OffsetType & step, int centerBin, IndexType & end) -> bool
+    {
+      end = center;
+      IndexType next = center + step;
+      while (imageRegion.IsInside(next))
+      {
+        char & nextVisited = visited[walkBox.LinearIndex(next)];
+        if (nextVisited)
+          return false;
+        if (binAt(next) != centerBin)
+          break;
+        nextVisited = 1;
+        end = next;
+        next += step;
+      }
+      return true;
+    };
+
+    IndexType index = box.m_Region.GetIndex();
+    for (std::size_t i = 0; i < box.m_NumberOfVoxels; ++i, box.NextIndex(index))
+    {
+      const int centerBin = binning.m_Bins[i];
+      if (!inside[i] || centerBin < 0 || visited[walkBox.LinearIndex(index)])
+        continue;
+
+      // the run consists of all voxels along the offset in the bin of the center, inside or outside of the mask
+      IndexType first, last;
+      if (!walk(index, offset, centerBin, last) || !walk(index, backward, centerBin, first))
+        continue;
+
+      PointType firstPoint, lastPoint;
+      itkImage->TransformIndexToPhysicalPoint(first, firstPoint);
+      itkImage->TransformIndexToPhysicalPoint(last, lastPoint);
+
+      run[0] = values[i];
+      run[1] = firstPoint.EuclideanDistanceTo(lastPoint);
+      if (run[1] >= 0 && run[1] <= binning.m_Range && histogram->GetIndex(run, histogramIndex))
+        histogram->IncreaseFrequencyOfIndex(histogramIndex, 1);
+    }
+
+    typename RunLengthFeaturesFilterType::Pointer featuresFilter = RunLengthFeaturesFilterType::New();
+    featuresFilter->SetInput(histogram);
+    featuresFilter->SetNumberOfVoxels(numberOfMaskVoxels);
+    featuresFilter->Update();
+    for (unsigned int f = 0; f < NumberOfRunLengthFeatures; ++f)
+      task.m_Features.push_back(featuresFilter->GetFeature(static_cast<typename RunLengthFeaturesFilterType::RunLengthFeatureName>(f)));
+  };
+
+  RunTasks(tasks.size(), numberOfThreads, [&](std::size_t t)
+  {
+    if (requests[tasks[t].m_Request].m_Type == mitk::GIFTextureEngine::Cooccurrence)
+      calculateCooccurrenceFeatures(tasks[t]);
+    else
+      calculateRunLengthFeatures(tasks[t]);
+  });
+
+  // ---------------- mean and deviation over the offsets of each request ----------------
+  for (std::size_t r = 0; r < requests.size(); ++r)
+  {
+    mitk::GIFTextureEngine::Request & request = requests[r];
+    const bool isCooccurrence = request.m_Type == mitk::GIFTextureEngine::Cooccurrence;
+    const char * const * names = isCooccurrence ? CooccurrenceFeatureNames : RunLengthFeatureNames;
+    const unsigned int numberOfFeatures = isCooccurrence ? NumberOfCooccurrenceFeatures : NumberOfRunLengthFeatures;
+
+    /* Incremental mean and SD like the ITK texture filters, a la Knuth, "The Art of Computer Programming,
+    Volume 2: Seminumerical Algorithms", section 4.2.2:
+    M(1) = x(1), M(k) = M(k-1) + (x(k) - M(k-1) ) / k
+    S(1) = 0, S(k) = S(k-1) + (x(k) - M(k-1)) * (x(k) - M(k)) */
+    std::vector<double> means, deviations;
+    int k = 0;
+    for (const auto & task : tasks)
+    {
+      if (task.m_Request != r)
+        continue;
+      ++k;
+      if (k == 1)
+      {
+        means = task.m_Features;
+        deviations.assign(numberOfFeatures, 0.0);
+        continue;
+      }
+      for (unsigned int f = 0; f < numberOfFeatures; ++f)
+      {
+        double M_k_minus_1 = means[f];
+        double x_k = task.m_Features[f];
+        double M_k = M_k_minus_1 + (x_k - M_k_minus_1) / k;
+        deviations[f] += (x_k - M_k_minus_1) * (x_k - M_k);
+        means[f] = M_k;
+      }
+    }
+    if (k == 0)
+    {
+      MITK_WARN << "No offset matches the requested direction " << request.m_Direction << ". No texture features calculated.";
+      continue;
+    }
+
+    std::ostringstream ss;
+    if (isCooccurrence)
+      ss << "co-occ. (" << request.m_Range << ") ";
+    else
+      ss << "RunLength. (" << runLengthBinnings[binningOfRequest[r]].m_Range << ") ";
+    const std::string prefix = ss.str();
+
+    for (unsigned int f = 0; f < numberOfFeatures; ++f)
+    {
+      request.m_Features.push_back(std::make_pair(prefix + names[f] + " Means", means[f]));
+      request.m_Features.push_back(std::make_pair(prefix + names[f] + " Std.", std::sqrt(deviations[f] / k)));
+    }
+  }
+}
+
+mitk::GIFTextureEngine::GIFTextureEngine()
+  : m_NumberOfThreads(0)
+{
+}
+
+mitk::GIFTextureEngine::~GIFTextureEngine()
+{
+}
+
+void mitk::GIFTextureEngine::SetImage(const Image::Pointer & image)
+{
+  m_Image = image;
+  this->Modified();
+}
+
+void mitk::GIFTextureEngine::SetMask(const Image::Pointer & mask)
+{
+  m_Mask = mask;
+  this->Modified();
+}
+
+unsigned int mitk::GIFTextureEngine::AddCooccurrenceRequest(double range, unsigned int direction)
+{
+  Request request;
+  request.m_Type = Cooccurrence;
+  request.m_Range = range;
+  request.m_UseCtRange = false;
+  request.m_Direction = direction;
+  m_Requests.push_back(request);
+  return static_cast<unsigned int>(m_Requests.size() - 1);
+}
+
+unsigned int mitk::GIFTextureEngine::AddRunLengthRequest(double range, bool useCtRange, unsigned int direction)
+{
+  Request request;
+  request.m_Type = RunLength;
+  request.m_Range = range;
+  request.m_UseCtRange = useCtRange;
+  request.m_Direction = direction;
+  m_Requests.push_back(request);
+  return static_cast<unsigned int>(m_Requests.size() - 1);
+}
+
+void mitk::GIFTextureEngine::ClearRequests()
+{
+  m_Requests.clear();
+}
+
+void mitk::GIFTextureEngine::Update()
+{
+  if (m_Image.IsNull() || m_Mask.IsNull())
+  {
+    mitkThrow() << "Image and mask are required to calculate texture features.";
+  }
+
+  for (auto & request : m_Requests)
+    request.m_Features.clear();
+  if (m_Requests.empty())
+    return;
+
+  AccessByItk_3(m_Image, CalculateTextureFeatures, m_Mask, m_Requests, m_NumberOfThreads);
+}
+
+const mitk::GIFTextureEngine::FeatureListType & mitk::GIFTextureEngine::GetFeatures(unsigned int request) const
+{
+  if (request >= m_Requests.size())
+  {
+    mitkThrow() << "Texture feature request " << request << " does not exist.";
+  }
+  return m_Requests[request].m_Features;
+}
+
+mitk::GIFTextureEngine::FeatureListType mitk::GIFTextureEngine::CalculateFeatures(const Image::Pointer & image, const Image::Pointer & mask,
+  const std::vector<AbstractGlobalImageFeature::Pointer> & features, unsigned int numberOfThreads)
+{
+  GIFTextureEngine::Pointer engine = GIFTextureEngine::New();
+  engine->SetImage(image);
+  engine->SetMask(mask);
+  engine->SetNumberOfThreads(numberOfThreads);
+
+  // request of each feature, -1 for features which are calculated on their own
+  std::vector<int> requestOfFeature;
+  for (const auto & feature : features)
+  {
+    if (auto cooccurrence = dynamic_cast<GIFCooccurenceMatrix *>(feature.GetPointer()))
+    {
+      requestOfFeature.push_back(static_cast<int>(engine->AddCooccurrenceRequest(cooccurrence->GetRange(), cooccurrence->GetDirection())));
+    }
+    else if (auto runLength = dynamic_cast<GIFGrayLevelRunLength *>(feature.GetPointer()))
+    {
+      requestOfFeature.push_back(static_cast<int>(engine->AddRunLengthRequest(runLength->GetRange(), runLength->GetUseCtRange(), runLength->GetDirection())));
+    }
+    else
+    {
+      requestOfFeature.push_back(-1);
+    }
+  }
+  engine->Update();
+
+  FeatureListType featureList;
+  for (std::size_t i = 0; i < features.size(); ++i)
+  {
+    if (requestOfFeature[i] < 0)
+    {
+      FeatureListType localFeatures = features[i]->CalculateFeatures(image, mask);
+      featureList.insert(featureList.end(), localFeatures.begin(), localFeatures.end());
+    }
+    else
+    {
+      const FeatureListType & localFeatures = engine->GetFeatures(requestOfFeature[i]);
+      featureList.insert(featureList.end(), localFeatures.begin(), localFeatures.end());
+    }
+  }
+  return featureList;
+}
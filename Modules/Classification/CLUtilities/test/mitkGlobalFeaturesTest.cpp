@@ -19,13 +19,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkIOUtil.h"
 
 #include <mitkImageCast.h>
+#include <mitkImageAccessByItk.h>
 #include <mitkGIFFirstOrderStatistics.h>
 #include <mitkGIFCooccurenceMatrix.h>
 #include <mitkGIFGrayLevelRunLength.h>
+#include <mitkGIFTextureEngine.h>
 #include <math.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include <mitkImageGenerator.h>
 
+#include <itkEnhancedScalarImageToTextureFeaturesFilter.h>
+#include <itkEnhancedScalarImageToRunLengthFeaturesFilter.h>
+#include <itkMinimumMaximumImageCalculator.h>
+
 template <typename TPixelType>
 static mitk::Image::Pointer GenerateMaskImage(unsigned int dimX,
                                               unsigned int dimY,
@@ -112,6 +121,123 @@ static mitk::Image::Pointer GenerateGradientWithDimXImage(unsigned int dimX,
   return mitkImage;
 }
 
+// Offsets of the original co-occurrence and run-length feature classes: the default offsets of
+// the filter, scaled by scale and restricted to the direction
+template <typename TFilter>
+static typename TFilter::OffsetVector::Pointer CreateReferenceOffsets(TFilter* filter, double scale, unsigned int direction)
+{
+  typename TFilter::OffsetVector::Pointer newOffset = TFilter::OffsetVector::New();
+  auto oldOffsets = filter->GetOffsets();
+  auto oldOffsetsIterator = oldOffsets->Begin();
+  while (oldOffsetsIterator != oldOffsets->End())
+  {
+    bool continueOuterLoop = false;
+    typename TFilter::OffsetType offset = oldOffsetsIterator->Value();
+    for (unsigned int i = 0; i < TFilter::OffsetType::GetOffsetDimension(); ++i)
+    {
+      offset[i] *= scale;
+      if (direction == i + 2 && offset[i] != 0)
+      {
+        continueOuterLoop = true;
+      }
+    }
+    if (direction == 1)
+    {
+      offset[0] = 0;
+      offset[1] = 0;
+      offset[2] = 1;
+      newOffset->push_back(offset);
+      break;
+    }
+
+    oldOffsetsIterator++;
+    if (continueOuterLoop)
+      continue;
+    newOffset->push_back(offset);
+  }
+  return newOffset;
+}
+
+// Co-occurrence features as calculated by the original GIFCooccurenceMatrix pipeline, means and
+// standard deviations alternating in the order of the feature enum
+template<typename TPixel, unsigned int VImageDimension>
+static void CalculateReferenceCooccurrenceFeatures(itk::Image<TPixel, VImageDimension>* itkImage, mitk::Image::Pointer mask, double range, unsigned int direction, std::vector<double> & values)
+{
+  typedef itk::Image<TPixel, VImageDimension> ImageType;
+  typedef itk::Statistics::EnhancedScalarImageToTextureFeaturesFilter<ImageType> FilterType;
+  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
+  typedef typename FilterType::TextureFeaturesFilterType TextureFilterType;
+
+  typename ImageType::Pointer maskImage = ImageType::New();
+  mitk::CastToItkImage(mask, maskImage);
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetOffsets(CreateReferenceOffsets(filter.GetPointer(), range, direction));
+
+  typename FilterType::FeatureNameVectorPointer requestedFeatures = FilterType::FeatureNameVector::New();
+  for (int feature = TextureFilterType::Energy; feature < TextureFilterType::InvalidFeatureName; ++feature)
+    requestedFeatures->push_back(feature);
+
+  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
+  minMaxComputer->SetImage(itkImage);
+  minMaxComputer->Compute();
+
+  filter->SetInput(itkImage);
+  filter->SetMaskImage(maskImage);
+  filter->SetRequestedFeatures(requestedFeatures);
+  filter->SetPixelValueMinMax(minMaxComputer->GetMinimum()-0.5,minMaxComputer->GetMaximum()+0.5);
+  filter->Update();
+
+  auto featureMeans = filter->GetFeatureMeans();
+  auto featureStd = filter->GetFeatureStandardDeviations();
+  for (std::size_t i = 0; i < featureMeans->size(); ++i)
+  {
+    values.push_back(featureMeans->ElementAt(i));
+    values.push_back(featureStd->ElementAt(i));
+  }
+}
+
+// Run-length features as calculated by the original GIFGrayLevelRunLength pipeline (without CT range)
+template<typename TPixel, unsigned int VImageDimension>
+static void CalculateReferenceRunLengthFeatures(itk::Image<TPixel, VImageDimension>* itkImage, mitk::Image::Pointer mask, int range, unsigned int direction, std::vector<double> & values)
+{
+  typedef itk::Image<TPixel, VImageDimension> ImageType;
+  typedef itk::Statistics::EnhancedScalarImageToRunLengthFeaturesFilter<ImageType> FilterType;
+  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
+  typedef typename FilterType::RunLengthFeaturesFilterType TextureFilterType;
+
+  typename ImageType::Pointer maskImage = ImageType::New();
+  mitk::CastToItkImage(mask, maskImage);
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetOffsets(CreateReferenceOffsets(filter.GetPointer(), 1, direction));
+
+  typename FilterType::FeatureNameVectorPointer requestedFeatures = FilterType::FeatureNameVector::New();
+  for (int feature = TextureFilterType::ShortRunEmphasis; feature <= TextureFilterType::NumberOfRuns; ++feature)
+    requestedFeatures->push_back(feature);
+
+  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
+  minMaxComputer->SetImage(itkImage);
+  minMaxComputer->Compute();
+
+  int rangeOfPixels = range < 2 ? 256 : range;
+  filter->SetInput(itkImage);
+  filter->SetMaskImage(maskImage);
+  filter->SetRequestedFeatures(requestedFeatures);
+  filter->SetPixelValueMinMax(minMaxComputer->GetMinimum(),minMaxComputer->GetMaximum());
+  filter->SetNumberOfBinsPerAxis(rangeOfPixels);
+  filter->SetDistanceValueMinMax(0,rangeOfPixels);
+  filter->Update();
+
+  auto featureMeans = filter->GetFeatureMeans();
+  auto featureStd = filter->GetFeatureStandardDeviations();
+  for (std::size_t i = 0; i < featureMeans->size(); ++i)
+  {
+    values.push_back(featureMeans->ElementAt(i));
+    values.push_back(featureStd->ElementAt(i));
+  }
+}
+
 class mitkGlobalFeaturesTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkGlobalFeaturesTestSuite  );
@@ -120,6 +246,7 @@ class mitkGlobalFeaturesTestSuite : public mitk::TestFixture
   MITK_TEST(FirstOrder_QubicArea);
   //MITK_TEST(RunLenght_QubicArea);
   MITK_TEST(Coocurrence_QubicArea);
+  MITK_TEST(TextureEngine_Batch_shouldMatchSingleFeatures);
   //MITK_TEST(TestFirstOrderStatistic);
   //  MITK_TEST(TestThreadedDecisionForest);
 
@@ -312,6 +439,78 @@ public:
     CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("The mean homogenity1 value should be 1.0",1, results["co-occ. (1) Homogeneity1 Means"], mitk::eps);
     CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("The mean InverseDifferenceMoment value should be 1.0",1, results["co-occ. (1) InverseDifferenceMoment Means"], mitk::eps);
   }
+
+  void TextureEngine_Batch_shouldMatchSingleFeatures()
+  {
+    // irregular mask: a ball of radius 3 voxels inside Pic3D
+    MaskType::Pointer itkBallMask;
+    mitk::CastToItkImage(m_Image, itkBallMask);
+    itkBallMask->FillBuffer(0);
+    MaskType::IndexType index;
+    for (int x = -3; x <= 3; ++x)
+      for (int y = -3; y <= 3; ++y)
+        for (int z = -3; z <= 3; ++z)
+          if (x*x + y*y + z*z <= 9)
+          {
+            index[0] = 88 + x;
+            index[1] = 81 + y;
+            index[2] = 13 + z;
+            itkBallMask->SetPixel(index, 1);
+          }
+    mitk::Image::Pointer ballMask;
+    mitk::CastToMitkImage(itkBallMask, ballMask);
+
+    // range and direction of the co-occurrence and run-length requests
+    struct TextureRequest { bool runLength; double range; unsigned int direction; std::string prefix; };
+    std::vector<TextureRequest> requests;
+    requests.push_back({ false, 1, 0, "co-occ. (1) " });
+    requests.push_back({ false, 3, 0, "co-occ. (3) " });
+    requests.push_back({ false, 2, 1, "co-occ. (2) " });
+    requests.push_back({ false, 2, 3, "co-occ. (2) " });
+    requests.push_back({ true, 16, 0, "RunLength. (16) " });
+    requests.push_back({ true, 1, 2, "RunLength. (256) " });
+
+    std::vector<mitk::AbstractGlobalImageFeature::Pointer> features;
+    std::vector<double> expected;
+    for (auto request : requests)
+    {
+      if (request.runLength)
+      {
+        mitk::GIFGrayLevelRunLength::Pointer runLength = mitk::GIFGrayLevelRunLength::New();
+        runLength->SetRange(request.range);
+        runLength->SetDirection(request.direction);
+        features.push_back(runLength.GetPointer());
+        AccessByItk_n(m_Image, CalculateReferenceRunLengthFeatures, (ballMask, static_cast<int>(request.range), request.direction, expected));
+      }
+      else
+      {
+        mitk::GIFCooccurenceMatrix::Pointer cooc = mitk::GIFCooccurenceMatrix::New();
+        cooc->SetRange(request.range);
+        cooc->SetDirection(request.direction);
+        features.push_back(cooc.GetPointer());
+        AccessByItk_n(m_Image, CalculateReferenceCooccurrenceFeatures, (ballMask, request.range, request.direction, expected));
+      }
+    }
+
+    auto batchResults = mitk::GIFTextureEngine::CalculateFeatures(m_Image, ballMask, features);
+    auto singleThreadResults = mitk::GIFTextureEngine::CalculateFeatures(m_Image, ballMask, features, 1);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Batch calculation should return all features", expected.size(), batchResults.size());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Single threaded calculation should return all features", expected.size(), singleThreadResults.size());
+    std::size_t i = 0;
+    for (auto request : requests)
+    {
+      std::size_t numberOfValues = request.runLength ? 24 : 50;
+      for (std::size_t end = i + numberOfValues; i < end; ++i)
+      {
+        const std::string & name = batchResults[i].first;
+        CPPUNIT_ASSERT_MESSAGE(name + " should be in the order of the feature classes", name.compare(0, request.prefix.size(), request.prefix) == 0);
+        double tolerance = 1e-6 * std::max(1.0, std::abs(expected[i]));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(name, expected[i], batchResults[i].second, tolerance);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(name, expected[i], singleThreadResults[i].second, tolerance);
+      }
+    }
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkGlobalFeatures)
\ No newline at end of file
@@ -5,6 +5,8 @@ set(CPP_FILES
     mitkModuleActivator.cpp
 
     Classifier/mitkVigraRandomForestClassifier.cpp
+    Classifier/mitkFlattenedRandomForest.cpp
+    Classifier/mitkTiledVoxelClassifier.cpp
 
     Algorithm/itkHessianMatrixEigenvalueImageFilter.cpp
     Algorithm/itkStructureTensorEigenvalueImageFilter.cpp
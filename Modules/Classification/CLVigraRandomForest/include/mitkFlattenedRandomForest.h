@@ -0,0 +1,95 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkFlattenedRandomForest_h
+#define mitkFlattenedRandomForest_h
+
+#include <MitkCLVigraRandomForestExports.h>
+
+#include <vigra/random_forest.hxx>
+
+#include <cstddef>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * \brief Inference representation of a trained vigra::RandomForest<int>.
+  *
+  * The nodes of all trees are stored in contiguous arrays (split feature, threshold and children). Samples
+  * are evaluated in batches: all samples of a batch descend one level of a tree together without branches,
+  * leaves point to themselves, so the inner loop can be vectorized by the compiler. The votes of the trees
+  * are accumulated in the same order and with the same arithmetic as vigra::RandomForest::predictProbabilities()
+  * and VigraRandomForestClassifier::PredictWeighted(), so the results are identical.
+  *
+  * Only forests with threshold splits and constant probability leaves can be flattened, which covers all
+  * forests trained by VigraRandomForestClassifier.
+  */
+  class MITKCLVIGRARANDOMFOREST_EXPORT FlattenedRandomForest
+  {
+  public:
+    FlattenedRandomForest();
+
+    /** \brief Copies the trees of the forest. Returns false and stays empty if a tree contains other node types. */
+    bool Compile(const vigra::RandomForest<int> & forest);
+    void Clear();
+
+    bool IsEmpty() const { return m_TreeRoots.empty(); }
+    unsigned int GetNumberOfTrees() const { return static_cast<unsigned int>(m_TreeRoots.size()); }
+    unsigned int GetNumberOfNodes() const { return static_cast<unsigned int>(m_Features.size()); }
+    int GetNumberOfClasses() const { return m_NumberOfClasses; }
+    int GetNumberOfFeatures() const { return m_NumberOfFeatures; }
+
+    /**
+    * \brief Predicts the class probabilities and labels of numberOfRows samples.
+    *
+    * Feature f of sample r is read from features[f * featureStride + r], probability of class c is written to
+    * probabilities[c * probabilityStride + r] (column major, like Eigen and vigra views of Eigen matrices).
+    * Without tree weights the result equals vigra::RandomForest::predictProbabilities() and predictLabels().
+    * With tree weights (one per tree) it equals VigraRandomForestClassifier::PredictWeighted(), i.e. the weighted
+    * votes are truncated to integers. labels may be nullptr. Instantiated for float and double features.
+    */
+    template <typename TFeature>
+    void Predict(const TFeature * features, std::size_t featureStride, std::size_t numberOfRows,
+                 double * probabilities, std::size_t probabilityStride, int * labels,
+                 const double * treeWeights = nullptr) const;
+
+    /** \brief Number of samples that descend the trees together */
+    static const std::size_t BatchSize = 64;
+
+  private:
+    template <typename TFeature>
+    void PredictBatch(const TFeature * features, std::size_t featureStride, std::size_t firstRow, std::size_t numberOfRows,
+                      double * probabilities, std::size_t probabilityStride, int * labels, const double * treeWeights) const;
+
+    // per node; leaves use feature 0 and point to themselves
+    std::vector<int> m_Features;
+    std::vector<double> m_Thresholds;
+    std::vector<int> m_Children;      ///< left and right child of each node
+    std::vector<int> m_LeafOffsets;   ///< offset of the leaf weight in m_LeafValues, -1 for split nodes
+
+    std::vector<double> m_LeafValues; ///< per leaf: weight (number of samples) followed by the class probabilities
+    std::vector<int> m_TreeRoots;
+    std::vector<int> m_TreeDepths;
+
+    std::vector<int> m_ClassLabels;   ///< label of each class index
+    int m_NumberOfClasses;
+    int m_NumberOfFeatures;
+    int m_PredictWeighted;            ///< vigra option predict_weighted_
+  };
+}
+
+#endif //mitkFlattenedRandomForest_h
@@ -0,0 +1,164 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkTiledVoxelClassifier_h
+#define mitkTiledVoxelClassifier_h
+
+#include <MitkCLVigraRandomForestExports.h>
+#include <mitkVigraRandomForestClassifier.h>
+#include <mitkImage.h>
+
+#include <itkImage.h>
+#include <itkObject.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * \brief Classifies all voxels of a mask block by block with a VigraRandomForestClassifier.
+  *
+  * VigraRandomForestClassifier::Predict() needs a matrix with one double per voxel and feature, which
+  * does not fit into memory for large images with many features. This class splits the mask into blocks
+  * and keeps only the float features of the blocks which are currently predicted, so the memory
+  * used for features does not depend on the image size.
+  *
+  * Features are read from precomputed feature images (AddFeatureImage()) and/or computed for each block by
+  * feature functions (AddFeatureFunction()). A feature function gets the block enlarged by a halo, so that
+  * neighborhood filters produce the same values at the block border as on the whole image.
+  *
+  * The blocks are distributed dynamically to the threads of an itk::MultiThreader. Labels and class
+  * probabilities are written directly into the output images, voxels outside of the mask are 0.
+  */
+  class MITKCLVIGRARANDOMFOREST_EXPORT TiledVoxelClassifier : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(TiledVoxelClassifier, itk::Object)
+    itkFactorylessNewMacro(Self)
+
+    typedef itk::Image<float, 3> FeatureImageType;
+    typedef itk::Image<unsigned char, 3> MaskImageType;
+    typedef itk::Image<int, 3> LabelImageType;
+    typedef itk::ImageRegion<3> RegionType;
+
+    /**
+    * \brief Computes features for the voxels of the given region.
+    *
+    * Has to return one image per feature, each covering at least the region. It is called concurrently
+    * by several threads.
+    */
+    typedef std::function<void(const RegionType & region, std::vector<FeatureImageType::Pointer> & features)> FeatureFunctionType;
+
+    void SetClassifier(VigraRandomForestClassifier * classifier);
+
+    /** \brief Voxels with a value larger than 0 are classified. Defines the geometry of the output images. */
+    void SetMask(mitk::Image * mask);
+
+    /** \brief Adds a precomputed feature image. The image must have the size of the mask. */
+    void AddFeatureImage(mitk::Image * image);
+
+    /** \brief Adds a feature function which computes numberOfFeatures features and needs halo voxels around each block. */
+    void AddFeatureFunction(const FeatureFunctionType & function, unsigned int numberOfFeatures, unsigned int halo);
+
+    /** \brief Removes all feature images and functions. The feature order must match the order used for training. */
+    void ClearFeatures();
+
+    unsigned int GetNumberOfFeatures() const;
+
+    itkSetMacro(BlockSize, unsigned int)      ///< Edge length of the blocks in voxels, default 32.
+    itkGetMacro(BlockSize, unsigned int)
+    itkSetMacro(NumberOfThreads, unsigned int) ///< 0 uses the default number of threads of itk::MultiThreader.
+    itkGetMacro(NumberOfThreads, unsigned int)
+    itkSetMacro(ComputeProbabilities, bool)    ///< Create one probability image per class, default true.
+    itkGetMacro(ComputeProbabilities, bool)
+
+    /**
+    * \brief Classifies all voxels of the mask.
+    * @throws mitk::Exception if classifier, mask or features are missing or do not match.
+    */
+    void Update();
+
+    /** \brief Labels of the last update as int image */
+    mitk::Image::Pointer GetLabelImage() const { return m_LabelImage; }
+    /** \brief Float probability image for each class of the forest, empty if probabilities are not computed */
+    std::vector<mitk::Image::Pointer> GetProbabilityImages() const { return m_ProbabilityImages; }
+
+    /** \brief Maximum number of bytes used for features and probabilities by all threads at the same time */
+    std::size_t GetPeakFeatureMemory() const { return m_PeakFeatureMemory; }
+    unsigned long long GetNumberOfClassifiedVoxels() const { return m_NumberOfClassifiedVoxels; }
+    double GetVoxelsPerSecond() const { return m_VoxelsPerSecond; }
+
+  protected:
+    TiledVoxelClassifier();
+    ~TiledVoxelClassifier();
+
+    /** \brief Copies a region of a feature image in ITK order to float values */
+    typedef std::function<void(const RegionType & region, float * values)> FeatureReaderType;
+
+    struct FeatureFunction
+    {
+      FeatureFunctionType m_Function;
+      unsigned int m_NumberOfFeatures;
+      unsigned int m_Halo;
+    };
+
+    struct ThreadBuffer
+    {
+      std::vector<unsigned char> m_Mask;
+      std::vector<float> m_Features;
+      std::vector<double> m_Probabilities; ///< double like Predict(), so the labels do not depend on the tiling
+      std::vector<int> m_Labels;
+    };
+
+    static ITK_THREAD_RETURN_TYPE ClassifyBlocksCallback(void * arg);
+    void ClassifyBlock(const RegionType & block, ThreadBuffer & buffer);
+
+    void AddFeatureMemory(std::size_t bytes);
+    void RemoveFeatureMemory(std::size_t bytes);
+
+    VigraRandomForestClassifier::Pointer m_Classifier;
+    const FlattenedRandomForest * m_FlattenedForest; ///< taken from m_Classifier by Update(), nullptr for the vigra evaluation
+    mitk::Image::Pointer m_Mask;
+    MaskImageType::Pointer m_ItkMask;
+    std::vector<mitk::Image::Pointer> m_FeatureImages;
+    std::vector<FeatureReaderType> m_FeatureReaders;
+    std::vector<FeatureFunction> m_FeatureFunctions;
+
+    unsigned int m_BlockSize;
+    unsigned int m_NumberOfThreads;
+    bool m_ComputeProbabilities;
+
+    LabelImageType::Pointer m_ItkLabelImage;
+    std::vector<FeatureImageType::Pointer> m_ItkProbabilityImages;
+    mitk::Image::Pointer m_LabelImage;
+    std::vector<mitk::Image::Pointer> m_ProbabilityImages;
+
+    std::vector<RegionType> m_Blocks;
+    std::atomic<std::size_t> m_NextBlock;
+    std::atomic<std::size_t> m_CurrentFeatureMemory;
+    std::atomic<std::size_t> m_PeakFeatureMemory;
+    std::atomic<unsigned long long> m_NumberOfClassifiedVoxels;
+    double m_VoxelsPerSecond;
+
+    std::mutex m_ErrorMutex;
+    std::string m_Error;
+  };
+}
+
+#endif //mitkTiledVoxelClassifier_h
@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkCLVigraRandomForestExports.h>
 #include <mitkAbstractClassifier.h>
+#include <mitkFlattenedRandomForest.h>
 
 //#include <vigra/multi_array.hxx>
 #include <vigra/random_forest.hxx>
@@ -52,6 +53,15 @@ namespace mitk
     void SetRandomForest(const vigra::RandomForest<int> & rf);
     const vigra::RandomForest<int> & GetRandomForest() const;
 
+    /**
+    * \brief Predict() and PredictWeighted() evaluate a flattened copy of the forest (default true).
+    *
+    * The results are identical to the vigra evaluation, which is used if disabled or if the forest cannot be flattened.
+    */
+    void UseFlattenedForest(bool);
+    /** \brief Returns the flattened forest, compiles it if the forest changed. nullptr if disabled or not possible. */
+    const FlattenedRandomForest * GetFlattenedRandomForest();
+
     void UsePointWiseWeight(bool);
     void SetMaximumTreeDepth(int);
     void SetMinimumSplitNodeSize(int);
@@ -83,6 +93,10 @@ namespace mitk
     Parameter * m_Parameter;
     vigra::RandomForest<int> m_RandomForest;
 
+    FlattenedRandomForest m_FlattenedForest;
+    bool m_FlattenedForestIsValid;
+    bool m_UseFlattenedForest;
+
     static ITK_THREAD_RETURN_TYPE TrainTreesCallback(void *);
     static ITK_THREAD_RETURN_TYPE PredictCallback(void *);
     static ITK_THREAD_RETURN_TYPE PredictWeightedCallback(void *);
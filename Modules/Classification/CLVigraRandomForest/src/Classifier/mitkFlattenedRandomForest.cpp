@@ -0,0 +1,238 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkFlattenedRandomForest.h>
+
+#include <algorithm>
+
+mitk::FlattenedRandomForest::FlattenedRandomForest()
+  : m_NumberOfClasses(0)
+  , m_NumberOfFeatures(0)
+  , m_PredictWeighted(0)
+{
+}
+
+void mitk::FlattenedRandomForest::Clear()
+{
+  m_Features.clear();
+  m_Thresholds.clear();
+  m_Children.clear();
+  m_LeafOffsets.clear();
+  m_LeafValues.clear();
+  m_TreeRoots.clear();
+  m_TreeDepths.clear();
+  m_ClassLabels.clear();
+  m_NumberOfClasses = 0;
+  m_NumberOfFeatures = 0;
+  m_PredictWeighted = 0;
+}
+
+bool mitk::FlattenedRandomForest::Compile(const vigra::RandomForest<int> & forest)
+{
+  this->Clear();
+
+  struct PendingNode
+  {
+    int m_TopologyIndex;
+    int m_Node;
+    int m_Depth;
+  };
+
+  auto addNode = [this]() -> int
+  {
+    int node = static_cast<int>(m_Features.size());
+    m_Features.push_back(0);
+    m_Thresholds.push_back(0.0);
+    m_Children.push_back(node);
+    m_Children.push_back(node);
+    m_LeafOffsets.push_back(-1);
+    return node;
+  };
+
+  for (int k = 0; k < forest.options_.tree_count_; ++k)
+  {
+    const vigra::RandomForest<int>::DecisionTree_t & tree = forest.trees_[k];
+    int treeDepth = 0;
+
+    // the root of a vigra tree is at topology index 2
+    std::vector<PendingNode> pendingNodes;
+    PendingNode root = { 2, addNode(), 0 };
+    m_TreeRoots.push_back(root.m_Node);
+    pendingNodes.push_back(root);
+
+    while (!pendingNodes.empty())
+    {
+      PendingNode current = pendingNodes.back();
+      pendingNodes.pop_back();
+
+      switch (tree.topology_[current.m_TopologyIndex])
+      {
+      case vigra::i_ThresholdNode:
+        {
+          vigra::Node<vigra::i_ThresholdNode> node(tree.topology_, tree.parameters_, current.m_TopologyIndex);
+          m_Features[current.m_Node] = node.column();
+          m_Thresholds[current.m_Node] = node.threshold();
+          PendingNode left = { node.child(0), addNode(), current.m_Depth + 1 };
+          PendingNode right = { node.child(1), addNode(), current.m_Depth + 1 };
+          m_Children[2 * current.m_Node] = left.m_Node;
+          m_Children[2 * current.m_Node + 1] = right.m_Node;
+          pendingNodes.push_back(right);
+          pendingNodes.push_back(left);
+          break;
+        }
+      case vigra::e_ConstProbNode:
+        {
+          vigra::Node<vigra::e_ConstProbNode> leaf(tree.topology_, tree.parameters_, current.m_TopologyIndex);
+          m_LeafOffsets[current.m_Node] = static_cast<int>(m_LeafValues.size());
+          m_LeafValues.push_back(leaf.weights());
+          for (int l = 0; l < forest.ext_param_.class_count_; ++l)
+            m_LeafValues.push_back(leaf.prob_begin()[l]);
+          treeDepth = std::max(treeDepth, current.m_Depth);
+          break;
+        }
+      default:
+        this->Clear();
+        return false;
+      }
+    }
+    m_TreeDepths.push_back(treeDepth);
+  }
+
+  m_NumberOfClasses = forest.ext_param_.class_count_;
+  m_NumberOfFeatures = forest.ext_param_.column_count_;
+  m_PredictWeighted = forest.options_.predict_weighted_;
+  for (int l = 0; l < m_NumberOfClasses; ++l)
+  {
+    int label;
+    forest.ext_param_.to_classlabel(l, label);
+    m_ClassLabels.push_back(label);
+  }
+  return true;
+}
+
+template <typename TFeature>
+void mitk::FlattenedRandomForest::Predict(const TFeature * features, std::size_t featureStride, std::size_t numberOfRows,
+                                          double * probabilities, std::size_t probabilityStride, int * labels,
+                                          const double * treeWeights) const
+{
+  for (std::size_t firstRow = 0; firstRow < numberOfRows; firstRow += BatchSize)
+  {
+    this->PredictBatch(features, featureStride, firstRow, std::min(BatchSize, numberOfRows - firstRow),
+                       probabilities, probabilityStride, labels, treeWeights);
+  }
+}
+
+template <typename TFeature>
+void mitk::FlattenedRandomForest::PredictBatch(const TFeature * features, std::size_t featureStride, std::size_t firstRow,
+                                               std::size_t numberOfRows, double * probabilities, std::size_t probabilityStride,
+                                               int * labels, const double * treeWeights) const
+{
+  int nodes[BatchSize];
+  double totalWeights[BatchSize];
+  bool valid[BatchSize];
+
+  const TFeature * batchFeatures = features + firstRow;
+  double * batchProbabilities = probabilities + firstRow;
+
+  for (std::size_t i = 0; i < numberOfRows; ++i)
+  {
+    totalWeights[i] = 0.0;
+    valid[i] = true;
+  }
+  for (int l = 0; l < m_NumberOfClasses; ++l)
+  {
+    for (std::size_t i = 0; i < numberOfRows; ++i)
+      batchProbabilities[l * probabilityStride + i] = 0.0;
+  }
+
+  // like vigra, samples with NaN features get zero probabilities
+  if (treeWeights == nullptr)
+  {
+    for (int f = 0; f < m_NumberOfFeatures; ++f)
+    {
+      const TFeature * column = batchFeatures + f * featureStride;
+      for (std::size_t i = 0; i < numberOfRows; ++i)
+        valid[i] = valid[i] && column[i] == column[i];
+    }
+  }
+
+  const int * featureIndices = m_Features.data();
+  const double * thresholds = m_Thresholds.data();
+  const int * children = m_Children.data();
+
+  for (std::size_t k = 0; k < m_TreeRoots.size(); ++k)
+  {
+    const int root = m_TreeRoots[k];
+    for (std::size_t i = 0; i < numberOfRows; ++i)
+      nodes[i] = root;
+
+    // every sample descends one level per step, leaves point to themselves
+    for (int level = 0; level < m_TreeDepths[k]; ++level)
+    {
+      for (std::size_t i = 0; i < numberOfRows; ++i)
+      {
+        const int node = nodes[i];
+        const TFeature value = batchFeatures[featureIndices[node] * featureStride + i];
+        nodes[i] = children[2 * node + (value < thresholds[node] ? 0 : 1)];
+      }
+    }
+
+    for (std::size_t i = 0; i < numberOfRows; ++i)
+    {
+      if (!valid[i])
+        continue;
+
+      const double * weights = m_LeafValues.data() + m_LeafOffsets[nodes[i]] + 1;
+      const double numberOfLeafObservations = *(weights - 1);
+      for (int l = 0; l < m_NumberOfClasses; ++l)
+      {
+        double cur_w = weights[l] * (m_PredictWeighted * numberOfLeafObservations + (1 - m_PredictWeighted));
+        if (treeWeights != nullptr)
+        {
+          cur_w = cur_w * treeWeights[k];
+          batchProbabilities[l * probabilityStride + i] += static_cast<int>(cur_w);
+        }
+        else
+        {
+          batchProbabilities[l * probabilityStride + i] += cur_w;
+        }
+        totalWeights[i] += cur_w;
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < numberOfRows; ++i)
+  {
+    int maxCol = 0;
+    if (valid[i])
+    {
+      for (int l = 0; l < m_NumberOfClasses; ++l)
+        batchProbabilities[l * probabilityStride + i] /= totalWeights[i];
+      for (int l = 1; l < m_NumberOfClasses; ++l)
+      {
+        if (batchProbabilities[l * probabilityStride + i] > batchProbabilities[maxCol * probabilityStride + i])
+          maxCol = l;
+      }
+    }
+    if (labels != nullptr)
+      labels[firstRow + i] = m_ClassLabels[maxCol];
+  }
+}
+
+template MITKCLVIGRARANDOMFOREST_EXPORT void mitk::FlattenedRandomForest::Predict<float>(const float *, std::size_t, std::size_t,
+  double *, std::size_t, int *, const double *) const;
+template MITKCLVIGRARANDOMFOREST_EXPORT void mitk::FlattenedRandomForest::Predict<double>(const double *, std::size_t, std::size_t,
+  double *, std::size_t, int *, const double *) const;
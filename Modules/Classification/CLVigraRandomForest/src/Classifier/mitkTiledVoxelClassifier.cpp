@@ -0,0 +1,422 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTiledVoxelClassifier.h>
+
+// MITK includes
+#include <mitkExceptionMacro.h>
+#include <mitkImageAccessByItk.h>
+#include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+
+// ITK includes
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkMultiThreader.h>
+
+// Vigra includes
+#include <vigra/random_forest.hxx>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+  typedef mitk::TiledVoxelClassifier::RegionType RegionType;
+  typedef std::function<void(const RegionType & region, float * values)> FeatureReaderType;
+
+  template<typename TPixel, unsigned int VImageDimension>
+  void CreateFeatureReader(itk::Image<TPixel, VImageDimension> * itkImage, std::vector<FeatureReaderType> & readers)
+  {
+    typedef itk::Image<TPixel, VImageDimension> ImageType;
+    typename ImageType::Pointer image = itkImage;
+    readers.push_back([image](const RegionType & region, float * values)
+    {
+      itk::ImageRegionConstIterator<ImageType> iter(image, region);
+      for (; !iter.IsAtEnd(); ++iter, ++values)
+        *values = static_cast<float>(iter.Get());
+    });
+  }
+
+  template<typename T>
+  std::size_t ResizeBuffer(std::vector<T> & buffer, std::size_t size)
+  {
+    // returns the number of additionally allocated bytes
+    std::size_t oldCapacity = buffer.capacity();
+    buffer.resize(size);
+    return (buffer.capacity() - oldCapacity) * sizeof(T);
+  }
+}
+
+mitk::TiledVoxelClassifier::TiledVoxelClassifier()
+  : m_FlattenedForest(nullptr)
+  , m_BlockSize(32)
+  , m_NumberOfThreads(0)
+  , m_ComputeProbabilities(true)
+  , m_NextBlock(0)
+  , m_CurrentFeatureMemory(0)
+  , m_PeakFeatureMemory(0)
+  , m_NumberOfClassifiedVoxels(0)
+  , m_VoxelsPerSecond(0)
+{
+}
+
+mitk::TiledVoxelClassifier::~TiledVoxelClassifier()
+{
+}
+
+void mitk::TiledVoxelClassifier::SetClassifier(VigraRandomForestClassifier * classifier)
+{
+  m_Classifier = classifier;
+  this->Modified();
+}
+
+void mitk::TiledVoxelClassifier::SetMask(mitk::Image * mask)
+{
+  m_Mask = mask;
+  m_ItkMask = nullptr;
+  this->Modified();
+}
+
+void mitk::TiledVoxelClassifier::AddFeatureImage(mitk::Image * image)
+{
+  if (image == nullptr || image->GetDimension() != 3)
+  {
+    mitkThrow() << "Feature images must be 3D images.";
+  }
+  m_FeatureImages.push_back(image);
+  AccessFixedDimensionByItk_1(image, CreateFeatureReader, 3, m_FeatureReaders);
+  this->Modified();
+}
+
+void mitk::TiledVoxelClassifier::AddFeatureFunction(const FeatureFunctionType & function, unsigned int numberOfFeatures, unsigned int halo)
+{
+  FeatureFunction featureFunction;
+  featureFunction.m_Function = function;
+  featureFunction.m_NumberOfFeatures = numberOfFeatures;
+  featureFunction.m_Halo = halo;
+  m_FeatureFunctions.push_back(featureFunction);
+  this->Modified();
+}
+
+void mitk::TiledVoxelClassifier::ClearFeatures()
+{
+  m_FeatureImages.clear();
+  m_FeatureReaders.clear();
+  m_FeatureFunctions.clear();
+  this->Modified();
+}
+
+unsigned int mitk::TiledVoxelClassifier::GetNumberOfFeatures() const
+{
+  unsigned int numberOfFeatures = static_cast<unsigned int>(m_FeatureReaders.size());
+  for (const auto & function : m_FeatureFunctions)
+    numberOfFeatures += function.m_NumberOfFeatures;
+  return numberOfFeatures;
+}
+
+void mitk::TiledVoxelClassifier::AddFeatureMemory(std::size_t bytes)
+{
+  std::size_t current = (m_CurrentFeatureMemory += bytes);
+  std::size_t peak = m_PeakFeatureMemory.load();
+  while (current > peak && !m_PeakFeatureMemory.compare_exchange_weak(peak, current))
+  {
+  }
+}
+
+void mitk::TiledVoxelClassifier::RemoveFeatureMemory(std::size_t bytes)
+{
+  m_CurrentFeatureMemory -= bytes;
+}
+
+void mitk::TiledVoxelClassifier::Update()
+{
+  if (m_Classifier.IsNull() || m_Classifier->GetRandomForest().tree_count() == 0)
+  {
+    mitkThrow() << "A trained classifier is required.";
+  }
+  if (m_Mask.IsNull() || m_Mask->GetDimension() != 3)
+  {
+    mitkThrow() << "A 3D mask image is required.";
+  }
+
+  const vigra::RandomForest<int> & randomForest = m_Classifier->GetRandomForest();
+  const unsigned int numberOfFeatures = this->GetNumberOfFeatures();
+  if (numberOfFeatures == 0 || static_cast<int>(numberOfFeatures) != randomForest.feature_count())
+  {
+    mitkThrow() << "The classifier was trained with " << randomForest.feature_count() << " features, but "
+                << numberOfFeatures << " features are given.";
+  }
+  for (const auto & image : m_FeatureImages)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      if (image->GetDimension(i) != m_Mask->GetDimension(i))
+        mitkThrow() << "The size of a feature image does not match the size of the mask.";
+    }
+  }
+  if (m_BlockSize == 0)
+  {
+    mitkThrow() << "The block size must be larger than 0.";
+  }
+
+  if (m_ItkMask.IsNull())
+    mitk::CastToItkImage(m_Mask, m_ItkMask);
+
+  const RegionType largestRegion = m_ItkMask->GetLargestPossibleRegion();
+
+  // outputs
+  m_ItkLabelImage = LabelImageType::New();
+  m_ItkLabelImage->CopyInformation(m_ItkMask);
+  m_ItkLabelImage->SetRegions(largestRegion);
+  m_ItkLabelImage->Allocate();
+  m_ItkLabelImage->FillBuffer(0);
+
+  m_ItkProbabilityImages.clear();
+  if (m_ComputeProbabilities)
+  {
+    for (int i = 0; i < randomForest.class_count(); ++i)
+    {
+      FeatureImageType::Pointer probabilityImage = FeatureImageType::New();
+      probabilityImage->CopyInformation(m_ItkMask);
+      probabilityImage->SetRegions(largestRegion);
+      probabilityImage->Allocate();
+      probabilityImage->FillBuffer(0);
+      m_ItkProbabilityImages.push_back(probabilityImage);
+    }
+  }
+
+  // blocks
+  m_Blocks.clear();
+  RegionType::IndexType start = largestRegion.GetIndex();
+  RegionType::SizeType size = largestRegion.GetSize();
+  for (itk::SizeValueType z = 0; z < size[2]; z += m_BlockSize)
+  {
+    for (itk::SizeValueType y = 0; y < size[1]; y += m_BlockSize)
+    {
+      for (itk::SizeValueType x = 0; x < size[0]; x += m_BlockSize)
+      {
+        RegionType::IndexType blockIndex = {{ start[0] + static_cast<itk::IndexValueType>(x),
+                                              start[1] + static_cast<itk::IndexValueType>(y),
+                                              start[2] + static_cast<itk::IndexValueType>(z) }};
+        RegionType::SizeType blockSize = {{ std::min<itk::SizeValueType>(m_BlockSize, size[0] - x),
+                                            std::min<itk::SizeValueType>(m_BlockSize, size[1] - y),
+                                            std::min<itk::SizeValueType>(m_BlockSize, size[2] - z) }};
+        m_Blocks.push_back(RegionType(blockIndex, blockSize));
+      }
+    }
+  }
+
+  m_NextBlock = 0;
+  m_CurrentFeatureMemory = 0;
+  m_PeakFeatureMemory = 0;
+  m_NumberOfClassifiedVoxels = 0;
+  m_Error.clear();
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  // compiled once here, the threads only read it
+  m_FlattenedForest = m_Classifier->GetFlattenedRandomForest();
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  if (m_NumberOfThreads > 0)
+    threader->SetNumberOfThreads(m_NumberOfThreads);
+  threader->SetSingleMethod(this->ClassifyBlocksCallback, this);
+  threader->SingleMethodExecute();
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  m_VoxelsPerSecond = seconds > 0 ? m_NumberOfClassifiedVoxels.load() / seconds : 0;
+
+  if (!m_Error.empty())
+  {
+    m_ItkLabelImage = nullptr;
+    m_ItkProbabilityImages.clear();
+    mitkThrow() << "Classification of a block failed: " << m_Error;
+  }
+
+  // hand the buffers over to the mitk images without copying them
+  m_LabelImage = mitk::GrabItkImageMemory(m_ItkLabelImage, nullptr, m_Mask->GetGeometry());
+  m_ProbabilityImages.clear();
+  for (auto & probabilityImage : m_ItkProbabilityImages)
+    m_ProbabilityImages.push_back(mitk::GrabItkImageMemory(probabilityImage, nullptr, m_Mask->GetGeometry()));
+  m_ItkLabelImage = nullptr;
+  m_ItkProbabilityImages.clear();
+
+  MITK_INFO("TiledVoxelClassifier") << "Classified " << m_NumberOfClassifiedVoxels.load() << " voxels in " << m_Blocks.size()
+                                    << " blocks (" << m_VoxelsPerSecond << " voxels/s), peak feature memory "
+                                    << m_PeakFeatureMemory.load() / (1024.0 * 1024.0) << " MB";
+}
+
+ITK_THREAD_RETURN_TYPE mitk::TiledVoxelClassifier::ClassifyBlocksCallback(void * arg)
+{
+  typedef itk::MultiThreader::ThreadInfoStruct  ThreadInfoType;
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  TiledVoxelClassifier * self = static_cast<TiledVoxelClassifier *>(infoStruct->UserData);
+
+  // the buffers grow to the largest block and are reused for all blocks of this thread
+  ThreadBuffer buffer;
+  std::size_t blockIndex;
+  while ((blockIndex = self->m_NextBlock++) < self->m_Blocks.size())
+  {
+    try
+    {
+      self->ClassifyBlock(self->m_Blocks[blockIndex], buffer);
+    }
+    catch (const std::exception & e)
+    {
+      std::lock_guard<std::mutex> lock(self->m_ErrorMutex);
+      if (self->m_Error.empty())
+        self->m_Error = e.what();
+      self->m_NextBlock = self->m_Blocks.size();
+    }
+  }
+
+  self->RemoveFeatureMemory(buffer.m_Features.capacity() * sizeof(float) + buffer.m_Probabilities.capacity() * sizeof(double)
+    + buffer.m_Labels.capacity() * sizeof(int));
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::TiledVoxelClassifier::ClassifyBlock(const RegionType & block, ThreadBuffer & buffer)
+{
+  const std::size_t numberOfVoxels = block.GetNumberOfPixels();
+
+  buffer.m_Mask.resize(numberOfVoxels);
+  std::size_t numberOfMaskVoxels = 0;
+  {
+    itk::ImageRegionConstIterator<MaskImageType> iter(m_ItkMask, block);
+    for (std::size_t i = 0; !iter.IsAtEnd(); ++iter, ++i)
+    {
+      buffer.m_Mask[i] = iter.Get() > 0;
+      numberOfMaskVoxels += buffer.m_Mask[i];
+    }
+  }
+  if (numberOfMaskVoxels == 0)
+    return;
+
+  // one column per feature, column major as expected by vigra
+  const unsigned int numberOfFeatures = this->GetNumberOfFeatures();
+  this->AddFeatureMemory(ResizeBuffer(buffer.m_Features, numberOfVoxels * numberOfFeatures));
+  float * column = buffer.m_Features.data();
+
+  for (const auto & reader : m_FeatureReaders)
+  {
+    reader(block, column);
+    column += numberOfVoxels;
+  }
+
+  for (const auto & function : m_FeatureFunctions)
+  {
+    RegionType paddedRegion = block;
+    paddedRegion.PadByRadius(function.m_Halo);
+    paddedRegion.Crop(m_ItkMask->GetLargestPossibleRegion());
+
+    std::vector<FeatureImageType::Pointer> features;
+    function.m_Function(paddedRegion, features);
+    if (features.size() != function.m_NumberOfFeatures)
+    {
+      mitkThrow() << "Feature function returned " << features.size() << " instead of " << function.m_NumberOfFeatures << " features.";
+    }
+
+    std::size_t featureMemory = 0;
+    for (const auto & feature : features)
+      featureMemory += feature->GetBufferedRegion().GetNumberOfPixels() * sizeof(float);
+    this->AddFeatureMemory(featureMemory);
+
+    for (const auto & feature : features)
+    {
+      if (!feature->GetBufferedRegion().IsInside(block))
+      {
+        this->RemoveFeatureMemory(featureMemory);
+        mitkThrow() << "Feature function returned an image which does not cover the block.";
+      }
+      itk::ImageRegionConstIterator<FeatureImageType> iter(feature, block);
+      for (float * value = column; !iter.IsAtEnd(); ++iter, ++value)
+        *value = iter.Get();
+      column += numberOfVoxels;
+    }
+    features.clear();
+    this->RemoveFeatureMemory(featureMemory);
+  }
+
+  // move the features of the mask voxels to the beginning of each column
+  if (numberOfMaskVoxels < numberOfVoxels)
+  {
+    for (unsigned int feature = 0; feature < numberOfFeatures; ++feature)
+    {
+      float * values = buffer.m_Features.data() + feature * numberOfVoxels;
+      std::size_t row = 0;
+      for (std::size_t i = 0; i < numberOfVoxels; ++i)
+      {
+        if (buffer.m_Mask[i])
+          values[row++] = values[i];
+      }
+    }
+  }
+
+  const vigra::RandomForest<int> & randomForest = m_Classifier->GetRandomForest();
+  const int numberOfClasses = randomForest.class_count();
+  this->AddFeatureMemory(ResizeBuffer(buffer.m_Probabilities, numberOfMaskVoxels * numberOfClasses));
+  std::fill(buffer.m_Probabilities.begin(), buffer.m_Probabilities.end(), 0.0);
+
+  this->AddFeatureMemory(ResizeBuffer(buffer.m_Labels, numberOfMaskVoxels));
+
+  if (m_FlattenedForest != nullptr)
+  {
+    m_FlattenedForest->Predict(buffer.m_Features.data(), numberOfVoxels, numberOfMaskVoxels,
+                               buffer.m_Probabilities.data(), numberOfMaskVoxels, buffer.m_Labels.data());
+  }
+  else
+  {
+    vigra::MultiArrayView<2, float, vigra::StridedArrayTag> X(
+      vigra::Shape2(numberOfMaskVoxels, numberOfFeatures), vigra::Shape2(1, numberOfVoxels), buffer.m_Features.data());
+    vigra::MultiArrayView<2, double> P(vigra::Shape2(numberOfMaskVoxels, numberOfClasses), buffer.m_Probabilities.data());
+    randomForest.predictProbabilities(X, P);
+
+    for (std::size_t row = 0; row < numberOfMaskVoxels; ++row)
+    {
+      int maxCol = 0;
+      for (int col = 1; col < numberOfClasses; ++col)
+      {
+        if (P(row, col) > P(row, maxCol))
+          maxCol = col;
+      }
+      randomForest.ext_param_.to_classlabel(maxCol, buffer.m_Labels[row]);
+    }
+  }
+
+  // write labels and probabilities of the mask voxels
+  itk::ImageRegionIterator<LabelImageType> labelIter(m_ItkLabelImage, block);
+  std::vector< itk::ImageRegionIterator<FeatureImageType> > probabilityIters;
+  for (const auto & probabilityImage : m_ItkProbabilityImages)
+    probabilityIters.push_back(itk::ImageRegionIterator<FeatureImageType>(probabilityImage, block));
+
+  std::size_t row = 0;
+  for (std::size_t i = 0; i < numberOfVoxels; ++i, ++labelIter)
+  {
+    if (buffer.m_Mask[i])
+    {
+      labelIter.Set(buffer.m_Labels[row]);
+
+      for (std::size_t col = 0; col < probabilityIters.size(); ++col)
+        probabilityIters[col].Set(static_cast<float>(buffer.m_Probabilities[col * numberOfMaskVoxels + row]));
+      ++row;
+    }
+    for (auto & iter : probabilityIters)
+      ++iter;
+  }
+
+  m_NumberOfClassifiedVoxels += numberOfMaskVoxels;
+}
@@ -82,12 +82,14 @@ struct mitk::VigraRandomForestClassifier::PredictionData
     const vigra::MultiArrayView<2, double> refFeature,
     vigra::MultiArrayView<2, int> refLabel,
     vigra::MultiArrayView<2, double> refProb,
-    vigra::MultiArrayView<2, double> refTreeWeights)
+    vigra::MultiArrayView<2, double> refTreeWeights,
+    const FlattenedRandomForest * flattenedForest)
     : m_RandomForest(refRF),
     m_Feature(refFeature),
     m_Label(refLabel),
     m_Probabilities(refProb),
-    m_TreeWeights(refTreeWeights)
+    m_TreeWeights(refTreeWeights),
+    m_FlattenedForest(flattenedForest)
   {
   }
   const vigra::RandomForest<int> & m_RandomForest;
@@ -95,10 +97,13 @@ struct mitk::VigraRandomForestClassifier::PredictionData
   vigra::MultiArrayView<2, int> m_Label;
   vigra::MultiArrayView<2, double> m_Probabilities;
   vigra::MultiArrayView<2, double> m_TreeWeights;
+  const FlattenedRandomForest * m_FlattenedForest; // nullptr if the vigra forest has to be used
 };
 
 mitk::VigraRandomForestClassifier::VigraRandomForestClassifier()
-  :m_Parameter(nullptr)
+  :m_Parameter(nullptr),
+  m_FlattenedForestIsValid(false),
+  m_UseFlattenedForest(true)
 {
   itk::SimpleMemberCommand<mitk::VigraRandomForestClassifier>::Pointer command = itk::SimpleMemberCommand<mitk::VigraRandomForestClassifier>::New();
   command->SetCallbackFunction(this, &mitk::VigraRandomForestClassifier::ConvertParameter);
@@ -124,6 +129,7 @@ void mitk::VigraRandomForestClassifier::OnlineTrain(const Eigen::MatrixXd & X_in
   vigra::MultiArrayView<2, double> X(vigra::Shape2(X_in.rows(),X_in.cols()),X_in.data());
   vigra::MultiArrayView<2, int> Y(vigra::Shape2(Y_in.rows(),Y_in.cols()),Y_in.data());
   m_RandomForest.onlineLearn(X,Y,0,true);
+  m_FlattenedForestIsValid = false;
 }
 
 void mitk::VigraRandomForestClassifier::Train(const Eigen::MatrixXd & X_in, const Eigen::MatrixXi &Y_in)
@@ -168,6 +174,7 @@ void mitk::VigraRandomForestClassifier::Train(const Eigen::MatrixXd & X_in, cons
   m_RandomForest.set_options().tree_count(m_Parameter->TreeCount);
   m_RandomForest.ext_param_.class_count_ = data->m_ClassCount;
   m_RandomForest.trees_ = data->trees_;
+  m_FlattenedForestIsValid = false;
 
   // Set Tree Weights to default
   m_TreeWeights = Eigen::MatrixXd(m_Parameter->TreeCount,1);
@@ -196,7 +203,7 @@ Eigen::MatrixXi mitk::VigraRandomForestClassifier::Predict(const Eigen::MatrixXd
   vigra::MultiArrayView<2, double> TW(vigra::Shape2(m_RandomForest.tree_count(),1),m_TreeWeights.data());
 
   std::unique_ptr<PredictionData> data;
-  data.reset( new PredictionData(m_RandomForest,X,Y,P,TW));
+  data.reset( new PredictionData(m_RandomForest,X,Y,P,TW,this->GetFlattenedRandomForest()));
 
   itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
   threader->SetSingleMethod(this->PredictCallback,data.get());
@@ -227,7 +234,7 @@ Eigen::MatrixXi mitk::VigraRandomForestClassifier::PredictWeighted(const Eigen::
   vigra::MultiArrayView<2, double> TW(vigra::Shape2(m_RandomForest.tree_count(),1),m_TreeWeights.data());
 
   std::unique_ptr<PredictionData> data;
-  data.reset( new PredictionData(m_RandomForest,X,Y,P,TW));
+  data.reset( new PredictionData(m_RandomForest,X,Y,P,TW,this->GetFlattenedRandomForest()));
 
   itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
   threader->SetSingleMethod(this->PredictWeightedCallback,data.get());
@@ -341,6 +348,13 @@ ITK_THREAD_RETURN_TYPE mitk::VigraRandomForestClassifier::PredictCallback(void *
     split_probability = data->m_Probabilities.subarray(lowerBound,upperBound);
   }
 
+  if (data->m_FlattenedForest != nullptr)
+  {
+    data->m_FlattenedForest->Predict(data->m_Feature.data() + start_index, data->m_Feature.stride(1), end_index - start_index,
+      data->m_Probabilities.data() + start_index, data->m_Probabilities.stride(1), data->m_Label.data() + start_index);
+    return NULL;
+  }
+
   data->m_RandomForest.predictLabels(split_features,split_labels);
   data->m_RandomForest.predictProbabilities(split_features, split_probability);
 
@@ -394,6 +408,14 @@ ITK_THREAD_RETURN_TYPE mitk::VigraRandomForestClassifier::PredictWeightedCallbac
     split_probability = data->m_Probabilities.subarray(lowerBound,upperBound);
   }
 
+  if (data->m_FlattenedForest != nullptr)
+  {
+    data->m_FlattenedForest->Predict(data->m_Feature.data() + start_index, data->m_Feature.stride(1), end_index - start_index,
+      data->m_Probabilities.data() + start_index, data->m_Probabilities.stride(1), data->m_Label.data() + start_index,
+      data->m_TreeWeights.data());
+    return NULL;
+  }
+
   VigraPredictWeighted(data, split_features,split_labels,split_probability);
 
   return NULL;
@@ -442,7 +464,7 @@ void mitk::VigraRandomForestClassifier::VigraPredictWeighted(PredictionData * da
     int maxCol = 0;
     for (int col=0;col<data->m_RandomForest.class_count();++col)
     {
-      if (data->m_Probabilities(row,col) > data->m_Probabilities(row, maxCol))
+      if (P(row,col) > P(row, maxCol))
         maxCol = col;
     }
     data->m_RandomForest.ext_param_.to_classlabel(maxCol, erg);
@@ -584,6 +606,26 @@ void mitk::VigraRandomForestClassifier::SetRandomForest(const vigra::RandomFores
   this->SetSamplesPerTree(rf.options().training_set_proportion_);
   this->UseSampleWithReplacement(rf.options().sample_with_replacement_);
   this->m_RandomForest = rf;
+  m_FlattenedForestIsValid = false;
+}
+
+void mitk::VigraRandomForestClassifier::UseFlattenedForest(bool value)
+{
+  m_UseFlattenedForest = value;
+}
+
+const mitk::FlattenedRandomForest * mitk::VigraRandomForestClassifier::GetFlattenedRandomForest()
+{
+  if (!m_UseFlattenedForest)
+    return nullptr;
+
+  if (!m_FlattenedForestIsValid)
+  {
+    if (!m_FlattenedForest.Compile(m_RandomForest))
+      MITK_WARN("VigraRandomForestClassifier") << "Forest contains unsupported nodes, it is evaluated without flattening.";
+    m_FlattenedForestIsValid = true;
+  }
+  return m_FlattenedForest.IsEmpty() ? nullptr : &m_FlattenedForest;
 }
 
 const vigra::RandomForest<int> & mitk::VigraRandomForestClassifier::GetRandomForest() const
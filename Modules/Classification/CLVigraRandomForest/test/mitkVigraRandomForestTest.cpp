@@ -22,10 +22,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkCSVArray2DFileReader.h>
 #include <itkCSVArray2DDataObject.h>
 #include <mitkVigraRandomForestClassifier.h>
+#include <mitkTiledVoxelClassifier.h>
 #include <itkLabelSampler.h>
 #include <itkAddImageFilter.h>
 #include <mitkImageCast.h>
 #include <mitkStandaloneDataStorage.h>
+#include <mitkImagePixelReadAccessor.h>
+#include <itkImageRegionIterator.h>
+#include <itkMeanImageFilter.h>
+#include <chrono>
 
 class mitkVigraRandomForestTestSuite : public mitk::TestFixture
 {
@@ -39,6 +44,9 @@ class mitkVigraRandomForestTestSuite : public mitk::TestFixture
   MITK_TEST(TrainThreadedDecisionForest_MatlabDataSet_shouldReturnTrue);
   MITK_TEST(PredictWeightedDecisionForest_SetWeightsToZero_shouldReturnTrue);
   MITK_TEST(TrainThreadedDecisionForest_BreastCancerDataSet_shouldReturnTrue);
+  MITK_TEST(TiledVoxelClassifier_SyntheticImage_shouldMatchPredict);
+  MITK_TEST(FlattenedForest_BothDataSets_shouldMatchVigraPrediction);
+  MITK_TEST(Benchmark_FlattenedForestPrediction);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -178,6 +186,208 @@ public:
   }
 
 
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+  /*
+  Predict and PredictWeighted with the flattened forest must return exactly the labels and
+  probabilities of the vigra evaluation.
+  */
+  void FlattenedForest_BothDataSets_shouldMatchVigraPrediction()
+  {
+    std::vector< std::pair<MatrixDoubleType*, MatrixIntType*> > dataSets;
+    dataSets.push_back(std::make_pair(&FeatureData_Matlab.first, &LabelData_Matlab.first));
+    dataSets.push_back(std::make_pair(&FeatureData_Cancer.first, &LabelData_Cancer.first));
+    std::vector<MatrixDoubleType*> testSets;
+    testSets.push_back(&FeatureData_Matlab.second);
+    testSets.push_back(&FeatureData_Cancer.second);
+
+    for (std::size_t i = 0; i < dataSets.size(); ++i)
+    {
+      classifier->Train(*dataSets[i].first, *dataSets[i].second);
+      CPPUNIT_ASSERT_MESSAGE("Trained forest can be flattened", classifier->GetFlattenedRandomForest() != nullptr);
+      CPPUNIT_ASSERT_EQUAL(classifier->GetRandomForest().tree_count(), static_cast<int>(classifier->GetFlattenedRandomForest()->GetNumberOfTrees()));
+
+      auto & Features_Testing = *testSets[i];
+
+      Eigen::MatrixXi flattenedLabels = classifier->Predict(Features_Testing);
+      Eigen::MatrixXd flattenedProbabilities = classifier->GetPointWiseProbabilities();
+      classifier->UseFlattenedForest(false);
+      Eigen::MatrixXi vigraLabels = classifier->Predict(Features_Testing);
+      Eigen::MatrixXd vigraProbabilities = classifier->GetPointWiseProbabilities();
+      classifier->UseFlattenedForest(true);
+
+      MITK_TEST_CONDITION(flattenedLabels == vigraLabels, "Flattened forest predicts the labels of the vigra forest");
+      MITK_TEST_CONDITION(flattenedProbabilities == vigraProbabilities, "Flattened forest predicts the probabilities of the vigra forest");
+
+      // non uniform tree weights, the votes are truncated to integers
+      Eigen::MatrixXd weights(classifier->GetRandomForest().tree_count(), 1);
+      for (int k = 0; k < weights.rows(); ++k)
+        weights(k, 0) = 0.5 + (k % 7) * 0.75;
+      classifier->SetTreeWeights(weights);
+
+      flattenedLabels = classifier->PredictWeighted(Features_Testing);
+      flattenedProbabilities = classifier->GetPointWiseProbabilities();
+      classifier->UseFlattenedForest(false);
+      vigraLabels = classifier->PredictWeighted(Features_Testing);
+      vigraProbabilities = classifier->GetPointWiseProbabilities();
+      classifier->UseFlattenedForest(true);
+
+      MITK_TEST_CONDITION(flattenedLabels == vigraLabels, "Flattened forest predicts the weighted labels of the vigra forest");
+      MITK_TEST_CONDITION(flattenedProbabilities == vigraProbabilities, "Flattened forest predicts the weighted probabilities of the vigra forest");
+    }
+  }
+
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+  /*
+  Reports the prediction throughput of the flattened and the vigra forest.
+  */
+  void Benchmark_FlattenedForestPrediction()
+  {
+    classifier->Train(FeatureData_Cancer.first, LabelData_Cancer.first);
+
+    // slightly enlarged test set, this runs with every unit test run and only reports a rough throughput
+    auto & Features_Testing = FeatureData_Cancer.second;
+    const int repetitions = 5;
+    MatrixDoubleType features(Features_Testing.rows() * repetitions, Features_Testing.cols());
+    for (int i = 0; i < repetitions; ++i)
+      features.block(i * Features_Testing.rows(), 0, Features_Testing.rows(), Features_Testing.cols()) = Features_Testing;
+
+    classifier->GetFlattenedRandomForest(); // compile outside of the measurement
+
+    auto start = std::chrono::steady_clock::now();
+    Eigen::MatrixXi flattenedLabels = classifier->Predict(features);
+    double flattenedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    classifier->UseFlattenedForest(false);
+    start = std::chrono::steady_clock::now();
+    Eigen::MatrixXi vigraLabels = classifier->Predict(features);
+    double vigraSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    MITK_INFO << "Prediction of " << features.rows() << " samples: flattened forest "
+              << features.rows() / flattenedSeconds << " samples/s, vigra forest "
+              << features.rows() / vigraSeconds << " samples/s";
+    MITK_TEST_CONDITION(flattenedLabels == vigraLabels, "Benchmark predictions are identical");
+  }
+
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+  /*
+  Classify an image block by block with a precomputed feature image and a neighborhood feature
+  which is computed per block. The result must match the prediction of the whole feature matrix.
+  */
+  void TiledVoxelClassifier_SyntheticImage_shouldMatchPredict()
+  {
+    typedef itk::Image<float, 3> FloatImageType;
+    typedef itk::Image<unsigned char, 3> MaskImageType;
+    typedef itk::MeanImageFilter<FloatImageType, FloatImageType> MeanFilterType;
+
+    FloatImageType::SizeType size = {{ 20, 16, 12 }};
+    FloatImageType::Pointer intensity = FloatImageType::New();
+    intensity->SetRegions(FloatImageType::RegionType(size));
+    intensity->Allocate();
+    MaskImageType::Pointer mask = MaskImageType::New();
+    mask->SetRegions(MaskImageType::RegionType(size));
+    mask->Allocate();
+
+    itk::ImageRegionIterator<FloatImageType> intensityIter(intensity, intensity->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<MaskImageType> maskIter(mask, mask->GetLargestPossibleRegion());
+    for (; !intensityIter.IsAtEnd(); ++intensityIter, ++maskIter)
+    {
+      FloatImageType::IndexType index = intensityIter.GetIndex();
+      intensityIter.Set((index[0] * 7 + index[1] * 3 + index[2] * 5) % 11);
+      maskIter.Set(index[0] > 0 ? 1 : 0);
+    }
+
+    MeanFilterType::InputSizeType radius;
+    radius.Fill(1);
+    MeanFilterType::Pointer meanFilter = MeanFilterType::New();
+    meanFilter->SetInput(intensity);
+    meanFilter->SetRadius(radius);
+    meanFilter->Update();
+    FloatImageType::Pointer mean = meanFilter->GetOutput();
+
+    // feature matrix of all mask voxels
+    unsigned int count = 0;
+    for (maskIter.GoToBegin(); !maskIter.IsAtEnd(); ++maskIter)
+      count += maskIter.Get();
+    Eigen::MatrixXd X(count, 2);
+    Eigen::MatrixXi Y(count, 1);
+    unsigned int row = 0;
+    for (maskIter.GoToBegin(); !maskIter.IsAtEnd(); ++maskIter)
+    {
+      if (maskIter.Get() == 0)
+        continue;
+      X(row, 0) = intensity->GetPixel(maskIter.GetIndex());
+      X(row, 1) = mean->GetPixel(maskIter.GetIndex());
+      Y(row, 0) = X(row, 1) > 5 ? 2 : 1;
+      ++row;
+    }
+
+    classifier->SetTreeCount(10);
+    classifier->Train(X, Y);
+    Eigen::MatrixXi expected = classifier->Predict(X);
+
+    // the mean is computed for each block, the halo provides the neighbors at the block border
+    auto meanFunction = [intensity](const itk::ImageRegion<3> & region, std::vector<FloatImageType::Pointer> & features)
+    {
+      FloatImageType::Pointer input = FloatImageType::New();
+      input->CopyInformation(intensity);
+      input->SetRegions(region);
+      input->Allocate();
+      itk::ImageRegionConstIterator<FloatImageType> sourceIter(intensity, region);
+      itk::ImageRegionIterator<FloatImageType> targetIter(input, region);
+      for (; !sourceIter.IsAtEnd(); ++sourceIter, ++targetIter)
+        targetIter.Set(sourceIter.Get());
+
+      MeanFilterType::InputSizeType meanRadius;
+      meanRadius.Fill(1);
+      MeanFilterType::Pointer filter = MeanFilterType::New();
+      filter->SetInput(input);
+      filter->SetRadius(meanRadius);
+      filter->SetNumberOfThreads(1);
+      filter->Update();
+      features.push_back(filter->GetOutput());
+    };
+
+    mitk::Image::Pointer mitkIntensity;
+    mitk::Image::Pointer mitkMask;
+    mitk::CastToMitkImage(intensity, mitkIntensity);
+    mitk::CastToMitkImage(mask, mitkMask);
+
+    mitk::TiledVoxelClassifier::Pointer tiledClassifier = mitk::TiledVoxelClassifier::New();
+    tiledClassifier->SetClassifier(classifier);
+    tiledClassifier->SetMask(mitkMask);
+    tiledClassifier->AddFeatureImage(mitkIntensity);
+    tiledClassifier->AddFeatureFunction(meanFunction, 1, 1);
+    tiledClassifier->SetBlockSize(7);
+    tiledClassifier->SetNumberOfThreads(3);
+    tiledClassifier->Update();
+
+    CPPUNIT_ASSERT_MESSAGE("All mask voxels classified", tiledClassifier->GetNumberOfClassifiedVoxels() == count);
+    CPPUNIT_ASSERT_MESSAGE("One probability image per class",
+      tiledClassifier->GetProbabilityImages().size() == static_cast<std::size_t>(classifier->GetRandomForest().class_count()));
+    CPPUNIT_ASSERT_MESSAGE("Feature memory is reported", tiledClassifier->GetPeakFeatureMemory() > 0);
+
+    mitk::ImagePixelReadAccessor<int, 3> labels(tiledClassifier->GetLabelImage());
+    unsigned int matches = 0;
+    unsigned int background = 0;
+    row = 0;
+    for (maskIter.GoToBegin(); !maskIter.IsAtEnd(); ++maskIter)
+    {
+      int label = labels.GetPixelByIndex(maskIter.GetIndex());
+      if (maskIter.Get() == 0)
+      {
+        background += label == 0;
+        continue;
+      }
+      matches += label == expected(row, 0);
+      ++row;
+    }
+    CPPUNIT_ASSERT_MESSAGE("Tiled labels match the labels of Predict()", matches == count);
+    CPPUNIT_ASSERT_MESSAGE("Voxels outside of the mask are 0", background == size[1] * size[2]);
+  }
+
   // ------------------------------------------------------------------------------------------------------
   // ------------------------------------------------------------------------------------------------------
   /*Reading an file, which includes the trainingdataset and the testdataset, and convert the
@@ -19,6 +19,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDataCollectionImageIterator.h>
 
 #include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+#include <mitkTiledVoxelClassifier.h>
 
 int mitk::DCUtilities::VoxelInMask(mitk::DataCollection::Pointer dc, std::string mask)
 {
@@ -280,4 +282,59 @@ void mitk::DCUtilities::EnsureDoubleImageInDC(mitk::DataCollection::Pointer dc,
       EnsureDoubleImageInDC(newCol, name, origin);
     }
   }
-}
\ No newline at end of file
+}
+
+// Gets an image of the collection as mitk::Image; the voxels are copied
+static mitk::Image::Pointer ImportCollectionImage(mitk::DataCollection* dc, const std::string& name)
+{
+  itk::DataObject* data = dc->GetData(name).GetPointer();
+  if (itk::Image<double, 3>* image = dynamic_cast<itk::Image<double, 3>*>(data))
+    return mitk::ImportItkImage(image);
+  if (itk::Image<unsigned char, 3>* image = dynamic_cast<itk::Image<unsigned char, 3>*>(data))
+    return mitk::ImportItkImage(image);
+  return dc->GetMitkImage(name);
+}
+
+void mitk::DCUtilities::ClassifyVoxels(mitk::DataCollection::Pointer dc, mitk::VigraRandomForestClassifier* forest,
+                                       const std::vector<std::string> &features, const std::string &mask,
+                                       const std::string &resultName, const std::vector<std::string> &probabilityNames)
+{
+  if (dc->HasElement(mask))
+  {
+    mitk::TiledVoxelClassifier::Pointer classifier = mitk::TiledVoxelClassifier::New();
+    classifier->SetClassifier(forest);
+    classifier->SetMask(ImportCollectionImage(dc, mask));
+    for (const auto& feature : features)
+      classifier->AddFeatureImage(ImportCollectionImage(dc, feature));
+    classifier->SetComputeProbabilities(!probabilityNames.empty());
+    classifier->Update();
+
+    std::vector<itk::DataObject::Pointer> results;
+    itk::Image<unsigned char, 3>::Pointer labels;
+    mitk::CastToItkImage(classifier->GetLabelImage(), labels);
+    results.push_back(labels.GetPointer());
+    std::vector<mitk::Image::Pointer> probabilities = classifier->GetProbabilityImages();
+    for (std::size_t i = 0; i < probabilityNames.size() && i < probabilities.size(); ++i)
+    {
+      itk::Image<double, 3>::Pointer probability;
+      mitk::CastToItkImage(probabilities[i], probability);
+      results.push_back(probability.GetPointer());
+    }
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+      const std::string& name = i == 0 ? resultName : probabilityNames[i - 1];
+      if (dc->HasElement(name))
+        dc->SetData(results[i], name);
+      else
+        dc->AddData(results[i], name, "");
+    }
+  }
+
+  for (std::size_t i = 0; i < dc->Size(); ++i)
+  {
+    mitk::DataCollection* subCollection = dynamic_cast<mitk::DataCollection*>(dc->GetData(i).GetPointer());
+    if (subCollection != nullptr)
+      ClassifyVoxels(subCollection, forest, features, mask, resultName, probabilityNames);
+  }
+}
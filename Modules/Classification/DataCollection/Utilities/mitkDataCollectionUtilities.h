@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 namespace mitk
 {
+  class VigraRandomForestClassifier;
+
   class MITKDATACOLLECTION_EXPORT DCUtilities
   {
   public:
@@ -41,6 +43,16 @@ namespace mitk
 
     static void EnsureUCharImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
     static void EnsureDoubleImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
+
+    /**
+    * \brief Classifies the mask voxels of dc and its sub collections block by block with a TiledVoxelClassifier.
+    *
+    * Unlike DC3dDToMatrixXd() no feature matrix of all voxels is created. The labels are stored as unsigned char
+    * image resultName, the class probabilities as double images probabilityNames (not computed if empty).
+    */
+    static void ClassifyVoxels(mitk::DataCollection::Pointer dc, mitk::VigraRandomForestClassifier* forest,
+                               const std::vector<std::string> &features, const std::string &mask,
+                               const std::string &resultName, const std::vector<std::string> &probabilityNames);
   };
 }
 
@@ -0,0 +1,140 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkAsynchronousSliceGenerator_h
+#define mitkAsynchronousSliceGenerator_h
+
+#include <MitkCoreExports.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkImage.h>
+#include <mitkPlaneGeometry.h>
+
+#include <vtkSmartPointer.h>
+
+#include <functional>
+#include <memory>
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkMitkThickSlicesFilter;
+
+namespace mitk {
+
+/**
+ * @brief Generates the slices of an image on a pool of background threads.
+ *
+ * ImageVtkMapper2D uses one generator per renderer if the property
+ * "Image Rendering.Asynchronous" of the node is true. The mapper keeps
+ * displaying the previous slice while the requested one is extracted
+ * (including thick slice compositing) and swaps it in as soon as the
+ * result callback requested a new render pass.
+ *
+ * Submit() replaces a request that is still waiting for a thread, and a
+ * result is only kept if no newer request has been submitted while it was
+ * generated. Thus, only the latest of many requests (e.g. while scrolling
+ * quickly through the slices) is fully processed.
+ *
+ * Requests are submitted and results are taken from the GUI thread. The
+ * result callback is called from a pool thread and must only schedule work
+ * on the GUI thread (see CallbackFromGUIThread).
+ *
+ * @ingroup Mapper
+ */
+class MITKCORE_EXPORT AsynchronousSliceGenerator
+{
+public:
+
+  /** \brief Everything that determines a slice. The geometries must not be changed after submission. */
+  struct MITKCORE_EXPORT Request
+  {
+    Request();
+
+    Image::ConstPointer Input;
+    unsigned long InputMTime;
+    PlaneGeometry::ConstPointer WorldGeometry;
+    BaseGeometry::ConstPointer ResliceTransformGeometry;
+    unsigned int TimeStep;
+    ExtractSliceFilter::ResliceInterpolation Interpolation;
+    bool InPlaneResampleExtentByGeometry;
+    int ThickSlicesMode;
+    int ThickSlicesNum;
+    double ThickSlicesSpacing;
+
+    /** \brief True if both requests describe the same slice of the same data. */
+    bool IsEquivalent(const Request& other) const;
+  };
+
+  /** \brief A generated slice and the information needed to place it in the scene. */
+  struct MITKCORE_EXPORT Result
+  {
+    Result();
+
+    Request SourceRequest;
+    vtkSmartPointer<vtkImageData> Slice;
+    vtkSmartPointer<vtkMatrix4x4> ResliceAxes;
+    double SliceBounds[6];
+    ScalarType MmPerPixel[2];
+  };
+
+  typedef std::function<void()> ResultCallback;
+
+  AsynchronousSliceGenerator();
+
+  /** \brief Drops all requests. A slice that is being generated is discarded when done. */
+  ~AsynchronousSliceGenerator();
+
+  /** \brief Called from a pool thread whenever a result has become available. */
+  void SetResultCallback(const ResultCallback& callback);
+
+  /** \brief Requests a slice, replacing all older requests. Nothing happens if an equivalent request is pending. */
+  void Submit(const Request& request);
+
+  /** \brief Drops the pending request and the available result. */
+  void Cancel();
+
+  /** \brief Moves the result of the latest request into result. Returns false if there is none (yet). */
+  bool TakeResult(Result& result);
+
+  bool HasResult() const;
+
+  /** \brief True while a request is waiting for or being processed by a thread. */
+  bool IsBusy() const;
+
+  /**
+   * \brief Extracts the slice described by request with the given filters.
+   *
+   * This is the actual work of the pool threads, which is also used by
+   * ImageVtkMapper2D for synchronous rendering. If copySlice is false, the
+   * slice of the result is the (reused) output of the filters.
+   */
+  static bool GenerateSlice(const Request& request, ExtractSliceFilter* reslicer,
+    vtkMitkThickSlicesFilter* thickSlicesFilter, Result& result, bool copySlice);
+
+private:
+
+  struct State;
+
+  static void ProcessRequests(const std::shared_ptr<State>& state);
+
+  std::shared_ptr<State> m_State;
+
+  AsynchronousSliceGenerator(const AsynchronousSliceGenerator&);
+  AsynchronousSliceGenerator& operator=(const AsynchronousSliceGenerator&);
+};
+
+}
+
+#endif // mitkAsynchronousSliceGenerator_h
@@ -26,6 +26,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkGeometry3D.h"
 #include "itkSimpleFastMutexLock.h"
 #include <map>
+#include <set>
+#include <vector>
 
 namespace mitk {
 
@@ -86,6 +88,39 @@ namespace mitk {
     //##
     void Remove(const mitk::DataStorage::SetOfObjects* nodes);
 
+    //##Documentation
+    //## @brief Starts a batch of Add() and Remove() calls
+    //##
+    //## Until the matching CommitBatch() call, added and removed nodes are only queued: Exists(),
+    //## GetAll() and all queries still return the state before the batch. Invalid calls (e.g. adding a
+    //## node twice) throw immediately. Batches can be nested, only the outermost CommitBatch() applies
+    //## the queued operations.
+    void BeginBatch();
+
+    //##Documentation
+    //## @brief Applies all Add() and Remove() calls since BeginBatch()
+    //##
+    //## The nodes are inserted and removed with one lock of the storage. RemoveNodeEvent and
+    //## AddNodeEvent are still emitted for every node (RemoveNodeEvents before the removals, AddNodeEvents
+    //## after the insertions), IsCommittingBatch(node) returns true while they are emitted. Afterwards
+    //## RemoveNodesEvent and AddNodesEvent are emitted once with all removed and added nodes, so
+    //## observers that react to the aggregated events can ignore the single node events of a batch.
+    void CommitBatch();
+
+    //##Documentation
+    //## @brief Returns true between BeginBatch() and CommitBatch()
+    bool IsBatchActive() const;
+
+    //##Documentation
+    //## @brief Returns true while the node events of a committed batch are emitted
+    bool IsCommittingBatch() const;
+
+    //##Documentation
+    //## @brief Returns true while the node events of a committed batch that contains the node are emitted
+    //##
+    //## Nodes added or removed outside of the batch during the commit (e.g. by an observer) return false.
+    bool IsCommittingBatch(const mitk::DataNode* node) const;
+
     //##Documentation
     //## @brief returns a set of data objects that meet the given condition(s)
     //##
@@ -101,7 +136,7 @@ namespace mitk {
     //## (see definition of NodePredicateBase for details).
     //## The method returns a set of SmartPointers to the DataNodes that fulfill the
     //## conditions. A set of all objects can be retrieved with the GetAll() method;
-    SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const;
+    virtual SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const;
 
     //##Documentation
     //## @brief returns a set of source objects for a given node that meet the given condition(s).
@@ -249,6 +284,27 @@ namespace mitk {
 
     DataStorageEvent InteractorChangedNodeEvent;
 
+    /* Events of batches */
+    typedef Message1<const SetOfObjects*> DataStorageBatchEvent;
+
+    //##Documentation
+    //## @brief AddNodesEvent is emitted once after the nodes of a batch have been added (see CommitBatch()).
+    //##
+    //## The single AddNodeEvents of the batch are emitted before this event.
+
+    // member variable is not needed to be locked in multi threaded scenarios since the DataStorageBatchEvent is a typedef for
+    // a Message1 object which is thread safe
+    DataStorageBatchEvent AddNodesEvent;
+
+    //##Documentation
+    //## @brief RemoveNodesEvent is emitted once after the nodes of a batch have been removed (see CommitBatch()).
+    //##
+    //## The single RemoveNodeEvents of the batch are emitted before the nodes are removed.
+
+    // member variable is not needed to be locked in multi threaded scenarios since the DataStorageBatchEvent is a typedef for
+    // a Message1 object which is thread safe
+    DataStorageBatchEvent RemoveNodesEvent;
+
 
     //##Documentation
     //## @brief Compute the axis-parallel bounding geometry of the input objects
@@ -346,6 +402,38 @@ namespace mitk {
     void BlockNodeModifiedEvents( bool block );
 
   protected:
+    //##Documentation
+    //## @brief Add() or Remove() call queued during a batch
+    struct BatchOperation
+    {
+      mitk::DataNode::Pointer Node;
+      SetOfObjects::ConstPointer Parents;
+      bool Remove;
+    };
+    typedef std::vector<BatchOperation> BatchOperations;
+
+    //##Documentation
+    //## @brief Queues an Add() call if a batch is active, returns false if the node has to be added immediately
+    //##
+    //## Throws the same exceptions as Add() for nodes that are already stored or queued.
+    bool QueueBatchAdd(mitk::DataNode* node, const mitk::DataStorage::SetOfObjects* parents);
+
+    //##Documentation
+    //## @brief Queues a Remove() call if a batch is active, returns false if the node has to be removed immediately
+    bool QueueBatchRemove(const mitk::DataNode* node);
+
+    //##Documentation
+    //## @brief Applies the operations of a committed batch, removals first
+    //##
+    //## The default implementation calls Remove() and Add() for every operation. Subclasses
+    //## apply the operations under one lock and have to emit the node events and batch events
+    //## like this implementation (see EmitBatchEvents()).
+    virtual void CommitBatchOperations(const BatchOperations& operations);
+
+    //##Documentation
+    //## @brief Emits RemoveNodesEvent and AddNodesEvent for a committed batch
+    void EmitBatchEvents(const SetOfObjects* removedNodes, const SetOfObjects* addedNodes);
+
     //##Documentation
     //## @brief  EmitAddNodeEvent emits the AddNodeEvent
     //##
@@ -394,6 +482,14 @@ namespace mitk {
     //## to suppress NodeChangedEvent to be emitted.
     bool m_BlockNodeModifiedEvents;
 
+    //##Documentation
+    //## @brief Nesting depth of BeginBatch() calls, the queued operations and the nodes of the
+    //## batch that is being committed, locked by m_BatchMutex
+    unsigned int m_BatchDepth;
+    BatchOperations m_BatchOperations;
+    std::set<const mitk::DataNode*> m_CommittingNodes;
+    mutable itk::SimpleFastMutexLock m_BatchMutex;
+
     //##Documentation
     //## @brief Standard Constructor for ::New() instantiation
     DataStorage();
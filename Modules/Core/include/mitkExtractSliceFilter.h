@@ -118,7 +118,7 @@ namespace mitk
     * SetVtkOutputRequest(true) has to be called at least once before
     * GetVtkOutput(). Otherwise the output is empty for the first update step.
     */
-    vtkImageData* GetVtkOutput(){ m_VtkOutputRequested = true; return m_Reslicer->GetOutput(); }
+    vtkImageData* GetVtkOutput();
 
     /** Set VtkOutPutRequest to suppress the convertion of the image.
     * It is suggested to use this with GetVtkOutput().
@@ -141,6 +141,16 @@ namespace mitk
 
     void SetInterpolationMode( ExtractSliceFilter::ResliceInterpolation interpolation){ this->m_InterpolationMode = interpolation; }
 
+    /** \brief Extract slices that are aligned with the image axes without vtkImageReslice.
+    * If enabled, 2D slices whose axes are parallel to the axes of the input image are extracted
+    * by multithreaded nearest neighbor and linear kernels that write directly into the output,
+    * which is reused as long as the size of the slice does not change. All other slices are
+    * extracted by vtkImageReslice.
+    * Enabled by default, unless a custom reslicer is passed to the constructor.
+    */
+    void SetUseAxisAlignedKernels(bool useAxisAlignedKernels){ this->m_UseAxisAlignedKernels = useAxisAlignedKernels; this->Modified(); }
+    bool GetUseAxisAlignedKernels() const { return this->m_UseAxisAlignedKernels; }
+
   protected:
     ExtractSliceFilter(vtkImageReslice* reslicer = nullptr);
     virtual ~ExtractSliceFilter();
@@ -149,6 +159,15 @@ namespace mitk
     virtual void GenerateOutputInformation() override;
     virtual void GenerateInputRequestedRegion() override;
 
+    /** \brief Extracts the slice with the axis aligned kernels.
+    * Expects the reslicer to be set up already and the output extent [xMin, xMax] x [yMin, yMax]
+    * (last pixel included). Returns false if the kernels cannot be used for the current slice.
+    */
+    bool ExtractAxisAlignedSlice(mitk::Image* input, int xMin, int xMax, int yMin, int yMax);
+
+    /** \brief Lookup tables of the axis aligned kernels, kept between calls */
+    struct AxisAlignedSliceTables;
+
     const PlaneGeometry* m_WorldGeometry;
     vtkSmartPointer<vtkImageReslice> m_Reslicer;
 
@@ -173,6 +192,14 @@ namespace mitk
     bool m_VtkOutputRequested;
 
     double m_BackgroundLevel;
+
+    bool m_UseAxisAlignedKernels;
+
+    AxisAlignedSliceTables* m_AxisAlignedSliceTables;
+
+    vtkSmartPointer<vtkImageData> m_KernelVtkOutput;
+
+    bool m_VtkOutputFromKernel;
   };
 }
 
@@ -28,6 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageDescriptor.h"
 #include "mitkImageAccessorBase.h"
 #include "mitkImageVtkAccessor.h"
+#include "mitkSharedMutex.h"
 
 //DEPRECATED
 #include <mitkTimeSlicedGeometry.h>
@@ -49,6 +50,7 @@ class SubImageSelector;
 class ImageTimeSelector;
 
 class ImageStatisticsHolder;
+class ImageTimeStepCache;
 
 //##Documentation
 //## @brief Image class for storing images
@@ -238,6 +240,19 @@ public:
   //## @sa SetPicChannel
   virtual bool SetImportChannel(void *data, int n = 0, ImportMemoryManagementType importMemoryManagement = CopyMemory );
 
+  //##Documentation
+  //## @brief Use the memory mapped file @a mappedFile as data of channel @a n.
+  //##
+  //## The data is not copied: volumes and slices of the channel reference the
+  //## mapping, so only the parts of the file which are actually accessed (e.g. by
+  //## GetVolumeData(t) or GetSliceData(s,t)) are paged into memory. The mapping
+  //## must contain at least as many bytes as the channel. If the file has been
+  //## opened in MemoryMappedFile::ReadOnly mode, write accessors to the image are refused.
+  //## Image must be initialized before.
+  //## @return false if the channel is invalid or the mapping is too small.
+  //## @sa MemoryMappedFile
+  virtual bool SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n = 0);
+
   //##Documentation
   //## initialize new (or re-initialize) image information
   //## @warning Initialize() by pic assumes a plane, evenly spaced geometry starting at (0,0,0).
@@ -593,11 +608,61 @@ public:
     return m_ImageStatistics;
   }
 
+  /**
+    \brief Returns how often an image accessor had to wait for another, overlapping accessor.
+
+    Read accessors share their image part with any number of other read accessors, only
+    write accessors require exclusive ownership. Requests rejected because of
+    ImageAccessorBase::ExceptionIfLocked are counted as well.
+    */
+  unsigned long GetAccessorContentionCount() const;
+
+  /**
+    \brief Returns how often GetSliceData(), GetVolumeData() or GetChannelData() had to wait for the
+    internal lock of the data item arrays.
+
+    Lookups of data items that already exist take the lock in shared mode and do not block each other.
+    */
+  unsigned long GetDataArraysContentionCount() const;
+
+  /**
+    \brief Resets the counters returned by GetAccessorContentionCount() and GetDataArraysContentionCount().
+    */
+  void ResetContentionCounts();
+
+  /**
+    \brief Limits the memory occupied by the volumes (time steps) of the image.
+
+    At most \a maximumResidentVolumes volumes and (if not 0) at most \a maximumResidentBytes
+    bytes of volume data stay resident. When a volume is requested via GetVolumeData(),
+    GetSliceData() or GetVtkImageData(), the least recently used volumes are evicted:
+    volumes which are memory mapped (see SetMemoryMappedChannel()) release their pages back
+    to the file, all other volumes are kept zlib compressed in memory and are decompressed
+    on their next request. Volumes still in use (referenced data items, accessors or
+    vtkImageData) are never evicted. When time steps are requested one after another (e.g.
+    during cine playback driven by the time SliceNavigationController), the next time step
+    is made resident on a background thread.
+
+    Channel data which is stored as one block (e.g. after reading an image with IOUtil) is split
+    into separately allocated volumes by this call. Accessing the complete channel
+    (GetChannelData(), GetData() or accessors without data item) makes all volumes resident again.
+
+    Passing 0 for both limits disables the policy and makes all volumes resident again.
+    The policy should be set before the image is shared between threads.
+    */
+  void SetTimeStepCachePolicy(unsigned int maximumResidentVolumes, size_t maximumResidentBytes = 0);
+
+  /**
+    \brief Returns the time step cache (statistics on resident and compressed volumes), NULL if no policy has been set.
+    */
+  const ImageTimeStepCache* GetTimeStepCache() const;
+
 protected:
 
   mitkCloneMacro(Self);
 
-  typedef itk::MutexLockHolder<itk::SimpleFastMutexLock> MutexHolder;
+  typedef itk::MutexLockHolder<SharedMutex> MutexHolder;
+  typedef SharedMutexLockHolder SharedMutexHolder;
 
   int GetSliceIndex(int s = 0, int t = 0, int n = 0) const;
 
@@ -631,7 +696,10 @@ protected:
   mutable ImageDataItemPointerArray m_Channels;
   mutable ImageDataItemPointerArray m_Volumes;
   mutable ImageDataItemPointerArray m_Slices;
-  mutable itk::SimpleFastMutexLock m_ImageDataArraysLock;
+  /** Guards m_Channels, m_Volumes and m_Slices. Lookups of already existing
+    * data items only need shared ownership, allocation and combination of
+    * data items require exclusive ownership. */
+  mutable SharedMutex m_ImageDataArraysLock;
 
   unsigned int m_Dimension;
 
@@ -660,6 +728,16 @@ private:
   bool IsVolumeSet_unlocked(int t, int n) const;
   bool IsChannelSet_unlocked(int n) const;
 
+  /** Volumes with their own memory or memory mapped volumes can be evicted by the time step cache */
+  bool IsVolumeEvictable(const ImageDataItem* vol) const;
+  /** Registers the access of a volume with the time step cache, triggers prefetching and eviction */
+  void UpdateTimeStepCache(const ImageDataItem* vol, int t, int n) const;
+  /** Evicts least recently used volumes until the limits of the time step cache are met */
+  void EnforceTimeStepCacheLimits(int keepVolumeIndex) const;
+  bool EvictVolume_unlocked(int volumeIndex) const;
+  void PrefetchVolume(int volumeIndex) const;
+  void SplitChannelIntoVolumes_unlocked(int n);
+
   /** Stores all existing ImageReadAccessors */
   mutable std::vector<ImageAccessorBase*> m_Readers;
   /** Stores all existing ImageWriteAccessors */
@@ -672,6 +750,13 @@ private:
   /** A mutex, which needs to be locked to manage m_VtkReaders */
   itk::SimpleFastMutexLock m_VtkReadersLock;
 
+  /** Number of image accessors that had to wait for (or were rejected by) an overlapping accessor.
+    * Only modified while m_ReadWriteLock is locked. */
+  mutable unsigned long m_AccessorContentionCount;
+
+  /** Bookkeeping of the time step cache policy, NULL if no policy has been set */
+  ImageTimeStepCache* m_TimeStepCache;
+
 };
 
  /**
@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <mitkIpPic.h>
 //#include "mitkPixelType.h"
 #include "mitkImageDescriptor.h"
+#include "mitkMemoryMappedFile.h"
 //#include "mitkImageVtkAccessor.h"
 
 class vtkImageData;
@@ -88,6 +89,14 @@ namespace mitk {
 
     ImageDataItem(const mitk::PixelType& type, int timestep, unsigned int dimension, unsigned int* dimensions, void* data, bool manageMemory);
 
+    //##Documentation
+    //## @brief Creates a data item for the whole image described by @a desc whose
+    //## memory is provided by @a mappedFile.
+    //##
+    //## The item keeps the mapping alive, sub-items (volumes, slices) reference it
+    //## through their parent. The data is never copied, pages are loaded on first access.
+    ImageDataItem(const mitk::ImageDescriptor::Pointer desc, int timestep, MemoryMappedFile* mappedFile);
+
     ImageDataItem(const ImageDataItem &other);
 
    /**
@@ -171,6 +180,19 @@ namespace mitk {
 
     virtual void Modified() const;
 
+    //##Documentation
+    //## @brief Returns true if the data of this item (or of its parent) is backed by a MemoryMappedFile.
+    bool IsMemoryMapped() const;
+
+    //##Documentation
+    //## @brief Returns the MemoryMappedFile backing the data of this item (or of its parent), NULL if there is none.
+    MemoryMappedFile* GetMemoryMappedFile() const;
+
+    //##Documentation
+    //## @brief Returns true if the data of this item must not be written, i.e. it is
+    //## backed by a MemoryMappedFile opened in MemoryMappedFile::ReadOnly mode.
+    bool IsReadOnly() const;
+
   protected:
     unsigned char* m_Data;
 
@@ -187,6 +209,8 @@ namespace mitk {
 
     unsigned long m_Size;
 
+    MemoryMappedFile::Pointer m_MappedFile;
+
   private:
     void ComputeItemSize( const unsigned int* dimensions, unsigned int dimension);
 
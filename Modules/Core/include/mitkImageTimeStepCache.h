@@ -0,0 +1,147 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIMAGETIMESTEPCACHE_H
+#define MITKIMAGETIMESTEPCACHE_H
+
+#include <MitkCoreExports.h>
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mitk {
+
+/**
+ * @brief Bookkeeping for the bounded residency of image volumes (time steps).
+ *
+ * The cache is owned by mitk::Image (see Image::SetTimeStepCachePolicy()) and
+ * is not meant to be used directly. It tracks the least recently used order of
+ * resident volumes, decides which volumes exceed the configured limits, keeps
+ * evicted volumes in a zlib compressed in-memory form and runs prefetch requests
+ * on a background thread.
+ *
+ * Volumes are identified by the volume index of mitk::Image (time step and channel).
+ * All methods are thread safe.
+ *
+ * @ingroup Data
+ */
+class MITKCORE_EXPORT ImageTimeStepCache
+{
+public:
+
+  typedef std::function<void(int)> PrefetchFunction;
+
+  ImageTimeStepCache();
+  ~ImageTimeStepCache();
+
+  /** \brief Maximum number of resident volumes, 0 means unlimited. */
+  void SetMaximumResidentVolumes(unsigned int maximum);
+  unsigned int GetMaximumResidentVolumes() const;
+
+  /** \brief Maximum number of bytes of resident volumes, 0 means unlimited. */
+  void SetMaximumResidentBytes(size_t maximum);
+  size_t GetMaximumResidentBytes() const;
+
+  /** \brief True if at least one limit is set. */
+  bool IsEnabled() const;
+
+  /** \brief Marks a resident volume of \a sizeInBytes as most recently used. */
+  void Touch(int volumeIndex, size_t sizeInBytes);
+
+  /** \brief Removes a volume from the resident set, e.g. after it has been evicted. */
+  void Forget(int volumeIndex);
+
+  /** \brief Removes an evicted volume from the resident set and counts the eviction. */
+  void Evicted(int volumeIndex);
+
+  /** \brief True if the resident volumes exceed one of the limits. */
+  bool IsOverLimit() const;
+
+  /** \brief Returns resident volumes in least recently used order, \a keep is never returned. */
+  std::vector<int> GetEvictionCandidates(int keep) const;
+
+  /** \brief Stores a compressed copy of the volume data. */
+  void StoreCompressed(int volumeIndex, const void* data, size_t sizeInBytes);
+
+  /** \brief True if a compressed copy of the volume exists. */
+  bool HasCompressed(int volumeIndex) const;
+
+  /** \brief Decompresses the volume into \a data and drops the compressed copy.
+    * \return false if there is no compressed copy or it is corrupt. */
+  bool RestoreCompressed(int volumeIndex, void* data, size_t sizeInBytes);
+
+  /** \brief Drops the compressed copy of a volume, e.g. because it is overwritten. */
+  void DiscardCompressed(int volumeIndex);
+
+  /** \brief Drops all bookkeeping and all compressed copies. */
+  void Clear();
+
+  /** \brief Installs the function which makes a volume resident on the prefetch thread. */
+  void SetPrefetchFunction(const PrefetchFunction& function);
+
+  /** \brief Requests a volume to be made resident in the background.
+    * Pending requests which have not been started yet are replaced. */
+  void RequestPrefetch(int volumeIndex);
+
+  /** \brief Remembers the last requested time step and returns the previous one. */
+  int ExchangeLastRequestedTimeStep(int timeStep);
+
+  unsigned int GetNumberOfResidentVolumes() const;
+  size_t GetResidentBytes() const;
+  unsigned int GetNumberOfCompressedVolumes() const;
+  size_t GetCompressedBytes() const;
+  unsigned long GetNumberOfEvictions() const;
+  unsigned long GetNumberOfRestores() const;
+
+private:
+
+  ImageTimeStepCache(const ImageTimeStepCache&);            // Not implemented on purpose.
+  ImageTimeStepCache& operator=(const ImageTimeStepCache&); // Not implemented on purpose.
+
+  void PrefetchLoop();
+
+  mutable std::mutex m_Mutex;
+
+  unsigned int m_MaximumResidentVolumes;
+  size_t m_MaximumResidentBytes;
+
+  /** Resident volumes, most recently used first */
+  std::list<std::pair<int, size_t> > m_LRUList;
+  std::map<int, std::list<std::pair<int, size_t> >::iterator> m_LRUIndex;
+  size_t m_ResidentBytes;
+
+  std::map<int, std::vector<unsigned char> > m_CompressedVolumes;
+  size_t m_CompressedBytes;
+
+  unsigned long m_NumberOfEvictions;
+  unsigned long m_NumberOfRestores;
+  int m_LastRequestedTimeStep;
+
+  PrefetchFunction m_PrefetchFunction;
+  std::thread m_PrefetchThread;
+  std::condition_variable m_PrefetchCondition;
+  int m_PendingPrefetch;
+  bool m_StopPrefetch;
+};
+
+}
+
+#endif // MITKIMAGETIMESTEPCACHE_H
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseRenderer.h"
 #include "mitkVtkMapper.h"
 #include "mitkExtractSliceFilter.h"
+#include "mitkAsynchronousSliceGenerator.h"
 
 //VTK
 #include <vtkSmartPointer.h>
@@ -89,6 +90,9 @@ namespace mitk {
  *   - \b "texture interpolation": (BoolProperty) texture interpolation of the image
  *   - \b "reslice interpolation": (VtkResliceInterpolationProperty) reslice interpolation of the image
  *   - \b "in plane resample extent by geometry": (BoolProperty) Do it or not
+ *   - \b "Image Rendering.Asynchronous": (BoolProperty) Extract the slices on background
+ *          threads (see AsynchronousSliceGenerator). The previous slice is shown until the
+ *          new one is available, so scrolling does not block the GUI thread.
  *   - \b "bounding box": (BoolProperty) Is the Bounding Box of the image shown or not
  *   - \b "layer": (IntProperty) Layer of the image
  *   - \b "volume annotation color": (ColorProperty) color of the volume annotation, TODO has to be reimplemented
@@ -104,6 +108,7 @@ namespace mitk {
  *   - \b "texture interpolation", mitk::BoolProperty::New( mitk::DataNodeFactory::m_TextureInterpolationActive ) )
  *   - \b "reslice interpolation", mitk::VtkResliceInterpolationProperty::New() )
  *   - \b "in plane resample extent by geometry", mitk::BoolProperty::New( false ) )
+ *   - \b "Image Rendering.Asynchronous", mitk::BoolProperty::New( false ), renderer, overwrite )
  *   - \b "bounding box", mitk::BoolProperty::New( false ) )
  *   - \b "layer", mitk::IntProperty::New(10), renderer, overwrite)
  *   - \b "Image Rendering.Transfer Function":  Default color transfer function for CTs
@@ -187,6 +192,11 @@ public:
     /** \brief mmPerPixel relation between pixel and mm. (World spacing).*/
     mitk::ScalarType* m_mmPerPixel;
 
+    /** \brief Generates the slices if "Image Rendering.Asynchronous" is true. */
+    mitk::AsynchronousSliceGenerator m_SliceGenerator;
+    /** \brief The slice shown in the render window together with its position and spacing. */
+    mitk::AsynchronousSliceGenerator::Result m_DisplayedSlice;
+
     /** \brief This filter is used to apply the level window to Grayvalue and RBG(A) images. */
     vtkSmartPointer<vtkMitkLevelWindowFilter> m_LevelWindowFilter;
 
@@ -258,6 +268,13 @@ protected:
     */
   virtual void GenerateDataForRenderer(mitk::BaseRenderer *renderer) override;
 
+  /** \brief Shows the requested slice if it has been generated in the background, otherwise submits it.
+    *
+    * Returns false if the previous slice stays displayed until the requested one is available. In this
+    * case, a render window update is requested as soon as the generator has finished.
+    */
+  bool UpdateSliceAsynchronously(mitk::BaseRenderer* renderer, const mitk::AsynchronousSliceGenerator::Request& request);
+
   /** \brief This method uses the vtkCamera clipping range and the layer property
     * to calcualte the depth of the object (e.g. image or contour). The depth is used
     * to keep the correct order for the final VTK rendering.*/
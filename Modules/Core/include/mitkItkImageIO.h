@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 namespace mitk {
 
+class MemoryMappedFile;
+
 /**
  * This class wraps ITK image IO objects as mitk::IFileReader and
  * mitk::IFileWriter objects.
@@ -40,6 +42,18 @@ public:
   ItkImageIO(itk::ImageIOBase::Pointer imageIO);
   ItkImageIO(const CustomMimeType& mimeType, itk::ImageIOBase::Pointer imageIO, int rank);
 
+  /**
+   * Reader option for NRRD files: map uncompressed (raw encoded) image data
+   * directly from the file instead of reading it into memory. Possible values are
+   * OPTION_MEMORY_MAPPING_OFF(), OPTION_MEMORY_MAPPING_READ_ONLY() and
+   * OPTION_MEMORY_MAPPING_COPY_ON_WRITE(). Files which cannot be mapped
+   * (compressed, foreign byte order, multi-component pixels) are read as usual.
+   */
+  static std::string OPTION_MEMORY_MAPPING();
+  static std::string OPTION_MEMORY_MAPPING_OFF();
+  static std::string OPTION_MEMORY_MAPPING_READ_ONLY();
+  static std::string OPTION_MEMORY_MAPPING_COPY_ON_WRITE();
+
   // -------------- AbstractFileReader -------------
 
   using AbstractFileReader::Read;
@@ -59,12 +73,18 @@ protected:
   // Fills the m_DefaultMetaDataKeys vector with default values
   virtual void InitializeDefaultMetaDataKeys();
 
+  // Registers reader options which depend on the wrapped ITK ImageIO
+  virtual void InitializeDefaultReaderOptions();
+
 private:
 
   ItkImageIO(const ItkImageIO& other);
 
   ItkImageIO* IOClone() const override;
 
+  // Maps the image data of path if requested by OPTION_MEMORY_MAPPING() and supported by the file, returns NULL otherwise
+  itk::SmartPointer<MemoryMappedFile> MapImageData(const std::string& path) const;
+
   itk::ImageIOBase::Pointer m_ImageIO;
 
   std::vector< std::string > m_DefaultMetaDataKeys;
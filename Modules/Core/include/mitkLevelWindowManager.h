@@ -97,6 +97,16 @@ namespace mitk
       */
     void DataStorageRemovedNode(const DataNode* removedNode = nullptr);
 
+    /** @brief This method is called once after the nodes of a batch were added to the data storage (see DataStorage::CommitBatch()).
+      *        The single node events of the batch are ignored.
+      */
+    void DataStorageAddedNodes(const DataStorage::SetOfObjects* addedNodes);
+
+    /** @brief This method is called once after the nodes of a batch were removed from the data storage (see DataStorage::CommitBatch()).
+      *        The single node events of the batch are ignored.
+      */
+    void DataStorageRemovedNodes(const DataStorage::SetOfObjects* removedNodes);
+
     /** @brief change notifications from mitkLevelWindowProperty */
     void OnPropertyModified(const itk::EventObject& e);
 
@@ -103,6 +103,28 @@ public:
   //## corresponding to the given values; if nothing found, then returns NULL
   virtual OperationEvent* GetLastOfType(OperationActor* destination, OperationType opType) override;
 
+  //##Documentation
+  //## @brief Maximum number of bytes occupied by the items of both stacks, 0 (default) means no limit
+  //##
+  //## If a new item exceeds the limit, the oldest groups of the undo stack are
+  //## dropped (signalled by an UndoFullEvent). The latest group is always kept.
+  //## Default for new instances is GetDefaultMemoryLimit().
+  virtual void SetMemoryLimit(std::size_t memoryLimit);
+  std::size_t GetMemoryLimit() const;
+
+  //##Documentation
+  //## @brief Memory limit of all undo models created afterwards
+  static void SetDefaultMemoryLimit(std::size_t memoryLimit);
+  static std::size_t GetDefaultMemoryLimit();
+
+  //##Documentation
+  //## @brief Approximate number of bytes occupied by the items of the undo stack
+  std::size_t GetUndoMemorySize() const;
+
+  //##Documentation
+  //## @brief Approximate number of bytes occupied by the items of the redo stack
+  std::size_t GetRedoMemorySize() const;
+
 protected:
   //##Documentation
   //## Constructor
@@ -116,11 +138,24 @@ protected:
   //## elements in the list and to clear the list
   void ClearList(UndoContainer* list);
 
+  //##Documentation
+  //## @brief Drops the oldest groups of the undo stack until the memory limit is met
+  //##
+  //## Called by SetOperationEvent() after a new item has been added.
+  void EnforceMemoryLimit();
+
+  static std::size_t GetMemorySize(const UndoContainer& list);
+
   UndoContainer m_UndoList;
 
   UndoContainer m_RedoList;
 
+  std::size_t m_MemoryLimit;
+
 private:
+
+  static std::size_t s_DefaultMemoryLimit;
+
   int FirstObjectEventIdOfCurrentGroup(UndoContainer& stack);
 
 };
@@ -134,7 +169,7 @@ itkEventMacro( UndoEmptyEvent,     UndoStackEvent );
 itkEventMacro( RedoEmptyEvent,     UndoStackEvent );
 itkEventMacro( UndoNotEmptyEvent,  UndoStackEvent );
 itkEventMacro( RedoNotEmptyEvent,  UndoStackEvent );
-/// Additional unused events, if anybody wants to put an artificial limit to the possible number of items in the stack
+/// UndoFullEvent is sent when items have been dropped from the undo stack because of the memory limit
 itkEventMacro( UndoFullEvent,      UndoStackEvent );
 itkEventMacro( RedoFullEvent,      UndoStackEvent );
 
@@ -0,0 +1,158 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMEMORYMAPPEDFILE_H
+#define MITKMEMORYMAPPEDFILE_H
+
+#include <MitkCoreExports.h>
+#include "mitkCommon.h"
+
+#include <itkLightObject.h>
+
+#include <string>
+
+namespace mitk {
+
+  /**
+   * @brief Maps a region of a file into memory.
+   *
+   * MemoryMappedFile is used as an out-of-core backing store for image data
+   * (see ImageDataItem and Image::SetMemoryMappedChannel). Pages of the file are
+   * only read by the operating system when they are touched, so images larger
+   * than the physical memory can be handled as long as only parts of them are
+   * accessed at a time.
+   *
+   * Three access modes are supported:
+   * - ReadOnly: the mapping must not be written to, image write accessors are refused.
+   * - CopyOnWrite: writes are allowed, modified pages are private to the process
+   *   and never written back to the file.
+   * - ReadWrite: writes are allowed and go directly to the file.
+   *
+   * A scratch file (a temporary file which is removed as soon as it is no longer
+   * mapped) can be created with CreateScratchFile().
+   *
+   * @ingroup Data
+   */
+  class MITKCORE_EXPORT MemoryMappedFile : public itk::LightObject
+  {
+  public:
+
+    mitkClassMacroItkParent(MemoryMappedFile, itk::LightObject);
+
+    enum AccessMode
+    {
+      ReadOnly,
+      CopyOnWrite,
+      ReadWrite
+    };
+
+    /**
+     * @brief Maps \a size bytes of the file \a path starting at byte \a offset.
+     *
+     * The offset does not need to be aligned to the page size.
+     * @throws mitk::Exception if the file cannot be opened or mapped or is too small.
+     */
+    static Pointer Open(const std::string& path, unsigned long long offset, unsigned long long size,
+                        AccessMode mode = ReadOnly);
+
+    /**
+     * @brief Creates a temporary file of \a size bytes and maps it in ReadWrite mode.
+     *
+     * The file is created in \a directory (defaults to IOUtil::GetTempPath()) and
+     * deleted when the mapping is released.
+     * @throws mitk::Exception if the file cannot be created or mapped.
+     */
+    static Pointer CreateScratchFile(unsigned long long size, const std::string& directory = std::string());
+
+    /** \brief Start of the mapped region as requested in Open(). */
+    void* GetData() const
+    {
+      return m_Data;
+    }
+
+    unsigned long long GetSize() const
+    {
+      return m_Size;
+    }
+
+    unsigned long long GetOffset() const
+    {
+      return m_Offset;
+    }
+
+    AccessMode GetAccessMode() const
+    {
+      return m_AccessMode;
+    }
+
+    bool IsReadOnly() const
+    {
+      return m_AccessMode == ReadOnly;
+    }
+
+    const std::string& GetFileName() const
+    {
+      return m_FileName;
+    }
+
+    /** \brief Writes modified pages of a ReadWrite mapping back to the file. */
+    void Flush();
+
+    /**
+     * @brief Releases the physical memory of the pages in the given range of the mapping.
+     *
+     * The data stays accessible and is read from the file again on the next access.
+     * Modified pages of a ReadWrite mapping are written back first. Has no effect for
+     * CopyOnWrite mappings because their modified pages exist in memory only.
+     */
+    void Discard(const void* address, unsigned long long length);
+
+  protected:
+
+    MemoryMappedFile();
+    virtual ~MemoryMappedFile();
+
+  private:
+
+    MemoryMappedFile(const MemoryMappedFile&);            // Not implemented on purpose.
+    MemoryMappedFile& operator=(const MemoryMappedFile&); // Not implemented on purpose.
+
+    void Map(const std::string& path, unsigned long long offset, unsigned long long size, AccessMode mode, bool create);
+    void Unmap();
+
+    std::string m_FileName;
+    AccessMode m_AccessMode;
+    bool m_RemoveOnUnmap;
+
+    void* m_Data;
+    unsigned long long m_Size;
+    unsigned long long m_Offset;
+
+    /** Page aligned start and length of the actual mapping. */
+    void* m_MappingBase;
+    unsigned long long m_MappingLength;
+
+#ifdef _WIN32
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#else
+    int m_FileDescriptor;
+#endif
+  };
+
+} // namespace mitk
+
+#endif // MITKMEMORYMAPPEDFILE_H
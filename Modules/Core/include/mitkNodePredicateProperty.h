@@ -50,6 +50,18 @@ namespace mitk {
       //## @brief Checks, if the nodes contains a property that is equal to m_ValidProperty
       virtual bool CheckNode(const mitk::DataNode* node) const override;
 
+      //##Documentation
+      //## @brief Returns the name of the checked property
+      const std::string& GetValidPropertyName() const { return m_ValidPropertyName; }
+
+      //##Documentation
+      //## @brief Returns the property value the node property is compared with, NULL if only the existence is checked
+      const mitk::BaseProperty* GetValidProperty() const { return m_ValidProperty; }
+
+      //##Documentation
+      //## @brief Returns the renderer of renderer-specific properties, NULL for non-renderer-specific properties
+      const mitk::BaseRenderer* GetRenderer() const { return m_Renderer; }
+
     protected:
       //##Documentation
       //## @brief Constructor to check for a named property
@@ -43,6 +43,13 @@ public:
 
   OperationType GetOperationType();
 
+  //##Documentation
+  //## @brief Approximate number of bytes occupied by this operation
+  //##
+  //## Used by the undo models to limit their memory consumption. Operations
+  //## that keep considerable amounts of data (e.g. image slices) override this.
+  virtual std::size_t GetMemorySize() const;
+
   protected:
   OperationType m_OperationType;
 };
@@ -79,6 +79,10 @@ class MITKCORE_EXPORT UndoStackItem
     virtual void ReverseOperations();
     virtual void ReverseAndExecute();
 
+    //##Documentation
+    //## @brief Approximate number of bytes occupied by the data of this item
+    virtual std::size_t GetMemorySize() const;
+
     //##Documentation
     //## @brief Increases the current ObjectEventId
     //## For example if a button click generates operations the ObjectEventId has to be incremented to be able to undo the operations.
@@ -160,6 +164,9 @@ public:
   //##reverses and executes both operations (used, when moved from undo to redo stack)
   virtual void ReverseAndExecute() override;
 
+  //## @brief Memory of the operation and the undo operation
+  virtual std::size_t GetMemorySize() const override;
+
   //## @brief returns true if the destination still is present
   //## and false if it already has been deleted
   virtual bool IsValid();
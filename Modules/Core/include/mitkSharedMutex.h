@@ -0,0 +1,120 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKSHAREDMUTEX_H
+#define MITKSHAREDMUTEX_H
+
+#include <MitkCoreExports.h>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace mitk {
+
+/**
+ * @brief Mutex supporting shared (read) and exclusive (write) ownership.
+ *
+ * Any number of threads may hold the mutex in shared mode at the same time,
+ * exclusive ownership is granted to a single thread only. Waiting writers
+ * take precedence over newly arriving readers, so a steady stream of readers
+ * cannot starve a writer. The mutex is not recursive: a thread must not
+ * request it again while holding it in either mode.
+ *
+ * Every acquisition that had to block is counted. The counter can be queried
+ * with GetContentionCount() to check whether concurrent users actually
+ * had to wait for each other.
+ *
+ * Lock()/Unlock() allow the use with itk::MutexLockHolder, shared ownership
+ * is best acquired through SharedMutexLockHolder.
+ *
+ * @ingroup Data
+ */
+class MITKCORE_EXPORT SharedMutex
+{
+public:
+
+  SharedMutex();
+  ~SharedMutex();
+
+  /** \brief Acquires exclusive ownership, blocks until no reader or writer holds the mutex. */
+  void Lock();
+
+  /** \brief Tries to acquire exclusive ownership without blocking. */
+  bool TryLock();
+
+  /** \brief Releases exclusive ownership. */
+  void Unlock();
+
+  /** \brief Acquires shared ownership, blocks while a writer holds or waits for the mutex. */
+  void LockShared();
+
+  /** \brief Tries to acquire shared ownership without blocking. */
+  bool TryLockShared();
+
+  /** \brief Releases shared ownership. */
+  void UnlockShared();
+
+  /** \brief Number of Lock()/LockShared() calls that had to wait for another owner. */
+  unsigned long GetContentionCount() const;
+
+  /** \brief Resets the contention counter to zero. */
+  void ResetContentionCount();
+
+private:
+
+  SharedMutex(const SharedMutex&);            // Not implemented on purpose.
+  SharedMutex& operator=(const SharedMutex&); // Not implemented on purpose.
+
+  mutable std::mutex m_Mutex;
+  std::condition_variable m_ReadersCondition;
+  std::condition_variable m_WritersCondition;
+
+  unsigned int m_ActiveReaders;
+  unsigned int m_WaitingWriters;
+  bool m_ActiveWriter;
+
+  unsigned long m_ContentionCount;
+};
+
+/**
+ * @brief Scoped shared ownership of a SharedMutex (counterpart to itk::MutexLockHolder).
+ */
+class SharedMutexLockHolder
+{
+public:
+
+  SharedMutexLockHolder(SharedMutex& mutex)
+    : m_Mutex(mutex)
+  {
+    m_Mutex.LockShared();
+  }
+
+  ~SharedMutexLockHolder()
+  {
+    m_Mutex.UnlockShared();
+  }
+
+private:
+
+  SharedMutexLockHolder(const SharedMutexLockHolder&);            // Not implemented on purpose.
+  SharedMutexLockHolder& operator=(const SharedMutexLockHolder&); // Not implemented on purpose.
+
+  SharedMutex& m_Mutex;
+};
+
+}
+
+#endif // MITKSHAREDMUTEX_H
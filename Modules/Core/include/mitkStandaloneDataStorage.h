@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkMessage.h"
 #include "itkVectorContainer.h"
 #include <map>
+#include <set>
+#include <vector>
 
 namespace mitk {
 
@@ -89,6 +91,31 @@ namespace mitk {
     //##
     SetOfObjects::ConstPointer GetAll() const override;
 
+    //##Documentation
+    //## @brief returns a set of data objects that meet the given condition(s)
+    //##
+    //## Conditions on the data type (NodePredicateDataType), on non-renderer-specific properties
+    //## with an indexed key (NodePredicateProperty) and conjunctions (NodePredicateAnd) containing
+    //## one of those are answered from secondary indices: only the candidate nodes of the index
+    //## are checked against the condition. All other conditions are checked for every node.
+    //## The indices follow changes of the nodes (data, property lists and values of indexed properties).
+    SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const override;
+
+    //##Documentation
+    //## @brief Adds a property key whose values are indexed for GetSubset() queries
+    //##
+    //## The "name" property is always indexed. Only add keys with cheap GetValueAsString()
+    //## implementations that are frequently used in queries.
+    void AddIndexedPropertyKey(const std::string& propertyKey);
+
+    //##Documentation
+    //## @brief Removes a property key from the indices ("name" cannot be removed)
+    void RemoveIndexedPropertyKey(const std::string& propertyKey);
+
+    //##Documentation
+    //## @brief Returns the property keys whose values are indexed
+    std::vector<std::string> GetIndexedPropertyKeys() const;
+
     /*ITK Mutex */
     mutable itk::SimpleFastMutexLock m_Mutex;
 
@@ -117,6 +144,18 @@ namespace mitk {
     //## @brief deletes all references to a node in a given relation (used in Remove() and TreeListener)
     void RemoveFromRelation(const mitk::DataNode* node, AdjacencyList& relation);
 
+    //##Documentation
+    //## @brief deletes all references to a set of nodes in a given relation (used in CommitBatchOperations())
+    void RemoveFromRelation(const std::set<const mitk::DataNode*>& nodes, AdjacencyList& relation);
+
+    //##Documentation
+    //## @brief stores a node and its relations (m_Mutex has to be locked)
+    void InsertNode(mitk::DataNode* node, const mitk::DataStorage::SetOfObjects* parents);
+
+    //##Documentation
+    //## @brief Inserts and removes the nodes of a committed batch with one lock of m_Mutex
+    virtual void CommitBatchOperations(const BatchOperations& operations) override;
+
     //##Documentation
     //## @brief Prints the contents of the StandaloneDataStorage to os. Do not call directly, call ->Print() instead
     virtual void PrintSelf(std::ostream& os, itk::Indent indent) const override;
@@ -127,6 +166,65 @@ namespace mitk {
     //##Documentation
     //## @brief Nodes are stored in reverse relation for easier traversal in the opposite direction of the relation
     AdjacencyList m_DerivedNodes;
+
+    //##Documentation
+    //## @brief Set of nodes of a secondary index, ordered like the result of GetAll()
+    typedef std::set<const mitk::DataNode*> IndexedNodes;
+
+    //##Documentation
+    //## @brief Values of a node as stored in the secondary indices, and the observers keeping them up to date
+    struct IndexEntry
+    {
+      std::string DataType;
+      std::map<std::string, std::string> PropertyValues;
+      std::vector<std::pair<mitk::BaseProperty::Pointer, unsigned long> > PropertyObserverTags;
+      unsigned long NodeObserverTag;
+    };
+
+    class IndexUpdateCommand;
+
+    //##Documentation
+    //## @brief Adds a node to the secondary indices (m_IndexMutex has to be locked)
+    void AddToIndex(const mitk::DataNode* node) const;
+
+    //##Documentation
+    //## @brief Removes a node from the secondary indices (m_IndexMutex has to be locked)
+    void RemoveFromIndex(const mitk::DataNode* node) const;
+
+    //##Documentation
+    //## @brief Re-reads the indexed values of a node (m_IndexMutex has to be locked)
+    void UpdateIndexEntry(const mitk::DataNode* node, IndexEntry& entry) const;
+
+    //##Documentation
+    //## @brief Removes the values of an index entry from the secondary indices (m_IndexMutex has to be locked)
+    void ClearIndexEntry(const mitk::DataNode* node, IndexEntry& entry) const;
+
+    //##Documentation
+    //## @brief Updates the index entries of all nodes that have been modified since the last query (m_IndexMutex has to be locked)
+    void UpdateModifiedIndexEntries() const;
+
+    //##Documentation
+    //## @brief Returns the indexed candidates for a condition, NULL if the condition cannot be answered from an index (m_IndexMutex has to be locked)
+    const IndexedNodes* GetIndexedCandidates(const NodePredicateBase* condition) const;
+
+    //##Documentation
+    //## @brief Marks the index entry of a node as outdated, called by the observers of nodes and indexed properties
+    void OnIndexedNodeModified(const mitk::DataNode* node) const;
+
+    //##Documentation
+    //## @brief Returns the key of a property value in the property index
+    static std::string GetIndexValue(const mitk::BaseProperty* property);
+
+    /* Mutex for the secondary indices, locked after m_Mutex if both are needed */
+    mutable itk::SimpleFastMutexLock m_IndexMutex;
+
+    std::set<std::string> m_IndexedPropertyKeys;
+    mutable std::map<const mitk::DataNode*, IndexEntry> m_IndexEntries;
+    mutable std::map<std::string, IndexedNodes> m_DataTypeIndex;
+    mutable std::map<std::string, std::map<std::string, IndexedNodes> > m_PropertyValueIndex;
+    mutable std::map<std::string, IndexedNodes> m_PropertyKeyIndex;
+    mutable IndexedNodes m_ModifiedNodes;
+    const IndexedNodes m_EmptyIndexedNodes;
   };
 } // namespace mitk
 #endif /* MITKSTANDALONEDATASTORAGE_H_HEADER_INCLUDED_ */
@@ -20,7 +20,194 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkImageChangeInformation.h>
 #include <mitkAbstractTransformGeometry.h>
 #include <vtkGeneralTransform.h>
+#include <vtkPointData.h>
 #include <mitkPlaneClipping.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+  template <typename TPixel>
+  inline TPixel ConvertToPixel(double value)
+  {
+    if (std::numeric_limits<TPixel>::is_integer)
+    {
+      // round and clamp like vtkImageReslice
+      value = std::floor(value + 0.5);
+      value = std::max(value, static_cast<double>(std::numeric_limits<TPixel>::min()));
+      value = std::min(value, static_cast<double>(std::numeric_limits<TPixel>::max()));
+    }
+    return static_cast<TPixel>(value);
+  }
+}
+
+/**
+* The axis aligned kernels are separable: every output column, every output row and the slice
+* position map to exactly one input axis each. Thus the input offsets (and the interpolation
+* weights) are computed once per column, row and slice instead of once per pixel, and the inner
+* loops only read these tables, which lets the compiler vectorize them.
+*/
+struct mitk::ExtractSliceFilter::AxisAlignedSliceTables
+{
+  /** Offsets (in scalars) and weights along one input axis */
+  struct AxisLookup
+  {
+    std::vector<vtkIdType> Offset0;
+    std::vector<vtkIdType> Offset1;
+    std::vector<double> Weight;
+    std::vector<char> Valid;
+
+    void Fill(double start, double step, int count, int size, vtkIdType stride, bool linear)
+    {
+      Offset0.resize(count);
+      Offset1.resize(count);
+      Weight.resize(count);
+      Valid.resize(count);
+
+      for (int n = 0; n < count; ++n)
+      {
+        const double coordinate = start + step * n;
+
+        // vtkImageReslice accepts points up to half a voxel outside of the image (border mode)
+        Valid[n] = coordinate >= -0.5 && coordinate <= size - 0.5;
+
+        if (linear)
+        {
+          const double floorCoordinate = std::floor(coordinate);
+          const int index = static_cast<int>(floorCoordinate);
+          Weight[n] = coordinate - floorCoordinate;
+          Offset0[n] = std::min(std::max(index, 0), size - 1) * stride;
+          Offset1[n] = std::min(std::max(index + 1, 0), size - 1) * stride;
+        }
+        else
+        {
+          const int index = static_cast<int>(std::floor(coordinate + 0.5));
+          Weight[n] = 0.0;
+          Offset0[n] = Offset1[n] = std::min(std::max(index, 0), size - 1) * stride;
+        }
+      }
+    }
+  };
+
+  AxisLookup Columns;
+  AxisLookup Rows;
+  AxisLookup Slice;
+
+  bool Linear;
+  bool ContiguousColumns;
+  int NumberOfComponents;
+  int Width;
+  int Height;
+  double Background;
+
+  int ScalarType;
+  const void* Input;
+  void* Output;
+
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    AxisAlignedSliceTables* tables = static_cast<AxisAlignedSliceTables*>(info->UserData);
+
+    // the rows of the slice are split evenly between the threads
+    const int rowsPerThread = (tables->Height + info->NumberOfThreads - 1) / info->NumberOfThreads;
+    const int firstRow = info->ThreadID * rowsPerThread;
+    const int lastRow = std::min(firstRow + rowsPerThread, tables->Height);
+
+    if (firstRow < lastRow)
+      tables->ExtractRows(firstRow, lastRow);
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  void ExtractRows(int firstRow, int lastRow) const
+  {
+    switch (ScalarType)
+    {
+      vtkTemplateMacro(this->ExtractRows(static_cast<const VTK_TT*>(Input), static_cast<VTK_TT*>(Output), firstRow, lastRow));
+    }
+  }
+
+  template <typename TPixel>
+  void ExtractRows(const TPixel* input, TPixel* output, int firstRow, int lastRow) const
+  {
+    const int components = NumberOfComponents;
+    const vtkIdType rowLength = static_cast<vtkIdType>(Width) * components;
+    const TPixel background = ConvertToPixel<TPixel>(Background);
+
+    for (int j = firstRow; j < lastRow; ++j)
+    {
+      TPixel* out = output + j * rowLength;
+
+      if (!Rows.Valid[j] || !Slice.Valid[0])
+      {
+        std::fill(out, out + rowLength, background);
+        continue;
+      }
+
+      if (!Linear)
+      {
+        const TPixel* in = input + Slice.Offset0[0] + Rows.Offset0[j];
+
+        if (ContiguousColumns)
+        {
+          std::copy(in + Columns.Offset0[0], in + Columns.Offset0[0] + rowLength, out);
+          continue;
+        }
+
+        for (int i = 0; i < Width; ++i, out += components)
+        {
+          const TPixel* pixel = in + Columns.Offset0[i];
+          for (int c = 0; c < components; ++c)
+          {
+            out[c] = Columns.Valid[i] ? pixel[c] : background;
+          }
+        }
+      }
+      else
+      {
+        const TPixel* in00 = input + Slice.Offset0[0] + Rows.Offset0[j];
+        const TPixel* in01 = input + Slice.Offset0[0] + Rows.Offset1[j];
+        const TPixel* in10 = input + Slice.Offset1[0] + Rows.Offset0[j];
+        const TPixel* in11 = input + Slice.Offset1[0] + Rows.Offset1[j];
+        const double rowWeight = Rows.Weight[j];
+        const double sliceWeight = Slice.Weight[0];
+
+        for (int i = 0; i < Width; ++i, out += components)
+        {
+          if (!Columns.Valid[i])
+          {
+            std::fill(out, out + components, background);
+            continue;
+          }
+
+          const vtkIdType offset0 = Columns.Offset0[i];
+          const vtkIdType offset1 = Columns.Offset1[i];
+          const double columnWeight = Columns.Weight[i];
+
+          for (int c = 0; c < components; ++c)
+          {
+            const double v00 = (1.0 - columnWeight) * in00[offset0 + c] + columnWeight * in00[offset1 + c];
+            const double v01 = (1.0 - columnWeight) * in01[offset0 + c] + columnWeight * in01[offset1 + c];
+            const double v10 = (1.0 - columnWeight) * in10[offset0 + c] + columnWeight * in10[offset1 + c];
+            const double v11 = (1.0 - columnWeight) * in11[offset0 + c] + columnWeight * in11[offset1 + c];
+            const double v0 = (1.0 - rowWeight) * v00 + rowWeight * v01;
+            const double v1 = (1.0 - rowWeight) * v10 + rowWeight * v11;
+            out[c] = ConvertToPixel<TPixel>((1.0 - sliceWeight) * v0 + sliceWeight * v1);
+          }
+        }
+      }
+    }
+  }
+};
 
 mitk::ExtractSliceFilter::ExtractSliceFilter(vtkImageReslice* reslicer ){
   if(reslicer == nullptr){
@@ -43,12 +230,27 @@ mitk::ExtractSliceFilter::ExtractSliceFilter(vtkImageReslice* reslicer ){
   m_ZMax = 0;
   m_VtkOutputRequested = false;
   m_BackgroundLevel = -32768.0;
+
+  // custom reslicers (e.g. mitkVtkImageOverwrite) have to be executed by vtk
+  m_UseAxisAlignedKernels = (reslicer == nullptr);
+  m_AxisAlignedSliceTables = new AxisAlignedSliceTables();
+  m_VtkOutputFromKernel = false;
 }
 
 mitk::ExtractSliceFilter::~ExtractSliceFilter(){
   m_ResliceTransform = nullptr;
   m_WorldGeometry = nullptr;
   delete [] m_OutPutSpacing;
+  delete m_AxisAlignedSliceTables;
+}
+
+vtkImageData* mitk::ExtractSliceFilter::GetVtkOutput(){
+  m_VtkOutputRequested = true;
+
+  if (m_VtkOutputFromKernel && m_OutputDimension == 2)
+    return m_KernelVtkOutput;
+
+  return m_Reslicer->GetOutput();
 }
 
 void mitk::ExtractSliceFilter::GenerateOutputInformation(){
@@ -78,6 +280,8 @@ mitk::ScalarType* mitk::ExtractSliceFilter::GetOutputSpacing(){
 }
 
 void mitk::ExtractSliceFilter::GenerateData(){
+  m_VtkOutputFromKernel = false;
+
   mitk::Image *input = const_cast< mitk::Image * >( this->GetInput() );
 
   if (!input)
@@ -337,13 +541,20 @@ void mitk::ExtractSliceFilter::GenerateData(){
 
   m_Reslicer->SetOutputSpacing( m_OutPutSpacing[0], m_OutPutSpacing[1], m_ZSpacing );
 
-  //TODO check the following lines, they are responsible wether vtk error outputs appear or not
-  m_Reslicer->UpdateWholeExtent(); //this produces a bad allocation error for 2D images
-  //m_Reslicer->GetOutput()->UpdateInformation();
-  //m_Reslicer->GetOutput()->SetUpdateExtentToWholeExtent();
+  //slices parallel to the image axes are extracted without the vtk pipeline
+  bool extractedByKernel = abstractGeometry == nullptr &&
+    this->ExtractAxisAlignedSlice(input, xMin, std::max(0, xMax-1), yMin, std::max(0, yMax-1));
+
+  if (!extractedByKernel)
+  {
+    //TODO check the following lines, they are responsible wether vtk error outputs appear or not
+    m_Reslicer->UpdateWholeExtent(); //this produces a bad allocation error for 2D images
+    //m_Reslicer->GetOutput()->UpdateInformation();
+    //m_Reslicer->GetOutput()->SetUpdateExtentToWholeExtent();
 
-  //start the pipeline
-  m_Reslicer->Update();
+    //start the pipeline
+    m_Reslicer->Update();
+  }
 
   /*================ #END setup vtkImageRslice properties================*/
 
@@ -355,31 +566,35 @@ void mitk::ExtractSliceFilter::GenerateData(){
   else
   {
     /*================ #BEGIN Get the slice from vtkImageReslice and convert it to mit::Image================*/
-    vtkImageData* reslicedImage;
-    reslicedImage = m_Reslicer->GetOutput();
+    mitk::Image::Pointer resultImage = this->GetOutput();
 
-    if(!reslicedImage)
+    //the axis aligned kernels have already written the voxel data into the result image
+    if (!extractedByKernel)
     {
-      itkWarningMacro(<<"Reslicer returned empty image");
-      return;
-    }
+      vtkImageData* reslicedImage;
+      reslicedImage = m_Reslicer->GetOutput();
 
-    mitk::Image::Pointer resultImage = this->GetOutput();
+      if(!reslicedImage)
+      {
+        itkWarningMacro(<<"Reslicer returned empty image");
+        return;
+      }
 
-    //initialize resultimage with the specs of the vtkImageData object returned from vtkImageReslice
-    if (reslicedImage->GetDataDimension() == 1)
-    {
-      // If original image was 2D, the slice might have an y extent of 0.
-      // Still i want to ensure here that Image is 2D
-      resultImage->Initialize(reslicedImage,1,-1,-1,1);
-    }
-    else
-    {
-      resultImage->Initialize(reslicedImage);
-    }
+      //initialize resultimage with the specs of the vtkImageData object returned from vtkImageReslice
+      if (reslicedImage->GetDataDimension() == 1)
+      {
+        // If original image was 2D, the slice might have an y extent of 0.
+        // Still i want to ensure here that Image is 2D
+        resultImage->Initialize(reslicedImage,1,-1,-1,1);
+      }
+      else
+      {
+        resultImage->Initialize(reslicedImage);
+      }
 
-    //transfer the voxel data
-    resultImage->SetVolume(reslicedImage->GetScalarPointer());
+      //transfer the voxel data
+      resultImage->SetVolume(reslicedImage->GetScalarPointer());
+    }
 
     //set the geometry from current worldgeometry for the reusultimage
     //this is needed that the image has the correct mitk geometry
@@ -435,6 +650,171 @@ void mitk::ExtractSliceFilter::GenerateData(){
   }
 }
 
+bool mitk::ExtractSliceFilter::ExtractAxisAlignedSlice(mitk::Image* input, int xMin, int xMax, int yMin, int yMax)
+{
+  if (!m_UseAxisAlignedKernels || m_OutputDimension != 2 ||
+      (m_InterpolationMode != RESLICE_NEAREST && m_InterpolationMode != RESLICE_LINEAR))
+  {
+    return false;
+  }
+
+  vtkImageData* inputVtkImage = input->GetVtkImageData(m_TimeStep);
+  if (inputVtkImage == nullptr || m_Reslicer->GetResliceAxes() == nullptr)
+    return false;
+
+  /*========== compose the matrix which maps output indices to input indices, as vtkImageReslice does ==========*/
+  vtkSmartPointer<vtkMatrix4x4> indexMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  indexMatrix->Identity();
+  indexMatrix->SetElement(0, 0, m_OutPutSpacing[0]);
+  indexMatrix->SetElement(1, 1, m_OutPutSpacing[1]);
+  indexMatrix->SetElement(2, 2, m_ZSpacing);
+  vtkMatrix4x4::Multiply4x4(m_Reslicer->GetResliceAxes(), indexMatrix, indexMatrix);
+
+  if (m_Reslicer->GetResliceTransform() != nullptr)
+  {
+    vtkLinearTransform* resliceTransform = vtkLinearTransform::SafeDownCast(m_Reslicer->GetResliceTransform());
+    if (resliceTransform == nullptr)
+      return false;
+    vtkMatrix4x4::Multiply4x4(resliceTransform->GetMatrix(), indexMatrix, indexMatrix);
+  }
+
+  double inputOrigin[3];
+  double inputSpacing[3];
+  inputVtkImage->GetOrigin(inputOrigin);
+  inputVtkImage->GetSpacing(inputSpacing);
+  if (m_ResliceTransform.IsNotNull())
+  {
+    // see unitSpacingImageFilter in GenerateData()
+    inputSpacing[0] = inputSpacing[1] = inputSpacing[2] = 1.0;
+  }
+
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      indexMatrix->SetElement(row, column, indexMatrix->GetElement(row, column) / inputSpacing[row]);
+    }
+    indexMatrix->SetElement(row, 3, indexMatrix->GetElement(row, 3) - inputOrigin[row] / inputSpacing[row]);
+  }
+
+  /*========== the output x and y axes have to map to two different input axes ==========*/
+  int inputAxes[2];
+  for (int column = 0; column < 2; ++column)
+  {
+    inputAxes[column] = 0;
+    for (int row = 1; row < 3; ++row)
+    {
+      if (std::abs(indexMatrix->GetElement(row, column)) > std::abs(indexMatrix->GetElement(inputAxes[column], column)))
+        inputAxes[column] = row;
+    }
+
+    const double tolerance = 1e-7 * std::abs(indexMatrix->GetElement(inputAxes[column], column));
+    for (int row = 0; row < 3; ++row)
+    {
+      if (row != inputAxes[column] && std::abs(indexMatrix->GetElement(row, column)) > tolerance)
+        return false;
+    }
+  }
+
+  if (inputAxes[0] == inputAxes[1])
+    return false;
+
+  const int columnAxis = inputAxes[0];
+  const int rowAxis = inputAxes[1];
+  const int sliceAxis = 3 - columnAxis - rowAxis;
+
+  /*========== fill the lookup tables ==========*/
+  int inputDimensions[3];
+  inputVtkImage->GetDimensions(inputDimensions);
+
+  const int numberOfComponents = inputVtkImage->GetNumberOfScalarComponents();
+  const vtkIdType strides[3] = {
+    numberOfComponents,
+    static_cast<vtkIdType>(numberOfComponents) * inputDimensions[0],
+    static_cast<vtkIdType>(numberOfComponents) * inputDimensions[0] * inputDimensions[1] };
+
+  AxisAlignedSliceTables& tables = *m_AxisAlignedSliceTables;
+  tables.Linear = m_InterpolationMode == RESLICE_LINEAR;
+  tables.NumberOfComponents = numberOfComponents;
+  tables.Width = xMax - xMin + 1;
+  tables.Height = yMax - yMin + 1;
+  tables.Background = m_BackgroundLevel;
+  tables.ScalarType = inputVtkImage->GetScalarType();
+
+  tables.Columns.Fill(indexMatrix->GetElement(columnAxis, 0) * xMin + indexMatrix->GetElement(columnAxis, 3),
+    indexMatrix->GetElement(columnAxis, 0), tables.Width, inputDimensions[columnAxis], strides[columnAxis], tables.Linear);
+  tables.Rows.Fill(indexMatrix->GetElement(rowAxis, 1) * yMin + indexMatrix->GetElement(rowAxis, 3),
+    indexMatrix->GetElement(rowAxis, 1), tables.Height, inputDimensions[rowAxis], strides[rowAxis], tables.Linear);
+  tables.Slice.Fill(indexMatrix->GetElement(sliceAxis, 3), 0.0, 1, inputDimensions[sliceAxis], strides[sliceAxis], tables.Linear);
+
+  // nearest neighbor rows which are a contiguous part of the input are copied at once
+  tables.ContiguousColumns = !tables.Linear;
+  for (int i = 0; i < tables.Width && tables.ContiguousColumns; ++i)
+  {
+    tables.ContiguousColumns = tables.Columns.Valid[i] &&
+      tables.Columns.Offset0[i] == tables.Columns.Offset0[0] + static_cast<vtkIdType>(i) * numberOfComponents;
+  }
+
+  /*========== reuse the output buffer if the size of the slice did not change ==========*/
+  mitk::ImageReadAccessor inputAccessor(input, input->GetVolumeData(m_TimeStep));
+  std::unique_ptr<mitk::ImageWriteAccessor> outputAccessor;
+
+  if (m_VtkOutputRequested)
+  {
+    if (m_KernelVtkOutput.GetPointer() == nullptr)
+      m_KernelVtkOutput = vtkSmartPointer<vtkImageData>::New();
+
+    const int* extent = m_KernelVtkOutput->GetExtent();
+    vtkDataArray* scalars = m_KernelVtkOutput->GetPointData()->GetScalars();
+    if (scalars == nullptr || scalars->GetDataType() != tables.ScalarType ||
+        scalars->GetNumberOfComponents() != numberOfComponents ||
+        extent[0] != xMin || extent[1] != xMax || extent[2] != yMin || extent[3] != yMax || extent[4] != 0 || extent[5] != 0)
+    {
+      m_KernelVtkOutput->SetExtent(xMin, xMax, yMin, yMax, 0, 0);
+      m_KernelVtkOutput->AllocateScalars(tables.ScalarType, numberOfComponents);
+    }
+    m_KernelVtkOutput->SetOrigin(0.0, 0.0, 0.0);
+    m_KernelVtkOutput->SetSpacing(m_OutPutSpacing[0], m_OutPutSpacing[1], m_ZSpacing);
+
+    tables.Output = m_KernelVtkOutput->GetScalarPointer();
+  }
+  else
+  {
+    mitk::Image::Pointer resultImage = this->GetOutput();
+    const unsigned int dimensions[2] = { static_cast<unsigned int>(tables.Width), static_cast<unsigned int>(tables.Height) };
+
+    if (!resultImage->IsInitialized() || resultImage->GetDimension() != 2 || resultImage->GetTimeSteps() != 1 ||
+        resultImage->GetDimension(0) != dimensions[0] || resultImage->GetDimension(1) != dimensions[1] ||
+        resultImage->GetPixelType() != input->GetPixelType())
+    {
+      resultImage->Initialize(input->GetPixelType(), 2, dimensions);
+    }
+
+    outputAccessor.reset(new mitk::ImageWriteAccessor(resultImage));
+    tables.Output = outputAccessor->GetData();
+  }
+  tables.Input = inputAccessor.GetData();
+
+  /*========== extract the slice, one block of rows per thread ==========*/
+  const vtkIdType pixelsPerThread = 64 * 1024;
+  const vtkIdType numberOfPixels = static_cast<vtkIdType>(tables.Width) * tables.Height;
+  itk::ThreadIdType numberOfThreads = static_cast<itk::ThreadIdType>(
+    std::min<vtkIdType>(std::min<vtkIdType>(this->GetNumberOfThreads(), tables.Height), numberOfPixels / pixelsPerThread + 1));
+
+  this->GetMultiThreader()->SetNumberOfThreads(std::max<itk::ThreadIdType>(1, numberOfThreads));
+  this->GetMultiThreader()->SetSingleMethod(AxisAlignedSliceTables::ThreaderCallback, m_AxisAlignedSliceTables);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  if (m_VtkOutputRequested)
+  {
+    m_KernelVtkOutput->GetPointData()->GetScalars()->Modified();
+    m_KernelVtkOutput->Modified();
+    m_VtkOutputFromKernel = true;
+  }
+
+  return true;
+}
+
 bool mitk::ExtractSliceFilter::GetClippedPlaneBounds(double bounds[6]){
   if(!m_WorldGeometry || !this->GetInput())
     return false;
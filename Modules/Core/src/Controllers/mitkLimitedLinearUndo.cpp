@@ -18,9 +18,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkLimitedLinearUndo.h"
 #include <mitkRenderingManager.h>
 
+std::size_t mitk::LimitedLinearUndo::s_DefaultMemoryLimit = 0;
+
 mitk::LimitedLinearUndo::LimitedLinearUndo()
+  : m_MemoryLimit(s_DefaultMemoryLimit)
 {
-  // nothing to do
 }
 
 mitk::LimitedLinearUndo::~LimitedLinearUndo()
@@ -56,9 +58,83 @@ bool mitk::LimitedLinearUndo::SetOperationEvent(UndoStackItem* stackItem)
 
   InvokeEvent( UndoNotEmptyEvent() );
 
+  this->EnforceMemoryLimit();
+
   return true;
 }
 
+void mitk::LimitedLinearUndo::SetMemoryLimit(std::size_t memoryLimit)
+{
+  if (m_MemoryLimit == memoryLimit) return;
+
+  m_MemoryLimit = memoryLimit;
+  this->EnforceMemoryLimit();
+  this->Modified();
+}
+
+std::size_t mitk::LimitedLinearUndo::GetMemoryLimit() const
+{
+  return m_MemoryLimit;
+}
+
+void mitk::LimitedLinearUndo::SetDefaultMemoryLimit(std::size_t memoryLimit)
+{
+  s_DefaultMemoryLimit = memoryLimit;
+}
+
+std::size_t mitk::LimitedLinearUndo::GetDefaultMemoryLimit()
+{
+  return s_DefaultMemoryLimit;
+}
+
+std::size_t mitk::LimitedLinearUndo::GetUndoMemorySize() const
+{
+  return GetMemorySize(m_UndoList);
+}
+
+std::size_t mitk::LimitedLinearUndo::GetRedoMemorySize() const
+{
+  return GetMemorySize(m_RedoList);
+}
+
+std::size_t mitk::LimitedLinearUndo::GetMemorySize(const UndoContainer& list)
+{
+  std::size_t memorySize = 0;
+  for ( auto iter = list.cbegin(); iter != list.cend(); ++iter )
+  {
+    memorySize += (*iter)->GetMemorySize();
+  }
+  return memorySize;
+}
+
+void mitk::LimitedLinearUndo::EnforceMemoryLimit()
+{
+  if (m_MemoryLimit == 0 || m_UndoList.empty()) return;
+
+  std::size_t memorySize = this->GetUndoMemorySize() + this->GetRedoMemorySize();
+  if (memorySize <= m_MemoryLimit) return;
+
+  // drop whole groups starting with the oldest one, but keep the latest group
+  const int latestGroupEventId = m_UndoList.back()->GetGroupEventId();
+  auto end = m_UndoList.begin();
+  while ( memorySize > m_MemoryLimit && end != m_UndoList.end() && (*end)->GetGroupEventId() != latestGroupEventId )
+  {
+    const int groupEventId = (*end)->GetGroupEventId();
+    while ( end != m_UndoList.end() && (*end)->GetGroupEventId() == groupEventId )
+    {
+      memorySize -= (*end)->GetMemorySize();
+      delete *end;
+      ++end;
+    }
+  }
+
+  if (end == m_UndoList.begin()) return;
+
+  MITK_DEBUG << "Dropped " << (end - m_UndoList.begin()) << " undo items, undo memory now " << memorySize << " bytes";
+  m_UndoList.erase(m_UndoList.begin(), end);
+  InvokeEvent( UndoFullEvent() );
+}
+
 bool mitk::LimitedLinearUndo::Undo(bool fine)
 {
   if (fine)
@@ -79,6 +79,11 @@ void mitk::UndoStackItem::ReverseAndExecute()
   ReverseOperations();
 }
 
+std::size_t mitk::UndoStackItem::GetMemorySize() const
+{
+  return sizeof(*this) + m_Description.capacity();
+}
+
 // ******************** mitk::OperationEvent ********************
 
 mitk::Operation* mitk::OperationEvent::GetOperation()
@@ -140,6 +145,16 @@ void mitk::OperationEvent::ReverseAndExecute()
     m_Destination->ExecuteOperation( m_Operation );
 }
 
+std::size_t mitk::OperationEvent::GetMemorySize() const
+{
+  std::size_t memorySize = UndoStackItem::GetMemorySize();
+  if (m_Operation)
+    memorySize += m_Operation->GetMemorySize();
+  if (m_UndoOperation)
+    memorySize += m_UndoOperation->GetMemorySize();
+  return memorySize;
+}
+
 mitk::OperationActor* mitk::OperationEvent::GetDestination()
 {
   return m_Destination;
@@ -24,9 +24,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImage.h"
 #include "itkMutexLockHolder.h"
 #include "itkCommand.h"
+#include <algorithm>
+#include <iterator>
 
 mitk::DataStorage::DataStorage() : itk::Object()
   , m_BlockNodeModifiedEvents(false)
+  , m_BatchDepth(0)
 {
 }
 
@@ -56,6 +59,145 @@ void mitk::DataStorage::Remove(const mitk::DataStorage::SetOfObjects* nodes)
     this->Remove(it.Value());
 }
 
+void mitk::DataStorage::BeginBatch()
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  ++m_BatchDepth;
+}
+
+void mitk::DataStorage::CommitBatch()
+{
+  BatchOperations operations;
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+    if (m_BatchDepth == 0)
+      throw std::logic_error("CommitBatch() called without BeginBatch()");
+    if (--m_BatchDepth > 0)
+      return;
+    operations.swap(m_BatchOperations);
+    for (BatchOperations::const_iterator it = operations.cbegin(); it != operations.cend(); ++it)
+      m_CommittingNodes.insert(it->Node.GetPointer());
+  }
+
+  try
+  {
+    this->CommitBatchOperations(operations);
+  }
+  catch (...)
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+    m_CommittingNodes.clear();
+    throw;
+  }
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  m_CommittingNodes.clear();
+}
+
+bool mitk::DataStorage::IsBatchActive() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  return m_BatchDepth > 0;
+}
+
+bool mitk::DataStorage::IsCommittingBatch() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  return !m_CommittingNodes.empty();
+}
+
+bool mitk::DataStorage::IsCommittingBatch(const mitk::DataNode* node) const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  return m_CommittingNodes.find(node) != m_CommittingNodes.end();
+}
+
+bool mitk::DataStorage::QueueBatchAdd(mitk::DataNode* node, const mitk::DataStorage::SetOfObjects* parents)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  if (m_BatchDepth == 0)
+    return false;
+
+  if (node == NULL)
+    throw std::invalid_argument("Node is NULL");
+  if ((parents != NULL) && (std::find(parents->begin(), parents->end(), node) != parents->end()))
+    throw std::invalid_argument("Node is it's own parent");
+
+  bool removalQueued = false;
+  for (BatchOperations::const_iterator it = m_BatchOperations.cbegin(); it != m_BatchOperations.cend(); ++it)
+  {
+    if (it->Node != node)
+      continue;
+    if (!it->Remove)
+      throw std::invalid_argument("Node is already in DataStorage");
+    removalQueued = true;
+  }
+  if (!removalQueued && this->Exists(node))
+    throw std::invalid_argument("Node is already in DataStorage");
+
+  BatchOperation operation;
+  operation.Node = node;
+  operation.Parents = parents;
+  operation.Remove = false;
+  m_BatchOperations.push_back(operation);
+  return true;
+}
+
+bool mitk::DataStorage::QueueBatchRemove(const mitk::DataNode* node)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_BatchMutex);
+  if (m_BatchDepth == 0)
+    return false;
+
+  // only the last queued operation tells whether the node is in the storage after the batch
+  for (BatchOperations::reverse_iterator it = m_BatchOperations.rbegin(); it != m_BatchOperations.rend(); ++it)
+  {
+    if (it->Node != node)
+      continue;
+    if (it->Remove)
+      return true;
+    m_BatchOperations.erase(std::next(it).base()); // added and removed within the batch
+    return true;
+  }
+
+  BatchOperation operation;
+  operation.Node = const_cast<mitk::DataNode*>(node);
+  operation.Remove = true;
+  m_BatchOperations.push_back(operation);
+  return true;
+}
+
+void mitk::DataStorage::CommitBatchOperations(const BatchOperations& operations)
+{
+  SetOfObjects::Pointer removedNodes = SetOfObjects::New();
+  SetOfObjects::Pointer addedNodes = SetOfObjects::New();
+  for (BatchOperations::const_iterator it = operations.cbegin(); it != operations.cend(); ++it)
+  {
+    if (it->Remove && this->Exists(it->Node))
+    {
+      this->Remove(it->Node);
+      removedNodes->InsertElement(removedNodes->Size(), it->Node);
+    }
+  }
+  for (BatchOperations::const_iterator it = operations.cbegin(); it != operations.cend(); ++it)
+  {
+    if (!it->Remove)
+    {
+      this->Add(it->Node, it->Parents);
+      addedNodes->InsertElement(addedNodes->Size(), it->Node);
+    }
+  }
+  this->EmitBatchEvents(removedNodes, addedNodes);
+}
+
+void mitk::DataStorage::EmitBatchEvents(const SetOfObjects* removedNodes, const SetOfObjects* addedNodes)
+{
+  if (removedNodes != NULL && removedNodes->Size() > 0)
+    RemoveNodesEvent.Send(removedNodes);
+  if (addedNodes != NULL && addedNodes->Size() > 0)
+    AddNodesEvent.Send(addedNodes);
+}
+
 mitk::DataStorage::SetOfObjects::ConstPointer mitk::DataStorage::GetSubset(const NodePredicateBase* condition) const
 {
   mitk::DataStorage::SetOfObjects::ConstPointer result = this->FilterSetOfObjects(this->GetAll(), condition);
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkCompareImageDataFilter.h"
 #include "mitkImageVtkReadAccessor.h"
 #include "mitkImageVtkWriteAccessor.h"
+#include "mitkImageTimeStepCache.h"
 
 //VTK
 #include <vtkImageData.h>
@@ -31,6 +32,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 //Other
 #include <cmath>
+#include <cstdlib>
 
 #define FILL_C_ARRAY( _arr, _size, _value) for(unsigned int i=0u; i<_size; i++) \
 { _arr[i] = _value; }
@@ -38,7 +40,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 mitk::Image::Image() :
   m_Dimension(0), m_Dimensions(nullptr), m_ImageDescriptor(nullptr), m_OffsetTable(nullptr), m_CompleteData(nullptr),
-  m_ImageStatistics(nullptr)
+  m_ImageStatistics(nullptr), m_AccessorContentionCount(0), m_TimeStepCache(nullptr)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -47,7 +49,8 @@ mitk::Image::Image() :
 }
 
 mitk::Image::Image(const Image &other) : SlicedData(other), m_Dimension(0), m_Dimensions(nullptr),
-  m_ImageDescriptor(nullptr), m_OffsetTable(nullptr), m_CompleteData(nullptr), m_ImageStatistics(nullptr)
+  m_ImageDescriptor(nullptr), m_OffsetTable(nullptr), m_CompleteData(nullptr), m_ImageStatistics(nullptr),
+  m_AccessorContentionCount(0), m_TimeStepCache(nullptr)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -80,6 +83,10 @@ mitk::Image::Image(const Image &other) : SlicedData(other), m_Dimension(0), m_Di
 
 mitk::Image::~Image()
 {
+  // stops the prefetch thread before any data is released
+  delete m_TimeStepCache;
+  m_TimeStepCache = nullptr;
+
   Clear();
   m_ReferenceCountLock.Lock();
   m_ReferenceCount = 3;
@@ -236,8 +243,30 @@ const vtkImageData* mitk::Image::GetVtkImageData(int t, int n) const
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData(int s, int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
-  return GetSliceData_unlocked(s, t, n, data, importMemoryManagement);
+  ImageDataItemPointer sl;
+  {
+    // fast path: slice already exists, concurrent lookups do not block each other
+    SharedMutexHolder sharedLock(m_ImageDataArraysLock);
+    if(IsValidSlice(s,t,n)==false) return nullptr;
+    sl = m_Slices[GetSliceIndex(s,t,n)];
+  }
+  if(sl.GetPointer()==nullptr)
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    sl = GetSliceData_unlocked(s, t, n, data, importMemoryManagement);
+  }
+  if(m_TimeStepCache != nullptr && sl.GetPointer() != nullptr)
+  {
+    // a slice keeps its volume in use, register the access of the volume
+    ImageDataItemPointer vol;
+    {
+      SharedMutexHolder sharedLock(m_ImageDataArraysLock);
+      vol = m_Volumes[GetVolumeIndex(t,n)];
+    }
+    if(vol.GetPointer() != nullptr)
+      UpdateTimeStepCache(vol, t, n);
+  }
+  return sl;
 }
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData_unlocked(int s, int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
@@ -272,6 +301,15 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData_unlocked(int s, int
     return m_Slices[pos]=sl;
   }
 
+  // is the volume of the slice kept compressed by the time step cache?
+  if(m_TimeStepCache != nullptr && m_TimeStepCache->HasCompressed(GetVolumeIndex(t,n)))
+  {
+    vol=GetVolumeData_unlocked(t,n,nullptr,CopyMemory);
+    sl=new ImageDataItem(*vol, m_ImageDescriptor, t, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*m_OffsetTable[2]*(ptypeSize));
+    sl->SetComplete(true);
+    return m_Slices[pos]=sl;
+  }
+
   // slice is unavailable. Can we calculate it?
   if((GetSource().IsNotNull()) && (GetSource()->Updating()==false))
   {
@@ -304,8 +342,25 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData_unlocked(int s, int
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData(int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
-  return GetVolumeData_unlocked(t, n, data, importMemoryManagement);
+  ImageDataItemPointer vol;
+  {
+    // fast path: volume already exists, concurrent lookups do not block each other
+    SharedMutexHolder sharedLock(m_ImageDataArraysLock);
+    if(IsValidVolume(t,n)==false) return nullptr;
+    vol = m_Volumes[GetVolumeIndex(t,n)];
+    if((vol.GetPointer()!=nullptr) && (vol->IsComplete()==false))
+      vol = nullptr;
+  }
+  if(vol.GetPointer()==nullptr)
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    vol = GetVolumeData_unlocked(t, n, data, importMemoryManagement);
+  }
+  if(m_TimeStepCache != nullptr && vol.GetPointer() != nullptr)
+  {
+    UpdateTimeStepCache(vol, t, n);
+  }
+  return vol;
 }
 mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
 {
@@ -330,6 +385,15 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(int t, int
     return m_Volumes[pos]=vol;
   }
 
+  // is the volume kept compressed by the time step cache?
+  if(m_TimeStepCache != nullptr && m_TimeStepCache->HasCompressed(pos))
+  {
+    vol=new ImageDataItem(this->m_ImageDescriptor->GetChannelTypeById(n), t, 3, m_Dimensions, nullptr, true);
+    m_TimeStepCache->RestoreCompressed(pos, vol->GetData(), vol->GetSize());
+    vol->SetComplete(true);
+    return m_Volumes[pos]=vol;
+  }
+
   // let's see if all slices of the volume are set, so that we can (could) combine them to a volume
   bool complete=true;
   unsigned int s;
@@ -424,6 +488,14 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(int t, int
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetChannelData(int n, void *data, ImportMemoryManagementType importMemoryManagement) const
 {
+  {
+    // fast path: channel already exists, concurrent lookups do not block each other
+    SharedMutexHolder sharedLock(m_ImageDataArraysLock);
+    if(IsValidChannel(n)==false) return nullptr;
+    ImageDataItemPointer ch = m_Channels[n];
+    if((ch.GetPointer()!=nullptr) && (ch->IsComplete()))
+      return ch;
+  }
   MutexHolder lock(m_ImageDataArraysLock);
   return GetChannelData_unlocked(n, data, importMemoryManagement);
 }
@@ -530,7 +602,7 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetChannelData_unlocked(int n, vo
 
 bool mitk::Image::IsSliceSet(int s, int t, int n) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
+  SharedMutexHolder lock(m_ImageDataArraysLock);
   return IsSliceSet_unlocked(s, t, n);
 }
 
@@ -554,12 +626,16 @@ bool mitk::Image::IsSliceSet_unlocked(int s, int t, int n) const
   {
     return true;
   }
+  if(m_TimeStepCache != nullptr && m_TimeStepCache->HasCompressed(GetVolumeIndex(t,n)))
+  {
+    return true;
+  }
   return false;
 }
 
 bool mitk::Image::IsVolumeSet(int t, int n) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
+  SharedMutexHolder lock(m_ImageDataArraysLock);
   return IsVolumeSet_unlocked(t, n);
 }
 
@@ -578,6 +654,10 @@ bool mitk::Image::IsVolumeSet_unlocked(int t, int n) const
   if((ch.GetPointer()!=nullptr) && (ch->IsComplete()))
     return true;
 
+  // is the volume kept compressed by the time step cache?
+  if(m_TimeStepCache != nullptr && m_TimeStepCache->HasCompressed(GetVolumeIndex(t,n)))
+    return true;
+
   // let's see if all slices of the volume are set, so that we can (could) combine them to a volume
   unsigned int s;
   for(s=0;s<m_Dimensions[2];++s)
@@ -592,7 +672,7 @@ bool mitk::Image::IsVolumeSet_unlocked(int t, int n) const
 
 bool mitk::Image::IsChannelSet(int n) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
+  SharedMutexHolder lock(m_ImageDataArraysLock);
   return IsChannelSet_unlocked(n);
 }
 
@@ -742,6 +822,54 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
   return true;
 }
 
+bool mitk::Image::SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n)
+{
+  if(IsValidChannel(n)==false || mappedFile == nullptr) return false;
+
+  const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  if(mappedFile->GetSize() < m_OffsetTable[4]*(ptypeSize))
+  {
+    MITK_ERROR << "Memory mapped file " << mappedFile->GetFileName() << " is smaller than channel " << n;
+    return false;
+  }
+
+  const bool wasSet = IsChannelSet(n);
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+
+    ImageDataItemPointer ch = new ImageDataItem(this->m_ImageDescriptor, -1, mappedFile);
+    ch->SetComplete(true);
+
+    // volumes and slices of this channel may still reference previous data
+    for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+    {
+      if(m_TimeStepCache != nullptr)
+      {
+        m_TimeStepCache->Forget(GetVolumeIndex(t,n));
+        m_TimeStepCache->DiscardCompressed(GetVolumeIndex(t,n));
+      }
+      m_Volumes[GetVolumeIndex(t,n)] = nullptr;
+      for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+      {
+        m_Slices[GetSliceIndex(s,t,n)] = nullptr;
+      }
+    }
+    m_Channels[n] = ch;
+    if(n == 0)
+    {
+      m_CompleteData = nullptr;
+    }
+  }
+
+  this->m_ImageDescriptor->GetChannelDescriptor(n).SetData( m_Channels[n]->GetData() );
+  if(wasSet)
+  {
+    //we have changed the data: call Modified()!
+    Modified();
+  }
+  return true;
+}
+
 void mitk::Image::Initialize()
 {
   ImageDataItemPointerArray::iterator it, end;
@@ -759,6 +887,11 @@ void mitk::Image::Initialize()
   }
   m_CompleteData = nullptr;
 
+  if( m_TimeStepCache != nullptr )
+  {
+    m_TimeStepCache->Clear();
+  }
+
   if( m_ImageStatistics == nullptr)
   {
     m_ImageStatistics = new mitk::ImageStatisticsHolder( this );
@@ -1093,6 +1226,11 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateSliceData_unlocked(int s,
   // is slice available as part of a volume that is available?
   ImageDataItemPointer sl, ch, vol;
   vol=m_Volumes[GetVolumeIndex(t,n)];
+  if(vol.GetPointer()==nullptr && m_TimeStepCache != nullptr && m_TimeStepCache->HasCompressed(GetVolumeIndex(t,n)))
+  {
+    // the other slices of the volume are kept compressed by the time step cache
+    vol=GetVolumeData_unlocked(t,n,nullptr,CopyMemory);
+  }
   if(vol.GetPointer()!=nullptr)
   {
     sl=new ImageDataItem(*vol, m_ImageDescriptor, t, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*m_OffsetTable[2]*(ptypeSize));
@@ -1135,6 +1273,12 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateVolumeData_unlocked(int t
 
   const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
 
+  // the volume is replaced, a compressed copy kept by the time step cache is outdated
+  if(m_TimeStepCache != nullptr)
+  {
+    m_TimeStepCache->DiscardCompressed(pos);
+  }
+
   // is volume available as part of a channel that is available?
   ImageDataItemPointer ch, vol;
   ch=m_Channels[n];
@@ -1192,6 +1336,288 @@ unsigned int* mitk::Image::GetDimensions() const
   return m_Dimensions;
 }
 
+unsigned long mitk::Image::GetAccessorContentionCount() const
+{
+  m_ReadWriteLock.Lock();
+  unsigned long count = m_AccessorContentionCount;
+  m_ReadWriteLock.Unlock();
+  return count;
+}
+
+unsigned long mitk::Image::GetDataArraysContentionCount() const
+{
+  return m_ImageDataArraysLock.GetContentionCount();
+}
+
+void mitk::Image::ResetContentionCounts()
+{
+  m_ReadWriteLock.Lock();
+  m_AccessorContentionCount = 0;
+  m_ReadWriteLock.Unlock();
+  m_ImageDataArraysLock.ResetContentionCount();
+}
+
+void mitk::Image::SetTimeStepCachePolicy(unsigned int maximumResidentVolumes, size_t maximumResidentBytes)
+{
+  if(m_Initialized==false)
+  {
+    mitkThrow() << "Cannot set a time step cache policy on an uninitialized image.";
+  }
+
+  if(maximumResidentVolumes == 0 && maximumResidentBytes == 0)
+  {
+    if(m_TimeStepCache == nullptr)
+      return;
+
+    // disable the policy and make everything resident again
+    m_TimeStepCache->SetMaximumResidentVolumes(0);
+    m_TimeStepCache->SetMaximumResidentBytes(0);
+    MutexHolder lock(m_ImageDataArraysLock);
+    for(unsigned int n=0; n<GetNumberOfChannels(); ++n)
+    {
+      for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+      {
+        GetVolumeData_unlocked(t, n, nullptr, CopyMemory);
+      }
+    }
+    m_TimeStepCache->Clear();
+    return;
+  }
+
+  if(m_TimeStepCache == nullptr)
+  {
+    m_TimeStepCache = new ImageTimeStepCache();
+    m_TimeStepCache->SetPrefetchFunction([this](int volumeIndex) { this->PrefetchVolume(volumeIndex); });
+  }
+  m_TimeStepCache->SetMaximumResidentVolumes(maximumResidentVolumes);
+  m_TimeStepCache->SetMaximumResidentBytes(maximumResidentBytes);
+
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    for(unsigned int n=0; n<GetNumberOfChannels(); ++n)
+    {
+      SplitChannelIntoVolumes_unlocked(n);
+      for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+      {
+        int pos = GetVolumeIndex(t,n);
+        ImageDataItemPointer vol = m_Volumes[pos];
+        if(vol.GetPointer() != nullptr && IsVolumeEvictable(vol))
+          m_TimeStepCache->Touch(pos, vol->GetSize());
+      }
+    }
+  }
+  EnforceTimeStepCacheLimits(-1);
+}
+
+const mitk::ImageTimeStepCache* mitk::Image::GetTimeStepCache() const
+{
+  return m_TimeStepCache;
+}
+
+bool mitk::Image::IsVolumeEvictable(const ImageDataItem* vol) const
+{
+  if(vol == nullptr || vol->IsComplete() == false)
+    return false;
+
+  // memory mapped pages can be dropped as long as they are not private copies
+  MemoryMappedFile* mappedFile = vol->GetMemoryMappedFile();
+  if(mappedFile != nullptr)
+    return mappedFile->GetAccessMode() != MemoryMappedFile::CopyOnWrite;
+
+  // volumes sharing the memory of a channel or of the caller cannot be released separately
+  return vol->GetParent().IsNull() && vol->GetManageMemory();
+}
+
+void mitk::Image::UpdateTimeStepCache(const ImageDataItem* vol, int t, int n) const
+{
+  if(m_TimeStepCache->IsEnabled() == false)
+    return;
+
+  int pos = GetVolumeIndex(t,n);
+  if(IsVolumeEvictable(vol))
+    m_TimeStepCache->Touch(pos, vol->GetSize());
+  else
+    m_TimeStepCache->Forget(pos);
+
+  // time steps requested one after another (e.g. cine playback): prepare the next one
+  int previous = m_TimeStepCache->ExchangeLastRequestedTimeStep(t);
+  if(previous >= 0 && std::abs(t - previous) == 1)
+  {
+    int next = t + (t - previous);
+    if(next >= 0 && next < static_cast<int>(m_Dimensions[3]) && m_TimeStepCache->HasCompressed(GetVolumeIndex(next,n)))
+      m_TimeStepCache->RequestPrefetch(GetVolumeIndex(next,n));
+  }
+
+  EnforceTimeStepCacheLimits(pos);
+}
+
+void mitk::Image::EnforceTimeStepCacheLimits(int keepVolumeIndex) const
+{
+  if(m_TimeStepCache == nullptr || m_TimeStepCache->IsOverLimit() == false)
+    return;
+
+  MutexHolder lock(m_ImageDataArraysLock);
+  std::vector<int> candidates = m_TimeStepCache->GetEvictionCandidates(keepVolumeIndex);
+  for(auto it = candidates.begin(); it != candidates.end() && m_TimeStepCache->IsOverLimit(); ++it)
+  {
+    EvictVolume_unlocked(*it);
+  }
+}
+
+bool mitk::Image::EvictVolume_unlocked(int volumeIndex) const
+{
+  if(volumeIndex < 0 || volumeIndex >= static_cast<int>(m_Volumes.size()))
+    return false;
+
+  ImageDataItemPointer vol = m_Volumes[volumeIndex];
+  if(IsVolumeEvictable(vol) == false)
+  {
+    m_TimeStepCache->Forget(volumeIndex);
+    return false;
+  }
+
+  MemoryMappedFile* mappedFile = vol->GetMemoryMappedFile();
+  if(mappedFile != nullptr)
+  {
+    // the data item stays valid, the pages are read from the file again on the next access
+    mappedFile->Discard(vol->GetData(), vol->GetSize());
+    m_TimeStepCache->Evicted(volumeIndex);
+    return true;
+  }
+
+  const int t = volumeIndex % m_Dimensions[3];
+  const int n = volumeIndex / m_Dimensions[3];
+
+  // volumes that are referenced outside of the image must not be released
+  int internalReferences = 2; // m_Volumes and vol
+  for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+  {
+    const ImageDataItem* sl = m_Slices[GetSliceIndex(s,t,n)];
+    if(sl != nullptr && sl->GetParent().GetPointer() == vol.GetPointer())
+    {
+      if(sl->GetReferenceCount() > 1 || (sl->m_VtkImageData != nullptr && sl->m_VtkImageData->GetReferenceCount() > 1))
+        return false;
+      ++internalReferences;
+    }
+  }
+  if(vol->GetReferenceCount() > internalReferences)
+    return false;
+  if(vol->m_VtkImageData != nullptr && vol->m_VtkImageData->GetReferenceCount() > 1)
+    return false;
+
+  const char* begin = static_cast<const char*>(vol->GetData());
+  const char* end = begin + vol->GetSize();
+  bool inUse = false;
+  m_ReadWriteLock.Lock();
+  for(auto accessors : { &m_Readers, &m_Writers })
+  {
+    for(ImageAccessorBase* accessor : *accessors)
+    {
+      if(static_cast<const char*>(accessor->m_AddressBegin) < end && static_cast<const char*>(accessor->m_AddressEnd) > begin)
+        inUse = true;
+    }
+  }
+  m_ReadWriteLock.Unlock();
+  if(inUse)
+    return false;
+
+  m_TimeStepCache->StoreCompressed(volumeIndex, vol->GetData(), vol->GetSize());
+  m_Volumes[volumeIndex] = nullptr;
+  for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+  {
+    m_Slices[GetSliceIndex(s,t,n)] = nullptr;
+  }
+  m_TimeStepCache->Evicted(volumeIndex);
+  return true;
+}
+
+void mitk::Image::PrefetchVolume(int volumeIndex) const
+{
+  ImageDataItemPointer vol;
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    if(volumeIndex < 0 || volumeIndex >= static_cast<int>(m_Volumes.size()))
+      return;
+    vol = GetVolumeData_unlocked(volumeIndex % m_Dimensions[3], volumeIndex / m_Dimensions[3], nullptr, CopyMemory);
+  }
+  if(vol.GetPointer() != nullptr && IsVolumeEvictable(vol))
+  {
+    m_TimeStepCache->Touch(volumeIndex, vol->GetSize());
+  }
+  vol = nullptr;
+  EnforceTimeStepCacheLimits(volumeIndex);
+}
+
+void mitk::Image::SplitChannelIntoVolumes_unlocked(int n)
+{
+  ImageDataItemPointer ch = m_Channels[n];
+  if(m_Dimensions[3] <= 1 || ch.GetPointer() == nullptr || ch->IsComplete() == false || ch->GetMemoryMappedFile() != nullptr)
+    return;
+
+  // the channel memory cannot be released while someone works on it
+  int internalReferences = 2; // m_Channels and ch
+  if(n == 0 && m_CompleteData.GetPointer() == ch.GetPointer())
+    ++internalReferences;
+  for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+  {
+    const ImageDataItem* vol = m_Volumes[GetVolumeIndex(t,n)];
+    if(vol != nullptr && vol->GetParent().GetPointer() == ch.GetPointer())
+      ++internalReferences;
+    for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+    {
+      const ImageDataItem* sl = m_Slices[GetSliceIndex(s,t,n)];
+      if(sl != nullptr && sl->GetParent().GetPointer() == ch.GetPointer())
+        ++internalReferences;
+    }
+  }
+  if(ch->GetReferenceCount() > internalReferences)
+    return;
+  m_ReadWriteLock.Lock();
+  bool inUse = !m_Readers.empty() || !m_Writers.empty();
+  m_ReadWriteLock.Unlock();
+  m_VtkReadersLock.Lock();
+  inUse = inUse || !m_VtkReaders.empty();
+  m_VtkReadersLock.Unlock();
+  if(inUse)
+    return;
+
+  const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  const size_t volumeSize = m_OffsetTable[3]*(ptypeSize);
+  const unsigned int maximumVolumes = m_TimeStepCache->GetMaximumResidentVolumes();
+  const size_t maximumBytes = m_TimeStepCache->GetMaximumResidentBytes();
+  size_t residentBytes = 0;
+  for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+  {
+    int pos = GetVolumeIndex(t,n);
+    const char* source = static_cast<const char*>(ch->GetData()) + ((size_t) t)*volumeSize;
+    bool keepResident = (maximumVolumes == 0 || t < maximumVolumes) && (maximumBytes == 0 || residentBytes + volumeSize <= maximumBytes);
+    if(keepResident)
+    {
+      ImageDataItemPointer vol = new ImageDataItem(this->m_ImageDescriptor->GetChannelTypeById(n), t, 3, m_Dimensions, nullptr, true);
+      std::memcpy(vol->GetData(), source, volumeSize);
+      vol->SetComplete(true);
+      m_Volumes[pos] = vol;
+      residentBytes += volumeSize;
+    }
+    else
+    {
+      m_TimeStepCache->StoreCompressed(pos, source, volumeSize);
+      m_Volumes[pos] = nullptr;
+    }
+    for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+    {
+      m_Slices[GetSliceIndex(s,t,n)] = nullptr;
+    }
+  }
+
+  m_Channels[n] = nullptr;
+  if(n == 0)
+  {
+    m_CompleteData = nullptr;
+  }
+  this->m_ImageDescriptor->GetChannelDescriptor(n).SetData(nullptr);
+}
+
 void mitk::Image::Clear()
 {
   Superclass::Clear();
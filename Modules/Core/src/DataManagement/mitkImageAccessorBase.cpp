@@ -91,10 +91,9 @@ mitk::ImageAccessorBase::ImageAccessorBase(ImageConstPointer image,
   {
     m_CoherentMemory = true;
 
-    // Organize first image channel
-    image->m_ReadWriteLock.Lock();
+    // Organize first image channel (GetChannelData is synchronized by the image itself,
+    // so concurrent accessors do not need to serialize on m_ReadWriteLock here)
     imageDataItem = image->GetChannelData();
-    image->m_ReadWriteLock.Unlock();
 
     // Set memory area
     m_AddressBegin = imageDataItem->m_Data;
@@ -167,6 +167,42 @@ mitk::ImageDataItem::ImageDataItem(const mitk::PixelType& type, int timestep,
   m_ReferenceCountLock.Unlock();
 }
 
+mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc, int timestep,
+                                   MemoryMappedFile* mappedFile)
+  : m_Data(nullptr)
+  , m_PixelType(new mitk::PixelType(desc->GetChannelDescriptor(0).GetPixelType()))
+  , m_ManageMemory(false)
+  , m_VtkImageData(nullptr)
+  , m_VtkImageReadAccessor(nullptr)
+  , m_VtkImageWriteAccessor(nullptr)
+  , m_Offset(0)
+  , m_IsComplete(false)
+  , m_Size(0)
+  , m_MappedFile(mappedFile)
+  , m_Parent(nullptr)
+  , m_Dimension(desc->GetNumberOfDimensions())
+  , m_Timestep(timestep)
+{
+  const unsigned int *dimensions = desc->GetDimensions();
+  for( unsigned int i=0; i<m_Dimension; i++)
+  {
+    m_Dimensions[i] = dimensions[i];
+  }
+
+  this->ComputeItemSize(m_Dimensions, m_Dimension );
+
+  if(mappedFile == nullptr || mappedFile->GetSize() < m_Size)
+  {
+    delete m_PixelType;
+    mitkThrow() << "ImageDataItem: the memory mapped file is smaller than the image data (" << m_Size << " bytes)";
+  }
+  m_Data = static_cast<unsigned char*>(mappedFile->GetData());
+
+  m_ReferenceCountLock.Lock();
+  m_ReferenceCount = 0;
+  m_ReferenceCountLock.Unlock();
+}
+
 mitk::ImageDataItem::ImageDataItem(const ImageDataItem &other)
   : itk::LightObject()
   , m_Data(other.m_Data)
@@ -178,6 +214,7 @@ mitk::ImageDataItem::ImageDataItem(const ImageDataItem &other)
   , m_Offset(other.m_Offset)
   , m_IsComplete(other.m_IsComplete)
   , m_Size(other.m_Size)
+  , m_MappedFile(other.m_MappedFile)
   , m_Parent(other.m_Parent)
   , m_Dimension(other.m_Dimension)
   , m_Timestep(other.m_Timestep)
@@ -315,6 +352,24 @@ void mitk::ImageDataItem::Modified() const
     m_VtkImageData->Modified();
 }
 
+mitk::MemoryMappedFile* mitk::ImageDataItem::GetMemoryMappedFile() const
+{
+  if(m_MappedFile.IsNotNull())
+    return m_MappedFile.GetPointer();
+  return m_Parent.IsNotNull() ? m_Parent->GetMemoryMappedFile() : nullptr;
+}
+
+bool mitk::ImageDataItem::IsMemoryMapped() const
+{
+  return GetMemoryMappedFile() != nullptr;
+}
+
+bool mitk::ImageDataItem::IsReadOnly() const
+{
+  MemoryMappedFile* mappedFile = GetMemoryMappedFile();
+  return mappedFile != nullptr && mappedFile->IsReadOnly();
+}
+
 mitk::ImageVtkReadAccessor* mitk::ImageDataItem::GetVtkImageAccessor(mitk::ImageDataItem::ImageConstPointer iP) const
 {
   if(m_VtkImageData==nullptr)
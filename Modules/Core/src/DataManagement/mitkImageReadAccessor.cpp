@@ -125,6 +125,8 @@ void mitk::ImageReadAccessor::OrganizeReadAccess()
         {
           PreventRecursiveMutexLock(w);
 
+          ++m_Image->m_AccessorContentionCount;
+
           // WAIT
           w->Increment();
           m_Image->m_ReadWriteLock.Unlock();
@@ -137,6 +139,7 @@ void mitk::ImageReadAccessor::OrganizeReadAccess()
         else
         {
           // THROW EXCEPTION
+          ++m_Image->m_AccessorContentionCount;
           m_Image->m_ReadWriteLock.Unlock();
           mitkThrowException(mitk::MemoryIsLockedException) << "The image part being ordered by the ImageAccessor is already in use and locked";
           return;
@@ -145,7 +148,8 @@ void mitk::ImageReadAccessor::OrganizeReadAccess()
     } // for
   } // if
 
-  // Now, we know, that there is no conflict with a Write-Access
+  // Now, we know, that there is no conflict with a Write-Access.
+  // Other ReadAccessors are never in conflict, even if their image part overlaps with this one.
   // Lock the Mutex in ImageAccessorBase, to make sure that every other ImageAccessor has to wait if it locks the mutex
   m_WaitLock->m_Mutex.Lock();
 
@@ -0,0 +1,314 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImageTimeStepCache.h"
+#include "mitkExceptionMacro.h"
+#include "mitkLogMacros.h"
+
+#include "itk_zlib.h"
+
+mitk::ImageTimeStepCache::ImageTimeStepCache()
+  : m_MaximumResidentVolumes(0)
+  , m_MaximumResidentBytes(0)
+  , m_ResidentBytes(0)
+  , m_CompressedBytes(0)
+  , m_NumberOfEvictions(0)
+  , m_NumberOfRestores(0)
+  , m_LastRequestedTimeStep(-1)
+  , m_PendingPrefetch(-1)
+  , m_StopPrefetch(false)
+{
+}
+
+mitk::ImageTimeStepCache::~ImageTimeStepCache()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_StopPrefetch = true;
+  }
+  m_PrefetchCondition.notify_all();
+
+  if (m_PrefetchThread.joinable())
+  {
+    m_PrefetchThread.join();
+  }
+}
+
+void mitk::ImageTimeStepCache::SetMaximumResidentVolumes(unsigned int maximum)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_MaximumResidentVolumes = maximum;
+}
+
+unsigned int mitk::ImageTimeStepCache::GetMaximumResidentVolumes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_MaximumResidentVolumes;
+}
+
+void mitk::ImageTimeStepCache::SetMaximumResidentBytes(size_t maximum)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_MaximumResidentBytes = maximum;
+}
+
+size_t mitk::ImageTimeStepCache::GetMaximumResidentBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_MaximumResidentBytes;
+}
+
+bool mitk::ImageTimeStepCache::IsEnabled() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_MaximumResidentVolumes > 0 || m_MaximumResidentBytes > 0;
+}
+
+void mitk::ImageTimeStepCache::Touch(int volumeIndex, size_t sizeInBytes)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  auto it = m_LRUIndex.find(volumeIndex);
+  if (it != m_LRUIndex.end())
+  {
+    m_ResidentBytes -= it->second->second;
+    m_LRUList.erase(it->second);
+  }
+
+  m_LRUList.push_front(std::make_pair(volumeIndex, sizeInBytes));
+  m_LRUIndex[volumeIndex] = m_LRUList.begin();
+  m_ResidentBytes += sizeInBytes;
+}
+
+void mitk::ImageTimeStepCache::Forget(int volumeIndex)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  auto it = m_LRUIndex.find(volumeIndex);
+  if (it != m_LRUIndex.end())
+  {
+    m_ResidentBytes -= it->second->second;
+    m_LRUList.erase(it->second);
+    m_LRUIndex.erase(it);
+  }
+}
+
+void mitk::ImageTimeStepCache::Evicted(int volumeIndex)
+{
+  this->Forget(volumeIndex);
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  ++m_NumberOfEvictions;
+}
+
+bool mitk::ImageTimeStepCache::IsOverLimit() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  if (m_MaximumResidentVolumes > 0 && m_LRUList.size() > m_MaximumResidentVolumes)
+    return true;
+
+  // a single volume is always allowed to be resident
+  return m_MaximumResidentBytes > 0 && m_ResidentBytes > m_MaximumResidentBytes && m_LRUList.size() > 1;
+}
+
+std::vector<int> mitk::ImageTimeStepCache::GetEvictionCandidates(int keep) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  std::vector<int> candidates;
+  for (auto it = m_LRUList.rbegin(); it != m_LRUList.rend(); ++it)
+  {
+    if (it->first != keep)
+    {
+      candidates.push_back(it->first);
+    }
+  }
+  return candidates;
+}
+
+void mitk::ImageTimeStepCache::StoreCompressed(int volumeIndex, const void* data, size_t sizeInBytes)
+{
+  // compress outside of the lock, only the bookkeeping is synchronized
+  ::uLongf compressedSize = ::compressBound(static_cast< ::uLong>(sizeInBytes));
+  std::vector<unsigned char> buffer(compressedSize);
+  int zlibRetVal = ::compress2(&buffer[0], &compressedSize, static_cast<const ::Bytef*>(data),
+                               static_cast< ::uLong>(sizeInBytes), Z_BEST_SPEED);
+  if (zlibRetVal != Z_OK)
+  {
+    mitkThrow() << "ImageTimeStepCache: compression of volume " << volumeIndex << " failed (zlib error " << zlibRetVal << ")";
+  }
+  buffer.resize(compressedSize);
+  buffer.shrink_to_fit();
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto it = m_CompressedVolumes.find(volumeIndex);
+  if (it != m_CompressedVolumes.end())
+  {
+    m_CompressedBytes -= it->second.size();
+  }
+  m_CompressedBytes += buffer.size();
+  m_CompressedVolumes[volumeIndex].swap(buffer);
+}
+
+bool mitk::ImageTimeStepCache::HasCompressed(int volumeIndex) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_CompressedVolumes.find(volumeIndex) != m_CompressedVolumes.end();
+}
+
+bool mitk::ImageTimeStepCache::RestoreCompressed(int volumeIndex, void* data, size_t sizeInBytes)
+{
+  std::vector<unsigned char> buffer;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_CompressedVolumes.find(volumeIndex);
+    if (it == m_CompressedVolumes.end())
+      return false;
+    buffer.swap(it->second);
+    m_CompressedBytes -= buffer.size();
+    m_CompressedVolumes.erase(it);
+    ++m_NumberOfRestores;
+  }
+
+  ::uLongf destLen = static_cast< ::uLongf>(sizeInBytes);
+  int zlibRetVal = ::uncompress(static_cast< ::Bytef*>(data), &destLen, &buffer[0], static_cast< ::uLong>(buffer.size()));
+  if (zlibRetVal != Z_OK || destLen != sizeInBytes)
+  {
+    MITK_ERROR << "ImageTimeStepCache: decompression of volume " << volumeIndex << " failed (zlib error " << zlibRetVal << ")";
+    return false;
+  }
+  return true;
+}
+
+void mitk::ImageTimeStepCache::DiscardCompressed(int volumeIndex)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto it = m_CompressedVolumes.find(volumeIndex);
+  if (it != m_CompressedVolumes.end())
+  {
+    m_CompressedBytes -= it->second.size();
+    m_CompressedVolumes.erase(it);
+  }
+}
+
+void mitk::ImageTimeStepCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_LRUList.clear();
+  m_LRUIndex.clear();
+  m_ResidentBytes = 0;
+  m_CompressedVolumes.clear();
+  m_CompressedBytes = 0;
+  m_LastRequestedTimeStep = -1;
+  m_PendingPrefetch = -1;
+}
+
+void mitk::ImageTimeStepCache::SetPrefetchFunction(const PrefetchFunction& function)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_PrefetchFunction = function;
+}
+
+void mitk::ImageTimeStepCache::RequestPrefetch(int volumeIndex)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_PrefetchFunction || m_StopPrefetch)
+      return;
+
+    m_PendingPrefetch = volumeIndex;
+
+    if (!m_PrefetchThread.joinable())
+    {
+      m_PrefetchThread = std::thread(&ImageTimeStepCache::PrefetchLoop, this);
+    }
+  }
+  m_PrefetchCondition.notify_one();
+}
+
+void mitk::ImageTimeStepCache::PrefetchLoop()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while (true)
+  {
+    while (!m_StopPrefetch && m_PendingPrefetch < 0)
+    {
+      m_PrefetchCondition.wait(lock);
+    }
+    if (m_StopPrefetch)
+      return;
+
+    int volumeIndex = m_PendingPrefetch;
+    m_PendingPrefetch = -1;
+    PrefetchFunction function = m_PrefetchFunction;
+
+    lock.unlock();
+    try
+    {
+      function(volumeIndex);
+    }
+    catch (const std::exception& e)
+    {
+      MITK_WARN << "ImageTimeStepCache: prefetching volume " << volumeIndex << " failed: " << e.what();
+    }
+    lock.lock();
+  }
+}
+
+int mitk::ImageTimeStepCache::ExchangeLastRequestedTimeStep(int timeStep)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  int previous = m_LastRequestedTimeStep;
+  m_LastRequestedTimeStep = timeStep;
+  return previous;
+}
+
+unsigned int mitk::ImageTimeStepCache::GetNumberOfResidentVolumes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return static_cast<unsigned int>(m_LRUList.size());
+}
+
+size_t mitk::ImageTimeStepCache::GetResidentBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_ResidentBytes;
+}
+
+unsigned int mitk::ImageTimeStepCache::GetNumberOfCompressedVolumes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return static_cast<unsigned int>(m_CompressedVolumes.size());
+}
+
+size_t mitk::ImageTimeStepCache::GetCompressedBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_CompressedBytes;
+}
+
+unsigned long mitk::ImageTimeStepCache::GetNumberOfEvictions() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_NumberOfEvictions;
+}
+
+unsigned long mitk::ImageTimeStepCache::GetNumberOfRestores() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_NumberOfRestores;
+}
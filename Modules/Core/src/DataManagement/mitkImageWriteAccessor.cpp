@@ -22,6 +22,13 @@ mitk::ImageWriteAccessor::ImageWriteAccessor(ImagePointer image, const mitk::Ima
   , m_Image(image)
 
 {
+  const ImageDataItem* item = iDI != nullptr ? iDI : image->GetChannelData().GetPointer();
+  if(item != nullptr && item->IsReadOnly())
+  {
+    delete m_WaitLock;
+    mitkThrow() << "ImageWriteAccessor: the requested image part is mapped read-only from a file";
+  }
+
   OrganizeWriteAccess();
 }
 
@@ -117,6 +124,8 @@ void mitk::ImageWriteAccessor::OrganizeWriteAccess()
   } // if
 
   if(readOverlap || writeOverlap) {
+    ++m_Image->m_AccessorContentionCount;
+
     // Throw an exception or wait for the WriteAccessor w until it is released and start again with the request afterwards.
     if(!(m_Options & ExceptionIfLocked))
     {
@@ -48,6 +48,10 @@ mitk::LevelWindowManager::~LevelWindowManager()
         MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageAddedNode ));
     m_DataStorage->RemoveNodeEvent.RemoveListener(
         MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageRemovedNode ));
+    m_DataStorage->AddNodesEvent.RemoveListener(
+        MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageAddedNodes ));
+    m_DataStorage->RemoveNodesEvent.RemoveListener(
+        MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageRemovedNodes ));
     m_DataStorage = NULL;
   }
 
@@ -73,6 +77,10 @@ void mitk::LevelWindowManager::SetDataStorage( mitk::DataStorage* ds )
         MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageAddedNode ));
     m_DataStorage->RemoveNodeEvent.RemoveListener(
         MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageRemovedNode ));
+    m_DataStorage->AddNodesEvent.RemoveListener(
+        MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageAddedNodes ));
+    m_DataStorage->RemoveNodesEvent.RemoveListener(
+        MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageRemovedNodes ));
   }
 
   /* register listener for new DataStorage */
@@ -81,6 +89,10 @@ void mitk::LevelWindowManager::SetDataStorage( mitk::DataStorage* ds )
       MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageAddedNode ));
   m_DataStorage->RemoveNodeEvent.AddListener(
       MessageDelegate1<LevelWindowManager, const mitk::DataNode*>( this, &LevelWindowManager::DataStorageRemovedNode ));
+  m_DataStorage->AddNodesEvent.AddListener(
+      MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageAddedNodes ));
+  m_DataStorage->RemoveNodesEvent.AddListener(
+      MessageDelegate1<LevelWindowManager, const DataStorage::SetOfObjects*>( this, &LevelWindowManager::DataStorageRemovedNodes ));
 
   this->DataStorageAddedNode(); // update us with new DataStorage
 }
@@ -235,8 +247,11 @@ void mitk::LevelWindowManager::SetLevelWindow(const mitk::LevelWindow& levelWind
   this->Modified();
 }
 
-void mitk::LevelWindowManager::DataStorageAddedNode( const mitk::DataNode* )
+void mitk::LevelWindowManager::DataStorageAddedNode( const mitk::DataNode* n )
 {
+  // nodes of a batch are handled once by DataStorageAddedNodes()
+  if (n != NULL && m_DataStorage.IsNotNull() && m_DataStorage->IsCommittingBatch(n))
+    return;
 
   //update observers with new data storage
   UpdateObservers();
@@ -252,6 +267,10 @@ void mitk::LevelWindowManager::DataStorageAddedNode( const mitk::DataNode* )
 
 void mitk::LevelWindowManager::DataStorageRemovedNode( const mitk::DataNode* removedNode )
 {
+  // nodes of a batch are handled once by DataStorageRemovedNodes()
+  if (removedNode != NULL && m_DataStorage.IsNotNull() && m_DataStorage->IsCommittingBatch(removedNode))
+    return;
+
   //first: check if deleted node is part of relevant nodes. If not, abort method because there is no need change anything.
   if ((this->GetRelevantNodes()->size() == 0)) return;
   bool removedNodeIsRelevant = false;
@@ -295,6 +314,30 @@ void mitk::LevelWindowManager::DataStorageRemovedNode( const mitk::DataNode* rem
      {mitkThrow() << "Wrong number of observers in Level Window Manager!";}
 }
 
+void mitk::LevelWindowManager::DataStorageAddedNodes( const DataStorage::SetOfObjects* )
+{
+  this->DataStorageAddedNode();
+}
+
+void mitk::LevelWindowManager::DataStorageRemovedNodes( const DataStorage::SetOfObjects* )
+{
+  // the nodes are already removed, observe the remaining ones
+  UpdateObservers();
+
+  if (m_LevelWindowProperty.IsNull() || m_AutoTopMost)
+  {
+    SetAutoTopMostImage(true);
+  }
+  else
+  {
+    mitk::NodePredicateProperty::Pointer p2 = mitk::NodePredicateProperty::New("levelwindow", m_LevelWindowProperty);
+    if (m_DataStorage->GetNode(p2) == NULL) // the node of the level window was removed
+    {
+      SetAutoTopMostImage(true);
+    }
+  }
+}
+
 void mitk::LevelWindowManager::UpdateObservers()
 {
   this->ClearPropObserverLists(); //remove old observers
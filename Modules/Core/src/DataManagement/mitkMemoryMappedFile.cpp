@@ -0,0 +1,306 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkMemoryMappedFile.h"
+#include "mitkExceptionMacro.h"
+#include "mitkIOUtil.h"
+
+#include <itksys/SystemTools.hxx>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mitk::MemoryMappedFile::Pointer mitk::MemoryMappedFile::Open(const std::string& path, unsigned long long offset,
+                                                             unsigned long long size, AccessMode mode)
+{
+  Pointer file = new MemoryMappedFile();
+  file->UnRegister();
+  file->Map(path, offset, size, mode, false);
+  return file;
+}
+
+mitk::MemoryMappedFile::Pointer mitk::MemoryMappedFile::CreateScratchFile(unsigned long long size,
+                                                                          const std::string& directory)
+{
+  const std::string path = IOUtil::CreateTemporaryFile("mitk-scratch-XXXXXX.raw", directory);
+
+  Pointer file = new MemoryMappedFile();
+  file->UnRegister();
+  file->m_RemoveOnUnmap = true;
+  try
+  {
+    file->Map(path, 0, size, ReadWrite, true);
+  }
+  catch (...)
+  {
+    itksys::SystemTools::RemoveFile(path.c_str());
+    throw;
+  }
+  return file;
+}
+
+mitk::MemoryMappedFile::MemoryMappedFile()
+  : m_AccessMode(ReadOnly)
+  , m_RemoveOnUnmap(false)
+  , m_Data(nullptr)
+  , m_Size(0)
+  , m_Offset(0)
+  , m_MappingBase(nullptr)
+  , m_MappingLength(0)
+#ifdef _WIN32
+  , m_FileHandle(INVALID_HANDLE_VALUE)
+  , m_MappingHandle(nullptr)
+#else
+  , m_FileDescriptor(-1)
+#endif
+{
+}
+
+mitk::MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Unmap();
+}
+
+#ifdef _WIN32
+
+void mitk::MemoryMappedFile::Map(const std::string& path, unsigned long long offset, unsigned long long size,
+                                 AccessMode mode, bool create)
+{
+  m_FileName = path;
+  m_AccessMode = mode;
+  m_Offset = offset;
+  m_Size = size;
+
+  const DWORD desiredAccess = mode == ReadWrite ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+  m_FileHandle = ::CreateFileA(path.c_str(), desiredAccess, FILE_SHARE_READ, nullptr,
+                               create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_FileHandle == INVALID_HANDLE_VALUE)
+  {
+    mitkThrow() << "MemoryMappedFile: cannot open " << path;
+  }
+
+  LARGE_INTEGER fileSize;
+  ::GetFileSizeEx(m_FileHandle, &fileSize);
+  if (!create && static_cast<unsigned long long>(fileSize.QuadPart) < offset + size)
+  {
+    this->Unmap();
+    mitkThrow() << "MemoryMappedFile: " << path << " is smaller than the requested region";
+  }
+
+  SYSTEM_INFO systemInfo;
+  ::GetSystemInfo(&systemInfo);
+  const unsigned long long granularity = systemInfo.dwAllocationGranularity;
+  const unsigned long long alignedOffset = (offset / granularity) * granularity;
+  m_MappingLength = size + (offset - alignedOffset);
+
+  const unsigned long long mappingSize = create ? offset + size : 0;
+  const DWORD protection = mode == ReadOnly ? PAGE_READONLY : (mode == CopyOnWrite ? PAGE_WRITECOPY : PAGE_READWRITE);
+  m_MappingHandle = ::CreateFileMappingA(m_FileHandle, nullptr, protection,
+                                         static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize & 0xFFFFFFFF),
+                                         nullptr);
+  if (m_MappingHandle == nullptr)
+  {
+    this->Unmap();
+    mitkThrow() << "MemoryMappedFile: cannot create a file mapping for " << path;
+  }
+
+  const DWORD viewAccess = mode == ReadOnly ? FILE_MAP_READ : (mode == CopyOnWrite ? FILE_MAP_COPY : FILE_MAP_WRITE);
+  m_MappingBase = ::MapViewOfFile(m_MappingHandle, viewAccess,
+                                  static_cast<DWORD>(alignedOffset >> 32), static_cast<DWORD>(alignedOffset & 0xFFFFFFFF),
+                                  static_cast<SIZE_T>(m_MappingLength));
+  if (m_MappingBase == nullptr)
+  {
+    this->Unmap();
+    mitkThrow() << "MemoryMappedFile: cannot map " << size << " bytes of " << path;
+  }
+
+  m_Data = static_cast<char*>(m_MappingBase) + (offset - alignedOffset);
+}
+
+void mitk::MemoryMappedFile::Unmap()
+{
+  if (m_MappingBase != nullptr)
+  {
+    ::UnmapViewOfFile(m_MappingBase);
+    m_MappingBase = nullptr;
+  }
+  if (m_MappingHandle != nullptr)
+  {
+    ::CloseHandle(m_MappingHandle);
+    m_MappingHandle = nullptr;
+  }
+  if (m_FileHandle != INVALID_HANDLE_VALUE)
+  {
+    ::CloseHandle(m_FileHandle);
+    m_FileHandle = INVALID_HANDLE_VALUE;
+  }
+  m_Data = nullptr;
+
+  if (m_RemoveOnUnmap && !m_FileName.empty())
+  {
+    itksys::SystemTools::RemoveFile(m_FileName.c_str());
+    m_RemoveOnUnmap = false;
+  }
+}
+
+void mitk::MemoryMappedFile::Flush()
+{
+  if (m_MappingBase != nullptr && m_AccessMode == ReadWrite)
+  {
+    ::FlushViewOfFile(m_MappingBase, static_cast<SIZE_T>(m_MappingLength));
+  }
+}
+
+void mitk::MemoryMappedFile::Discard(const void* address, unsigned long long length)
+{
+  if (m_MappingBase == nullptr || m_AccessMode == CopyOnWrite || length == 0)
+  {
+    return;
+  }
+  if (m_AccessMode == ReadWrite)
+  {
+    ::FlushViewOfFile(address, static_cast<SIZE_T>(length));
+  }
+  // unlocking pages which are not locked removes them from the working set
+  ::VirtualUnlock(const_cast<void*>(address), static_cast<SIZE_T>(length));
+}
+
+#else
+
+void mitk::MemoryMappedFile::Map(const std::string& path, unsigned long long offset, unsigned long long size,
+                                 AccessMode mode, bool create)
+{
+  m_FileName = path;
+  m_AccessMode = mode;
+  m_Offset = offset;
+  m_Size = size;
+
+  int flags = mode == ReadWrite ? O_RDWR : O_RDONLY;
+  if (create)
+  {
+    flags |= O_CREAT;
+  }
+  m_FileDescriptor = ::open(path.c_str(), flags, S_IRUSR | S_IWUSR);
+  if (m_FileDescriptor < 0)
+  {
+    mitkThrow() << "MemoryMappedFile: cannot open " << path;
+  }
+
+  if (create)
+  {
+    if (::ftruncate(m_FileDescriptor, static_cast<off_t>(offset + size)) != 0)
+    {
+      this->Unmap();
+      mitkThrow() << "MemoryMappedFile: cannot resize " << path << " to " << offset + size << " bytes";
+    }
+  }
+  else
+  {
+    struct stat fileStatus;
+    if (::fstat(m_FileDescriptor, &fileStatus) != 0 ||
+        static_cast<unsigned long long>(fileStatus.st_size) < offset + size)
+    {
+      this->Unmap();
+      mitkThrow() << "MemoryMappedFile: " << path << " is smaller than the requested region";
+    }
+  }
+
+  const unsigned long long pageSize = static_cast<unsigned long long>(::sysconf(_SC_PAGESIZE));
+  const unsigned long long alignedOffset = (offset / pageSize) * pageSize;
+  m_MappingLength = size + (offset - alignedOffset);
+
+  const int protection = mode == ReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
+  const int sharing = mode == CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+  void* base = ::mmap(nullptr, static_cast<size_t>(m_MappingLength), protection, sharing, m_FileDescriptor,
+                      static_cast<off_t>(alignedOffset));
+  if (base == MAP_FAILED)
+  {
+    this->Unmap();
+    mitkThrow() << "MemoryMappedFile: cannot map " << size << " bytes of " << path;
+  }
+  m_MappingBase = base;
+  m_Data = static_cast<char*>(m_MappingBase) + (offset - alignedOffset);
+
+  // the mapping keeps the data accessible, a scratch file can be removed right away
+  if (m_RemoveOnUnmap)
+  {
+    itksys::SystemTools::RemoveFile(path.c_str());
+    m_RemoveOnUnmap = false;
+  }
+}
+
+void mitk::MemoryMappedFile::Unmap()
+{
+  if (m_MappingBase != nullptr)
+  {
+    ::munmap(m_MappingBase, static_cast<size_t>(m_MappingLength));
+    m_MappingBase = nullptr;
+  }
+  if (m_FileDescriptor >= 0)
+  {
+    ::close(m_FileDescriptor);
+    m_FileDescriptor = -1;
+  }
+  m_Data = nullptr;
+
+  if (m_RemoveOnUnmap && !m_FileName.empty())
+  {
+    itksys::SystemTools::RemoveFile(m_FileName.c_str());
+    m_RemoveOnUnmap = false;
+  }
+}
+
+void mitk::MemoryMappedFile::Flush()
+{
+  if (m_MappingBase != nullptr && m_AccessMode == ReadWrite)
+  {
+    ::msync(m_MappingBase, static_cast<size_t>(m_MappingLength), MS_SYNC);
+  }
+}
+
+void mitk::MemoryMappedFile::Discard(const void* address, unsigned long long length)
+{
+  if (m_MappingBase == nullptr || m_AccessMode == CopyOnWrite || length == 0)
+  {
+    return;
+  }
+
+  // only whole pages inside the range can be released
+  const unsigned long long pageSize = static_cast<unsigned long long>(::sysconf(_SC_PAGESIZE));
+  const unsigned long long begin = reinterpret_cast<unsigned long long>(address);
+  const unsigned long long alignedBegin = ((begin + pageSize - 1) / pageSize) * pageSize;
+  const unsigned long long alignedEnd = ((begin + length) / pageSize) * pageSize;
+  if (alignedEnd <= alignedBegin)
+  {
+    return;
+  }
+
+  void* alignedAddress = reinterpret_cast<void*>(alignedBegin);
+  const size_t alignedLength = static_cast<size_t>(alignedEnd - alignedBegin);
+  if (m_AccessMode == ReadWrite)
+  {
+    ::msync(alignedAddress, alignedLength, MS_SYNC);
+  }
+  ::madvise(alignedAddress, alignedLength, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSharedMutex.h"
+
+mitk::SharedMutex::SharedMutex()
+  : m_ActiveReaders(0)
+  , m_WaitingWriters(0)
+  , m_ActiveWriter(false)
+  , m_ContentionCount(0)
+{
+}
+
+mitk::SharedMutex::~SharedMutex()
+{
+}
+
+void mitk::SharedMutex::Lock()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+
+  if (m_ActiveWriter || m_ActiveReaders > 0)
+  {
+    ++m_ContentionCount;
+    ++m_WaitingWriters;
+    while (m_ActiveWriter || m_ActiveReaders > 0)
+    {
+      m_WritersCondition.wait(lock);
+    }
+    --m_WaitingWriters;
+  }
+
+  m_ActiveWriter = true;
+}
+
+bool mitk::SharedMutex::TryLock()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  if (m_ActiveWriter || m_ActiveReaders > 0)
+    return false;
+
+  m_ActiveWriter = true;
+  return true;
+}
+
+void mitk::SharedMutex::Unlock()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  m_ActiveWriter = false;
+
+  // Prefer writers, otherwise release all readers at once
+  if (m_WaitingWriters > 0)
+  {
+    m_WritersCondition.notify_one();
+  }
+  else
+  {
+    m_ReadersCondition.notify_all();
+  }
+}
+
+void mitk::SharedMutex::LockShared()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+
+  if (m_ActiveWriter || m_WaitingWriters > 0)
+  {
+    ++m_ContentionCount;
+    while (m_ActiveWriter || m_WaitingWriters > 0)
+    {
+      m_ReadersCondition.wait(lock);
+    }
+  }
+
+  ++m_ActiveReaders;
+}
+
+bool mitk::SharedMutex::TryLockShared()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  if (m_ActiveWriter || m_WaitingWriters > 0)
+    return false;
+
+  ++m_ActiveReaders;
+  return true;
+}
+
+void mitk::SharedMutex::UnlockShared()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  --m_ActiveReaders;
+
+  if (m_ActiveReaders == 0 && m_WaitingWriters > 0)
+  {
+    m_WritersCondition.notify_one();
+  }
+}
+
+unsigned long mitk::SharedMutex::GetContentionCount() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_ContentionCount;
+}
+
+void mitk::SharedMutex::ResetContentionCount()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_ContentionCount = 0;
+}
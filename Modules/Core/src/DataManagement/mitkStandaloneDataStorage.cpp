@@ -20,14 +20,53 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkProperties.h"
 #include "mitkNodePredicateBase.h"
 #include "mitkNodePredicateProperty.h"
+#include "mitkNodePredicateDataType.h"
+#include "mitkNodePredicateAnd.h"
 #include "mitkGroupTagProperty.h"
 #include "itkSimpleFastMutexLock.h"
 #include "itkMutexLockHolder.h"
+#include "itkCommand.h"
+#include <algorithm>
+
+
+//##Documentation
+//## @brief Observer of nodes and indexed properties, marks the index entry of its node as outdated
+class mitk::StandaloneDataStorage::IndexUpdateCommand : public itk::Command
+{
+public:
+  typedef IndexUpdateCommand Self;
+  typedef itk::Command Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+
+  void SetNode(const StandaloneDataStorage* dataStorage, const DataNode* node)
+  {
+    m_DataStorage = dataStorage;
+    m_Node = node;
+  }
+
+  virtual void Execute(itk::Object* caller, const itk::EventObject& event) override
+  {
+    this->Execute(const_cast<const itk::Object*>(caller), event);
+  }
+
+  virtual void Execute(const itk::Object*, const itk::EventObject&) override
+  {
+    m_DataStorage->OnIndexedNodeModified(m_Node);
+  }
+
+protected:
+  IndexUpdateCommand() : m_DataStorage(nullptr), m_Node(nullptr) {}
+
+  const StandaloneDataStorage* m_DataStorage;
+  const DataNode* m_Node;
+};
 
 
 mitk::StandaloneDataStorage::StandaloneDataStorage()
 : mitk::DataStorage()
 {
+  m_IndexedPropertyKeys.insert("name");
 }
 
 
@@ -37,6 +76,7 @@ mitk::StandaloneDataStorage::~StandaloneDataStorage()
     it != m_SourceNodes.end(); it++)
   {
     this->RemoveListeners(it->first);
+    this->RemoveFromIndex(it->first);
   }
 }
 
@@ -51,6 +91,10 @@ bool mitk::StandaloneDataStorage::IsInitialized() const
 
 void mitk::StandaloneDataStorage::Add(mitk::DataNode* node, const mitk::DataStorage::SetOfObjects* parents)
 {
+  /* during a batch the node is added by CommitBatch() */
+  if (this->QueueBatchAdd(node, parents))
+    return;
+
   {
     itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
     if (!IsInitialized())
@@ -62,38 +106,47 @@ void mitk::StandaloneDataStorage::Add(mitk::DataNode* node, const mitk::DataStor
     if (m_SourceNodes.find(node) != m_SourceNodes.end())
       throw std::invalid_argument("Node is already in DataStorage");
 
-    /* create parent list if it does not exist */
-    mitk::DataStorage::SetOfObjects::ConstPointer sp;
-    if (parents != NULL)
-      sp = parents;
-    else
-      sp = mitk::DataStorage::SetOfObjects::New();
-    /* Store node and parent list in sources adjacency list */
-    m_SourceNodes.insert(std::make_pair(node, sp));
+    this->InsertNode(node, parents);
+  }
 
-    /* Store node and an empty children list in derivations adjacency list */
-    mitk::DataStorage::SetOfObjects::Pointer childrenPointer = mitk::DataStorage::SetOfObjects::New();
-    mitk::DataStorage::SetOfObjects::ConstPointer children =  childrenPointer.GetPointer();
-    m_DerivedNodes.insert(std::make_pair(node, children));
+  /* Notify observers */
+  EmitAddNodeEvent(node);
 
-    /* create entry in derivations adjacency list for each parent of the new node */
-    for (SetOfObjects::ConstIterator it = sp->Begin(); it != sp->End(); it++)
-    {
-      mitk::DataNode::ConstPointer parent = it.Value().GetPointer();
-      mitk::DataStorage::SetOfObjects::ConstPointer derivedObjects = m_DerivedNodes[parent]; // get or create pointer to list of derived objects for that parent node
-      if (derivedObjects.IsNull())
-        m_DerivedNodes[parent] = mitk::DataStorage::SetOfObjects::New();  // Create a set of Objects, if it does not already exist
-      mitk::DataStorage::SetOfObjects* deob = const_cast<mitk::DataStorage::SetOfObjects*>(m_DerivedNodes[parent].GetPointer());  // temporarily get rid of const pointer to insert new element
-      deob->InsertElement(deob->Size(), node); // node is derived from parent. Insert it into the parents list of derived objects
-    }
+}
+
+
+void mitk::StandaloneDataStorage::InsertNode(mitk::DataNode* node, const mitk::DataStorage::SetOfObjects* parents)
+{
+  /* create parent list if it does not exist */
+  mitk::DataStorage::SetOfObjects::ConstPointer sp;
+  if (parents != NULL)
+    sp = parents;
+  else
+    sp = mitk::DataStorage::SetOfObjects::New();
+  /* Store node and parent list in sources adjacency list */
+  m_SourceNodes.insert(std::make_pair(node, sp));
+
+  /* Store node and an empty children list in derivations adjacency list */
+  mitk::DataStorage::SetOfObjects::Pointer childrenPointer = mitk::DataStorage::SetOfObjects::New();
+  mitk::DataStorage::SetOfObjects::ConstPointer children =  childrenPointer.GetPointer();
+  m_DerivedNodes.insert(std::make_pair(node, children));
 
-    // register for ITK changed events
-    this->AddListeners(node);
+  /* create entry in derivations adjacency list for each parent of the new node */
+  for (SetOfObjects::ConstIterator it = sp->Begin(); it != sp->End(); it++)
+  {
+    mitk::DataNode::ConstPointer parent = it.Value().GetPointer();
+    mitk::DataStorage::SetOfObjects::ConstPointer derivedObjects = m_DerivedNodes[parent]; // get or create pointer to list of derived objects for that parent node
+    if (derivedObjects.IsNull())
+      m_DerivedNodes[parent] = mitk::DataStorage::SetOfObjects::New();  // Create a set of Objects, if it does not already exist
+    mitk::DataStorage::SetOfObjects* deob = const_cast<mitk::DataStorage::SetOfObjects*>(m_DerivedNodes[parent].GetPointer());  // temporarily get rid of const pointer to insert new element
+    deob->InsertElement(deob->Size(), node); // node is derived from parent. Insert it into the parents list of derived objects
   }
 
-  /* Notify observers */
-  EmitAddNodeEvent(node);
+  // register for ITK changed events
+  this->AddListeners(node);
 
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+  this->AddToIndex(node);
 }
 
 
@@ -104,6 +157,10 @@ void mitk::StandaloneDataStorage::Remove(const mitk::DataNode* node)
   if (node == NULL)
     return;
 
+  /* during a batch the node is removed by CommitBatch() */
+  if (this->QueueBatchRemove(node))
+    return;
+
   // remove ITK modified event listener
   this->RemoveListeners(node);
 
@@ -122,6 +179,9 @@ void mitk::StandaloneDataStorage::Remove(const mitk::DataNode* node)
     /* remove node from both relation adjacency lists */
     this->RemoveFromRelation(node, m_SourceNodes);
     this->RemoveFromRelation(node, m_DerivedNodes);
+
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+    this->RemoveFromIndex(node);
   }
 }
 
@@ -149,6 +209,75 @@ void mitk::StandaloneDataStorage::RemoveFromRelation(const mitk::DataNode* node,
 }
 
 
+void mitk::StandaloneDataStorage::RemoveFromRelation(const std::set<const mitk::DataNode*>& nodes, AdjacencyList& relation)
+{
+  /* one pass over the relation for all nodes */
+  for (AdjacencyList::const_iterator mapIter = relation.cbegin(); mapIter != relation.cend(); ++mapIter)
+    if (mapIter->second.IsNotNull())
+    {
+      SetOfObjects::Pointer s = const_cast<SetOfObjects*>(mapIter->second.GetPointer());
+      s->erase(std::remove_if(s->begin(), s->end(),
+        [&nodes](const mitk::DataNode::Pointer& n) { return nodes.find(n.GetPointer()) != nodes.end(); }), s->end());
+    }
+  for (std::set<const mitk::DataNode*>::const_iterator it = nodes.cbegin(); it != nodes.cend(); ++it)
+    relation.erase(*it);
+}
+
+
+void mitk::StandaloneDataStorage::CommitBatchOperations(const BatchOperations& operations)
+{
+  if (!IsInitialized())
+    throw std::logic_error("DataStorage not initialized");
+
+  /* the operations keep the removed nodes alive until the batch events have been sent */
+  mitk::DataStorage::SetOfObjects::Pointer removedNodes = mitk::DataStorage::SetOfObjects::New();
+  std::set<const mitk::DataNode*> removedSet;
+  for (BatchOperations::const_iterator it = operations.cbegin(); it != operations.cend(); ++it)
+  {
+    if (!it->Remove || !this->Exists(it->Node))
+      continue;
+    this->RemoveListeners(it->Node);
+    /* Notify observers of imminent node removal */
+    EmitRemoveNodeEvent(it->Node);
+    removedNodes->InsertElement(removedNodes->Size(), it->Node);
+    removedSet.insert(it->Node.GetPointer());
+  }
+
+  mitk::DataStorage::SetOfObjects::Pointer addedNodes = mitk::DataStorage::SetOfObjects::New();
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+    if (!removedSet.empty())
+    {
+      this->RemoveFromRelation(removedSet, m_SourceNodes);
+      this->RemoveFromRelation(removedSet, m_DerivedNodes);
+
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+      for (std::set<const mitk::DataNode*>::const_iterator it = removedSet.cbegin(); it != removedSet.cend(); ++it)
+        this->RemoveFromIndex(*it);
+    }
+
+    for (BatchOperations::const_iterator it = operations.cbegin(); it != operations.cend(); ++it)
+    {
+      if (it->Remove)
+        continue;
+      /* added meanwhile from another thread or by an observer of the removals */
+      if (m_SourceNodes.find(it->Node.GetPointer()) != m_SourceNodes.end())
+      {
+        MITK_WARN << "Node " << it->Node->GetName() << " of a batch is already in DataStorage";
+        continue;
+      }
+      this->InsertNode(it->Node, it->Parents);
+      addedNodes->InsertElement(addedNodes->Size(), it->Node);
+    }
+  }
+
+  /* Notify observers */
+  for (SetOfObjects::ConstIterator it = addedNodes->Begin(); it != addedNodes->End(); ++it)
+    EmitAddNodeEvent(it.Value());
+  this->EmitBatchEvents(removedNodes, addedNodes);
+}
+
+
 mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetAll() const
 {
   itk::MutexLockHolder<itk::SimpleFastMutexLock > locked(m_Mutex);
@@ -243,6 +372,240 @@ mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetDe
 }
 
 
+mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetSubset(const NodePredicateBase* condition) const
+{
+  mitk::DataStorage::SetOfObjects::Pointer candidates;
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+    this->UpdateModifiedIndexEntries();
+    const IndexedNodes* indexedNodes = this->GetIndexedCandidates(condition);
+    if (indexedNodes != nullptr)
+    {
+      candidates = mitk::DataStorage::SetOfObjects::New();
+      for (IndexedNodes::const_iterator it = indexedNodes->cbegin(); it != indexedNodes->cend(); ++it)
+        candidates->InsertElement(candidates->Size(), const_cast<mitk::DataNode*>(*it));
+    }
+  }
+
+  /* conditions without index are checked for all nodes */
+  if (candidates.IsNull())
+    return Superclass::GetSubset(condition);
+
+  /* the index only preselects, the condition decides (e.g. for properties with equal string representation) */
+  return this->FilterSetOfObjects(candidates, condition);
+}
+
+
+void mitk::StandaloneDataStorage::AddIndexedPropertyKey(const std::string& propertyKey)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+  if (!m_IndexedPropertyKeys.insert(propertyKey).second)
+    return;
+
+  /* read the new key with the next query */
+  for (std::map<const mitk::DataNode*, IndexEntry>::const_iterator it = m_IndexEntries.cbegin(); it != m_IndexEntries.cend(); ++it)
+    m_ModifiedNodes.insert(it->first);
+}
+
+
+void mitk::StandaloneDataStorage::RemoveIndexedPropertyKey(const std::string& propertyKey)
+{
+  if (propertyKey == "name")
+    return;
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+  if (m_IndexedPropertyKeys.erase(propertyKey) == 0)
+    return;
+
+  /* drop the values and the property observers with the next query */
+  for (std::map<const mitk::DataNode*, IndexEntry>::const_iterator it = m_IndexEntries.cbegin(); it != m_IndexEntries.cend(); ++it)
+    m_ModifiedNodes.insert(it->first);
+}
+
+
+std::vector<std::string> mitk::StandaloneDataStorage::GetIndexedPropertyKeys() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+  return std::vector<std::string>(m_IndexedPropertyKeys.cbegin(), m_IndexedPropertyKeys.cend());
+}
+
+
+void mitk::StandaloneDataStorage::AddToIndex(const mitk::DataNode* node) const
+{
+  if (node == nullptr || m_IndexEntries.find(node) != m_IndexEntries.end())
+    return;
+
+  IndexEntry& entry = m_IndexEntries[node];
+  IndexUpdateCommand::Pointer command = IndexUpdateCommand::New();
+  command->SetNode(this, node);
+  entry.NodeObserverTag = node->AddObserver(itk::ModifiedEvent(), command);
+  this->UpdateIndexEntry(node, entry);
+}
+
+
+void mitk::StandaloneDataStorage::RemoveFromIndex(const mitk::DataNode* node) const
+{
+  std::map<const mitk::DataNode*, IndexEntry>::iterator it = m_IndexEntries.find(node);
+  if (it == m_IndexEntries.end())
+    return;
+
+  this->ClearIndexEntry(node, it->second);
+  const_cast<mitk::DataNode*>(node)->RemoveObserver(it->second.NodeObserverTag);
+  m_IndexEntries.erase(it);
+  m_ModifiedNodes.erase(node);
+}
+
+
+void mitk::StandaloneDataStorage::UpdateIndexEntry(const mitk::DataNode* node, IndexEntry& entry) const
+{
+  this->ClearIndexEntry(node, entry);
+
+  const mitk::BaseData* data = node->GetData();
+  if (data != nullptr)
+  {
+    entry.DataType = data->GetNameOfClass();
+    m_DataTypeIndex[entry.DataType].insert(node);
+  }
+
+  for (std::set<std::string>::const_iterator keyIt = m_IndexedPropertyKeys.cbegin(); keyIt != m_IndexedPropertyKeys.cend(); ++keyIt)
+  {
+    mitk::BaseProperty* property = node->GetProperty(keyIt->c_str());
+    if (property == nullptr)
+      continue;
+
+    std::string value = GetIndexValue(property);
+    entry.PropertyValues[*keyIt] = value;
+    m_PropertyValueIndex[*keyIt][value].insert(node);
+    m_PropertyKeyIndex[*keyIt].insert(node);
+
+    /* values of properties can be changed without notifying the node */
+    IndexUpdateCommand::Pointer command = IndexUpdateCommand::New();
+    command->SetNode(this, node);
+    entry.PropertyObserverTags.push_back(std::make_pair(mitk::BaseProperty::Pointer(property), property->AddObserver(itk::ModifiedEvent(), command)));
+  }
+}
+
+
+void mitk::StandaloneDataStorage::ClearIndexEntry(const mitk::DataNode* node, IndexEntry& entry) const
+{
+  if (!entry.DataType.empty())
+  {
+    std::map<std::string, IndexedNodes>::iterator typeIt = m_DataTypeIndex.find(entry.DataType);
+    if (typeIt != m_DataTypeIndex.end())
+    {
+      typeIt->second.erase(node);
+      if (typeIt->second.empty())
+        m_DataTypeIndex.erase(typeIt);
+    }
+    entry.DataType.clear();
+  }
+
+  for (std::map<std::string, std::string>::const_iterator valueIt = entry.PropertyValues.cbegin(); valueIt != entry.PropertyValues.cend(); ++valueIt)
+  {
+    std::map<std::string, std::map<std::string, IndexedNodes> >::iterator keyIt = m_PropertyValueIndex.find(valueIt->first);
+    if (keyIt != m_PropertyValueIndex.end())
+    {
+      std::map<std::string, IndexedNodes>::iterator nodesIt = keyIt->second.find(valueIt->second);
+      if (nodesIt != keyIt->second.end())
+      {
+        nodesIt->second.erase(node);
+        if (nodesIt->second.empty())
+          keyIt->second.erase(nodesIt);
+      }
+      if (keyIt->second.empty())
+        m_PropertyValueIndex.erase(keyIt);
+    }
+
+    std::map<std::string, IndexedNodes>::iterator existsIt = m_PropertyKeyIndex.find(valueIt->first);
+    if (existsIt != m_PropertyKeyIndex.end())
+    {
+      existsIt->second.erase(node);
+      if (existsIt->second.empty())
+        m_PropertyKeyIndex.erase(existsIt);
+    }
+  }
+  entry.PropertyValues.clear();
+
+  for (std::vector<std::pair<mitk::BaseProperty::Pointer, unsigned long> >::const_iterator tagIt = entry.PropertyObserverTags.cbegin(); tagIt != entry.PropertyObserverTags.cend(); ++tagIt)
+    tagIt->first->RemoveObserver(tagIt->second);
+  entry.PropertyObserverTags.clear();
+}
+
+
+void mitk::StandaloneDataStorage::UpdateModifiedIndexEntries() const
+{
+  for (IndexedNodes::const_iterator it = m_ModifiedNodes.cbegin(); it != m_ModifiedNodes.cend(); ++it)
+  {
+    std::map<const mitk::DataNode*, IndexEntry>::iterator entryIt = m_IndexEntries.find(*it);
+    if (entryIt != m_IndexEntries.end())
+      this->UpdateIndexEntry(entryIt->first, entryIt->second);
+  }
+  m_ModifiedNodes.clear();
+}
+
+
+const mitk::StandaloneDataStorage::IndexedNodes* mitk::StandaloneDataStorage::GetIndexedCandidates(const NodePredicateBase* condition) const
+{
+  if (condition == nullptr)
+    return nullptr;
+
+  if (const mitk::NodePredicateDataType* dataTypeCondition = dynamic_cast<const mitk::NodePredicateDataType*>(condition))
+  {
+    std::map<std::string, IndexedNodes>::const_iterator it = m_DataTypeIndex.find(dataTypeCondition->GetValidDataType());
+    return it != m_DataTypeIndex.cend() ? &it->second : &m_EmptyIndexedNodes;
+  }
+
+  if (const mitk::NodePredicateProperty* propertyCondition = dynamic_cast<const mitk::NodePredicateProperty*>(condition))
+  {
+    const std::string& key = propertyCondition->GetValidPropertyName();
+    if (propertyCondition->GetRenderer() != nullptr || m_IndexedPropertyKeys.find(key) == m_IndexedPropertyKeys.end())
+      return nullptr;
+
+    if (propertyCondition->GetValidProperty() == nullptr)
+    {
+      std::map<std::string, IndexedNodes>::const_iterator it = m_PropertyKeyIndex.find(key);
+      return it != m_PropertyKeyIndex.cend() ? &it->second : &m_EmptyIndexedNodes;
+    }
+
+    std::map<std::string, std::map<std::string, IndexedNodes> >::const_iterator keyIt = m_PropertyValueIndex.find(key);
+    if (keyIt == m_PropertyValueIndex.cend())
+      return &m_EmptyIndexedNodes;
+    std::map<std::string, IndexedNodes>::const_iterator valueIt = keyIt->second.find(GetIndexValue(propertyCondition->GetValidProperty()));
+    return valueIt != keyIt->second.cend() ? &valueIt->second : &m_EmptyIndexedNodes;
+  }
+
+  if (const mitk::NodePredicateAnd* andCondition = dynamic_cast<const mitk::NodePredicateAnd*>(condition))
+  {
+    /* every node of the result fulfills all children, the smallest indexed child set is sufficient */
+    const IndexedNodes* smallest = nullptr;
+    mitk::NodePredicateCompositeBase::ChildPredicates children = andCondition->GetPredicates();
+    for (mitk::NodePredicateCompositeBase::ChildPredicates::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+    {
+      const IndexedNodes* candidates = this->GetIndexedCandidates(*it);
+      if (candidates != nullptr && (smallest == nullptr || candidates->size() < smallest->size()))
+        smallest = candidates;
+    }
+    return smallest;
+  }
+
+  return nullptr;
+}
+
+
+void mitk::StandaloneDataStorage::OnIndexedNodeModified(const mitk::DataNode* node) const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> indexLocked(m_IndexMutex);
+  m_ModifiedNodes.insert(node);
+}
+
+
+std::string mitk::StandaloneDataStorage::GetIndexValue(const mitk::BaseProperty* property)
+{
+  /* BaseProperty::operator== requires equal types, so the type is part of the key */
+  return std::string(property->GetNameOfClass()) + ':' + property->GetValueAsString();
+}
+
+
 void mitk::StandaloneDataStorage::PrintSelf(std::ostream& os, itk::Indent indent) const
 {
   os << indent << "StandaloneDataStorage:\n";
@@ -25,20 +25,153 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCoreServices.h>
 #include <mitkIPropertyPersistence.h>
 #include <mitkArbitraryTimeGeometry.h>
+#include <mitkMemoryMappedFile.h>
 
 #include <itkImage.h>
 #include <itkImageIOFactory.h>
 #include <itkImageFileReader.h>
 #include <itkImageIORegion.h>
 #include <itkMetaDataObject.h>
+#include <itkByteSwapper.h>
+#include <itksys/SystemTools.hxx>
 
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
 
 namespace mitk {
 
 const char * const PROPERTY_KEY_TIMEGEOMETRY_TYPE = "org.mitk.timegeometry.type";
 const char * const PROPERTY_KEY_TIMEGEOMETRY_TIMEPOINTS = "org.mitk.timegeometry.timepoints";
 
+std::string ItkImageIO::OPTION_MEMORY_MAPPING()
+{
+  static std::string s = "Memory mapping";
+  return s;
+}
+
+std::string ItkImageIO::OPTION_MEMORY_MAPPING_OFF()
+{
+  static std::string s = "Off";
+  return s;
+}
+
+std::string ItkImageIO::OPTION_MEMORY_MAPPING_READ_ONLY()
+{
+  static std::string s = "Read only";
+  return s;
+}
+
+std::string ItkImageIO::OPTION_MEMORY_MAPPING_COPY_ON_WRITE()
+{
+  static std::string s = "Copy on write";
+  return s;
+}
+
+/**Helper function that determines where the raw pixel data of a NRRD file starts.
+ * Returns false if the data cannot be mapped directly (encoding is not raw, byte order
+ * differs from the host, several data files, line skips).*/
+static bool GetRawNrrdDataLocation(const std::string& path, unsigned long long imageSizeInBytes,
+                                   unsigned int componentSize, std::string& dataFile, unsigned long long& offset)
+{
+  std::ifstream header(path.c_str(), std::ios::in | std::ios::binary);
+  std::string line;
+  if (!header.good() || !std::getline(header, line) || line.compare(0, 4, "NRRD") != 0)
+  {
+    return false;
+  }
+
+  std::string encoding;
+  std::string endian;
+  long long byteSkip = 0;
+  long long lineSkip = 0;
+  dataFile.clear();
+  bool attached = false;
+
+  while (std::getline(header, line))
+  {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+    {
+      line.erase(line.size() - 1);
+    }
+    if (line.empty())
+    {
+      // an empty line separates the header from attached data
+      attached = dataFile.empty();
+      break;
+    }
+    if (line[0] == '#' || line.find(":=") != std::string::npos)
+    {
+      continue;
+    }
+    const std::string::size_type separator = line.find(": ");
+    if (separator == std::string::npos)
+    {
+      continue;
+    }
+    const std::string field = line.substr(0, separator);
+    const std::string value = itksys::SystemTools::TrimWhitespace(line.substr(separator + 2));
+
+    if (field == "encoding")
+      encoding = value;
+    else if (field == "endian")
+      endian = value;
+    else if (field == "byte skip" || field == "byteskip")
+      byteSkip = std::atoll(value.c_str());
+    else if (field == "line skip" || field == "lineskip")
+      lineSkip = std::atoll(value.c_str());
+    else if (field == "data file" || field == "datafile")
+      dataFile = value;
+  }
+
+  if (encoding != "raw" || lineSkip != 0)
+  {
+    return false;
+  }
+
+  if (componentSize > 1)
+  {
+    const std::string hostEndian = itk::ByteSwapper<int>::SystemIsLittleEndian() ? "little" : "big";
+    if (endian != hostEndian)
+    {
+      return false;
+    }
+  }
+
+  if (attached)
+  {
+    dataFile = path;
+    offset = static_cast<unsigned long long>(header.tellg());
+  }
+  else
+  {
+    if (dataFile.empty() || dataFile.find(' ') != std::string::npos || dataFile == "LIST")
+    {
+      return false;
+    }
+    if (!itksys::SystemTools::FileIsFullPath(dataFile.c_str()))
+    {
+      dataFile = itksys::SystemTools::GetFilenamePath(path) + "/" + dataFile;
+    }
+    offset = 0;
+  }
+
+  const unsigned long long fileSize = itksys::SystemTools::FileLength(dataFile.c_str());
+  if (byteSkip == -1)
+  {
+    // data is located at the end of the file
+    if (fileSize < imageSizeInBytes)
+      return false;
+    offset = fileSize - imageSizeInBytes;
+  }
+  else
+  {
+    offset += static_cast<unsigned long long>(byteSkip);
+  }
+
+  return offset + imageSizeInBytes <= fileSize;
+}
+
 ItkImageIO::ItkImageIO(const ItkImageIO& other)
   : AbstractFileIO(other)
   , m_ImageIO(dynamic_cast<itk::ImageIOBase*>(other.m_ImageIO->Clone().GetPointer()))
@@ -162,6 +295,8 @@ ItkImageIO::ItkImageIO(itk::ImageIOBase::Pointer imageIO)
   this->SetReaderDescription(description);
   this->SetWriterDescription(description);
 
+  this->InitializeDefaultReaderOptions();
+
   this->RegisterService();
 }
 
@@ -183,6 +318,8 @@ ItkImageIO::ItkImageIO(const CustomMimeType& mimeType, itk::ImageIOBase::Pointer
     this->AbstractFileWriter::SetRanking(rank);
   }
 
+  this->InitializeDefaultReaderOptions();
+
   this->RegisterService();
 }
 
@@ -295,11 +432,20 @@ std::vector<BaseData::Pointer> ItkImageIO::Read()
 
   MITK_INFO << "ioRegion: " << ioRegion << std::endl;
   m_ImageIO->SetIORegion( ioRegion );
-  void* buffer = new unsigned char[m_ImageIO->GetImageSizeInBytes()];
-  m_ImageIO->Read( buffer );
-
   image->Initialize( MakePixelType(m_ImageIO), ndim, dimensions );
-  image->SetImportChannel( buffer, 0, Image::ManageMemory );
+
+  void* buffer = NULL;
+  MemoryMappedFile::Pointer mappedFile = this->MapImageData(path);
+  if (mappedFile.IsNotNull() && image->SetMemoryMappedChannel(mappedFile, 0))
+  {
+    MITK_INFO << "image data is memory mapped from " << mappedFile->GetFileName() << " at offset " << mappedFile->GetOffset();
+  }
+  else
+  {
+    buffer = new unsigned char[m_ImageIO->GetImageSizeInBytes()];
+    m_ImageIO->Read( buffer );
+    image->SetImportChannel( buffer, 0, Image::ManageMemory );
+  }
 
   const itk::MetaDataDictionary& dictionary = m_ImageIO->GetMetaDataDictionary();
 
@@ -632,6 +778,59 @@ ItkImageIO* ItkImageIO::IOClone() const
   return new ItkImageIO(*this);
 }
 
+void ItkImageIO::InitializeDefaultReaderOptions()
+{
+  if (std::string(m_ImageIO->GetNameOfClass()) != "NrrdImageIO")
+  {
+    return;
+  }
+
+  Options defaultOptions = this->GetDefaultReaderOptions();
+  defaultOptions[OPTION_MEMORY_MAPPING()] = OPTION_MEMORY_MAPPING_OFF();
+  std::vector<std::string> mappingEnum;
+  mappingEnum.push_back(OPTION_MEMORY_MAPPING_OFF());
+  mappingEnum.push_back(OPTION_MEMORY_MAPPING_READ_ONLY());
+  mappingEnum.push_back(OPTION_MEMORY_MAPPING_COPY_ON_WRITE());
+  defaultOptions[OPTION_MEMORY_MAPPING() + ".enum"] = mappingEnum;
+  this->SetDefaultReaderOptions(defaultOptions);
+}
+
+MemoryMappedFile::Pointer ItkImageIO::MapImageData(const std::string& path) const
+{
+  us::Any mappingOption = this->GetReaderOption(OPTION_MEMORY_MAPPING());
+  if (mappingOption.Empty() || mappingOption.ToString() == OPTION_MEMORY_MAPPING_OFF())
+  {
+    return nullptr;
+  }
+
+  if (m_ImageIO->GetNumberOfComponents() != 1)
+  {
+    MITK_INFO << "memory mapping is only supported for scalar images, reading " << path << " into memory";
+    return nullptr;
+  }
+
+  std::string dataFile;
+  unsigned long long offset = 0;
+  const unsigned long long size = m_ImageIO->GetImageSizeInBytes();
+  if (!GetRawNrrdDataLocation(path, size, m_ImageIO->GetComponentSize(), dataFile, offset))
+  {
+    MITK_INFO << "image data of " << path << " is not stored uncompressed in host byte order, reading it into memory";
+    return nullptr;
+  }
+
+  const MemoryMappedFile::AccessMode mode = mappingOption.ToString() == OPTION_MEMORY_MAPPING_COPY_ON_WRITE()
+    ? MemoryMappedFile::CopyOnWrite : MemoryMappedFile::ReadOnly;
+  try
+  {
+    return MemoryMappedFile::Open(dataFile, offset, size, mode);
+  }
+  catch (const mitk::Exception& e)
+  {
+    MITK_WARN << "memory mapping failed, reading image data into memory: " << e.GetDescription();
+  }
+  return nullptr;
+}
+
 void ItkImageIO::InitializeDefaultMetaDataKeys()
 {
   this->m_DefaultMetaDataKeys.push_back("NRRD.space");
@@ -0,0 +1,397 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkAsynchronousSliceGenerator.h"
+#include "vtkMitkThickSlicesFilter.h"
+
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  /** Threads shared by all generators. Each generator has at most one task in the queue. */
+  class SliceThreadPool
+  {
+  public:
+
+    typedef std::function<void()> Task;
+
+    static SliceThreadPool& GetInstance()
+    {
+      static SliceThreadPool pool;
+      return pool;
+    }
+
+    void Enqueue(const Task& task)
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+
+      if (m_Threads.empty())
+      {
+        // the slice extraction itself is multithreaded, a few threads suffice
+        const unsigned int numberOfThreads = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+        for (unsigned int i = 0; i < numberOfThreads; ++i)
+        {
+          m_Threads.push_back(std::thread(&SliceThreadPool::Run, this));
+        }
+      }
+
+      m_Tasks.push_back(task);
+      m_Condition.notify_one();
+    }
+
+  private:
+
+    SliceThreadPool()
+      : m_Stop(false)
+    {
+    }
+
+    ~SliceThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+        m_Tasks.clear();
+      }
+      m_Condition.notify_all();
+
+      for (std::thread& thread : m_Threads)
+      {
+        thread.join();
+      }
+    }
+
+    void Run()
+    {
+      for (;;)
+      {
+        Task task;
+        {
+          std::unique_lock<std::mutex> lock(m_Mutex);
+          m_Condition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+
+          if (m_Stop)
+            return;
+
+          task = m_Tasks.front();
+          m_Tasks.pop_front();
+        }
+
+        task();
+      }
+    }
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<Task> m_Tasks;
+    std::vector<std::thread> m_Threads;
+    bool m_Stop;
+  };
+}
+
+struct mitk::AsynchronousSliceGenerator::State
+{
+  State()
+    : Reslicer(ExtractSliceFilter::New()),
+      ThickSlicesFilter(vtkSmartPointer<vtkMitkThickSlicesFilter>::New()),
+      Generation(0),
+      Queued(false),
+      Cancelled(false)
+  {
+    ThickSlicesFilter->ReleaseDataFlagOn();
+  }
+
+  // only used by the pool thread which processes the requests
+  ExtractSliceFilter::Pointer Reslicer;
+  vtkSmartPointer<vtkMitkThickSlicesFilter> ThickSlicesFilter;
+
+  std::mutex Mutex;
+  ResultCallback Callback;
+  std::unique_ptr<Request> Latest;
+  std::unique_ptr<Request> Pending;
+  std::unique_ptr<Result> Available;
+  unsigned long Generation;
+  bool Queued;
+  bool Cancelled;
+};
+
+mitk::AsynchronousSliceGenerator::Request::Request()
+  : InputMTime(0),
+    TimeStep(0),
+    Interpolation(ExtractSliceFilter::RESLICE_NEAREST),
+    InPlaneResampleExtentByGeometry(false),
+    ThickSlicesMode(0),
+    ThickSlicesNum(1),
+    ThickSlicesSpacing(1.0)
+{
+}
+
+bool mitk::AsynchronousSliceGenerator::Request::IsEquivalent(const Request& other) const
+{
+  if (Input.IsNull() || Input != other.Input || InputMTime != other.InputMTime ||
+      TimeStep != other.TimeStep || Interpolation != other.Interpolation ||
+      InPlaneResampleExtentByGeometry != other.InPlaneResampleExtentByGeometry ||
+      ThickSlicesMode != other.ThickSlicesMode)
+  {
+    return false;
+  }
+
+  if (ThickSlicesMode > 0 && (ThickSlicesNum != other.ThickSlicesNum || ThickSlicesSpacing != other.ThickSlicesSpacing))
+    return false;
+
+  if (WorldGeometry.IsNull() || other.WorldGeometry.IsNull() ||
+      WorldGeometry->GetReferenceGeometry() != other.WorldGeometry->GetReferenceGeometry() ||
+      !Equal(*WorldGeometry, *other.WorldGeometry, eps, false))
+  {
+    return false;
+  }
+
+  if (ResliceTransformGeometry.IsNull() || other.ResliceTransformGeometry.IsNull())
+    return ResliceTransformGeometry.IsNull() && other.ResliceTransformGeometry.IsNull();
+
+  return Equal(*ResliceTransformGeometry, *other.ResliceTransformGeometry, eps, false);
+}
+
+mitk::AsynchronousSliceGenerator::Result::Result()
+{
+  std::fill(SliceBounds, SliceBounds + 6, 0.0);
+  MmPerPixel[0] = MmPerPixel[1] = 1.0;
+}
+
+mitk::AsynchronousSliceGenerator::AsynchronousSliceGenerator()
+  : m_State(new State)
+{
+}
+
+mitk::AsynchronousSliceGenerator::~AsynchronousSliceGenerator()
+{
+  // a running request keeps the state alive and finds it cancelled
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+  m_State->Cancelled = true;
+  m_State->Callback = nullptr;
+  m_State->Pending.reset();
+  m_State->Available.reset();
+}
+
+void mitk::AsynchronousSliceGenerator::SetResultCallback(const ResultCallback& callback)
+{
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+  m_State->Callback = callback;
+}
+
+void mitk::AsynchronousSliceGenerator::Submit(const Request& request)
+{
+  bool enqueue = false;
+  {
+    std::lock_guard<std::mutex> lock(m_State->Mutex);
+
+    if (m_State->Latest && m_State->Latest->IsEquivalent(request) && (m_State->Queued || m_State->Available))
+      return;
+
+    // older requests are replaced, their results (if any) are stale
+    ++m_State->Generation;
+    m_State->Latest.reset(new Request(request));
+    m_State->Pending.reset(new Request(request));
+    m_State->Available.reset();
+
+    if (!m_State->Queued)
+    {
+      m_State->Queued = true;
+      enqueue = true;
+    }
+  }
+
+  if (enqueue)
+  {
+    std::shared_ptr<State> state = m_State;
+    SliceThreadPool::GetInstance().Enqueue([state]() { AsynchronousSliceGenerator::ProcessRequests(state); });
+  }
+}
+
+void mitk::AsynchronousSliceGenerator::Cancel()
+{
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+  ++m_State->Generation;
+  m_State->Latest.reset();
+  m_State->Pending.reset();
+  m_State->Available.reset();
+}
+
+bool mitk::AsynchronousSliceGenerator::TakeResult(Result& result)
+{
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+
+  if (!m_State->Available)
+    return false;
+
+  result = *m_State->Available;
+  m_State->Available.reset();
+  return true;
+}
+
+bool mitk::AsynchronousSliceGenerator::HasResult() const
+{
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+  return m_State->Available != nullptr;
+}
+
+bool mitk::AsynchronousSliceGenerator::IsBusy() const
+{
+  std::lock_guard<std::mutex> lock(m_State->Mutex);
+  return m_State->Queued;
+}
+
+void mitk::AsynchronousSliceGenerator::ProcessRequests(const std::shared_ptr<State>& state)
+{
+  for (;;)
+  {
+    Request request;
+    unsigned long generation;
+    {
+      std::lock_guard<std::mutex> lock(state->Mutex);
+
+      if (state->Cancelled || !state->Pending)
+      {
+        state->Queued = false;
+        return;
+      }
+
+      request = *state->Pending;
+      state->Pending.reset();
+      generation = state->Generation;
+    }
+
+    std::unique_ptr<Result> result(new Result);
+    bool generated = false;
+    try
+    {
+      generated = GenerateSlice(request, state->Reslicer, state->ThickSlicesFilter, *result, true);
+    }
+    catch (const std::exception& e)
+    {
+      MITK_WARN << "Asynchronous slice generation failed: " << e.what();
+    }
+
+    ResultCallback callback;
+    {
+      std::lock_guard<std::mutex> lock(state->Mutex);
+
+      // discard the slice if a newer request has been submitted meanwhile
+      if (generated && !state->Cancelled && generation == state->Generation)
+      {
+        state->Available = std::move(result);
+        callback = state->Callback;
+      }
+    }
+
+    if (callback)
+      callback();
+  }
+}
+
+bool mitk::AsynchronousSliceGenerator::GenerateSlice(const Request& request, ExtractSliceFilter* reslicer,
+  vtkMitkThickSlicesFilter* thickSlicesFilter, Result& result, bool copySlice)
+{
+  if (request.Input.IsNull() || request.WorldGeometry.IsNull())
+    return false;
+
+  //set main input for ExtractSliceFilter
+  reslicer->SetInput(request.Input);
+  reslicer->SetWorldGeometry(request.WorldGeometry);
+  reslicer->SetTimeStep(request.TimeStep);
+
+  //set the transformation of the image to adapt reslice axis
+  reslicer->SetResliceTransformByGeometry(request.ResliceTransformGeometry);
+
+  reslicer->SetInPlaneResampleExtentByGeometry(request.InPlaneResampleExtentByGeometry);
+  reslicer->SetInterpolationMode(request.Interpolation);
+
+  //set the vtk output property to true, makes sure that no unneeded mitk image convertion
+  //is done.
+  reslicer->SetVtkOutputRequest(true);
+
+  vtkImageData* slice = nullptr;
+  if (request.ThickSlicesMode > 0)
+  {
+    reslicer->SetOutputDimensionality(3);
+    reslicer->SetOutputSpacingZDirection(request.ThickSlicesSpacing);
+    reslicer->SetOutputExtentZDirection(-request.ThickSlicesNum, 0 + request.ThickSlicesNum);
+
+    // Do the reslicing. Modified() is called to make sure that the reslicer is
+    // executed even though the input geometry information did not change; this
+    // is necessary when the input /em data, but not the /em geometry changes.
+    thickSlicesFilter->SetThickSliceMode(request.ThickSlicesMode - 1);
+    thickSlicesFilter->SetInputData(reslicer->GetVtkOutput());
+
+    //vtkFilter=>mitkFilter=>vtkFilter update mechanism will fail without calling manually
+    reslicer->Modified();
+    reslicer->Update();
+
+    thickSlicesFilter->Modified();
+    thickSlicesFilter->Update();
+    slice = thickSlicesFilter->GetOutput();
+  }
+  else
+  {
+    //this is needed when thick mode was enable bevore. These variable have to be reset to default values
+    reslicer->SetOutputDimensionality(2);
+    reslicer->SetOutputSpacingZDirection(1.0);
+    reslicer->SetOutputExtentZDirection(0, 0);
+
+    reslicer->Modified();
+    //start the pipeline with updating the largest possible, needed if the geometry of the input has changed
+    reslicer->UpdateLargestPossibleRegion();
+    slice = reslicer->GetVtkOutput();
+  }
+
+  if (slice == nullptr)
+    return false;
+
+  if (copySlice)
+  {
+    // the filters reuse their output for the next request
+    result.Slice = vtkSmartPointer<vtkImageData>::New();
+    result.Slice->DeepCopy(slice);
+  }
+  else
+  {
+    result.Slice = slice;
+  }
+
+  // Bounds information for reslicing (only reuqired if reference geometry
+  // is present)
+  //this used for generating a vtkPLaneSource with the right size
+  std::fill(result.SliceBounds, result.SliceBounds + 6, 0.0);
+  reslicer->GetClippedPlaneBounds(result.SliceBounds);
+
+  //get the spacing of the slice
+  result.MmPerPixel[0] = reslicer->GetOutputSpacing()[0];
+  result.MmPerPixel[1] = reslicer->GetOutputSpacing()[1];
+
+  result.ResliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  result.ResliceAxes->DeepCopy(reslicer->GetResliceAxes());
+
+  result.SourceRequest = request;
+  return true;
+}
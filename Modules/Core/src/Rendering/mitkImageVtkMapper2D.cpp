@@ -54,8 +54,58 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkColorTransferFunction.h>
 
 //ITK
+#include <itkCommand.h>
 #include <itkRGBAPixel.h>
 #include <mitkRenderingModeProperty.h>
+#include <mitkCallbackFromGUIThread.h>
+#include <mitkRenderingManager.h>
+
+#include <algorithm>
+
+namespace
+{
+  /** Requests an update of a render window, executed from the GUI thread when a slice was generated in the background. */
+  class RequestUpdateCommand : public itk::Command
+  {
+  public:
+
+    mitkClassMacroItkParent(RequestUpdateCommand, itk::Command)
+    itkFactorylessNewMacro(Self)
+
+    void SetRenderWindow(mitk::RenderingManager* renderingManager, vtkRenderWindow* renderWindow)
+    {
+      m_RenderingManager = renderingManager;
+      m_RenderWindow = renderWindow;
+    }
+
+    virtual void Execute(itk::Object*, const itk::EventObject&) override
+    {
+      this->RequestUpdate();
+    }
+
+    virtual void Execute(const itk::Object*, const itk::EventObject&) override
+    {
+      this->RequestUpdate();
+    }
+
+  private:
+
+    RequestUpdateCommand()
+      : m_RenderWindow(NULL)
+    {
+    }
+
+    void RequestUpdate()
+    {
+      // unknown (e.g. closed) render windows are ignored by the rendering manager
+      if ( m_RenderingManager.IsNotNull() )
+        m_RenderingManager->RequestUpdate( m_RenderWindow );
+    }
+
+    mitk::RenderingManager::Pointer m_RenderingManager;
+    vtkRenderWindow* m_RenderWindow;
+  };
+}
 
 mitk::ImageVtkMapper2D::ImageVtkMapper2D()
 {
@@ -147,24 +197,26 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
     // see bug-13275
     localStorage->m_ReslicedImage = NULL;
     localStorage->m_Mapper->SetInputData( localStorage->m_EmptyPolyData );
+    localStorage->m_SliceGenerator.Cancel();
     return;
   }
 
 
-  //set main input for ExtractSliceFilter
-  localStorage->m_Reslicer->SetInput(input);
-  localStorage->m_Reslicer->SetWorldGeometry(worldGeometry);
-  localStorage->m_Reslicer->SetTimeStep( this->GetTimestep() );
-
+  //the slice to be shown, see AsynchronousSliceGenerator::GenerateSlice() for the setup of the reslicer
+  AsynchronousSliceGenerator::Request request;
+  request.Input = input;
+  request.InputMTime = std::max(input->GetMTime(), input->GetPipelineMTime());
+  request.WorldGeometry = worldGeometry;
+  request.TimeStep = this->GetTimestep();
 
   //set the transformation of the image to adapt reslice axis
-  localStorage->m_Reslicer->SetResliceTransformByGeometry( input->GetTimeGeometry()->GetGeometryForTimeStep( this->GetTimestep() ) );
+  request.ResliceTransformGeometry = input->GetTimeGeometry()->GetGeometryForTimeStep( this->GetTimestep() );
 
 
   //is the geometry of the slice based on the input image or the worldgeometry?
   bool inPlaneResampleExtentByGeometry = false;
   datanode->GetBoolProperty("in plane resample extent by geometry", inPlaneResampleExtentByGeometry, renderer);
-  localStorage->m_Reslicer->SetInPlaneResampleExtentByGeometry(inPlaneResampleExtentByGeometry);
+  request.InPlaneResampleExtentByGeometry = inPlaneResampleExtentByGeometry;
 
 
   // Initialize the interpolation mode for resampling; switch to nearest
@@ -184,25 +236,21 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
     switch ( interpolationMode )
     {
     case VTK_RESLICE_NEAREST:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_NEAREST);
+      request.Interpolation = ExtractSliceFilter::RESLICE_NEAREST;
       break;
     case VTK_RESLICE_LINEAR:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_LINEAR);
+      request.Interpolation = ExtractSliceFilter::RESLICE_LINEAR;
       break;
     case VTK_RESLICE_CUBIC:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_CUBIC);
+      request.Interpolation = ExtractSliceFilter::RESLICE_CUBIC;
       break;
     }
   }
   else
   {
-    localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_NEAREST);
+    request.Interpolation = ExtractSliceFilter::RESLICE_NEAREST;
   }
 
-  //set the vtk output property to true, makes sure that no unneeded mitk image convertion
-  //is done.
-  localStorage->m_Reslicer->SetVtkOutputRequest(true);
-
 
   //Thickslicing
   int thickSlicesMode = 0;
@@ -256,50 +304,49 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
 
     dataZSpacing = 1.0 / normInIndex.GetNorm();
 
-    localStorage->m_Reslicer->SetOutputDimensionality( 3 );
-    localStorage->m_Reslicer->SetOutputSpacingZDirection(dataZSpacing);
-    localStorage->m_Reslicer->SetOutputExtentZDirection( -thickSlicesNum, 0+thickSlicesNum );
-
-    // Do the reslicing. Modified() is called to make sure that the reslicer is
-    // executed even though the input geometry information did not change; this
-    // is necessary when the input /em data, but not the /em geometry changes.
-    localStorage->m_TSFilter->SetThickSliceMode( thickSlicesMode-1 );
-    localStorage->m_TSFilter->SetInputData( localStorage->m_Reslicer->GetVtkOutput() );
+    request.ThickSlicesMode = thickSlicesMode;
+    request.ThickSlicesNum = thickSlicesNum;
+    request.ThickSlicesSpacing = dataZSpacing;
+  }
 
-    //vtkFilter=>mitkFilter=>vtkFilter update mechanism will fail without calling manually
-    localStorage->m_Reslicer->Modified();
-    localStorage->m_Reslicer->Update();
+  bool asynchronous = false;
+  datanode->GetBoolProperty( "Image Rendering.Asynchronous", asynchronous, renderer );
+  if ( asynchronous )
+  {
+    // the geometries of the renderer may be changed in place while the request is pending
+    request.WorldGeometry = worldGeometry->Clone().GetPointer();
+    request.ResliceTransformGeometry = request.ResliceTransformGeometry->Clone().GetPointer();
+  }
 
-    localStorage->m_TSFilter->Modified();
-    localStorage->m_TSFilter->Update();
-    localStorage->m_ReslicedImage = localStorage->m_TSFilter->GetOutput();
+  // the first slice is always generated synchronously, so there is something to show
+  if ( asynchronous && localStorage->m_DisplayedSlice.Slice != NULL )
+  {
+    if ( !this->UpdateSliceAsynchronously( renderer, request ) )
+    {
+      // keep showing the previous slice
+      return;
+    }
   }
   else
   {
-    //this is needed when thick mode was enable bevore. These variable have to be reset to default values
-    localStorage->m_Reslicer->SetOutputDimensionality( 2 );
-    localStorage->m_Reslicer->SetOutputSpacingZDirection(1.0);
-    localStorage->m_Reslicer->SetOutputExtentZDirection( 0, 0 );
-
+    localStorage->m_SliceGenerator.Cancel();
+    AsynchronousSliceGenerator::GenerateSlice( request, localStorage->m_Reslicer, localStorage->m_TSFilter, localStorage->m_DisplayedSlice, false );
 
-    localStorage->m_Reslicer->Modified();
-    //start the pipeline with updating the largest possible, needed if the geometry of the input has changed
-    localStorage->m_Reslicer->UpdateLargestPossibleRegion();
-    localStorage->m_ReslicedImage = localStorage->m_Reslicer->GetVtkOutput();
+    // without cloned geometries, the request cannot be compared with later ones
+    if ( !asynchronous )
+      localStorage->m_DisplayedSlice.SourceRequest = AsynchronousSliceGenerator::Request();
   }
 
+  localStorage->m_ReslicedImage = localStorage->m_DisplayedSlice.Slice;
+
   // Bounds information for reslicing (only reuqired if reference geometry
   // is present)
   //this used for generating a vtkPLaneSource with the right size
   double sliceBounds[6];
-  for (auto & sliceBound : sliceBounds)
-  {
-    sliceBound = 0.0;
-  }
-  localStorage->m_Reslicer->GetClippedPlaneBounds(sliceBounds);
+  std::copy( localStorage->m_DisplayedSlice.SliceBounds, localStorage->m_DisplayedSlice.SliceBounds + 6, sliceBounds );
 
   //get the spacing of the slice
-  localStorage->m_mmPerPixel = localStorage->m_Reslicer->GetOutputSpacing();
+  localStorage->m_mmPerPixel = localStorage->m_DisplayedSlice.MmPerPixel;
 
   // calculate minimum bounding rect of IMAGE in texture
   {
@@ -434,6 +481,37 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
   localStorage->m_LastUpdateTime.Modified();
 }
 
+bool mitk::ImageVtkMapper2D::UpdateSliceAsynchronously(mitk::BaseRenderer* renderer, const AsynchronousSliceGenerator::Request& request)
+{
+  LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
+
+  if ( localStorage->m_DisplayedSlice.SourceRequest.IsEquivalent( request ) )
+  {
+    // e.g. scrolled back to the displayed slice before the pending one was finished
+    localStorage->m_SliceGenerator.Cancel();
+    return true;
+  }
+
+  AsynchronousSliceGenerator::Result result;
+  if ( localStorage->m_SliceGenerator.TakeResult( result ) && result.SourceRequest.IsEquivalent( request ) )
+  {
+    localStorage->m_DisplayedSlice = result;
+    return true;
+  }
+
+  RenderingManager::Pointer renderingManager = renderer->GetRenderingManager();
+  vtkRenderWindow* renderWindow = renderer->GetRenderWindow();
+  localStorage->m_SliceGenerator.SetResultCallback( [renderingManager, renderWindow]()
+  {
+    RequestUpdateCommand::Pointer command = RequestUpdateCommand::New();
+    command->SetRenderWindow( renderingManager, renderWindow );
+    CallbackFromGUIThread::GetInstance()->CallThisFromGUIThread( command );
+  } );
+  localStorage->m_SliceGenerator.Submit( request );
+
+  return false;
+}
+
 void mitk::ImageVtkMapper2D::ApplyLevelWindow(mitk::BaseRenderer *renderer)
 {
   LocalStorage *localStorage = this->GetLocalStorage( renderer );
@@ -661,7 +739,8 @@ void mitk::ImageVtkMapper2D::Update(mitk::BaseRenderer* renderer)
        || (localStorage->m_LastUpdateTime < renderer->GetCurrentWorldPlaneGeometryUpdateTime()) //was the geometry modified?
        || (localStorage->m_LastUpdateTime < renderer->GetCurrentWorldPlaneGeometry()->GetMTime())
        || (localStorage->m_LastUpdateTime < node->GetPropertyList()->GetMTime()) //was a property modified?
-       || (localStorage->m_LastUpdateTime < node->GetPropertyList(renderer)->GetMTime()) )
+       || (localStorage->m_LastUpdateTime < node->GetPropertyList(renderer)->GetMTime())
+       || (localStorage->m_SliceGenerator.HasResult()) ) //was a slice generated in the background?
   {
     this->GenerateDataForRenderer( renderer );
   }
@@ -686,6 +765,7 @@ void mitk::ImageVtkMapper2D::SetDefaultProperties(mitk::DataNode* node, mitk::Ba
   else node->AddProperty( "reslice interpolation", mitk::VtkResliceInterpolationProperty::New() );
   node->AddProperty( "texture interpolation", mitk::BoolProperty::New( false ) );
   node->AddProperty( "in plane resample extent by geometry", mitk::BoolProperty::New( false ) );
+  node->AddProperty( "Image Rendering.Asynchronous", mitk::BoolProperty::New( false ), renderer, overwrite );
   node->AddProperty( "bounding box", mitk::BoolProperty::New( false ) );
 
   mitk::RenderingModeProperty::Pointer renderingModeProperty = mitk::RenderingModeProperty::New();
@@ -984,7 +1064,7 @@ void mitk::ImageVtkMapper2D::TransformActor(mitk::BaseRenderer* renderer)
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
   //get the transformation matrix of the reslicer in order to render the slice as axial, coronal or saggital
   vtkSmartPointer<vtkTransform> trans = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_Reslicer->GetResliceAxes();
+  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_DisplayedSlice.ResliceAxes;
   trans->SetMatrix(matrix);
   //transform the plane/contour (the actual actor) to the corresponding view (axial, coronal or saggital)
   localStorage->m_Actor->SetUserTransform(trans);
@@ -1055,6 +1135,7 @@ mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
   //the following actions are always the same and thus can be performed
   //in the constructor for each image (i.e. the image-corresponding local storage)
   m_TSFilter->ReleaseDataFlagOn();
+  m_mmPerPixel = m_DisplayedSlice.MmPerPixel;
 
   mitk::LookupTable::Pointer mitkLUT = mitk::LookupTable::New();
   //built a default lookuptable
@@ -0,0 +1,179 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkAsynchronousSliceGenerator.h>
+#include <mitkImageWriteAccessor.h>
+#include "vtkMitkThickSlicesFilter.h"
+
+#include <vtkImageData.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+class mitkAsynchronousSliceGeneratorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkAsynchronousSliceGeneratorTestSuite);
+  MITK_TEST(Submit_ResultEqualsSynchronousSlice);
+  MITK_TEST(Submit_OnlyLatestRequestIsKept);
+  MITK_TEST(Submit_EquivalentRequestIsIgnored);
+  MITK_TEST(Cancel_DropsResult);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::Image::Pointer m_Image;
+
+  mitk::AsynchronousSliceGenerator::Request CreateRequest(double zPosition)
+  {
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializeStandardPlane(m_Image->GetGeometry(), mitk::PlaneGeometry::Axial, zPosition);
+
+    mitk::AsynchronousSliceGenerator::Request request;
+    request.Input = m_Image;
+    request.InputMTime = m_Image->GetMTime();
+    request.WorldGeometry = plane.GetPointer();
+    request.ResliceTransformGeometry = m_Image->GetGeometry();
+    return request;
+  }
+
+  static bool WaitWhileBusy(const mitk::AsynchronousSliceGenerator& generator)
+  {
+    std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (generator.IsBusy())
+    {
+      if (std::chrono::steady_clock::now() > timeout)
+        return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  static bool SlicesAreEqual(vtkImageData* slice1, vtkImageData* slice2)
+  {
+    int* dimensions1 = slice1->GetDimensions();
+    int* dimensions2 = slice2->GetDimensions();
+    if (dimensions1[0] != dimensions2[0] || dimensions1[1] != dimensions2[1] || slice1->GetScalarType() != slice2->GetScalarType())
+      return false;
+
+    return std::memcmp(slice1->GetScalarPointer(), slice2->GetScalarPointer(),
+      dimensions1[0] * dimensions1[1] * slice1->GetScalarSize()) == 0;
+  }
+
+public:
+
+  void setUp() override
+  {
+    unsigned int dimensions[3] = { 64, 48, 16 };
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<short>(), 3, dimensions);
+
+    mitk::ImageWriteAccessor accessor(m_Image);
+    short* data = static_cast<short*>(accessor.GetData());
+    for (unsigned int i = 0; i < dimensions[0] * dimensions[1] * dimensions[2]; ++i)
+    {
+      data[i] = static_cast<short>(i % 1021);
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+  }
+
+  void Submit_ResultEqualsSynchronousSlice()
+  {
+    mitk::AsynchronousSliceGenerator generator;
+    std::atomic<int> callbacks(0);
+    generator.SetResultCallback([&callbacks]() { ++callbacks; });
+
+    mitk::AsynchronousSliceGenerator::Request request = this->CreateRequest(5.0);
+    generator.Submit(request);
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    CPPUNIT_ASSERT_EQUAL(1, callbacks.load());
+
+    mitk::AsynchronousSliceGenerator::Result result;
+    CPPUNIT_ASSERT(generator.TakeResult(result));
+    CPPUNIT_ASSERT(!generator.HasResult());
+    CPPUNIT_ASSERT(result.SourceRequest.IsEquivalent(request));
+
+    mitk::AsynchronousSliceGenerator::Result expected;
+    vtkSmartPointer<vtkMitkThickSlicesFilter> thickSlicesFilter = vtkSmartPointer<vtkMitkThickSlicesFilter>::New();
+    CPPUNIT_ASSERT(mitk::AsynchronousSliceGenerator::GenerateSlice(
+      request, mitk::ExtractSliceFilter::New(), thickSlicesFilter, expected, false));
+    CPPUNIT_ASSERT(SlicesAreEqual(expected.Slice, result.Slice));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.MmPerPixel[0], result.MmPerPixel[0], mitk::eps);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.SliceBounds[1], result.SliceBounds[1], mitk::eps);
+  }
+
+  void Submit_OnlyLatestRequestIsKept()
+  {
+    mitk::AsynchronousSliceGenerator generator;
+
+    // e.g. scrolling through all slices faster than they can be generated
+    for (int z = 0; z < 16; ++z)
+    {
+      generator.Submit(this->CreateRequest(z + 0.5));
+    }
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+
+    mitk::AsynchronousSliceGenerator::Result result;
+    CPPUNIT_ASSERT(generator.TakeResult(result));
+    CPPUNIT_ASSERT(result.SourceRequest.IsEquivalent(this->CreateRequest(15.5)));
+    CPPUNIT_ASSERT(!result.SourceRequest.IsEquivalent(this->CreateRequest(14.5)));
+  }
+
+  void Submit_EquivalentRequestIsIgnored()
+  {
+    mitk::AsynchronousSliceGenerator generator;
+    std::atomic<int> callbacks(0);
+    generator.SetResultCallback([&callbacks]() { ++callbacks; });
+
+    generator.Submit(this->CreateRequest(3.0));
+    generator.Submit(this->CreateRequest(3.0));
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    generator.Submit(this->CreateRequest(3.0));
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    CPPUNIT_ASSERT_EQUAL(1, callbacks.load());
+
+    // modified data needs a new slice
+    m_Image->Modified();
+    generator.Submit(this->CreateRequest(3.0));
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    CPPUNIT_ASSERT_EQUAL(2, callbacks.load());
+  }
+
+  void Cancel_DropsResult()
+  {
+    mitk::AsynchronousSliceGenerator generator;
+    generator.Submit(this->CreateRequest(7.0));
+    generator.Cancel();
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    CPPUNIT_ASSERT(!generator.HasResult());
+
+    generator.Submit(this->CreateRequest(7.0));
+    CPPUNIT_ASSERT(WaitWhileBusy(generator));
+    CPPUNIT_ASSERT(generator.HasResult());
+    generator.Cancel();
+    CPPUNIT_ASSERT(!generator.HasResult());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkAsynchronousSliceGenerator)
@@ -0,0 +1,263 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkStandaloneDataStorage.h>
+#include <mitkMessage.h>
+#include <mitkSurface.h>
+
+#include <sstream>
+
+class mitkDataStorageBatchTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkDataStorageBatchTestSuite);
+  MITK_TEST(CommitBatch_AddsNodesWithOneBatchEvent);
+  MITK_TEST(CommitBatch_RemovesNodesAndRelations);
+  MITK_TEST(Batch_AddAndRemoveCancelEachOther);
+  MITK_TEST(Batch_RemoveAddRemove_RemovesNode);
+  MITK_TEST(CommitBatch_NodesAddedByObserversAreNotPartOfBatch);
+  MITK_TEST(Batch_AddExistingNodeThrows);
+  MITK_TEST(Batch_Nested);
+  MITK_TEST(CommitBatch_WithoutBeginThrows);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::DataStorage::Pointer m_DataStorage;
+
+  unsigned int m_NodeEvents;
+  unsigned int m_NodeEventsDuringCommit;
+  unsigned int m_BatchEvents;
+  unsigned int m_BatchEventNodes;
+  mitk::DataNode::Pointer m_ObserverNode;
+  bool m_ObserverNodeInBatch;
+
+  void OnNode(const mitk::DataNode* node)
+  {
+    ++m_NodeEvents;
+    if (m_DataStorage->IsCommittingBatch(node))
+      ++m_NodeEventsDuringCommit;
+  }
+
+  // adds another node while the node events of a batch are emitted
+  void OnNodeAddObserverNode(const mitk::DataNode* node)
+  {
+    if (node == m_ObserverNode)
+    {
+      m_ObserverNodeInBatch = m_DataStorage->IsCommittingBatch(node);
+      return;
+    }
+    if (!m_DataStorage->Exists(m_ObserverNode))
+      m_DataStorage->Add(m_ObserverNode);
+  }
+
+  void OnNodes(const mitk::DataStorage::SetOfObjects* nodes)
+  {
+    ++m_BatchEvents;
+    m_BatchEventNodes += nodes->Size();
+  }
+
+  mitk::DataNode::Pointer CreateNode(unsigned int i)
+  {
+    std::ostringstream name;
+    name << "node " << i;
+    mitk::DataNode::Pointer node = mitk::DataNode::New();
+    node->SetName(name.str());
+    node->SetData(mitk::Surface::New());
+    return node;
+  }
+
+  void ObserveAdditions()
+  {
+    m_DataStorage->AddNodeEvent.AddListener(mitk::MessageDelegate1<mitkDataStorageBatchTestSuite, const mitk::DataNode*>(this, &mitkDataStorageBatchTestSuite::OnNode));
+    m_DataStorage->AddNodesEvent.AddListener(mitk::MessageDelegate1<mitkDataStorageBatchTestSuite, const mitk::DataStorage::SetOfObjects*>(this, &mitkDataStorageBatchTestSuite::OnNodes));
+  }
+
+  void ObserveRemovals()
+  {
+    m_DataStorage->RemoveNodeEvent.AddListener(mitk::MessageDelegate1<mitkDataStorageBatchTestSuite, const mitk::DataNode*>(this, &mitkDataStorageBatchTestSuite::OnNode));
+    m_DataStorage->RemoveNodesEvent.AddListener(mitk::MessageDelegate1<mitkDataStorageBatchTestSuite, const mitk::DataStorage::SetOfObjects*>(this, &mitkDataStorageBatchTestSuite::OnNodes));
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_DataStorage = mitk::StandaloneDataStorage::New().GetPointer();
+    m_NodeEvents = 0;
+    m_NodeEventsDuringCommit = 0;
+    m_BatchEvents = 0;
+    m_BatchEventNodes = 0;
+    m_ObserverNode = nullptr;
+    m_ObserverNodeInBatch = true;
+  }
+
+  void tearDown() override
+  {
+    m_DataStorage = nullptr;
+    m_ObserverNode = nullptr;
+  }
+
+  void CommitBatch_AddsNodesWithOneBatchEvent()
+  {
+    this->ObserveAdditions();
+    mitk::DataNode::Pointer parent = this->CreateNode(0);
+
+    m_DataStorage->BeginBatch();
+    CPPUNIT_ASSERT(m_DataStorage->IsBatchActive());
+    m_DataStorage->Add(parent);
+    for (unsigned int i = 1; i < 500; ++i)
+    {
+      m_DataStorage->Add(this->CreateNode(i), parent);
+    }
+    CPPUNIT_ASSERT_MESSAGE("Nodes are added before the batch is committed", !m_DataStorage->Exists(parent));
+    CPPUNIT_ASSERT_EQUAL(0u, m_NodeEvents);
+
+    m_DataStorage->CommitBatch();
+    CPPUNIT_ASSERT(!m_DataStorage->IsBatchActive());
+    CPPUNIT_ASSERT(!m_DataStorage->IsCommittingBatch());
+    CPPUNIT_ASSERT_EQUAL(500u, static_cast<unsigned int>(m_DataStorage->GetAll()->Size()));
+    CPPUNIT_ASSERT_EQUAL(499u, static_cast<unsigned int>(m_DataStorage->GetDerivations(parent)->Size()));
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("node 42") != nullptr);
+
+    CPPUNIT_ASSERT_EQUAL(500u, m_NodeEvents);
+    CPPUNIT_ASSERT_EQUAL(500u, m_NodeEventsDuringCommit);
+    CPPUNIT_ASSERT_EQUAL(1u, m_BatchEvents);
+    CPPUNIT_ASSERT_EQUAL(500u, m_BatchEventNodes);
+  }
+
+  void CommitBatch_RemovesNodesAndRelations()
+  {
+    mitk::DataNode::Pointer parent = this->CreateNode(0);
+    m_DataStorage->Add(parent);
+    std::vector<mitk::DataNode::Pointer> children;
+    for (unsigned int i = 1; i < 100; ++i)
+    {
+      children.push_back(this->CreateNode(i));
+      m_DataStorage->Add(children.back(), parent);
+    }
+    this->ObserveRemovals();
+
+    m_DataStorage->BeginBatch();
+    for (unsigned int i = 0; i < children.size(); i += 2)
+    {
+      m_DataStorage->Remove(children[i]);
+    }
+    CPPUNIT_ASSERT(m_DataStorage->Exists(children[0]));
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT(!m_DataStorage->Exists(children[0]));
+    CPPUNIT_ASSERT(m_DataStorage->Exists(children[1]));
+    CPPUNIT_ASSERT_EQUAL(49u, static_cast<unsigned int>(m_DataStorage->GetDerivations(parent)->Size()));
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("node 1") == nullptr);
+    CPPUNIT_ASSERT_EQUAL(50u, m_NodeEventsDuringCommit);
+    CPPUNIT_ASSERT_EQUAL(1u, m_BatchEvents);
+    CPPUNIT_ASSERT_EQUAL(50u, m_BatchEventNodes);
+  }
+
+  void Batch_AddAndRemoveCancelEachOther()
+  {
+    this->ObserveAdditions();
+    this->ObserveRemovals();
+    mitk::DataNode::Pointer node = this->CreateNode(0);
+
+    m_DataStorage->BeginBatch();
+    m_DataStorage->Add(node);
+    m_DataStorage->Remove(node);
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT(!m_DataStorage->Exists(node));
+    CPPUNIT_ASSERT_EQUAL(0u, m_NodeEvents);
+    CPPUNIT_ASSERT_EQUAL(0u, m_BatchEvents);
+  }
+
+  void Batch_RemoveAddRemove_RemovesNode()
+  {
+    mitk::DataNode::Pointer node = this->CreateNode(0);
+    m_DataStorage->Add(node);
+    this->ObserveAdditions();
+    this->ObserveRemovals();
+
+    m_DataStorage->BeginBatch();
+    m_DataStorage->Remove(node);
+    m_DataStorage->Add(node);
+    m_DataStorage->Remove(node);
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT_MESSAGE("Node is still in the storage after the last Remove()", !m_DataStorage->Exists(node));
+    CPPUNIT_ASSERT_EQUAL(1u, m_NodeEvents);
+    CPPUNIT_ASSERT_EQUAL(1u, m_BatchEvents);
+    CPPUNIT_ASSERT_EQUAL(1u, m_BatchEventNodes);
+  }
+
+  void CommitBatch_NodesAddedByObserversAreNotPartOfBatch()
+  {
+    m_ObserverNode = this->CreateNode(100);
+    m_DataStorage->AddNodeEvent.AddListener(mitk::MessageDelegate1<mitkDataStorageBatchTestSuite, const mitk::DataNode*>(this, &mitkDataStorageBatchTestSuite::OnNodeAddObserverNode));
+
+    m_DataStorage->BeginBatch();
+    m_DataStorage->Add(this->CreateNode(0));
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT(m_DataStorage->Exists(m_ObserverNode));
+    CPPUNIT_ASSERT_MESSAGE("Node added by an observer during the commit is reported as part of the batch", !m_ObserverNodeInBatch);
+  }
+
+  void Batch_AddExistingNodeThrows()
+  {
+    mitk::DataNode::Pointer node = this->CreateNode(0);
+    m_DataStorage->Add(node);
+    mitk::DataNode::Pointer queued = this->CreateNode(1);
+
+    m_DataStorage->BeginBatch();
+    CPPUNIT_ASSERT_THROW(m_DataStorage->Add(node), std::invalid_argument);
+    m_DataStorage->Add(queued);
+    CPPUNIT_ASSERT_THROW(m_DataStorage->Add(queued), std::invalid_argument);
+
+    // a node removed in the batch can be added again
+    m_DataStorage->Remove(node);
+    m_DataStorage->Add(node);
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT(m_DataStorage->Exists(node));
+    CPPUNIT_ASSERT(m_DataStorage->Exists(queued));
+  }
+
+  void Batch_Nested()
+  {
+    this->ObserveAdditions();
+
+    m_DataStorage->BeginBatch();
+    m_DataStorage->Add(this->CreateNode(0));
+    m_DataStorage->BeginBatch();
+    m_DataStorage->Add(this->CreateNode(1));
+    m_DataStorage->CommitBatch();
+    CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(m_DataStorage->GetAll()->Size()));
+    m_DataStorage->CommitBatch();
+
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetAll()->Size()));
+    CPPUNIT_ASSERT_EQUAL(1u, m_BatchEvents);
+  }
+
+  void CommitBatch_WithoutBeginThrows()
+  {
+    CPPUNIT_ASSERT_THROW(m_DataStorage->CommitBatch(), std::logic_error);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkDataStorageBatch)
@@ -0,0 +1,251 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkExtractSliceFilter.h>
+#include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkPlaneGeometry.h>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+class mitkExtractSliceFilterAxisAlignedTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkExtractSliceFilterAxisAlignedTestSuite);
+  MITK_TEST(Nearest_EqualsVtkImageReslice);
+  MITK_TEST(Linear_EqualsVtkImageReslice);
+  MITK_TEST(ResliceTransform_EqualsVtkImageReslice);
+  MITK_TEST(ImageOutput_EqualsVtkImageReslice);
+  MITK_TEST(VtkOutput_BufferIsReused);
+  MITK_TEST(Benchmark_SlicesPerSecond);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::Image::Pointer m_Image;
+
+  static mitk::Image::Pointer CreateImage(unsigned int dimX, unsigned int dimY, unsigned int dimZ)
+  {
+    unsigned int dimensions[3] = { dimX, dimY, dimZ };
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<short>(), 3, dimensions);
+
+    mitk::ImageWriteAccessor accessor(image);
+    short* data = static_cast<short*>(accessor.GetData());
+    const size_t numberOfPixels = static_cast<size_t>(dimX) * dimY * dimZ;
+    for (size_t i = 0; i < numberOfPixels; ++i)
+    {
+      data[i] = static_cast<short>(static_cast<int>((i * 7919) % 4001) - 2000);
+    }
+    return image;
+  }
+
+  mitk::PlaneGeometry::Pointer CreatePlane(mitk::PlaneGeometry::PlaneOrientation orientation, double zPosition,
+                                           bool frontside = true, bool rotated = false)
+  {
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializeStandardPlane(m_Image->GetGeometry(), orientation, zPosition, frontside, rotated);
+    return plane;
+  }
+
+  mitk::ExtractSliceFilter::Pointer CreateFilter(const mitk::PlaneGeometry* plane, bool useKernels,
+                                                 mitk::ExtractSliceFilter::ResliceInterpolation interpolation,
+                                                 bool resliceTransform = false, bool vtkOutput = true)
+  {
+    mitk::ExtractSliceFilter::Pointer filter = mitk::ExtractSliceFilter::New();
+    filter->SetInput(m_Image);
+    filter->SetWorldGeometry(plane);
+    filter->SetUseAxisAlignedKernels(useKernels);
+    filter->SetInterpolationMode(interpolation);
+    filter->SetVtkOutputRequest(vtkOutput);
+    if (resliceTransform)
+      filter->SetResliceTransformByGeometry(m_Image->GetGeometry());
+    filter->Update();
+    return filter;
+  }
+
+  static double MaximumDifference(vtkImageData* image1, vtkImageData* image2)
+  {
+    int* extent1 = image1->GetExtent();
+    int* extent2 = image2->GetExtent();
+    for (int i = 0; i < 6; ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(extent1[i], extent2[i]);
+    }
+    CPPUNIT_ASSERT_EQUAL(image1->GetScalarType(), image2->GetScalarType());
+
+    vtkDataArray* scalars1 = image1->GetPointData()->GetScalars();
+    vtkDataArray* scalars2 = image2->GetPointData()->GetScalars();
+    double maximumDifference = 0.0;
+    for (vtkIdType i = 0; i < scalars1->GetNumberOfTuples(); ++i)
+    {
+      maximumDifference = std::max(maximumDifference, std::abs(scalars1->GetTuple1(i) - scalars2->GetTuple1(i)));
+    }
+    return maximumDifference;
+  }
+
+  void CompareWithVtkImageReslice(mitk::ExtractSliceFilter::ResliceInterpolation interpolation, bool resliceTransform, double tolerance)
+  {
+    const mitk::PlaneGeometry::PlaneOrientation orientations[] = {
+      mitk::PlaneGeometry::Axial, mitk::PlaneGeometry::Frontal, mitk::PlaneGeometry::Sagittal };
+    const double zPositions[] = { 0.5, 4.3, 11.8 };
+
+    for (mitk::PlaneGeometry::PlaneOrientation orientation : orientations)
+    {
+      for (double zPosition : zPositions)
+      {
+        for (int flags = 0; flags < 4; ++flags)
+        {
+          mitk::PlaneGeometry::Pointer plane = this->CreatePlane(orientation, zPosition, (flags & 1) != 0, (flags & 2) != 0);
+          mitk::ExtractSliceFilter::Pointer kernelFilter = this->CreateFilter(plane, true, interpolation, resliceTransform);
+          mitk::ExtractSliceFilter::Pointer vtkFilter = this->CreateFilter(plane, false, interpolation, resliceTransform);
+
+          std::ostringstream message;
+          message << "orientation " << orientation << ", position " << zPosition << ", flags " << flags;
+          CPPUNIT_ASSERT_MESSAGE(message.str(),
+            MaximumDifference(kernelFilter->GetVtkOutput(), vtkFilter->GetVtkOutput()) <= tolerance);
+        }
+      }
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Image = CreateImage(40, 30, 20);
+
+    mitk::Vector3D spacing;
+    mitk::FillVector3D(spacing, 1.0, 0.8, 2.5);
+    m_Image->SetSpacing(spacing);
+
+    mitk::Point3D origin;
+    mitk::FillVector3D(origin, 10.0, -5.0, 3.0);
+    m_Image->SetOrigin(origin);
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+  }
+
+  void Nearest_EqualsVtkImageReslice()
+  {
+    this->CompareWithVtkImageReslice(mitk::ExtractSliceFilter::RESLICE_NEAREST, false, 0.0);
+  }
+
+  void Linear_EqualsVtkImageReslice()
+  {
+    // results may differ by rounding of the interpolated values
+    this->CompareWithVtkImageReslice(mitk::ExtractSliceFilter::RESLICE_LINEAR, false, 1.0);
+  }
+
+  void ResliceTransform_EqualsVtkImageReslice()
+  {
+    this->CompareWithVtkImageReslice(mitk::ExtractSliceFilter::RESLICE_NEAREST, true, 0.0);
+    this->CompareWithVtkImageReslice(mitk::ExtractSliceFilter::RESLICE_LINEAR, true, 1.0);
+  }
+
+  void ImageOutput_EqualsVtkImageReslice()
+  {
+    mitk::PlaneGeometry::Pointer plane = this->CreatePlane(mitk::PlaneGeometry::Frontal, 7.5);
+    mitk::ExtractSliceFilter::Pointer kernelFilter = this->CreateFilter(plane, true, mitk::ExtractSliceFilter::RESLICE_NEAREST, true, false);
+    mitk::ExtractSliceFilter::Pointer vtkFilter = this->CreateFilter(plane, false, mitk::ExtractSliceFilter::RESLICE_NEAREST, true, false);
+
+    mitk::Image::Pointer kernelSlice = kernelFilter->GetOutput();
+    mitk::Image::Pointer vtkSlice = vtkFilter->GetOutput();
+    CPPUNIT_ASSERT_EQUAL(vtkSlice->GetDimension(), kernelSlice->GetDimension());
+    CPPUNIT_ASSERT_EQUAL(vtkSlice->GetDimension(0), kernelSlice->GetDimension(0));
+    CPPUNIT_ASSERT_EQUAL(vtkSlice->GetDimension(1), kernelSlice->GetDimension(1));
+    CPPUNIT_ASSERT(vtkSlice->GetPixelType() == kernelSlice->GetPixelType());
+    CPPUNIT_ASSERT(mitk::Equal(*vtkSlice->GetGeometry(), *kernelSlice->GetGeometry(), mitk::eps, true));
+
+    mitk::ImageReadAccessor kernelAccessor(kernelSlice);
+    mitk::ImageReadAccessor vtkAccessor(vtkSlice);
+    CPPUNIT_ASSERT(std::memcmp(kernelAccessor.GetData(), vtkAccessor.GetData(),
+      kernelSlice->GetDimension(0) * kernelSlice->GetDimension(1) * sizeof(short)) == 0);
+  }
+
+  void VtkOutput_BufferIsReused()
+  {
+    mitk::ExtractSliceFilter::Pointer filter =
+      this->CreateFilter(this->CreatePlane(mitk::PlaneGeometry::Axial, 2.5), true, mitk::ExtractSliceFilter::RESLICE_NEAREST);
+    vtkImageData* slice = filter->GetVtkOutput();
+    const void* buffer = slice->GetScalarPointer();
+    const short firstValue = *static_cast<const short*>(buffer);
+
+    filter->SetWorldGeometry(this->CreatePlane(mitk::PlaneGeometry::Axial, 3.5));
+    filter->Update();
+    CPPUNIT_ASSERT(filter->GetVtkOutput() == slice);
+    CPPUNIT_ASSERT(slice->GetScalarPointer() == buffer);
+    CPPUNIT_ASSERT(*static_cast<const short*>(buffer) != firstValue);
+
+    // a slice of a different size needs a new buffer
+    filter->SetWorldGeometry(this->CreatePlane(mitk::PlaneGeometry::Sagittal, 3.5));
+    filter->Update();
+    CPPUNIT_ASSERT_EQUAL(30 * 20, static_cast<int>(filter->GetVtkOutput()->GetNumberOfPoints()));
+  }
+
+  void Benchmark_SlicesPerSecond()
+  {
+    const unsigned int planeSizes[] = { 512, 2048 };
+    const mitk::ExtractSliceFilter::ResliceInterpolation interpolations[] = {
+      mitk::ExtractSliceFilter::RESLICE_NEAREST, mitk::ExtractSliceFilter::RESLICE_LINEAR };
+
+    for (unsigned int planeSize : planeSizes)
+    {
+      m_Image = CreateImage(planeSize, planeSize, 4);
+      const unsigned int numberOfSlices = planeSize > 1000 ? 10 : 100;
+
+      for (mitk::ExtractSliceFilter::ResliceInterpolation interpolation : interpolations)
+      {
+        double slicesPerSecond[2];
+        for (int useKernels = 0; useKernels < 2; ++useKernels)
+        {
+          mitk::PlaneGeometry::Pointer planes[2] = {
+            this->CreatePlane(mitk::PlaneGeometry::Axial, 1.3), this->CreatePlane(mitk::PlaneGeometry::Axial, 2.6) };
+          mitk::ExtractSliceFilter::Pointer filter = this->CreateFilter(planes[0], useKernels != 0, interpolation);
+
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          for (unsigned int i = 0; i < numberOfSlices; ++i)
+          {
+            filter->SetWorldGeometry(planes[i % 2]);
+            filter->Update();
+          }
+          std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+          slicesPerSecond[useKernels] = numberOfSlices / std::max(duration.count(), 1e-9);
+        }
+
+        MITK_INFO << planeSize << "x" << planeSize << (interpolation == mitk::ExtractSliceFilter::RESLICE_LINEAR ? " linear" : " nearest")
+                  << ": vtkImageReslice " << slicesPerSecond[0] << " slices/s, axis aligned kernels "
+                  << slicesPerSecond[1] << " slices/s";
+      }
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkExtractSliceFilterAxisAligned)
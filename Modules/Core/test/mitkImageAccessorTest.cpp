@@ -220,6 +220,31 @@ int mitkImageAccessorTest(int argc, char* argv[])
      MITK_TEST_CONDITION_REQUIRED(false, "Ignoring the lock mechanism leads to exception.");
    }
 
+   // concurrent read accessors share the image part, only write accessors are exclusive
+   image->ResetContentionCounts();
+   try
+   {
+     mitk::ImageReadAccessor first(image, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+     mitk::ImageReadAccessor second(image, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+     MITK_TEST_CONDITION_REQUIRED(first.GetData() == second.GetData(), "Testing two read accessors on the same image part");
+   }
+   catch(const mitk::Exception& /*e*/)
+   {
+     MITK_TEST_CONDITION_REQUIRED(false, "Read accessors on the same image part must not lock each other.");
+   }
+   MITK_TEST_CONDITION_REQUIRED(image->GetAccessorContentionCount() == 0, "Testing that read accessors did not wait for each other");
+
+   try
+   {
+     mitk::ImageReadAccessor first(image);
+     mitk::ImageWriteAccessor second(image, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+     MITK_TEST_CONDITION_REQUIRED(false, "Write accessor must not be granted while a read accessor holds the image part.");
+   }
+   catch(const mitk::MemoryIsLockedException& /*e*/)
+   {
+   }
+   MITK_TEST_CONDITION_REQUIRED(image->GetAccessorContentionCount() == 1, "Testing the contention count of a rejected write accessor");
+
    // CREATE THREADS
 
    image->GetGeometry()->Initialize();
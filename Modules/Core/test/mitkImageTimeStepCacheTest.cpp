@@ -0,0 +1,161 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageTimeStepCache.h>
+
+class mitkImageTimeStepCacheTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageTimeStepCacheTestSuite);
+  MITK_TEST(SetPolicy_LimitsResidentVolumes);
+  MITK_TEST(GetVolumeData_RestoresEvictedVolume);
+  MITK_TEST(GetVolumeData_VolumeInUseIsNotEvicted);
+  MITK_TEST(GetChannelData_RestoresAllVolumes);
+  MITK_TEST(DisablePolicy_MakesAllVolumesResident);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  static const unsigned int m_DimX = 16;
+  static const unsigned int m_DimY = 8;
+  static const unsigned int m_DimZ = 4;
+  static const unsigned int m_DimT = 6;
+
+  mitk::Image::Pointer m_Image;
+
+  unsigned int NumberOfVolumePixels() const
+  {
+    return m_DimX * m_DimY * m_DimZ;
+  }
+
+  bool HasExpectedContent(mitk::Image::ImageDataItemPointer volume, unsigned int t) const
+  {
+    const short* data = static_cast<const short*>(volume->GetData());
+    for (unsigned int i = 0; i < this->NumberOfVolumePixels(); ++i)
+    {
+      if (data[i] != static_cast<short>(t * 1000 + i % 1000))
+        return false;
+    }
+    return true;
+  }
+
+public:
+
+  void setUp() override
+  {
+    unsigned int dimensions[4] = { m_DimX, m_DimY, m_DimZ, m_DimT };
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<short>(), 4, dimensions);
+
+    short* data = static_cast<short*>(m_Image->GetData());
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      for (unsigned int i = 0; i < this->NumberOfVolumePixels(); ++i)
+      {
+        data[t * this->NumberOfVolumePixels() + i] = static_cast<short>(t * 1000 + i % 1000);
+      }
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+  }
+
+  void SetPolicy_LimitsResidentVolumes()
+  {
+    m_Image->SetTimeStepCachePolicy(2);
+
+    const mitk::ImageTimeStepCache* cache = m_Image->GetTimeStepCache();
+    CPPUNIT_ASSERT(cache != nullptr);
+    CPPUNIT_ASSERT_EQUAL(2u, cache->GetNumberOfResidentVolumes());
+    CPPUNIT_ASSERT_EQUAL(m_DimT - 2, cache->GetNumberOfCompressedVolumes());
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Evicted volumes are still reported as set", m_Image->IsVolumeSet(t));
+    }
+  }
+
+  void GetVolumeData_RestoresEvictedVolume()
+  {
+    m_Image->SetTimeStepCachePolicy(2);
+    const mitk::ImageTimeStepCache* cache = m_Image->GetTimeStepCache();
+
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      mitk::Image::ImageDataItemPointer volume = m_Image->GetVolumeData(t);
+      CPPUNIT_ASSERT(volume.IsNotNull());
+      CPPUNIT_ASSERT_MESSAGE("Restored volume differs from the original data", this->HasExpectedContent(volume, t));
+    }
+    CPPUNIT_ASSERT(cache->GetNumberOfRestores() > 0);
+    CPPUNIT_ASSERT(cache->GetNumberOfResidentVolumes() <= 2);
+
+    // slices of evicted volumes can still be requested
+    mitk::Image::ImageDataItemPointer slice = m_Image->GetSliceData(1, 0);
+    CPPUNIT_ASSERT(slice.IsNotNull());
+    CPPUNIT_ASSERT_EQUAL(static_cast<short>(m_DimX * m_DimY), static_cast<const short*>(slice->GetData())[0]);
+  }
+
+  void GetVolumeData_VolumeInUseIsNotEvicted()
+  {
+    m_Image->SetTimeStepCachePolicy(1);
+
+    mitk::Image::ImageDataItemPointer volume = m_Image->GetVolumeData(3);
+    const void* address = volume->GetData();
+    {
+      mitk::ImageReadAccessor accessor(m_Image, m_Image->GetVolumeData(4));
+      for (unsigned int t = 0; t < m_DimT; ++t)
+      {
+        m_Image->GetVolumeData(t);
+      }
+      CPPUNIT_ASSERT(this->HasExpectedContent(m_Image->GetVolumeData(4), 4));
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Referenced volume has been evicted", m_Image->GetVolumeData(3)->GetData() == address);
+    CPPUNIT_ASSERT(this->HasExpectedContent(volume, 3));
+  }
+
+  void GetChannelData_RestoresAllVolumes()
+  {
+    m_Image->SetTimeStepCachePolicy(2);
+
+    mitk::ImageReadAccessor accessor(m_Image);
+    const short* data = static_cast<const short*>(accessor.GetData());
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      CPPUNIT_ASSERT_EQUAL(static_cast<short>(t * 1000), data[t * this->NumberOfVolumePixels()]);
+    }
+  }
+
+  void DisablePolicy_MakesAllVolumesResident()
+  {
+    m_Image->SetTimeStepCachePolicy(1);
+    m_Image->SetTimeStepCachePolicy(0, 0);
+
+    const mitk::ImageTimeStepCache* cache = m_Image->GetTimeStepCache();
+    CPPUNIT_ASSERT_EQUAL(0u, cache->GetNumberOfCompressedVolumes());
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      CPPUNIT_ASSERT(this->HasExpectedContent(m_Image->GetVolumeData(t), t));
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageTimeStepCache)
@@ -0,0 +1,154 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkIOUtil.h>
+#include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkMemoryMappedFile.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <fstream>
+
+class mitkMemoryMappedFileTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMemoryMappedFileTestSuite);
+  MITK_TEST(ScratchFile_WriteAndRead);
+  MITK_TEST(Open_UnalignedOffset);
+  MITK_TEST(Open_TooSmallFile_Throws);
+  MITK_TEST(Image_ReadOnlyMappedChannel);
+  MITK_TEST(Image_CopyOnWriteMappedChannel);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  std::string m_FileName;
+  static const unsigned int m_Header = 123; // deliberately not page aligned
+  static const unsigned int m_DimX = 16;
+  static const unsigned int m_DimY = 8;
+  static const unsigned int m_DimZ = 4;
+  static const unsigned int m_DimT = 3;
+
+  unsigned int NumberOfPixels() const
+  {
+    return m_DimX * m_DimY * m_DimZ * m_DimT;
+  }
+
+  mitk::Image::Pointer CreateMappedImage(mitk::MemoryMappedFile::AccessMode mode)
+  {
+    unsigned int dimensions[4] = { m_DimX, m_DimY, m_DimZ, m_DimT };
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<short>(), 4, dimensions);
+
+    mitk::MemoryMappedFile::Pointer file =
+      mitk::MemoryMappedFile::Open(m_FileName, m_Header, this->NumberOfPixels() * sizeof(short), mode);
+    CPPUNIT_ASSERT(image->SetMemoryMappedChannel(file));
+    return image;
+  }
+
+public:
+
+  void setUp() override
+  {
+    std::ofstream stream;
+    m_FileName = mitk::IOUtil::CreateTemporaryFile(stream, std::ios_base::out | std::ios_base::binary, "mitkMemoryMappedFileTest-XXXXXX.raw");
+    for (unsigned int i = 0; i < m_Header; ++i)
+    {
+      stream.put('#');
+    }
+    for (unsigned int i = 0; i < this->NumberOfPixels(); ++i)
+    {
+      short value = static_cast<short>(i);
+      stream.write(reinterpret_cast<const char*>(&value), sizeof(short));
+    }
+    stream.close();
+  }
+
+  void tearDown() override
+  {
+    itksys::SystemTools::RemoveFile(m_FileName.c_str());
+  }
+
+  void ScratchFile_WriteAndRead()
+  {
+    mitk::MemoryMappedFile::Pointer file = mitk::MemoryMappedFile::CreateScratchFile(1024 * 1024);
+    CPPUNIT_ASSERT(file->GetData() != nullptr);
+    CPPUNIT_ASSERT_EQUAL(1024ull * 1024ull, file->GetSize());
+    CPPUNIT_ASSERT(!file->IsReadOnly());
+
+    unsigned char* data = static_cast<unsigned char*>(file->GetData());
+    data[0] = 42;
+    data[1024 * 1024 - 1] = 43;
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(42), data[0]);
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(43), data[1024 * 1024 - 1]);
+  }
+
+  void Open_UnalignedOffset()
+  {
+    mitk::MemoryMappedFile::Pointer file =
+      mitk::MemoryMappedFile::Open(m_FileName, m_Header, this->NumberOfPixels() * sizeof(short));
+    const short* data = static_cast<const short*>(file->GetData());
+    for (unsigned int i = 0; i < this->NumberOfPixels(); ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(static_cast<short>(i), data[i]);
+    }
+  }
+
+  void Open_TooSmallFile_Throws()
+  {
+    CPPUNIT_ASSERT_THROW(mitk::MemoryMappedFile::Open(m_FileName, m_Header, this->NumberOfPixels() * sizeof(short) + 1),
+                         mitk::Exception);
+  }
+
+  void Image_ReadOnlyMappedChannel()
+  {
+    mitk::Image::Pointer image = this->CreateMappedImage(mitk::MemoryMappedFile::ReadOnly);
+
+    const unsigned int volumeSize = m_DimX * m_DimY * m_DimZ;
+    const unsigned int sliceSize = m_DimX * m_DimY;
+    for (unsigned int t = 0; t < m_DimT; ++t)
+    {
+      mitk::ImageReadAccessor volumeAccessor(image, image->GetVolumeData(t));
+      CPPUNIT_ASSERT_EQUAL(static_cast<short>(t * volumeSize), static_cast<const short*>(volumeAccessor.GetData())[0]);
+
+      mitk::ImageReadAccessor sliceAccessor(image, image->GetSliceData(2, t));
+      CPPUNIT_ASSERT_EQUAL(static_cast<short>(t * volumeSize + 2 * sliceSize), static_cast<const short*>(sliceAccessor.GetData())[0]);
+    }
+
+    CPPUNIT_ASSERT(image->GetVolumeData(1)->IsMemoryMapped());
+    CPPUNIT_ASSERT_THROW(mitk::ImageWriteAccessor(image, image->GetVolumeData(1)), mitk::Exception);
+  }
+
+  void Image_CopyOnWriteMappedChannel()
+  {
+    {
+      mitk::Image::Pointer image = this->CreateMappedImage(mitk::MemoryMappedFile::CopyOnWrite);
+      mitk::ImageWriteAccessor accessor(image, image->GetVolumeData(0));
+      static_cast<short*>(accessor.GetData())[0] = 4711;
+      CPPUNIT_ASSERT_EQUAL(static_cast<short>(4711), static_cast<short*>(accessor.GetData())[0]);
+    }
+
+    // the file itself must not have been modified
+    mitk::MemoryMappedFile::Pointer file = mitk::MemoryMappedFile::Open(m_FileName, m_Header, sizeof(short));
+    CPPUNIT_ASSERT_EQUAL(static_cast<short>(0), static_cast<const short*>(file->GetData())[0]);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMemoryMappedFile)
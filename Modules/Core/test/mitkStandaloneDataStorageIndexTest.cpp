@@ -0,0 +1,225 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkStandaloneDataStorage.h>
+#include <mitkNodePredicateAnd.h>
+#include <mitkNodePredicateDataType.h>
+#include <mitkNodePredicateNot.h>
+#include <mitkNodePredicateProperty.h>
+#include <mitkPointSet.h>
+#include <mitkProperties.h>
+#include <mitkStringProperty.h>
+#include <mitkSurface.h>
+
+#include <chrono>
+#include <sstream>
+
+class mitkStandaloneDataStorageIndexTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkStandaloneDataStorageIndexTestSuite);
+  MITK_TEST(GetNamedNode_FollowsRenaming);
+  MITK_TEST(GetSubset_DataType_FollowsSetData);
+  MITK_TEST(GetSubset_IndexedPropertyKey);
+  MITK_TEST(GetSubset_ConjunctionUsesIndex);
+  MITK_TEST(GetSubset_RemovedNodeIsNotReturned);
+  MITK_TEST(Benchmark_QueryTimeVersusNodeCount);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::StandaloneDataStorage::Pointer m_DataStorage;
+
+  mitk::DataNode::Pointer AddNode(const std::string& name, mitk::BaseData* data)
+  {
+    mitk::DataNode::Pointer node = mitk::DataNode::New();
+    node->SetName(name);
+    node->SetData(data);
+    m_DataStorage->Add(node);
+    return node;
+  }
+
+  /** Evaluates the condition for every node, as done without indices */
+  mitk::DataStorage::SetOfObjects::ConstPointer GetSubsetLinear(const mitk::NodePredicateBase* condition)
+  {
+    mitk::DataStorage::SetOfObjects::Pointer result = mitk::DataStorage::SetOfObjects::New();
+    mitk::DataStorage::SetOfObjects::ConstPointer all = m_DataStorage->GetAll();
+    for (mitk::DataStorage::SetOfObjects::ConstIterator it = all->Begin(); it != all->End(); ++it)
+    {
+      if (condition->CheckNode(it.Value()))
+        result->InsertElement(result->Size(), it.Value());
+    }
+    return result.GetPointer();
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_DataStorage = mitk::StandaloneDataStorage::New();
+  }
+
+  void tearDown() override
+  {
+    m_DataStorage = nullptr;
+  }
+
+  void GetNamedNode_FollowsRenaming()
+  {
+    mitk::DataNode::Pointer node = this->AddNode("liver", mitk::Surface::New());
+    this->AddNode("spleen", mitk::Surface::New());
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("liver") == node);
+
+    node->SetName("kidney");
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("liver") == nullptr);
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("kidney") == node);
+
+    // changing the property object directly does not modify the node
+    dynamic_cast<mitk::StringProperty*>(node->GetProperty("name"))->SetValue("pancreas");
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("kidney") == nullptr);
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("pancreas") == node);
+  }
+
+  void GetSubset_DataType_FollowsSetData()
+  {
+    mitk::DataNode::Pointer node = this->AddNode("a", mitk::Surface::New());
+    this->AddNode("b", mitk::PointSet::New());
+
+    mitk::NodePredicateDataType::Pointer isSurface = mitk::NodePredicateDataType::New("Surface");
+    mitk::NodePredicateDataType::Pointer isPointSet = mitk::NodePredicateDataType::New("PointSet");
+    CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(m_DataStorage->GetSubset(isSurface)->Size()));
+
+    node->SetData(mitk::PointSet::New());
+    CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(m_DataStorage->GetSubset(isSurface)->Size()));
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetSubset(isPointSet)->Size()));
+    CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(m_DataStorage->GetSubset(mitk::NodePredicateDataType::New("Image"))->Size()));
+  }
+
+  void GetSubset_IndexedPropertyKey()
+  {
+    mitk::DataNode::Pointer liver = this->AddNode("a", mitk::Surface::New());
+    mitk::DataNode::Pointer spleen = this->AddNode("b", mitk::Surface::New());
+    this->AddNode("c", mitk::Surface::New());
+    liver->SetStringProperty("organ", "liver");
+    spleen->SetStringProperty("organ", "spleen");
+
+    mitk::NodePredicateProperty::Pointer isLiver = mitk::NodePredicateProperty::New("organ", mitk::StringProperty::New("liver"));
+    mitk::NodePredicateProperty::Pointer hasOrgan = mitk::NodePredicateProperty::New("organ");
+
+    // not indexed yet
+    CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(m_DataStorage->GetSubset(isLiver)->Size()));
+
+    m_DataStorage->AddIndexedPropertyKey("organ");
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetIndexedPropertyKeys().size()));
+    CPPUNIT_ASSERT(m_DataStorage->GetSubset(isLiver)->GetElement(0) == liver);
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetSubset(hasOrgan)->Size()));
+
+    spleen->SetStringProperty("organ", "liver");
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetSubset(isLiver)->Size()));
+
+    // equal string representation of different property types
+    liver->GetPropertyList()->ReplaceProperty("organ", mitk::IntProperty::New(1));
+    spleen->GetPropertyList()->ReplaceProperty("organ", mitk::StringProperty::New("1"));
+    CPPUNIT_ASSERT(m_DataStorage->GetSubset(mitk::NodePredicateProperty::New("organ", mitk::IntProperty::New(1)))->GetElement(0) == liver);
+    CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(m_DataStorage->GetSubset(mitk::NodePredicateProperty::New("organ", mitk::IntProperty::New(1)))->Size()));
+
+    m_DataStorage->RemoveIndexedPropertyKey("organ");
+    CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(m_DataStorage->GetSubset(hasOrgan)->Size()));
+  }
+
+  void GetSubset_ConjunctionUsesIndex()
+  {
+    this->AddNode("target", mitk::Surface::New());
+    mitk::DataNode::Pointer pointSet = this->AddNode("target", mitk::PointSet::New());
+    this->AddNode("other", mitk::PointSet::New());
+
+    mitk::NodePredicateAnd::Pointer condition = mitk::NodePredicateAnd::New(
+      mitk::NodePredicateProperty::New("name", mitk::StringProperty::New("target")),
+      mitk::NodePredicateNot::New(mitk::NodePredicateDataType::New("Surface")));
+    mitk::DataStorage::SetOfObjects::ConstPointer result = m_DataStorage->GetSubset(condition);
+    CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(result->Size()));
+    CPPUNIT_ASSERT(result->GetElement(0) == pointSet);
+  }
+
+  void GetSubset_RemovedNodeIsNotReturned()
+  {
+    mitk::DataNode::Pointer node = this->AddNode("removed", mitk::Surface::New());
+    m_DataStorage->Remove(node);
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("removed") == nullptr);
+
+    // the removed node is not observed any more
+    node->SetName("renamed");
+    CPPUNIT_ASSERT(m_DataStorage->GetNamedNode("renamed") == nullptr);
+  }
+
+  void Benchmark_QueryTimeVersusNodeCount()
+  {
+    const unsigned int nodeCounts[] = { 100, 1000, 5000 };
+    const unsigned int numberOfQueries = 100;
+
+    for (unsigned int nodeCount : nodeCounts)
+    {
+      m_DataStorage = mitk::StandaloneDataStorage::New();
+      for (unsigned int i = 0; i < nodeCount; ++i)
+      {
+        std::ostringstream name;
+        name << "node " << i;
+        mitk::BaseData::Pointer data;
+        if (i % 10 == 0)
+          data = mitk::PointSet::New();
+        else
+          data = mitk::Surface::New();
+        this->AddNode(name.str(), data);
+      }
+
+      std::vector<mitk::NodePredicateBase::Pointer> conditions;
+      for (unsigned int i = 0; i < numberOfQueries; ++i)
+      {
+        std::ostringstream name;
+        name << "node " << (i * 7919) % nodeCount;
+        conditions.push_back(mitk::NodePredicateProperty::New("name", mitk::StringProperty::New(name.str())).GetPointer());
+      }
+      conditions.push_back(mitk::NodePredicateDataType::New("PointSet").GetPointer());
+
+      std::vector<unsigned int> linearSizes;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (const mitk::NodePredicateBase::Pointer& condition : conditions)
+      {
+        linearSizes.push_back(this->GetSubsetLinear(condition)->Size());
+      }
+      std::chrono::duration<double, std::milli> linear = std::chrono::steady_clock::now() - start;
+
+      std::vector<unsigned int> indexedSizes;
+      start = std::chrono::steady_clock::now();
+      for (const mitk::NodePredicateBase::Pointer& condition : conditions)
+      {
+        indexedSizes.push_back(m_DataStorage->GetSubset(condition)->Size());
+      }
+      std::chrono::duration<double, std::milli> indexed = std::chrono::steady_clock::now() - start;
+
+      CPPUNIT_ASSERT(linearSizes == indexedSizes);
+      MITK_INFO << nodeCount << " nodes, " << conditions.size() << " queries: linear scan " << linear.count()
+                << " ms, indexed " << indexed.count() << " ms";
+
+      mitk::DataStorage::SetOfObjects::ConstPointer pointSets = m_DataStorage->GetSubset(conditions.back());
+      CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>((nodeCount + 9) / 10), static_cast<unsigned int>(pointSets->Size()));
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkStandaloneDataStorageIndex)
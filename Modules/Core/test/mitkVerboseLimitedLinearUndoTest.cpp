@@ -44,6 +44,23 @@ public:
     g_GlobalCounter--;
   };
 };
+
+/**
+* @brief Operation that pretends to hold a lot of data, for the memory limit of the undo model
+**/
+class LargeTestOperation : public TestOperation
+{
+public:
+  LargeTestOperation(OperationType operationType)
+    : TestOperation(operationType)
+  {
+  };
+
+  virtual std::size_t GetMemorySize() const override
+  {
+    return 1000;
+  };
+};
 }//namespace
 
 
@@ -135,6 +152,30 @@ int mitkVerboseLimitedLinearUndoTest(int /* argc */, char* /*argv*/[])
   //after deleting UndoController g_GlobalCounter will still be 4 because m_CurrentUndoModel inside myUndoModel is a static singleton
   MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4,"checking singleton UndoModel");
 
+  // the memory limit drops the oldest groups
+  mitk::VerboseLimitedLinearUndo::Pointer limitedUndo = mitk::VerboseLimitedLinearUndo::New();
+  limitedUndo->SetMemoryLimit(7000);
+  for (int i = 0; i<5; i++)
+  {
+    auto  doOp = new mitk::LargeTestOperation(mitk::OpTEST);
+    auto undoOp = new mitk::LargeTestOperation(mitk::OpTEST);
+    mitk::OperationEvent *operationEvent = new mitk::OperationEvent(nullptr, doOp, undoOp, "Test");
+    limitedUndo->SetOperationEvent(operationEvent);
+    mitk::OperationEvent::IncCurrObjectEventId();
+    mitk::OperationEvent::IncCurrGroupEventId();
+  }
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4 + 6,"checking that the oldest operations are dropped at the memory limit");
+  MITK_TEST_CONDITION_REQUIRED(limitedUndo->GetUndoMemorySize() <= 7000 && limitedUndo->GetUndoMemorySize() >= 6000,"checking reported undo memory");
+
+  limitedUndo->Undo();
+  MITK_TEST_CONDITION_REQUIRED(limitedUndo->GetRedoMemorySize() >= 2000,"checking reported redo memory");
+
+  limitedUndo->SetMemoryLimit(1);
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4 + 2 + 2,"checking that the latest group is kept when lowering the limit");
+
+  limitedUndo->Clear();
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4,"checking deleting all operations of limited undo model");
+
   // always end with this!
   MITK_TEST_END()
   //operations will be deleted after terminating the application
@@ -20,6 +20,7 @@ set(CPP_FILES
   mitkThreeDnTDICOMSeriesReader.cpp
   mitkDICOMTag.cpp
   mitkDICOMTagCache.cpp
+  mitkDICOMTagCacheFile.cpp
   mitkDICOMEnums.cpp
   mitkDICOMReaderConfigurator.cpp
   mitkDICOMFileReaderSelector.cpp
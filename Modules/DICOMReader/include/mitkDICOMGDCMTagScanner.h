@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define mitkDICOMGDCMTagScanner_h
 
 #include "mitkDICOMTagCache.h"
+#include "mitkDICOMTagCacheFile.h"
 #include "mitkDICOMEnums.h"
 
 #include "mitkDICOMGDCMImageFrameInfo.h"
@@ -47,6 +48,16 @@ namespace mitk
     When used in a process where multiple classes will access the scan
     results, care should be taken that all the tags and files of interest
     are communicated to DICOMGDCMTagScanner before requesting the results!
+
+    The headers are read by a number of threads, each of them running its
+    own gdcm::Scanner on batches of files. The tag values are copied, so
+    the results do not depend on the lifetime of the gdcm::Scanner objects.
+
+    If a cache file is set (see SetCacheFilename() and
+    SetDefaultCacheFilename()), the scanned values are kept in a
+    DICOMTagCacheFile. Files whose path, size and modification time match
+    an entry of this index are not read again in subsequent scans, even
+    from other processes.
   */
   class MITKDICOMREADER_EXPORT DICOMGDCMTagScanner : public DICOMTagCache
   {
@@ -72,11 +83,36 @@ namespace mitk
       */
       virtual void SetInputFiles(const StringList& filenames);
 
+      /**
+        \brief Number of threads reading file headers, 0 (default) means one per CPU core.
+      */
+      itkSetMacro(NumberOfThreads, unsigned int);
+      itkGetConstMacro(NumberOfThreads, unsigned int);
+
+      /**
+        \brief Index file of tag values from previous scans, empty to disable caching.
+        Initialized with GetDefaultCacheFilename().
+      */
+      itkSetStringMacro(CacheFilename);
+      itkGetStringMacro(CacheFilename);
+
+      /**
+        \brief Cache file of all scanners created afterwards.
+        Initially, this is the value of the environment variable MITK_DICOM_TAG_CACHE_FILE (if set).
+      */
+      static void SetDefaultCacheFilename(const std::string& filename);
+      static std::string GetDefaultCacheFilename();
+
+      /**
+        \brief Number of files whose headers have been read by the last Scan(), i.e. which were not found in the cache.
+      */
+      itkGetConstMacro(NumberOfReadFiles, unsigned int);
+
       /**
         \brief Start the scanning process.
         Calling Scan() will invalidate previous scans, forgetting
         all about files and tags from files that have been scanned
-        previously.
+        previously. Frame infos of previous scans must not be used anymore.
       */
       virtual void Scan();
 
@@ -96,11 +132,24 @@ namespace mitk
       DICOMGDCMTagScanner(const DICOMGDCMTagScanner&);
       virtual ~DICOMGDCMTagScanner();
 
+      typedef std::map<std::string, DICOMTagCacheFile::TagValueMap> FileTagValueMap;
+
+      /**
+        \brief Reads the headers of filenames on multiple threads and stores the values in m_TagValues.
+      */
+      void ReadFiles(const StringList& filenames);
+
       std::set<DICOMTag> m_ScannedTags;
 
-      gdcm::Scanner m_GDCMScanner;
       StringList m_InputFilenames;
       DICOMGDCMImageFrameList m_ScanResult;
+
+      /// Owner of the values that the frame infos of m_ScanResult point to
+      FileTagValueMap m_TagValues;
+
+      unsigned int m_NumberOfThreads;
+      std::string m_CacheFilename;
+      unsigned int m_NumberOfReadFiles;
   };
 }
 
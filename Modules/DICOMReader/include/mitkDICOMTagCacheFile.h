@@ -0,0 +1,144 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkDICOMTagCacheFile_h
+#define mitkDICOMTagCacheFile_h
+
+#include "itkObjectFactory.h"
+#include "mitkCommon.h"
+
+#include "mitkDICOMTag.h"
+
+#include "MitkDICOMReaderExports.h"
+
+#include <map>
+#include <set>
+
+namespace mitk
+{
+
+  /**
+    \ingroup DICOMReaderModule
+    \brief On-disk index of tag values that have been scanned from DICOM files.
+
+    DICOMGDCMTagScanner uses this index to avoid reading the headers of
+    files again which have been scanned before. An entry is identified by
+    the path of a file, its size and its modification time. If any of them
+    differs, the entry is regarded as outdated.
+
+    Each entry also remembers the set of tags that have been scanned, so
+    that a tag which is not present in a file can be told apart from a tag
+    that has not been asked for.
+
+    The index is a plain text file. Save() writes a temporary file first
+    and renames it afterwards, so that concurrent readers never see a
+    partially written index.
+  */
+  class MITKDICOMREADER_EXPORT DICOMTagCacheFile : public itk::Object
+  {
+    public:
+
+      mitkClassMacroItkParent( DICOMTagCacheFile, itk::Object );
+      itkFactorylessNewMacro( DICOMTagCacheFile );
+
+      typedef std::map<DICOMTag, std::string> TagValueMap;
+      typedef std::set<DICOMTag> TagSet;
+
+      /**
+        \brief Location of the index.
+      */
+      itkSetStringMacro( Filename );
+      itkGetStringMacro( Filename );
+
+      /**
+        \brief Replaces all entries by the content of the index file.
+        A missing file results in an empty index. Returns false if the
+        file exists but could not be parsed.
+      */
+      bool Load();
+
+      /**
+        \brief Writes all entries to the index file if there are changes since the last Load() or Save().
+      */
+      bool Save();
+
+      /**
+        \brief Retrieve the values of tags for a file.
+        Returns false if there is no entry for the file with the given
+        size and modification time, or if any of tags has not been
+        scanned for this entry.
+      */
+      bool GetTagValues(const std::string& filename,
+                        unsigned long long fileSize,
+                        long long modificationTime,
+                        const TagSet& tags,
+                        TagValueMap& values) const;
+
+      /**
+        \brief Store the result of scanning tags in a file.
+        Values of tags that are missing in the file must not be contained
+        in values. An entry for the same version of the file is extended,
+        any other entry is replaced.
+      */
+      void SetTagValues(const std::string& filename,
+                        unsigned long long fileSize,
+                        long long modificationTime,
+                        const TagSet& tags,
+                        const TagValueMap& values);
+
+      /**
+        \brief Forget all entries.
+      */
+      void Clear();
+
+      unsigned int GetNumberOfEntries() const;
+
+      /**
+        \brief Size and modification time of a file as used for the keys of the index.
+        Returns false if the file does not exist.
+      */
+      static bool GetFileStatus(const std::string& filename, unsigned long long& fileSize, long long& modificationTime);
+
+    protected:
+
+      DICOMTagCacheFile();
+      virtual ~DICOMTagCacheFile();
+
+      struct Entry
+      {
+        unsigned long long FileSize;
+        long long ModificationTime;
+        TagSet ScannedTags;
+        TagValueMap Values;
+      };
+
+      typedef std::map<std::string, Entry> EntryMap;
+
+      static std::string Escape(const std::string& s);
+      static std::string Unescape(const std::string& s);
+
+      std::string m_Filename;
+      EntryMap m_Entries;
+      bool m_EntriesModified;
+
+    private:
+
+      DICOMTagCacheFile(const DICOMTagCacheFile&);
+      DICOMTagCacheFile& operator=(const DICOMTagCacheFile&);
+  };
+}
+
+#endif
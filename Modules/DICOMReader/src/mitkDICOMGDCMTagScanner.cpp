@@ -16,12 +16,50 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDICOMGDCMTagScanner.h"
 
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+  /// Number of files a thread takes at once, small enough to balance the load of the threads
+  const size_t s_FilesPerBatch = 16;
+
+  /// Serializes access to the cache files (and the default cache filename) within this process
+  std::mutex& GetCacheMutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::string& GetDefaultCacheFilenameStorage()
+  {
+    static std::string filename;
+    static bool initialized = false;
+    if ( !initialized )
+    {
+      itksys::SystemTools::GetEnv( "MITK_DICOM_TAG_CACHE_FILE", filename );
+      initialized = true;
+    }
+    return filename;
+  }
+}
+
 mitk::DICOMGDCMTagScanner::DICOMGDCMTagScanner()
+: m_NumberOfThreads( 0 )
+, m_CacheFilename( GetDefaultCacheFilename() )
+, m_NumberOfReadFiles( 0 )
 {
 }
 
 mitk::DICOMGDCMTagScanner::DICOMGDCMTagScanner( const DICOMGDCMTagScanner& other )
 : DICOMTagCache( other )
+, m_NumberOfThreads( other.m_NumberOfThreads )
+, m_CacheFilename( other.m_CacheFilename )
+, m_NumberOfReadFiles( 0 )
 {
 }
 
@@ -46,8 +84,16 @@ std::string mitk::DICOMGDCMTagScanner::GetTagValue( DICOMImageFrameInfo* frame,
     if ( std::find( m_InputFilenames.cbegin(), m_InputFilenames.cend(), frame->Filename )
          != m_InputFilenames.cend() )
     {
-      // precondition of gdcm::Scanner::GetValue() fulfilled
-      return m_GDCMScanner.GetValue( frame->Filename.c_str(), gdcm::Tag( tag.GetGroup(), tag.GetElement() ) );
+      const auto fileIter = m_TagValues.find( frame->Filename );
+      if ( fileIter != m_TagValues.cend() )
+      {
+        const auto valueIter = fileIter->second.find( tag );
+        if ( valueIter != fileIter->second.cend() )
+        {
+          return valueIter->second;
+        }
+      }
+      return std::string( "" );
     }
     else
     {
@@ -76,9 +122,7 @@ std::string mitk::DICOMGDCMTagScanner::GetTagValue( DICOMImageFrameInfo* frame,
 
 void mitk::DICOMGDCMTagScanner::AddTag( const DICOMTag& tag )
 {
-  m_ScannedTags.insert( tag );
-  m_GDCMScanner.AddTag(
-    gdcm::Tag( tag.GetGroup(), tag.GetElement() ) ); // also a set, duplicate calls to AddTag don't hurt
+  m_ScannedTags.insert( tag ); // a set, duplicate calls to AddTag don't hurt
 }
 
 void mitk::DICOMGDCMTagScanner::AddTags( const DICOMTagList& tags )
@@ -95,18 +139,151 @@ void mitk::DICOMGDCMTagScanner::SetInputFiles( const StringList& filenames )
 }
 
 
+void mitk::DICOMGDCMTagScanner::SetDefaultCacheFilename( const std::string& filename )
+{
+  std::lock_guard<std::mutex> lock( GetCacheMutex() );
+  GetDefaultCacheFilenameStorage() = filename;
+}
+
+std::string mitk::DICOMGDCMTagScanner::GetDefaultCacheFilename()
+{
+  std::lock_guard<std::mutex> lock( GetCacheMutex() );
+  return GetDefaultCacheFilenameStorage();
+}
+
+void mitk::DICOMGDCMTagScanner::ReadFiles( const StringList& filenames )
+{
+  std::vector<DICOMTagCacheFile::TagValueMap> results( filenames.size() );
+  std::atomic<size_t> nextFile( 0 );
+
+  auto readBatches = [&]()
+  {
+    gdcm::Scanner gdcmScanner;
+    for ( auto tagIter = m_ScannedTags.cbegin(); tagIter != m_ScannedTags.cend(); ++tagIter )
+    {
+      gdcmScanner.AddTag( gdcm::Tag( tagIter->GetGroup(), tagIter->GetElement() ) );
+    }
+
+    for ( size_t begin = nextFile.fetch_add( s_FilesPerBatch ); begin < filenames.size();
+          begin = nextFile.fetch_add( s_FilesPerBatch ) )
+    {
+      const size_t end = std::min( begin + s_FilesPerBatch, filenames.size() );
+      gdcmScanner.Scan( gdcm::Directory::FilenamesType( filenames.begin() + begin, filenames.begin() + end ) );
+
+      // copy the values, the next Scan() invalidates them
+      for ( size_t fileIndex = begin; fileIndex < end; ++fileIndex )
+      {
+        const gdcm::Scanner::TagToValue& mapping = gdcmScanner.GetMapping( filenames[fileIndex].c_str() );
+        for ( auto mappingIter = mapping.cbegin(); mappingIter != mapping.cend(); ++mappingIter )
+        {
+          results[fileIndex].insert( std::make_pair( DICOMTag( mappingIter->first.GetGroup(), mappingIter->first.GetElement() ),
+                                                     std::string( mappingIter->second != nullptr ? mappingIter->second : "" ) ) );
+        }
+      }
+    }
+  };
+
+  size_t numberOfThreads = m_NumberOfThreads > 0 ? m_NumberOfThreads : std::thread::hardware_concurrency();
+  numberOfThreads = std::min( numberOfThreads, ( filenames.size() + s_FilesPerBatch - 1 ) / s_FilesPerBatch );
+
+  if ( numberOfThreads <= 1 )
+  {
+    readBatches();
+  }
+  else
+  {
+    std::vector<std::thread> threads;
+    for ( size_t threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex )
+    {
+      threads.push_back( std::thread( readBatches ) );
+    }
+    for ( auto threadIter = threads.begin(); threadIter != threads.end(); ++threadIter )
+    {
+      threadIter->join();
+    }
+  }
+
+  for ( size_t fileIndex = 0; fileIndex < filenames.size(); ++fileIndex )
+  {
+    m_TagValues[filenames[fileIndex]].swap( results[fileIndex] );
+  }
+}
+
 void mitk::DICOMGDCMTagScanner::Scan()
 {
   // TODO integrate push/pop locale??
-  m_GDCMScanner.Scan( m_InputFilenames );
-
   m_ScanResult.clear();
+  m_TagValues.clear();
+
+  DICOMTagCacheFile::Pointer cacheFile;
+  if ( !m_CacheFilename.empty() )
+  {
+    std::lock_guard<std::mutex> lock( GetCacheMutex() );
+    cacheFile = DICOMTagCacheFile::New();
+    cacheFile->SetFilename( m_CacheFilename );
+    cacheFile->Load();
+  }
+
+  // everything that is not found in the cache is read from the files
+  StringList filesToRead;
+  std::map<std::string, std::pair<unsigned long long, long long>> fileStatus;
+  for ( auto inputIter = m_InputFilenames.cbegin(); inputIter != m_InputFilenames.cend(); ++inputIter )
+  {
+    if ( m_TagValues.find( *inputIter ) != m_TagValues.cend() )
+    {
+      continue; // listed twice
+    }
+
+    if ( cacheFile.IsNotNull() )
+    {
+      unsigned long long fileSize;
+      long long modificationTime;
+      if ( DICOMTagCacheFile::GetFileStatus( *inputIter, fileSize, modificationTime ) )
+      {
+        if ( cacheFile->GetTagValues( *inputIter, fileSize, modificationTime, m_ScannedTags, m_TagValues[*inputIter] ) )
+        {
+          continue;
+        }
+        fileStatus[*inputIter] = std::make_pair( fileSize, modificationTime );
+      }
+    }
+
+    m_TagValues[*inputIter]; // marks the file as handled
+    filesToRead.push_back( *inputIter );
+  }
+
+  m_NumberOfReadFiles = static_cast<unsigned int>( filesToRead.size() );
+  this->ReadFiles( filesToRead );
+
+  if ( cacheFile.IsNotNull() && !filesToRead.empty() )
+  {
+    for ( auto fileIter = filesToRead.cbegin(); fileIter != filesToRead.cend(); ++fileIter )
+    {
+      const auto statusIter = fileStatus.find( *fileIter );
+      if ( statusIter != fileStatus.cend() ) // missing files are not cached
+      {
+        cacheFile->SetTagValues( *fileIter, statusIter->second.first, statusIter->second.second, m_ScannedTags, m_TagValues[*fileIter] );
+      }
+    }
+
+    std::lock_guard<std::mutex> lock( GetCacheMutex() );
+    cacheFile->Save();
+  }
+
   m_ScanResult.reserve( m_InputFilenames.size() );
 
   for ( auto inputIter = m_InputFilenames.cbegin(); inputIter != m_InputFilenames.cend(); ++inputIter )
   {
-    m_ScanResult.push_back( DICOMGDCMImageFrameInfo::New( DICOMImageFrameInfo::New( *inputIter, 0 ),
-                                                          m_GDCMScanner.GetMapping( inputIter->c_str() ) ) );
+    // the frame info points to the values owned by m_TagValues
+    const DICOMTagCacheFile::TagValueMap& values = m_TagValues[*inputIter];
+    gdcm::Scanner::TagToValue mapping;
+    for ( auto valueIter = values.cbegin(); valueIter != values.cend(); ++valueIter )
+    {
+      mapping.insert( std::make_pair( gdcm::Tag( valueIter->first.GetGroup(), valueIter->first.GetElement() ),
+                                      valueIter->second.c_str() ) );
+    }
+
+    m_ScanResult.push_back( DICOMGDCMImageFrameInfo::New( DICOMImageFrameInfo::New( *inputIter, 0 ), mapping ) );
   }
 }
 
@@ -0,0 +1,317 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDICOMTagCacheFile.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  const char* const s_Header = "MITK DICOM tag cache 1";
+
+  bool ParseTag( const std::string& s, unsigned int& group, unsigned int& element )
+  {
+    return std::sscanf( s.c_str(), "%x,%x", &group, &element ) == 2;
+  }
+
+  void SplitLine( const std::string& line, std::vector<std::string>& fields )
+  {
+    fields.clear();
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    while ( ( end = line.find( '\t', start ) ) != std::string::npos )
+    {
+      fields.push_back( line.substr( start, end - start ) );
+      start = end + 1;
+    }
+    fields.push_back( line.substr( start ) );
+  }
+}
+
+mitk::DICOMTagCacheFile::DICOMTagCacheFile()
+:itk::Object()
+,m_EntriesModified(false)
+{
+}
+
+mitk::DICOMTagCacheFile::~DICOMTagCacheFile()
+{
+}
+
+std::string mitk::DICOMTagCacheFile::Escape( const std::string& s )
+{
+  std::string result;
+  result.reserve( s.size() );
+  for ( auto c : s )
+  {
+    switch ( c )
+    {
+      case '%':  result += "%25"; break;
+      case '\t': result += "%09"; break;
+      case '\n': result += "%0A"; break;
+      case '\r': result += "%0D"; break;
+      default:   result += c;
+    }
+  }
+  return result;
+}
+
+std::string mitk::DICOMTagCacheFile::Unescape( const std::string& s )
+{
+  std::string result;
+  result.reserve( s.size() );
+  for ( std::string::size_type i = 0; i < s.size(); ++i )
+  {
+    unsigned int code;
+    if ( s[i] == '%' && i + 2 < s.size() && std::sscanf( s.substr( i + 1, 2 ).c_str(), "%2x", &code ) == 1 )
+    {
+      result += static_cast<char>( code );
+      i += 2;
+    }
+    else
+    {
+      result += s[i];
+    }
+  }
+  return result;
+}
+
+bool mitk::DICOMTagCacheFile::GetFileStatus( const std::string& filename,
+                                             unsigned long long& fileSize,
+                                             long long& modificationTime )
+{
+  if ( !itksys::SystemTools::FileExists( filename.c_str(), true ) )
+  {
+    return false;
+  }
+
+  fileSize = itksys::SystemTools::FileLength( filename.c_str() );
+  modificationTime = itksys::SystemTools::ModifiedTime( filename.c_str() );
+  return true;
+}
+
+void mitk::DICOMTagCacheFile::Clear()
+{
+  m_EntriesModified = m_EntriesModified || !m_Entries.empty();
+  m_Entries.clear();
+}
+
+unsigned int mitk::DICOMTagCacheFile::GetNumberOfEntries() const
+{
+  return static_cast<unsigned int>( m_Entries.size() );
+}
+
+bool mitk::DICOMTagCacheFile::Load()
+{
+  m_Entries.clear();
+  m_EntriesModified = false;
+
+  std::ifstream file( m_Filename.c_str(), std::ios::binary );
+  if ( !file.is_open() )
+  {
+    // nothing cached yet
+    return !itksys::SystemTools::FileExists( m_Filename.c_str(), true );
+  }
+
+  std::string line;
+  if ( !std::getline( file, line ) || line != s_Header )
+  {
+    MITK_WARN << "Ignoring DICOM tag cache '" << m_Filename << "' of unknown format";
+    return false;
+  }
+
+  std::vector<std::string> fields;
+  Entry* currentEntry = nullptr;
+  while ( std::getline( file, line ) )
+  {
+    SplitLine( line, fields );
+    if ( fields[0] == "F" && fields.size() == 4 )
+    {
+      Entry entry;
+      std::istringstream sizeStream( fields[1] );
+      std::istringstream timeStream( fields[2] );
+      if ( !( sizeStream >> entry.FileSize ) || !( timeStream >> entry.ModificationTime ) )
+      {
+        break;
+      }
+      currentEntry = &( m_Entries[Unescape( fields[3] )] = entry );
+    }
+    else if ( fields[0] == "S" && currentEntry != nullptr )
+    {
+      unsigned int group, element;
+      for ( auto fieldIter = fields.cbegin() + 1; fieldIter != fields.cend(); ++fieldIter )
+      {
+        if ( ParseTag( *fieldIter, group, element ) )
+        {
+          currentEntry->ScannedTags.insert( DICOMTag( group, element ) );
+        }
+      }
+    }
+    else if ( fields[0] == "V" && fields.size() == 3 && currentEntry != nullptr )
+    {
+      unsigned int group, element;
+      if ( ParseTag( fields[1], group, element ) )
+      {
+        currentEntry->Values.insert( std::make_pair( DICOMTag( group, element ), Unescape( fields[2] ) ) );
+      }
+    }
+    else if ( !line.empty() )
+    {
+      break;
+    }
+  }
+
+  if ( !file.eof() )
+  {
+    MITK_WARN << "Ignoring corrupt DICOM tag cache '" << m_Filename << "'";
+    m_Entries.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool mitk::DICOMTagCacheFile::Save()
+{
+  if ( !m_EntriesModified )
+  {
+    return true;
+  }
+
+  const std::string temporaryFilename = m_Filename + ".tmp";
+  {
+    std::ofstream file( temporaryFilename.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !file.is_open() )
+    {
+      MITK_WARN << "Could not write DICOM tag cache '" << temporaryFilename << "'";
+      return false;
+    }
+
+    file << s_Header << "\n";
+    char tagString[16];
+    for ( auto entryIter = m_Entries.cbegin(); entryIter != m_Entries.cend(); ++entryIter )
+    {
+      const Entry& entry = entryIter->second;
+      file << "F\t" << entry.FileSize << "\t" << entry.ModificationTime << "\t" << Escape( entryIter->first ) << "\n";
+
+      file << "S";
+      for ( auto tagIter = entry.ScannedTags.cbegin(); tagIter != entry.ScannedTags.cend(); ++tagIter )
+      {
+        std::sprintf( tagString, "\t%04x,%04x", tagIter->GetGroup(), tagIter->GetElement() );
+        file << tagString;
+      }
+      file << "\n";
+
+      for ( auto valueIter = entry.Values.cbegin(); valueIter != entry.Values.cend(); ++valueIter )
+      {
+        std::sprintf( tagString, "%04x,%04x", valueIter->first.GetGroup(), valueIter->first.GetElement() );
+        file << "V\t" << tagString << "\t" << Escape( valueIter->second ) << "\n";
+      }
+    }
+
+    if ( !file.good() )
+    {
+      MITK_WARN << "Could not write DICOM tag cache '" << temporaryFilename << "'";
+      file.close();
+      std::remove( temporaryFilename.c_str() );
+      return false;
+    }
+  }
+
+  if ( std::rename( temporaryFilename.c_str(), m_Filename.c_str() ) != 0 )
+  {
+    // rename() does not replace existing files on all platforms
+    std::remove( m_Filename.c_str() );
+    if ( std::rename( temporaryFilename.c_str(), m_Filename.c_str() ) != 0 )
+    {
+      MITK_WARN << "Could not replace DICOM tag cache '" << m_Filename << "'";
+      std::remove( temporaryFilename.c_str() );
+      return false;
+    }
+  }
+
+  m_EntriesModified = false;
+  return true;
+}
+
+bool mitk::DICOMTagCacheFile::GetTagValues( const std::string& filename,
+                                            unsigned long long fileSize,
+                                            long long modificationTime,
+                                            const TagSet& tags,
+                                            TagValueMap& values ) const
+{
+  const auto entryIter = m_Entries.find( filename );
+  if ( entryIter == m_Entries.cend() )
+  {
+    return false;
+  }
+
+  const Entry& entry = entryIter->second;
+  if ( entry.FileSize != fileSize || entry.ModificationTime != modificationTime
+       || !std::includes( entry.ScannedTags.cbegin(), entry.ScannedTags.cend(), tags.cbegin(), tags.cend() ) )
+  {
+    return false;
+  }
+
+  values.clear();
+  for ( auto tagIter = tags.cbegin(); tagIter != tags.cend(); ++tagIter )
+  {
+    const auto valueIter = entry.Values.find( *tagIter );
+    if ( valueIter != entry.Values.cend() )
+    {
+      values.insert( *valueIter );
+    }
+  }
+
+  return true;
+}
+
+void mitk::DICOMTagCacheFile::SetTagValues( const std::string& filename,
+                                            unsigned long long fileSize,
+                                            long long modificationTime,
+                                            const TagSet& tags,
+                                            const TagValueMap& values )
+{
+  auto entryIter = m_Entries.find( filename );
+  if ( entryIter == m_Entries.end() || entryIter->second.FileSize != fileSize
+       || entryIter->second.ModificationTime != modificationTime )
+  {
+    Entry entry;
+    entry.FileSize = fileSize;
+    entry.ModificationTime = modificationTime;
+    entry.ScannedTags = tags;
+    entry.Values = values;
+    m_Entries.erase( filename );
+    m_Entries.insert( std::make_pair( filename, entry ) );
+  }
+  else
+  {
+    Entry& entry = entryIter->second;
+    entry.ScannedTags.insert( tags.cbegin(), tags.cend() );
+    for ( auto tagIter = tags.cbegin(); tagIter != tags.cend(); ++tagIter )
+    {
+      entry.Values.erase( *tagIter );
+    }
+    entry.Values.insert( values.cbegin(), values.cend() );
+  }
+
+  m_EntriesModified = true;
+}
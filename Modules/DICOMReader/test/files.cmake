@@ -1,5 +1,6 @@
 set(MODULE_TESTS
   mitkDICOMReaderConfiguratorTest.cpp
+  mitkDICOMTagCacheFileTest.cpp
 )
 
 set(MODULE_CUSTOM_TESTS
@@ -0,0 +1,104 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDICOMTagCacheFile.h"
+
+#include "mitkIOUtil.h"
+#include "mitkTestingMacros.h"
+
+#include <cstdio>
+
+/**
+  \brief Verify that DICOMTagCacheFile keeps tag values of unchanged files only.
+*/
+int mitkDICOMTagCacheFileTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkDICOMTagCacheFileTest");
+
+  const mitk::DICOMTag tagModality( 0x0008, 0x0060 );
+  const mitk::DICOMTag tagImagePositionPatient( 0x0020, 0x0032 );
+  const mitk::DICOMTag tagSeriesDescription( 0x0008, 0x103e );
+
+  mitk::DICOMTagCacheFile::TagSet scannedTags;
+  scannedTags.insert( tagModality );
+  scannedTags.insert( tagImagePositionPatient );
+  scannedTags.insert( tagSeriesDescription );
+
+  mitk::DICOMTagCacheFile::TagValueMap values;
+  values.insert( std::make_pair( tagModality, std::string( "CT" ) ) );
+  values.insert( std::make_pair( tagImagePositionPatient, std::string( "-12.5\\0\\100" ) ) );
+  // no series description in this file
+
+  const std::string indexFilename = mitk::IOUtil::CreateTemporaryFile( "DICOMTagCache-XXXXXX.txt" );
+  std::remove( indexFilename.c_str() );
+
+  mitk::DICOMTagCacheFile::Pointer cache = mitk::DICOMTagCacheFile::New();
+  cache->SetFilename( indexFilename );
+  MITK_TEST_CONDITION_REQUIRED( cache->Load(), "Missing index file results in an empty index" );
+  MITK_TEST_CONDITION_REQUIRED( cache->GetNumberOfEntries() == 0, "Empty index" );
+
+  cache->SetTagValues( "/data/study 1/img1.dcm", 1024, 42, scannedTags, values );
+  cache->SetTagValues( "/data/study 1/img\t2%.dcm", 2048, 43, scannedTags, values );
+  MITK_TEST_CONDITION_REQUIRED( cache->Save(), "Index can be saved" );
+
+  mitk::DICOMTagCacheFile::Pointer loadedCache = mitk::DICOMTagCacheFile::New();
+  loadedCache->SetFilename( indexFilename );
+  MITK_TEST_CONDITION_REQUIRED( loadedCache->Load(), "Saved index can be loaded" );
+  MITK_TEST_CONDITION( loadedCache->GetNumberOfEntries() == 2, "All entries loaded" );
+
+  mitk::DICOMTagCacheFile::TagValueMap loadedValues;
+  MITK_TEST_CONDITION( loadedCache->GetTagValues( "/data/study 1/img\t2%.dcm", 2048, 43, scannedTags, loadedValues ),
+                       "Entry with special characters in its path found" );
+  MITK_TEST_CONDITION( loadedValues == values, "Values restored, tag without value remains absent" );
+
+  MITK_TEST_CONDITION( !loadedCache->GetTagValues( "/data/study 1/img1.dcm", 1025, 42, scannedTags, loadedValues ),
+                       "Entry of file with different size is outdated" );
+  MITK_TEST_CONDITION( !loadedCache->GetTagValues( "/data/study 1/img1.dcm", 1024, 44, scannedTags, loadedValues ),
+                       "Entry of file with different modification time is outdated" );
+  MITK_TEST_CONDITION( !loadedCache->GetTagValues( "/data/study 1/img3.dcm", 1024, 42, scannedTags, loadedValues ),
+                       "No entry for unknown file" );
+
+  mitk::DICOMTagCacheFile::TagSet moreTags( scannedTags );
+  const mitk::DICOMTag tagSliceThickness( 0x0018, 0x0050 );
+  moreTags.insert( tagSliceThickness );
+  MITK_TEST_CONDITION( !loadedCache->GetTagValues( "/data/study 1/img1.dcm", 1024, 42, moreTags, loadedValues ),
+                       "Entry is not used if a tag has not been scanned" );
+
+  mitk::DICOMTagCacheFile::TagSet additionalTags;
+  additionalTags.insert( tagSliceThickness );
+  mitk::DICOMTagCacheFile::TagValueMap additionalValues;
+  additionalValues.insert( std::make_pair( tagSliceThickness, std::string( "2.5" ) ) );
+  loadedCache->SetTagValues( "/data/study 1/img1.dcm", 1024, 42, additionalTags, additionalValues );
+  MITK_TEST_CONDITION( loadedCache->GetTagValues( "/data/study 1/img1.dcm", 1024, 42, moreTags, loadedValues ),
+                       "Entry of the same file version is extended" );
+  MITK_TEST_CONDITION( loadedValues.size() == 3 && loadedValues[tagSliceThickness] == "2.5"
+                       && loadedValues[tagModality] == "CT", "Extended entry keeps previous values" );
+
+  loadedCache->SetTagValues( "/data/study 1/img1.dcm", 4096, 50, additionalTags, additionalValues );
+  MITK_TEST_CONDITION( !loadedCache->GetTagValues( "/data/study 1/img1.dcm", 4096, 50, scannedTags, loadedValues ),
+                       "Entry of a new file version replaces the previous one" );
+
+  unsigned long long fileSize = 0;
+  long long modificationTime = 0;
+  MITK_TEST_CONDITION( mitk::DICOMTagCacheFile::GetFileStatus( indexFilename, fileSize, modificationTime ) && fileSize > 0,
+                       "File status of existing file" );
+  MITK_TEST_CONDITION( !mitk::DICOMTagCacheFile::GetFileStatus( indexFilename + ".missing", fileSize, modificationTime ),
+                       "No file status of missing file" );
+
+  std::remove( indexFilename.c_str() );
+
+  MITK_TEST_END();
+}
@@ -62,6 +62,11 @@ class MITKDATATYPESEXT_EXPORT CompressedImageContainer : public itk::Object
      */
     Image::Pointer GetImage();
 
+    /**
+     * \brief Number of bytes occupied by the compressed data.
+     */
+    std::size_t GetMemorySize() const;
+
   protected:
 
     CompressedImageContainer(); // purposely hidden
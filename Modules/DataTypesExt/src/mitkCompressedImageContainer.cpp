@@ -182,3 +182,15 @@ mitk::Image::Pointer mitk::CompressedImageContainer::GetImage()
 
   return image;
 }
+
+std::size_t mitk::CompressedImageContainer::GetMemorySize() const
+{
+  std::size_t memorySize = sizeof(*this);
+  for (auto iter = m_ByteBuffers.begin();
+       iter != m_ByteBuffers.end();
+       ++iter)
+  {
+    memorySize += iter->second;
+  }
+  return memorySize;
+}
@@ -25,6 +25,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
+#include <algorithm>
+#include <chrono>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -53,6 +55,7 @@ TPDPixelType>
     , m_ResampleFibers(false)
     , m_SeedImage(NULL)
     , m_MaskImage(NULL)
+    , m_SeedBatchSize(64)
 {
     // At least 1 inputs is necessary for a vector image.
     // For images added one at a time we need at least six
@@ -105,13 +108,6 @@ TPDPixelType>
     if (m_ResampleFibers)
         m_PointPistance = 0.5*minSpacing;
 
-    m_PolyDataContainer = itk::VectorContainer< int, FiberPolyDataType >::New();
-    for (unsigned int i=0; i<this->GetNumberOfThreads(); i++)
-    {
-        FiberPolyDataType poly = FiberPolyDataType::New();
-        m_PolyDataContainer->InsertElement(i, poly);
-    }
-
     if (m_SeedImage.IsNull())
     {
         // initialize mask image
@@ -226,6 +222,54 @@ TPDPixelType>
     std::cout << "StreamlineTrackingFilter: stepsize: " << m_StepSize << " mm" << std::endl;
     std::cout << "StreamlineTrackingFilter: f: " << m_F << std::endl;
     std::cout << "StreamlineTrackingFilter: g: " << m_G << std::endl;
+    // collect the seed voxels in the order of the single threaded tracking
+    m_Seeds.clear();
+    for (int img=0; img<m_NumberOfInputs; img++)
+    {
+        ImageRegionConstIteratorWithIndex< ItkUcharImgType > sit(m_SeedImage, m_SeedImage->GetLargestPossibleRegion());
+        ImageRegionConstIterator< ItkFloatImgType > fit(m_FaImage, m_SeedImage->GetLargestPossibleRegion());
+        ImageRegionConstIterator< ItkUcharImgType > mit(m_MaskImage, m_SeedImage->GetLargestPossibleRegion());
+        for (; !sit.IsAtEnd(); ++sit, ++fit, ++mit)
+        {
+            if (sit.Value()==0 || fit.Value()<m_FaThreshold || mit.Value()==0)
+                continue;
+            TrackingSeed seed;
+            seed.m_Index = sit.GetIndex();
+            seed.m_ImageIdx = img;
+            m_Seeds.push_back(seed);
+        }
+    }
+
+    // split the seeds into batches, each thread initially owns a contiguous range of batches
+    unsigned int batchSize = std::max(m_SeedBatchSize, 1u);
+    m_SeedBatches.clear();
+    for (unsigned int i=0; i<m_Seeds.size(); i+=batchSize)
+    {
+        SeedBatch batch;
+        batch.m_FirstSeed = i;
+        batch.m_EndSeed = std::min<unsigned int>(i+batchSize, m_Seeds.size());
+        batch.m_ThreadId = 0;
+        batch.m_FirstConnectivityEntry = 0;
+        batch.m_EndConnectivityEntry = 0;
+        batch.m_NumberOfFibers = 0;
+        m_SeedBatches.push_back(batch);
+    }
+
+    unsigned int numThreads = this->GetNumberOfThreads();
+    std::vector< SeedQueue >(numThreads).swap(m_SeedQueues);
+    m_ThreadOutputs.clear();
+    m_ThreadOutputs.resize(numThreads);
+    for (unsigned int i=0; i<numThreads; i++)
+    {
+        m_SeedQueues[i].m_Front = static_cast<unsigned long long>(m_SeedBatches.size())*i/numThreads;
+        m_SeedQueues[i].m_Back = static_cast<unsigned long long>(m_SeedBatches.size())*(i+1)/numThreads;
+        m_ThreadOutputs[i].m_Points = vtkSmartPointer< vtkPoints >::New();
+        m_ThreadOutputs[i].m_NumberOfStreamlines = 0;
+        m_ThreadOutputs[i].m_NumberOfStolenBatches = 0;
+        m_ThreadOutputs[i].m_TrackingTime = 0;
+    }
+
+    std::cout << "StreamlineTrackingFilter: " << m_Seeds.size() << " seed voxels in " << m_SeedBatches.size() << " batches" << std::endl;
     std::cout << "StreamlineTrackingFilter: starting streamline tracking using " << this->GetNumberOfThreads() << " threads." << std::endl;
 }
 
@@ -729,140 +773,156 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
     return tractLength;
 }
 
-template< class TTensorPixelType,
-          class TPDPixelType>
-void StreamlineTrackingFilter< TTensorPixelType,
-TPDPixelType>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
-                       ThreadIdType threadId)
+template< class TTensorPixelType, class TPDPixelType>
+bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GetNextBatch(ThreadIdType threadId, unsigned int& batch)
 {
-    FiberPolyDataType poly = m_PolyDataContainer->GetElement(threadId);
-    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> Cells = vtkSmartPointer<vtkCellArray>::New();
-
-    typedef itk::DiffusionTensor3D<TTensorPixelType>        TensorType;
-    typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-    typedef ImageRegionConstIterator< ItkUcharImgType >     MaskIteratorType;
-    typedef ImageRegionConstIterator< ItkFloatImgType >     doubleIteratorType;
-    typedef typename InputImageType::PixelType              InputTensorType;
-
-    MaskIteratorType    sit(m_SeedImage, outputRegionForThread );
-    doubleIteratorType   fit(m_FaImage, outputRegionForThread );
-    MaskIteratorType    mit(m_MaskImage, outputRegionForThread );
+    SeedQueue& ownQueue = m_SeedQueues.at(threadId);
+    {
+        std::lock_guard<std::mutex> lock(ownQueue.m_Mutex);
+        if (ownQueue.m_Front<ownQueue.m_Back)
+        {
+            batch = ownQueue.m_Front++;
+            return true;
+        }
+    }
 
-    for (int img=0; img<m_NumberOfInputs; img++)
+    // steal the back half of the fullest queue
+    while (true)
     {
-        sit.GoToBegin();
-        mit.GoToBegin();
-        fit.GoToBegin();
-        itk::Point<double> worldPos;
-        while( !sit.IsAtEnd() )
+        unsigned int victim = 0;
+        unsigned int maxRemaining = 0;
+        for (unsigned int i=0; i<m_SeedQueues.size(); i++)
         {
-            if (sit.Value()==0 || fit.Value()<m_FaThreshold || mit.Value()==0)
+            std::lock_guard<std::mutex> lock(m_SeedQueues[i].m_Mutex);
+            if (m_SeedQueues[i].m_Back-m_SeedQueues[i].m_Front > maxRemaining)
             {
-                ++sit;
-                ++mit;
-                ++fit;
-                continue;
+                maxRemaining = m_SeedQueues[i].m_Back-m_SeedQueues[i].m_Front;
+                victim = i;
             }
+        }
+        if (maxRemaining==0)
+            return false;
 
-            for (int s=0; s<m_SeedsPerVoxel; s++)
-            {
-                vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
-                std::vector< vtkIdType > pointIDs;
-                typename InputImageType::IndexType index = sit.GetIndex();
-                itk::ContinuousIndex<double, 3> start;
-                unsigned int counter = 0;
+        unsigned int first, end;
+        {
+            std::lock_guard<std::mutex> lock(m_SeedQueues[victim].m_Mutex);
+            SeedQueue& victimQueue = m_SeedQueues[victim];
+            if (victimQueue.m_Front>=victimQueue.m_Back)
+                continue;   // emptied in the meantime
+            end = victimQueue.m_Back;
+            first = victimQueue.m_Back - (victimQueue.m_Back-victimQueue.m_Front+1)/2;
+            victimQueue.m_Back = first;
+        }
 
-                if (m_SeedsPerVoxel>1)
-                {
-                    start[0] = index[0]+(double)(rand()%99-49)/100;
-                    start[1] = index[1]+(double)(rand()%99-49)/100;
-                    start[2] = index[2]+(double)(rand()%99-49)/100;
-                }
-                else
-                {
-                    start[0] = index[0];
-                    start[1] = index[1];
-                    start[2] = index[2];
-                }
+        m_ThreadOutputs[threadId].m_NumberOfStolenBatches += end-first;
+        std::lock_guard<std::mutex> lock(ownQueue.m_Mutex);
+        ownQueue.m_Front = first+1;
+        ownQueue.m_Back = end;
+        batch = first;
+        return true;
+    }
+}
 
-                // forward tracking
-                double tractLength = FollowStreamline(start, 1, points, pointIDs, img);
+template< class TTensorPixelType, class TPDPixelType>
+void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::TrackBatch(SeedBatch& batch, ThreadIdType threadId)
+{
+    ThreadOutput& output = m_ThreadOutputs[threadId];
+    vtkPoints* points = output.m_Points;
+    std::vector< vtkIdType >& connectivity = output.m_Connectivity;
 
-                // add ids to line
-                counter += pointIDs.size();
-                while (!pointIDs.empty())
-                {
-                    line->GetPointIds()->InsertNextId(pointIDs.back());
-                    pointIDs.pop_back();
-                }
+    batch.m_ThreadId = threadId;
+    batch.m_FirstConnectivityEntry = connectivity.size();
+    batch.m_NumberOfFibers = 0;
 
-                // insert start point
-                m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
-                line->GetPointIds()->InsertNextId(points->InsertNextPoint(worldPos.GetDataPointer()));
+    itk::Point<double> worldPos;
+    std::vector< vtkIdType > pointIDs;
+    for (unsigned int seedIdx=batch.m_FirstSeed; seedIdx<batch.m_EndSeed; seedIdx++)
+    {
+        const TrackingSeed& seed = m_Seeds[seedIdx];
+        const typename InputImageType::IndexType& index = seed.m_Index;
 
-                // backward tracking
-                tractLength += FollowStreamline(start, -1, points, pointIDs, img);
+        for (int s=0; s<m_SeedsPerVoxel; s++)
+        {
+            itk::ContinuousIndex<double, 3> start;
+            unsigned int counter = 0;
 
-                counter += pointIDs.size();
+            if (m_SeedsPerVoxel>1)
+            {
+                start[0] = index[0]+(double)(rand()%99-49)/100;
+                start[1] = index[1]+(double)(rand()%99-49)/100;
+                start[2] = index[2]+(double)(rand()%99-49)/100;
+            }
+            else
+            {
+                start[0] = index[0];
+                start[1] = index[1];
+                start[2] = index[2];
+            }
 
-                //MITK_INFO << "Tract length " << tractLength;
+            // the number of points is set when the fiber is complete
+            std::size_t lineStart = connectivity.size();
+            connectivity.push_back(0);
 
-                if (tractLength<m_MinTractLength || counter<2)
-                    continue;
+            // forward tracking
+            pointIDs.clear();
+            double tractLength = FollowStreamline(start, 1, points, pointIDs, seed.m_ImageIdx);
 
-                // add ids to line
-                for (unsigned int i=0; i<pointIDs.size(); i++)
-                    line->GetPointIds()->InsertNextId(pointIDs.at(i));
+            // add ids to line
+            counter += pointIDs.size();
+            while (!pointIDs.empty())
+            {
+                connectivity.push_back(pointIDs.back());
+                pointIDs.pop_back();
+            }
 
-                Cells->InsertNextCell(line);
+            // insert start point
+            m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
+            connectivity.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+
+            // backward tracking
+            tractLength += FollowStreamline(start, -1, points, pointIDs, seed.m_ImageIdx);
+
+            counter += pointIDs.size();
+
+            if (tractLength<m_MinTractLength || counter<2)
+            {
+                connectivity.resize(lineStart);
+                continue;
             }
-            ++sit;
-            ++mit;
-            ++fit;
+
+            // add ids to line
+            connectivity.insert(connectivity.end(), pointIDs.begin(), pointIDs.end());
+            connectivity[lineStart] = connectivity.size()-lineStart-1;
+            batch.m_NumberOfFibers++;
         }
     }
-    poly->SetPoints(points);
-    poly->SetLines(Cells);
 
-    std::cout << "Thread " << threadId << " finished tracking" << std::endl;
+    batch.m_EndConnectivityEntry = connectivity.size();
+    output.m_NumberOfStreamlines += batch.m_NumberOfFibers;
 }
 
 template< class TTensorPixelType,
           class TPDPixelType>
-vtkSmartPointer< vtkPolyData > StreamlineTrackingFilter< TTensorPixelType,
+void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2)
+::ThreadedGenerateData(const OutputImageRegionType&,
+                       ThreadIdType threadId)
 {
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = poly1->GetLines();
-    vtkSmartPointer<vtkPoints> vNewPoints = poly1->GetPoints();
+    // the seeds are distributed by the batch queues, the image region of the thread is not used
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 
-    for( int i=0; i<poly2->GetNumberOfLines(); i++ )
-    {
-        vtkCell* cell = poly2->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    unsigned int batch;
+    while (GetNextBatch(threadId, batch))
+        TrackBatch(m_SeedBatches[batch], threadId);
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double p[3];
-            points->GetPoint(j, p);
+    ThreadOutput& output = m_ThreadOutputs[threadId];
+    output.m_TrackingTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-startTime).count();
 
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vNewLines->InsertNextCell(container);
-    }
-
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
-
-    return vNewPolyData;
+    std::cout << "Thread " << threadId << " finished tracking" << std::endl;
 }
+
 template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
@@ -870,14 +930,91 @@ TPDPixelType>
 ::AfterThreadedGenerateData()
 {
     MITK_INFO << "Generating polydata ";
-    m_FiberPolyData = m_PolyDataContainer->GetElement(0);
-    for (unsigned int i=1; i<this->GetNumberOfThreads(); i++)
+
+    // the fibers of all batches are copied once into preallocated arrays, in the order of the seeds
+    vtkIdType numFibers = 0;
+    vtkIdType numPoints = 0;
+    for (unsigned int i=0; i<m_SeedBatches.size(); i++)
+    {
+        numFibers += m_SeedBatches[i].m_NumberOfFibers;
+        numPoints += m_SeedBatches[i].m_EndConnectivityEntry-m_SeedBatches[i].m_FirstConnectivityEntry-m_SeedBatches[i].m_NumberOfFibers;
+    }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(numPoints);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(numFibers+numPoints);
+
+    vtkIdType* ids = connectivity->GetPointer(0);
+    vtkIdType pointId = 0;
+    double p[3];
+    for (unsigned int i=0; i<m_SeedBatches.size(); i++)
+    {
+        const SeedBatch& batch = m_SeedBatches[i];
+        const ThreadOutput& output = m_ThreadOutputs[batch.m_ThreadId];
+        std::size_t entry = batch.m_FirstConnectivityEntry;
+        while (entry<batch.m_EndConnectivityEntry)
+        {
+            vtkIdType numFiberPoints = output.m_Connectivity[entry++];
+            *ids++ = numFiberPoints;
+            for (vtkIdType j=0; j<numFiberPoints; j++)
+            {
+                output.m_Points->GetPoint(output.m_Connectivity[entry++], p);
+                points->SetPoint(pointId, p);
+                *ids++ = pointId++;
+            }
+        }
+    }
+
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    cells->SetCells(numFibers, connectivity);
+
+    m_FiberPolyData = FiberPolyDataType::New();
+    m_FiberPolyData->SetPoints(points);
+    m_FiberPolyData->SetLines(cells);
+
+    // keep the statistics, release the buffers
+    for (unsigned int i=0; i<m_ThreadOutputs.size(); i++)
     {
-        m_FiberPolyData = AddPolyData(m_FiberPolyData, m_PolyDataContainer->GetElement(i));
+        m_ThreadOutputs[i].m_Points = nullptr;
+        std::vector< vtkIdType >().swap(m_ThreadOutputs[i].m_Connectivity);
     }
+    std::vector< TrackingSeed >().swap(m_Seeds);
+    std::vector< SeedBatch >().swap(m_SeedBatches);
+
     MITK_INFO << "done";
 }
 
+template< class TTensorPixelType, class TPDPixelType>
+std::vector< unsigned int > StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GetNumberOfStreamlinesPerThread() const
+{
+    std::vector< unsigned int > result;
+    for (unsigned int i=0; i<m_ThreadOutputs.size(); i++)
+        result.push_back(m_ThreadOutputs[i].m_NumberOfStreamlines);
+    return result;
+}
+
+template< class TTensorPixelType, class TPDPixelType>
+std::vector< double > StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GetTrackingTimePerThread() const
+{
+    std::vector< double > result;
+    for (unsigned int i=0; i<m_ThreadOutputs.size(); i++)
+        result.push_back(m_ThreadOutputs[i].m_TrackingTime);
+    return result;
+}
+
+template< class TTensorPixelType, class TPDPixelType>
+std::vector< unsigned int > StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GetNumberOfStolenBatchesPerThread() const
+{
+    std::vector< unsigned int > result;
+    for (unsigned int i=0; i<m_ThreadOutputs.size(); i++)
+        result.push_back(m_ThreadOutputs[i].m_NumberOfStolenBatches);
+    return result;
+}
+
 template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
@@ -32,11 +32,18 @@ This file is based heavily on a corresponding ITK filter.
 #include <vtkCellArray.h>
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
+#include <mutex>
+#include <vector>
 
 namespace itk{
 
 /**
-* \brief Performes deterministic streamline tracking on the input tensor image.   */
+* \brief Performes deterministic streamline tracking on the input tensor image.
+*
+* The seeds are distributed to the threads in batches. Each thread owns a queue of batches and steals
+* batches from the other queues when its own queue is empty, so threads finishing early keep working
+* regardless of where the white matter is located. The fibers of each batch are merged in seed order,
+* the result does not depend on the number of threads.   */
 
   template< class TTensorPixelType, class TPDPixelType=double>
   class StreamlineTrackingFilter :
@@ -84,6 +91,15 @@ namespace itk{
     itkSetMacro( MinCurvatureRadius, double )            ///< Tracking is stopped if curvature radius (in mm) is too small.
     itkGetMacro( MinCurvatureRadius, double )
     itkSetMacro( ResampleFibers, bool )                 ///< If enabled, the resulting fibers are resampled to feature point distances of 0.5*MinSpacing. This is recommendable for very short integration steps and many seeds. If disabled, the resulting fiber bundle might become very large.
+    itkSetMacro( SeedBatchSize, unsigned int )          ///< Number of seed voxels processed by a thread at once.
+    itkGetMacro( SeedBatchSize, unsigned int )
+
+    /** \brief Number of streamlines generated by each thread during the last update. */
+    std::vector< unsigned int > GetNumberOfStreamlinesPerThread() const;
+    /** \brief Tracking time in seconds of each thread during the last update. */
+    std::vector< double > GetTrackingTimePerThread() const;
+    /** \brief Number of seed batches each thread took from the queues of other threads during the last update. */
+    std::vector< unsigned int > GetNumberOfStolenBatchesPerThread() const;
 
   protected:
     StreamlineTrackingFilter();
@@ -99,7 +115,43 @@ namespace itk{
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
     void AfterThreadedGenerateData();
 
-    FiberPolyDataType AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2);    ///< Combine tracking results generated by the individual threads.
+    struct TrackingSeed
+    {
+        typename InputImageType::IndexType  m_Index;
+        int                                 m_ImageIdx;
+    };
+
+    /** \brief Seeds [m_FirstSeed, m_EndSeed) and the location of the resulting fibers in the buffer of the thread that processed them. */
+    struct SeedBatch
+    {
+        unsigned int    m_FirstSeed;
+        unsigned int    m_EndSeed;
+        ThreadIdType    m_ThreadId;
+        std::size_t     m_FirstConnectivityEntry;
+        std::size_t     m_EndConnectivityEntry;
+        unsigned int    m_NumberOfFibers;
+    };
+
+    /** \brief Batches [m_Front, m_Back) are not processed yet. The owner takes from the front, other threads steal from the back. */
+    struct SeedQueue
+    {
+        unsigned int    m_Front;
+        unsigned int    m_Back;
+        std::mutex      m_Mutex;
+    };
+
+    /** \brief Fibers of one thread. The connectivity holds the number of points followed by the point ids of each fiber. */
+    struct ThreadOutput
+    {
+        vtkSmartPointer<vtkPoints>  m_Points;
+        std::vector< vtkIdType >    m_Connectivity;
+        unsigned int                m_NumberOfStreamlines;
+        unsigned int                m_NumberOfStolenBatches;
+        double                      m_TrackingTime;
+    };
+
+    bool GetNextBatch(ThreadIdType threadId, unsigned int& batch);   ///< Take a batch from the own queue or steal one from another thread.
+    void TrackBatch(SeedBatch& batch, ThreadIdType threadId);       ///< Track all seeds of the batch and store the fibers in the thread output.
 
     FiberPolyDataType               m_FiberPolyData;
     vtkSmartPointer<vtkPoints>      m_Points;
@@ -127,7 +179,11 @@ namespace itk{
     ItkUcharImgType::Pointer    m_SeedImage;
     ItkUcharImgType::Pointer    m_MaskImage;
 
-    itk::VectorContainer< int, FiberPolyDataType >::Pointer m_PolyDataContainer;
+    unsigned int                    m_SeedBatchSize;
+    std::vector< TrackingSeed >     m_Seeds;
+    std::vector< SeedBatch >        m_SeedBatches;
+    std::vector< SeedQueue >        m_SeedQueues;
+    std::vector< ThreadOutput >     m_ThreadOutputs;
 
   private:
 
@@ -45,6 +45,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTransferFunction.h>
 #include <vtkLookupTable.h>
 #include <mitkLookupTable.h>
+#include <algorithm>
 
 const char* mitk::FiberBundle::FIBER_ID_ARRAY = "Fiber_IDs";
 
@@ -280,6 +281,7 @@ void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, b
     }
 
     m_NumFibers = m_FiberPolyData->GetNumberOfLines();
+    m_SegmentIndex = nullptr;
 
     if (updateGeometry)
         UpdateFiberGeometry();
@@ -974,48 +976,69 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
     }
     else if ( dynamic_cast<mitk::PlanarFigure*>(roi->GetData()) )  // actual extraction
     {
+        std::vector<long> candidateFibers;
+        std::vector<unsigned int> candidateOffsets;
+        std::vector<unsigned int> candidateSegments;
+        std::vector<unsigned char> inRoi;
+
         if ( dynamic_cast<mitk::PlanarPolygon*>(roi->GetData()) )
         {
             mitk::PlanarFigure::Pointer planarPoly = dynamic_cast<mitk::PlanarFigure*>(roi->GetData());
+            if (planarPoly->GetNumberOfControlPoints()==0)
+                return result;
+            double tolerance = 0.001;
 
-            //create vtkPolygon using controlpoints from planarFigure polygon
-            vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
+            // only segments close to the polygon can intersect it
+            std::vector< itk::Point<double,3> > controlPoints;
+            double bounds[6];
             for (unsigned int i=0; i<planarPoly->GetNumberOfControlPoints(); ++i)
             {
                 itk::Point<double,3> p = planarPoly->GetWorldControlPoint(i);
-                vtkIdType id = polygonVtk->GetPoints()->InsertNextPoint(p[0], p[1], p[2] );
-                polygonVtk->GetPointIds()->InsertNextId(id);
+                controlPoints.push_back(p);
+                for (int d=0; d<3; ++d)
+                {
+                    bounds[2*d] = i==0 ? p[d]-tolerance : std::min(bounds[2*d], p[d]-tolerance);
+                    bounds[2*d+1] = i==0 ? p[d]+tolerance : std::max(bounds[2*d+1], p[d]+tolerance);
+                }
             }
 
             MITK_INFO << "Extracting with polygon";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
-            {
-                ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
-                int numPoints = cell->GetNumberOfPoints();
-                vtkPoints* points = cell->GetPoints();
+            this->GetSegmentIndex()->GetCandidateSegments(bounds, candidateFibers, candidateOffsets, candidateSegments);
+            inRoi.assign(candidateFibers.size(), 0);
 
-                for (int j=0; j<numPoints-1; j++)
+#pragma omp parallel
+            {
+                // vtkPolygon uses internal buffers, every thread needs its own copy
+                vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
+                for (unsigned int i=0; i<controlPoints.size(); ++i)
                 {
-                    // Inputs
-                    double p1[3] = {0,0,0};
-                    points->GetPoint(j, p1);
-                    double p2[3] = {0,0,0};
-                    points->GetPoint(j+1, p2);
-                    double tolerance = 0.001;
-
-                    // Outputs
-                    double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-                    double x[3] = {0,0,0}; // The coordinate of the intersection
-                    double pcoords[3] = {0,0,0};
-                    int subId = 0;
+                    const itk::Point<double,3>& p = controlPoints[i];
+                    vtkIdType id = polygonVtk->GetPoints()->InsertNextPoint(p[0], p[1], p[2] );
+                    polygonVtk->GetPointIds()->InsertNextId(id);
+                }
 
-                    int iD = polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId);
-                    if (iD!=0)
+#pragma omp for schedule(dynamic, 64)
+                for (long i=0; i<static_cast<long>(candidateFibers.size()); i++)
+                {
+                    for (unsigned int j=candidateOffsets[i]; j<candidateOffsets[i+1]; j++)
                     {
-                        result.push_back(i);
-                        break;
+                        // Inputs
+                        double p1[3] = {0,0,0};
+                        double p2[3] = {0,0,0};
+                        m_SegmentIndex->GetSegment(candidateSegments[j], p1, p2);
+
+                        // Outputs
+                        double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+                        double x[3] = {0,0,0}; // The coordinate of the intersection
+                        double pcoords[3] = {0,0,0};
+                        int subId = 0;
+
+                        int iD = polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId);
+                        if (iD!=0)
+                        {
+                            inRoi[i] = 1;
+                            break;
+                        }
                     }
                 }
             }
@@ -1031,24 +1054,29 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
             mitk::Point3D V2w  = planarFigure->GetWorldControlPoint(1); //radiusPoint
 
             double radius = V1w.EuclideanDistanceTo(V2w);
+
+            // only segments within the bounding box of the circle can intersect it
+            double bounds[6];
+            for (int d=0; d<3; ++d)
+            {
+                bounds[2*d] = V1w[d]-radius;
+                bounds[2*d+1] = V1w[d]+radius;
+            }
             radius *= radius;
 
             MITK_INFO << "Extracting with circle";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
-            {
-                ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
-                int numPoints = cell->GetNumberOfPoints();
-                vtkPoints* points = cell->GetPoints();
+            this->GetSegmentIndex()->GetCandidateSegments(bounds, candidateFibers, candidateOffsets, candidateSegments);
+            inRoi.assign(candidateFibers.size(), 0);
 
-                for (int j=0; j<numPoints-1; j++)
+#pragma omp parallel for schedule(dynamic, 64)
+            for (long i=0; i<static_cast<long>(candidateFibers.size()); i++)
+            {
+                for (unsigned int j=candidateOffsets[i]; j<candidateOffsets[i+1]; j++)
                 {
                     // Inputs
                     double p1[3] = {0,0,0};
-                    points->GetPoint(j, p1);
                     double p2[3] = {0,0,0};
-                    points->GetPoint(j+1, p2);
+                    m_SegmentIndex->GetSegment(candidateSegments[j], p1, p2);
 
                     // Outputs
                     double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
@@ -1061,21 +1089,39 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
                         double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
                         if( dist <= radius)
                         {
-                            result.push_back(i);
+                            inRoi[i] = 1;
                             break;
                         }
                     }
                 }
             }
         }
+
+        // candidates are sorted by fiber id
+        for (unsigned int i=0; i<candidateFibers.size(); i++)
+            if (inRoi[i])
+                result.push_back(candidateFibers[i]);
+
         return result;
     }
 
     return result;
 }
 
+mitk::FiberBundleSegmentIndex* mitk::FiberBundle::GetSegmentIndex()
+{
+    if (m_SegmentIndex.IsNull())
+    {
+        m_SegmentIndex = mitk::FiberBundleSegmentIndex::New();
+        m_SegmentIndex->Build(m_FiberPolyData);
+    }
+    return m_SegmentIndex;
+}
+
 void mitk::FiberBundle::UpdateFiberGeometry()
 {
+    m_SegmentIndex = nullptr;
+
     vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
     cleaner->SetInputData(m_FiberPolyData);
     cleaner->PointMergingOff();
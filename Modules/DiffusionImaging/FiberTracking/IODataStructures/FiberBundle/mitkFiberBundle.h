@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlanarFigure.h>
 #include <mitkPixelTypeTraits.h>
 #include <mitkPlanarFigureComposite.h>
+#include <mitkFiberBundleSegmentIndex.h>
 
 
 //includes storing fiberdata
@@ -102,6 +103,9 @@ public:
     FiberBundle::Pointer           ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert=false, bool bothEnds=true);
     FiberBundle::Pointer           RemoveFibersOutside(ItkUcharImgType* mask, bool invert=false);
 
+    /** \brief Spatial index of the fiber segments used by the planar figure based extraction. Built on first use and discarded when the fibers change. */
+    FiberBundleSegmentIndex*        GetSegmentIndex();
+
     vtkSmartPointer<vtkPolyData>    GeneratePolyDataByIds( std::vector<long> ); // TODO: make protected
     void                            GenerateFiberIds(); // TODO: make protected
 
@@ -170,6 +174,7 @@ private:
     itk::TimeStamp m_UpdateTime2D;
     itk::TimeStamp m_UpdateTime3D;
     mitk::BaseGeometry::Pointer m_ReferenceGeometry;
+    FiberBundleSegmentIndex::Pointer m_SegmentIndex;
 };
 
 } // namespace mitk
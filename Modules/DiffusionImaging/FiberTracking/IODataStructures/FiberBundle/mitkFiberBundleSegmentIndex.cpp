@@ -0,0 +1,224 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBundleSegmentIndex.h"
+
+#include <mitkExceptionMacro.h>
+
+#include <vtkCellArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // upper limit of grid cells per axis
+    const int MaxGridDimension = 1024;
+}
+
+mitk::FiberBundleSegmentIndex::FiberBundleSegmentIndex()
+    : m_NumberOfSegments(0)
+    , m_CellSize(1.0)
+{
+    m_Origin[0] = m_Origin[1] = m_Origin[2] = 0.0;
+    m_Dimensions[0] = m_Dimensions[1] = m_Dimensions[2] = 0;
+}
+
+mitk::FiberBundleSegmentIndex::~FiberBundleSegmentIndex()
+{
+
+}
+
+void mitk::FiberBundleSegmentIndex::Build(vtkPolyData* fiberPolyData, double segmentsPerCell)
+{
+    m_Points = nullptr;
+    m_PointIds.clear();
+    m_FiberPointOffsets.clear();
+    m_FiberSegmentOffsets.clear();
+    m_CellOffsets.clear();
+    m_CellSegments.clear();
+    m_NumberOfSegments = 0;
+    m_Dimensions[0] = m_Dimensions[1] = m_Dimensions[2] = 0;
+    this->Modified();
+
+    if (fiberPolyData==nullptr || fiberPolyData->GetPoints()==nullptr || fiberPolyData->GetLines()==nullptr)
+        return;
+
+    m_Points = fiberPolyData->GetPoints();
+
+    // copy the connectivity, the cell array of the poly data is not safe for concurrent traversal
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    m_PointIds.reserve(lines->GetNumberOfConnectivityEntries());
+    m_FiberPointOffsets.reserve(lines->GetNumberOfCells()+1);
+    m_FiberSegmentOffsets.reserve(lines->GetNumberOfCells()+1);
+
+    unsigned long long numberOfSegments = 0;
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    lines->InitTraversal();
+    while (lines->GetNextCell(numPoints, pointIds))
+    {
+        m_FiberPointOffsets.push_back(m_PointIds.size());
+        m_FiberSegmentOffsets.push_back(numberOfSegments);
+        m_PointIds.insert(m_PointIds.end(), pointIds, pointIds+numPoints);
+        if (numPoints>1)
+            numberOfSegments += numPoints-1;
+    }
+    m_FiberPointOffsets.push_back(m_PointIds.size());
+    m_FiberSegmentOffsets.push_back(numberOfSegments);
+
+    if (numberOfSegments >= std::numeric_limits<unsigned int>::max())
+        mitkThrow() << "Too many fiber segments for the segment index: " << numberOfSegments;
+    m_NumberOfSegments = numberOfSegments;
+
+    if (m_NumberOfSegments==0)
+        return;
+
+    // choose a cubic cell size that results in about segmentsPerCell segments per cell
+    double bounds[6];
+    m_Points->GetBounds(bounds);
+    double extent[3];
+    double maxExtent = 0;
+    for (int i=0; i<3; i++)
+    {
+        extent[i] = bounds[2*i+1]-bounds[2*i];
+        maxExtent = std::max(maxExtent, extent[i]);
+    }
+    if (maxExtent<=0)
+        maxExtent = 1;
+
+    double volume = 1;
+    for (int i=0; i<3; i++)
+        volume *= std::max(extent[i], 0.001*maxExtent);
+
+    double numberOfCells = std::max(1.0, m_NumberOfSegments/std::max(segmentsPerCell, 1.0));
+    m_CellSize = std::pow(volume/numberOfCells, 1.0/3.0);
+    m_CellSize = std::max(m_CellSize, maxExtent/MaxGridDimension);
+
+    for (int i=0; i<3; i++)
+    {
+        m_Origin[i] = bounds[2*i];
+        m_Dimensions[i] = std::min(MaxGridDimension, std::max(1, static_cast<int>(std::floor(extent[i]/m_CellSize))+1));
+    }
+
+    const std::size_t cellCount = static_cast<std::size_t>(m_Dimensions[0])*m_Dimensions[1]*m_Dimensions[2];
+    m_CellOffsets.assign(cellCount+1, 0);
+
+    // two passes: count the segments of each cell, then fill the cells
+    double p1[3];
+    double p2[3];
+    for (int pass=0; pass<2; pass++)
+    {
+        std::vector<unsigned int> cursor;
+        if (pass==1)
+        {
+            for (std::size_t c=0; c<cellCount; c++)
+                m_CellOffsets[c+1] += m_CellOffsets[c];
+            m_CellSegments.resize(m_CellOffsets[cellCount]);
+            cursor.assign(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+        }
+
+        for (unsigned int s=0; s<m_NumberOfSegments; s++)
+        {
+            this->GetSegment(s, p1, p2);
+            double segmentBounds[6] = { std::min(p1[0],p2[0]), std::max(p1[0],p2[0]),
+                                        std::min(p1[1],p2[1]), std::max(p1[1],p2[1]),
+                                        std::min(p1[2],p2[2]), std::max(p1[2],p2[2]) };
+            int minCell[3];
+            int maxCell[3];
+            this->GetCellRange(segmentBounds, minCell, maxCell);
+
+            for (int z=minCell[2]; z<=maxCell[2]; z++)
+                for (int y=minCell[1]; y<=maxCell[1]; y++)
+                    for (int x=minCell[0]; x<=maxCell[0]; x++)
+                    {
+                        std::size_t c = (static_cast<std::size_t>(z)*m_Dimensions[1]+y)*m_Dimensions[0]+x;
+                        if (pass==0)
+                            m_CellOffsets[c+1]++;
+                        else
+                            m_CellSegments[cursor[c]++] = s;
+                    }
+        }
+    }
+}
+
+bool mitk::FiberBundleSegmentIndex::GetCellRange(const double bounds[6], int minCell[3], int maxCell[3]) const
+{
+    for (int i=0; i<3; i++)
+    {
+        double minPos = (bounds[2*i]-m_Origin[i])/m_CellSize;
+        double maxPos = (bounds[2*i+1]-m_Origin[i])/m_CellSize;
+        // the last cell also holds the points on the upper border
+        if (maxPos<0 || minPos>m_Dimensions[i])
+            return false;
+
+        minCell[i] = std::max(0, std::min(m_Dimensions[i]-1, static_cast<int>(std::floor(minPos))));
+        maxCell[i] = std::max(0, std::min(m_Dimensions[i]-1, static_cast<int>(std::floor(maxPos))));
+    }
+    return true;
+}
+
+void mitk::FiberBundleSegmentIndex::GetCandidateSegments(const double bounds[6], std::vector<long>& fiberIds, std::vector<unsigned int>& fiberOffsets, std::vector<unsigned int>& segments) const
+{
+    fiberIds.clear();
+    fiberOffsets.clear();
+    segments.clear();
+
+    int minCell[3];
+    int maxCell[3];
+    if (m_CellOffsets.empty() || !this->GetCellRange(bounds, minCell, maxCell))
+    {
+        fiberOffsets.push_back(0);
+        return;
+    }
+
+    for (int z=minCell[2]; z<=maxCell[2]; z++)
+        for (int y=minCell[1]; y<=maxCell[1]; y++)
+            for (int x=minCell[0]; x<=maxCell[0]; x++)
+            {
+                std::size_t c = (static_cast<std::size_t>(z)*m_Dimensions[1]+y)*m_Dimensions[0]+x;
+                segments.insert(segments.end(), m_CellSegments.begin()+m_CellOffsets[c], m_CellSegments.begin()+m_CellOffsets[c+1]);
+            }
+
+    // segments spanning several cells are registered more than once
+    std::sort(segments.begin(), segments.end());
+    segments.erase(std::unique(segments.begin(), segments.end()), segments.end());
+
+    // segment ids ascend with the fiber ids
+    unsigned int fiberEnd = 0;
+    for (unsigned int i=0; i<segments.size(); i++)
+    {
+        if (fiberIds.empty() || segments[i]>=fiberEnd)
+        {
+            std::vector<unsigned int>::const_iterator it = std::upper_bound(m_FiberSegmentOffsets.begin(), m_FiberSegmentOffsets.end(), segments[i]);
+            fiberIds.push_back(it-m_FiberSegmentOffsets.begin()-1);
+            fiberOffsets.push_back(i);
+            fiberEnd = *it;
+        }
+    }
+    fiberOffsets.push_back(segments.size());
+}
+
+void mitk::FiberBundleSegmentIndex::GetSegment(unsigned int segment, double p1[3], double p2[3]) const
+{
+    std::size_t fiber = std::upper_bound(m_FiberSegmentOffsets.begin(), m_FiberSegmentOffsets.end(), segment)-m_FiberSegmentOffsets.begin()-1;
+    std::size_t point = m_FiberPointOffsets[fiber]+(segment-m_FiberSegmentOffsets[fiber]);
+
+    // vtkPoints::GetPoint(id, x) does not use internal buffers and may be called concurrently
+    m_Points->GetPoint(m_PointIds[point], p1);
+    m_Points->GetPoint(m_PointIds[point+1], p2);
+}
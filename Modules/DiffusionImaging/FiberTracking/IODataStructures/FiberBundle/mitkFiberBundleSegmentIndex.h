@@ -0,0 +1,100 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberBundleSegmentIndex_H
+#define _MITK_FiberBundleSegmentIndex_H
+
+#include <mitkCommon.h>
+#include <MitkFiberTrackingExports.h>
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Uniform grid over the line segments of a fiber bundle.
+  *
+  * Every segment is registered in all grid cells overlapped by its bounding box. Queries with an
+  * axis aligned box return only the segments registered in the overlapped cells, grouped by fiber.
+  * Segments intersecting a region of interest inside the query box are always among the candidates,
+  * so exact intersection tests only have to be applied to the candidates.
+  *
+  * The index refers to the points of the poly data it was built from and has to be rebuilt if the
+  * fibers change. Queries are const and may be run concurrently.
+  */
+class MITKFIBERTRACKING_EXPORT FiberBundleSegmentIndex : public itk::Object
+{
+public:
+
+    mitkClassMacroItkParent( FiberBundleSegmentIndex, itk::Object )
+    itkFactorylessNewMacro(Self)
+
+    /** \brief Builds the grid for all lines of the poly data. The cell size is chosen to hold about segmentsPerCell segments. */
+    void Build(vtkPolyData* fiberPolyData, double segmentsPerCell = 4.0);
+
+    /**
+      * \brief Collects the candidate segments for an axis aligned box (xmin, xmax, ymin, ymax, zmin, zmax).
+      * \param fiberIds ascending ids of all fibers with candidate segments
+      * \param fiberOffsets the candidate segments of fiberIds[i] are segments[fiberOffsets[i]] to segments[fiberOffsets[i+1]-1]
+      * \param segments ascending segment ids, use GetSegment() to retrieve the end points
+      */
+    void GetCandidateSegments(const double bounds[6], std::vector<long>& fiberIds, std::vector<unsigned int>& fiberOffsets, std::vector<unsigned int>& segments) const;
+
+    /** \brief Gets the end points of a segment */
+    void GetSegment(unsigned int segment, double p1[3], double p2[3]) const;
+
+    unsigned int GetNumberOfSegments() const { return m_NumberOfSegments; }
+    unsigned int GetNumberOfFibers() const { return m_FiberSegmentOffsets.empty() ? 0 : m_FiberSegmentOffsets.size()-1; }
+
+protected:
+
+    FiberBundleSegmentIndex();
+    virtual ~FiberBundleSegmentIndex();
+
+    /** \brief Range of grid cells overlapped by a box, clamped to the grid */
+    bool GetCellRange(const double bounds[6], int minCell[3], int maxCell[3]) const;
+
+    vtkSmartPointer<vtkPoints> m_Points;
+
+    // point ids of all fibers, the points of fiber f start at m_PointIds[m_FiberPointOffsets[f]]
+    std::vector<vtkIdType> m_PointIds;
+    std::vector<std::size_t> m_FiberPointOffsets;
+
+    // first segment of each fiber, one additional entry holds the number of segments
+    std::vector<unsigned int> m_FiberSegmentOffsets;
+
+    unsigned int m_NumberOfSegments;
+
+    // grid cells in compressed row storage, the segments of cell c are m_CellSegments[m_CellOffsets[c]] to m_CellSegments[m_CellOffsets[c+1]-1]
+    std::vector<unsigned int> m_CellOffsets;
+    std::vector<unsigned int> m_CellSegments;
+
+    double m_Origin[3];
+    double m_CellSize;
+    int m_Dimensions[3];
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBundleSegmentIndex_H */
@@ -0,0 +1,161 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkStreamlineContainer.h"
+
+#include <mitkExceptionMacro.h>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <cmath>
+
+mitk::StreamlineContainer::StreamlineContainer()
+    : m_ScratchFileCapacity(0)
+{
+    m_Offsets.push_back(0);
+}
+
+mitk::StreamlineContainer::~StreamlineContainer()
+{
+
+}
+
+void mitk::StreamlineContainer::UseScratchFile(unsigned long long maxPoints, const std::string& directory)
+{
+    this->Clear();
+    std::vector<float>().swap(m_Points);
+
+    m_ScratchFile = nullptr;
+    m_ScratchFile = mitk::MemoryMappedFile::CreateScratchFile(std::max(maxPoints, 1ULL)*3*sizeof(float), directory);
+    m_ScratchFileCapacity = maxPoints;
+}
+
+void mitk::StreamlineContainer::Reserve(unsigned long long numStreamlines, unsigned long long numPoints)
+{
+    m_Offsets.reserve(numStreamlines+1);
+    if (m_ScratchFile.IsNull())
+        m_Points.reserve(3*numPoints);
+}
+
+void mitk::StreamlineContainer::Clear()
+{
+    m_Offsets.clear();
+    m_Offsets.push_back(0);
+    m_Points.clear();
+    this->Modified();
+}
+
+const float* mitk::StreamlineContainer::GetPointData() const
+{
+    if (m_ScratchFile.IsNotNull())
+        return static_cast<const float*>(m_ScratchFile->GetData());
+    return m_Points.empty() ? nullptr : &m_Points.front();
+}
+
+void mitk::StreamlineContainer::AddStreamline(const float* points, unsigned int numPoints)
+{
+    unsigned long long first = m_Offsets.back();
+    if (m_ScratchFile.IsNotNull())
+    {
+        if (first+numPoints > m_ScratchFileCapacity)
+            mitkThrow() << "Scratch file of the streamline container is full (" << m_ScratchFileCapacity << " points).";
+        std::copy(points, points+3*numPoints, static_cast<float*>(m_ScratchFile->GetData())+3*first);
+    }
+    else
+    {
+        m_Points.insert(m_Points.end(), points, points+3*numPoints);
+    }
+    m_Offsets.push_back(first+numPoints);
+}
+
+void mitk::StreamlineContainer::AddPolyData(vtkPolyData* polyData)
+{
+    if (polyData==nullptr || polyData->GetLines()==nullptr)
+        return;
+
+    std::vector<float> buffer;
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    double p[3];
+    vtkCellArray* lines = polyData->GetLines();
+    this->Reserve(this->GetNumberOfStreamlines()+lines->GetNumberOfCells(), this->GetNumberOfPoints()+polyData->GetNumberOfPoints());
+
+    lines->InitTraversal();
+    while (lines->GetNextCell(numPoints, pointIds))
+    {
+        buffer.resize(3*numPoints);
+        for (vtkIdType i=0; i<numPoints; i++)
+        {
+            polyData->GetPoint(pointIds[i], p);
+            buffer[3*i] = p[0];
+            buffer[3*i+1] = p[1];
+            buffer[3*i+2] = p[2];
+        }
+        this->AddStreamline(buffer.empty() ? nullptr : &buffer.front(), numPoints);
+    }
+}
+
+float mitk::StreamlineContainer::GetLength(unsigned long long streamline) const
+{
+    const float* points = this->GetPoints(streamline);
+    float length = 0;
+    for (unsigned int i=1; i<this->GetNumberOfPoints(streamline); i++)
+    {
+        const float* p1 = points+3*(i-1);
+        const float* p2 = points+3*i;
+        length += std::sqrt((p2[0]-p1[0])*(p2[0]-p1[0]) + (p2[1]-p1[1])*(p2[1]-p1[1]) + (p2[2]-p1[2])*(p2[2]-p1[2]));
+    }
+    return length;
+}
+
+vtkSmartPointer<vtkPolyData> mitk::StreamlineContainer::CreatePolyData() const
+{
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(this->GetNumberOfPoints());
+    if (this->GetNumberOfPoints()>0)
+        std::copy(this->GetPointData(), this->GetPointData()+3*this->GetNumberOfPoints(), coordinates->GetPointer(0));
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(coordinates);
+
+    // the connectivity is written directly: number of points followed by the point ids of every line
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(this->GetNumberOfStreamlines()+this->GetNumberOfPoints());
+    vtkIdType* ids = connectivity->GetPointer(0);
+    for (unsigned long long s=0; s<this->GetNumberOfStreamlines(); s++)
+    {
+        *ids++ = this->GetNumberOfPoints(s);
+        for (unsigned long long i=m_Offsets[s]; i<m_Offsets[s+1]; i++)
+            *ids++ = i;
+    }
+
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(this->GetNumberOfStreamlines(), connectivity);
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    return polyData;
+}
+
+std::size_t mitk::StreamlineContainer::GetMemorySize() const
+{
+    return sizeof(*this) + m_Offsets.capacity()*sizeof(unsigned long long) + m_Points.capacity()*sizeof(float);
+}
@@ -0,0 +1,111 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_StreamlineContainer_H
+#define _MITK_StreamlineContainer_H
+
+#include <mitkCommon.h>
+#include <mitkMemoryMappedFile.h>
+#include <MitkFiberTrackingExports.h>
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+#include <string>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Compact storage of streamlines as packed float32 coordinates.
+  *
+  * The points of all streamlines are stored consecutively (x,y,z per point), an offset table holds the
+  * first point of each streamline. This needs 12 bytes per point and 8 bytes per streamline, a fraction
+  * of the memory of an equivalent vtkPolyData.
+  *
+  * The points are either kept in main memory or, after UseScratchFile(), in a memory mapped temporary
+  * file. In the latter case the operating system pages the coordinates in and out as they are accessed,
+  * so bundles larger than the physical memory can be processed sequentially.
+  *
+  * vtkPolyData is only created on request by CreatePolyData().
+  */
+class MITKFIBERTRACKING_EXPORT StreamlineContainer : public itk::Object
+{
+public:
+
+    mitkClassMacroItkParent( StreamlineContainer, itk::Object )
+    itkFactorylessNewMacro(Self)
+
+    /**
+      * \brief Stores the points in a memory mapped temporary file with room for maxPoints points.
+      * Removes all streamlines. Throws an mitk::Exception if the file cannot be created.
+      */
+    void UseScratchFile(unsigned long long maxPoints, const std::string& directory = std::string());
+
+    bool IsUsingScratchFile() const { return m_ScratchFile.IsNotNull(); }
+
+    void Reserve(unsigned long long numStreamlines, unsigned long long numPoints);
+
+    /** \brief Removes all streamlines, a scratch file is kept for reuse */
+    void Clear();
+
+    /** \brief Appends a streamline. points holds x,y,z of numPoints points. Throws if the scratch file is full. */
+    void AddStreamline(const float* points, unsigned int numPoints);
+
+    /** \brief Appends all lines of the poly data */
+    void AddPolyData(vtkPolyData* polyData);
+
+    unsigned long long GetNumberOfStreamlines() const { return m_Offsets.size()-1; }
+
+    /** \brief Number of points of all streamlines */
+    unsigned long long GetNumberOfPoints() const { return m_Offsets.back(); }
+
+    unsigned int GetNumberOfPoints(unsigned long long streamline) const { return m_Offsets[streamline+1]-m_Offsets[streamline]; }
+
+    /** \brief Coordinates of the points of a streamline, x,y,z per point */
+    const float* GetPoints(unsigned long long streamline) const { return this->GetPointData()+3*m_Offsets[streamline]; }
+
+    float GetLength(unsigned long long streamline) const;
+
+    /** \brief Creates poly data with one line per streamline */
+    vtkSmartPointer<vtkPolyData> CreatePolyData() const;
+
+    /** \brief Bytes of main memory occupied by the container, mapped points are not included */
+    std::size_t GetMemorySize() const;
+
+protected:
+
+    StreamlineContainer();
+    virtual ~StreamlineContainer();
+
+    const float* GetPointData() const;
+
+    // first point of every streamline, one additional entry holds the number of points
+    std::vector<unsigned long long> m_Offsets;
+
+    std::vector<float> m_Points;
+
+    MemoryMappedFile::Pointer m_ScratchFile;
+    unsigned long long m_ScratchFileCapacity;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_StreamlineContainer_H */
@@ -1,5 +1,6 @@
 #include <mitkTrackvis.h>
-#include <vtkTransformPolyDataFilter.h>
+#include <vtkMatrix4x4.h>
+#include <algorithm>
 
 TrackVisFiberReader::TrackVisFiberReader()  { m_Filename = ""; m_FilePointer = nullptr; }
 
@@ -49,6 +50,23 @@ short TrackVisFiberReader::create(string filename , const mitk::FiberBundle *fib
     m_Header.version = 1;
     m_Header.hdr_size = 1000;
 
+    return create(filename, m_Header);
+}
+
+
+// Create a TrackVis file with the metadata of another TrackVis file, e.g. to write the
+// filtered fibers of a file processed in chunks. Scalars and properties are not written.
+// The fibers are appended in the MITK convention, so the voxel order is set to LPS.
+// ---------------------------------------------------------------------------------------
+short TrackVisFiberReader::create(string filename, const TrackVis_header& header)
+{
+    m_Header = header;
+    sprintf(m_Header.voxel_order,"LPS");
+    m_Header.n_scalars = 0;
+    m_Header.n_properties = 0;
+    m_Header.n_count = 0;
+    m_Header.hdr_size = 1000;
+
     // write the header to the file
     m_FilePointer = fopen(filename.c_str(),"w+b");
     if (m_FilePointer == nullptr)
@@ -84,39 +102,30 @@ short TrackVisFiberReader::open( string filename )
 
 
 
-// Append a fiber to the file
-// --------------------------
+// Append the fibers to the file
+// ------------------------------
 short TrackVisFiberReader::append(const mitk::FiberBundle *fib)
 {
-    vtkPolyData* poly = fib->GetFiberPolyData();
-    for (int i=0; i<fib->GetNumFibers(); i++)
-    {
-        vtkCell* cell = poly->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        unsigned int     numSaved, pos = 0;
-        //float* tmp = new float[3*maxSteps];
-        std::vector< float > tmp;
-        tmp.reserve(3*numPoints);
-
-        numSaved = numPoints;
-        for(unsigned int i=0; i<numSaved ;i++)
-        {
-            double* p = points->GetPoint(i);
+    mitk::StreamlineContainer::Pointer streamlines = mitk::StreamlineContainer::New();
+    streamlines->AddPolyData(fib->GetFiberPolyData());
+    return append(streamlines);
+}
 
-            tmp[pos++] = p[0];
-            tmp[pos++] = p[1];
-            tmp[pos++] = p[2];
-        }
 
+// Append the streamlines to the file
+// ----------------------------------
+short TrackVisFiberReader::append(const mitk::StreamlineContainer* streamlines)
+{
+    for (unsigned long long i=0; i<streamlines->GetNumberOfStreamlines(); i++)
+    {
         // write the coordinates to the file
+        unsigned int numSaved = streamlines->GetNumberOfPoints(i);
         if ( fwrite((char*)&numSaved, 1, 4, m_FilePointer) != 4 )
         {
             printf( "[ERROR] Problems saving the fiber!\n" );
             return 1;
         }
-        if ( fwrite((char*)&(tmp.front()), 1, 4*pos, m_FilePointer) != 4*pos )
+        if ( numSaved>0 && fwrite((char*)streamlines->GetPoints(i), 1, 12*numSaved, m_FilePointer) != 12*numSaved )
         {
             printf( "[ERROR] Problems saving the fiber!\n" );
             return 1;
@@ -126,40 +135,113 @@ short TrackVisFiberReader::append(const mitk::FiberBundle *fib)
     return 0;
 }
 
-//// Read one fiber from the file
-//// ----------------------------
-short TrackVisFiberReader::read( mitk::FiberBundle* fib )
+
+// Read the next maxStreamlines fibers (all remaining fibers if maxStreamlines<=0) and
+// append them to the container. The coordinates are converted to the MITK convention.
+// Returns the number of fibers read, 0 at the end of the file and -1 on errors.
+// ---------------------------------------------------------------------------------------
+int TrackVisFiberReader::readStreamlines( mitk::StreamlineContainer* streamlines, int maxStreamlines )
 {
+    const int pointStride = 3 + std::max<int>(m_Header.n_scalars, 0);
+    const int numProperties = std::max<int>(m_Header.n_properties, 0);
+    const float flip[3] = { m_Header.voxel_order[0]=='R' ? -1.0f : 1.0f,
+                            m_Header.voxel_order[1]=='A' ? -1.0f : 1.0f,
+                            m_Header.voxel_order[2]=='I' ? -1.0f : 1.0f };
+
+    // each fiber is read with a single call, scalars are dropped by compacting the buffer
+    std::vector< float > buffer;
+    int numRead = 0;
     int numPoints;
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    while (fread((char*)&numPoints, 1, 4, m_FilePointer)==4)
+    while ((maxStreamlines<=0 || numRead<maxStreamlines) && fread((char*)&numPoints, 1, 4, m_FilePointer)==4)
     {
         if ( numPoints <= 0 )
         {
             printf( "[ERROR] Trying to read a fiber with %d points!\n", numPoints );
             return -1;
         }
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
 
-        float tmp[3];
-        for(int i=0; i<numPoints; i++)
+        buffer.resize(static_cast<std::size_t>(numPoints)*pointStride);
+        if (fread((char*)&buffer.front(), sizeof(float), buffer.size(), m_FilePointer) != buffer.size())
         {
-            if (fread((char*)tmp, 1, 12, m_FilePointer) == 0)
-                MITK_ERROR << "TrackVis::read: Error during read.";
+            MITK_ERROR << "TrackVis::read: Error during read.";
+            return -1;
+        }
+        for (int i=0; i<numPoints; i++)
+            for (int j=0; j<3; j++)
+                buffer[3*i+j] = flip[j]*buffer[pointStride*i+j];
 
-            vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-            container->GetPointIds()->InsertNextId(id);
+        if (numProperties>0)
+            fseek(m_FilePointer, 4*numProperties, SEEK_CUR);
+
+        streamlines->AddStreamline(&buffer.front(), numPoints);
+        numRead++;
+    }
+
+    return numRead;
+}
+
+
+// Copy the fibers of a TrackVis file with a length (in mm) of at least minLength and at
+// most maxLength (no upper limit if maxLength<=0) to a new file. Only chunkSize fibers are
+// held in memory at a time. Returns the number of fibers written and -1 on errors.
+// ---------------------------------------------------------------------------------------
+int TrackVisFiberReader::filterByLength( string inFilename, string outFilename, float minLength, float maxLength, int chunkSize )
+{
+    TrackVisFiberReader reader;
+    if (reader.open(inFilename) != 1000)
+        return -1;
+    TrackVisFiberReader writer;
+    if (writer.create(outFilename, reader.m_Header) != 1)
+        return -1;
+
+    mitk::StreamlineContainer::Pointer chunk = mitk::StreamlineContainer::New();
+    mitk::StreamlineContainer::Pointer filtered = mitk::StreamlineContainer::New();
+    int numWritten = 0;
+    int numRead;
+    while ((numRead = reader.readStreamlines(chunk, chunkSize)) > 0)
+    {
+        for (unsigned long long i=0; i<chunk->GetNumberOfStreamlines(); i++)
+        {
+            float length = chunk->GetLength(i);
+            if (length>=minLength && (maxLength<=0 || length<=maxLength))
+                filtered->AddStreamline(chunk->GetPoints(i), chunk->GetNumberOfPoints(i));
         }
-        vtkNewCells->InsertNextCell(container);
+        if (writer.append(filtered) != 0)
+            return -1;
+        numWritten += static_cast<int>(filtered->GetNumberOfStreamlines());
+        chunk->Clear();
+        filtered->Clear();
     }
+    if (numRead < 0)
+        return -1;
+
+    writer.updateTotal(numWritten);
+    return numWritten;
+}
+
+
+// Position the file pointer at the first fiber
+// --------------------------------------------
+short TrackVisFiberReader::rewind()
+{
+    if (m_FilePointer == nullptr)
+        return 0;
+    return fseek(m_FilePointer, 1000, SEEK_SET)==0;
+}
+
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    fiberPolyData->SetPoints(vtkNewPoints);
-    fiberPolyData->SetLines(vtkNewCells);
+// Read all fibers from the file
+// -----------------------------
+short TrackVisFiberReader::read( mitk::FiberBundle* fib )
+{
+    mitk::StreamlineContainer::Pointer streamlines = mitk::StreamlineContainer::New();
+    if (m_Header.n_count>0)
+        streamlines->Reserve(m_Header.n_count, 0);
+    if (readStreamlines(streamlines, 0) < 0)
+        return -1;
 
     MITK_INFO << "Coordinate convention: " << m_Header.voxel_order;
+    fib->SetFiberPolyData(streamlines->CreatePolyData());
 
     mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
     vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
@@ -174,12 +256,6 @@ short TrackVisFiberReader::read( mitk::FiberBundle* fib )
 
     geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
 
-    vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-    transformFilter->SetInputData(fiberPolyData);
-    transformFilter->SetTransform(geometry->GetVtkTransform());
-    transformFilter->Update();
-    fib->SetFiberPolyData(transformFilter->GetOutput());
-
     mitk::Point3D origin;
     origin[0]=m_Header.origin[0];
     origin[1]=m_Header.origin[1];
@@ -198,7 +274,7 @@ short TrackVisFiberReader::read( mitk::FiberBundle* fib )
 
     fib->SetReferenceGeometry(dynamic_cast<mitk::BaseGeometry*>(geometry.GetPointer()));
 
-    return numPoints;
+    return 1;
 }
 
 
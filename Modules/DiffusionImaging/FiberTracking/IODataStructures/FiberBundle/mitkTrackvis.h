@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkCommon.h>
 #include <mitkFiberBundle.h>
+#include <mitkStreamlineContainer.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
 #include <vtkCellArray.h>
@@ -56,7 +57,10 @@ struct TrackVis_header
 };
 
 // Class to handle TrackVis files.
-// -------------------------------
+// Large files can be processed in chunks: open() the file, call readStreamlines()
+// until it returns 0 and append() each processed chunk to a file created with create().
+// filterByLength() does this to remove short and long fibers without loading the file.
+// ---------------------------------------------------------------------------------------
 class MITKFIBERTRACKING_EXPORT TrackVisFiberReader
 {
 private:
@@ -67,14 +71,20 @@ public:
     TrackVis_header     m_Header;
 
     short   create(string m_Filename, const mitk::FiberBundle* fib);
+    short   create(string m_Filename, const TrackVis_header& header);
     short   open( string m_Filename );
     short   read( mitk::FiberBundle* fib );
+    int     readStreamlines( mitk::StreamlineContainer* streamlines, int maxStreamlines );
+    short   rewind();
     short   append(const mitk::FiberBundle* fib );
+    short   append(const mitk::StreamlineContainer* streamlines );
     void    writeHdr();
     void    updateTotal( int totFibers );
     void    close();
     bool    IsTransformValid();
 
+    static int filterByLength( string inFilename, string outFilename, float minLength, float maxLength, int chunkSize=10000 );
+
     TrackVisFiberReader();
     ~TrackVisFiberReader();
 };
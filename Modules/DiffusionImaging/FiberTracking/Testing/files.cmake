@@ -10,6 +10,8 @@ SET(MODULE_CUSTOM_TESTS
   mitkFiberfoxSignalGenerationTest.cpp
   mitkMachineLearningTrackingTest.cpp
   mitkFiberProcessingTest.cpp
+  mitkFiberBundleSegmentIndexTest.cpp
+  mitkStreamlineContainerTest.cpp
 )
 
 
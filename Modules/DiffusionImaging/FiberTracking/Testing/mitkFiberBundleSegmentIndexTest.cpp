@@ -0,0 +1,212 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkFiberBundle.h>
+#include <mitkFiberBundleSegmentIndex.h>
+#include <mitkPlanarCircle.h>
+#include <mitkPlanarPolygon.h>
+#include <mitkStandaloneDataStorage.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <vtkCellArray.h>
+#include <vtkPlane.h>
+#include <vtkPolyLine.h>
+#include <vtkPolygon.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+    // straight fibers with random position, direction and some jitter
+    vtkSmartPointer<vtkPolyData> CreateSyntheticFibers(int numFibers, int numPoints)
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> position(0.0, 100.0);
+        std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        for (int i=0; i<numFibers; i++)
+        {
+            double p[3] = { position(generator), position(generator), position(generator) };
+            double dir[3] = { position(generator)-50.0, position(generator)-50.0, position(generator)-50.0 };
+            double norm = std::sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
+
+            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            for (int j=0; j<numPoints; j++)
+            {
+                vtkIdType id = points->InsertNextPoint(p);
+                container->GetPointIds()->InsertNextId(id);
+                for (int d=0; d<3; d++)
+                    p[d] += dir[d]/norm + jitter(generator);
+            }
+            lines->InsertNextCell(container);
+        }
+
+        vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+        polyData->SetPoints(points);
+        polyData->SetLines(lines);
+        return polyData;
+    }
+
+    mitk::PlaneGeometry::Pointer CreatePlane()
+    {
+        mitk::PlaneGeometry::Pointer planeGeometry = mitk::PlaneGeometry::New();
+        planeGeometry->InitializeStandardPlane(100.0, 100.0);
+        mitk::Point3D origin;
+        origin[0] = 0; origin[1] = 0; origin[2] = 50.0;
+        planeGeometry->SetOrigin(origin);
+        return planeGeometry;
+    }
+
+    // reference implementation: test every segment of every fiber
+    std::vector<long> ExtractWithCircle(mitk::FiberBundle* fib, mitk::PlanarFigure* circle)
+    {
+        std::vector<long> result;
+        mitk::Vector3D planeNormal = circle->GetPlaneGeometry()->GetNormal();
+        planeNormal.Normalize();
+        mitk::Point3D center = circle->GetWorldControlPoint(0);
+        double radius = center.EuclideanDistanceTo(circle->GetWorldControlPoint(1));
+
+        vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+        for (int i=0; i<fib->GetNumFibers(); i++)
+        {
+            vtkCell* cell = polyData->GetCell(i);
+            for (int j=0; j<cell->GetNumberOfPoints()-1; j++)
+            {
+                double p1[3], p2[3], x[3], t;
+                cell->GetPoints()->GetPoint(j, p1);
+                cell->GetPoints()->GetPoint(j+1, p2);
+                if (vtkPlane::IntersectWithLine(p1, p2, planeNormal.GetDataPointer(), center.GetDataPointer(), t, x)
+                    && (x[0]-center[0])*(x[0]-center[0])+(x[1]-center[1])*(x[1]-center[1])+(x[2]-center[2])*(x[2]-center[2]) <= radius*radius)
+                {
+                    result.push_back(i);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<long> ExtractWithPolygon(mitk::FiberBundle* fib, mitk::PlanarFigure* polygon)
+    {
+        std::vector<long> result;
+        vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
+        for (unsigned int i=0; i<polygon->GetNumberOfControlPoints(); ++i)
+        {
+            mitk::Point3D p = polygon->GetWorldControlPoint(i);
+            vtkIdType id = polygonVtk->GetPoints()->InsertNextPoint(p[0], p[1], p[2]);
+            polygonVtk->GetPointIds()->InsertNextId(id);
+        }
+
+        vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+        for (int i=0; i<fib->GetNumFibers(); i++)
+        {
+            vtkCell* cell = polyData->GetCell(i);
+            for (int j=0; j<cell->GetNumberOfPoints()-1; j++)
+            {
+                double p1[3], p2[3], x[3], pcoords[3], t;
+                int subId;
+                cell->GetPoints()->GetPoint(j, p1);
+                cell->GetPoints()->GetPoint(j+1, p2);
+                if (polygonVtk->IntersectWithLine(p1, p2, 0.001, t, x, pcoords, subId))
+                {
+                    result.push_back(i);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+/**Documentation
+ *  Test if the segment index based fiber extraction yields the same fibers as testing all segments.
+ *  An optional argument sets the number of synthetic fibers and can be used for benchmarking.
+ */
+int mitkFiberBundleSegmentIndexTest(int argc, char* argv[])
+{
+    MITK_TEST_BEGIN("mitkFiberBundleSegmentIndexTest");
+
+    int numFibers = 20000;
+    if (argc>1)
+        numFibers = std::atoi(argv[1]);
+
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New(CreateSyntheticFibers(numFibers, 40));
+    MITK_TEST_CONDITION_REQUIRED(fib->GetNumFibers()==numFibers, "check number of synthetic fibers");
+
+    double startTime = itksys::SystemTools::GetTime();
+    mitk::FiberBundleSegmentIndex* index = fib->GetSegmentIndex();
+    MITK_INFO << "Segment index built in " << itksys::SystemTools::GetTime()-startTime << "s";
+    MITK_TEST_CONDITION_REQUIRED(index->GetNumberOfFibers()==static_cast<unsigned int>(numFibers), "check number of indexed fibers");
+    MITK_TEST_CONDITION_REQUIRED(index->GetNumberOfSegments()==static_cast<unsigned int>(numFibers*39), "check number of indexed segments");
+    MITK_TEST_CONDITION(fib->GetSegmentIndex()==index, "check index is reused");
+
+    mitk::StandaloneDataStorage::Pointer storage = mitk::StandaloneDataStorage::New();
+
+    // circle
+    mitk::PlanarCircle::Pointer circle = mitk::PlanarCircle::New();
+    circle->SetPlaneGeometry(CreatePlane());
+    mitk::Point2D p0; p0[0] = 50.0; p0[1] = 50.0;
+    mitk::Point2D p1; p1[0] = 65.0; p1[1] = 50.0;
+    circle->SetControlPoint(0, p0, true);
+    circle->SetControlPoint(1, p1, true);
+    mitk::DataNode::Pointer circleNode = mitk::DataNode::New();
+    circleNode->SetData(circle);
+
+    startTime = itksys::SystemTools::GetTime();
+    std::vector<long> expected = ExtractWithCircle(fib, circle);
+    MITK_INFO << "Circle: testing all segments took " << itksys::SystemTools::GetTime()-startTime << "s";
+    startTime = itksys::SystemTools::GetTime();
+    std::vector<long> extracted = fib->ExtractFiberIdSubset(circleNode, storage);
+    MITK_INFO << "Circle: indexed extraction took " << itksys::SystemTools::GetTime()-startTime << "s";
+    MITK_TEST_CONDITION_REQUIRED(!expected.empty(), "check circle intersects fibers");
+    MITK_TEST_CONDITION(extracted==expected, "check fibers extracted with circle");
+
+    // polygon
+    mitk::PlanarPolygon::Pointer polygon = mitk::PlanarPolygon::New();
+    polygon->SetPlaneGeometry(CreatePlane());
+    mitk::Point2D q0; q0[0] = 20.0; q0[1] = 20.0;
+    mitk::Point2D q1; q1[0] = 60.0; q1[1] = 25.0;
+    mitk::Point2D q2; q2[0] = 40.0; q2[1] = 70.0;
+    polygon->SetControlPoint(0, q0, true);
+    polygon->SetControlPoint(1, q1, true);
+    polygon->SetControlPoint(2, q2, true);
+    polygon->SetClosed(true);
+    mitk::DataNode::Pointer polygonNode = mitk::DataNode::New();
+    polygonNode->SetData(polygon);
+
+    startTime = itksys::SystemTools::GetTime();
+    expected = ExtractWithPolygon(fib, polygon);
+    MITK_INFO << "Polygon: testing all segments took " << itksys::SystemTools::GetTime()-startTime << "s";
+    startTime = itksys::SystemTools::GetTime();
+    extracted = fib->ExtractFiberIdSubset(polygonNode, storage);
+    MITK_INFO << "Polygon: indexed extraction took " << itksys::SystemTools::GetTime()-startTime << "s";
+    MITK_TEST_CONDITION_REQUIRED(!expected.empty(), "check polygon intersects fibers");
+    MITK_TEST_CONDITION(extracted==expected, "check fibers extracted with polygon");
+
+    // the index follows transformations of the fibers
+    fib->TranslateFibers(0, 0, 10);
+    expected = ExtractWithCircle(fib, circle);
+    extracted = fib->ExtractFiberIdSubset(circleNode, storage);
+    MITK_TEST_CONDITION(extracted==expected, "check fibers extracted with circle after translation");
+
+    MITK_TEST_END();
+}
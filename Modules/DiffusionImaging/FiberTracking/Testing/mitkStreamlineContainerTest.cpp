@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkFiberBundle.h>
+#include <mitkIOUtil.h>
+#include <mitkStreamlineContainer.h>
+#include <mitkTrackvis.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    // random walks with 10 to 50 points
+    void CreateSyntheticStreamlines(mitk::StreamlineContainer* streamlines, int numStreamlines)
+    {
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<int> length(10, 50);
+        std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+        std::vector<float> points;
+        for (int i=0; i<numStreamlines; i++)
+        {
+            points.resize(3*length(generator));
+            float p[3] = { 50.0f, 50.0f, 50.0f };
+            for (unsigned int j=0; j<points.size(); j+=3)
+                for (int d=0; d<3; d++)
+                {
+                    p[d] += step(generator);
+                    points[j+d] = p[d];
+                }
+            streamlines->AddStreamline(&points.front(), points.size()/3);
+        }
+    }
+
+    bool CompareStreamlines(mitk::StreamlineContainer* s1, mitk::StreamlineContainer* s2)
+    {
+        if (s1->GetNumberOfStreamlines()!=s2->GetNumberOfStreamlines() || s1->GetNumberOfPoints()!=s2->GetNumberOfPoints())
+            return false;
+        for (unsigned long long i=0; i<s1->GetNumberOfStreamlines(); i++)
+        {
+            if (s1->GetNumberOfPoints(i)!=s2->GetNumberOfPoints(i))
+                return false;
+            for (unsigned int j=0; j<3*s1->GetNumberOfPoints(i); j++)
+                if (std::fabs(s1->GetPoints(i)[j]-s2->GetPoints(i)[j])>0.0001)
+                    return false;
+        }
+        return true;
+    }
+}
+
+/**Documentation
+ *  Test the compact streamline storage and the chunked TrackVis reading and writing.
+ */
+int mitkStreamlineContainerTest(int /*argc*/, char* /*argv*/[])
+{
+    MITK_TEST_BEGIN("mitkStreamlineContainerTest");
+
+    mitk::StreamlineContainer::Pointer streamlines = mitk::StreamlineContainer::New();
+    MITK_TEST_CONDITION_REQUIRED(streamlines->GetNumberOfStreamlines()==0 && streamlines->GetNumberOfPoints()==0, "check empty container");
+
+    CreateSyntheticStreamlines(streamlines, 1000);
+    MITK_TEST_CONDITION_REQUIRED(streamlines->GetNumberOfStreamlines()==1000, "check number of streamlines");
+
+    // poly data conversion
+    vtkSmartPointer<vtkPolyData> polyData = streamlines->CreatePolyData();
+    MITK_TEST_CONDITION_REQUIRED(polyData->GetNumberOfLines()==1000, "check number of lines");
+    MITK_TEST_CONDITION_REQUIRED(static_cast<unsigned long long>(polyData->GetNumberOfPoints())==streamlines->GetNumberOfPoints(), "check number of points");
+
+    mitk::StreamlineContainer::Pointer converted = mitk::StreamlineContainer::New();
+    converted->AddPolyData(polyData);
+    MITK_TEST_CONDITION(CompareStreamlines(streamlines, converted), "check streamlines converted from poly data");
+
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New(polyData);
+    MITK_TEST_CONDITION(fib->GetNumFibers()==1000, "check fiber bundle created from streamlines");
+
+    // scratch file storage
+    mitk::StreamlineContainer::Pointer mapped = mitk::StreamlineContainer::New();
+    mapped->UseScratchFile(streamlines->GetNumberOfPoints());
+    MITK_TEST_CONDITION_REQUIRED(mapped->IsUsingScratchFile(), "check scratch file is used");
+    for (unsigned long long i=0; i<streamlines->GetNumberOfStreamlines(); i++)
+        mapped->AddStreamline(streamlines->GetPoints(i), streamlines->GetNumberOfPoints(i));
+    MITK_TEST_CONDITION(CompareStreamlines(streamlines, mapped), "check streamlines stored in scratch file");
+    MITK_TEST_CONDITION(mapped->GetMemorySize()<streamlines->GetMemorySize(), "check points of scratch file are not held in memory");
+    MITK_TEST_FOR_EXCEPTION(mitk::Exception, mapped->AddStreamline(streamlines->GetPoints(0), streamlines->GetNumberOfPoints(0)));
+
+    // TrackVis round trip in chunks, keeping only the streamlines longer than 20mm
+    std::string inputFile = mitk::IOUtil::CreateTemporaryFile("streamlinesXXXXXX.trk");
+    std::string outputFile = mitk::IOUtil::CreateTemporaryFile("streamlinesXXXXXX.trk");
+
+    TrackVisFiberReader writer;
+    MITK_TEST_CONDITION_REQUIRED(writer.create(inputFile, fib)==1, "check creating TrackVis file");
+    writer.m_Header.n_count = streamlines->GetNumberOfStreamlines();
+    writer.writeHdr();
+    MITK_TEST_CONDITION_REQUIRED(writer.append(streamlines)==0, "check writing TrackVis file");
+    writer.close();
+
+    TrackVisFiberReader reader;
+    MITK_TEST_CONDITION_REQUIRED(reader.open(inputFile)==1000, "check opening TrackVis file");
+    TrackVisFiberReader filteredWriter;
+    MITK_TEST_CONDITION_REQUIRED(filteredWriter.create(outputFile, reader.m_Header)==1, "check creating filtered TrackVis file");
+
+    mitk::StreamlineContainer::Pointer chunk = mitk::StreamlineContainer::New();
+    mitk::StreamlineContainer::Pointer filtered = mitk::StreamlineContainer::New();
+    mitk::StreamlineContainer::Pointer expected = mitk::StreamlineContainer::New();
+    int numChunks = 0;
+    while (reader.readStreamlines(chunk, 128)>0)
+    {
+        numChunks++;
+        filtered->Clear();
+        for (unsigned long long i=0; i<chunk->GetNumberOfStreamlines(); i++)
+            if (chunk->GetLength(i)>20)
+                filtered->AddStreamline(chunk->GetPoints(i), chunk->GetNumberOfPoints(i));
+        filteredWriter.append(filtered);
+        chunk->Clear();
+    }
+    filteredWriter.close();
+    reader.close();
+    MITK_TEST_CONDITION(numChunks==8, "check number of chunks");
+
+    for (unsigned long long i=0; i<streamlines->GetNumberOfStreamlines(); i++)
+        if (streamlines->GetLength(i)>20)
+            expected->AddStreamline(streamlines->GetPoints(i), streamlines->GetNumberOfPoints(i));
+    MITK_TEST_CONDITION_REQUIRED(expected->GetNumberOfStreamlines()>0 && expected->GetNumberOfStreamlines()<1000, "check filter removes some streamlines");
+
+    // the written files use the LPS convention, so no coordinates are flipped
+    TrackVisFiberReader filteredReader;
+    filteredReader.open(outputFile);
+    mitk::StreamlineContainer::Pointer result = mitk::StreamlineContainer::New();
+    MITK_TEST_CONDITION(filteredReader.readStreamlines(result, 0)==static_cast<int>(expected->GetNumberOfStreamlines()), "check number of filtered streamlines");
+    MITK_TEST_CONDITION(CompareStreamlines(expected, result), "check filtered streamlines");
+
+    MITK_TEST_CONDITION_REQUIRED(filteredReader.rewind(), "check rewinding TrackVis file");
+    mitk::FiberBundle::Pointer filteredFib = mitk::FiberBundle::New();
+    MITK_TEST_CONDITION(filteredReader.read(filteredFib)==1, "check reading fiber bundle");
+    MITK_TEST_CONDITION(filteredFib->GetNumFibers()==static_cast<int>(expected->GetNumberOfStreamlines()), "check number of fibers read");
+    filteredReader.close();
+
+    // the same in one call, with an upper length limit
+    std::string lengthFilteredFile = mitk::IOUtil::CreateTemporaryFile("streamlinesXXXXXX.trk");
+    mitk::StreamlineContainer::Pointer expectedInRange = mitk::StreamlineContainer::New();
+    for (unsigned long long i=0; i<streamlines->GetNumberOfStreamlines(); i++)
+        if (streamlines->GetLength(i)>=20 && streamlines->GetLength(i)<=40)
+            expectedInRange->AddStreamline(streamlines->GetPoints(i), streamlines->GetNumberOfPoints(i));
+    int numWritten = TrackVisFiberReader::filterByLength(inputFile, lengthFilteredFile, 20, 40, 100);
+    MITK_TEST_CONDITION_REQUIRED(numWritten==static_cast<int>(expectedInRange->GetNumberOfStreamlines()), "check number of streamlines written by filterByLength");
+
+    TrackVisFiberReader lengthFilteredReader;
+    MITK_TEST_CONDITION_REQUIRED(lengthFilteredReader.open(lengthFilteredFile)==1000, "check opening length filtered TrackVis file");
+    MITK_TEST_CONDITION(lengthFilteredReader.m_Header.n_count==numWritten, "check fiber count in header");
+    mitk::StreamlineContainer::Pointer inRange = mitk::StreamlineContainer::New();
+    lengthFilteredReader.readStreamlines(inRange, 0);
+    MITK_TEST_CONDITION(CompareStreamlines(expectedInRange, inRange), "check length filtered streamlines");
+    lengthFilteredReader.close();
+    MITK_TEST_CONDITION(TrackVisFiberReader::filterByLength("missing.trk", lengthFilteredFile, 20, 40)==-1, "check filtering a missing file");
+
+    std::remove(inputFile.c_str());
+    std::remove(outputFile.c_str());
+    std::remove(lengthFilteredFile.c_str());
+
+    MITK_TEST_END();
+}
@@ -106,6 +106,37 @@ int mitkStreamlineTrackingTest(int argc, char* argv[])
             MITK_INFO << "OUTPUT: " << mitk::IOUtil::GetTempPath();
         }
         MITK_TEST_CONDITION_REQUIRED(ok, "Check if tractograms are equal.");
+
+        // seed batches are distributed to the threads dynamically, the fibers are still merged in seed order
+        FilterType::Pointer parallelFilter = FilterType::New();
+        parallelFilter->SetInput(itk_dti);
+        parallelFilter->SetSeedsPerVoxel(numSeeds);
+        parallelFilter->SetFaThreshold(minFA);
+        parallelFilter->SetMinCurvatureRadius(minCurv);
+        parallelFilter->SetStepSize(stepSize);
+        parallelFilter->SetF(tendf);
+        parallelFilter->SetG(tendg);
+        parallelFilter->SetInterpolate(interpolate);
+        parallelFilter->SetMinTractLength(minLength);
+        parallelFilter->SetNumberOfThreads(4);
+        parallelFilter->SetSeedBatchSize(8);
+
+        ItkUCharImageType::Pointer seedMask = ItkUCharImageType::New();
+        mitk::CastToItkImage(mitkSeedImage, seedMask);
+        parallelFilter->SetSeedImage(seedMask);
+        ItkUCharImageType::Pointer trackingMask = ItkUCharImageType::New();
+        mitk::CastToItkImage(mitkMaskImage, trackingMask);
+        parallelFilter->SetMaskImage(trackingMask);
+        parallelFilter->Update();
+
+        mitk::FiberBundle::Pointer fib3 = mitk::FiberBundle::New(parallelFilter->GetFiberPolyData());
+        MITK_TEST_CONDITION_REQUIRED(fib3->Equals(fib2), "Check if multi-threaded tractogram is equal.");
+
+        std::vector< unsigned int > numStreamlines = parallelFilter->GetNumberOfStreamlinesPerThread();
+        unsigned int totalStreamlines = 0;
+        for (unsigned int i=0; i<numStreamlines.size(); i++)
+            totalStreamlines += numStreamlines.at(i);
+        MITK_TEST_CONDITION(totalStreamlines==static_cast<unsigned int>(fib3->GetNumFibers()), "Check number of streamlines per thread.");
     }
     catch (itk::ExceptionObject e)
     {
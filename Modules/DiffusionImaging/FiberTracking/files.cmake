@@ -4,6 +4,8 @@ set(CPP_FILES
 
   ## IO datastructures
   IODataStructures/FiberBundle/mitkFiberBundle.cpp
+  IODataStructures/FiberBundle/mitkFiberBundleSegmentIndex.cpp
+  IODataStructures/FiberBundle/mitkStreamlineContainer.cpp
   IODataStructures/FiberBundle/mitkTrackvis.cpp
   IODataStructures/PlanarFigureComposite/mitkPlanarFigureComposite.cpp
 
@@ -21,6 +23,8 @@ set(CPP_FILES
 set(H_FILES
   # DataStructures -> FiberBundle
   IODataStructures/FiberBundle/mitkFiberBundle.h
+  IODataStructures/FiberBundle/mitkFiberBundleSegmentIndex.h
+  IODataStructures/FiberBundle/mitkStreamlineContainer.h
   IODataStructures/FiberBundle/mitkTrackvis.h
   IODataStructures/mitkFiberfoxParameters.h
 
@@ -30,7 +30,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/lexical_cast.hpp>
 #include <mitkCoreObjectFactory.h>
 #include <mitkIOUtil.h>
+#include <mitkTrackvis.h>
 #include <itkFiberCurvatureFilter.h>
+#include <itksys/SystemTools.hxx>
 
 
 mitk::FiberBundle::Pointer LoadFib(std::string filename)
@@ -148,6 +150,24 @@ int main(int argc, char* argv[])
 
     try
     {
+        // TrackVis files that are only filtered by length are processed in chunks, without loading the whole tractogram
+        bool onlyLengthFilter = smoothDist<=0 && compress<=0 && maxAngularDev<=0 && axis==0
+                && rotateX<=0 && rotateY<=0 && rotateZ<=0 && translateX<=0 && translateY<=0 && translateZ<=0
+                && scaleX<=0 && scaleY<=0 && scaleZ<=0;
+        if (onlyLengthFilter
+                && itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(inFileName))==".trk"
+                && itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(outFileName))==".trk")
+        {
+            int numFibers = TrackVisFiberReader::filterByLength(inFileName, outFileName, minFiberLength, maxFiberLength);
+            if (numFibers<0)
+            {
+                std::cout << "File " << inFileName << " could not be filtered!";
+                return EXIT_FAILURE;
+            }
+            std::cout << numFibers << " fibers written";
+            return EXIT_SUCCESS;
+        }
+
         mitk::FiberBundle::Pointer fib = LoadFib(inFileName);
 
         if (minFiberLength>0)
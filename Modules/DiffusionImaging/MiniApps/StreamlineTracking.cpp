@@ -150,6 +150,17 @@ int main(int argc, char* argv[])
 
         filter->Update();
 
+        std::vector< unsigned int > numStreamlines = filter->GetNumberOfStreamlinesPerThread();
+        std::vector< double > trackingTime = filter->GetTrackingTimePerThread();
+        std::vector< unsigned int > stolenBatches = filter->GetNumberOfStolenBatchesPerThread();
+        for (unsigned int i=0; i<numStreamlines.size(); i++)
+        {
+            std::cout << "Thread " << i << ": " << numStreamlines.at(i) << " streamlines in " << trackingTime.at(i) << "s";
+            if (trackingTime.at(i)>0)
+                std::cout << " (" << numStreamlines.at(i)/trackingTime.at(i) << " streamlines/s)";
+            std::cout << ", " << stolenBatches.at(i) << " stolen seed batches" << std::endl;
+        }
+
         vtkSmartPointer<vtkPolyData> fiberBundle = filter->GetFiberPolyData();
         if ( fiberBundle->GetNumberOfLines()==0 )
         {
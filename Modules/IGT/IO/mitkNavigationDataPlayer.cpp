@@ -58,30 +58,21 @@ void mitk::NavigationDataPlayer::GenerateData()
   // imediatly with the first navigation data (not to wait till the first time
   // stamp is reached)
   TimeStampType timeStampSinceStartWithOffset = m_TimeStampSinceStart
-      + m_NavigationDataSet->Begin()->at(0)->GetIGTTimeStamp();
+      + m_NavigationDataSet->GetIGTTimeStampForIndex(0, 0);
 
-  // iterate through all NavigationData objects of the given tool index
-  // till the timestamp of the NavigationData is greater then the given timestamp
-  for (; m_NavigationDataSetIterator != m_NavigationDataSet->End(); ++m_NavigationDataSetIterator)
+  // iterate through all time steps of the first tool
+  // till the timestamp of the successor is greater then the given timestamp
+  unsigned int lastSnapshot = m_NavigationDataSet->Size() - 1;
+  while ( m_CurrentSnapshot < lastSnapshot &&
+          m_NavigationDataSet->GetIGTTimeStampForIndex(m_CurrentSnapshot + 1, 0) <= timeStampSinceStartWithOffset )
   {
-    // test if the timestamp of the successor is greater than the time stamp
-    if ( m_NavigationDataSetIterator+1 == m_NavigationDataSet->End() ||
-        (m_NavigationDataSetIterator+1)->at(0)->GetIGTTimeStamp() > timeStampSinceStartWithOffset )
-    {
-      break;
-    }
+    ++m_CurrentSnapshot;
   }
 
-  for (unsigned int index = 0; index < GetNumberOfOutputs(); index++)
-  {
-    mitk::NavigationData* output = this->GetOutput(index);
-    if( !output ) { mitkThrowException(mitk::IGTException) << "Output of index "<<index<<" is null."; }
-
-    output->Graft(m_NavigationDataSetIterator->at(index));
-  }
+  this->SetOutputsToCurrentSnapshot();
 
   // stop playing if the last NavigationData objects were grafted
-  if (m_NavigationDataSetIterator+1 == m_NavigationDataSet->End())
+  if (m_CurrentSnapshot == lastSnapshot)
   {
     this->StopPlaying();
 
@@ -103,7 +94,7 @@ void mitk::NavigationDataPlayer::StartPlaying()
 
   // set state and iterator for playing from start
   m_CurPlayerState = PlayerRunning;
-  m_NavigationDataSetIterator = m_NavigationDataSet->Begin();
+  m_CurrentSnapshot = 0;
 
   // reset playing timestamps
   m_PauseTimeStamp = 0;
@@ -20,7 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkIGTException.h"
 
 mitk::NavigationDataPlayerBase::NavigationDataPlayerBase()
-  : m_Repeat(false)
+  : m_Repeat(false), m_CurrentSnapshot(0)
 {
   this->SetName("Navigation Data Player Source");
 }
@@ -37,13 +37,13 @@ void mitk::NavigationDataPlayerBase::UpdateOutputInformation()
 
 bool mitk::NavigationDataPlayerBase::IsAtEnd()
 {
-  return m_NavigationDataSetIterator == m_NavigationDataSet->End();
+  return m_CurrentSnapshot >= m_NavigationDataSet->Size();
 }
 
 void mitk::NavigationDataPlayerBase::SetNavigationDataSet(NavigationDataSet::Pointer navigationDataSet)
 {
   m_NavigationDataSet = navigationDataSet;
-  m_NavigationDataSetIterator = navigationDataSet->Begin();
+  m_CurrentSnapshot = 0;
 
   this->InitPlayer();
 }
@@ -55,7 +55,7 @@ unsigned int mitk::NavigationDataPlayerBase::GetNumberOfSnapshots()
 
 unsigned int mitk::NavigationDataPlayerBase::GetCurrentSnapshotNumber()
 {
-  return m_NavigationDataSet.IsNull() ? 0 : m_NavigationDataSetIterator - m_NavigationDataSet->Begin();
+  return m_NavigationDataSet.IsNull() ? 0 : m_CurrentSnapshot;
 }
 
 void mitk::NavigationDataPlayerBase::InitPlayer()
@@ -108,3 +108,14 @@ void mitk::NavigationDataPlayerBase::GraftEmptyOutput()
     output->Graft(nd);
   }
 }
+
+void mitk::NavigationDataPlayerBase::SetOutputsToCurrentSnapshot()
+{
+  for (unsigned int index = 0; index < GetNumberOfOutputs(); index++)
+  {
+    mitk::NavigationData* output = this->GetOutput(index);
+    if( !output ) { mitkThrowException(mitk::IGTException) << "Output of index "<<index<<" is null."; }
+
+    m_NavigationDataSet->CopyNavigationDataForIndex(m_CurrentSnapshot, index, output);
+  }
+}
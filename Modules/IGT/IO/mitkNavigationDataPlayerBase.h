@@ -109,9 +109,16 @@ namespace mitk{
     NavigationDataSet::Pointer m_NavigationDataSet;
 
     /**
-    * \brief Iterator always points to the NavigationData object which is in the outputs at the moment.
+    * \brief Index of the time step which is in the outputs at the moment. Equals the size of the set at the end.
     */
-    mitk::NavigationDataSet::NavigationDataSetConstIterator m_NavigationDataSetIterator;
+    unsigned int m_CurrentSnapshot;
+
+    /**
+    * \brief Copies the values of the current snapshot into the outputs.
+    * The values are read directly from the columns of the set, no intermediate mitk::NavigationData is created.
+    * @throw mitk::IGTException Throws an exception if an output is null.
+    */
+    void SetOutputsToCurrentSnapshot();
   };
 } // namespace mitk
 
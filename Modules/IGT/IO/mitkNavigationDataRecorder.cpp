@@ -16,6 +16,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkNavigationDataRecorder.h"
 #include <mitkIGTTimeStamp.h>
+#include <mitkIGTIOException.h>
+#include <mitkNavigationDataSetBinaryIO.h>
 
 mitk::NavigationDataRecorder::NavigationDataRecorder()
 {
@@ -24,10 +26,13 @@ mitk::NavigationDataRecorder::NavigationDataRecorder()
   m_Recording = false;
   m_StandardizedTimeInitialized = false;
   m_RecordCountLimit = -1;
+  m_StreamBlockSize = 64;
+  m_NumberOfStreamedSteps = 0;
 }
 
 mitk::NavigationDataRecorder::~NavigationDataRecorder()
 {
+  this->CloseStream();
   //mitk::IGTTimeStamp::GetInstance()->Stop(this); //commented out because of bug 18952
 }
 
@@ -36,8 +41,10 @@ void mitk::NavigationDataRecorder::GenerateData()
   // get each input, lookup the associated BaseData and transfer the data
   DataObjectPointerArray inputs = this->GetIndexedInputs(); //get all inputs
 
-  //This vector will hold the NavigationDatas that are copied from the inputs
-  std::vector< mitk::NavigationData::Pointer > clonedDatas;
+  //The NavigationDatas that are copied from the inputs. The objects are reused, the set only copies their values
+  while (m_RecordBuffer.size() < inputs.size())
+    m_RecordBuffer.push_back(mitk::NavigationData::New());
+  m_RecordBuffer.resize(inputs.size());
 
   // For each input
   for (unsigned int index=0; index < inputs.size(); index++)
@@ -48,26 +55,66 @@ void mitk::NavigationDataRecorder::GenerateData()
     // if we are not recording, that's all there is to do
     if (! m_Recording) continue;
 
-    // Clone a Navigation Data
-    mitk::NavigationData::Pointer clone = mitk::NavigationData::New();
-    clone->Graft(this->GetInput(index));
-    clonedDatas.push_back(clone);
+    // Copy the Navigation Data
+    m_RecordBuffer[index]->Graft(this->GetInput(index));
 
     if (m_StandardizeTime)
     {
       mitk::NavigationData::TimeStampType igtTimestamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed(this);
-      clonedDatas[index]->SetIGTTimeStamp(igtTimestamp);
+      m_RecordBuffer[index]->SetIGTTimeStamp(igtTimestamp);
     }
   }
 
   // if limitation is set and has been reached, stop recording
-  if ((m_RecordCountLimit > 0) && (m_NavigationDataSet->Size() >= m_RecordCountLimit)) m_Recording = false;
+  if ((m_RecordCountLimit > 0) && (m_NavigationDataSet->Size() >= m_RecordCountLimit))
+  {
+    m_Recording = false;
+    this->WritePendingTimeSteps();
+  }
   // We can skip the rest of the method, if recording is deactivated
   if  (!m_Recording) return;
 
 
   // Add data to set
-  m_NavigationDataSet->AddNavigationDatas(clonedDatas);
+  m_NavigationDataSet->AddNavigationDatas(m_RecordBuffer);
+
+  if (m_NavigationDataSet->Size() - m_NumberOfStreamedSteps >= m_StreamBlockSize)
+    this->WritePendingTimeSteps();
+}
+
+void mitk::NavigationDataRecorder::WritePendingTimeSteps()
+{
+  if (m_StreamFileName.empty() || m_NavigationDataSet.IsNull() || m_NavigationDataSet->Size() <= m_NumberOfStreamedSteps)
+    return;
+
+  if (!m_Stream.is_open())
+  {
+    m_Stream.open(m_StreamFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_Stream.good())
+    {
+      m_Recording = false;
+      mitkThrowException(mitk::IGTIOException) << "Cannot open stream file " << m_StreamFileName << ".";
+    }
+    // written with the first block, the tool names are known from the first time step
+    mitk::NavigationDataSetBinaryIO::WriteHeader(m_Stream, m_NavigationDataSet);
+  }
+
+  mitk::NavigationDataSetBinaryIO::WriteTimeSteps(m_Stream, m_NavigationDataSet, m_NumberOfStreamedSteps, m_NavigationDataSet->Size());
+  m_NumberOfStreamedSteps = m_NavigationDataSet->Size();
+
+  if (!m_Stream.good())
+  {
+    MITK_ERROR("NavigationDataRecorder") << "Writing to stream file " << m_StreamFileName << " failed.";
+  }
+}
+
+void mitk::NavigationDataRecorder::CloseStream()
+{
+  if (m_Stream.is_open())
+  {
+    this->WritePendingTimeSteps();
+    m_Stream.close();
+  }
 }
 
 void mitk::NavigationDataRecorder::StartRecording()
@@ -85,7 +132,14 @@ void mitk::NavigationDataRecorder::StartRecording()
     mitk::IGTTimeStamp::GetInstance()->Start(this);
 
   if (m_NavigationDataSet.IsNull())
+  {
     m_NavigationDataSet = mitk::NavigationDataSet::New(GetNumberOfIndexedInputs());
+    m_NumberOfStreamedSteps = 0;
+  }
+
+  // the limit is known in advance, so allocate the whole recording at once
+  if (m_RecordCountLimit > 0)
+    m_NavigationDataSet->Reserve(m_RecordCountLimit);
 }
 
 void mitk::NavigationDataRecorder::StopRecording()
@@ -96,10 +150,19 @@ void mitk::NavigationDataRecorder::StopRecording()
     return;
   }
   m_Recording = false;
+
+  this->WritePendingTimeSteps();
+  if (m_Stream.is_open())
+    m_Stream.flush();
 }
 
 void mitk::NavigationDataRecorder::ResetRecording()
 {
+  // the stream file belongs to the old set, the next recording starts a new file
+  this->WritePendingTimeSteps();
+  this->CloseStream();
+  m_NumberOfStreamedSteps = 0;
+
   m_NavigationDataSet = mitk::NavigationDataSet::New(GetNumberOfIndexedInputs());
 
   if (m_Recording)
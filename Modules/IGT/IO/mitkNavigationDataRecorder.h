@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNavigationData.h"
 #include "mitkNavigationDataSet.h"
 
+#include <fstream>
+
 namespace mitk
 {
   /**Documentation
@@ -70,6 +72,22 @@ namespace mitk
     */
     itkSetMacro(StandardizeTime, bool);
 
+    /**
+    * \brief If set, the recorded time steps are additionally streamed to this file in the binary
+    * format of mitk::NavigationDataSetBinaryIO while recording. Time steps are written in blocks of
+    * StreamBlockSize, the remaining ones on StopRecording() and ResetRecording(). The file is created
+    * when recording starts and is overwritten by the next recording after ResetRecording().
+    * Empty by default, i.e. the data is only kept in memory.
+    */
+    itkSetStringMacro(StreamFileName);
+    itkGetStringMacro(StreamFileName);
+
+    /**
+    * \brief Number of time steps which are collected before they are written to the stream file. Default is 64.
+    */
+    itkSetMacro(StreamBlockSize, unsigned int);
+    itkGetMacro(StreamBlockSize, unsigned int);
+
     /**
     * \brief Starts recording NavigationData into the NAvigationDataSet
     */
@@ -115,6 +133,20 @@ namespace mitk
     bool m_StandardizedTimeInitialized; //< set to true the first time start recording is called.
 
     int m_RecordCountLimit; ///< limits the number of frames, recording will be stopped if the limit is reached. -1 disables the limit
+
+    /**
+    * \brief Writes the time steps which were recorded since the last call to the stream file.
+    */
+    void WritePendingTimeSteps();
+
+    void CloseStream();
+
+    std::vector< mitk::NavigationData::Pointer > m_RecordBuffer; ///< reused for every time step, the set only copies the values
+
+    std::string m_StreamFileName;
+    std::ofstream m_Stream;
+    unsigned int m_StreamBlockSize;
+    unsigned int m_NumberOfStreamedSteps; ///< number of time steps of the current set which are already in the stream file
   };
 }
 #endif // #define _MITK_POINT_SET_SOURCE_H
@@ -17,11 +17,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkNavigationDataRecorder.h>
 #include <mitkNavigationDataSequentialPlayer.h>
 #include <mitkNavigationDataSet.h>
+#include <mitkNavigationDataSetBinaryIO.h>
 #include <mitkStandardFileLocations.h>
 #include <mitkTestingMacros.h>
 #include <mitkTestFixture.h>
 #include <mitkIOUtil.h>
 
+#include <cstdio>
+#include <fstream>
+
 //for exceptions
 #include "mitkIGTException.h"
 #include "mitkIGTIOException.h"
@@ -32,6 +36,7 @@ class mitkNavigationDataRecorderTestSuite : public mitk::TestFixture
   MITK_TEST(TestRecording);
   MITK_TEST(TestStopRecording);
   MITK_TEST(TestLimiting);
+  MITK_TEST(TestStreaming);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -117,6 +122,28 @@ public:
     MITK_TEST_CONDITION_REQUIRED(m_Recorder->GetNavigationDataSet()->Size() == 30, "Test if SetRecordCountLimit works as intended.");
   }
 
+  void TestStreaming()
+  {
+    std::string streamFile = mitk::IOUtil::CreateTemporaryFile("NavigationDataRecorderTest_XXXXXX.nds");
+    m_Recorder->SetStreamFileName(streamFile);
+    m_Recorder->SetStreamBlockSize(7);
+    m_Recorder->StartRecording();
+    while (!m_Player->IsAtEnd())
+    {
+      m_Recorder->Update();
+      m_Player->GoToNextSnapshot();
+    }
+    m_Recorder->StopRecording();
+
+    std::ifstream file(streamFile.c_str(), std::ios::in | std::ios::binary);
+    mitk::NavigationDataSet::Pointer streamedData = mitk::NavigationDataSetBinaryIO::Read(file);
+    file.close();
+    std::remove(streamFile.c_str());
+
+    MITK_TEST_CONDITION_REQUIRED(streamedData->Size() == m_NavigationDataSet->Size(), "Test if streamed Dataset is of equal size as original");
+    MITK_TEST_CONDITION_REQUIRED(compareDataSet(streamedData), "Test streamed dataset for equality with reference");
+  }
+
 private:
 
   /*
@@ -17,6 +17,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkTestingMacros.h"
 #include "mitkNavigationData.h"
 #include "mitkNavigationDataSet.h"
+#include "mitkNavigationDataSetBinaryIO.h"
+#include "mitkIGTIOException.h"
+
+#include <sstream>
 
 static void TestEmptySet()
 {
@@ -63,22 +67,127 @@ static void TestSetAndGet()
   MITK_TEST_CONDITION_REQUIRED(!(navigationDataSet->AddNavigationDatas(step3)),
     "Adding an invalid third set, should be unsusuccessful.");
 
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(0, 0) == nd11,
+  // the set stores copies of the values, not the objects
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(0, 0), *nd11),
     "First NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(0, 1) == nd21,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(0, 1), *nd21),
     "Second NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(1, 0) == nd12,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(1, 0), *nd12),
     "First NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(1, 1) == nd22,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(1, 1), *nd22),
     "Second NavigationData object for tool 0 should be the same as added previously.");
 
   std::vector<mitk::NavigationData::Pointer> result = navigationDataSet->GetTimeStep(1);
-  MITK_TEST_CONDITION_REQUIRED(nd12 == result[0],"Comparing returned datas from GetTimeStep().");
-  MITK_TEST_CONDITION_REQUIRED(nd22 == result[1],"Comparing returned datas from GetTimeStep().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd12, *result[0]),"Comparing returned datas from GetTimeStep().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd22, *result[1]),"Comparing returned datas from GetTimeStep().");
 
   result = navigationDataSet->GetDataStreamForTool(1);
-  MITK_TEST_CONDITION_REQUIRED(nd21 == result[0],"Comparing returned datas from GetStreamForTool().");
-  MITK_TEST_CONDITION_REQUIRED(nd22 == result[1],"Comparing returned datas from GetStreamForTool().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd21, *result[0]),"Comparing returned datas from GetStreamForTool().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd22, *result[1]),"Comparing returned datas from GetStreamForTool().");
+}
+
+static mitk::NavigationDataSet::Pointer CreateLargeSet(unsigned int size)
+{
+  mitk::NavigationDataSet::Pointer navigationDataSet = mitk::NavigationDataSet::New(2);
+
+  std::vector<mitk::NavigationData::Pointer> step;
+  step.push_back(mitk::NavigationData::New());
+  step.push_back(mitk::NavigationData::New());
+  step[0]->SetName("Tool0");
+  step[1]->SetName("Tool1");
+
+  for (unsigned int i = 0; i < size; i++)
+  {
+    for (unsigned int tool = 0; tool < 2; tool++)
+    {
+      mitk::NavigationData::PositionType position;
+      mitk::FillVector3D(position, i, tool, -1.0 * i);
+      mitk::NavigationData::OrientationType orientation(0.0, 0.0, 0.0, 1.0);
+      orientation[tool] = 0.5;
+      step[tool]->SetPosition(position);
+      step[tool]->SetOrientation(orientation);
+      step[tool]->SetIGTTimeStamp(10.0 * i + tool);
+      step[tool]->SetDataValid(i % 3 != 0);
+      step[tool]->SetHasOrientation(tool == 0);
+    }
+    // only the last chunk gets a covariance column
+    if (i == size - 2)
+      step[1]->SetPositionAccuracy(0.25);
+    if (i == size - 1)
+      step[1]->SetPositionAccuracy(1.0);
+
+    navigationDataSet->AddNavigationDatas(step);
+  }
+  return navigationDataSet;
+}
+
+static bool CompareLargeSet(mitk::NavigationDataSet* navigationDataSet, unsigned int size)
+{
+  if (navigationDataSet->Size() != size || navigationDataSet->GetNumberOfTools() != 2)
+    return false;
+
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+  for (unsigned int i = 0; i < size; i++)
+  {
+    for (unsigned int tool = 0; tool < 2; tool++)
+    {
+      if (!navigationDataSet->CopyNavigationDataForIndex(i, tool, nd))
+        return false;
+      if (!mitk::Equal(nd->GetPosition()[0], static_cast<double>(i)) || !mitk::Equal(nd->GetPosition()[2], -1.0 * i))
+        return false;
+      if (!mitk::Equal(nd->GetOrientation()[tool], 0.5) || !mitk::Equal(nd->GetIGTTimeStamp(), 10.0 * i + tool))
+        return false;
+      if (nd->IsDataValid() != (i % 3 != 0) || nd->GetHasOrientation() != (tool == 0))
+        return false;
+      if (nd->GetName() != (tool == 0 ? "Tool0" : "Tool1"))
+        return false;
+
+      double expectedCovariance = (tool == 1 && i == size - 2) ? 0.0625 : 1.0;
+      if (!mitk::Equal(nd->GetCovErrorMatrix()[2][2], expectedCovariance) || !mitk::Equal(nd->GetCovErrorMatrix()[4][4], 1.0))
+        return false;
+    }
+  }
+  return true;
+}
+
+static void TestChunkedStorage()
+{
+  unsigned int size = 2 * mitk::NavigationDataSet::ChunkSize + 10;
+  mitk::NavigationDataSet::Pointer navigationDataSet = CreateLargeSet(size);
+
+  MITK_TEST_CONDITION_REQUIRED(CompareLargeSet(navigationDataSet, size), "Values spanning several chunks are stored correctly.");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(navigationDataSet->GetIGTTimeStampForIndex(size - 1, 1), 10.0 * (size - 1) + 1),
+    "Timestamps can be read without creating NavigationData objects.");
+  MITK_TEST_CONDITION_REQUIRED(!navigationDataSet->CopyNavigationDataForIndex(size, 0, mitk::NavigationData::New()),
+    "Copying from an index behind the end fails.");
+
+  mitk::NavigationDataSet::Pointer reserved = mitk::NavigationDataSet::New(2);
+  reserved->Reserve(mitk::NavigationDataSet::ChunkSize + 1);
+  MITK_TEST_CONDITION_REQUIRED(reserved->Size() == 0 && reserved->IsEmpty(), "Reserving does not add time steps.");
+}
+
+static void TestBinaryReadWrite()
+{
+  unsigned int size = mitk::NavigationDataSet::ChunkSize + 10;
+  mitk::NavigationDataSet::Pointer navigationDataSet = CreateLargeSet(size);
+
+  std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+  mitk::NavigationDataSetBinaryIO::WriteHeader(stream, navigationDataSet);
+  // written in two blocks, as done while recording
+  mitk::NavigationDataSetBinaryIO::WriteTimeSteps(stream, navigationDataSet, 0, 100);
+  mitk::NavigationDataSetBinaryIO::WriteTimeSteps(stream, navigationDataSet, 100, size);
+
+  mitk::NavigationDataSet::Pointer readSet = mitk::NavigationDataSetBinaryIO::Read(stream);
+  MITK_TEST_CONDITION_REQUIRED(CompareLargeSet(readSet, size), "Binary read / write cycle restores all values.");
+
+  // a recording which was cut off while writing
+  std::string content = stream.str();
+  std::stringstream truncated(content.substr(0, content.size() - 20), std::ios::in | std::ios::binary);
+  readSet = mitk::NavigationDataSetBinaryIO::Read(truncated);
+  MITK_TEST_CONDITION_REQUIRED(readSet->Size() == size - 1, "Incomplete last time step is skipped.");
+
+  std::stringstream invalid("no navigation data", std::ios::in | std::ios::binary);
+  MITK_TEST_FOR_EXCEPTION(mitk::IGTIOException, mitk::NavigationDataSetBinaryIO::Read(invalid));
 }
 
 /**
@@ -90,6 +199,8 @@ int mitkNavigationDataSetTest(int /* argc */, char* /*argv*/[])
 
   TestEmptySet();
   TestSetAndGet();
+  TestChunkedStorage();
+  TestBinaryReadWrite();
 
   MITK_TEST_END();
 }
\ No newline at end of file
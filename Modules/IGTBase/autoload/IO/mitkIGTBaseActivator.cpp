@@ -20,6 +20,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkNavigationDataSetWriterCSV.h>
 #include <mitkNavigationDataReaderCSV.h>
 #include <mitkNavigationDataReaderXML.h>
+#include <mitkNavigationDataSetWriterBinary.h>
+#include <mitkNavigationDataReaderBinary.h>
 
 namespace mitk {
 
@@ -29,6 +31,8 @@ void IOExtActivator::Load(us::ModuleContext*)
   m_NavigationDataSetWriterCSV.reset(new NavigationDataSetWriterCSV());
   m_NavigationDataReaderCSV.reset(new NavigationDataReaderCSV());
   m_NavigationDataReaderXML.reset(new NavigationDataReaderXML());
+  m_NavigationDataSetWriterBinary.reset(new NavigationDataSetWriterBinary());
+  m_NavigationDataReaderBinary.reset(new NavigationDataReaderBinary());
 
 }
 
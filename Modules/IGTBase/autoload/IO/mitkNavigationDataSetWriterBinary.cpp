@@ -0,0 +1,64 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// MITK
+#include "mitkNavigationDataSetWriterBinary.h"
+#include <mitkIGTMimeTypes.h>
+#include <mitkIGTIOException.h>
+#include <mitkNavigationDataSetBinaryIO.h>
+
+// STL
+#include <fstream>
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary() : AbstractFileWriter(NavigationDataSet::GetStaticNameOfClass(),
+  mitk::IGTMimeTypes::NAVIGATIONDATASETBINARY_MIMETYPE(),
+  "MITK NavigationDataSet Writer (binary)")
+{
+  RegisterService();
+}
+
+mitk::NavigationDataSetWriterBinary::~NavigationDataSetWriterBinary()
+{
+}
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary(const mitk::NavigationDataSetWriterBinary& other) : AbstractFileWriter(other)
+{
+}
+
+mitk::NavigationDataSetWriterBinary* mitk::NavigationDataSetWriterBinary::Clone() const
+{
+  return new NavigationDataSetWriterBinary(*this);
+}
+
+void mitk::NavigationDataSetWriterBinary::Write()
+{
+  mitk::NavigationDataSet::ConstPointer data = dynamic_cast<const NavigationDataSet*> (this->GetInput());
+
+  std::ostream* out = GetOutputStream();
+  if (out != nullptr)
+  {
+    NavigationDataSetBinaryIO::Write(*out, data);
+    out->flush();
+    return;
+  }
+
+  std::ofstream file(GetOutputLocation().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << GetOutputLocation() << "' could not be opened for writing.";
+  }
+  NavigationDataSetBinaryIO::Write(file, data);
+}
@@ -0,0 +1,42 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
+#define MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
+
+#include <mitkNavigationDataSet.h>
+#include <mitkAbstractFileWriter.h>
+
+namespace mitk {
+  /** Writes navigation data sets in the binary format of mitk::NavigationDataSetBinaryIO. */
+  class NavigationDataSetWriterBinary : public AbstractFileWriter
+  {
+  public:
+
+    NavigationDataSetWriterBinary();
+    virtual~NavigationDataSetWriterBinary();
+
+    using AbstractFileWriter::Write;
+    virtual void Write() override;
+
+  protected:
+
+    NavigationDataSetWriterBinary(const NavigationDataSetWriterBinary& other);
+    virtual mitk::NavigationDataSetWriterBinary* Clone() const override;
+  };
+}
+
+#endif // MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
@@ -87,11 +87,12 @@ void mitk::NavigationDataSetWriterXML::StreamHeader (std::ostream* stream, mitk:
 void mitk::NavigationDataSetWriterXML::StreamData (std::ostream* stream, mitk::NavigationDataSet::ConstPointer data)
 {
   // For each time step in the Dataset
-  for (auto it = data->Begin(); it != data->End(); it++)
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+  for (unsigned int index = 0; index < data->Size(); index++)
   {
-    for (std::size_t toolIndex = 0; toolIndex < it->size(); toolIndex++)
+    for (unsigned int toolIndex = 0; toolIndex < data->GetNumberOfTools(); toolIndex++)
     {
-      mitk::NavigationData::Pointer nd = it->at(toolIndex);
+      data->CopyNavigationDataForIndex(index, toolIndex, nd);
       auto  elem = new TiXmlElement("ND");
 
       elem->SetDoubleAttribute("Time", nd->GetIGTTimeStamp());
@@ -21,11 +21,21 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseData.h"
 #include "mitkNavigationData.h"
 
+#include <memory>
+
 namespace mitk {
   /**
   * \brief Data structure which stores streams of mitk::NavigationData for
   * multiple tools.
   *
+  * The values are not kept as mitk::NavigationData objects but in columns
+  * (timestamps, positions, orientations, flags and error covariances) which are
+  * allocated in chunks of ChunkSize time steps. Adding a time step therefore
+  * only copies values and long recordings at high rates neither allocate a
+  * data object per sample nor move the recorded data when the set grows.
+  * Covariance columns are only allocated for chunks which contain a sample
+  * with a covariance different from the identity.
+  *
   * Use mitk::NavigationDataRecorder to create these sets easily from pipelines.
   * Use mitk::NavigationDataPlayer to stream from these sets easily.
   *
@@ -34,44 +44,54 @@ namespace mitk {
   {
   public:
 
-    /**
-    * \brief This iterator iterates over the distinct time steps in this set.
-    *
-    * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
-    */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::iterator NavigationDataSetIterator;
-
-    /**
-    * \brief This iterator iterates over the distinct time steps in this set. And is const.
-    *
-    * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
-    */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::const_iterator NavigationDataSetConstIterator;
-
     mitkClassMacro(NavigationDataSet, BaseData);
 
     mitkNewMacro1Param(Self, unsigned int);
 
+    /**
+    * \brief Number of time steps stored in one chunk of the columns.
+    */
+    static const unsigned int ChunkSize = 4096;
+
     /**
     * \brief Add mitk::NavigationData of the given tool to the Set.
     *
+    * The values of the objects are copied, the objects itself are not referenced by the set.
+    *
     * @param navigationDatas vector of mitk::NavigationData objects to be added. Make sure that the size of the
     * vector equals the number of tools given in the constructor
     * @return true if object was be added to the set successfully, false otherwise
     */
-    bool AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas );
+    bool AddNavigationDatas( const std::vector<mitk::NavigationData::Pointer>& navigationDatas );
+
+    /**
+    * \brief Preallocates the columns for the given number of time steps.
+    */
+    void Reserve( unsigned int numberOfTimeSteps );
 
     /**
     * \brief Get mitk::NavigationData from the given tool at given index.
     *
+    * A new object is created for each call. Use CopyNavigationDataForIndex() to fill an existing one.
+    *
     * @param toolIndex Index of the tool from which mitk::NavigationData should be returned.
     * @param index Index of the mitk::NavigationData object that should be returned.
     * @return mitk::NavigationData at the specified indices, 0 if there is no object at the indices.
     */
     NavigationData::Pointer GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const;
 
+    /**
+    * \brief Copies the values of the given tool at given index into an existing mitk::NavigationData.
+    *
+    * @return false if there is no data at the indices, the target is not changed in this case.
+    */
+    bool CopyNavigationDataForIndex( unsigned int index, unsigned int toolIndex, mitk::NavigationData* target ) const;
+
+    /**
+    * \brief Returns the IGT timestamp of the given tool at given index without creating a mitk::NavigationData.
+    */
+    NavigationData::TimeStampType GetIGTTimeStampForIndex( unsigned int index, unsigned int toolIndex ) const;
+
     ///**
     //* \brief Get last mitk::Navigation object for given tool whose timestamp is less than the given timestamp.
     //* @param toolIndex Index of the tool from which mitk::NavigationData should be returned.
@@ -84,7 +104,8 @@ namespace mitk {
     /**
     * \brief Returns a vector that contains all tracking data for a given tool.
     *
-    * This is a relatively expensive operation, as it requires the construction of a new vector.
+    * This is a relatively expensive operation, as it requires the construction of a new vector and
+    * a new mitk::NavigationData for each time step.
     *
     * @param toolIndex Index of the tool for which the stream should be returned.
     * @return Returns a vector that contains all tracking data for a given tool.
@@ -121,18 +142,10 @@ namespace mitk {
     unsigned int Size() const;
 
     /**
-    * \brief Returns an iterator pointing to the first TimeStep.
-    *
-    * @return Returns an iterator pointing to the first TimeStep.
-    */
-    virtual NavigationDataSetConstIterator Begin() const;
-
-    /**
-    * \brief Returns an iterator pointing behind to the last TimeStep.
-    *
-    * @return Returns an iterator pointing behind to the last TimeStep.
+    * \brief Name of the tool. Taken from the first time step that was added, if not set explicitly.
     */
-    virtual NavigationDataSetConstIterator End() const;
+    std::string GetToolName( unsigned int toolIndex ) const;
+    void SetToolName( unsigned int toolIndex, const std::string& name );
 
     // virtual methods, that need to be implemented, but aren't reasonable for NavigationData
     virtual void SetRequestedRegionToLargestPossibleRegion( ) override;
@@ -153,18 +166,48 @@ namespace mitk {
     NavigationDataSet( unsigned int numTools );
     virtual ~NavigationDataSet( );
 
+    enum SampleFlags
+    {
+      DataValid = 1,
+      HasPosition = 2,
+      HasOrientation = 4
+    };
+
     /**
-    * \brief Holds all the mitk::NavigationData objects managed by this class.
+    * \brief Columns of ChunkSize time steps.
     *
-    * The first dimension is the index of the navigation data, the second is the
-    * tool to which this data belongs. i.e. the first dimension is usually the longer one.
+    * The values of all tools of a time step are stored next to each other, i.e. the
+    * sample of a tool is at (index % ChunkSize) * m_NumberOfTools + toolIndex, times the
+    * number of components. m_Covariances is empty as long as all samples of the chunk have
+    * the identity as covariance.
+    */
+    struct Chunk
+    {
+      std::vector< NavigationData::TimeStampType > m_TimeStamps;
+      std::vector< ScalarType > m_Positions;      ///< 3 per sample
+      std::vector< ScalarType > m_Orientations;   ///< 4 per sample, x y z r
+      std::vector< unsigned char > m_Flags;       ///< SampleFlags
+      std::vector< ScalarType > m_Covariances;    ///< 36 per sample, row major
+    };
+
+    Chunk* AllocateChunk() const;
+
+    /**
+    * \brief Holds all values managed by this class. Chunks are only appended, never moved.
     */
-    std::vector<std::vector<NavigationData::Pointer> > m_NavigationDataVectors;
+    std::vector< std::unique_ptr<Chunk> > m_Chunks;
+
+    /**
+    * \brief Number of time steps stored in m_Chunks.
+    */
+    unsigned int m_Size;
 
     /**
     * \brief The Number of Tools that this class is going to support.
     */
     unsigned int m_NumberOfTools;
+
+    std::vector< std::string > m_ToolNames;
   };
 }
 
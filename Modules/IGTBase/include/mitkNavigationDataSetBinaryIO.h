@@ -0,0 +1,66 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNAVIGATIONDATASETBINARYIO_H_HEADER_INCLUDED_
+#define MITKNAVIGATIONDATASETBINARYIO_H_HEADER_INCLUDED_
+
+#include <MitkIGTBaseExports.h>
+#include "mitkNavigationDataSet.h"
+
+#include <iostream>
+
+namespace mitk {
+  /**
+  * \brief Binary file format of mitk::NavigationDataSet.
+  *
+  * The format is written time step by time step, so a recording can be streamed to disk while it
+  * is running (see mitk::NavigationDataRecorder::SetStreamFileName()) and a file which was cut off
+  * by a crash can still be read up to the last complete time step.
+  *
+  * Layout: the header consists of the magic "MITKNDS" followed by a zero byte, the version, a byte order
+  * mark, the number of tools and the tool names (length + characters), all integers as 32 bit unsigned.
+  * Each time step holds for every tool the IGT timestamp, the position (3), the orientation (4, x y z r),
+  * all as double, followed by a flag byte. If bit 3 of the flags is set, the 6x6 error covariance follows
+  * (36 doubles, row major), otherwise the covariance is the identity. Values are stored in the byte order of
+  * the writing machine, files with another byte order are rejected.
+  */
+  class MITKIGTBASE_EXPORT NavigationDataSetBinaryIO
+  {
+  public:
+    /**
+    * \brief Writes the header. The tool names are taken from the set, so write the header after the first time step was added.
+    */
+    static void WriteHeader(std::ostream& stream, const mitk::NavigationDataSet* data);
+
+    /**
+    * \brief Writes the time steps [first, end) of the set.
+    */
+    static void WriteTimeSteps(std::ostream& stream, const mitk::NavigationDataSet* data, unsigned int first, unsigned int end);
+
+    /**
+    * \brief Writes header and all time steps.
+    */
+    static void Write(std::ostream& stream, const mitk::NavigationDataSet* data);
+
+    /**
+    * \brief Reads a set from the stream. An incomplete last time step is skipped with a warning.
+    * @throw mitk::IGTIOException Throws an exception if the header is invalid.
+    */
+    static mitk::NavigationDataSet::Pointer Read(std::istream& stream);
+  };
+}
+
+#endif // MITKNAVIGATIONDATASETBINARYIO_H_HEADER_INCLUDED_
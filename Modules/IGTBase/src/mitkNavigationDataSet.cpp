@@ -17,7 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNavigationDataSet.h"
 
 mitk::NavigationDataSet::NavigationDataSet( unsigned int numberOfTools )
-  : m_NavigationDataVectors(std::vector<std::vector<mitk::NavigationData::Pointer> >()), m_NumberOfTools(numberOfTools)
+  : m_Size(0), m_NumberOfTools(numberOfTools), m_ToolNames(numberOfTools)
 {
 }
 
@@ -25,7 +25,26 @@ mitk::NavigationDataSet::~NavigationDataSet( )
 {
 }
 
-bool mitk::NavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas )
+mitk::NavigationDataSet::Chunk* mitk::NavigationDataSet::AllocateChunk() const
+{
+  auto chunk = new Chunk;
+  std::size_t numberOfSamples = static_cast<std::size_t>(ChunkSize) * m_NumberOfTools;
+  chunk->m_TimeStamps.resize(numberOfSamples);
+  chunk->m_Positions.resize(3 * numberOfSamples);
+  chunk->m_Orientations.resize(4 * numberOfSamples);
+  chunk->m_Flags.resize(numberOfSamples);
+  return chunk;
+}
+
+void mitk::NavigationDataSet::Reserve( unsigned int numberOfTimeSteps )
+{
+  std::size_t requiredChunks = (static_cast<std::size_t>(numberOfTimeSteps) + ChunkSize - 1) / ChunkSize;
+  m_Chunks.reserve(requiredChunks);
+  while (m_Chunks.size() < requiredChunks)
+    m_Chunks.push_back(std::unique_ptr<Chunk>(this->AllocateChunk()));
+}
+
+bool mitk::NavigationDataSet::AddNavigationDatas( const std::vector<mitk::NavigationData::Pointer>& navigationDatas )
 {
   // test if tool with given index exist
   if ( navigationDatas.size() != m_NumberOfTools )
@@ -35,35 +54,141 @@ bool mitk::NavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationDa
   }
 
   // test for consistent timestamp
-  if ( m_NavigationDataVectors.size() > 0)
+  if ( m_Size > 0)
   {
     for (std::vector<mitk::NavigationData::Pointer>::size_type i = 0; i < navigationDatas.size(); i++)
-      if (navigationDatas[i]->GetIGTTimeStamp() <= m_NavigationDataVectors.back()[i]->GetIGTTimeStamp())
+      if (navigationDatas[i]->GetIGTTimeStamp() <= this->GetIGTTimeStampForIndex(m_Size - 1, i))
       {
         MITK_WARN("NavigationDataSet") << "IGTTimeStamp of new NavigationData should be newer than timestamp of last NavigationData.";
         return false;
       }
   }
+  else
+  {
+    for (unsigned int i = 0; i < m_NumberOfTools; i++)
+      if (m_ToolNames[i].empty())
+        m_ToolNames[i] = navigationDatas[i]->GetName();
+  }
+
+  if ( m_Size / ChunkSize >= m_Chunks.size() )
+    m_Chunks.push_back(std::unique_ptr<Chunk>(this->AllocateChunk()));
+
+  Chunk* chunk = m_Chunks[m_Size / ChunkSize].get();
+  std::size_t sample = static_cast<std::size_t>(m_Size % ChunkSize) * m_NumberOfTools;
+
+  for (unsigned int i = 0; i < m_NumberOfTools; i++, sample++)
+  {
+    const mitk::NavigationData* nd = navigationDatas[i];
+
+    chunk->m_TimeStamps[sample] = nd->GetIGTTimeStamp();
+
+    const mitk::NavigationData::PositionType& position = nd->GetPosition();
+    for (int d = 0; d < 3; d++)
+      chunk->m_Positions[3 * sample + d] = position[d];
+
+    const mitk::NavigationData::OrientationType& orientation = nd->GetOrientation();
+    for (int d = 0; d < 4; d++)
+      chunk->m_Orientations[4 * sample + d] = orientation[d];
+
+    chunk->m_Flags[sample] = (nd->IsDataValid() ? DataValid : 0)
+      | (nd->GetHasPosition() ? HasPosition : 0)
+      | (nd->GetHasOrientation() ? HasOrientation : 0);
 
-  m_NavigationDataVectors.push_back(navigationDatas);
+    // covariances are rarely set by tracking devices, keep the column empty as long as possible
+    const mitk::NavigationData::CovarianceMatrixType& covariance = nd->GetCovErrorMatrix();
+    bool isIdentity = true;
+    for (int r = 0; r < 6 && isIdentity; r++)
+      for (int c = 0; c < 6 && isIdentity; c++)
+        isIdentity = covariance[r][c] == (r == c ? 1.0 : 0.0);
+
+    if (!isIdentity && chunk->m_Covariances.empty())
+    {
+      chunk->m_Covariances.assign(36 * chunk->m_Flags.size(), 0.0);
+      for (std::size_t s = 0; s < chunk->m_Flags.size(); s++)
+        for (int d = 0; d < 6; d++)
+          chunk->m_Covariances[36 * s + 7 * d] = 1.0;
+    }
+
+    if (!chunk->m_Covariances.empty())
+    {
+      for (int r = 0; r < 6; r++)
+        for (int c = 0; c < 6; c++)
+          chunk->m_Covariances[36 * sample + 6 * r + c] = covariance[r][c];
+    }
+  }
+
+  ++m_Size;
   return true;
 }
 
 mitk::NavigationData::Pointer mitk::NavigationDataSet::GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const
 {
-  if ( index >= m_NavigationDataVectors.size() )
+  if ( index >= m_Size )
   {
     MITK_WARN("NavigationDataSet") << "There is no NavigationData available at index " << index << ".";
     return nullptr;
   }
 
-  if ( toolIndex >= m_NavigationDataVectors.at(index).size() )
+  if ( toolIndex >= m_NumberOfTools )
   {
     MITK_WARN("NavigationDataSet") << "There is NavigatitionData available at index " << index << " for tool " << toolIndex << ".";
     return nullptr;
   }
 
-  return m_NavigationDataVectors.at(index).at(toolIndex);
+  mitk::NavigationData::Pointer result = mitk::NavigationData::New();
+  this->CopyNavigationDataForIndex(index, toolIndex, result);
+  return result;
+}
+
+bool mitk::NavigationDataSet::CopyNavigationDataForIndex( unsigned int index, unsigned int toolIndex, mitk::NavigationData* target ) const
+{
+  if ( index >= m_Size || toolIndex >= m_NumberOfTools || target == nullptr )
+    return false;
+
+  const Chunk* chunk = m_Chunks[index / ChunkSize].get();
+  std::size_t sample = static_cast<std::size_t>(index % ChunkSize) * m_NumberOfTools + toolIndex;
+
+  mitk::NavigationData::PositionType position;
+  for (int d = 0; d < 3; d++)
+    position[d] = chunk->m_Positions[3 * sample + d];
+
+  const ScalarType* o = &chunk->m_Orientations[4 * sample];
+  mitk::NavigationData::OrientationType orientation(o[0], o[1], o[2], o[3]);
+
+  mitk::NavigationData::CovarianceMatrixType covariance;
+  if (chunk->m_Covariances.empty())
+  {
+    covariance.SetIdentity();
+  }
+  else
+  {
+    for (int r = 0; r < 6; r++)
+      for (int c = 0; c < 6; c++)
+        covariance[r][c] = chunk->m_Covariances[36 * sample + 6 * r + c];
+  }
+
+  unsigned char flags = chunk->m_Flags[sample];
+
+  target->SetPosition(position);
+  target->SetOrientation(orientation);
+  target->SetDataValid((flags & DataValid) != 0);
+  target->SetIGTTimeStamp(chunk->m_TimeStamps[sample]);
+  target->SetHasPosition((flags & HasPosition) != 0);
+  target->SetHasOrientation((flags & HasOrientation) != 0);
+  target->SetCovErrorMatrix(covariance);
+  target->SetName(m_ToolNames[toolIndex]);
+  return true;
+}
+
+mitk::NavigationData::TimeStampType mitk::NavigationDataSet::GetIGTTimeStampForIndex( unsigned int index, unsigned int toolIndex ) const
+{
+  if ( index >= m_Size || toolIndex >= m_NumberOfTools )
+  {
+    MITK_WARN("NavigationDataSet") << "There is no NavigationData available at index " << index << " for tool " << toolIndex << ".";
+    return 0.0;
+  }
+
+  return m_Chunks[index / ChunkSize]->m_TimeStamps[static_cast<std::size_t>(index % ChunkSize) * m_NumberOfTools + toolIndex];
 }
 
 // Method not yet supported, code below compiles but delivers wrong results
@@ -106,16 +231,23 @@ std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetDataStr
   }
 
   std::vector< mitk::NavigationData::Pointer > result;
+  result.reserve(m_Size);
 
-  for(std::vector<std::vector<NavigationData::Pointer> >::size_type i = 0; i < m_NavigationDataVectors.size(); i++)
-    result.push_back(m_NavigationDataVectors[i][toolIndex]);
+  for(unsigned int i = 0; i < m_Size; i++)
+    result.push_back(this->GetNavigationDataForIndex(i, toolIndex));
 
   return result;
 }
 
 std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetTimeStep(unsigned int index) const
 {
-  return m_NavigationDataVectors[index];
+  std::vector< mitk::NavigationData::Pointer > result;
+  result.reserve(m_NumberOfTools);
+
+  for(unsigned int toolIndex = 0; toolIndex < m_NumberOfTools; toolIndex++)
+    result.push_back(this->GetNavigationDataForIndex(index, toolIndex));
+
+  return result;
 }
 
 unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
@@ -125,7 +257,22 @@ unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
 
 unsigned int mitk::NavigationDataSet::Size() const
 {
-  return m_NavigationDataVectors.size();
+  return m_Size;
+}
+
+std::string mitk::NavigationDataSet::GetToolName( unsigned int toolIndex ) const
+{
+  return toolIndex < m_NumberOfTools ? m_ToolNames[toolIndex] : std::string();
+}
+
+void mitk::NavigationDataSet::SetToolName( unsigned int toolIndex, const std::string& name )
+{
+  if (toolIndex >= m_NumberOfTools)
+  {
+    MITK_WARN("NavigationDataSet") << "Invalid toolIndex: " << m_NumberOfTools << " Tools known, requested index " << toolIndex << "";
+    return;
+  }
+  m_ToolNames[toolIndex] = name;
 }
 
 // ---> methods necessary for BaseData
@@ -153,15 +300,3 @@ bool mitk::NavigationDataSet::IsEmpty() const
 }
 
 // <--- methods necessary for BaseData
-
-// ---> methods for Iterators
-
-mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::Begin() const
-{
-  return m_NavigationDataVectors.cbegin();
-}
-
-mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::End() const
-{
-  return m_NavigationDataVectors.cend();
-}
@@ -0,0 +1,218 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataSetBinaryIO.h"
+#include "mitkIGTIOException.h"
+
+#include <cstring>
+
+namespace
+{
+  const char Magic[8] = { 'M', 'I', 'T', 'K', 'N', 'D', 'S', '\0' };
+  const unsigned int Version = 1;
+  const unsigned int ByteOrderMark = 0x01020304;
+  const unsigned char HasCovarianceFlag = 8;
+
+  template <typename T>
+  void WriteValue(std::ostream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  bool ReadValue(std::istream& stream, T& value)
+  {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return stream.gcount() == static_cast<std::streamsize>(sizeof(T));
+  }
+}
+
+void mitk::NavigationDataSetBinaryIO::WriteHeader(std::ostream& stream, const mitk::NavigationDataSet* data)
+{
+  stream.write(Magic, sizeof(Magic));
+  WriteValue(stream, Version);
+  WriteValue(stream, ByteOrderMark);
+
+  unsigned int numberOfTools = data->GetNumberOfTools();
+  WriteValue(stream, numberOfTools);
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+  {
+    std::string name = data->GetToolName(toolIndex);
+    unsigned int length = static_cast<unsigned int>(name.size());
+    WriteValue(stream, length);
+    stream.write(name.data(), length);
+  }
+}
+
+void mitk::NavigationDataSetBinaryIO::WriteTimeSteps(std::ostream& stream, const mitk::NavigationDataSet* data, unsigned int first, unsigned int end)
+{
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+  mitk::NavigationData::CovarianceMatrixType identity;
+  identity.SetIdentity();
+
+  // one record of a tool without covariance: timestamp, position, orientation and flags
+  char record[8 * sizeof(double) + 1];
+
+  for (unsigned int index = first; index < end && index < data->Size(); index++)
+  {
+    for (unsigned int toolIndex = 0; toolIndex < data->GetNumberOfTools(); toolIndex++)
+    {
+      data->CopyNavigationDataForIndex(index, toolIndex, nd);
+
+      double values[8];
+      values[0] = nd->GetIGTTimeStamp();
+      for (int d = 0; d < 3; d++)
+        values[1 + d] = nd->GetPosition()[d];
+      for (int d = 0; d < 4; d++)
+        values[4 + d] = nd->GetOrientation()[d];
+
+      const mitk::NavigationData::CovarianceMatrixType& covariance = nd->GetCovErrorMatrix();
+      bool hasCovariance = covariance != identity;
+
+      unsigned char flags = (nd->IsDataValid() ? 1 : 0)
+        | (nd->GetHasPosition() ? 2 : 0)
+        | (nd->GetHasOrientation() ? 4 : 0)
+        | (hasCovariance ? HasCovarianceFlag : 0);
+
+      std::memcpy(record, values, sizeof(values));
+      record[sizeof(values)] = static_cast<char>(flags);
+      stream.write(record, sizeof(record));
+
+      if (hasCovariance)
+      {
+        for (int r = 0; r < 6; r++)
+          for (int c = 0; c < 6; c++)
+            WriteValue(stream, static_cast<double>(covariance[r][c]));
+      }
+    }
+  }
+}
+
+void mitk::NavigationDataSetBinaryIO::Write(std::ostream& stream, const mitk::NavigationDataSet* data)
+{
+  WriteHeader(stream, data);
+  WriteTimeSteps(stream, data, 0, data->Size());
+}
+
+mitk::NavigationDataSet::Pointer mitk::NavigationDataSetBinaryIO::Read(std::istream& stream)
+{
+  char magic[sizeof(Magic)];
+  stream.read(magic, sizeof(magic));
+  if (stream.gcount() != static_cast<std::streamsize>(sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Stream does not contain a binary NavigationDataSet.";
+  }
+
+  unsigned int version = 0;
+  unsigned int byteOrderMark = 0;
+  unsigned int numberOfTools = 0;
+  if (!ReadValue(stream, version) || !ReadValue(stream, byteOrderMark) || !ReadValue(stream, numberOfTools))
+  {
+    mitkThrowException(mitk::IGTIOException) << "Header of binary NavigationDataSet is incomplete.";
+  }
+  if (version != Version)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File format version " << version << " is not supported.";
+  }
+  if (byteOrderMark != ByteOrderMark)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Binary NavigationDataSet was written on a machine with different byte order.";
+  }
+
+  mitk::NavigationDataSet::Pointer result = mitk::NavigationDataSet::New(numberOfTools);
+
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+  {
+    unsigned int length = 0;
+    if (!ReadValue(stream, length))
+    {
+      mitkThrowException(mitk::IGTIOException) << "Header of binary NavigationDataSet is incomplete.";
+    }
+    std::string name(length, '\0');
+    stream.read(&name[0], length);
+    if (stream.gcount() != static_cast<std::streamsize>(length))
+    {
+      mitkThrowException(mitk::IGTIOException) << "Header of binary NavigationDataSet is incomplete.";
+    }
+    result->SetToolName(toolIndex, name);
+  }
+
+  // the same objects are filled for every time step, the set only copies their values
+  std::vector<mitk::NavigationData::Pointer> timeStep;
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+  {
+    timeStep.push_back(mitk::NavigationData::New());
+    timeStep.back()->SetName(result->GetToolName(toolIndex));
+  }
+
+  char record[8 * sizeof(double) + 1];
+  bool complete = true;
+
+  while (complete && numberOfTools > 0 && stream.peek() != std::char_traits<char>::eof())
+  {
+    for (unsigned int toolIndex = 0; toolIndex < numberOfTools && complete; toolIndex++)
+    {
+      stream.read(record, sizeof(record));
+      if (stream.gcount() != static_cast<std::streamsize>(sizeof(record)))
+      {
+        complete = false;
+        break;
+      }
+
+      double values[8];
+      std::memcpy(values, record, sizeof(values));
+      unsigned char flags = static_cast<unsigned char>(record[sizeof(values)]);
+
+      mitk::NavigationData::CovarianceMatrixType covariance;
+      covariance.SetIdentity();
+      if (flags & HasCovarianceFlag)
+      {
+        for (int r = 0; r < 6 && complete; r++)
+          for (int c = 0; c < 6 && complete; c++)
+          {
+            double value;
+            complete = ReadValue(stream, value);
+            covariance[r][c] = value;
+          }
+      }
+
+      mitk::NavigationData::PositionType position;
+      for (int d = 0; d < 3; d++)
+        position[d] = values[1 + d];
+      mitk::NavigationData::OrientationType orientation(values[4], values[5], values[6], values[7]);
+
+      mitk::NavigationData* nd = timeStep[toolIndex];
+      nd->SetIGTTimeStamp(values[0]);
+      nd->SetPosition(position);
+      nd->SetOrientation(orientation);
+      nd->SetDataValid((flags & 1) != 0);
+      nd->SetHasPosition((flags & 2) != 0);
+      nd->SetHasOrientation((flags & 4) != 0);
+      nd->SetCovErrorMatrix(covariance);
+    }
+
+    if (complete)
+      result->AddNavigationDatas(timeStep);
+  }
+
+  if (!complete)
+  {
+    MITK_WARN("NavigationDataSetBinaryIO") << "Binary NavigationDataSet ends with an incomplete time step, which was skipped. "
+      << result->Size() << " time steps were read.";
+  }
+
+  return result;
+}
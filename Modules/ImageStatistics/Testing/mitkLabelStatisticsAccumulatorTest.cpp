@@ -0,0 +1,243 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include "mitkLabelStatisticsAccumulator.h"
+#include "mitkExtendedLabelStatisticsImageFilter.h"
+#include "mitkImageStatisticsCalculator.h"
+#include <mitkITKImageImport.h>
+
+#include <itkImageRegionIterator.h>
+#include <itkTimeProbe.h>
+
+class mitkLabelStatisticsAccumulatorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkLabelStatisticsAccumulatorTestSuite);
+  MITK_TEST(ComputeMoments_EqualsLabelStatisticsFilter);
+  MITK_TEST(ComputeHistograms_EqualsLabelStatisticsFilter);
+  MITK_TEST(ComputeMoments_IndependentOfNumberOfThreads);
+  MITK_TEST(CalculateStatistics_SinglePassEqualsPerLabelPasses);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image< short, 3 > ImageType;
+  typedef itk::Image< unsigned short, 3 > LabelImageType;
+  typedef mitk::LabelStatisticsAccumulator< ImageType, LabelImageType > AccumulatorType;
+  typedef itk::ExtendedLabelStatisticsImageFilter< ImageType, LabelImageType > LabelStatisticsFilterType;
+
+  static const unsigned int NumberOfLabels = 24;
+
+  ImageType::Pointer m_Image;
+  LabelImageType::Pointer m_LabelImage;
+
+public:
+
+  void setUp() override
+  {
+    ImageType::SizeType size;
+    size.Fill( 48 );
+    ImageType::RegionType region( size );
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions( region );
+    m_Image->Allocate();
+
+    m_LabelImage = LabelImageType::New();
+    m_LabelImage->SetRegions( region );
+    m_LabelImage->Allocate();
+
+    // pseudo random values, labels in blocks of slices and columns with a background border
+    unsigned int seed = 4711;
+    itk::ImageRegionIterator< ImageType > imageIt( m_Image, region );
+    itk::ImageRegionIterator< LabelImageType > labelIt( m_LabelImage, region );
+    for ( ; !imageIt.IsAtEnd(); ++imageIt, ++labelIt )
+    {
+      seed = seed * 1103515245 + 12345;
+      const ImageType::IndexType index = imageIt.GetIndex();
+      const unsigned short label = static_cast< unsigned short >( 1 + ( index[2] / 8 ) * 4 + index[0] / 12 );
+
+      imageIt.Set( static_cast< short >( ( seed >> 16 ) % 2000 ) - 500 + 20 * label );
+      labelIt.Set( index[1] < 2 || index[1] > 45 ? 0 : label );
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_LabelImage = nullptr;
+  }
+
+  void ComputeMoments_EqualsLabelStatisticsFilter()
+  {
+    AccumulatorType::Pointer accumulator = AccumulatorType::New();
+    accumulator->SetInput( m_Image );
+    accumulator->SetLabelInput( m_LabelImage );
+    accumulator->ComputeMoments();
+
+    LabelStatisticsFilterType::Pointer filter = LabelStatisticsFilterType::New();
+    filter->SetInput( m_Image );
+    filter->SetLabelInput( m_LabelImage );
+    filter->Update();
+
+    CPPUNIT_ASSERT_EQUAL( static_cast< size_t >( NumberOfLabels ), accumulator->GetLabelStatistics().size() );
+    CPPUNIT_ASSERT( !accumulator->HasLabel( 0 ) );
+
+    for ( unsigned short label = 1; label <= NumberOfLabels; ++label )
+    {
+      CPPUNIT_ASSERT( accumulator->HasLabel( label ) );
+      const AccumulatorType::LabelStatistics& statistics = accumulator->GetLabelStatistics().find( label )->second;
+
+      CPPUNIT_ASSERT_EQUAL( static_cast< itk::SizeValueType >( filter->GetCount( label ) ), statistics.Count );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetMinimum( label ), statistics.Minimum, mitk::eps );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetMaximum( label ), statistics.Maximum, mitk::eps );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetMean( label ), statistics.Mean, 1e-8 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetSigma( label ), statistics.Sigma, 1e-6 );
+
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( statistics.Minimum, static_cast< double >( m_Image->GetPixel( statistics.MinimumIndex ) ), mitk::eps );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( statistics.Maximum, static_cast< double >( m_Image->GetPixel( statistics.MaximumIndex ) ), mitk::eps );
+      CPPUNIT_ASSERT_EQUAL( label, m_LabelImage->GetPixel( statistics.MinimumIndex ) );
+      CPPUNIT_ASSERT_EQUAL( label, m_LabelImage->GetPixel( statistics.MaximumIndex ) );
+    }
+
+    // the filter does not reset its sums for skewness, kurtosis and MPP between labels, thus only the first label is comparable
+    const AccumulatorType::LabelStatistics& first = accumulator->GetLabelStatistics().find( 1 )->second;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetSkewness( 1 ), first.Skewness, 1e-6 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetKurtosis( 1 ), first.Kurtosis, 1e-6 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetMPP( 1 ), first.MPP, 1e-6 );
+  }
+
+  void ComputeHistograms_EqualsLabelStatisticsFilter()
+  {
+    AccumulatorType::Pointer accumulator = AccumulatorType::New();
+    accumulator->SetInput( m_Image );
+    accumulator->SetLabelInput( m_LabelImage );
+    accumulator->ComputeMoments();
+
+    // a range which clips some values of all labels
+    const double lower = -300.0;
+    const double upper = 1200.0;
+    const unsigned int numberOfBins = 150;
+    accumulator->ComputeHistograms( numberOfBins, lower, upper );
+
+    LabelStatisticsFilterType::Pointer filter = LabelStatisticsFilterType::New();
+    filter->SetInput( m_Image );
+    filter->SetLabelInput( m_LabelImage );
+    filter->UseHistogramsOn();
+    filter->SetHistogramParameters( numberOfBins, lower, upper );
+    filter->Update();
+
+    for ( unsigned short label = 1; label <= NumberOfLabels; ++label )
+    {
+      const AccumulatorType::LabelStatistics& statistics = accumulator->GetLabelStatistics().find( label )->second;
+      const LabelStatisticsFilterType::HistogramType* expectedHistogram = filter->GetHistogram( label );
+
+      CPPUNIT_ASSERT( statistics.Histogram.IsNotNull() );
+      CPPUNIT_ASSERT_EQUAL( expectedHistogram->GetSize( 0 ), statistics.Histogram->GetSize( 0 ) );
+      for ( unsigned int bin = 0; bin < numberOfBins; ++bin )
+      {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( expectedHistogram->GetBinMin( 0, bin ), statistics.Histogram->GetBinMin( 0, bin ), mitk::eps );
+        CPPUNIT_ASSERT_EQUAL( expectedHistogram->GetFrequency( bin ), statistics.Histogram->GetFrequency( bin ) );
+      }
+
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetMedian( label ), statistics.Median, mitk::eps );
+    }
+
+    // the filter does not reset entropy, uniformity and UPP between labels, thus only the first label is comparable
+    const AccumulatorType::LabelStatistics& first = accumulator->GetLabelStatistics().find( 1 )->second;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetEntropy( 1 ), first.Entropy, 1e-8 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetUniformity( 1 ), first.Uniformity, 1e-8 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( filter->GetUPP( 1 ), first.UPP, 1e-8 );
+  }
+
+  void ComputeMoments_IndependentOfNumberOfThreads()
+  {
+    AccumulatorType::Pointer singleThreaded = AccumulatorType::New();
+    singleThreaded->SetInput( m_Image );
+    singleThreaded->SetLabelInput( m_LabelImage );
+    singleThreaded->SetNumberOfThreads( 1 );
+    singleThreaded->ComputeMoments();
+
+    AccumulatorType::Pointer multiThreaded = AccumulatorType::New();
+    multiThreaded->SetInput( m_Image );
+    multiThreaded->SetLabelInput( m_LabelImage );
+    multiThreaded->SetNumberOfThreads( 7 );
+    multiThreaded->ComputeMoments();
+
+    for ( unsigned short label = 1; label <= NumberOfLabels; ++label )
+    {
+      const AccumulatorType::LabelStatistics& expected = singleThreaded->GetLabelStatistics().find( label )->second;
+      const AccumulatorType::LabelStatistics& statistics = multiThreaded->GetLabelStatistics().find( label )->second;
+
+      CPPUNIT_ASSERT_EQUAL( expected.Count, statistics.Count );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected.Mean, statistics.Mean, 1e-8 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected.Variance, statistics.Variance, 1e-6 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected.Kurtosis, statistics.Kurtosis, 1e-8 );
+      CPPUNIT_ASSERT_EQUAL( expected.MinimumIndex, statistics.MinimumIndex );
+      CPPUNIT_ASSERT_EQUAL( expected.MaximumIndex, statistics.MaximumIndex );
+    }
+  }
+
+  void CalculateStatistics_SinglePassEqualsPerLabelPasses()
+  {
+    mitk::Image::Pointer image = mitk::GrabItkImageMemory( m_Image.GetPointer() );
+    mitk::Image::Pointer mask = mitk::GrabItkImageMemory( m_LabelImage.GetPointer() );
+
+    mitk::ImageStatisticsCalculator::Pointer singlePass = mitk::ImageStatisticsCalculator::New();
+    singlePass->SetImage( image );
+    singlePass->SetImageMask( mask );
+    singlePass->SetMaskingModeToImage();
+
+    mitk::ImageStatisticsCalculator::Pointer perLabel = mitk::ImageStatisticsCalculator::New();
+    perLabel->SetImage( image );
+    perLabel->SetImageMask( mask );
+    perLabel->SetMaskingModeToImage();
+    perLabel->SetUseSinglePassLabelStatistics( false );
+
+    itk::TimeProbe singlePassProbe;
+    singlePassProbe.Start();
+    singlePass->ComputeStatistics();
+    singlePassProbe.Stop();
+
+    itk::TimeProbe perLabelProbe;
+    perLabelProbe.Start();
+    perLabel->ComputeStatistics();
+    perLabelProbe.Stop();
+
+    MITK_INFO << "Statistics of " << NumberOfLabels << " labels: " << singlePassProbe.GetTotal() << "s (single pass), "
+              << perLabelProbe.GetTotal() << "s (per label)";
+
+    const mitk::ImageStatisticsCalculator::StatisticsContainer& expected = perLabel->GetStatisticsVector();
+    const mitk::ImageStatisticsCalculator::StatisticsContainer& statistics = singlePass->GetStatisticsVector();
+    CPPUNIT_ASSERT_EQUAL( expected.size(), statistics.size() );
+
+    for ( size_t i = 0; i < statistics.size(); ++i )
+    {
+      CPPUNIT_ASSERT_EQUAL( expected[i].GetLabel(), statistics[i].GetLabel() );
+      CPPUNIT_ASSERT_EQUAL( expected[i].GetN(), statistics[i].GetN() );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetMin(), statistics[i].GetMin(), mitk::eps );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetMax(), statistics[i].GetMax(), mitk::eps );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetMean(), statistics[i].GetMean(), 1e-8 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetSigma(), statistics[i].GetSigma(), 1e-6 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetRMS(), statistics[i].GetRMS(), 1e-6 );
+      CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[i].GetMedian(), statistics[i].GetMedian(), mitk::eps );
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkLabelStatisticsAccumulator)
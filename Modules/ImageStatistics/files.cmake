@@ -11,4 +11,5 @@ set(H_FILES
   mitkPointSetStatisticsCalculator.h
   mitkExtendedStatisticsImageFilter.h
   mitkExtendedLabelStatisticsImageFilter.h
+  mitkLabelStatisticsAccumulator.h
 )
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkExtendedStatisticsImageFilter.h>
 #include <mitkExtendedLabelStatisticsImageFilter.h>
+#include "mitkLabelStatisticsAccumulator.h"
 
 #include <itkScalarImageToHistogramGenerator.h>
 
@@ -87,6 +88,7 @@ namespace mitk
     m_HistogramBinSize(1.0),
     m_UseDefaultBinSize(true),
     m_UseBinSizeBasedOnVOIRegion(false),
+    m_UseSinglePassLabelStatistics(true),
     m_HotspotRadiusInMM(6.2035049089940),   // radius of a 1cm3 sphere in mm
     m_CalculateHotspot(false),
     m_HotspotRadiusInMMChanged(false),
@@ -111,6 +113,16 @@ namespace mitk
     m_UseDefaultBinSize = useDefault;
   }
 
+  void ImageStatisticsCalculator::SetUseSinglePassLabelStatistics(bool useSinglePass)
+  {
+    m_UseSinglePassLabelStatistics = useSinglePass;
+  }
+
+  bool ImageStatisticsCalculator::GetUseSinglePassLabelStatistics() const
+  {
+    return m_UseSinglePassLabelStatistics;
+  }
+
 
 
 
@@ -1414,6 +1426,13 @@ namespace mitk
       adaptedImage = image;
     }
 
+    if ( m_UseSinglePassLabelStatistics && !m_UseBinSizeBasedOnVOIRegion )
+    {
+      this->InternalCalculateLabelStatistics( adaptedImage.GetPointer(), adaptedMaskImage.GetPointer(),
+        statisticsContainer, histogramContainer );
+      return;
+    }
+
     // Initialize Filter
     typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
     typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
@@ -1568,41 +1587,8 @@ namespace mitk
         typename MinMaxFilterType::IndexType tempMinIndex =
           (isMinAndMaxSameValue ? minMaxFilter->GetIndexOfMaximum() : minMaxFilter->GetIndexOfMinimum());
 
-        // FIX BUG 14644
-        //If a PlanarFigure is used for segmentation the
-        //adaptedImage is a single slice (2D). Adding the
-        // 3. dimension.
-
-        // FIX Bug 19625 pt. 1
-        // m_Image will yield 4 coordinates if it has 4 Dimensions, the min max value is however only searched for in one timeSliceImage (3D)
-        // the 3D min/max coordinates are then set and the 4th coordinate is blank, causing random numbers to appear in the GUI
-        // (Fix = replace m_Image with VImageDimension (Dimension of image))
-
-        vnl_vector<int> maxIndex;
-        vnl_vector<int> minIndex;
-        unsigned int imageDimension = m_Image->GetDimension();
-        unsigned int maxDimensionsToDisplay = 3; // we do not want to display the time step as part of the coordinates
-        maxIndex.set_size(std::min(imageDimension, maxDimensionsToDisplay));
-        minIndex.set_size(std::min(imageDimension, maxDimensionsToDisplay));
-
-        if (m_MaskingMode == MASKING_MODE_PLANARFIGURE && imageDimension == 3)
-        {
-          maxIndex[m_PlanarFigureCoordinate0] = tempMaxIndex[0];
-          maxIndex[m_PlanarFigureCoordinate1] = tempMaxIndex[1];
-          maxIndex[m_PlanarFigureAxis] = m_PlanarFigureSlice;
-
-          minIndex[m_PlanarFigureCoordinate0] = tempMinIndex[0] ;
-          minIndex[m_PlanarFigureCoordinate1] = tempMinIndex[1];
-          minIndex[m_PlanarFigureAxis] = m_PlanarFigureSlice;
-        } else
-        {
-          for (unsigned int i = 0; i<maxIndex.size(); i++)
-          {
-            maxIndex[i] = tempMaxIndex[i];
-            minIndex[i] = tempMinIndex[i];
-          }
-        }
-        // FIX END
+        vnl_vector<int> maxIndex = this->GetDisplayIndex( tempMaxIndex );
+        vnl_vector<int> minIndex = this->GetDisplayIndex( tempMinIndex );
         statistics.SetMaxIndex(maxIndex);
         statistics.SetMinIndex(minIndex);
         /*****************************************************Calculate Hotspot Statistics**********************************************/
@@ -1633,6 +1619,145 @@ namespace mitk
   }
 
 
+  template < typename TPixel, unsigned int VImageDimension >
+  void ImageStatisticsCalculator::InternalCalculateLabelStatistics(
+    const itk::Image< TPixel, VImageDimension > *adaptedImage,
+    itk::Image< unsigned short, VImageDimension > *adaptedMaskImage,
+    StatisticsContainer* statisticsContainer,
+    HistogramContainer* histogramContainer )
+  {
+    typedef itk::Image< TPixel, VImageDimension > ImageType;
+    typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
+    typedef LabelStatisticsAccumulator< ImageType, MaskImageType > AccumulatorType;
+    typedef typename AccumulatorType::LabelStatisticsMapType LabelStatisticsMapType;
+
+    typename AccumulatorType::Pointer accumulator = AccumulatorType::New();
+    accumulator->SetInput( adaptedImage );
+    accumulator->SetLabelInput( adaptedMaskImage );
+
+    this->InvokeEvent( itk::StartEvent() );
+
+    // first pass: all labels at once, everything except the histogram based values
+    try
+    {
+      accumulator->ComputeMoments();
+    }
+    catch( const itk::ExceptionObject& e )
+    {
+      mitkThrow() << "Image statistics calculation failed due to following ITK Exception: \n " << e.what();
+    }
+    this->InvokeEvent( itk::ProgressEvent() );
+
+    // The histogram range is determined by label 1 for all labels (as done by GetMinAndMaxValue() before)
+    double minimum = 0.0;
+    double maximum = 0.0;
+    if ( accumulator->HasLabel( 1 ) )
+    {
+      minimum = accumulator->GetLabelStatistics().find( 1 )->second.Minimum;
+      maximum = accumulator->GetLabelStatistics().find( 1 )->second.Maximum;
+    }
+
+    unsigned int numberOfBins = maximum - minimum;
+    if ( maximum - minimum <= 10 )
+    {
+      numberOfBins = 100;
+    }
+
+    // second pass: histograms, median, entropy, uniformity and UPP
+    accumulator->ComputeHistograms( numberOfBins, floor( minimum ), ceil( maximum ) );
+    this->InvokeEvent( itk::ProgressEvent() );
+
+    const LabelStatisticsMapType& labelStatistics = accumulator->GetLabelStatistics();
+    for ( typename LabelStatisticsMapType::const_iterator it = labelStatistics.begin(); it != labelStatistics.end(); ++it )
+    {
+      const typename AccumulatorType::LabelStatistics& labelStatistic = it->second;
+
+      Statistics statistics;
+      histogramContainer->push_back( HistogramType::ConstPointer( labelStatistic.Histogram.GetPointer() ) );
+
+      statistics.SetLabel( it->first );
+      statistics.SetN( labelStatistic.Count );
+      statistics.SetMin( labelStatistic.Minimum );
+      statistics.SetMax( labelStatistic.Maximum );
+      statistics.SetMean( labelStatistic.Mean );
+      statistics.SetMedian( labelStatistic.Median );
+      statistics.SetVariance( labelStatistic.Variance );
+      statistics.SetSigma( labelStatistic.Sigma );
+      statistics.SetSkewness( labelStatistic.Skewness );
+      statistics.SetKurtosis( labelStatistic.Kurtosis );
+      statistics.SetUniformity( labelStatistic.Uniformity );
+      statistics.SetEntropy( labelStatistic.Entropy );
+      statistics.SetUPP( labelStatistic.UPP );
+      statistics.SetMPP( labelStatistic.MPP );
+      statistics.SetRMS( sqrt( statistics.GetMean() * statistics.GetMean()
+        + statistics.GetSigma() * statistics.GetSigma() ) );
+
+      statistics.SetMaxIndex( this->GetDisplayIndex( labelStatistic.MaximumIndex ) );
+      statistics.SetMinIndex( this->GetDisplayIndex( labelStatistic.MinimumIndex ) );
+
+      if( IsHotspotCalculated() && VImageDimension == 3 )
+      {
+        bool isDefined(false);
+        Statistics hotspotStatistics = CalculateHotspotStatistics( adaptedImage, adaptedMaskImage, GetHotspotRadiusInMM(), isDefined, it->first );
+        statistics.GetHotspotStatistics() = hotspotStatistics;
+        if( statistics.GetHotspotStatistics().HasHotspotStatistics() )
+        {
+          MITK_DEBUG << "Hotspot statistics available";
+          statistics.SetHotspotIndex( hotspotStatistics.GetHotspotIndex() );
+        }
+        else
+        {
+          MITK_ERROR << "No hotspot statistics available!";
+        }
+      }
+      statisticsContainer->push_back( statistics );
+    }
+
+    if ( labelStatistics.empty() )
+    {
+      histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
+      statisticsContainer->push_back( Statistics() );
+    }
+
+    this->InvokeEvent( itk::EndEvent() );
+  }
+
+
+  template < typename TIndex >
+  vnl_vector<int> ImageStatisticsCalculator::GetDisplayIndex( const TIndex& index ) const
+  {
+    // FIX BUG 14644
+    //If a PlanarFigure is used for segmentation the
+    //adaptedImage is a single slice (2D). Adding the
+    // 3. dimension.
+
+    // FIX Bug 19625 pt. 1
+    // m_Image will yield 4 coordinates if it has 4 Dimensions, the min max value is however only searched for in one timeSliceImage (3D)
+    // the 3D min/max coordinates are then set and the 4th coordinate is blank, causing random numbers to appear in the GUI
+    // (Fix = replace m_Image with VImageDimension (Dimension of image))
+    vnl_vector<int> displayIndex;
+    unsigned int imageDimension = m_Image->GetDimension();
+    unsigned int maxDimensionsToDisplay = 3; // we do not want to display the time step as part of the coordinates
+    displayIndex.set_size(std::min(imageDimension, maxDimensionsToDisplay));
+
+    if (m_MaskingMode == MASKING_MODE_PLANARFIGURE && imageDimension == 3)
+    {
+      displayIndex[m_PlanarFigureCoordinate0] = index[0];
+      displayIndex[m_PlanarFigureCoordinate1] = index[1];
+      displayIndex[m_PlanarFigureAxis] = m_PlanarFigureSlice;
+    }
+    else
+    {
+      for (unsigned int i = 0; i < displayIndex.size() && i < TIndex::GetIndexDimension(); i++)
+      {
+        displayIndex[i] = index[i];
+      }
+    }
+    // FIX END
+    return displayIndex;
+  }
+
+
   template <typename TPixel, unsigned int VImageDimension  >
   ImageStatisticsCalculator::ImageExtrema
     ImageStatisticsCalculator::CalculateExtremaWorld(
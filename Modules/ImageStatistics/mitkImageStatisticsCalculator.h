@@ -274,6 +274,12 @@ namespace mitk
       /** \brief Automatically calculate bin size to obtain 200 bins. */
       void SetUseDefaultBinSize(bool useDefault);
 
+    /** \brief Calculate the statistics of all mask labels in two multithreaded passes
+    * (default) instead of separate passes per label with itk::ExtendedLabelStatisticsImageFilter. */
+    void SetUseSinglePassLabelStatistics(bool useSinglePass);
+
+    bool GetUseSinglePassLabelStatistics() const;
+
     /** \brief Set image from which to compute statistics. */
     void SetImage( const mitk::Image *image );
 
@@ -422,6 +428,20 @@ namespace mitk
       StatisticsContainer* statisticsContainer,
       HistogramContainer* histogramContainer );
 
+    /** \brief Calculates the statistics of all labels with LabelStatisticsAccumulator.
+    * Image and mask are expected to be aligned already. */
+    template < typename TPixel, unsigned int VImageDimension >
+    void InternalCalculateLabelStatistics(
+      const itk::Image< TPixel, VImageDimension > *adaptedImage,
+      itk::Image< unsigned short, VImageDimension > *adaptedMaskImage,
+      StatisticsContainer* statisticsContainer,
+      HistogramContainer* histogramContainer );
+
+    /** \brief Converts the index of an extremum into the index shown to the user
+    * (i.e. the index in the 3D image for planar figure masks). */
+    template < typename TIndex >
+    vnl_vector<int> GetDisplayIndex( const TIndex& index ) const;
+
     template < typename TPixel, unsigned int VImageDimension >
     void InternalCalculateMaskFromPlanarFigure(
       const itk::Image< TPixel, VImageDimension > *image, unsigned int axis );
@@ -591,6 +611,7 @@ namespace mitk
     double m_HistogramBinSize;    ///Bin size for histogram resoluion.
     bool m_UseDefaultBinSize;
     bool m_UseBinSizeBasedOnVOIRegion;
+    bool m_UseSinglePassLabelStatistics;
     double m_HotspotRadiusInMM;
     bool m_CalculateHotspot;
     bool m_HotspotRadiusInMMChanged;
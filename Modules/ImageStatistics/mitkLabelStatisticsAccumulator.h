@@ -0,0 +1,178 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef __mitkLabelStatisticsAccumulator_h
+#define __mitkLabelStatisticsAccumulator_h
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkHistogram.h>
+#include <itkMultiThreader.h>
+
+#include <map>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * \brief Calculates the statistics of all labels of a label image at once.
+  *
+  * In contrast to itk::ExtendedLabelStatisticsImageFilter, which needs additional
+  * passes over the bounding box of each label for the higher moments, this class
+  * visits each voxel once to calculate count, minimum, maximum (and their first
+  * indices), mean, variance, skewness, kurtosis and MPP of all labels
+  * (ComputeMoments()). The central moments are updated incrementally, so they do
+  * not suffer from the cancellation of the naive sum of squares algorithm.
+  *
+  * Since the histogram range usually depends on the result of the first pass,
+  * the histograms of all labels are filled in a second pass (ComputeHistograms()),
+  * which also calculates median, entropy, uniformity and UPP. The bins follow the
+  * rules of itk::Statistics::Histogram (values outside of the range are clipped,
+  * the upper bound belongs to the last bin).
+  *
+  * Both passes split the region of the label image into slabs along its slowest
+  * dimension, which are processed by separate threads. Each thread accumulates
+  * into its own partial results, which are merged afterwards. Label 0 is regarded
+  * as background and ignored.
+  */
+  template< class TInputImage, class TLabelImage >
+  class LabelStatisticsAccumulator : public itk::Object
+  {
+  public:
+
+    typedef LabelStatisticsAccumulator         Self;
+    typedef itk::Object                        Superclass;
+    typedef itk::SmartPointer< Self >          Pointer;
+    typedef itk::SmartPointer< const Self >    ConstPointer;
+
+    itkFactorylessNewMacro( Self );
+    itkTypeMacro( LabelStatisticsAccumulator, itk::Object );
+
+    typedef typename TInputImage::PixelType    PixelType;
+    typedef typename TInputImage::IndexType    IndexType;
+    typedef typename TInputImage::RegionType   RegionType;
+    typedef typename TLabelImage::PixelType    LabelPixelType;
+    typedef itk::Statistics::Histogram<double> HistogramType;
+
+    itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+    /** \brief The statistics of a single label. */
+    class LabelStatistics
+    {
+    public:
+
+      LabelStatistics();
+
+      itk::SizeValueType Count;
+      double Minimum;
+      double Maximum;
+      IndexType MinimumIndex;
+      IndexType MaximumIndex;
+      double Mean;
+      /** \brief Sample variance (normalized by Count - 1) */
+      double Variance;
+      double Sigma;
+      /** \brief Third and fourth standardized moment, based on Sigma. */
+      double Skewness;
+      double Kurtosis;
+      /** \brief Mean of the positive pixel values, relative to Count */
+      double MPP;
+
+      /** \brief Only available after ComputeHistograms() */
+      HistogramType::Pointer Histogram;
+      double Median;
+      double Entropy;
+      double Uniformity;
+      double UPP;
+
+    private:
+
+      friend class LabelStatisticsAccumulator;
+
+      /** \brief Sums of the powers of the deviations from the mean */
+      double m_M2;
+      double m_M3;
+      double m_M4;
+      double m_SumOfPositiveValues;
+    };
+
+    typedef std::map< LabelPixelType, LabelStatistics > LabelStatisticsMapType;
+
+    /** \brief Set the image the statistics are calculated from. */
+    void SetInput( const TInputImage* image );
+
+    /** \brief Set the label image. Its buffered region is evaluated, it has to be inside of the input image. */
+    void SetLabelInput( const TLabelImage* labelImage );
+
+    /** \brief Maximum number of threads, defaults to the global default of itk::MultiThreader. */
+    itkSetMacro( NumberOfThreads, itk::ThreadIdType );
+    itkGetConstMacro( NumberOfThreads, itk::ThreadIdType );
+
+    /** \brief First pass: all statistics that do not need a histogram. Clears the histograms. */
+    void ComputeMoments();
+
+    /** \brief Second pass: histograms with numberOfBins bins of equal width in [lowerBound, upperBound]. */
+    void ComputeHistograms( unsigned int numberOfBins, double lowerBound, double upperBound );
+
+    /** \brief The statistics of all labels in ascending order */
+    const LabelStatisticsMapType& GetLabelStatistics() const;
+
+    bool HasLabel( LabelPixelType label ) const;
+
+  protected:
+
+    LabelStatisticsAccumulator();
+    virtual ~LabelStatisticsAccumulator() {}
+
+  private:
+
+    LabelStatisticsAccumulator(const Self&); // purposely not implemented
+    void operator=(const Self&); // purposely not implemented
+
+    static ITK_THREAD_RETURN_TYPE MomentsThreaderCallback( void* arg );
+    static ITK_THREAD_RETURN_TYPE HistogramsThreaderCallback( void* arg );
+
+    /** \brief Splits the region along its slowest dimension with more than one element. */
+    std::vector< RegionType > SplitRegion() const;
+
+    void ExecuteThreads( ITK_THREAD_METHOD_TYPE callback );
+
+    void AccumulateMoments( const RegionType& region, LabelStatisticsMapType& partialStatistics ) const;
+
+    void AccumulateHistograms( const RegionType& region, std::map< LabelPixelType, std::vector< itk::SizeValueType > >& partialFrequencies ) const;
+
+    static void Merge( LabelStatistics& statistics, const LabelStatistics& other );
+
+    typename TInputImage::ConstPointer m_Input;
+    typename TLabelImage::ConstPointer m_LabelInput;
+    itk::ThreadIdType m_NumberOfThreads;
+
+    LabelStatisticsMapType m_LabelStatistics;
+
+    // state of the running pass
+    std::vector< RegionType > m_Regions;
+    std::vector< LabelStatisticsMapType > m_PartialStatistics;
+    std::vector< std::map< LabelPixelType, std::vector< itk::SizeValueType > > > m_PartialFrequencies;
+    std::vector< double > m_BinMinimums;
+    std::vector< double > m_BinMaximums;
+  };
+
+} // end namespace mitk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "mitkLabelStatisticsAccumulator.hxx"
+#endif
+
+#endif
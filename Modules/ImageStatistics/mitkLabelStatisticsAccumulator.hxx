@@ -0,0 +1,492 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef _mitkLabelStatisticsAccumulator_hxx
+#define _mitkLabelStatisticsAccumulator_hxx
+
+#include "mitkLabelStatisticsAccumulator.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include "mitkNumericConstants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mitk
+{
+  template< class TInputImage, class TLabelImage >
+  LabelStatisticsAccumulator< TInputImage, TLabelImage >::LabelStatistics::LabelStatistics()
+    : Count( 0 ),
+      Minimum( std::numeric_limits<double>::max() ),
+      Maximum( std::numeric_limits<double>::lowest() ),
+      Mean( 0.0 ),
+      Variance( 0.0 ),
+      Sigma( 0.0 ),
+      Skewness( 0.0 ),
+      Kurtosis( 0.0 ),
+      MPP( 0.0 ),
+      Median( 0.0 ),
+      Entropy( 0.0 ),
+      Uniformity( 0.0 ),
+      UPP( 0.0 ),
+      m_M2( 0.0 ),
+      m_M3( 0.0 ),
+      m_M4( 0.0 ),
+      m_SumOfPositiveValues( 0.0 )
+  {
+    MinimumIndex.Fill( 0 );
+    MaximumIndex.Fill( 0 );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  LabelStatisticsAccumulator< TInputImage, TLabelImage >::LabelStatisticsAccumulator()
+    : m_NumberOfThreads( itk::MultiThreader::GetGlobalDefaultNumberOfThreads() )
+  {
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::SetInput( const TInputImage* image )
+  {
+    if ( m_Input != image )
+    {
+      m_Input = image;
+      this->Modified();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::SetLabelInput( const TLabelImage* labelImage )
+  {
+    if ( m_LabelInput != labelImage )
+    {
+      m_LabelInput = labelImage;
+      this->Modified();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  const typename LabelStatisticsAccumulator< TInputImage, TLabelImage >::LabelStatisticsMapType&
+    LabelStatisticsAccumulator< TInputImage, TLabelImage >::GetLabelStatistics() const
+  {
+    return m_LabelStatistics;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  bool LabelStatisticsAccumulator< TInputImage, TLabelImage >::HasLabel( LabelPixelType label ) const
+  {
+    return m_LabelStatistics.find( label ) != m_LabelStatistics.end();
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  std::vector< typename LabelStatisticsAccumulator< TInputImage, TLabelImage >::RegionType >
+    LabelStatisticsAccumulator< TInputImage, TLabelImage >::SplitRegion() const
+  {
+    std::vector< RegionType > regions;
+
+    RegionType region = m_LabelInput->GetBufferedRegion();
+    if ( !region.Crop( m_Input->GetBufferedRegion() ) || region.GetNumberOfPixels() == 0 )
+    {
+      return regions;
+    }
+
+    unsigned int splitDimension = 0;
+    for ( unsigned int i = ImageDimension; i > 0; --i )
+    {
+      if ( region.GetSize( i - 1 ) > 1 )
+      {
+        splitDimension = i - 1;
+        break;
+      }
+    }
+
+    const itk::SizeValueType size = region.GetSize( splitDimension );
+    const itk::SizeValueType numberOfPieces = std::max< itk::SizeValueType >( 1, std::min< itk::SizeValueType >( m_NumberOfThreads, size ) );
+
+    for ( itk::SizeValueType piece = 0; piece < numberOfPieces; ++piece )
+    {
+      const itk::SizeValueType begin = piece * size / numberOfPieces;
+      const itk::SizeValueType end = ( piece + 1 ) * size / numberOfPieces;
+
+      RegionType pieceRegion = region;
+      pieceRegion.SetIndex( splitDimension, region.GetIndex( splitDimension ) + static_cast< itk::IndexValueType >( begin ) );
+      pieceRegion.SetSize( splitDimension, end - begin );
+      regions.push_back( pieceRegion );
+    }
+
+    return regions;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::ExecuteThreads( ITK_THREAD_METHOD_TYPE callback )
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( static_cast< itk::ThreadIdType >( m_Regions.size() ) );
+    threader->SetSingleMethod( callback, this );
+    threader->SingleMethodExecute();
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  ITK_THREAD_RETURN_TYPE LabelStatisticsAccumulator< TInputImage, TLabelImage >::MomentsThreaderCallback( void* arg )
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast< itk::MultiThreader::ThreadInfoStruct* >( arg );
+    Self* self = static_cast< Self* >( info->UserData );
+
+    // the threader may start less threads than requested
+    for ( size_t i = info->ThreadID; i < self->m_Regions.size(); i += info->NumberOfThreads )
+    {
+      self->AccumulateMoments( self->m_Regions[i], self->m_PartialStatistics[i] );
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  ITK_THREAD_RETURN_TYPE LabelStatisticsAccumulator< TInputImage, TLabelImage >::HistogramsThreaderCallback( void* arg )
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast< itk::MultiThreader::ThreadInfoStruct* >( arg );
+    Self* self = static_cast< Self* >( info->UserData );
+
+    for ( size_t i = info->ThreadID; i < self->m_Regions.size(); i += info->NumberOfThreads )
+    {
+      self->AccumulateHistograms( self->m_Regions[i], self->m_PartialFrequencies[i] );
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::AccumulateMoments( const RegionType& region, LabelStatisticsMapType& partialStatistics ) const
+  {
+    itk::ImageRegionConstIteratorWithIndex< TInputImage > imageIt( m_Input, region );
+    itk::ImageRegionConstIterator< TLabelImage > labelIt( m_LabelInput, region );
+
+    LabelPixelType currentLabel = 0;
+    LabelStatistics* statistics = nullptr;
+
+    for ( ; !labelIt.IsAtEnd(); ++labelIt, ++imageIt )
+    {
+      const LabelPixelType label = labelIt.Get();
+      if ( label == 0 )
+        continue;
+
+      // labels come in runs, avoid looking up each voxel
+      if ( statistics == nullptr || label != currentLabel )
+      {
+        statistics = &partialStatistics[label];
+        currentLabel = label;
+      }
+
+      const double value = static_cast< double >( imageIt.Get() );
+
+      // incremental update of the central moments, see Pebay, "Formulas for robust,
+      // one-pass parallel computation of covariances and arbitrary-order statistical moments"
+      const double n1 = static_cast< double >( statistics->Count );
+      const double n = n1 + 1.0;
+      const double delta = value - statistics->Mean;
+      const double deltaN = delta / n;
+      const double deltaN2 = deltaN * deltaN;
+      const double term1 = delta * deltaN * n1;
+
+      statistics->Mean += deltaN;
+      statistics->m_M4 += term1 * deltaN2 * ( n * n - 3.0 * n + 3.0 ) + 6.0 * deltaN2 * statistics->m_M2 - 4.0 * deltaN * statistics->m_M3;
+      statistics->m_M3 += term1 * deltaN * ( n - 2.0 ) - 3.0 * deltaN * statistics->m_M2;
+      statistics->m_M2 += term1;
+      ++statistics->Count;
+
+      if ( value > 0.0 )
+        statistics->m_SumOfPositiveValues += value;
+
+      // keep the first extremum in raster order
+      if ( value < statistics->Minimum )
+      {
+        statistics->Minimum = value;
+        statistics->MinimumIndex = imageIt.GetIndex();
+      }
+      if ( value > statistics->Maximum )
+      {
+        statistics->Maximum = value;
+        statistics->MaximumIndex = imageIt.GetIndex();
+      }
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::Merge( LabelStatistics& statistics, const LabelStatistics& other )
+  {
+    if ( other.Count == 0 )
+      return;
+
+    if ( statistics.Count == 0 )
+    {
+      statistics = other;
+      return;
+    }
+
+    const double na = static_cast< double >( statistics.Count );
+    const double nb = static_cast< double >( other.Count );
+    const double n = na + nb;
+    const double delta = other.Mean - statistics.Mean;
+    const double delta2 = delta * delta;
+
+    const double m2 = statistics.m_M2 + other.m_M2 + delta2 * na * nb / n;
+    const double m3 = statistics.m_M3 + other.m_M3
+      + delta2 * delta * na * nb * ( na - nb ) / ( n * n )
+      + 3.0 * delta * ( na * other.m_M2 - nb * statistics.m_M2 ) / n;
+    const double m4 = statistics.m_M4 + other.m_M4
+      + delta2 * delta2 * na * nb * ( na * na - na * nb + nb * nb ) / ( n * n * n )
+      + 6.0 * delta2 * ( na * na * other.m_M2 + nb * nb * statistics.m_M2 ) / ( n * n )
+      + 4.0 * delta * ( na * other.m_M3 - nb * statistics.m_M3 ) / n;
+
+    statistics.Mean += delta * nb / n;
+    statistics.m_M2 = m2;
+    statistics.m_M3 = m3;
+    statistics.m_M4 = m4;
+    statistics.Count += other.Count;
+    statistics.m_SumOfPositiveValues += other.m_SumOfPositiveValues;
+
+    // other covers a later part of the image, thus its extrema only win if they are strictly more extreme
+    if ( other.Minimum < statistics.Minimum )
+    {
+      statistics.Minimum = other.Minimum;
+      statistics.MinimumIndex = other.MinimumIndex;
+    }
+    if ( other.Maximum > statistics.Maximum )
+    {
+      statistics.Maximum = other.Maximum;
+      statistics.MaximumIndex = other.MaximumIndex;
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::ComputeMoments()
+  {
+    if ( m_Input.IsNull() || m_LabelInput.IsNull() )
+    {
+      itkExceptionMacro( << "Input and label input need to be set!" );
+    }
+
+    m_LabelStatistics.clear();
+    m_Regions = this->SplitRegion();
+    m_PartialStatistics.assign( m_Regions.size(), LabelStatisticsMapType() );
+
+    if ( !m_Regions.empty() )
+    {
+      this->ExecuteThreads( &Self::MomentsThreaderCallback );
+    }
+
+    // merge in the order of the regions to get the same result for any number of threads
+    for ( size_t i = 0; i < m_PartialStatistics.size(); ++i )
+    {
+      for ( typename LabelStatisticsMapType::const_iterator it = m_PartialStatistics[i].begin(); it != m_PartialStatistics[i].end(); ++it )
+      {
+        Merge( m_LabelStatistics[it->first], it->second );
+      }
+    }
+    m_PartialStatistics.clear();
+
+    for ( typename LabelStatisticsMapType::iterator it = m_LabelStatistics.begin(); it != m_LabelStatistics.end(); ++it )
+    {
+      LabelStatistics& statistics = it->second;
+      const double n = static_cast< double >( statistics.Count );
+
+      statistics.Variance = statistics.Count > 1 ? statistics.m_M2 / ( n - 1.0 ) : 0.0;
+      statistics.Sigma = std::sqrt( statistics.Variance );
+      statistics.MPP = statistics.m_SumOfPositiveValues / n;
+
+      if ( statistics.Sigma > mitk::sqrteps )
+      {
+        const double sigma2 = statistics.Sigma * statistics.Sigma;
+        statistics.Skewness = statistics.m_M3 / ( n * sigma2 * statistics.Sigma );
+        statistics.Kurtosis = statistics.m_M4 / ( n * sigma2 * sigma2 );
+      }
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::AccumulateHistograms( const RegionType& region,
+    std::map< LabelPixelType, std::vector< itk::SizeValueType > >& partialFrequencies ) const
+  {
+    itk::ImageRegionConstIterator< TInputImage > imageIt( m_Input, region );
+    itk::ImageRegionConstIterator< TLabelImage > labelIt( m_LabelInput, region );
+
+    const size_t numberOfBins = m_BinMinimums.size();
+    const size_t lastBin = numberOfBins - 1;
+    const double lowerBound = m_BinMinimums.front();
+    const double upperBound = m_BinMaximums.back();
+    const double binsPerUnit = upperBound > lowerBound ? numberOfBins / ( upperBound - lowerBound ) : 0.0;
+    const double upperBoundTolerance = mitk::eps * std::max( 1.0, std::abs( upperBound ) );
+
+    LabelPixelType currentLabel = 0;
+    std::vector< itk::SizeValueType >* frequencies = nullptr;
+
+    for ( ; !labelIt.IsAtEnd(); ++labelIt, ++imageIt )
+    {
+      const LabelPixelType label = labelIt.Get();
+      if ( label == 0 )
+        continue;
+
+      if ( frequencies == nullptr || label != currentLabel )
+      {
+        frequencies = &partialFrequencies[label];
+        if ( frequencies->empty() )
+          frequencies->assign( numberOfBins, 0 );
+        currentLabel = label;
+      }
+
+      const double value = static_cast< double >( imageIt.Get() );
+
+      // same clipping as itk::Statistics::Histogram::GetIndex()
+      size_t bin;
+      if ( value < lowerBound )
+      {
+        continue;
+      }
+      else if ( value >= upperBound )
+      {
+        if ( value - upperBound > upperBoundTolerance )
+          continue;
+        bin = lastBin;
+      }
+      else
+      {
+        // estimate the bin and correct for rounding of the bin boundaries
+        bin = std::min( static_cast< size_t >( ( value - lowerBound ) * binsPerUnit ), lastBin );
+        while ( bin > 0 && value < m_BinMinimums[bin] )
+          --bin;
+        while ( bin < lastBin && value >= m_BinMaximums[bin] )
+          ++bin;
+      }
+
+      ++( *frequencies )[bin];
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void LabelStatisticsAccumulator< TInputImage, TLabelImage >::ComputeHistograms( unsigned int numberOfBins, double lowerBound, double upperBound )
+  {
+    if ( m_Input.IsNull() || m_LabelInput.IsNull() )
+    {
+      itkExceptionMacro( << "Input and label input need to be set!" );
+    }
+
+    numberOfBins = std::max( 1u, numberOfBins );
+
+    // take the bin boundaries from a histogram to get exactly the same bins
+    HistogramType::SizeType size( 1 );
+    size.Fill( numberOfBins );
+    HistogramType::MeasurementVectorType lower( 1 );
+    HistogramType::MeasurementVectorType upper( 1 );
+    lower.Fill( lowerBound );
+    upper.Fill( upperBound );
+
+    HistogramType::Pointer binsHistogram = HistogramType::New();
+    binsHistogram->SetMeasurementVectorSize( 1 );
+    binsHistogram->Initialize( size, lower, upper );
+
+    m_BinMinimums.resize( numberOfBins );
+    m_BinMaximums.resize( numberOfBins );
+    for ( unsigned int bin = 0; bin < numberOfBins; ++bin )
+    {
+      m_BinMinimums[bin] = binsHistogram->GetBinMin( 0, bin );
+      m_BinMaximums[bin] = binsHistogram->GetBinMax( 0, bin );
+    }
+
+    m_Regions = this->SplitRegion();
+    m_PartialFrequencies.assign( m_Regions.size(), std::map< LabelPixelType, std::vector< itk::SizeValueType > >() );
+
+    if ( !m_Regions.empty() )
+    {
+      this->ExecuteThreads( &Self::HistogramsThreaderCallback );
+    }
+
+    for ( typename LabelStatisticsMapType::iterator it = m_LabelStatistics.begin(); it != m_LabelStatistics.end(); ++it )
+    {
+      LabelStatistics& statistics = it->second;
+
+      HistogramType::Pointer histogram = HistogramType::New();
+      histogram->SetMeasurementVectorSize( 1 );
+      histogram->Initialize( size, lower, upper );
+
+      double totalFrequency = 0.0;
+      for ( size_t i = 0; i < m_PartialFrequencies.size(); ++i )
+      {
+        typename std::map< LabelPixelType, std::vector< itk::SizeValueType > >::const_iterator frequencies = m_PartialFrequencies[i].find( it->first );
+        if ( frequencies == m_PartialFrequencies[i].end() )
+          continue;
+
+        for ( unsigned int bin = 0; bin < numberOfBins; ++bin )
+        {
+          if ( frequencies->second[bin] != 0 )
+          {
+            histogram->IncreaseFrequency( bin, frequencies->second[bin] );
+            totalFrequency += frequencies->second[bin];
+          }
+        }
+      }
+
+      // count bins until just over half the distribution is counted (as itk::LabelStatisticsImageFilter does)
+      unsigned int medianBin = 0;
+      double total = 0.0;
+      while ( total <= statistics.Count / 2 && medianBin < numberOfBins )
+      {
+        total += histogram->GetFrequency( medianBin );
+        ++medianBin;
+      }
+      medianBin = medianBin > 0 ? medianBin - 1 : 0;
+      statistics.Median = ( histogram->GetBinMin( 0, medianBin ) + histogram->GetBinMax( 0, medianBin ) ) / 2.0;
+
+      statistics.Entropy = 0.0;
+      statistics.Uniformity = 0.0;
+      statistics.UPP = 0.0;
+      if ( totalFrequency > 0.0 )
+      {
+        for ( unsigned int bin = 0; bin < numberOfBins; ++bin )
+        {
+          const double probability = histogram->GetFrequency( bin ) / totalFrequency;
+          if ( probability == 0.0 )
+            continue;
+
+          statistics.Entropy -= probability * std::log( probability ) / std::log( 2.0 );
+          statistics.Uniformity += probability * probability;
+          if ( histogram->GetMeasurement( bin, 0 ) > 0.0 )
+          {
+            statistics.UPP += probability * probability;
+          }
+        }
+      }
+
+      statistics.Histogram = histogram;
+    }
+
+    m_PartialFrequencies.clear();
+  }
+
+} // end namespace mitk
+
+#endif
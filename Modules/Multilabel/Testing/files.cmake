@@ -2,6 +2,7 @@ set(MODULE_TESTS
     mitkLabelTest.cpp
     mitkLabelSetTest.cpp
     mitkLabelSetImageTest.cpp
+    mitkSparseLabelLayerTest.cpp
     #mitkLabelSetImageIOTest.cpp # Deactivated. Not supported yet - requires low level writer access.
 )
 
@@ -0,0 +1,219 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkLabelSetImage.h>
+#include <mitkSparseLabelLayer.h>
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <cstring>
+
+class mitkSparseLabelLayerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkSparseLabelLayerTestSuite);
+  MITK_TEST(TestEncodeDecode);
+  MITK_TEST(TestBoundingBox);
+  MITK_TEST(TestEraseLabel);
+  MITK_TEST(TestMergeLabel);
+  MITK_TEST(TestCenterIndex);
+  MITK_TEST(TestLabelSetImageSparseLayers);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef mitk::SparseLabelLayer::PixelType PixelType;
+
+  static const unsigned int SizeX = 32;
+  static const unsigned int SizeY = 24;
+  static const unsigned int SizeZ = 10;
+
+  mitk::Image::Pointer m_Image;
+
+  mitk::Image::Pointer CreateImage()
+  {
+    mitk::Image::Pointer image = mitk::Image::New();
+    unsigned int dimensions[3] = { SizeX, SizeY, SizeZ };
+    image->Initialize(mitk::MakeScalarPixelType<PixelType>(), 3, dimensions);
+
+    mitk::ImageWriteAccessor accessor(image);
+    std::memset(accessor.GetData(), 0, SizeX * SizeY * SizeZ * sizeof(PixelType));
+    return image;
+  }
+
+  // fills the box [x0,x1] x [y0,y1] x [z0,z1] with the given value
+  void FillBox(mitk::Image* image, PixelType value,
+               unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1, unsigned int z0, unsigned int z1)
+  {
+    mitk::ImageWriteAccessor accessor(image);
+    PixelType* data = static_cast<PixelType*>(accessor.GetData());
+    for (unsigned int z = z0; z <= z1; ++z)
+      for (unsigned int y = y0; y <= y1; ++y)
+        for (unsigned int x = x0; x <= x1; ++x)
+          data[(z * SizeY + y) * SizeX + x] = value;
+  }
+
+  bool HaveEqualPixels(const mitk::Image* image1, const mitk::Image* image2)
+  {
+    mitk::ImageReadAccessor accessor1(image1);
+    mitk::ImageReadAccessor accessor2(image2);
+    return std::memcmp(accessor1.GetData(), accessor2.GetData(), SizeX * SizeY * SizeZ * sizeof(PixelType)) == 0;
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Image = this->CreateImage();
+    this->FillBox(m_Image, 1, 2, 10, 3, 8, 1, 4);
+    this->FillBox(m_Image, 5, 20, 30, 10, 20, 5, 9);
+    // a second run of label 1 in the same rows
+    this->FillBox(m_Image, 1, 14, 16, 3, 8, 2, 2);
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+  }
+
+  void TestEncodeDecode()
+  {
+    mitk::SparseLabelLayer::Pointer layer = mitk::SparseLabelLayer::New();
+    layer->Encode(m_Image);
+
+    CPPUNIT_ASSERT_MESSAGE("Labels not encoded", layer->ExistLabel(1) && layer->ExistLabel(5) && !layer->ExistLabel(0));
+    CPPUNIT_ASSERT_MESSAGE("Wrong number of labels", layer->GetLabels().size() == 2);
+    CPPUNIT_ASSERT_MESSAGE("Wrong number of voxels", layer->GetNumberOfVoxels(1) == 9 * 6 * 4 + 3 * 6);
+    CPPUNIT_ASSERT_MESSAGE("Encoded layer is not smaller than the image",
+                           layer->GetMemorySize() < SizeX * SizeY * SizeZ * sizeof(PixelType));
+
+    mitk::Image::Pointer decoded = this->CreateImage();
+    this->FillBox(decoded, 7, 0, SizeX - 1, 0, SizeY - 1, 0, SizeZ - 1);
+    layer->Decode(decoded);
+    CPPUNIT_ASSERT_MESSAGE("Decoded image differs from the encoded one", this->HaveEqualPixels(decoded, m_Image));
+
+    mitk::SparseLabelLayer::Pointer clone = layer->Clone();
+    clone->EraseLabel(1);
+    CPPUNIT_ASSERT_MESSAGE("Clone shares the runs of the original layer", layer->ExistLabel(1));
+  }
+
+  void TestBoundingBox()
+  {
+    mitk::SparseLabelLayer::Pointer layer = mitk::SparseLabelLayer::New();
+    layer->Encode(m_Image);
+
+    mitk::SparseLabelLayer::BoundingBox box;
+    CPPUNIT_ASSERT_MESSAGE("No bounding box", layer->GetBoundingBox(1, box));
+    CPPUNIT_ASSERT_MESSAGE("Wrong bounding box",
+                           box.MinX == 2 && box.MaxX == 16 && box.MinY == 3 && box.MaxY == 8 && box.MinSlice == 1 && box.MaxSlice == 4);
+    CPPUNIT_ASSERT_MESSAGE("Bounding box of missing label", !layer->GetBoundingBox(2, box));
+  }
+
+  void TestEraseLabel()
+  {
+    mitk::SparseLabelLayer::Pointer layer = mitk::SparseLabelLayer::New();
+    layer->Encode(m_Image);
+    layer->EraseLabel(5);
+
+    this->FillBox(m_Image, 0, 20, 30, 10, 20, 5, 9);
+    mitk::Image::Pointer decoded = this->CreateImage();
+    layer->Decode(decoded);
+    CPPUNIT_ASSERT_MESSAGE("Label not erased", !layer->ExistLabel(5) && this->HaveEqualPixels(decoded, m_Image));
+  }
+
+  void TestMergeLabel()
+  {
+    // label 3 touches label 1 in the same rows, the runs have to be joined
+    this->FillBox(m_Image, 3, 11, 13, 3, 8, 2, 2);
+    mitk::SparseLabelLayer::Pointer layer = mitk::SparseLabelLayer::New();
+    layer->Encode(m_Image);
+
+    layer->MergeLabel(1, 3);
+    layer->MergeLabel(1, 5);
+    CPPUNIT_ASSERT_MESSAGE("Labels not merged", !layer->ExistLabel(3) && !layer->ExistLabel(5) && layer->GetLabels().size() == 1);
+    CPPUNIT_ASSERT_MESSAGE("Wrong number of voxels after merging",
+                           layer->GetNumberOfVoxels(1) == 9 * 6 * 4 + 3 * 6 + 3 * 6 + 11 * 11 * 5);
+
+    mitk::SparseLabelLayer::BoundingBox box;
+    layer->GetBoundingBox(1, box);
+    CPPUNIT_ASSERT_MESSAGE("Wrong bounding box after merging",
+                           box.MinX == 2 && box.MaxX == 30 && box.MinY == 3 && box.MaxY == 20 && box.MinSlice == 1 && box.MaxSlice == 9);
+
+    this->FillBox(m_Image, 1, 11, 13, 3, 8, 2, 2);
+    this->FillBox(m_Image, 1, 20, 30, 10, 20, 5, 9);
+    mitk::Image::Pointer decoded = this->CreateImage();
+    layer->Decode(decoded);
+    CPPUNIT_ASSERT_MESSAGE("Merged layer decoded wrongly", this->HaveEqualPixels(decoded, m_Image));
+
+    // merging into a missing label only relabels the runs
+    layer->MergeLabel(8, 1);
+    CPPUNIT_ASSERT_MESSAGE("Label not relabeled", !layer->ExistLabel(1) && layer->GetNumberOfVoxels(8) == 9 * 6 * 4 + 3 * 6 + 3 * 6 + 11 * 11 * 5);
+  }
+
+  void TestCenterIndex()
+  {
+    mitk::SparseLabelLayer::Pointer layer = mitk::SparseLabelLayer::New();
+    layer->Encode(m_Image);
+
+    // the middle voxel of label 5 in memory order
+    itk::Index<3> index;
+    unsigned int timeStep = 1;
+    CPPUNIT_ASSERT_MESSAGE("No center index", layer->GetCenterIndex(5, index, timeStep));
+    const unsigned int middle = 11 * 11 * 5 / 2;
+    CPPUNIT_ASSERT_MESSAGE("Wrong center index",
+                           index[0] == 20 + middle % 11 && index[1] == 10 + (middle / 11) % 11 && index[2] == 5 + middle / (11 * 11) && timeStep == 0);
+    CPPUNIT_ASSERT_MESSAGE("Center index of missing label", !layer->GetCenterIndex(2, index, timeStep));
+  }
+
+  void TestLabelSetImageSparseLayers()
+  {
+    mitk::LabelSetImage::Pointer labelSetImage = mitk::LabelSetImage::New();
+    labelSetImage->Initialize(m_Image);
+    labelSetImage->ClearBuffer();
+    labelSetImage->SetSparseLayerStorage(true);
+    CPPUNIT_ASSERT_MESSAGE("Sparse layer storage not enabled", labelSetImage->GetSparseLayerStorage());
+
+    labelSetImage->AddLayer(m_Image);
+    CPPUNIT_ASSERT_MESSAGE("Layer image not activated", this->HaveEqualPixels(labelSetImage, m_Image));
+
+    labelSetImage->SetActiveLayer(0);
+    mitk::Image::Pointer decodedLayerImage = labelSetImage->DecodeLayerImage(1);
+    CPPUNIT_ASSERT_MESSAGE("Inactive layer decoded wrongly", this->HaveEqualPixels(decodedLayerImage, m_Image));
+    CPPUNIT_ASSERT_MESSAGE("Decoded layer image kept", labelSetImage->DecodeLayerImage(1) != decodedLayerImage);
+    CPPUNIT_ASSERT_MESSAGE("Inactive layer decoded wrongly", this->HaveEqualPixels(labelSetImage->GetLayerImage(1), m_Image));
+
+    itk::ModifiedTimeType mergeTime = labelSetImage->GetMTime();
+    std::vector<PixelType> mergedLabels(1, 7);
+    labelSetImage->MergeLabels(mergedLabels, 5, 1);
+    CPPUNIT_ASSERT_MESSAGE("Merge in inactive layer not marked as modification", labelSetImage->GetMTime() > mergeTime);
+
+    labelSetImage->EraseLabel(5, 1);
+    CPPUNIT_ASSERT_MESSAGE("Label of active layer erased", this->HaveEqualPixels(labelSetImage, this->CreateImage()));
+
+    labelSetImage->SetActiveLayer(1);
+    this->FillBox(m_Image, 0, 20, 30, 10, 20, 5, 9);
+    CPPUNIT_ASSERT_MESSAGE("Label not erased from inactive layer", this->HaveEqualPixels(labelSetImage, m_Image));
+
+    mitk::LabelSetImage::Pointer clone = labelSetImage->Clone();
+    clone->SetActiveLayer(0);
+    CPPUNIT_ASSERT_MESSAGE("Cloned layer differs", this->HaveEqualPixels(clone->GetLayerImage(1), m_Image));
+
+    labelSetImage->SetSparseLayerStorage(false);
+    CPPUNIT_ASSERT_MESSAGE("Layer image not restored", this->HaveEqualPixels(labelSetImage->GetLayerImage(1), m_Image));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkSparseLabelLayer)
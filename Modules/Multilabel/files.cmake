@@ -8,6 +8,7 @@ set(CPP_FILES
   mitkLabelSetImageToSurfaceThreadedFilter.cpp
   mitkLabelSetImageVtkMapper2D.cpp
   mitkMultilabelObjectFactory.cpp
+  mitkSparseLabelLayer.cpp
 )
 
 set(RESOURCE_FILES
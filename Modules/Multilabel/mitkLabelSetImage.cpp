@@ -38,7 +38,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 mitk::LabelSetImage::LabelSetImage() :
 mitk::Image(),
 m_ActiveLayer(0),
-m_ExteriorLabel(nullptr)
+m_ExteriorLabel(nullptr),
+m_SparseLayerStorage(false)
 {
   // Iniitlaize Background Label
   mitk::Color color;
@@ -54,7 +55,8 @@ m_ExteriorLabel(nullptr)
 mitk::LabelSetImage::LabelSetImage(const mitk::LabelSetImage & other) :
 Image(other),
 m_ActiveLayer(other.GetActiveLayer()),
-m_ExteriorLabel(other.GetExteriorLabel()->Clone())
+m_ExteriorLabel(other.GetExteriorLabel()->Clone()),
+m_SparseLayerStorage(other.m_SparseLayerStorage)
 {
   for (unsigned int i = 0; i < other.GetNumberOfLayers(); i++)
   {
@@ -66,9 +68,19 @@ m_ExteriorLabel(other.GetExteriorLabel()->Clone())
     lsClone->AddObserver(itk::ModifiedEvent(), command);
     m_LabelSetContainer.push_back(lsClone);
 
-    // clone layer Image data
-    mitk::Image::Pointer liClone = other.GetLayerImage(i)->Clone();
-    m_LayerContainer.push_back(liClone);
+    if (m_SparseLayerStorage)
+    {
+      // clone the encoded layer, decoded images are created on demand
+      m_LayerContainer.push_back(nullptr);
+      m_SparseLayerContainer.push_back(other.m_SparseLayerContainer[i].IsNotNull() ? other.m_SparseLayerContainer[i]->Clone() : nullptr);
+    }
+    else
+    {
+      // clone layer Image data
+      mitk::Image::Pointer liClone = other.GetLayerImage(i)->Clone();
+      m_LayerContainer.push_back(liClone);
+      m_SparseLayerContainer.push_back(nullptr);
+    }
   }
 }
 
@@ -119,12 +131,85 @@ mitk::LabelSetImage::~LabelSetImage()
 
 mitk::Image* mitk::LabelSetImage::GetLayerImage(unsigned int layer)
 {
+  if (m_SparseLayerStorage)
+  {
+    if (layer == GetActiveLayer())
+      return this;
+
+    if (m_LayerContainer[layer].IsNull())
+    {
+      mitk::Image::Pointer layerImage = this->CreateLayerImage();
+      m_SparseLayerContainer[layer]->Decode(layerImage);
+      m_LayerContainer[layer] = layerImage;
+    }
+  }
   return m_LayerContainer[layer];
 }
 
 const mitk::Image* mitk::LabelSetImage::GetLayerImage(unsigned int layer) const
 {
-  return m_LayerContainer[layer];
+  // decoding a sparse layer only fills the cache of decoded images
+  return const_cast<Self*>(this)->GetLayerImage(layer);
+}
+
+mitk::Image::Pointer mitk::LabelSetImage::DecodeLayerImage(unsigned int layer) const
+{
+  if (!m_SparseLayerStorage || layer == GetActiveLayer() || m_LayerContainer[layer].IsNotNull())
+    return const_cast<Self*>(this)->GetLayerImage(layer);
+
+  mitk::Image::Pointer layerImage = this->CreateLayerImage();
+  m_SparseLayerContainer[layer]->Decode(layerImage);
+  return layerImage;
+}
+
+void mitk::LabelSetImage::SetSparseLayerStorage(bool sparse)
+{
+  if (sparse == m_SparseLayerStorage)
+    return;
+
+  m_SparseLayerContainer.resize(m_LayerContainer.size());
+  try
+  {
+    for (unsigned int layer = 0; layer < m_LayerContainer.size(); ++layer)
+    {
+      if (sparse)
+      {
+        if (layer != GetActiveLayer())
+        {
+          mitk::SparseLabelLayer::Pointer sparseLayer = mitk::SparseLabelLayer::New();
+          sparseLayer->Encode(m_LayerContainer[layer]);
+          m_SparseLayerContainer[layer] = sparseLayer;
+        }
+        m_LayerContainer[layer] = nullptr;
+      }
+      else
+      {
+        if (m_LayerContainer[layer].IsNull())
+        {
+          m_LayerContainer[layer] = this->CreateLayerImage();
+          if (layer != GetActiveLayer())
+            m_SparseLayerContainer[layer]->Decode(m_LayerContainer[layer]);
+        }
+        m_SparseLayerContainer[layer] = nullptr;
+      }
+    }
+
+    if (!sparse && GetActiveLayer() < m_LayerContainer.size())
+    {
+      AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
+    }
+  }
+  catch (itk::ExceptionObject& e)
+  {
+    mitkThrow() << e.GetDescription();
+  }
+
+  m_SparseLayerStorage = sparse;
+}
+
+bool mitk::LabelSetImage::GetSparseLayerStorage() const
+{
+  return m_SparseLayerStorage;
 }
 
 unsigned int mitk::LabelSetImage::GetActiveLayer() const
@@ -149,6 +234,15 @@ void mitk::LabelSetImage::RemoveLayer()
   // remove labelset and image data
   m_LabelSetContainer.erase(m_LabelSetContainer.begin() + layerToDelete);
   m_LayerContainer.erase(m_LayerContainer.begin() + layerToDelete);
+  m_SparseLayerContainer.erase(m_SparseLayerContainer.begin() + layerToDelete);
+
+  // the layer above the deleted one was moved into the active slot
+  if (m_SparseLayerStorage && GetActiveLayer() < m_SparseLayerContainer.size() && m_SparseLayerContainer[GetActiveLayer()].IsNotNull())
+  {
+    m_SparseLayerContainer[GetActiveLayer()]->Decode(this);
+    m_SparseLayerContainer[GetActiveLayer()] = nullptr;
+    m_LayerContainer[GetActiveLayer()] = nullptr;
+  }
 
   this->Modified();
 }
@@ -159,7 +253,7 @@ void SetToZero(itk::Image< TPixel, VDimensions> * source)
   source->FillBuffer(0);
 }
 
-unsigned int mitk::LabelSetImage::AddLayer(mitk::LabelSet::Pointer lset)
+mitk::Image::Pointer mitk::LabelSetImage::CreateLayerImage() const
 {
   mitk::Image::Pointer newImage = mitk::Image::New();
   newImage->Initialize( this->GetPixelType(), this->GetDimension(), this->GetDimensions(), this->GetImageDescriptor()->GetNumberOfChannels() );
@@ -174,12 +268,35 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::LabelSet::Pointer lset)
     AccessFixedDimensionByItk(newImage, SetToZero, 4);
   }
 
-  unsigned int newLabelSetId = this->AddLayer(newImage, lset);
+  return newImage;
+}
 
-  return newLabelSetId;
+unsigned int mitk::LabelSetImage::AddLayer(mitk::LabelSet::Pointer lset)
+{
+  if (m_SparseLayerStorage)
+  {
+    // an empty layer does not need any image data
+    mitk::SparseLabelLayer::Pointer sparseLayer = mitk::SparseLabelLayer::New();
+    sparseLayer->Initialize(this);
+    return this->InsertLayer(nullptr, sparseLayer, lset);
+  }
+
+  return this->InsertLayer(this->CreateLayerImage(), nullptr, lset);
 }
 
 unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk::LabelSet::Pointer lset)
+{
+  if (m_SparseLayerStorage)
+  {
+    mitk::SparseLabelLayer::Pointer sparseLayer = mitk::SparseLabelLayer::New();
+    sparseLayer->Encode(layerImage);
+    return this->InsertLayer(nullptr, sparseLayer, lset);
+  }
+
+  return this->InsertLayer(layerImage, nullptr, lset);
+}
+
+unsigned int mitk::LabelSetImage::InsertLayer(mitk::Image::Pointer layerImage, mitk::SparseLabelLayer::Pointer sparseLayer, mitk::LabelSet::Pointer lset)
 {
   unsigned int newLabelSetId = m_LayerContainer.size();
 
@@ -202,6 +319,14 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk
 
   // push a new working image for the new layer
   m_LayerContainer.push_back(layerImage);
+  m_SparseLayerContainer.push_back(sparseLayer);
+
+  // the first layer is active right away and has to be stored in the image buffer
+  if (m_SparseLayerStorage && newLabelSetId == GetActiveLayer())
+  {
+    sparseLayer->Decode(this);
+    m_SparseLayerContainer[newLabelSetId] = nullptr;
+  }
 
   // push a new labelset for the new layer
   m_LabelSetContainer.push_back(ls);
@@ -250,9 +375,30 @@ void mitk::LabelSetImage::SetActiveLayer(unsigned int layer)
     {
       BeforeChangeLayerEvent.Send();
 
-      AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
+      if (m_SparseLayerStorage)
+      {
+        mitk::SparseLabelLayer::Pointer sparseLayer = mitk::SparseLabelLayer::New();
+        sparseLayer->Encode(this);
+        m_SparseLayerContainer[GetActiveLayer()] = sparseLayer;
+        m_LayerContainer[GetActiveLayer()] = nullptr;
+      }
+      else
+      {
+        AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
+      }
+
       m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
-      AccessByItk_1(this, LayerContainerToImageProcessing, GetActiveLayer());
+
+      if (m_SparseLayerStorage)
+      {
+        m_SparseLayerContainer[GetActiveLayer()]->Decode(this);
+        m_SparseLayerContainer[GetActiveLayer()] = nullptr;
+        m_LayerContainer[GetActiveLayer()] = nullptr;
+      }
+      else
+      {
+        AccessByItk_1(this, LayerContainerToImageProcessing, GetActiveLayer());
+      }
 
       AfterChangeLayerEvent.Send();
     }
@@ -329,9 +475,18 @@ bool mitk::LabelSetImage::ExistLabelSet(unsigned int layer) const
   return layer < m_LabelSetContainer.size();
 }
 
-void mitk::LabelSetImage::MergeLabel(PixelType pixelValue, unsigned int /*layer*/)
+void mitk::LabelSetImage::MergeLabel(PixelType pixelValue, unsigned int layer)
 {
   int targetPixelValue = GetActiveLabel()->GetValue();
+  if (m_SparseLayerStorage && layer != GetActiveLayer() && layer < m_SparseLayerContainer.size())
+  {
+    // only the runs of both labels are touched
+    m_SparseLayerContainer[layer]->MergeLabel(targetPixelValue, pixelValue);
+    m_LayerContainer[layer] = nullptr;
+    Modified();
+    return;
+  }
+
   try
   {
     AccessByItk_2(this, MergeLabelProcessing, targetPixelValue, pixelValue);
@@ -346,6 +501,17 @@ void mitk::LabelSetImage::MergeLabel(PixelType pixelValue, unsigned int /*layer*
 void mitk::LabelSetImage::MergeLabels(std::vector<PixelType> &VectorOfLablePixelValues, PixelType pixelValue, unsigned int layer)
 {
   GetLabelSet(layer)->SetActiveLabel(pixelValue);
+  if (m_SparseLayerStorage && layer != GetActiveLayer() && layer < m_SparseLayerContainer.size())
+  {
+    for (unsigned int idx = 0; idx < VectorOfLablePixelValues.size(); idx++)
+    {
+      m_SparseLayerContainer[layer]->MergeLabel(pixelValue, VectorOfLablePixelValues[idx]);
+    }
+    m_LayerContainer[layer] = nullptr;
+    Modified();
+    return;
+  }
+
   try
   {
     for (unsigned int idx = 0; idx < VectorOfLablePixelValues.size(); idx++)
@@ -378,6 +544,14 @@ void mitk::LabelSetImage::EraseLabels(std::vector<PixelType> &VectorOfLabelPixel
 
 void mitk::LabelSetImage::EraseLabel(PixelType pixelValue, unsigned int layer)
 {
+  if (m_SparseLayerStorage && layer != GetActiveLayer() && layer < m_SparseLayerContainer.size())
+  {
+    m_SparseLayerContainer[layer]->EraseLabel(pixelValue);
+    m_LayerContainer[layer] = nullptr;
+    Modified();
+    return;
+  }
+
   try
   {
     AccessByItk_2(this, EraseLabelProcessing, pixelValue, layer);
@@ -431,6 +605,30 @@ mitk::LabelSet* mitk::LabelSetImage::GetActiveLabelSet()
 
 void mitk::LabelSetImage::UpdateCenterOfMass(PixelType pixelValue, unsigned int layer)
 {
+  if (m_SparseLayerStorage && layer != GetActiveLayer() && layer < m_SparseLayerContainer.size())
+  {
+    // same voxel as CalculateCenterOfMassProcessing, found without decoding the layer
+    itk::Index<3> centerIndex;
+    unsigned int timeStep;
+    mitk::Point3D pos;
+    pos.Fill(0.0);
+
+    if (m_SparseLayerContainer[layer]->GetCenterIndex(pixelValue, centerIndex, timeStep))
+    {
+      if (this->GetDimension() != 3)
+        return;
+
+      pos[0] = centerIndex[0];
+      pos[1] = centerIndex[1];
+      pos[2] = centerIndex[2];
+    }
+
+    GetLabelSet(layer)->GetLabel(pixelValue)->SetCenterOfMassIndex(pos);
+    this->GetSlicedGeometry()->IndexToWorld(pos, pos); // TODO: TimeGeometry?
+    GetLabelSet(layer)->GetLabel(pixelValue)->SetCenterOfMassCoordinates(pos);
+    return;
+  }
+
   AccessByItk_2(this, CalculateCenterOfMassProcessing, pixelValue, layer);
 }
 
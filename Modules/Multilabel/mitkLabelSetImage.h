@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkImage.h>
 #include <mitkLabelSet.h>
+#include <mitkSparseLabelLayer.h>
 
 #include <MitkMultilabelExports.h>
 
@@ -248,11 +249,30 @@ public:
   void RemoveLayer();
 
   /**
-    * \brief  */
+   * @brief Returns the image data of a layer.
+   *        If sparse layer storage is enabled, the image of the active layer is the LabelSetImage itself and
+   *        the images of all other layers are decoded on demand. Decoded images are kept until the layer is
+   *        modified or activated and must not be modified.
+   */
   mitk::Image* GetLayerImage(unsigned int layer);
 
   const mitk::Image* GetLayerImage(unsigned int layer) const;
 
+  /**
+   * @brief Returns the image data of a layer without keeping a decoded sparse layer.
+   *        If sparse layer storage is enabled, an inactive layer is decoded into a new image which is released
+   *        together with the returned pointer. Otherwise the image of GetLayerImage() is returned.
+   */
+  mitk::Image::Pointer DecodeLayerImage(unsigned int layer) const;
+
+  /**
+   * @brief Enables or disables run-length encoded storage of the inactive layers (see mitk::SparseLabelLayer).
+   *        The active layer is always stored in the image buffer. Disabled by default.
+   */
+  void SetSparseLayerStorage(bool sparse);
+
+  bool GetSparseLayerStorage() const;
+
   void OnLabelSetModified();
 
   /**
@@ -277,6 +297,13 @@ protected:
   LabelSetImage(const LabelSetImage & other);
   virtual ~LabelSetImage();
 
+  /**
+   * @brief Creates an image with the geometry of this image filled with the exterior label
+   */
+  mitk::Image::Pointer CreateLayerImage() const;
+
+  unsigned int InsertLayer(mitk::Image::Pointer layerImage, mitk::SparseLabelLayer::Pointer sparseLayer, mitk::LabelSet::Pointer lset);
+
   template < typename ImageType1, typename ImageType2 >
   void ChangeLayerProcessing( ImageType1* source, ImageType2* target );
 
@@ -316,6 +343,11 @@ protected:
   std::vector< LabelSet::Pointer > m_LabelSetContainer;
   std::vector< Image::Pointer > m_LayerContainer;
 
+  // Encoded inactive layers if m_SparseLayerStorage is true, m_LayerContainer then only holds decoded images
+  std::vector< SparseLabelLayer::Pointer > m_SparseLayerContainer;
+
+  bool m_SparseLayerStorage;
+
   int m_ActiveLayer;
 
   mitk::Label::Pointer m_ExteriorLabel;
@@ -38,11 +38,19 @@ static void ConvertLabelSetImageToImage(const itk::Image<TPixel, VDimension>*, m
     auto vectorImageComposer = ComposeFilterType::New();
     auto activeLayer = labelSetImage->GetActiveLayer();
 
+    // the ITK images reference the memory of decoded sparse layers, which are released after composing
+    std::vector<mitk::Image::ConstPointer> decodedLayerImages;
+
     for (decltype(numberOfLayers) layer = 0; layer < numberOfLayers; ++layer)
     {
-      auto layerImage = mitk::ImageToItkImage<TPixel, VDimension>(layer != activeLayer
-        ? labelSetImage->GetLayerImage(layer)
-        : labelSetImage);
+      mitk::Image::ConstPointer mitkLayerImage = labelSetImage.GetPointer();
+      if (layer != activeLayer)
+      {
+        mitkLayerImage = labelSetImage->DecodeLayerImage(layer).GetPointer();
+        decodedLayerImages.push_back(mitkLayerImage);
+      }
+
+      auto layerImage = mitk::ImageToItkImage<TPixel, VDimension>(mitkLayerImage.GetPointer());
 
       vectorImageComposer->SetInput(layer, layerImage);
     }
@@ -149,13 +149,16 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer
 
   for (int lidx=0; lidx<numberOfLayers; ++lidx)
   {
-    mitk::Image* layerImage = NULL;
+    mitk::Image::Pointer layerImage;
 
     //set main input for ExtractSliceFilter
     if (lidx == activeLayer)
       layerImage = image;
     else
-      layerImage = image->GetLayerImage(lidx);
+      layerImage = image->DecodeLayerImage(lidx);
+
+    //a decoded sparse layer is only kept until its slice has been extracted
+    bool decodedLayer = lidx != activeLayer && image->GetSparseLayerStorage();
 
     localStorage->m_ReslicerVector[lidx]->SetInput(layerImage);
     localStorage->m_ReslicerVector[lidx]->SetWorldGeometry(worldGeometry);
@@ -197,6 +200,12 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer
     //start the pipeline with updating the largest possible, needed if the geometry of the image has changed
     localStorage->m_ReslicerVector[lidx]->UpdateLargestPossibleRegion();
     localStorage->m_ReslicedImageVector[lidx] = localStorage->m_ReslicerVector[lidx]->GetVtkOutput();
+    if (decodedLayer)
+    {
+      vtkSmartPointer<vtkImageData> reslicedImage = vtkSmartPointer<vtkImageData>::New();
+      reslicedImage->DeepCopy(localStorage->m_ReslicedImageVector[lidx]);
+      localStorage->m_ReslicedImageVector[lidx] = reslicedImage;
+    }
 
     localStorage->m_OutlineActor->GetProperty()->SetOpacity(opacity);
     localStorage->m_OutlineShadowActor->GetProperty()->SetOpacity(opacity);
@@ -246,8 +255,6 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer
 
     localStorage->m_LayerTextureVector[lidx]->SetInputConnection(localStorage->m_LevelWindowFilterVector[lidx]->GetOutputPort());
 
-    this->TransformActor( renderer );
-
     //set the plane as input for the mapper
     localStorage->m_LayerMapperVector[lidx]->SetInputConnection(localStorage->m_Plane->GetOutputPort());
     //set the texture for the actor
@@ -255,8 +262,16 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer
     localStorage->m_LayerActorVector[lidx]->SetTexture(localStorage->m_LayerTextureVector[lidx]);
 
     localStorage->m_LayerActorVector[lidx]->GetProperty()->SetOpacity(opacity);
+
+    if (decodedLayer)
+    {
+      //the reslicer references the decoded image, it is replaced to release the memory
+      localStorage->m_ReslicerVector[lidx] = mitk::ExtractSliceFilter::New();
+    }
   }
 
+  this->TransformActor( renderer );
+
   if (image->GetActiveLabel())
   {
     int pixelValue = image->GetActiveLabel()->GetValue();
@@ -574,7 +589,9 @@ void mitk::LabelSetImageVtkMapper2D::TransformActor(mitk::BaseRenderer* renderer
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
   //get the transformation matrix of the reslicer in order to render the slice as axial, coronal or saggital
   vtkSmartPointer<vtkTransform> trans = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_ReslicerVector[0]->GetResliceAxes(); //same for all layers
+  //same for all layers, the reslicer of the active layer is the only one which is never replaced
+  mitk::LabelSetImage* image = dynamic_cast< mitk::LabelSetImage* >( this->GetDataNode()->GetData() );
+  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_ReslicerVector[image->GetActiveLayer()]->GetResliceAxes();
   trans->SetMatrix(matrix);
 
   for (int lidx=0; lidx<localStorage->m_NumberOfLayers ; ++lidx)
@@ -0,0 +1,344 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSparseLabelLayer.h"
+
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+  struct RowRun
+  {
+    unsigned int Row;
+    unsigned int Start;
+    unsigned int Length;
+  };
+}
+
+mitk::SparseLabelLayer::SparseLabelLayer() :
+m_NumberOfSlicesPerTimeStep(0)
+{
+  m_Dimensions[0] = m_Dimensions[1] = m_Dimensions[2] = 0;
+}
+
+mitk::SparseLabelLayer::SparseLabelLayer(const mitk::SparseLabelLayer& other) :
+itk::Object(),
+m_Labels(other.m_Labels),
+m_NumberOfSlicesPerTimeStep(other.m_NumberOfSlicesPerTimeStep)
+{
+  m_Dimensions[0] = other.m_Dimensions[0];
+  m_Dimensions[1] = other.m_Dimensions[1];
+  m_Dimensions[2] = other.m_Dimensions[2];
+}
+
+mitk::SparseLabelLayer::~SparseLabelLayer()
+{
+}
+
+void mitk::SparseLabelLayer::Initialize(const mitk::Image* image)
+{
+  const unsigned int dimension = image->GetDimension();
+  m_Dimensions[0] = image->GetDimension(0);
+  m_Dimensions[1] = dimension > 1 ? image->GetDimension(1) : 1;
+  m_NumberOfSlicesPerTimeStep = dimension > 2 ? image->GetDimension(2) : 1;
+  m_Dimensions[2] = m_NumberOfSlicesPerTimeStep * (dimension > 3 ? image->GetDimension(3) : 1);
+
+  m_Labels.clear();
+  this->Modified();
+}
+
+void mitk::SparseLabelLayer::CheckImage(const mitk::Image* image) const
+{
+  if (image == nullptr || !image->IsInitialized())
+    mitkThrow() << "Invalid layer image.";
+
+  if (image->GetPixelType() != mitk::MakeScalarPixelType<PixelType>())
+    mitkThrow() << "Layer image has wrong pixel type.";
+
+  unsigned long long numberOfPixels = 1;
+  for (unsigned int dim = 0; dim < image->GetDimension(); ++dim)
+    numberOfPixels *= image->GetDimension(dim);
+
+  if (numberOfPixels != static_cast<unsigned long long>(m_Dimensions[0]) * m_Dimensions[1] * m_Dimensions[2])
+    mitkThrow() << "Layer image has wrong dimensions.";
+}
+
+void mitk::SparseLabelLayer::Encode(const mitk::Image* image)
+{
+  this->Initialize(image);
+  this->CheckImage(image);
+
+  mitk::ImageReadAccessor accessor(image);
+  const PixelType* data = static_cast<const PixelType*>(accessor.GetData());
+
+  // collect the runs of each label in memory order
+  std::map<PixelType, std::vector<RowRun> > rowRuns;
+  PixelType lastValue = 0;
+  std::vector<RowRun>* lastRuns = nullptr;
+
+  const unsigned int numberOfRows = m_Dimensions[1] * m_Dimensions[2];
+  for (unsigned int row = 0; row < numberOfRows; ++row)
+  {
+    const PixelType* rowData = data + static_cast<std::size_t>(row) * m_Dimensions[0];
+    unsigned int x = 0;
+    while (x < m_Dimensions[0])
+    {
+      const PixelType value = rowData[x];
+      unsigned int end = x + 1;
+      while (end < m_Dimensions[0] && rowData[end] == value)
+        ++end;
+
+      if (value != 0)
+      {
+        if (lastRuns == nullptr || value != lastValue)
+        {
+          lastRuns = &rowRuns[value];
+          lastValue = value;
+        }
+        RowRun run = { row, x, end - x };
+        lastRuns->push_back(run);
+      }
+      x = end;
+    }
+  }
+
+  for (auto labelIter = rowRuns.begin(); labelIter != rowRuns.end(); ++labelIter)
+  {
+    const std::vector<RowRun>& runs = labelIter->second;
+    LabelRuns& labelRuns = m_Labels[labelIter->first];
+
+    BoundingBox& box = labelRuns.Box;
+    box.MinX = box.MinY = box.MinSlice = std::numeric_limits<unsigned int>::max();
+    box.MaxX = box.MaxY = box.MaxSlice = 0;
+    labelRuns.NumberOfVoxels = 0;
+    for (auto runIter = runs.begin(); runIter != runs.end(); ++runIter)
+    {
+      const unsigned int y = runIter->Row % m_Dimensions[1];
+      const unsigned int slice = runIter->Row / m_Dimensions[1];
+      box.MinX = std::min(box.MinX, runIter->Start);
+      box.MaxX = std::max(box.MaxX, runIter->Start + runIter->Length - 1);
+      box.MinY = std::min(box.MinY, y);
+      box.MaxY = std::max(box.MaxY, y);
+      box.MinSlice = std::min(box.MinSlice, slice);
+      box.MaxSlice = std::max(box.MaxSlice, slice);
+      labelRuns.NumberOfVoxels += runIter->Length;
+    }
+
+    // rows of the bounding box are in memory order as well
+    const unsigned int boxRows = box.MaxY - box.MinY + 1;
+    labelRuns.RowOffsets.assign(boxRows * (box.MaxSlice - box.MinSlice + 1) + 1, 0);
+    labelRuns.Runs.resize(runs.size());
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+      const unsigned int y = runs[i].Row % m_Dimensions[1];
+      const unsigned int slice = runs[i].Row / m_Dimensions[1];
+      ++labelRuns.RowOffsets[(slice - box.MinSlice) * boxRows + (y - box.MinY) + 1];
+      labelRuns.Runs[i].Start = runs[i].Start;
+      labelRuns.Runs[i].Length = runs[i].Length;
+    }
+    for (std::size_t r = 1; r < labelRuns.RowOffsets.size(); ++r)
+      labelRuns.RowOffsets[r] += labelRuns.RowOffsets[r - 1];
+  }
+
+  this->Modified();
+}
+
+void mitk::SparseLabelLayer::Decode(mitk::Image* image) const
+{
+  this->CheckImage(image);
+
+  mitk::ImageWriteAccessor accessor(image);
+  PixelType* data = static_cast<PixelType*>(accessor.GetData());
+  std::fill_n(data, static_cast<std::size_t>(m_Dimensions[0]) * m_Dimensions[1] * m_Dimensions[2], 0);
+
+  for (auto labelIter = m_Labels.begin(); labelIter != m_Labels.end(); ++labelIter)
+  {
+    const LabelRuns& labelRuns = labelIter->second;
+    const BoundingBox& box = labelRuns.Box;
+    const unsigned int boxRows = box.MaxY - box.MinY + 1;
+    for (std::size_t r = 0; r + 1 < labelRuns.RowOffsets.size(); ++r)
+    {
+      const unsigned int y = box.MinY + r % boxRows;
+      const unsigned int slice = box.MinSlice + r / boxRows;
+      PixelType* rowData = data + (static_cast<std::size_t>(slice) * m_Dimensions[1] + y) * m_Dimensions[0];
+      for (unsigned int i = labelRuns.RowOffsets[r]; i < labelRuns.RowOffsets[r + 1]; ++i)
+      {
+        std::fill_n(rowData + labelRuns.Runs[i].Start, labelRuns.Runs[i].Length, labelIter->first);
+      }
+    }
+  }
+}
+
+bool mitk::SparseLabelLayer::ExistLabel(PixelType pixelValue) const
+{
+  return m_Labels.find(pixelValue) != m_Labels.end();
+}
+
+std::vector<mitk::SparseLabelLayer::PixelType> mitk::SparseLabelLayer::GetLabels() const
+{
+  std::vector<PixelType> labels;
+  labels.reserve(m_Labels.size());
+  for (auto labelIter = m_Labels.begin(); labelIter != m_Labels.end(); ++labelIter)
+    labels.push_back(labelIter->first);
+  return labels;
+}
+
+unsigned long long mitk::SparseLabelLayer::GetNumberOfVoxels(PixelType pixelValue) const
+{
+  auto labelIter = m_Labels.find(pixelValue);
+  return labelIter != m_Labels.end() ? labelIter->second.NumberOfVoxels : 0;
+}
+
+bool mitk::SparseLabelLayer::GetBoundingBox(PixelType pixelValue, BoundingBox& boundingBox) const
+{
+  auto labelIter = m_Labels.find(pixelValue);
+  if (labelIter == m_Labels.end())
+    return false;
+
+  boundingBox = labelIter->second.Box;
+  return true;
+}
+
+void mitk::SparseLabelLayer::EraseLabel(PixelType pixelValue)
+{
+  if (m_Labels.erase(pixelValue) > 0)
+    this->Modified();
+}
+
+void mitk::SparseLabelLayer::MergeLabel(PixelType targetValue, PixelType sourceValue)
+{
+  auto sourceIter = m_Labels.find(sourceValue);
+  if (sourceIter == m_Labels.end() || targetValue == sourceValue)
+    return;
+
+  if (targetValue == 0)
+  {
+    this->EraseLabel(sourceValue);
+    return;
+  }
+
+  auto targetIter = m_Labels.find(targetValue);
+  if (targetIter == m_Labels.end())
+  {
+    m_Labels[targetValue].Box = sourceIter->second.Box;
+    m_Labels[targetValue].RowOffsets.swap(sourceIter->second.RowOffsets);
+    m_Labels[targetValue].Runs.swap(sourceIter->second.Runs);
+    m_Labels[targetValue].NumberOfVoxels = sourceIter->second.NumberOfVoxels;
+    m_Labels.erase(sourceIter);
+    this->Modified();
+    return;
+  }
+
+  const LabelRuns& source = sourceIter->second;
+  const LabelRuns& target = targetIter->second;
+
+  LabelRuns merged;
+  merged.Box.MinX = std::min(source.Box.MinX, target.Box.MinX);
+  merged.Box.MaxX = std::max(source.Box.MaxX, target.Box.MaxX);
+  merged.Box.MinY = std::min(source.Box.MinY, target.Box.MinY);
+  merged.Box.MaxY = std::max(source.Box.MaxY, target.Box.MaxY);
+  merged.Box.MinSlice = std::min(source.Box.MinSlice, target.Box.MinSlice);
+  merged.Box.MaxSlice = std::max(source.Box.MaxSlice, target.Box.MaxSlice);
+  merged.NumberOfVoxels = source.NumberOfVoxels + target.NumberOfVoxels;
+  merged.Runs.reserve(source.Runs.size() + target.Runs.size());
+
+  const unsigned int boxRows = merged.Box.MaxY - merged.Box.MinY + 1;
+  const unsigned int numberOfRows = boxRows * (merged.Box.MaxSlice - merged.Box.MinSlice + 1);
+  merged.RowOffsets.resize(numberOfRows + 1);
+  merged.RowOffsets[0] = 0;
+
+  const LabelRuns* labels[2] = { &target, &source };
+  std::vector<Run> rowRuns;
+  for (unsigned int r = 0; r < numberOfRows; ++r)
+  {
+    const unsigned int y = merged.Box.MinY + r % boxRows;
+    const unsigned int slice = merged.Box.MinSlice + r / boxRows;
+
+    rowRuns.clear();
+    for (unsigned int l = 0; l < 2; ++l)
+    {
+      const BoundingBox& box = labels[l]->Box;
+      if (y < box.MinY || y > box.MaxY || slice < box.MinSlice || slice > box.MaxSlice)
+        continue;
+
+      const unsigned int labelRow = (slice - box.MinSlice) * (box.MaxY - box.MinY + 1) + (y - box.MinY);
+      rowRuns.insert(rowRuns.end(),
+                     labels[l]->Runs.begin() + labels[l]->RowOffsets[labelRow],
+                     labels[l]->Runs.begin() + labels[l]->RowOffsets[labelRow + 1]);
+    }
+
+    // the labels do not overlap, adjacent runs are joined
+    std::sort(rowRuns.begin(), rowRuns.end(), [](const Run& a, const Run& b) { return a.Start < b.Start; });
+    for (auto runIter = rowRuns.begin(); runIter != rowRuns.end(); ++runIter)
+    {
+      if (merged.Runs.size() > merged.RowOffsets[r] && merged.Runs.back().Start + merged.Runs.back().Length == runIter->Start)
+        merged.Runs.back().Length += runIter->Length;
+      else
+        merged.Runs.push_back(*runIter);
+    }
+    merged.RowOffsets[r + 1] = merged.Runs.size();
+  }
+
+  m_Labels.erase(sourceValue);
+  m_Labels[targetValue] = merged;
+  this->Modified();
+}
+
+bool mitk::SparseLabelLayer::GetCenterIndex(PixelType pixelValue, itk::Index<3>& index, unsigned int& timeStep) const
+{
+  auto labelIter = m_Labels.find(pixelValue);
+  if (labelIter == m_Labels.end())
+    return false;
+
+  const LabelRuns& labelRuns = labelIter->second;
+  const unsigned int boxRows = labelRuns.Box.MaxY - labelRuns.Box.MinY + 1;
+  unsigned long long remaining = labelRuns.NumberOfVoxels / 2;
+
+  for (std::size_t r = 0; r + 1 < labelRuns.RowOffsets.size(); ++r)
+  {
+    for (unsigned int i = labelRuns.RowOffsets[r]; i < labelRuns.RowOffsets[r + 1]; ++i)
+    {
+      if (remaining < labelRuns.Runs[i].Length)
+      {
+        const unsigned int slice = labelRuns.Box.MinSlice + r / boxRows;
+        index[0] = labelRuns.Runs[i].Start + remaining;
+        index[1] = labelRuns.Box.MinY + r % boxRows;
+        index[2] = slice % m_NumberOfSlicesPerTimeStep;
+        timeStep = slice / m_NumberOfSlicesPerTimeStep;
+        return true;
+      }
+      remaining -= labelRuns.Runs[i].Length;
+    }
+  }
+
+  return false;
+}
+
+std::size_t mitk::SparseLabelLayer::GetMemorySize() const
+{
+  std::size_t size = sizeof(*this);
+  for (auto labelIter = m_Labels.begin(); labelIter != m_Labels.end(); ++labelIter)
+  {
+    size += sizeof(LabelRunsMap::value_type);
+    size += labelIter->second.RowOffsets.capacity() * sizeof(unsigned int);
+    size += labelIter->second.Runs.capacity() * sizeof(Run);
+  }
+  return size;
+}
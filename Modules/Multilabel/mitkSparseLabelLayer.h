@@ -0,0 +1,166 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __mitkSparseLabelLayer_H_
+#define __mitkSparseLabelLayer_H_
+
+#include <mitkImage.h>
+#include <mitkLabel.h>
+
+#include <MitkMultilabelExports.h>
+
+#include <map>
+#include <vector>
+
+namespace mitk
+{
+
+//##Documentation
+//## @brief Run-length encoded storage of one layer of a LabelSetImage.
+//##
+//## For each label the runs of voxels along the x axis are stored for the rows (y, z and time step)
+//## within the bounding box of the label. Voxels of the exterior label (0) are not stored. Thus, the
+//## memory needed grows with the surface of the labels instead of the volume of the image, and erasing
+//## or merging a label only touches the runs of this label.
+//##
+//## Rows are counted over all time steps, i.e. the slice of a row is z + t * (number of slices).
+//## A dense image is only created by Decode().
+//## @ingroup Data
+class MITKMULTILABEL_EXPORT SparseLabelLayer : public itk::Object
+{
+
+public:
+
+  mitkClassMacroItkParent(SparseLabelLayer, itk::Object)
+  itkFactorylessNewMacro(Self)
+  itkCloneMacro(Self)
+
+  typedef mitk::Label::PixelType PixelType;
+
+  /**
+   * @brief Bounding box of a label in index coordinates, slices are counted over all time steps
+   */
+  struct BoundingBox
+  {
+    unsigned int MinX;
+    unsigned int MaxX;
+    unsigned int MinY;
+    unsigned int MaxY;
+    unsigned int MinSlice;
+    unsigned int MaxSlice;
+  };
+
+  /**
+   * @brief Initializes an empty layer with the dimensions of the given image
+   */
+  void Initialize(const mitk::Image* image);
+
+  /**
+   * @brief Replaces the content of the layer by the labels of the given image
+   * @param image an image of the pixel type of mitk::LabelSetImage
+   */
+  void Encode(const mitk::Image* image);
+
+  /**
+   * @brief Writes the labels into all voxels of the given image
+   * @param image an image of the pixel type of mitk::LabelSetImage and the dimensions of the encoded image
+   */
+  void Decode(mitk::Image* image) const;
+
+  /**
+   * @brief Returns true if at least one voxel has the given label
+   */
+  bool ExistLabel(PixelType pixelValue) const;
+
+  /**
+   * @brief Returns the values of all labels which occupy at least one voxel, except the exterior label
+   */
+  std::vector<PixelType> GetLabels() const;
+
+  unsigned long long GetNumberOfVoxels(PixelType pixelValue) const;
+
+  /**
+   * @brief Gets the bounding box of a label
+   * @return false if no voxel has the given label
+   */
+  bool GetBoundingBox(PixelType pixelValue, BoundingBox& boundingBox) const;
+
+  /**
+   * @brief Sets the voxels of a label to the exterior label
+   */
+  void EraseLabel(PixelType pixelValue);
+
+  /**
+   * @brief Sets the voxels of the label sourceValue to the label targetValue
+   */
+  void MergeLabel(PixelType targetValue, PixelType sourceValue);
+
+  /**
+   * @brief Gets the index of the middle voxel of a label in memory order, as used by
+   *        mitk::LabelSetImage::UpdateCenterOfMass()
+   * @param index the index in x, y and z direction
+   * @param timeStep the time step of the voxel
+   * @return false if no voxel has the given label
+   */
+  bool GetCenterIndex(PixelType pixelValue, itk::Index<3>& index, unsigned int& timeStep) const;
+
+  /**
+   * @brief Approximate number of bytes occupied by the runs of all labels
+   */
+  std::size_t GetMemorySize() const;
+
+protected:
+
+  mitkCloneMacro(Self)
+
+  SparseLabelLayer();
+  SparseLabelLayer(const SparseLabelLayer& other);
+  virtual ~SparseLabelLayer();
+
+  struct Run
+  {
+    unsigned int Start;
+    unsigned int Length;
+  };
+
+  /**
+   * The runs of the rows of the bounding box, row by row. The runs of row r are
+   * Runs[RowOffsets[r]] to Runs[RowOffsets[r+1]-1].
+   */
+  struct LabelRuns
+  {
+    BoundingBox Box;
+    std::vector<unsigned int> RowOffsets;
+    std::vector<Run> Runs;
+    unsigned long long NumberOfVoxels;
+  };
+
+  typedef std::map<PixelType, LabelRuns> LabelRunsMap;
+
+  void CheckImage(const mitk::Image* image) const;
+
+  LabelRunsMap m_Labels;
+
+  // x, y, slices of all time steps
+  unsigned int m_Dimensions[3];
+
+  unsigned int m_NumberOfSlicesPerTimeStep;
+
+};
+
+} // namespace mitk
+
+#endif // __mitkSparseLabelLayer_H_
@@ -0,0 +1,305 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+//TEST
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+//STD
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//MITK
+#include "mitkIGTLClient.h"
+#include "mitkIGTLMessageQueue.h"
+#include "mitkIGTLMessageRingBuffer.h"
+#include "mitkIGTLServer.h"
+
+//IGTL
+#include "igtlImageMessage.h"
+#include "igtlTransformMessage.h"
+
+static int PORT = 35353;
+static const std::string HOSTNAME = "localhost";
+
+class mitkIGTLMessageQueueTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkIGTLMessageQueueTestSuite);
+  MITK_TEST(Test_OverwriteOldest_KeepsNewestMessages);
+  MITK_TEST(Test_CapacityOne_KeepsLatestMessage);
+  MITK_TEST(Test_Block_DropsNewMessageAfterTimeout);
+  MITK_TEST(Test_ConcurrentProducerAndConsumer_PreservesOrder);
+  MITK_TEST(Test_Queue_SortsMessagesByType);
+  MITK_TEST(Test_ClientServer_LatencyPercentiles);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef mitk::IGTLMessageRingBuffer<igtl::TransformMessage> TransformBufferType;
+  typedef std::chrono::steady_clock ClockType;
+
+  // the sequence number is stored in the seconds of the time stamp
+  igtl::TransformMessage::Pointer CreateTransformMessage(unsigned int sequenceNumber)
+  {
+    igtl::TransformMessage::Pointer message = igtl::TransformMessage::New();
+    message->SetDeviceName("Tool");
+    message->SetTimeStamp(sequenceNumber, 0);
+    return message;
+  }
+
+  igtl::ImageMessage::Pointer CreateImageMessage(unsigned int sequenceNumber, int depth)
+  {
+    igtl::ImageMessage::Pointer message = igtl::ImageMessage::New();
+    message->SetDeviceName("Probe");
+    message->SetDimensions(128, 128, depth);
+    message->SetScalarType(igtl::ImageMessage::TYPE_UINT8);
+    message->AllocateScalars();
+    std::fill_n(static_cast<unsigned char*>(message->GetScalarPointer()), message->GetImageSize(), 0);
+    message->SetTimeStamp(sequenceNumber, 0);
+    return message;
+  }
+
+  unsigned int GetSequenceNumber(igtl::MessageBase* message)
+  {
+    unsigned int seconds, fraction;
+    message->GetTimeStamp(&seconds, &fraction);
+    return seconds;
+  }
+
+  double GetPercentile(std::vector<double> values, double percentile)
+  {
+    std::sort(values.begin(), values.end());
+    return values.at(static_cast<std::size_t>(percentile * (values.size() - 1)));
+  }
+
+public:
+
+  void Test_OverwriteOldest_KeepsNewestMessages()
+  {
+    TransformBufferType buffer(4, TransformBufferType::OverwriteOldest);
+    CPPUNIT_ASSERT_EQUAL(4u, buffer.GetCapacity());
+
+    for (unsigned int i = 0; i < 10; ++i)
+      CPPUNIT_ASSERT(buffer.Push(this->CreateTransformMessage(i)));
+    CPPUNIT_ASSERT_EQUAL(4u, buffer.GetSize());
+
+    for (unsigned int i = 6; i < 10; ++i)
+    {
+      igtl::TransformMessage::Pointer message = buffer.Pull();
+      CPPUNIT_ASSERT(message.IsNotNull());
+      CPPUNIT_ASSERT_EQUAL(i, this->GetSequenceNumber(message));
+    }
+    CPPUNIT_ASSERT(buffer.Pull().IsNull());
+
+    mitk::IGTLMessageRingBufferBase::Statistics statistics = buffer.GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(10ull, statistics.m_NumberOfPushedMessages);
+    CPPUNIT_ASSERT_EQUAL(4ull, statistics.m_NumberOfPulledMessages);
+    CPPUNIT_ASSERT_EQUAL(6ull, statistics.m_NumberOfDroppedMessages);
+  }
+
+  void Test_CapacityOne_KeepsLatestMessage()
+  {
+    TransformBufferType buffer(1, TransformBufferType::OverwriteOldest);
+    CPPUNIT_ASSERT_EQUAL(1u, buffer.GetCapacity());
+
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+      CPPUNIT_ASSERT(buffer.Push(this->CreateTransformMessage(i)));
+      CPPUNIT_ASSERT_EQUAL(1u, buffer.GetSize());
+    }
+
+    igtl::TransformMessage::Pointer message = buffer.Pull();
+    CPPUNIT_ASSERT(message.IsNotNull());
+    CPPUNIT_ASSERT_EQUAL(4u, this->GetSequenceNumber(message));
+    CPPUNIT_ASSERT(buffer.Pull().IsNull());
+    CPPUNIT_ASSERT_EQUAL(4ull, buffer.GetStatistics().m_NumberOfDroppedMessages);
+
+    TransformBufferType blockingBuffer(1, TransformBufferType::Block, 10);
+    CPPUNIT_ASSERT(blockingBuffer.Push(this->CreateTransformMessage(0)));
+    CPPUNIT_ASSERT(!blockingBuffer.Push(this->CreateTransformMessage(1)));
+    CPPUNIT_ASSERT_EQUAL(0u, this->GetSequenceNumber(blockingBuffer.Pull()));
+  }
+
+  void Test_Block_DropsNewMessageAfterTimeout()
+  {
+    TransformBufferType buffer(2, TransformBufferType::Block, 10);
+    CPPUNIT_ASSERT(buffer.Push(this->CreateTransformMessage(0)));
+    CPPUNIT_ASSERT(buffer.Push(this->CreateTransformMessage(1)));
+
+    ClockType::time_point start = ClockType::now();
+    CPPUNIT_ASSERT(!buffer.Push(this->CreateTransformMessage(2)));
+    CPPUNIT_ASSERT(ClockType::now() - start >= std::chrono::milliseconds(10));
+    CPPUNIT_ASSERT_EQUAL(1ull, buffer.GetStatistics().m_NumberOfDroppedMessages);
+
+    // the blocked producer continues as soon as the consumer made room
+    std::thread consumer([&buffer]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      buffer.Pull();
+    });
+    TransformBufferType::MessagePointer message = this->CreateTransformMessage(3);
+    bool pushed = false;
+    for (int i = 0; i < 100 && !pushed; ++i)
+      pushed = buffer.Push(message);
+    consumer.join();
+    CPPUNIT_ASSERT(pushed);
+    CPPUNIT_ASSERT_EQUAL(1u, this->GetSequenceNumber(buffer.Pull()));
+    CPPUNIT_ASSERT_EQUAL(3u, this->GetSequenceNumber(buffer.Pull()));
+  }
+
+  void Test_ConcurrentProducerAndConsumer_PreservesOrder()
+  {
+    const unsigned int numberOfMessages = 20000;
+    std::vector< igtl::TransformMessage::Pointer > messages;
+    for (unsigned int i = 0; i < numberOfMessages; ++i)
+      messages.push_back(this->CreateTransformMessage(i));
+
+    TransformBufferType buffer(64, TransformBufferType::Block, 10000);
+    std::thread producer([&buffer, &messages]() {
+      for (unsigned int i = 0; i < messages.size(); ++i)
+        buffer.Push(messages[i]);
+    });
+
+    unsigned int expected = 0;
+    bool ordered = true;
+    while (expected < numberOfMessages)
+    {
+      igtl::TransformMessage::Pointer message = buffer.Pull();
+      if (message.IsNull())
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      ordered = ordered && this->GetSequenceNumber(message) == expected;
+      ++expected;
+    }
+    producer.join();
+
+    CPPUNIT_ASSERT_MESSAGE("Messages were reordered", ordered);
+    mitk::IGTLMessageRingBufferBase::Statistics statistics = buffer.GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long long>(numberOfMessages), statistics.m_NumberOfPulledMessages);
+    CPPUNIT_ASSERT_EQUAL(0ull, statistics.m_NumberOfDroppedMessages);
+  }
+
+  void Test_Queue_SortsMessagesByType()
+  {
+    mitk::IGTLMessageQueue::Pointer queue = mitk::IGTLMessageQueue::New();
+    queue->PushMessage(this->CreateTransformMessage(0).GetPointer());
+    queue->PushMessage(this->CreateImageMessage(1, 1).GetPointer());
+    queue->PushMessage(this->CreateImageMessage(2, 4).GetPointer());
+    CPPUNIT_ASSERT_EQUAL(3, queue->GetSize());
+
+    CPPUNIT_ASSERT(queue->PullTrackingMessage().IsNull());
+    CPPUNIT_ASSERT_EQUAL(0u, this->GetSequenceNumber(queue->PullTransformMessage()));
+    CPPUNIT_ASSERT_EQUAL(1u, this->GetSequenceNumber(queue->PullImage2dMessage()));
+    CPPUNIT_ASSERT_EQUAL(2u, this->GetSequenceNumber(queue->PullImage3dMessage()));
+    CPPUNIT_ASSERT_EQUAL(0, queue->GetSize());
+
+    // without buffering only the latest message is kept
+    queue->PushMessage(this->CreateTransformMessage(3).GetPointer());
+    queue->PushMessage(this->CreateTransformMessage(4).GetPointer());
+    CPPUNIT_ASSERT_EQUAL(4u, this->GetSequenceNumber(queue->PullTransformMessage()));
+    CPPUNIT_ASSERT_EQUAL(1ull, queue->GetStatistics(mitk::IGTLMessageQueue::TransformBuffer).m_NumberOfDroppedMessages);
+
+    queue->SetBufferCapacity(8);
+    queue->EnableInfiniteBuffering(true);
+    for (unsigned int i = 0; i < 10; ++i)
+      queue->PushMessage(this->CreateTransformMessage(i).GetPointer());
+    CPPUNIT_ASSERT_EQUAL(8, queue->GetSize());
+    CPPUNIT_ASSERT_EQUAL(2u, this->GetSequenceNumber(queue->PullTransformMessage()));
+  }
+
+  void Test_ClientServer_LatencyPercentiles()
+  {
+    mitk::IGTLServer::Pointer server = mitk::IGTLServer::New(true);
+    server->SetHostname(HOSTNAME);
+    server->SetName("Latency Test Server");
+    server->SetPortNumber(PORT);
+    mitk::IGTLClient::Pointer client = mitk::IGTLClient::New(true);
+    client->SetHostname(HOSTNAME);
+    client->SetName("Latency Test Client");
+    client->SetPortNumber(PORT);
+
+    server->GetMessageQueue()->SetBufferCapacity(256);
+    server->GetMessageQueue()->EnableInfiniteBuffering(true);
+    client->GetMessageQueue()->SetBufferCapacity(256);
+    client->GetMessageQueue()->EnableInfiniteBuffering(true);
+
+    CPPUNIT_ASSERT_MESSAGE("Could not open Connection with Server", server->OpenConnection());
+    server->StartCommunication();
+    CPPUNIT_ASSERT_MESSAGE("Could not connect to Server", client->OpenConnection());
+    client->StartCommunication();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 200 Hz tracking data and 2D images at about 30 Hz for one second
+    const unsigned int numberOfTransforms = 200;
+    std::vector<ClockType::time_point> sendTimes(numberOfTransforms + numberOfTransforms / 6 + 1);
+    std::thread sender([&]() {
+      unsigned int sequenceNumber = 0;
+      for (unsigned int i = 0; i < numberOfTransforms; ++i)
+      {
+        sendTimes[sequenceNumber] = ClockType::now();
+        server->SendMessage(this->CreateTransformMessage(sequenceNumber++).GetPointer());
+        if (i % 6 == 0)
+        {
+          sendTimes[sequenceNumber] = ClockType::now();
+          server->SendMessage(this->CreateImageMessage(sequenceNumber++, 1).GetPointer());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    });
+
+    std::vector<double> transformLatencies;
+    std::vector<double> imageLatencies;
+    ClockType::time_point end = ClockType::now() + std::chrono::seconds(3);
+    while (ClockType::now() < end && transformLatencies.size() < numberOfTransforms)
+    {
+      igtl::TransformMessage::Pointer transform = client->GetMessageQueue()->PullTransformMessage();
+      if (transform.IsNotNull())
+        transformLatencies.push_back(std::chrono::duration<double, std::milli>(ClockType::now() - sendTimes.at(this->GetSequenceNumber(transform))).count());
+      igtl::ImageMessage::Pointer image = client->GetMessageQueue()->PullImage2dMessage();
+      if (image.IsNotNull())
+        imageLatencies.push_back(std::chrono::duration<double, std::milli>(ClockType::now() - sendTimes.at(this->GetSequenceNumber(image))).count());
+      if (transform.IsNull() && image.IsNull())
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    sender.join();
+
+    client->StopCommunication();
+    server->StopCommunication();
+    client->CloseConnection();
+    server->CloseConnection();
+
+    CPPUNIT_ASSERT_MESSAGE("No transform received", !transformLatencies.empty());
+    CPPUNIT_ASSERT_MESSAGE("No image received", !imageLatencies.empty());
+
+    MITK_INFO << "Received " << transformLatencies.size() << " of " << numberOfTransforms << " transforms, latency (ms)"
+              << " p50: " << this->GetPercentile(transformLatencies, 0.5)
+              << " p95: " << this->GetPercentile(transformLatencies, 0.95)
+              << " p99: " << this->GetPercentile(transformLatencies, 0.99);
+    MITK_INFO << "Received " << imageLatencies.size() << " images, latency (ms)"
+              << " p50: " << this->GetPercentile(imageLatencies, 0.5)
+              << " p95: " << this->GetPercentile(imageLatencies, 0.95)
+              << " p99: " << this->GetPercentile(imageLatencies, 0.99);
+
+    mitk::IGTLMessageQueue::BufferStatistics statistics = client->GetMessageQueue()->GetStatistics(mitk::IGTLMessageQueue::TransformBuffer);
+    MITK_INFO << "Client transform buffer: " << statistics.m_NumberOfPushedMessages << " pushed, "
+              << statistics.m_NumberOfDroppedMessages << " dropped, mean time in buffer "
+              << statistics.m_MeanLatency << " us, maximum " << statistics.m_MaximumLatency << " us";
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkIGTLMessageQueue)
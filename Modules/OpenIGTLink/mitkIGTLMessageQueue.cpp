@@ -15,207 +15,120 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkIGTLMessageQueue.h"
+#include "mitkExceptionMacro.h"
 #include <string>
 #include "igtlMessageBase.h"
 
-void mitk::IGTLMessageQueue::PushSendMessage(igtl::MessageBase::Pointer message)
+std::shared_ptr< mitk::IGTLMessageRingBufferBase > mitk::IGTLMessageQueue::GetBuffer(BufferType buffer) const
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-    m_SendQueue.clear();
+  return std::atomic_load(&m_Buffers[buffer]);
+}
 
-  m_SendQueue.push_back(message);
-  this->m_Mutex->Unlock();
+void mitk::IGTLMessageQueue::PushSendMessage(igtl::MessageBase::Pointer message)
+{
+  this->GetTypedBuffer<MessageBufferType>(SendBuffer)->Push(message);
 }
 
 void mitk::IGTLMessageQueue::PushCommandMessage(igtl::MessageBase::Pointer message)
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-    m_CommandQueue.clear();
-
-  m_CommandQueue.push_back(message);
-  this->m_Mutex->Unlock();
+  this->GetTypedBuffer<MessageBufferType>(CommandBuffer)->Push(message);
 }
 
 void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer msg)
 {
-  this->m_Mutex->Lock();
-
   std::stringstream infolog;
 
   infolog << "Received message of type ";
 
   if (dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-      m_TrackingDataQueue.clear();
-
-    this->m_TrackingDataQueue.push_back(dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()));
+    this->GetTypedBuffer<TrackingDataBufferType>(TrackingDataBuffer)->Push(dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()));
 
     infolog << "TDATA";
   }
   else if (dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-      m_TransformQueue.clear();
-
-    this->m_TransformQueue.push_back(dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()));
+    this->GetTypedBuffer<TransformBufferType>(TransformBuffer)->Push(dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()));
 
     infolog << "TRANSFORM";
   }
   else if (dynamic_cast<igtl::StringMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-      m_StringQueue.clear();
-
-    this->m_StringQueue.push_back(dynamic_cast<igtl::StringMessage*>(msg.GetPointer()));
+    this->GetTypedBuffer<StringBufferType>(StringBuffer)->Push(dynamic_cast<igtl::StringMessage*>(msg.GetPointer()));
 
     infolog << "STRING";
   }
   else if (dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()) != nullptr)
   {
     igtl::ImageMessage::Pointer imageMsg = dynamic_cast<igtl::ImageMessage*>(msg.GetPointer());
-    int* dim = new int[3];
+    int dim[3];
     imageMsg->GetDimensions(dim);
     if (dim[2] > 1)
     {
-      if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-        m_Image3dQueue.clear();
-
-      this->m_Image3dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
+      this->GetTypedBuffer<ImageBufferType>(Image3dBuffer)->Push(imageMsg);
 
       infolog << "IMAGE3D";
     }
     else
     {
-      if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-        m_Image2dQueue.clear();
-
-      this->m_Image2dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
+      this->GetTypedBuffer<ImageBufferType>(Image2dBuffer)->Push(imageMsg);
 
       infolog << "IMAGE2D";
     }
   }
   else
   {
-    if (this->m_BufferingType == IGTLMessageQueue::Infinit)
-      m_MiscQueue.clear();
-
-    this->m_MiscQueue.push_back(msg);
+    this->GetTypedBuffer<MessageBufferType>(MiscBuffer)->Push(msg);
 
     infolog << "OTHER";
   }
 
+  this->m_Mutex->Lock();
   m_Latest_Message = msg;
-
-  MITK_INFO << infolog.str();
-
   this->m_Mutex->Unlock();
+
+  // logged at debug level, info output for every message delays the receive thread
+  MITK_DEBUG << infolog.str();
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullSendMessage()
 {
-  igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_SendQueue.size() > 0)
-  {
-    ret = this->m_SendQueue.front();
-    this->m_SendQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<MessageBufferType>(SendBuffer)->Pull();
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullMiscMessage()
 {
-  igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_MiscQueue.size() > 0)
-  {
-    ret = this->m_MiscQueue.front();
-    this->m_MiscQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<MessageBufferType>(MiscBuffer)->Pull();
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage2dMessage()
 {
-  igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image2dQueue.size() > 0)
-  {
-    ret = this->m_Image2dQueue.front();
-    this->m_Image2dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<ImageBufferType>(Image2dBuffer)->Pull();
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage3dMessage()
 {
-  igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image3dQueue.size() > 0)
-  {
-    ret = this->m_Image3dQueue.front();
-    this->m_Image3dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<ImageBufferType>(Image3dBuffer)->Pull();
 }
 
 igtl::TrackingDataMessage::Pointer mitk::IGTLMessageQueue::PullTrackingMessage()
 {
-  igtl::TrackingDataMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TrackingDataQueue.size() > 0)
-  {
-    ret = this->m_TrackingDataQueue.front();
-    this->m_TrackingDataQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<TrackingDataBufferType>(TrackingDataBuffer)->Pull();
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullCommandMessage()
 {
-  igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_CommandQueue.size() > 0)
-  {
-    ret = this->m_CommandQueue.front();
-    this->m_CommandQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<MessageBufferType>(CommandBuffer)->Pull();
 }
 
 igtl::StringMessage::Pointer mitk::IGTLMessageQueue::PullStringMessage()
 {
-  igtl::StringMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_StringQueue.size() > 0)
-  {
-    ret = this->m_StringQueue.front();
-    this->m_StringQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<StringBufferType>(StringBuffer)->Pull();
 }
 
 igtl::TransformMessage::Pointer mitk::IGTLMessageQueue::PullTransformMessage()
 {
-  igtl::TransformMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TransformQueue.size() > 0)
-  {
-    ret = this->m_TransformQueue.front();
-    this->m_TransformQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return this->GetTypedBuffer<TransformBufferType>(TransformBuffer)->Pull();
 }
 
 std::string mitk::IGTLMessageQueue::GetNextMsgInformationString()
@@ -286,8 +199,11 @@ std::string mitk::IGTLMessageQueue::GetLatestMsgDeviceType()
 
 int mitk::IGTLMessageQueue::GetSize()
 {
-  return (this->m_CommandQueue.size() + this->m_Image2dQueue.size() + this->m_Image3dQueue.size() + this->m_MiscQueue.size()
-    + this->m_StringQueue.size() + this->m_TrackingDataQueue.size() + this->m_TransformQueue.size());
+  // the send buffer is not included
+  int size = 0;
+  for (int i = 0; i < SendBuffer; ++i)
+    size += this->GetBuffer(static_cast<BufferType>(i))->GetSize();
+  return size;
 }
 
 void mitk::IGTLMessageQueue::EnableInfiniteBuffering(bool enable)
@@ -297,16 +213,80 @@ void mitk::IGTLMessageQueue::EnableInfiniteBuffering(bool enable)
     this->m_BufferingType = IGTLMessageQueue::BufferingType::Infinit;
   else
     this->m_BufferingType = IGTLMessageQueue::BufferingType::NoBuffering;
+  unsigned int capacity = enable ? m_BufferCapacity : 1;
+  this->m_Mutex->Unlock();
+
+  for (int i = 0; i < NumberOfBuffers; ++i)
+    this->SetBufferingPolicy(static_cast<BufferType>(i), IGTLMessageRingBufferBase::OverwriteOldest, capacity);
+}
+
+void mitk::IGTLMessageQueue::SetBufferCapacity(unsigned int capacity)
+{
+  this->m_Mutex->Lock();
+  m_BufferCapacity = capacity;
+  bool infinit = this->m_BufferingType == IGTLMessageQueue::Infinit;
   this->m_Mutex->Unlock();
+
+  if (infinit)
+    this->EnableInfiniteBuffering(true);
+}
+
+unsigned int mitk::IGTLMessageQueue::GetBufferCapacity() const
+{
+  return m_BufferCapacity;
+}
+
+void mitk::IGTLMessageQueue::SetBufferingPolicy(BufferType buffer, OverflowPolicy policy, unsigned int capacity, unsigned int blockTimeout)
+{
+  std::shared_ptr< IGTLMessageRingBufferBase > newBuffer;
+  switch (buffer)
+  {
+  case Image2dBuffer:
+  case Image3dBuffer:
+    newBuffer = std::make_shared<ImageBufferType>(capacity, policy, blockTimeout);
+    break;
+  case TransformBuffer:
+    newBuffer = std::make_shared<TransformBufferType>(capacity, policy, blockTimeout);
+    break;
+  case TrackingDataBuffer:
+    newBuffer = std::make_shared<TrackingDataBufferType>(capacity, policy, blockTimeout);
+    break;
+  case StringBuffer:
+    newBuffer = std::make_shared<StringBufferType>(capacity, policy, blockTimeout);
+    break;
+  case CommandBuffer:
+  case MiscBuffer:
+  case SendBuffer:
+    newBuffer = std::make_shared<MessageBufferType>(capacity, policy, blockTimeout);
+    break;
+  default:
+    mitkThrow() << "Invalid message buffer " << buffer;
+  }
+
+  // threads still holding the old buffer finish their push or pull on it
+  std::atomic_store(&m_Buffers[buffer], newBuffer);
+}
+
+mitk::IGTLMessageQueue::BufferStatistics mitk::IGTLMessageQueue::GetStatistics(BufferType buffer) const
+{
+  return this->GetBuffer(buffer)->GetStatistics();
+}
+
+void mitk::IGTLMessageQueue::ResetStatistics()
+{
+  for (int i = 0; i < NumberOfBuffers; ++i)
+    this->GetBuffer(static_cast<BufferType>(i))->ResetStatistics();
 }
 
 mitk::IGTLMessageQueue::IGTLMessageQueue()
+  : m_BufferCapacity(64)
 {
   this->m_Mutex = itk::FastMutexLock::New();
-  this->m_BufferingType = IGTLMessageQueue::Infinit;
+  this->m_BufferingType = IGTLMessageQueue::NoBuffering;
+  for (int i = 0; i < NumberOfBuffers; ++i)
+    this->SetBufferingPolicy(static_cast<BufferType>(i), IGTLMessageRingBufferBase::OverwriteOldest, 1);
 }
 
 mitk::IGTLMessageQueue::~IGTLMessageQueue()
 {
-  this->m_Mutex->Unlock();
-}
\ No newline at end of file
+}
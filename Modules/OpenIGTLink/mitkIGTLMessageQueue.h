@@ -22,8 +22,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkObject.h"
 #include "itkFastMutexLock.h"
 #include "mitkCommon.h"
+#include "mitkIGTLMessageRingBuffer.h"
 
-#include <deque>
+#include <memory>
 
 //OpenIGTLink
 #include "igtlMessageBase.h"
@@ -37,6 +38,12 @@ namespace mitk {
   * \class IGTLMessageQueue
   * \brief Thread safe message queue to store OpenIGTLink messages.
   *
+  * Each message type is stored in its own fixed capacity lock-free ring buffer
+  * (see IGTLMessageRingBuffer), so pushing and pulling messages never waits for
+  * a mutex. Capacity and overflow policy can be set per buffer, every buffer
+  * counts pushed, pulled and dropped messages and the time messages spent in the
+  * buffer.
+  *
   * \ingroup OpenIGTLink
   */
   class MITKOPENIGTLINK_EXPORT IGTLMessageQueue : public itk::Object
@@ -48,11 +55,20 @@ namespace mitk {
 
       /**
        * \brief Different buffering types
-       * Infinit buffering means that you can push as many messages as you want
+       * Infinit buffering means that the queues store up to their buffer capacity
        * NoBuffering means that the queue just stores a single message
        */
     enum BufferingType { Infinit, NoBuffering };
 
+    /**
+    * \brief The buffers of the queue, one per message type
+    */
+    enum BufferType { CommandBuffer, Image2dBuffer, Image3dBuffer, TransformBuffer,
+      TrackingDataBuffer, StringBuffer, MiscBuffer, SendBuffer, NumberOfBuffers };
+
+    typedef IGTLMessageRingBufferBase::OverflowPolicy OverflowPolicy;
+    typedef IGTLMessageRingBufferBase::Statistics BufferStatistics;
+
     void PushSendMessage(igtl::MessageBase::Pointer message);
 
     /**
@@ -105,35 +121,68 @@ namespace mitk {
 
     /**
     * \brief Sets infinite buffering on/off.
-    * Initiale value is enabled.
+    * If enabled, the receive buffers store up to GetBufferCapacity() messages,
+    * otherwise only the latest message. Initial value is disabled.
+    * Messages in the receive buffers are discarded.
     */
     void EnableInfiniteBuffering(bool enable);
 
+    /**
+    * \brief Capacity of the receive buffers if infinite buffering is enabled
+    */
+    void SetBufferCapacity(unsigned int capacity);
+    unsigned int GetBufferCapacity() const;
+
+    /**
+    * \brief Replaces a buffer by an empty one with the given capacity and
+    * overflow policy. blockTimeout is the maximum time in ms a push waits with
+    * the Block policy. Messages in the replaced buffer are discarded.
+    */
+    void SetBufferingPolicy(BufferType buffer, OverflowPolicy policy, unsigned int capacity, unsigned int blockTimeout = 100);
+
+    /**
+    * \brief Counters and latencies of a buffer
+    */
+    BufferStatistics GetStatistics(BufferType buffer) const;
+    void ResetStatistics();
+
   protected:
     IGTLMessageQueue();
     virtual ~IGTLMessageQueue();
 
   protected:
     /**
-    * \brief Mutex to take car of the queue
+    * \brief Mutex to take care of the latest message and the buffer configuration.
+    * It is not locked to push or pull messages.
     */
     itk::FastMutexLock::Pointer m_Mutex;
 
+    typedef IGTLMessageRingBuffer< igtl::MessageBase > MessageBufferType;
+    typedef IGTLMessageRingBuffer< igtl::ImageMessage > ImageBufferType;
+    typedef IGTLMessageRingBuffer< igtl::TransformMessage > TransformBufferType;
+    typedef IGTLMessageRingBuffer< igtl::TrackingDataMessage > TrackingDataBufferType;
+    typedef IGTLMessageRingBuffer< igtl::StringMessage > StringBufferType;
+
     /**
-    * \brief the queue that stores pointer to the inserted messages
+    * \brief Returns the buffer currently in use, buffers are replaced atomically
+    * if their configuration changes
     */
-    std::deque< igtl::MessageBase::Pointer > m_CommandQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image2dQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image3dQueue;
-    std::deque< igtl::TransformMessage::Pointer > m_TransformQueue;
-    std::deque< igtl::TrackingDataMessage::Pointer > m_TrackingDataQueue;
-    std::deque< igtl::StringMessage::Pointer > m_StringQueue;
-    std::deque< igtl::MessageBase::Pointer > m_MiscQueue;
+    std::shared_ptr< IGTLMessageRingBufferBase > GetBuffer(BufferType buffer) const;
+    template <class TBuffer>
+    std::shared_ptr< TBuffer > GetTypedBuffer(BufferType buffer) const
+    {
+      return std::static_pointer_cast<TBuffer>(this->GetBuffer(buffer));
+    }
 
-    std::deque< igtl::MessageBase::Pointer> m_SendQueue;
+    /**
+    * \brief the buffers that store pointers to the inserted messages
+    */
+    std::shared_ptr< IGTLMessageRingBufferBase > m_Buffers[NumberOfBuffers];
 
     igtl::MessageBase::Pointer m_Latest_Message;
 
+    unsigned int m_BufferCapacity;
+
     /**
     * \brief defines the kind of buffering
     */
@@ -0,0 +1,149 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLMessageRingBuffer.h"
+
+#include <algorithm>
+
+mitk::IGTLMessageRingBufferBase::IGTLMessageRingBufferBase(unsigned int capacity, OverflowPolicy policy, unsigned int blockTimeout)
+  : m_Capacity(1)
+  , m_Mask(0)
+  , m_PushPosition(0)
+  , m_PullPosition(0)
+  , m_Policy(policy)
+  , m_BlockTimeout(blockTimeout)
+  , m_NumberOfPushedMessages(0)
+  , m_NumberOfPulledMessages(0)
+  , m_NumberOfDroppedMessages(0)
+  , m_TotalLatency(0)
+  , m_MaximumLatency(0)
+{
+  while (m_Capacity < capacity)
+    m_Capacity *= 2;
+
+  // with a single slot the sequence of a written and a freed slot is the same,
+  // so a capacity of one uses two slots and Push() limits the number of messages
+  std::size_t size = std::max<std::size_t>(m_Capacity, 2);
+  m_Mask = size - 1;
+
+  m_Sequences.reset(new std::atomic<std::size_t>[size]);
+  for (std::size_t i = 0; i < size; ++i)
+    m_Sequences[i].store(i, std::memory_order_relaxed);
+}
+
+bool mitk::IGTLMessageRingBufferBase::ClaimPushSlot(std::size_t& pos)
+{
+  pos = m_PushPosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    std::size_t sequence = m_Sequences[pos & m_Mask].load(std::memory_order_acquire);
+    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+    if (diff == 0)
+    {
+      // the buffer may have more slots than messages, see the constructor
+      std::ptrdiff_t size = static_cast<std::ptrdiff_t>(pos) - static_cast<std::ptrdiff_t>(m_PullPosition.load(std::memory_order_acquire));
+      if (size >= static_cast<std::ptrdiff_t>(m_Capacity))
+        return false;
+
+      // the slot is free, try to take it before another producer does
+      if (m_PushPosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        return true;
+    }
+    else if (diff < 0)
+    {
+      // the slot still holds a message from the previous round
+      return false;
+    }
+    else
+    {
+      pos = m_PushPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool mitk::IGTLMessageRingBufferBase::ClaimPullSlot(std::size_t& pos)
+{
+  pos = m_PullPosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    std::size_t sequence = m_Sequences[pos & m_Mask].load(std::memory_order_acquire);
+    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+    if (diff == 0)
+    {
+      if (m_PullPosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        return true;
+    }
+    else if (diff < 0)
+    {
+      // the slot was not written yet
+      return false;
+    }
+    else
+    {
+      pos = m_PullPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void mitk::IGTLMessageRingBufferBase::PublishPushSlot(std::size_t pos)
+{
+  m_Sequences[pos & m_Mask].store(pos + 1, std::memory_order_release);
+}
+
+void mitk::IGTLMessageRingBufferBase::PublishPullSlot(std::size_t pos)
+{
+  m_Sequences[pos & m_Mask].store(pos + m_Mask + 1, std::memory_order_release);
+}
+
+void mitk::IGTLMessageRingBufferBase::RecordLatency(ClockType::time_point pushTime)
+{
+  unsigned long long latency = std::chrono::duration_cast<std::chrono::microseconds>(ClockType::now() - pushTime).count();
+  ++m_NumberOfPulledMessages;
+  m_TotalLatency += latency;
+
+  unsigned long long maximum = m_MaximumLatency.load(std::memory_order_relaxed);
+  while (latency > maximum && !m_MaximumLatency.compare_exchange_weak(maximum, latency, std::memory_order_relaxed))
+  {
+  }
+}
+
+unsigned int mitk::IGTLMessageRingBufferBase::GetSize() const
+{
+  std::size_t pulled = m_PullPosition.load(std::memory_order_relaxed);
+  std::size_t pushed = m_PushPosition.load(std::memory_order_relaxed);
+  return pushed > pulled ? static_cast<unsigned int>(pushed - pulled) : 0;
+}
+
+mitk::IGTLMessageRingBufferBase::Statistics mitk::IGTLMessageRingBufferBase::GetStatistics() const
+{
+  Statistics statistics;
+  statistics.m_NumberOfPushedMessages = m_NumberOfPushedMessages.load();
+  statistics.m_NumberOfPulledMessages = m_NumberOfPulledMessages.load();
+  statistics.m_NumberOfDroppedMessages = m_NumberOfDroppedMessages.load();
+  statistics.m_MaximumLatency = m_MaximumLatency.load();
+  statistics.m_MeanLatency = statistics.m_NumberOfPulledMessages > 0
+    ? static_cast<double>(m_TotalLatency.load()) / statistics.m_NumberOfPulledMessages : 0.0;
+  return statistics;
+}
+
+void mitk::IGTLMessageRingBufferBase::ResetStatistics()
+{
+  m_NumberOfPushedMessages = 0;
+  m_NumberOfPulledMessages = 0;
+  m_NumberOfDroppedMessages = 0;
+  m_TotalLatency = 0;
+  m_MaximumLatency = 0;
+}
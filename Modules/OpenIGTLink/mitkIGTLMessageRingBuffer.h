@@ -0,0 +1,200 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef IGTLMessageRingBuffer_H
+#define IGTLMessageRingBuffer_H
+
+#include "MitkOpenIGTLinkExports.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace mitk {
+  /**
+  * \class IGTLMessageRingBufferBase
+  * \brief Overflow policy and statistics of the OpenIGTLink message ring buffers.
+  *
+  * \ingroup OpenIGTLink
+  */
+  class MITKOPENIGTLINK_EXPORT IGTLMessageRingBufferBase
+  {
+  public:
+    /**
+    * \brief Behavior of Push() if the buffer is full
+    * OverwriteOldest drops the oldest message to make room for the new one.
+    * Block waits until the consumer made room or the block timeout expired; the
+    * new message is dropped after the timeout.
+    */
+    enum OverflowPolicy { OverwriteOldest, Block };
+
+    /**
+    * \brief Counters of a buffer. Latencies are measured from Push() to Pull() in
+    * microseconds and only cover pulled messages.
+    */
+    struct Statistics
+    {
+      unsigned long long m_NumberOfPushedMessages;
+      unsigned long long m_NumberOfPulledMessages;
+      unsigned long long m_NumberOfDroppedMessages;
+      unsigned long long m_MaximumLatency;
+      double m_MeanLatency;
+    };
+
+    IGTLMessageRingBufferBase(unsigned int capacity, OverflowPolicy policy, unsigned int blockTimeout);
+    virtual ~IGTLMessageRingBufferBase() {}
+
+    /** \brief Maximum number of messages, the requested capacity rounded up to a power of two */
+    unsigned int GetCapacity() const { return static_cast<unsigned int>(m_Capacity); }
+    OverflowPolicy GetOverflowPolicy() const { return m_Policy; }
+    /** \brief Maximum time in ms Push() waits with the Block policy */
+    unsigned int GetBlockTimeout() const { return m_BlockTimeout; }
+
+    /** \brief Number of messages in the buffer. Only a snapshot if other threads push or pull. */
+    unsigned int GetSize() const;
+
+    Statistics GetStatistics() const;
+    void ResetStatistics();
+
+  protected:
+    typedef std::chrono::steady_clock ClockType;
+
+    /** \brief Claims the next free slot for writing. Returns false if the buffer is full. */
+    bool ClaimPushSlot(std::size_t& pos);
+    /** \brief Claims the oldest written slot for reading. Returns false if the buffer is empty. */
+    bool ClaimPullSlot(std::size_t& pos);
+    /** \brief Hands the slot over to the consumers/producers after it was written/read */
+    void PublishPushSlot(std::size_t pos);
+    void PublishPullSlot(std::size_t pos);
+
+    void RecordLatency(ClockType::time_point pushTime);
+
+    // position of each slot in the sequence of pushes and pulls, see D. Vyukov's bounded queue
+    std::unique_ptr< std::atomic<std::size_t>[] > m_Sequences;
+    std::size_t m_Capacity;
+    std::size_t m_Mask;
+
+    std::atomic<std::size_t> m_PushPosition;
+    std::atomic<std::size_t> m_PullPosition;
+
+    OverflowPolicy m_Policy;
+    unsigned int m_BlockTimeout;
+
+    std::atomic<unsigned long long> m_NumberOfPushedMessages;
+    std::atomic<unsigned long long> m_NumberOfPulledMessages;
+    std::atomic<unsigned long long> m_NumberOfDroppedMessages;
+    std::atomic<unsigned long long> m_TotalLatency;
+    std::atomic<unsigned long long> m_MaximumLatency;
+
+  private:
+    IGTLMessageRingBufferBase(const IGTLMessageRingBufferBase&);
+    IGTLMessageRingBufferBase& operator=(const IGTLMessageRingBufferBase&);
+  };
+
+  /**
+  * \class IGTLMessageRingBuffer
+  * \brief Fixed capacity lock-free queue of OpenIGTLink messages.
+  *
+  * Producers and consumers synchronize on a sequence number per slot, no mutex
+  * is involved. The buffer is meant for one producer (e.g. the receive thread
+  * of an IGTLDevice) and one consumer, but it stays correct with several of
+  * each. With the OverwriteOldest policy the producer removes the oldest
+  * message itself, so it never waits for the consumer.
+  *
+  * \ingroup OpenIGTLink
+  */
+  template <class TMessage>
+  class IGTLMessageRingBuffer : public IGTLMessageRingBufferBase
+  {
+  public:
+    typedef typename TMessage::Pointer MessagePointer;
+
+    IGTLMessageRingBuffer(unsigned int capacity = 1, OverflowPolicy policy = OverwriteOldest, unsigned int blockTimeout = 100)
+      : IGTLMessageRingBufferBase(capacity, policy, blockTimeout)
+      , m_Messages(new MessagePointer[m_Mask + 1])
+      , m_PushTimes(new ClockType::time_point[m_Mask + 1])
+    {
+    }
+
+    /**
+    * \brief Adds the message to the buffer according to the overflow policy.
+    * Returns false if the message was dropped.
+    */
+    bool Push(const MessagePointer& message)
+    {
+      ClockType::time_point start = ClockType::now();
+      std::size_t pos;
+      while (!this->ClaimPushSlot(pos))
+      {
+        if (m_Policy == OverwriteOldest)
+        {
+          MessagePointer oldest;
+          if (this->TryPull(oldest, false))
+            ++m_NumberOfDroppedMessages;
+        }
+        else if (ClockType::now() - start > std::chrono::milliseconds(m_BlockTimeout))
+        {
+          ++m_NumberOfDroppedMessages;
+          return false;
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+      }
+
+      m_Messages[pos & m_Mask] = message;
+      m_PushTimes[pos & m_Mask] = ClockType::now();
+      this->PublishPushSlot(pos);
+      ++m_NumberOfPushedMessages;
+      return true;
+    }
+
+    /**
+    * \brief Returns and removes the oldest message, nullptr if the buffer is empty
+    */
+    MessagePointer Pull()
+    {
+      MessagePointer message;
+      this->TryPull(message, true);
+      return message;
+    }
+
+  protected:
+    bool TryPull(MessagePointer& message, bool recordLatency)
+    {
+      std::size_t pos;
+      if (!this->ClaimPullSlot(pos))
+        return false;
+
+      message = m_Messages[pos & m_Mask];
+      m_Messages[pos & m_Mask] = nullptr;
+      ClockType::time_point pushTime = m_PushTimes[pos & m_Mask];
+      this->PublishPullSlot(pos);
+
+      if (recordLatency)
+        this->RecordLatency(pushTime);
+      return true;
+    }
+
+    std::unique_ptr< MessagePointer[] > m_Messages;
+    std::unique_ptr< ClockType::time_point[] > m_PushTimes;
+  };
+}
+
+#endif
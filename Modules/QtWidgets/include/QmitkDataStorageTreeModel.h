@@ -126,6 +126,14 @@ public:
   ///
   virtual void RemoveNode(const mitk::DataNode* node);
   ///
+  /// Adds the nodes of a committed DataStorage batch and adjusts the layers once.
+  ///
+  virtual void AddNodes(const mitk::DataStorage::SetOfObjects* nodes);
+  ///
+  /// Removes the nodes of a committed DataStorage batch and adjusts the layers once.
+  ///
+  virtual void RemoveNodes(const mitk::DataStorage::SetOfObjects* nodes);
+  ///
   /// Sets a node to modfified. Called by the DataStorage
   ///
   virtual void SetNodeModified(const mitk::DataNode* node);
@@ -250,8 +258,8 @@ protected:
   TreeItem* m_Root;
 
 private:
-  void AddNodeInternal(const mitk::DataNode*);
-  void RemoveNodeInternal(const mitk::DataNode*);
+  void AddNodeInternal(const mitk::DataNode*, bool adjustLayerProperty = true);
+  void RemoveNodeInternal(const mitk::DataNode*, bool adjustLayerProperty = true);
   ///
   /// Checks if dicom properties patient name, study names and series name exists
   ///
@@ -436,6 +436,12 @@ void QmitkDataStorageTreeModel::SetDataStorage( mitk::DataStorage* _DataStorage
       m_DataStorage->RemoveNodeEvent.RemoveListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
         , const mitk::DataNode*>( this, &QmitkDataStorageTreeModel::RemoveNode ) );
 
+      m_DataStorage->AddNodesEvent.RemoveListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
+        , const mitk::DataStorage::SetOfObjects*>( this, &QmitkDataStorageTreeModel::AddNodes ) );
+
+      m_DataStorage->RemoveNodesEvent.RemoveListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
+        , const mitk::DataStorage::SetOfObjects*>( this, &QmitkDataStorageTreeModel::RemoveNodes ) );
+
     }
 
     // take over the new data storage
@@ -466,6 +472,12 @@ void QmitkDataStorageTreeModel::SetDataStorage( mitk::DataStorage* _DataStorage
       m_DataStorage->RemoveNodeEvent.AddListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
         , const mitk::DataNode*>( this, &QmitkDataStorageTreeModel::RemoveNode ) );
 
+      m_DataStorage->AddNodesEvent.AddListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
+        , const mitk::DataStorage::SetOfObjects*>( this, &QmitkDataStorageTreeModel::AddNodes ) );
+
+      m_DataStorage->RemoveNodesEvent.AddListener( mitk::MessageDelegate1<QmitkDataStorageTreeModel
+        , const mitk::DataStorage::SetOfObjects*>( this, &QmitkDataStorageTreeModel::RemoveNodes ) );
+
       mitk::DataStorage::SetOfObjects::ConstPointer _NodeSet = m_DataStorage->GetSubset(m_Predicate);
 
       // finally add all nodes to the model
@@ -479,7 +491,7 @@ void QmitkDataStorageTreeModel::SetDataStorageDeleted( const itk::Object* /*_Dat
   this->SetDataStorage(0);
 }
 
-void QmitkDataStorageTreeModel::AddNodeInternal(const mitk::DataNode *node)
+void QmitkDataStorageTreeModel::AddNodeInternal(const mitk::DataNode *node, bool adjustLayerProperty)
 {
     if(node == 0
       || m_DataStorage.IsNull()
@@ -497,7 +509,7 @@ void QmitkDataStorageTreeModel::AddNodeInternal(const mitk::DataNode *node)
       parentTreeItem = m_Root->Find(parentDataNode); // find the corresponding tree item
       if(!parentTreeItem)
       {
-        this->AddNode(parentDataNode);
+        this->AddNodeInternal(parentDataNode, adjustLayerProperty);
         parentTreeItem = m_Root->Find(parentDataNode);
         if(!parentTreeItem)
           return;
@@ -525,7 +537,8 @@ void QmitkDataStorageTreeModel::AddNodeInternal(const mitk::DataNode *node)
     // emit endInsertRows event
     endInsertRows();
 
-    this->AdjustLayerProperty();
+    if (adjustLayerProperty)
+      this->AdjustLayerProperty();
 }
 
 void QmitkDataStorageTreeModel::AddNode( const mitk::DataNode* node )
@@ -534,19 +547,31 @@ void QmitkDataStorageTreeModel::AddNode( const mitk::DataNode* node )
       || node == 0
       || m_DataStorage.IsNull()
       || !m_DataStorage->Exists(node)
-      || m_Root->Find(node) != 0)
+      || m_Root->Find(node) != 0
+      || m_DataStorage->IsCommittingBatch(node)) // handled by AddNodes()
       return;
 
       this->AddNodeInternal(node);
 }
 
+void QmitkDataStorageTreeModel::AddNodes( const mitk::DataStorage::SetOfObjects* nodes )
+{
+    if (m_BlockDataStorageEvents || nodes == 0 || m_DataStorage.IsNull())
+      return;
+
+    for (mitk::DataStorage::SetOfObjects::ConstIterator it = nodes->Begin(); it != nodes->End(); ++it)
+      this->AddNodeInternal(it.Value(), false);
+
+    this->AdjustLayerProperty();
+}
+
 
 void QmitkDataStorageTreeModel::SetPlaceNewNodesOnTop(bool _PlaceNewNodesOnTop)
 {
   m_PlaceNewNodesOnTop = _PlaceNewNodesOnTop;
 }
 
-void QmitkDataStorageTreeModel::RemoveNodeInternal( const mitk::DataNode* node )
+void QmitkDataStorageTreeModel::RemoveNodeInternal( const mitk::DataNode* node, bool adjustLayerProperty )
 {
     if(!m_Root) return;
 
@@ -582,7 +607,8 @@ void QmitkDataStorageTreeModel::RemoveNodeInternal( const mitk::DataNode* node )
       endInsertRows();
     }
 
-    this->AdjustLayerProperty();
+    if (adjustLayerProperty)
+      this->AdjustLayerProperty();
 }
 
 void QmitkDataStorageTreeModel::RemoveNode( const mitk::DataNode* node )
@@ -590,9 +616,24 @@ void QmitkDataStorageTreeModel::RemoveNode( const mitk::DataNode* node )
     if (m_BlockDataStorageEvents || node == 0)
         return;
 
+    // handled by RemoveNodes()
+    if (m_DataStorage.IsNotNull() && m_DataStorage->IsCommittingBatch(node))
+        return;
+
     this->RemoveNodeInternal(node);
 }
 
+void QmitkDataStorageTreeModel::RemoveNodes( const mitk::DataStorage::SetOfObjects* nodes )
+{
+    if (m_BlockDataStorageEvents || nodes == 0)
+        return;
+
+    for (mitk::DataStorage::SetOfObjects::ConstIterator it = nodes->Begin(); it != nodes->End(); ++it)
+      this->RemoveNodeInternal(it.Value(), false);
+
+    this->AdjustLayerProperty();
+}
+
 void QmitkDataStorageTreeModel::SetNodeModified( const mitk::DataNode* node )
 {
   TreeItem* treeItem = m_Root->Find(node);
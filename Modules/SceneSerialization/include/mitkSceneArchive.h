@@ -0,0 +1,121 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkSceneArchive_h_included
+#define mitkSceneArchive_h_included
+
+#include <MitkSceneSerializationExports.h>
+
+#include <mitkCommon.h>
+#include <itkObject.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Poco
+{
+namespace Zip
+{
+class ZipArchive;
+}
+}
+
+namespace mitk
+{
+
+/**
+ * \brief Read access to the files of a scene file (.mitk) without unpacking the whole archive.
+ *
+ * Only the directory of the ZIP archive is read by Open(). Single files can then be read
+ * into memory (used for index.xml) or extracted to a directory right before a reader needs
+ * them on disk. Extracted files are removed again by RemoveExtractedFiles(), so that the
+ * temporary disk space needed while loading a scene is that of a single node instead of
+ * that of the whole scene.
+ *
+ * Every read opens its own stream on the scene file, so files can be read and extracted
+ * from several threads at the same time.
+ */
+class MITKSCENESERIALIZATION_EXPORT SceneArchive : public itk::Object
+{
+  public:
+
+    mitkClassMacroItkParent( SceneArchive, itk::Object );
+    itkFactorylessNewMacro(Self)
+
+    /**
+     * \brief Open a scene file and read the directory of its entries.
+     * \return false if the file cannot be opened or is no valid ZIP archive.
+     */
+    bool Open( const std::string& filename );
+
+    void Close();
+
+    bool IsOpen() const;
+
+    /**
+     * \brief Names of all files contained in the archive (directories are omitted).
+     */
+    std::vector<std::string> GetFileNames() const;
+
+    bool HasFile( const std::string& name ) const;
+
+    /**
+     * \brief Decompress a file of the archive into memory.
+     */
+    bool ReadFile( const std::string& name, std::string& content );
+
+    /**
+     * \brief Decompress a file of the archive into the given directory.
+     *
+     * All files that share the part of the name before the first '.' are extracted
+     * together, so that formats with separate header and data files (.mhd/.raw) can be read.
+     */
+    bool ExtractFile( const std::string& name, const std::string& directory );
+
+    /**
+     * \brief Like ExtractFile(), but the extracted files are appended to extractedFiles
+     * instead of being remembered for RemoveExtractedFiles().
+     */
+    bool ExtractFile( const std::string& name, const std::string& directory, std::vector<std::string>& extractedFiles );
+
+    /**
+     * \brief Delete all files that were extracted by ExtractFile() since the last call.
+     */
+    void RemoveExtractedFiles();
+
+    /**
+     * \brief Delete the given files and clear the list.
+     */
+    static void RemoveFiles( std::vector<std::string>& files );
+
+  protected:
+
+    SceneArchive();
+    virtual ~SceneArchive();
+
+    bool ExtractSingleFile( const std::string& name, const std::string& directory, std::vector<std::string>& extractedFiles ) const;
+
+    std::string m_Filename;
+    std::unique_ptr<Poco::Zip::ZipArchive> m_Archive;
+    std::vector<std::string> m_ExtractedFiles;
+    std::mutex m_ExtractedFilesMutex;
+};
+
+}
+
+#endif
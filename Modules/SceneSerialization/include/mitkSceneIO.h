@@ -21,8 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDataStorage.h"
 #include "mitkNodePredicateBase.h"
+#include "mitkSceneNodeTiming.h"
 
-#include <Poco/Zip/ZipLocalFileHeader.h>
+#include <mutex>
 
 class TiXmlElement;
 
@@ -47,7 +48,9 @@ class MITKSCENESERIALIZATION_EXPORT SceneIO : public itk::Object
      * \return DataStorage with all scene objects and their relations. If loading failed, query GetFailedNodes() and GetFailedProperties() for more detail.
      *
      * Attempts to read the provided file and create objects with
-     * parent/child relations into a DataStorage.
+     * parent/child relations into a DataStorage. The archive is not unpacked as a whole:
+     * index.xml is parsed from memory and the files of each node are extracted to a temporary
+     * directory only while that node is read.
      *
      * \param filename full filename of the scene file
      * \param storage If given, this DataStorage is used instead of a newly created one
@@ -64,6 +67,8 @@ class MITKSCENESERIALIZATION_EXPORT SceneIO : public itk::Object
      *
      * Attempts to write a scene file, which contains the nodes of the
      * provided DataStorage, their parent/child relations, and properties.
+     * The files of each node are added to the archive as soon as the node is serialized,
+     * so only the files of a single node are kept in the temporary directory.
      *
      * \param storage a DataStorage containing all nodes that should be saved
      * \param filename full filename of the scene file
@@ -93,6 +98,19 @@ class MITKSCENESERIALIZATION_EXPORT SceneIO : public itk::Object
      */
     const PropertyList* GetFailedProperties();
 
+    /**
+     * \brief Number of threads reading or writing nodes concurrently, 0 uses the default of itk::MultiThreader.
+     */
+    itkSetMacro(NumberOfThreads, unsigned int);
+    itkGetConstMacro(NumberOfThreads, unsigned int);
+
+    /**
+     * \brief Time spent on each node during the last call to LoadScene or SaveScene.
+     *
+     * Entries are in the order of the scene file or of the saved nodes, respectively.
+     */
+    const SceneNodeTimingList& GetNodeTimings() const;
+
   protected:
 
     SceneIO();
@@ -100,17 +118,16 @@ class MITKSCENESERIALIZATION_EXPORT SceneIO : public itk::Object
 
     std::string CreateEmptyTempDirectory();
 
-    TiXmlElement* SaveBaseData( BaseData* data, const std::string& filenamehint, bool& error);
-    TiXmlElement* SavePropertyList( PropertyList* propertyList, const std::string& filenamehint );
-
-    void OnUnzipError(const void* pSender, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string>& info);
-    void OnUnzipOk(const void* pSender, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path>& info);
+    TiXmlElement* SaveBaseData( BaseData* data, const std::string& filenamehint, const std::string& workingDirectory, bool& error);
+    TiXmlElement* SavePropertyList( PropertyList* propertyList, const std::string& filenamehint, const std::string& workingDirectory );
 
     FailedBaseDataListType::Pointer m_FailedNodes;
     PropertyList::Pointer           m_FailedProperties;
+    std::mutex                      m_FailedPropertiesMutex;
 
     std::string  m_WorkingDirectory;
-    unsigned int m_UnzipErrors;
+    unsigned int m_NumberOfThreads;
+    SceneNodeTimingList m_NodeTimings;
 };
 
 }
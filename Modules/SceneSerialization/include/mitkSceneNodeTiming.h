@@ -0,0 +1,44 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkSceneNodeTiming_h_included
+#define mitkSceneNodeTiming_h_included
+
+#include <string>
+#include <vector>
+
+namespace mitk
+{
+
+/**
+ * \brief Time spent on reading or writing one node of a scene.
+ *
+ * Nodes are read and written concurrently, so the times of all nodes add up
+ * to more than the wall clock time of SceneIO::LoadScene() or SceneIO::SaveScene().
+ */
+struct SceneNodeTiming
+{
+  std::string m_UID;
+  std::string m_Name;
+  double m_DataSeconds;        ///< reading or writing the BaseData file
+  double m_PropertiesSeconds;  ///< reading or writing the property lists of data and node
+};
+
+typedef std::vector<SceneNodeTiming> SceneNodeTimingList;
+
+}
+
+#endif
@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkObjectFactory.h>
 
 #include "mitkDataStorage.h"
+#include "mitkSceneArchive.h"
+#include "mitkSceneNodeTiming.h"
 
 namespace mitk
 {
@@ -34,6 +36,46 @@ class MITKSCENESERIALIZATION_EXPORT SceneReader : public itk::Object
     itkCloneMacro(Self)
 
     virtual bool LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage );
+
+    /**
+     * \brief Archive from which the files referenced by the scene are extracted on demand.
+     *
+     * If no archive is set, all files are expected to exist in the working directory.
+     */
+    itkSetObjectMacro(Archive, SceneArchive);
+    itkGetObjectMacro(Archive, SceneArchive);
+
+    /**
+     * \brief Number of threads reading nodes concurrently, 0 uses the default of itk::MultiThreader.
+     */
+    itkSetMacro(NumberOfThreads, unsigned int);
+    itkGetConstMacro(NumberOfThreads, unsigned int);
+
+    /**
+     * \brief Time spent on each node during the last call to LoadScene(), in the order of the scene file.
+     */
+    const SceneNodeTimingList& GetNodeTimings() const;
+
+  protected:
+
+    SceneReader();
+
+    /**
+     * \brief Makes sure that a file referenced by the scene exists in the working directory.
+     *
+     * The names of extracted files are appended to extractedFiles, so that concurrent
+     * readers can each remove their own files by ReleaseFiles().
+     */
+    bool PrepareFile( const std::string& filename, const std::string& workingDirectory, std::vector<std::string>& extractedFiles );
+
+    /**
+     * \brief Removes the files that were extracted by PrepareFile().
+     */
+    static void ReleaseFiles( std::vector<std::string>& extractedFiles );
+
+    SceneArchive::Pointer m_Archive;
+    unsigned int m_NumberOfThreads;
+    SceneNodeTimingList m_NodeTimings;
 };
 
 }
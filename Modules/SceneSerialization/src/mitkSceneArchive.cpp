@@ -0,0 +1,215 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSceneArchive.h"
+
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/Zip/ZipArchive.h>
+#include <Poco/Zip/ZipStream.h>
+
+#include <fstream>
+#include <sstream>
+
+mitk::SceneArchive::SceneArchive()
+{
+}
+
+mitk::SceneArchive::~SceneArchive()
+{
+  this->RemoveExtractedFiles();
+}
+
+bool mitk::SceneArchive::Open( const std::string& filename )
+{
+  this->Close();
+
+  std::ifstream stream( filename.c_str(), std::ios::binary );
+  if (!stream.good())
+  {
+    MITK_ERROR << "Cannot open '" << filename << "' for reading";
+    return false;
+  }
+
+  try
+  {
+    // parses the local file headers only, the entries are decompressed on request
+    m_Archive.reset( new Poco::Zip::ZipArchive( stream ) );
+  }
+  catch (std::exception& e)
+  {
+    MITK_ERROR << "Could not read the contents of '" << filename << "': " << e.what();
+    this->Close();
+    return false;
+  }
+
+  m_Filename = filename;
+  return true;
+}
+
+void mitk::SceneArchive::Close()
+{
+  this->RemoveExtractedFiles();
+  m_Archive.reset();
+  m_Filename.clear();
+}
+
+bool mitk::SceneArchive::IsOpen() const
+{
+  return m_Archive.get() != nullptr;
+}
+
+std::vector<std::string> mitk::SceneArchive::GetFileNames() const
+{
+  std::vector<std::string> names;
+  if (!this->IsOpen())
+    return names;
+
+  for (auto iter = m_Archive->headerBegin(); iter != m_Archive->headerEnd(); ++iter)
+  {
+    if (iter->second.isFile())
+    {
+      names.push_back( iter->first );
+    }
+  }
+  return names;
+}
+
+bool mitk::SceneArchive::HasFile( const std::string& name ) const
+{
+  return this->IsOpen() && m_Archive->findHeader( name ) != m_Archive->headerEnd();
+}
+
+bool mitk::SceneArchive::ReadFile( const std::string& name, std::string& content )
+{
+  content.clear();
+  if (!this->HasFile(name))
+  {
+    MITK_ERROR << "File '" << name << "' not found in '" << m_Filename << "'";
+    return false;
+  }
+
+  try
+  {
+    std::ifstream stream( m_Filename.c_str(), std::ios::binary );
+    Poco::Zip::ZipInputStream zipStream( stream, m_Archive->findHeader( name )->second );
+    std::ostringstream output;
+    Poco::StreamCopier::copyStream( zipStream, output );
+    content = output.str();
+  }
+  catch (std::exception& e)
+  {
+    MITK_ERROR << "Error while unzipping '" << name << "' from '" << m_Filename << "': " << e.what();
+    return false;
+  }
+  return true;
+}
+
+bool mitk::SceneArchive::ExtractFile( const std::string& name, const std::string& directory )
+{
+  std::vector<std::string> extractedFiles;
+  bool success = this->ExtractFile( name, directory, extractedFiles );
+
+  std::lock_guard<std::mutex> lock( m_ExtractedFilesMutex );
+  m_ExtractedFiles.insert( m_ExtractedFiles.end(), extractedFiles.begin(), extractedFiles.end() );
+  return success;
+}
+
+bool mitk::SceneArchive::ExtractFile( const std::string& name, const std::string& directory, std::vector<std::string>& extractedFiles )
+{
+  if (!this->HasFile(name))
+  {
+    MITK_ERROR << "File '" << name << "' not found in '" << m_Filename << "'";
+    return false;
+  }
+
+  bool success = this->ExtractSingleFile( name, directory, extractedFiles );
+
+  // companion files, e.g. the .raw file of a .mhd header
+  const std::string stem = name.substr( 0, name.find('.') );
+  for (auto iter = m_Archive->headerBegin(); iter != m_Archive->headerEnd(); ++iter)
+  {
+    if ( iter->first != name && iter->second.isFile() &&
+         iter->first.size() > stem.size() && iter->first.compare( 0, stem.size() + 1, stem + "." ) == 0 )
+    {
+      success &= this->ExtractSingleFile( iter->first, directory, extractedFiles );
+    }
+  }
+  return success;
+}
+
+bool mitk::SceneArchive::ExtractSingleFile( const std::string& name, const std::string& directory, std::vector<std::string>& extractedFiles ) const
+{
+  Poco::Path path( directory, Poco::Path::PATH_NATIVE );
+  path.makeDirectory();
+  path.append( Poco::Path( name, Poco::Path::PATH_UNIX ) );
+  const std::string filename = path.toString();
+
+  try
+  {
+    Poco::File( path.parent() ).createDirectories();
+
+    std::ofstream output( filename.c_str(), std::ios::binary | std::ios::out );
+    if (!output.good())
+    {
+      MITK_ERROR << "Cannot open '" << filename << "' for writing";
+      return false;
+    }
+    extractedFiles.push_back( filename );
+
+    std::ifstream stream( m_Filename.c_str(), std::ios::binary );
+    Poco::Zip::ZipInputStream zipStream( stream, m_Archive->findHeader( name )->second );
+    Poco::StreamCopier::copyStream( zipStream, output );
+    if (!output.good())
+    {
+      MITK_ERROR << "Error while writing '" << filename << "'";
+      return false;
+    }
+  }
+  catch (std::exception& e)
+  {
+    MITK_ERROR << "Error while unzipping '" << name << "' from '" << m_Filename << "': " << e.what();
+    return false;
+  }
+  return true;
+}
+
+void mitk::SceneArchive::RemoveExtractedFiles()
+{
+  std::lock_guard<std::mutex> lock( m_ExtractedFilesMutex );
+  RemoveFiles( m_ExtractedFiles );
+}
+
+void mitk::SceneArchive::RemoveFiles( std::vector<std::string>& files )
+{
+  for (auto iter = files.begin(); iter != files.end(); ++iter)
+  {
+    try
+    {
+      Poco::File file( *iter );
+      if (file.exists())
+      {
+        file.remove();
+      }
+    }
+    catch (...)
+    {
+      MITK_ERROR << "Could not delete temporary file " << *iter;
+    }
+  }
+  files.clear();
+}
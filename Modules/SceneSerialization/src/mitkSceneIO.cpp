@@ -16,14 +16,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <Poco/TemporaryFile.h>
 #include <Poco/Path.h>
-#include <Poco/Delegate.h>
+#include <Poco/DateTime.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/File.h>
 #include <Poco/Zip/Compress.h>
-#include <Poco/Zip/Decompress.h>
 
 #include "mitkSceneIO.h"
+#include "mitkSceneArchive.h"
 #include "mitkBaseDataSerializer.h"
 #include "mitkPropertyListSerializer.h"
 #include "mitkSceneReader.h"
+#include "mitkSceneTasks.h"
 
 #include "mitkProgressBar.h"
 #include "mitkBaseRenderer.h"
@@ -36,15 +39,39 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <tinyxml.h>
 
+#include <chrono>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <mitkIOUtil.h>
 
 #include "itksys/SystemTools.hxx"
 
+namespace
+{
+  // adds all files of the working directory to the archive and deletes them
+  void MoveFilesToArchive( const std::string& workingDirectory, Poco::Zip::Compress& zipper )
+  {
+    std::vector<Poco::Path> files;
+    for (Poco::DirectoryIterator iter( workingDirectory ); iter != Poco::DirectoryIterator(); ++iter)
+    {
+      if (iter->isFile())
+      {
+        files.push_back( iter.path() );
+      }
+    }
+
+    for (auto path : files)
+    {
+      zipper.addFile( path, Poco::Path( path.getFileName(), Poco::Path::PATH_UNIX ) );
+      Poco::File( path ).remove();
+    }
+  }
+}
+
 mitk::SceneIO::SceneIO()
   :m_WorkingDirectory(""),
-  m_UnzipErrors(0)
+  m_NumberOfThreads(0)
 {
 }
 
@@ -117,50 +144,46 @@ mitk::DataStorage::Pointer mitk::SceneIO::LoadScene( const std::string& filename
     return storage;
   }
 
-  // test if filename can be read
-  std::ifstream file( filename.c_str(), std::ios::binary );
-  if (!file.good())
+  // read the directory of the archive, entries are unzipped only when they are read
+  SceneArchive::Pointer archive = SceneArchive::New();
+  if ( !archive->Open( filename ) )
   {
-    MITK_ERROR << "Cannot open '" << filename << "' for reading";
     return storage;
   }
 
-  // get new temporary directory
-  m_WorkingDirectory = CreateEmptyTempDirectory();
-  if (m_WorkingDirectory.empty())
+  // parse index.xml with TinyXML, directly from the archive
+  std::string index;
+  if ( !archive->ReadFile( "index.xml", index ) )
   {
-    MITK_ERROR << "Could not create temporary directory. Cannot open scene files.";
+    MITK_ERROR << "Could not read index.xml from '" << filename << "'";
     return storage;
   }
 
-  // unzip all filenames contents to temp dir
-  m_UnzipErrors = 0;
-  Poco::Zip::Decompress unzipper( file, Poco::Path( m_WorkingDirectory ) );
-  unzipper.EError += Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string> >(this, &SceneIO::OnUnzipError);
-  unzipper.EOk    += Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path> >(this, &SceneIO::OnUnzipOk);
-  unzipper.decompressAllFiles();
-  unzipper.EError -= Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string> >(this, &SceneIO::OnUnzipError);
-  unzipper.EOk    -= Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path> >(this, &SceneIO::OnUnzipOk);
-
-  if ( m_UnzipErrors )
+  TiXmlDocument document;
+  document.Parse( index.c_str() );
+  if ( document.Error() )
   {
-    MITK_ERROR << "There were " << m_UnzipErrors << " errors unzipping '" << filename << "'. Will attempt to read whatever could be unzipped.";
+    MITK_ERROR << "Could not parse index.xml of '" << filename << "'\nTinyXML reports: " << document.ErrorDesc() << std::endl;
+    return storage;
   }
 
-  // test if index.xml exists
-  // parse index.xml with TinyXML
-  TiXmlDocument document( m_WorkingDirectory + mitk::IOUtil::GetDirectorySeparator() + "index.xml" );
-  if (!document.LoadFile())
+  // get new temporary directory, it will only hold the files of the node that is currently read
+  m_WorkingDirectory = CreateEmptyTempDirectory();
+  if (m_WorkingDirectory.empty())
   {
-    MITK_ERROR << "Could not open/read/parse " << m_WorkingDirectory << mitk::IOUtil::GetDirectorySeparator() << "index.xml\nTinyXML reports: " << document.ErrorDesc() << std::endl;
+    MITK_ERROR << "Could not create temporary directory. Cannot open scene files.";
     return storage;
   }
 
   SceneReader::Pointer reader = SceneReader::New();
+  reader->SetArchive( archive );
+  reader->SetNumberOfThreads( m_NumberOfThreads );
   if ( !reader->LoadScene( document, m_WorkingDirectory, storage ) )
   {
     MITK_ERROR << "There were errors while loading scene file " << filename << ". Your data may be corrupted";
   }
+  m_NodeTimings = reader->GetNodeTimings();
+  archive->Close();
 
   // delete temp directory
   try
@@ -199,10 +222,30 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
   mitk::LocaleSwitch localeSwitch("C");
 
+  // the archive is written to a temporary file next to filename, which replaces filename only when the
+  // archive is complete. Thus a failed save neither destroys an existing scene nor leaves a partial one.
+  std::string temporaryFilename;
+  auto removeTemporaryFiles = [&]()
+  {
+    try
+    {
+      if ( !temporaryFilename.empty() && Poco::File( temporaryFilename ).exists() )
+        Poco::File( temporaryFilename ).remove();
+      if ( !m_WorkingDirectory.empty() && Poco::File( m_WorkingDirectory ).exists() )
+        Poco::File( m_WorkingDirectory ).remove(true); // recursive
+    }
+    catch(...)
+    {
+      MITK_ERROR << "Could not delete temporary files of scene " << filename;
+    }
+  };
+
   try
   {
     m_FailedNodes = DataStorage::SetOfObjects::New();
     m_FailedProperties = PropertyList::New();
+    m_NodeTimings.clear();
+    bool success(true);
 
     // start XML DOM
     TiXmlDocument document;
@@ -217,6 +260,25 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
     //DataStorage::SetOfObjects::ConstPointer sceneNodes = storage->GetSubset( predicate );
 
+    // the working directory only holds the files of the nodes that are currently serialized
+    m_WorkingDirectory = CreateEmptyTempDirectory();
+    if (m_WorkingDirectory.empty())
+    {
+      MITK_ERROR << "Could not create temporary directory. Cannot create scene files.";
+      return false;
+    }
+
+    // create the zip, the files of each node are added as soon as they are written
+    temporaryFilename = Poco::TemporaryFile::tempName( Poco::Path( filename ).absolute().parent().toString() );
+    std::ofstream file( temporaryFilename.c_str(), std::ios::binary | std::ios::out);
+    if (!file.good())
+    {
+      MITK_ERROR << "Could not open a zip file for writing: '" << temporaryFilename << "'";
+      removeTemporaryFiles();
+      return false;
+    }
+    Poco::Zip::Compress zipper( file, true );
+
     if ( sceneNodes.IsNull() )
     {
       MITK_WARN << "Saving empty scene to " << filename;
@@ -230,13 +292,6 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
       MITK_INFO << "Storing scene with " << sceneNodes->size() << " objects to " << filename;
 
-      m_WorkingDirectory = CreateEmptyTempDirectory();
-      if (m_WorkingDirectory.empty())
-      {
-        MITK_ERROR << "Could not create temporary directory. Cannot create scene files.";
-        return false;
-      }
-
       ProgressBar::GetInstance()->AddStepsToDo( sceneNodes->size() );
 
       // find out about dependencies
@@ -282,149 +337,190 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
       }
 
       // write out objects, dependencies and properties
+      // The nodes are serialized concurrently, each into its own subdirectory of the working
+      // directory. As soon as a node is written, its files are moved into the archive.
+      std::vector<DataNode*> nodes;
       for (DataStorage::SetOfObjects::const_iterator iter = sceneNodes->begin();
         iter != sceneNodes->end();
         ++iter)
       {
-        DataNode* node = iter->GetPointer();
+        nodes.push_back( iter->GetPointer() );
+      }
+
+      std::vector<TiXmlElement*> nodeElements( nodes.size(), nullptr );
+      std::vector<char> nodeErrors( nodes.size(), 0 ); // not std::vector<bool>, which is not safe for concurrent writes
+      m_NodeTimings.assign( nodes.size(), SceneNodeTiming() );
+      std::mutex zipperMutex;
+
+      bool tasksSucceeded = RunSceneTasks( nodes.size(), m_NumberOfThreads, [&](std::size_t i)
+      {
+        DataNode* node = nodes[i];
+        if (!node)
+          return;
 
-        if (node)
+        std::ostringstream nodeDirectoryName;
+        nodeDirectoryName << m_WorkingDirectory << Poco::Path::separator() << "node" << i;
+        const std::string nodeDirectory = nodeDirectoryName.str();
+        Poco::File( nodeDirectory ).createDirectories();
+
+        SceneNodeTiming& timing = m_NodeTimings[i];
+        timing.m_Name = node->GetName();
+
+        std::unique_ptr<TiXmlElement> nodeElement( new TiXmlElement("node") );
+        std::string filenameHint( node->GetName() );
+        filenameHint = itksys::SystemTools::MakeCindentifier(filenameHint.c_str()); // escape filename <-- only allow [A-Za-z0-9_], replace everything else with _
+
+        // store dependencies
+        UIDMapType::iterator searchUIDIter = nodeUIDs.find(node);
+        if ( searchUIDIter != nodeUIDs.end() )
         {
-          TiXmlElement* nodeElement = new TiXmlElement("node");
-          std::string filenameHint( node->GetName() );
-          filenameHint = itksys::SystemTools::MakeCindentifier(filenameHint.c_str()); // escape filename <-- only allow [A-Za-z0-9_], replace everything else with _
+          // store this node's ID
+          nodeElement->SetAttribute("UID", searchUIDIter->second.c_str() );
+          timing.m_UID = searchUIDIter->second;
+        }
 
-          // store dependencies
-          UIDMapType::iterator searchUIDIter = nodeUIDs.find(node);
-          if ( searchUIDIter != nodeUIDs.end() )
+        SourcesMapType::iterator searchSourcesIter = sourceUIDs.find(node);
+        if ( searchSourcesIter != sourceUIDs.end() )
+        {
+          // store all source IDs
+          for ( std::list<std::string>::iterator sourceUIDIter = searchSourcesIter->second.begin();
+            sourceUIDIter != searchSourcesIter->second.end();
+            ++sourceUIDIter )
           {
-            // store this node's ID
-            nodeElement->SetAttribute("UID", searchUIDIter->second.c_str() );
+            TiXmlElement* uidElement = new TiXmlElement("source");
+            uidElement->SetAttribute("UID", sourceUIDIter->c_str() );
+            nodeElement->LinkEndChild( uidElement );
           }
+        }
 
-          SourcesMapType::iterator searchSourcesIter = sourceUIDs.find(node);
-          if ( searchSourcesIter != sourceUIDs.end() )
-          {
-            // store all source IDs
-            for ( std::list<std::string>::iterator sourceUIDIter = searchSourcesIter->second.begin();
-              sourceUIDIter != searchSourcesIter->second.end();
-              ++sourceUIDIter )
-            {
-              TiXmlElement* uidElement = new TiXmlElement("source");
-              uidElement->SetAttribute("UID", sourceUIDIter->c_str() );
-              nodeElement->LinkEndChild( uidElement );
-            }
-          }
+        double propertiesSeconds = 0.0;
 
-          // store basedata
-          if ( BaseData* data = node->GetData() )
+        // store basedata
+        if ( BaseData* data = node->GetData() )
+        {
+          //std::string filenameHint( node->GetName() );
+          bool error(false);
+          auto start = std::chrono::steady_clock::now();
+          TiXmlElement* dataElement( SaveBaseData( data, filenameHint, nodeDirectory, error ) ); // returns a reference to a file
+          auto dataSaved = std::chrono::steady_clock::now();
+          timing.m_DataSeconds = std::chrono::duration<double>(dataSaved - start).count();
+          nodeErrors[i] = error;
+
+          // store basedata properties
+          PropertyList* propertyList = data->GetPropertyList();
+          if (propertyList && !propertyList->IsEmpty() )
           {
-            //std::string filenameHint( node->GetName() );
-            bool error(false);
-            TiXmlElement* dataElement( SaveBaseData( data, filenameHint, error ) ); // returns a reference to a file
-            if (error)
-            {
-              m_FailedNodes->push_back( node );
-            }
-
-            // store basedata properties
-            PropertyList* propertyList = data->GetPropertyList();
-            if (propertyList && !propertyList->IsEmpty() )
-            {
-              TiXmlElement* baseDataPropertiesElement( SavePropertyList( propertyList, filenameHint + "-data") ); // returns a reference to a file
-              dataElement->LinkEndChild( baseDataPropertiesElement );
-            }
-
-            nodeElement->LinkEndChild( dataElement );
+            TiXmlElement* baseDataPropertiesElement( SavePropertyList( propertyList, filenameHint + "-data", nodeDirectory ) ); // returns a reference to a file
+            dataElement->LinkEndChild( baseDataPropertiesElement );
           }
+          propertiesSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - dataSaved).count();
 
-          // store all renderwindow specific propertylists
-          mitk::DataNode::PropertyListKeyNames propertyListKeys = node->GetPropertyListNames();
-          for (auto renderWindowName : propertyListKeys)
-          {
-            PropertyList* propertyList = node->GetPropertyList(renderWindowName);
-            if ( propertyList && !propertyList->IsEmpty() )
-            {
-              TiXmlElement* renderWindowPropertiesElement( SavePropertyList( propertyList, filenameHint + "-" + renderWindowName) ); // returns a reference to a file
-              renderWindowPropertiesElement->SetAttribute("renderwindow", renderWindowName);
-              nodeElement->LinkEndChild( renderWindowPropertiesElement );
-            }
-          }
+          nodeElement->LinkEndChild( dataElement );
+        }
+
+        auto start = std::chrono::steady_clock::now();
 
-          // don't forget the renderwindow independent list
-          PropertyList* propertyList = node->GetPropertyList();
+        // store all renderwindow specific propertylists
+        mitk::DataNode::PropertyListKeyNames propertyListKeys = node->GetPropertyListNames();
+        for (auto renderWindowName : propertyListKeys)
+        {
+          PropertyList* propertyList = node->GetPropertyList(renderWindowName);
           if ( propertyList && !propertyList->IsEmpty() )
           {
-            TiXmlElement* propertiesElement( SavePropertyList( propertyList, filenameHint + "-node") ); // returns a reference to a file
-            nodeElement->LinkEndChild( propertiesElement );
+            TiXmlElement* renderWindowPropertiesElement( SavePropertyList( propertyList, filenameHint + "-" + renderWindowName, nodeDirectory ) ); // returns a reference to a file
+            renderWindowPropertiesElement->SetAttribute("renderwindow", renderWindowName);
+            nodeElement->LinkEndChild( renderWindowPropertiesElement );
           }
-          document.LinkEndChild( nodeElement );
-        }
-        else
-        {
-          MITK_WARN << "Ignoring NULL node during scene serialization.";
         }
 
-        ProgressBar::GetInstance()->Progress();
-      } // end for all nodes
-    } // end if sceneNodes
-
-    if ( !document.SaveFile( m_WorkingDirectory + Poco::Path::separator() + "index.xml" ) )
-    {
-      MITK_ERROR << "Could not write scene to " << m_WorkingDirectory << Poco::Path::separator() << "index.xml" << "\nTinyXML reports '" << document.ErrorDesc() << "'";
-      return false;
-    }
-    else
-    {
-      try
-      {
-        Poco::File deleteFile( filename.c_str() );
-        if (deleteFile.exists())
+        // don't forget the renderwindow independent list
+        PropertyList* propertyList = node->GetPropertyList();
+        if ( propertyList && !propertyList->IsEmpty() )
         {
-          deleteFile.remove();
+          TiXmlElement* propertiesElement( SavePropertyList( propertyList, filenameHint + "-node", nodeDirectory ) ); // returns a reference to a file
+          nodeElement->LinkEndChild( propertiesElement );
         }
+        propertiesSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        timing.m_PropertiesSeconds = propertiesSeconds;
 
-        // create zip at filename
-        std::ofstream file( filename.c_str(), std::ios::binary | std::ios::out);
-        if (!file.good())
         {
-          MITK_ERROR << "Could not open a zip file for writing: '" << filename << "'";
-          return false;
+          std::lock_guard<std::mutex> lock( zipperMutex );
+          MoveFilesToArchive( nodeDirectory, zipper );
         }
-        else
+        Poco::File( nodeDirectory ).remove(true);
+
+        nodeElements[i] = nodeElement.release();
+      });
+
+      // the document keeps the order of the nodes
+      for (std::size_t i = 0; i < nodes.size(); ++i)
+      {
+        if ( nodeElements[i] )
         {
-          Poco::Zip::Compress zipper( file, true );
-          Poco::Path tmpdir( m_WorkingDirectory );
-          zipper.addRecursive( tmpdir );
-          zipper.close();
+          if ( nodeErrors[i] )
+          {
+            m_FailedNodes->push_back( nodes[i] );
+          }
+          document.LinkEndChild( nodeElements[i] );
         }
-        try
+        else if ( nodes[i] )
         {
-          Poco::File deleteDir( m_WorkingDirectory );
-          deleteDir.remove(true); // recursive
+          MITK_ERROR << "Could not serialize node '" << nodes[i]->GetName() << "'";
+          m_FailedNodes->push_back( nodes[i] );
         }
-        catch(...)
+        else
         {
-          MITK_ERROR << "Could not delete temporary directory " << m_WorkingDirectory;
-          return false; // ok?
+          MITK_WARN << "Ignoring NULL node during scene serialization.";
         }
-      }
-      catch(std::exception& e)
+
+        ProgressBar::GetInstance()->Progress();
+      } // end for all nodes
+
+      if ( !tasksSucceeded )
       {
-        MITK_ERROR << "Could not create ZIP file from " << m_WorkingDirectory << "\nReason: " << e.what();
-        return false;
+        success = false;
       }
-      return true;
+    } // end if sceneNodes
+
+    // index.xml is written directly from memory
+    TiXmlPrinter printer;
+    document.Accept( &printer );
+    std::istringstream index( printer.CStr() );
+    zipper.addFile( index, Poco::DateTime(), Poco::Path( "index.xml", Poco::Path::PATH_UNIX ) );
+    zipper.close();
+    file.close();
+    if (file.fail())
+    {
+      MITK_ERROR << "Could not write zip file '" << temporaryFilename << "'";
+      removeTemporaryFiles();
+      return false;
+    }
+
+    // replaces an existing file
+    Poco::File( temporaryFilename ).renameTo( filename );
+    temporaryFilename.clear();
+
+    try
+    {
+      Poco::File deleteDir( m_WorkingDirectory );
+      deleteDir.remove(true); // recursive
     }
+    catch(...)
+    {
+      MITK_ERROR << "Could not delete temporary directory " << m_WorkingDirectory;
+      return false; // ok?
+    }
+    return success;
   }
   catch(std::exception& e)
   {
-    MITK_ERROR << "Caught exception during saving temporary files to disk. Error description: '" << e.what() << "'";
+    MITK_ERROR << "Caught exception during saving scene to " << filename << ". Error description: '" << e.what() << "'";
+    removeTemporaryFiles();
     return false;
   }
 }
 
-TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& filenamehint, bool& error )
+TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& filenamehint, const std::string& workingDirectory, bool& error )
 {
   assert(data);
   error = true;
@@ -454,7 +550,7 @@ TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& fi
     {
       serializer->SetData(data);
       serializer->SetFilenameHint(filenamehint);
-      serializer->SetWorkingDirectory( m_WorkingDirectory );
+      serializer->SetWorkingDirectory( workingDirectory );
       try
       {
         std::string writtenfilename = serializer->Serialize();
@@ -472,7 +568,7 @@ TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& fi
   return element;
 }
 
-TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const std::string& filenamehint)
+TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const std::string& filenamehint, const std::string& workingDirectory )
 {
   assert(propertyList);
 
@@ -484,7 +580,7 @@ TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const
 
   serializer->SetPropertyList(propertyList);
   serializer->SetFilenameHint(filenamehint);
-  serializer->SetWorkingDirectory( m_WorkingDirectory );
+  serializer->SetWorkingDirectory( workingDirectory );
   try
   {
     std::string writtenfilename = serializer->Serialize();
@@ -492,7 +588,8 @@ TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const
     PropertyList::Pointer failedProperties = serializer->GetFailedProperties();
     if (failedProperties.IsNotNull())
     {
-      // move failed properties to global list
+      // move failed properties to global list, lists of several nodes are saved concurrently
+      std::lock_guard<std::mutex> lock( m_FailedPropertiesMutex );
       m_FailedProperties->ConcatenatePropertyList( failedProperties, true );
     }
   }
@@ -514,13 +611,7 @@ const mitk::PropertyList* mitk::SceneIO::GetFailedProperties()
   return m_FailedProperties;
 }
 
-void mitk::SceneIO::OnUnzipError(const void*  /*pSender*/, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string>& info)
-{
-  ++m_UnzipErrors;
-  MITK_ERROR << "Error while unzipping: " << info.second;
-}
-
-void mitk::SceneIO::OnUnzipOk(const void*  /*pSender*/, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path>& /*info*/)
+const mitk::SceneNodeTimingList& mitk::SceneIO::GetNodeTimings() const
 {
-  // MITK_INFO << "Unzipped ok: " << info.second.toString();
+  return m_NodeTimings;
 }
@@ -16,6 +16,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkSceneReader.h"
 
+mitk::SceneReader::SceneReader()
+  : m_NumberOfThreads(0)
+{
+}
+
 bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage )
 {
   // find version node --> note version in some variable
@@ -48,7 +53,11 @@ bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& w
   {
     if (SceneReader* reader = dynamic_cast<SceneReader*>( iter->GetPointer() ) )
     {
-      if ( !reader->LoadScene( document, workingDirectory, storage ) )
+      reader->SetArchive( m_Archive );
+      reader->SetNumberOfThreads( m_NumberOfThreads );
+      bool success = reader->LoadScene( document, workingDirectory, storage );
+      m_NodeTimings = reader->GetNodeTimings();
+      if ( !success )
       {
         MITK_ERROR << "There were errors while loading scene file " << workingDirectory + "/index.xml. Your data may be corrupted";
         return false;
@@ -61,3 +70,23 @@ bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& w
   }
   return false;
 }
+
+const mitk::SceneNodeTimingList& mitk::SceneReader::GetNodeTimings() const
+{
+  return m_NodeTimings;
+}
+
+bool mitk::SceneReader::PrepareFile( const std::string& filename, const std::string& workingDirectory, std::vector<std::string>& extractedFiles )
+{
+  if ( m_Archive.IsNull() )
+  {
+    return true;
+  }
+
+  return m_Archive->ExtractFile( filename, workingDirectory, extractedFiles );
+}
+
+void mitk::SceneReader::ReleaseFiles( std::vector<std::string>& extractedFiles )
+{
+  SceneArchive::RemoveFiles( extractedFiles );
+}
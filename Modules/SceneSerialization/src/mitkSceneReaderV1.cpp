@@ -20,9 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkPropertyListDeserializer.h"
 #include "mitkProgressBar.h"
 #include "mitkIOUtil.h"
+#include "mitkSceneTasks.h"
 #include "Poco/Path.h"
 #include <mitkRenderingModeProperty.h>
 
+#include <chrono>
+#include <set>
+
 MITK_REGISTER_SERIALIZER(SceneReaderV1)
 
 namespace
@@ -62,7 +66,9 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
 
   // TODO prepare to detect errors (such as cycles) from wrongly written or edited xml files
 
-  //Get number of elements to initialze progress bar
+  // Every <node> element references its own files only, so the data and property lists
+  // of all nodes are read concurrently. Parent relations and the insertion into the
+  // DataStorage are resolved afterwards for all nodes together.
   //   1. if there is a <data type="..." file="..."> element,
     //        - construct a name for the appropriate serializer
     //        - try to instantiate this serializer via itk object factory
@@ -71,27 +77,29 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
 
     // create a node for the tag "data" and test if node was created
   typedef std::vector<mitk::DataNode::Pointer> DataNodeVector;
-  DataNodeVector DataNodes;
-  unsigned int listSize = 0;
+  std::vector<TiXmlElement*> nodeElements;
   for( TiXmlElement* element = document.FirstChildElement("node"); element != NULL; element = element->NextSiblingElement("node") )
   {
-    ++listSize;
+    nodeElements.push_back(element);
   }
+  const std::size_t listSize = nodeElements.size();
 
-  ProgressBar::GetInstance()->AddStepsToDo(listSize * 2);
+  ProgressBar::GetInstance()->AddStepsToDo(static_cast<unsigned int>(listSize * 2));
 
-  for (TiXmlElement* element = document.FirstChildElement("node"); element != NULL; element = element->NextSiblingElement("node"))
-  {
-      DataNodes.push_back(LoadBaseDataFromDataTag(element->FirstChildElement("data"), workingDirectory, error));
-      ProgressBar::GetInstance()->Progress();
-  }
+  DataNodeVector DataNodes(listSize);
+  std::vector<char> nodeErrors(listSize, 0); // not std::vector<bool>, which is not safe for concurrent writes
+  m_NodeTimings.assign(listSize, SceneNodeTiming());
 
-  // iterate all nodes
-  // first level nodes should be <node> elements
-  DataNodeVector::iterator nit = DataNodes.begin();
-  for( TiXmlElement* element = document.FirstChildElement("node"); element != NULL || nit != DataNodes.end(); element = element->NextSiblingElement("node"), ++nit )
+  bool tasksSucceeded = RunSceneTasks(listSize, m_NumberOfThreads, [&](std::size_t i)
   {
-    mitk::DataNode::Pointer node = *nit;
+    TiXmlElement* element = nodeElements[i];
+    SceneNodeTiming& timing = m_NodeTimings[i];
+    bool nodeError(false);
+
+    auto start = std::chrono::steady_clock::now();
+    mitk::DataNode::Pointer node = LoadBaseDataFromDataTag(element->FirstChildElement("data"), workingDirectory, nodeError);
+    auto dataLoaded = std::chrono::steady_clock::now();
+
     // in case dataXmlElement is valid test whether it containts the "properties" child tag
     // and process further if and only if yes
     TiXmlElement *dataXmlElement = element->FirstChildElement("data");
@@ -108,6 +116,44 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
       }
     }
 
+    //   3. if there are <properties> nodes,
+    //        - instantiate the appropriate PropertyListDeSerializer
+    //        - use them to construct PropertyList objects
+    //        - add these properties to the node (if necessary, use renderwindow name)
+    bool success = DecorateNodeWithProperties(node, element, workingDirectory);
+    if (!success)
+    {
+      MITK_ERROR << "Could not load properties for node.";
+      nodeError = true;
+    }
+    auto propertiesLoaded = std::chrono::steady_clock::now();
+
+    const char* uida = element->Attribute("UID");
+    timing.m_UID = uida ? uida : "";
+    timing.m_Name = node->GetName();
+    timing.m_DataSeconds = std::chrono::duration<double>(dataLoaded - start).count();
+    timing.m_PropertiesSeconds = std::chrono::duration<double>(propertiesLoaded - dataLoaded).count();
+
+    DataNodes[i] = node;
+    nodeErrors[i] = nodeError;
+  });
+  error |= !tasksSucceeded;
+
+  ProgressBar::GetInstance()->Progress(static_cast<unsigned int>(listSize));
+
+  // iterate all nodes
+  // first level nodes should be <node> elements
+  for (std::size_t i = 0; i < listSize; ++i)
+  {
+    TiXmlElement* element = nodeElements[i];
+    mitk::DataNode::Pointer node = DataNodes[i];
+    if (node.IsNull())
+    {
+      // the task of this node failed with an exception, keep an empty node like for missing data
+      node = DataNode::New();
+    }
+    error |= (nodeErrors[i] != 0);
+
     //   2. check child nodes
     const char* uida = element->Attribute("UID");
     std::string uid("");
@@ -124,17 +170,6 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
       error = true;
     }
 
-    //   3. if there are <properties> nodes,
-    //        - instantiate the appropriate PropertyListDeSerializer
-    //        - use them to construct PropertyList objects
-    //        - add these properties to the node (if necessary, use renderwindow name)
-    bool success = DecorateNodeWithProperties(node, element, workingDirectory);
-    if (!success)
-    {
-      MITK_ERROR << "Could not load properties for node.";
-      error = true;
-    }
-
     // remember node for later adding to DataStorage
     m_OrderedNodePairs.push_back( std::make_pair( node, std::list<std::string>() ) );
 
@@ -176,64 +211,79 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
     }
   }
 
-  // repeat the following loop ...
-  //   ... for all created nodes
-  unsigned int lastMapSize(0);
-  while ( lastMapSize != m_OrderedNodePairs.size()) // this is to prevent infinite loops; each iteration must at least add one node to DataStorage
+  // insert all nodes with one batch, so observers of the storage are notified once. Until the
+  // batch is committed Exists() does not know the new nodes, so remember them for the parents check
+  std::set<const DataNode*> addedNodes;
+  storage->BeginBatch();
+  try
   {
-    lastMapSize = m_OrderedNodePairs.size();
-
-    // iterate (layer) ordered nodes backwards
-    // we insert the highest layers first
-    for (OrderedNodesList::iterator nodesIter = m_OrderedNodePairs.begin();
-         nodesIter != m_OrderedNodePairs.end();
-         ++nodesIter)
+    // repeat the following loop ...
+    //   ... for all created nodes
+    unsigned int lastMapSize(0);
+    while ( lastMapSize != m_OrderedNodePairs.size()) // this is to prevent infinite loops; each iteration must at least add one node to DataStorage
     {
-      bool addThisNode(true);
+      lastMapSize = m_OrderedNodePairs.size();
 
-      // if any parent node is not yet in DataStorage, skip node for now and check later
-      for (std::list<std::string>::iterator parentsIter = nodesIter->second.begin();
-           parentsIter != nodesIter->second.end();
-           ++parentsIter)
+      // iterate (layer) ordered nodes backwards
+      // we insert the highest layers first
+      for (OrderedNodesList::iterator nodesIter = m_OrderedNodePairs.begin();
+           nodesIter != m_OrderedNodePairs.end();
+           ++nodesIter)
       {
-        if ( !storage->Exists( m_NodeForID[ *parentsIter ] ) )
+        bool addThisNode(true);
+
+        // if any parent node is not yet in DataStorage, skip node for now and check later
+        for (std::list<std::string>::iterator parentsIter = nodesIter->second.begin();
+             parentsIter != nodesIter->second.end();
+             ++parentsIter)
         {
-          addThisNode = false;
-          break;
+          DataNode* parent = m_NodeForID[ *parentsIter ];
+          if ( addedNodes.find( parent ) == addedNodes.end() && !storage->Exists( parent ) )
+          {
+            addThisNode = false;
+            break;
+          }
         }
-      }
 
-      if (addThisNode)
-      {
-        DataStorage::SetOfObjects::Pointer parents = DataStorage::SetOfObjects::New();
-        for ( std::list<std::string>::iterator parentsIter = nodesIter->second.begin();
-              parentsIter != nodesIter->second.end();
-              ++parentsIter )
+        if (addThisNode)
         {
-           parents->push_back(m_NodeForID[*parentsIter]);
+          DataStorage::SetOfObjects::Pointer parents = DataStorage::SetOfObjects::New();
+          for ( std::list<std::string>::iterator parentsIter = nodesIter->second.begin();
+                parentsIter != nodesIter->second.end();
+                ++parentsIter )
+          {
+             parents->push_back(m_NodeForID[*parentsIter]);
+          }
+
+          // if all parents are found in datastorage (or are unknown), add node to DataStorage
+          storage->Add(nodesIter->first, parents);
+          addedNodes.insert(nodesIter->first.GetPointer());
+
+          // remove this node from m_OrderedNodePairs
+          m_OrderedNodePairs.erase( nodesIter );
+
+          // break this for loop because iterators are probably invalid
+          break;
         }
-
-        // if all parents are found in datastorage (or are unknown), add node to DataStorage
-        storage->Add(nodesIter->first, parents);
-
-        // remove this node from m_OrderedNodePairs
-        m_OrderedNodePairs.erase( nodesIter );
-
-        // break this for loop because iterators are probably invalid
-        break;
       }
     }
-  }
 
-  // All nodes that are still in m_OrderedNodePairs at this point are not part of a proper directed graph structure. We'll add such nodes without any parent information.
-  for (OrderedNodesList::iterator nodesIter = m_OrderedNodePairs.begin();
-       nodesIter != m_OrderedNodePairs.end();
-       ++nodesIter)
+    // All nodes that are still in m_OrderedNodePairs at this point are not part of a proper directed graph structure. We'll add such nodes without any parent information.
+    for (OrderedNodesList::iterator nodesIter = m_OrderedNodePairs.begin();
+         nodesIter != m_OrderedNodePairs.end();
+         ++nodesIter)
+    {
+      storage->Add( nodesIter->first );
+      MITK_WARN << "Encountered node that is not part of a directed graph structure. Will be added to DataStorage without parents.";
+      error = true;
+    }
+  }
+  catch (...)
   {
-    storage->Add( nodesIter->first );
-    MITK_WARN << "Encountered node that is not part of a directed graph structure. Will be added to DataStorage without parents.";
-    error = true;
+    storage->CommitBatch();
+    throw;
   }
+  storage->CommitBatch();
 
   return !error;
 }
@@ -247,8 +297,10 @@ mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlEleme
     const char* filename = dataElement->Attribute("file");
     if ( filename )
     {
+      std::vector<std::string> extractedFiles;
       try
       {
+        this->PrepareFile( filename, workingDirectory, extractedFiles );
         std::vector<BaseData::Pointer> baseData = IOUtil::Load( workingDirectory + Poco::Path::separator() + filename );
         if (baseData.size() > 1)
         {
@@ -262,6 +314,7 @@ mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlEleme
         MITK_ERROR << "Error during attempt to read '" << filename << "'. Exception says: " << e.what();
         error = true;
       }
+      ReleaseFiles( extractedFiles );
 
       if (node.IsNull())
       {
@@ -332,8 +385,11 @@ bool mitk::SceneReaderV1::DecorateNodeWithProperties(DataNode* node, TiXmlElemen
     // use deserializer to construct new properties
     PropertyListDeserializer::Pointer deserializer = PropertyListDeserializer::New();
 
+    std::vector<std::string> extractedFiles;
+    this->PrepareFile(propertiesfile, workingDirectory, extractedFiles);
     deserializer->SetFilename(workingDirectory + Poco::Path::separator() + propertiesfile);
     bool success = deserializer->Deserialize();
+    ReleaseFiles(extractedFiles);
     error |= !success;
     PropertyList::Pointer readProperties = deserializer->GetOutput();
 
@@ -367,8 +423,11 @@ bool mitk::SceneReaderV1::DecorateBaseDataWithProperties(BaseData::Pointer data,
     PropertyListDeserializer::Pointer propertyDeserializer = PropertyListDeserializer::New();
 
     // initialize the property reader
+    std::vector<std::string> extractedFiles;
+    this->PrepareFile(baseDataPropertyFile, workingDir, extractedFiles);
     propertyDeserializer->SetFilename(workingDir + Poco::Path::separator() + baseDataPropertyFile);
     bool ioSuccess = propertyDeserializer->Deserialize();
+    ReleaseFiles(extractedFiles);
     error = !ioSuccess;
 
     // get the output
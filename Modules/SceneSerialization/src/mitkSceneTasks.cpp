@@ -0,0 +1,83 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSceneTasks.h"
+
+#include <mitkLogMacros.h>
+
+#include <itkMultiThreader.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+  struct SceneTaskList
+  {
+    const std::function<void(std::size_t)>* m_Task;
+    std::size_t m_NumberOfTasks;
+    std::atomic<std::size_t> m_NextTask;
+    std::atomic<bool> m_Success;
+  };
+
+  ITK_THREAD_RETURN_TYPE RunSceneTasksCallback( void* arg )
+  {
+    typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ThreadInfoType* infoStruct = static_cast<ThreadInfoType*>( arg );
+    SceneTaskList* tasks = static_cast<SceneTaskList*>( infoStruct->UserData );
+
+    for (std::size_t task = tasks->m_NextTask++; task < tasks->m_NumberOfTasks; task = tasks->m_NextTask++)
+    {
+      try
+      {
+        (*tasks->m_Task)( task );
+      }
+      catch (std::exception& e)
+      {
+        MITK_ERROR << "Caught exception while processing node " << task << " of the scene: " << e.what();
+        tasks->m_Success = false;
+      }
+      catch (...)
+      {
+        MITK_ERROR << "Caught unknown exception while processing node " << task << " of the scene";
+        tasks->m_Success = false;
+      }
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+}
+
+bool mitk::RunSceneTasks( std::size_t numberOfTasks, unsigned int numberOfThreads, const std::function<void(std::size_t)>& task )
+{
+  if (numberOfTasks == 0)
+    return true;
+
+  SceneTaskList tasks;
+  tasks.m_Task = &task;
+  tasks.m_NumberOfTasks = numberOfTasks;
+  tasks.m_NextTask = 0;
+  tasks.m_Success = true;
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  if (numberOfThreads > 0)
+    threader->SetNumberOfThreads( numberOfThreads );
+  if (static_cast<std::size_t>( threader->GetNumberOfThreads() ) > numberOfTasks)
+    threader->SetNumberOfThreads( static_cast<itk::ThreadIdType>( numberOfTasks ) );
+  threader->SetSingleMethod( RunSceneTasksCallback, &tasks );
+  threader->SingleMethodExecute();
+
+  return tasks.m_Success;
+}
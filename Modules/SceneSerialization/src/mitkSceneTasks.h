@@ -0,0 +1,38 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkSceneTasks_h_included
+#define mitkSceneTasks_h_included
+
+#include <cstddef>
+#include <functional>
+
+namespace mitk
+{
+
+/**
+ * \brief Runs task(0) to task(numberOfTasks - 1) on the threads of an itk::MultiThreader.
+ *
+ * Used to read and write the nodes of a scene concurrently. Tasks report their errors
+ * themselves; exceptions escaping a task are logged and make the function return false.
+ *
+ * \param numberOfThreads number of threads, 0 uses the default of itk::MultiThreader
+ */
+bool RunSceneTasks( std::size_t numberOfTasks, unsigned int numberOfThreads, const std::function<void(std::size_t)>& task );
+
+}
+
+#endif
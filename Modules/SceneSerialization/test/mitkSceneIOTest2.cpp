@@ -20,8 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkIOUtil.h"
 #include "mitkSceneIO.h"
+#include "mitkSceneArchive.h"
 #include "mitkSceneIOTestScenarioProvider.h"
 #include "mitkDataStorageCompare.h"
+#include "mitkStandaloneDataStorage.h"
+
+#include <Poco/File.h>
+#include <Poco/Path.h>
 
 /**
   \brief Test cases for SceneIO.
@@ -81,10 +86,22 @@ class mitkSceneIOTest2Suite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkSceneIOTest2Suite);
   MITK_TEST(Test_SceneIOInterfaces);
   MITK_TEST(Test_ReconstructionOfScenes);
+  MITK_TEST(Test_SceneArchiveExtractsSingleFiles);
+  MITK_TEST(Test_ConcurrentNodesMatchSequentialNodes);
+  MITK_TEST(Test_LoadSceneAddsNodesWithOneBatchEvent);
   CPPUNIT_TEST_SUITE_END();
 
   mitk::SceneIOTestScenarioProvider m_TestCaseProvider;
 
+  unsigned int m_AddNodesEvents;
+  unsigned int m_AddedNodes;
+
+  void OnNodesAdded(const mitk::DataStorage::SetOfObjects* nodes)
+  {
+    ++m_AddNodesEvents;
+    m_AddedNodes += nodes->Size();
+  }
+
 public:
 
   void Test_SceneIOInterfaces()
@@ -134,6 +151,115 @@ public:
     }
   }
 
+  void Test_SceneArchiveExtractsSingleFiles()
+  {
+    std::string tempDir = mitk::IOUtil::CreateTemporaryDirectory("SceneIOTest_XXXXXX");
+
+    mitk::SceneIOTestScenarioProvider::ScenarioList scenarios = m_TestCaseProvider.GetAllScenarios();
+    for (auto scenario : scenarios)
+    {
+      if (!scenario.serializable)
+        continue;
+
+      std::string archiveFilename = mitk::IOUtil::CreateTemporaryFile("scene_XXXXXX.mitk", tempDir);
+      mitk::SceneIO::Pointer writer = mitk::SceneIO::New();
+      mitk::DataStorage::Pointer originalStorage = scenario.BuildDataStorage();
+      CPPUNIT_ASSERT(writer->SaveScene(originalStorage->GetAll(), originalStorage, archiveFilename));
+
+      mitk::SceneArchive::Pointer archive = mitk::SceneArchive::New();
+      CPPUNIT_ASSERT_MESSAGE("Open scene archive", archive->Open(archiveFilename));
+      CPPUNIT_ASSERT_MESSAGE("Scene contains index.xml", archive->HasFile("index.xml"));
+
+      std::string index;
+      CPPUNIT_ASSERT_MESSAGE("Read index.xml into memory", archive->ReadFile("index.xml", index));
+      CPPUNIT_ASSERT_MESSAGE("index.xml is not empty", index.find("<Version") != std::string::npos);
+
+      std::string extractDir = mitk::IOUtil::CreateTemporaryDirectory("SceneArchiveTest_XXXXXX", tempDir);
+      for (auto name : archive->GetFileNames())
+      {
+        std::string extractedFilename = extractDir + Poco::Path::separator() + name;
+        CPPUNIT_ASSERT_MESSAGE(std::string("Extract ") + name, archive->ExtractFile(name, extractDir));
+        CPPUNIT_ASSERT_MESSAGE(std::string("Extracted ") + name, Poco::File(extractedFilename).exists());
+        archive->RemoveExtractedFiles();
+        CPPUNIT_ASSERT_MESSAGE(std::string("Removed ") + name, !Poco::File(extractedFilename).exists());
+      }
+      archive->Close();
+      break; // one scenario is enough to test the archive access
+    }
+  }
+
+  void Test_ConcurrentNodesMatchSequentialNodes()
+  {
+    std::string tempDir = mitk::IOUtil::CreateTemporaryDirectory("SceneIOTest_XXXXXX");
+
+    mitk::SceneIOTestScenarioProvider::ScenarioList scenarios = m_TestCaseProvider.GetAllScenarios();
+    for (auto scenario : scenarios)
+    {
+      if (!scenario.serializable)
+        continue;
+
+      MITK_TEST_OUTPUT(<< "\n===== Test_ConcurrentNodesMatchSequentialNodes, scenario '" << scenario.key << "' =====");
+
+      mitk::DataStorage::Pointer originalStorage = scenario.BuildDataStorage();
+      mitk::DataStorage::SetOfObjects::ConstPointer nodes = originalStorage->GetAll();
+
+      std::string concurrentFilename = mitk::IOUtil::CreateTemporaryFile("scene_XXXXXX.mitk", tempDir);
+      mitk::SceneIO::Pointer concurrentWriter = mitk::SceneIO::New();
+      concurrentWriter->SetNumberOfThreads(4);
+      CPPUNIT_ASSERT(concurrentWriter->SaveScene(nodes, originalStorage, concurrentFilename));
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("One timing per saved node", static_cast<std::size_t>(nodes->size()), concurrentWriter->GetNodeTimings().size());
+
+      mitk::SceneIO::Pointer sequentialReader = mitk::SceneIO::New();
+      sequentialReader->SetNumberOfThreads(1);
+      mitk::DataStorage::Pointer sequentialStorage = sequentialReader->LoadScene(concurrentFilename);
+
+      mitk::SceneIO::Pointer concurrentReader = mitk::SceneIO::New();
+      concurrentReader->SetNumberOfThreads(4);
+      mitk::DataStorage::Pointer concurrentStorage = concurrentReader->LoadScene(concurrentFilename);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("One timing per loaded node", static_cast<std::size_t>(nodes->size()), concurrentReader->GetNodeTimings().size());
+
+      const mitk::DataStorageCompare::Tests flags = mitk::DataStorageCompare::CMP_Hierarchy |
+                                                    mitk::DataStorageCompare::CMP_Data |
+                                                    mitk::DataStorageCompare::CMP_Properties;
+      CPPUNIT_ASSERT_MESSAGE(std::string("Concurrently restored scenario '") + scenario.key + "'",
+          mitk::DataStorageCompare(originalStorage, concurrentStorage, flags, scenario.comparisonPrecision).CompareVerbose());
+      CPPUNIT_ASSERT_MESSAGE(std::string("Sequentially restored scenario '") + scenario.key + "'",
+          mitk::DataStorageCompare(sequentialStorage, concurrentStorage, flags, scenario.comparisonPrecision).CompareVerbose());
+    }
+  }
+
+  void Test_LoadSceneAddsNodesWithOneBatchEvent()
+  {
+    std::string tempDir = mitk::IOUtil::CreateTemporaryDirectory("SceneIOTest_XXXXXX");
+
+    mitk::SceneIOTestScenarioProvider::ScenarioList scenarios = m_TestCaseProvider.GetAllScenarios();
+    for (auto scenario : scenarios)
+    {
+      if (!scenario.serializable)
+        continue;
+
+      mitk::DataStorage::Pointer originalStorage = scenario.BuildDataStorage();
+      mitk::DataStorage::SetOfObjects::ConstPointer nodes = originalStorage->GetAll();
+      if (nodes->empty())
+        continue;
+
+      std::string sceneFilename = mitk::IOUtil::CreateTemporaryFile("scene_XXXXXX.mitk", tempDir);
+      mitk::SceneIO::Pointer writer = mitk::SceneIO::New();
+      CPPUNIT_ASSERT(writer->SaveScene(nodes, originalStorage, sceneFilename));
+
+      mitk::DataStorage::Pointer restoredStorage = mitk::StandaloneDataStorage::New().GetPointer();
+      m_AddNodesEvents = 0;
+      m_AddedNodes = 0;
+      restoredStorage->AddNodesEvent.AddListener(mitk::MessageDelegate1<mitkSceneIOTest2Suite, const mitk::DataStorage::SetOfObjects*>(this, &mitkSceneIOTest2Suite::OnNodesAdded));
+
+      mitk::SceneIO::Pointer reader = mitk::SceneIO::New();
+      reader->LoadScene(sceneFilename, restoredStorage);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE(std::string("Batch events for scenario '") + scenario.key + "'", 1u, m_AddNodesEvents);
+      CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(nodes->size()), m_AddedNodes);
+      CPPUNIT_ASSERT(mitk::DataStorageCompare(originalStorage, restoredStorage, mitk::DataStorageCompare::CMP_Hierarchy, scenario.comparisonPrecision).CompareVerbose());
+    }
+  }
+
 }; // class
 
 int mitkSceneIOTest2(int /*argc*/, char* /*argv*/[])
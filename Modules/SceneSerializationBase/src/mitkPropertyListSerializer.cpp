@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkStandardFileLocations.h"
 #include <itksys/SystemTools.hxx>
 
+#include <atomic>
+
 mitk::PropertyListSerializer::PropertyListSerializer()
 : m_FilenameHint("unnamed")
 , m_WorkingDirectory("")
@@ -43,8 +45,8 @@ std::string mitk::PropertyListSerializer::Serialize()
     return "";
   }
 
-  // tmpname
-  static unsigned long count = 1;
+  // tmpname, lists may be serialized concurrently
+  static std::atomic<unsigned long> count(1);
   unsigned long n = count++;
   std::ostringstream name;
   for (int i = 0; i < 6; ++i)
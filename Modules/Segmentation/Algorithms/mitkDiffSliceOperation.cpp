@@ -16,10 +16,30 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDiffSliceOperation.h"
 
+#include <mitkExtractSliceFilter.h>
 #include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkVtkImageOverwrite.h>
 
 #include <itkCommand.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+  typedef unsigned int RunLengthType;
+
+  void AppendRun( std::vector<unsigned char>& runs, RunLengthType runLength, const unsigned char* pixel, std::size_t bytesPerPixel )
+  {
+    const unsigned char* runLengthBytes = reinterpret_cast<const unsigned char*>( &runLength );
+    runs.insert( runs.end(), runLengthBytes, runLengthBytes + sizeof(RunLengthType) );
+    runs.insert( runs.end(), pixel, pixel + bytesPerPixel );
+  }
+}
+
 mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
 {
   m_TimeStep = 0;
@@ -28,6 +48,11 @@ mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
   m_WorldGeometry = nullptr;
   m_SliceGeometry = nullptr;
   m_ImageIsValid = false;
+  m_SliceSize[0] = m_SliceSize[1] = 0;
+  m_DiffIndex[0] = m_DiffIndex[1] = 0;
+  m_DiffSize[0] = m_DiffSize[1] = 0;
+  m_BytesPerPixel = 0;
+  m_DiffIsRunLengthEncoded = false;
 }
 
 
@@ -36,10 +61,35 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
                                              SlicedGeometry3D* sliceGeometry,
                                              unsigned int timestep,
                                              BaseGeometry* currentWorldGeometry):Operation(1)
+{
+  this->Initialize(imageVolume, sliceGeometry, timestep, currentWorldGeometry);
+
+  m_zlibSliceContainer = CompressedImageContainer::New();
+  m_zlibSliceContainer->SetImage( slice );
+}
 
+mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
+                                             Image *slice,
+                                             Image *referenceSlice,
+                                             SlicedGeometry3D* sliceGeometry,
+                                             unsigned int timestep,
+                                             BaseGeometry* currentWorldGeometry):Operation(1)
 {
-  m_WorldGeometry = currentWorldGeometry->Clone();
+  this->Initialize(imageVolume, sliceGeometry, timestep, currentWorldGeometry);
 
+  if ( !this->StoreDifference( slice, referenceSlice ) )
+  {
+    m_zlibSliceContainer = CompressedImageContainer::New();
+    m_zlibSliceContainer->SetImage( slice );
+  }
+}
+
+void mitk::DiffSliceOperation::Initialize(mitk::Image* imageVolume,
+                                          SlicedGeometry3D* sliceGeometry,
+                                          unsigned int timestep,
+                                          BaseGeometry* currentWorldGeometry)
+{
+  m_WorldGeometry = currentWorldGeometry->Clone();
   /*
   Quick fix for bug 12338.
   Guard object - fix this when clone method of PlaneGeometry is cloning the reference geometry (see bug 13392)*/
@@ -51,8 +101,11 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
 
   m_TimeStep = timestep;
 
-  m_zlibSliceContainer = CompressedImageContainer::New();
-  m_zlibSliceContainer->SetImage( slice );
+  m_SliceSize[0] = m_SliceSize[1] = 0;
+  m_DiffIndex[0] = m_DiffIndex[1] = 0;
+  m_DiffSize[0] = m_DiffSize[1] = 0;
+  m_BytesPerPixel = 0;
+  m_DiffIsRunLengthEncoded = false;
 
   m_Image = imageVolume;
 
@@ -63,12 +116,115 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
     //get the id of the observer, used to remove it later on
     m_DeleteObserverTag = imageVolume->AddObserver( itk::DeleteEvent(), command );
 
-
     m_ImageIsValid = true;
   }
   else
     m_ImageIsValid = false;
+}
 
+bool mitk::DiffSliceOperation::StoreDifference(mitk::Image* slice, mitk::Image* referenceSlice)
+{
+  if ( !slice || !referenceSlice
+       || slice->GetPixelType() != referenceSlice->GetPixelType()
+       || slice->GetDimension(0) != referenceSlice->GetDimension(0)
+       || slice->GetDimension(1) != referenceSlice->GetDimension(1)
+       || ( slice->GetDimension() > 2 && slice->GetDimension(2) != 1 )
+       || ( referenceSlice->GetDimension() > 2 && referenceSlice->GetDimension(2) != 1 ) )
+  {
+    return false;
+  }
+
+  m_SliceSize[0] = slice->GetDimension(0);
+  m_SliceSize[1] = slice->GetDimension(1);
+  m_BytesPerPixel = slice->GetPixelType().GetSize();
+
+  ImageReadAccessor sliceAccessor(slice, slice->GetSliceData(0));
+  ImageReadAccessor referenceAccessor(referenceSlice, referenceSlice->GetSliceData(0));
+  const unsigned char* sliceData = static_cast<const unsigned char*>(sliceAccessor.GetData());
+  const unsigned char* referenceData = static_cast<const unsigned char*>(referenceAccessor.GetData());
+
+  // bounding box of the changed pixels
+  unsigned int minIndex[2] = { m_SliceSize[0], m_SliceSize[1] };
+  unsigned int maxIndex[2] = { 0, 0 };
+  const std::size_t bytesPerRow = m_SliceSize[0] * m_BytesPerPixel;
+  for ( unsigned int y = 0; y < m_SliceSize[1]; ++y )
+  {
+    const unsigned char* row = sliceData + y * bytesPerRow;
+    const unsigned char* referenceRow = referenceData + y * bytesPerRow;
+    if ( std::memcmp( row, referenceRow, bytesPerRow ) == 0 )
+      continue;
+
+    for ( unsigned int x = 0; x < m_SliceSize[0]; ++x )
+    {
+      if ( std::memcmp( row + x * m_BytesPerPixel, referenceRow + x * m_BytesPerPixel, m_BytesPerPixel ) != 0 )
+      {
+        minIndex[0] = std::min( minIndex[0], x );
+        maxIndex[0] = std::max( maxIndex[0], x );
+      }
+    }
+    minIndex[1] = std::min( minIndex[1], y );
+    maxIndex[1] = y;
+  }
+
+  m_DiffData.clear();
+  m_DiffIsRunLengthEncoded = false;
+  if ( minIndex[1] > maxIndex[1] )
+  {
+    // nothing changed
+    m_DiffIndex[0] = m_DiffIndex[1] = 0;
+    m_DiffSize[0] = m_DiffSize[1] = 0;
+    return true;
+  }
+
+  for ( unsigned int i = 0; i < 2; ++i )
+  {
+    m_DiffIndex[i] = minIndex[i];
+    m_DiffSize[i] = maxIndex[i] - minIndex[i] + 1;
+  }
+
+  // run-length encoding pays off for label images, otherwise keep the plain pixels
+  std::vector<unsigned char> runs;
+  const std::size_t plainSize = m_DiffSize[0] * m_DiffSize[1] * m_BytesPerPixel;
+  const unsigned char* currentPixel = nullptr;
+  RunLengthType runLength = 0;
+  for ( unsigned int y = m_DiffIndex[1]; y < m_DiffIndex[1] + m_DiffSize[1] && runs.size() < plainSize; ++y )
+  {
+    for ( unsigned int x = m_DiffIndex[0]; x < m_DiffIndex[0] + m_DiffSize[0]; ++x )
+    {
+      const unsigned char* pixel = sliceData + ( y * m_SliceSize[0] + x ) * m_BytesPerPixel;
+      if ( currentPixel && runLength < std::numeric_limits<RunLengthType>::max()
+           && std::memcmp( pixel, currentPixel, m_BytesPerPixel ) == 0 )
+      {
+        ++runLength;
+        continue;
+      }
+      if ( currentPixel )
+        AppendRun( runs, runLength, currentPixel, m_BytesPerPixel );
+      currentPixel = pixel;
+      runLength = 1;
+    }
+  }
+  AppendRun( runs, runLength, currentPixel, m_BytesPerPixel );
+
+  if ( runs.size() < plainSize )
+  {
+    m_DiffData.swap( runs );
+    m_DiffIsRunLengthEncoded = true;
+  }
+  else
+  {
+    m_DiffData.resize( plainSize );
+    const std::size_t bytesPerBoxRow = m_DiffSize[0] * m_BytesPerPixel;
+    for ( unsigned int y = 0; y < m_DiffSize[1]; ++y )
+    {
+      std::memcpy( &m_DiffData[y * bytesPerBoxRow],
+                   sliceData + ( ( m_DiffIndex[1] + y ) * m_SliceSize[0] + m_DiffIndex[0] ) * m_BytesPerPixel,
+                   bytesPerBoxRow );
+    }
+  }
+
+  m_DiffData.shrink_to_fit();
+  return true;
 }
 
 mitk::DiffSliceOperation::~DiffSliceOperation()
@@ -86,13 +242,95 @@ mitk::DiffSliceOperation::~DiffSliceOperation()
 
 mitk::Image::Pointer mitk::DiffSliceOperation::GetSlice()
 {
-  Image::Pointer image = m_zlibSliceContainer->GetImage();
-  return image;
+  if ( m_zlibSliceContainer.IsNotNull() )
+  {
+    Image::Pointer image = m_zlibSliceContainer->GetImage();
+    return image;
+  }
+
+  Image::Pointer slice = this->ExtractCurrentSlice();
+  if ( slice.IsNull() || slice->GetPixelType().GetSize() != m_BytesPerPixel
+       || slice->GetDimension(0) != m_SliceSize[0] || slice->GetDimension(1) != m_SliceSize[1] )
+  {
+    MITK_WARN << "Slice of the volume does not match the stored difference, cannot restore slice.";
+    return nullptr;
+  }
+
+  ImageWriteAccessor sliceAccessor(slice, slice->GetSliceData(0));
+  unsigned char* sliceData = static_cast<unsigned char*>(sliceAccessor.GetData());
+  const std::size_t bytesPerBoxRow = m_DiffSize[0] * m_BytesPerPixel;
+
+  if ( !m_DiffIsRunLengthEncoded )
+  {
+    for ( unsigned int y = 0; y < m_DiffSize[1]; ++y )
+    {
+      std::memcpy( sliceData + ( ( m_DiffIndex[1] + y ) * m_SliceSize[0] + m_DiffIndex[0] ) * m_BytesPerPixel,
+                   &m_DiffData[y * bytesPerBoxRow],
+                   bytesPerBoxRow );
+    }
+    return slice;
+  }
+
+  unsigned int x = 0;
+  unsigned int y = 0;
+  for ( std::size_t position = 0; position < m_DiffData.size(); position += sizeof(RunLengthType) + m_BytesPerPixel )
+  {
+    RunLengthType runLength;
+    std::memcpy( &runLength, &m_DiffData[position], sizeof(RunLengthType) );
+    const unsigned char* pixel = &m_DiffData[position + sizeof(RunLengthType)];
+
+    for ( ; runLength > 0; --runLength )
+    {
+      std::memcpy( sliceData + ( ( m_DiffIndex[1] + y ) * m_SliceSize[0] + m_DiffIndex[0] + x ) * m_BytesPerPixel,
+                   pixel, m_BytesPerPixel );
+      if ( ++x == m_DiffSize[0] )
+      {
+        x = 0;
+        ++y;
+      }
+    }
+  }
+
+  return slice;
+}
+
+mitk::Image::Pointer mitk::DiffSliceOperation::ExtractCurrentSlice()
+{
+  PlaneGeometry* plane = dynamic_cast<PlaneGeometry*>(m_WorldGeometry.GetPointer());
+  if ( !m_ImageIsValid || !plane )
+    return nullptr;
+
+  //use the same reslicer that is used for overwriting
+  vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
+  reslice->SetOverwriteMode(false);
+  reslice->Modified();
+
+  mitk::ExtractSliceFilter::Pointer extractor =  mitk::ExtractSliceFilter::New(reslice);
+  extractor->SetInput( m_Image );
+  extractor->SetTimeStep( m_TimeStep );
+  extractor->SetWorldGeometry( plane );
+  extractor->SetVtkOutputRequest(false);
+  extractor->SetResliceTransformByGeometry( m_Image->GetTimeGeometry()->GetGeometryForTimeStep( m_TimeStep ) );
+
+  extractor->Modified();
+  extractor->Update();
+
+  Image::Pointer slice = extractor->GetOutput();
+  slice->DisconnectPipeline();
+  return slice;
+}
+
+std::size_t mitk::DiffSliceOperation::GetMemorySize() const
+{
+  std::size_t memorySize = sizeof(*this) + m_DiffData.capacity();
+  if ( m_zlibSliceContainer.IsNotNull() )
+    memorySize += m_zlibSliceContainer->GetMemorySize();
+  return memorySize;
 }
 
 bool mitk::DiffSliceOperation::IsValid()
 {
-  return m_ImageIsValid && m_zlibSliceContainer.IsNotNull() && (m_WorldGeometry.IsNotNull());//TODO improve
+  return m_ImageIsValid && (m_zlibSliceContainer.IsNotNull() || m_BytesPerPixel > 0) && (m_WorldGeometry.IsNotNull());//TODO improve
 }
 
 void mitk::DiffSliceOperation::OnImageDeleted()
@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <vtkSmartPointer.h>
 
+#include <vector>
+
 
 namespace mitk
 {
@@ -40,6 +42,11 @@ class Image;
      currentWorldGeometry   specifies the axis where the slice has to be applied in the volume.
 
     This Operation can be used to realize undo-redo functionality for e.g. segmentation purposes.
+
+    If a reference slice is given, only the bounding box of the pixels that differ from the
+    reference slice is stored (run-length encoded if this is smaller). GetSlice() then extracts
+    the current slice from the volume and replaces the pixels of this box. Otherwise, the whole
+    slice is kept in a CompressedImageContainer.
   */
   class MITKSEGMENTATION_EXPORT DiffSliceOperation : public Operation
   {
@@ -61,6 +68,13 @@ class Image;
     /** \brief */
     DiffSliceOperation( mitk::Image* imageVolume, mitk::Image* slice, SlicedGeometry3D* sliceGeometry, unsigned int timestep, BaseGeometry* currentWorldGeometry);
 
+    /** \brief Only stores the pixels of slice that differ from referenceSlice.
+      Usually, referenceSlice is the content of the volume when the operation is executed, i.e.
+      the modified slice for an undo operation and the original slice for a redo operation. If the
+      slices do not match in size and pixel type, the whole slice is stored.
+    */
+    DiffSliceOperation( mitk::Image* imageVolume, mitk::Image* slice, mitk::Image* referenceSlice, SlicedGeometry3D* sliceGeometry, unsigned int timestep, BaseGeometry* currentWorldGeometry);
+
     /** \brief Check if it is a valid operation.*/
     bool IsValid();
 
@@ -71,9 +85,15 @@ class Image;
 
     /** \brief Set thee slice to be applied.*/
     void SetImage(vtkImageData* slice){ this->m_Slice = slice;}
-    /** \brief Get the slice that is applied in the operation.*/
+    /** \brief Get the slice that is applied in the operation. NULL if it cannot be restored.*/
     Image::Pointer GetSlice();
 
+    /** \brief True if only the difference to a reference slice is stored.*/
+    bool IsDifferenceOnly() const { return m_zlibSliceContainer.IsNull(); }
+
+    /** \brief Memory of the stored pixels.*/
+    virtual std::size_t GetMemorySize() const override;
+
     /** \brief Get timeStep.*/
     void SetTimeStep(unsigned int timestep){this->m_TimeStep = timestep;}
     /** \brief Set timeStep*/
@@ -96,8 +116,27 @@ class Image;
     /** \brief Callback for image observer.*/
     void OnImageDeleted();
 
+    void Initialize( mitk::Image* imageVolume, SlicedGeometry3D* sliceGeometry, unsigned int timestep, BaseGeometry* currentWorldGeometry);
+
+    /** \brief Stores the pixels of slice in the bounding box of the differences to referenceSlice, false if the slices do not match.*/
+    bool StoreDifference( mitk::Image* slice, mitk::Image* referenceSlice );
+
+    /** \brief Extracts the current slice from the volume.*/
+    Image::Pointer ExtractCurrentSlice();
+
+    /** \brief Full slice, only used if there is no reference slice */
     CompressedImageContainer::Pointer m_zlibSliceContainer;
 
+    /** \brief Size of the slice, index and size of the box of changed pixels (x, y) */
+    unsigned int m_SliceSize[2];
+    unsigned int m_DiffIndex[2];
+    unsigned int m_DiffSize[2];
+    std::size_t m_BytesPerPixel;
+    /** \brief Pixels of the box in row order, as runs of (count, pixel) if m_DiffIsRunLengthEncoded */
+    std::vector<unsigned char> m_DiffData;
+    bool m_DiffIsRunLengthEncoded;
+
+
     mitk::Image* m_Image;
 
     vtkSmartPointer<vtkImageData> m_Slice;
@@ -49,6 +49,8 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation( Operation* operation )
     vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
 
     mitk::Image::Pointer slice = imageOperation->GetSlice();
+    if (slice.IsNull())
+      return;
     //Set the slice as 'input'
     reslice->SetInputSlice(const_cast<vtkImageData*>(slice->GetVtkImageData()));
 
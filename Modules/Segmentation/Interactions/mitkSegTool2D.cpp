@@ -336,9 +336,8 @@ void mitk::SegTool2D::WriteSliceToVolume(mitk::SegTool2D::SliceInformation slice
   Image* image = dynamic_cast<Image*>(workingNode->GetData());
 
   /*============= BEGIN undo/redo feature block ========================*/
-  // Create undo operation by caching the not yet modified slices
+  // Keep the not yet modified slice, the undo operation only stores its difference to the modified one
   mitk::Image::Pointer originalSlice = GetAffectedImageSliceAs2DImage(sliceInfo.plane, image, sliceInfo.timestep);
-  DiffSliceOperation* undoOperation = new DiffSliceOperation(const_cast<mitk::Image*>(image), originalSlice, dynamic_cast<SlicedGeometry3D*>(originalSlice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
   /*============= END undo/redo feature block ========================*/
 
   //Make sure that for reslicing and overwriting the same alogrithm is used. We can specify the mode of the vtk reslicer
@@ -366,8 +365,10 @@ void mitk::SegTool2D::WriteSliceToVolume(mitk::SegTool2D::SliceInformation slice
   image->GetVtkImageData()->Modified();
 
   /*============= BEGIN undo/redo feature block ========================*/
-  //specify the undo operation with the edited slice
-  DiffSliceOperation* doOperation = new DiffSliceOperation(image, extractor->GetOutput(),dynamic_cast<SlicedGeometry3D*>(sliceInfo.slice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
+  //specify the undo and redo operations by the pixels that differ between the original and the edited slice
+  mitk::Image::Pointer modifiedSlice = extractor->GetOutput();
+  DiffSliceOperation* undoOperation = new DiffSliceOperation(image, originalSlice, modifiedSlice, dynamic_cast<SlicedGeometry3D*>(originalSlice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
+  DiffSliceOperation* doOperation = new DiffSliceOperation(image, modifiedSlice, originalSlice, dynamic_cast<SlicedGeometry3D*>(sliceInfo.slice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
 
   //create an operation event for the undo stack
   OperationEvent* undoStackItem = new OperationEvent( DiffSliceOperationApplier::GetInstance(), doOperation, undoOperation, "Segmentation" );
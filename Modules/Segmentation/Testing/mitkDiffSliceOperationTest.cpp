@@ -0,0 +1,135 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkDiffSliceOperation.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkImageCast.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkVtkImageOverwrite.h>
+#include <mitkTestingMacros.h>
+
+#include <itkImage.h>
+
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+
+namespace
+{
+  mitk::Image::Pointer ExtractSlice(mitk::Image* volume, mitk::PlaneGeometry* plane)
+  {
+    vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
+    reslice->SetOverwriteMode(false);
+    mitk::ExtractSliceFilter::Pointer extractor = mitk::ExtractSliceFilter::New(reslice);
+    extractor->SetInput(volume);
+    extractor->SetTimeStep(0);
+    extractor->SetWorldGeometry(plane);
+    extractor->SetVtkOutputRequest(false);
+    extractor->SetResliceTransformByGeometry(volume->GetTimeGeometry()->GetGeometryForTimeStep(0));
+    extractor->Update();
+
+    mitk::Image::Pointer slice = extractor->GetOutput();
+    slice->DisconnectPipeline();
+    return slice;
+  }
+
+  bool HaveEqualPixels(mitk::Image* image1, mitk::Image* image2)
+  {
+    if (image1->GetDimension(0) != image2->GetDimension(0) || image1->GetDimension(1) != image2->GetDimension(1))
+      return false;
+
+    mitk::ImageReadAccessor accessor1(image1, image1->GetSliceData(0));
+    mitk::ImageReadAccessor accessor2(image2, image2->GetSliceData(0));
+    return std::memcmp(accessor1.GetData(), accessor2.GetData(),
+                       image1->GetDimension(0) * image1->GetDimension(1) * image1->GetPixelType().GetSize()) == 0;
+  }
+}
+
+/**
+  \brief Verify that DiffSliceOperation restores slices from the stored differences.
+*/
+int mitkDiffSliceOperationTest(int, char* [])
+{
+  MITK_TEST_BEGIN("mitkDiffSliceOperationTest")
+
+  typedef itk::Image<unsigned char, 3> ImageType;
+  const unsigned int volumeSize = 64;
+
+  ImageType::Pointer itkVolume = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(volumeSize);
+  ImageType::RegionType region;
+  region.SetSize(size);
+  itkVolume->SetRegions(region);
+  itkVolume->Allocate();
+  itkVolume->FillBuffer(0);
+
+  mitk::Image::Pointer volume;
+  mitk::CastToMitkImage(itkVolume, volume);
+
+  mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+  plane->InitializeStandardPlane(volume->GetGeometry(), mitk::PlaneGeometry::Axial, 20, true, false);
+  mitk::Point3D origin = plane->GetOrigin();
+  mitk::Vector3D normal = plane->GetNormal();
+  normal.Normalize();
+  origin += normal * 0.5;
+  plane->SetOrigin(origin);
+
+  mitk::Image::Pointer originalSlice = ExtractSlice(volume, plane);
+  MITK_TEST_CONDITION_REQUIRED(originalSlice->GetDimension(0) == volumeSize && originalSlice->GetDimension(1) == volumeSize, "Extracted slice has the size of the volume");
+
+  // paint a small square into a copy of the slice
+  mitk::Image::Pointer modifiedSlice = originalSlice->Clone();
+  {
+    mitk::ImageWriteAccessor accessor(modifiedSlice, modifiedSlice->GetSliceData(0));
+    unsigned char* pixels = static_cast<unsigned char*>(accessor.GetData());
+    for (unsigned int y = 10; y < 14; ++y)
+      for (unsigned int x = 30; x < 35; ++x)
+        pixels[y * volumeSize + x] = 1;
+  }
+
+  mitk::SlicedGeometry3D* sliceGeometry = dynamic_cast<mitk::SlicedGeometry3D*>(originalSlice->GetGeometry());
+
+  mitk::DiffSliceOperation* doOperation = new mitk::DiffSliceOperation(volume, modifiedSlice, originalSlice, sliceGeometry, 0, plane);
+  MITK_TEST_CONDITION_REQUIRED(doOperation->IsValid(), "Operation with difference is valid");
+  MITK_TEST_CONDITION(doOperation->IsDifferenceOnly(), "Only the difference is stored");
+  MITK_TEST_CONDITION(doOperation->GetMemorySize() < volumeSize * volumeSize, "Difference needs less memory than the slice");
+
+  mitk::Image::Pointer restoredSlice = doOperation->GetSlice();
+  MITK_TEST_CONDITION_REQUIRED(restoredSlice.IsNotNull(), "Slice restored");
+  MITK_TEST_CONDITION(HaveEqualPixels(restoredSlice, modifiedSlice), "Restored slice equals the modified slice");
+
+  mitk::DiffSliceOperation* noChangeOperation = new mitk::DiffSliceOperation(volume, originalSlice, originalSlice, sliceGeometry, 0, plane);
+  restoredSlice = noChangeOperation->GetSlice();
+  MITK_TEST_CONDITION(restoredSlice.IsNotNull() && HaveEqualPixels(restoredSlice, originalSlice), "Operation without difference restores the current slice");
+
+  // slices that do not match are stored completely
+  mitk::Image::Pointer croppedSlice = mitk::Image::New();
+  unsigned int croppedDimensions[2] = { volumeSize / 2, volumeSize };
+  croppedSlice->Initialize(originalSlice->GetPixelType(), 2, croppedDimensions);
+  mitk::DiffSliceOperation* fullOperation = new mitk::DiffSliceOperation(volume, modifiedSlice, croppedSlice, sliceGeometry, 0, plane);
+  MITK_TEST_CONDITION(fullOperation->IsValid() && !fullOperation->IsDifferenceOnly(), "Whole slice is stored if the reference slice does not match");
+  restoredSlice = fullOperation->GetSlice();
+  MITK_TEST_CONDITION(restoredSlice.IsNotNull() && HaveEqualPixels(restoredSlice, modifiedSlice), "Whole slice restored");
+
+  // the destructor is protected, operations are usually deleted by OperationEvent
+  delete static_cast<mitk::Operation*>(doOperation);
+  delete static_cast<mitk::Operation*>(noChangeOperation);
+  delete static_cast<mitk::Operation*>(fullOperation);
+
+  MITK_TEST_END()
+}
@@ -20,6 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
 #include <mitkComputeContourSetNormalsFilter.h>
+#include <mitkImageCast.h>
+
+#include <itkImageRegionConstIterator.h>
 
 #include <vtkDebugLeaks.h>
 
@@ -29,6 +32,7 @@ class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixtu
   vtkDebugLeaks::SetExitError(0);
   MITK_TEST(TestCreateDistanceImageForLiver);
   MITK_TEST(TestCreateDistanceImageForTube);
+  MITK_TEST(TestCompactSupportSolverForLiver);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -132,6 +136,78 @@ public:
     CPPUNIT_ASSERT_MESSAGE("HolesDistanceImages are not equal!", mitk::Equal(*(holesDistanceImageReference), *(holeDistanceImage), 0.0001, true));
   }
 
+  // The compact support solver has to produce the same inside/outside decision as the dense solver
+  void TestCompactSupportSolverForLiver()
+  {
+    unsigned int NUMBER_OF_LIVER_CONTOURS = 18;
+
+    for (unsigned int i = 0; i <= NUMBER_OF_LIVER_CONTOURS; ++i)
+    {
+      std::stringstream s;
+      s << "SurfaceInterpolation/InterpolateLiver/LiverContourWithNormals_";
+      s << i;
+      s << ".vtk";
+      mitk::Surface::Pointer contour = mitk::IOUtil::LoadSurface(GetTestDataFilePath(s.str()));
+      contourList.push_back(contour);
+    }
+
+    mitk::Image::Pointer segmentationImage = mitk::IOUtil::LoadImage(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverSegmentation.nrrd"));
+    itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+    AccessFixedDimensionByItk_1( segmentationImage, GetImageBase, 3, itkImage );
+
+    mitk::ComputeContourSetNormalsFilter::Pointer normalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+    for (unsigned int j = 0; j < contourList.size(); j++)
+    {
+      normalsFilter->SetInput(j, contourList.at(j));
+    }
+    normalsFilter->Update();
+
+    mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType::Pointer distanceImages[2];
+    mitk::CreateDistanceImageFromSurfaceFilter::SolverType solvers[2] = {
+      mitk::CreateDistanceImageFromSurfaceFilter::DenseSolver, mitk::CreateDistanceImageFromSurfaceFilter::CompactSupportSolver };
+
+    for (unsigned int s = 0; s < 2; ++s)
+    {
+      mitk::CreateDistanceImageFromSurfaceFilter::Pointer interpolateSurfaceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+      interpolateSurfaceFilter->SetReferenceImage( itkImage.GetPointer() );
+      interpolateSurfaceFilter->SetSolver( solvers[s] );
+      for (unsigned int j = 0; j < contourList.size(); j++)
+      {
+        interpolateSurfaceFilter->SetInput(j, normalsFilter->GetOutput(j));
+      }
+      interpolateSurfaceFilter->Update();
+
+      MITK_INFO << "Solver " << solvers[s] << ": solving took " << interpolateSurfaceFilter->GetSolveTime()
+                << "s, evaluation took " << interpolateSurfaceFilter->GetEvaluationTime() << "s";
+
+      mitk::Image::Pointer distanceImage = interpolateSurfaceFilter->GetOutput();
+      CPPUNIT_ASSERT(distanceImage.IsNotNull());
+      mitk::CastToItkImage(distanceImage, distanceImages[s]);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Distance images have different sizes!",
+      distanceImages[0]->GetLargestPossibleRegion() == distanceImages[1]->GetLargestPossibleRegion());
+
+    typedef itk::ImageRegionConstIterator<mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType> IteratorType;
+    IteratorType denseIter(distanceImages[0], distanceImages[0]->GetLargestPossibleRegion());
+    IteratorType compactIter(distanceImages[1], distanceImages[1]->GetLargestPossibleRegion());
+
+    unsigned int insideVoxels = 0;
+    unsigned int differentVoxels = 0;
+    for (; !denseIter.IsAtEnd(); ++denseIter, ++compactIter)
+    {
+      const bool denseInside = denseIter.Get() < 0;
+      const bool compactInside = compactIter.Get() < 0;
+      if (denseInside)
+        ++insideVoxels;
+      if (denseInside != compactInside)
+        ++differentVoxels;
+    }
+
+    CPPUNIT_ASSERT(insideVoxels > 0);
+    CPPUNIT_ASSERT_MESSAGE("Interpolated shapes differ too much!", differentVoxels < insideVoxels / 20);
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkCreateDistanceImageFromSurfaceFilter)
@@ -23,6 +23,25 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImageTimeSelector.h"
 #include "mitkImagePixelWriteAccessor.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkProgressBarImplementation.h"
+
+#include <cstring>
+
+// Aborts the interpolation as soon as it reports progress
+class AbortingProgressBarImplementation : public mitk::ProgressBarImplementation
+{
+public:
+  AbortingProgressBarImplementation(mitk::SurfaceInterpolationController* controller) : m_Controller(controller) {}
+
+  void SetPercentageVisible(bool) override {}
+  void Reset() override {}
+  void AddStepsToDo(unsigned int) override {}
+  void Progress(unsigned int) override { m_Controller->AbortInterpolation(); }
+
+private:
+  mitk::SurfaceInterpolationController* m_Controller;
+};
 
 class mitkSurfaceInterpolationControllerTestSuite : public mitk::TestFixture
 {
@@ -46,6 +65,7 @@ class mitkSurfaceInterpolationControllerTestSuite : public mitk::TestFixture
 
   MITK_TEST(TestAddNewContour);
   MITK_TEST(TestRemoveContour);
+  MITK_TEST(TestInterpolate);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -522,6 +542,104 @@ public:
     return true;
   }
 
+  mitk::Surface::Pointer createAxialContour(double z, double radius)
+  {
+    double center[3] = {15.0, 15.0, z};
+    double normal[3] = {0.0, 0.0, 1.0};
+    vtkSmartPointer<vtkRegularPolygonSource> p_source = vtkSmartPointer<vtkRegularPolygonSource>::New();
+    p_source->SetNumberOfSides(40);
+    p_source->SetCenter(center);
+    p_source->SetRadius(radius);
+    p_source->SetNormal(normal);
+    p_source->GeneratePolylineOff();
+    p_source->Update();
+    mitk::Surface::Pointer surface = mitk::Surface::New();
+    surface->SetVtkPolyData(p_source->GetOutput());
+    return surface;
+  }
+
+  void TestInterpolate()
+  {
+    // Create an empty segmentation image
+    unsigned int dimensions[] = {30, 30, 30};
+    mitk::Image::Pointer segmentation = createImage(dimensions);
+    {
+      mitk::ImageWriteAccessor accessor(segmentation);
+      std::memset(accessor.GetData(), 0, dimensions[0] * dimensions[1] * dimensions[2]);
+    }
+    m_Controller->SetCurrentInterpolationSession(segmentation);
+    m_Controller->SetMinSpacing(1.0);
+    m_Controller->SetMaxSpacing(1.0);
+    m_Controller->SetDistanceImageVolume(50000);
+
+    std::vector<mitk::Surface::Pointer> contours;
+    contours.push_back(createAxialContour(5.0, 8.0));
+    contours.push_back(createAxialContour(15.0, 8.0));
+    contours.push_back(createAxialContour(25.0, 8.0));
+    m_Controller->AddNewContours(contours);
+
+    m_Controller->Interpolate();
+    mitk::Surface::Pointer firstResult = m_Controller->GetInterpolationResult();
+    CPPUNIT_ASSERT_MESSAGE("No interpolation result!", firstResult.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Empty interpolation result!", firstResult->GetVtkPolyData()->GetNumberOfPoints() > 0);
+    CPPUNIT_ASSERT_MESSAGE("Not all contours reduced!", m_Controller->GetNumberOfRecentlyReducedContours() == 3);
+
+    // Without changes all contours are taken from the cache
+    m_Controller->Interpolate();
+    CPPUNIT_ASSERT_MESSAGE("No interpolation result!", m_Controller->GetInterpolationResult().IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Cached contours reduced again!", m_Controller->GetNumberOfRecentlyReducedContours() == 0);
+
+    // Replace one contour, the other ones are not reduced again
+    m_Controller->AddNewContour(createAxialContour(15.0, 10.0));
+    CPPUNIT_ASSERT_MESSAGE("Wrong number of contours!", m_Controller->GetNumberOfContours() == 3);
+
+    m_Controller->Interpolate();
+    mitk::Surface::Pointer secondResult = m_Controller->GetInterpolationResult();
+    CPPUNIT_ASSERT_MESSAGE("No interpolation result!", secondResult.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Interpolation result not updated!", secondResult.GetPointer() != firstResult.GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Only the replaced contour should be reduced!", m_Controller->GetNumberOfRecentlyReducedContours() == 1);
+
+    // An interpolation aborted while the replaced contour is preprocessed keeps the previous result
+    AbortingProgressBarImplementation abortingProgressBar(m_Controller);
+    mitk::ProgressBar::GetInstance()->RegisterImplementationInstance(&abortingProgressBar);
+    m_Controller->AddNewContour(createAxialContour(25.0, 6.0));
+    m_Controller->Interpolate();
+    mitk::ProgressBar::GetInstance()->UnregisterImplementationInstance(&abortingProgressBar);
+    CPPUNIT_ASSERT_MESSAGE("Aborted interpolation changed the result!", m_Controller->GetInterpolationResult().GetPointer() == secondResult.GetPointer());
+
+    // The contour preprocessed before the abort is cached
+    m_Controller->Interpolate();
+    mitk::Surface::Pointer thirdResult = m_Controller->GetInterpolationResult();
+    CPPUNIT_ASSERT_MESSAGE("No interpolation result!", thirdResult.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Interpolation result not updated!", thirdResult.GetPointer() != secondResult.GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Cached contours reduced again!", m_Controller->GetNumberOfRecentlyReducedContours() == 0);
+
+    // The needed memory can be estimated as soon as a session with contours is selected
+    mitk::Image::Pointer otherSegmentation = createImage(dimensions);
+    m_Controller->SetCurrentInterpolationSession(otherSegmentation);
+    CPPUNIT_ASSERT_MESSAGE("Memory estimated for an empty session!", m_Controller->EstimatePortionOfNeededMemory() == 0.0);
+    m_Controller->SetCurrentInterpolationSession(segmentation);
+    CPPUNIT_ASSERT_MESSAGE("Memory not estimated for the session!", m_Controller->EstimatePortionOfNeededMemory() > 0.0);
+    m_Controller->RemoveInterpolationSession(otherSegmentation);
+
+    // Removing contours until less than two are left resets the result
+    mitk::SurfaceInterpolationController::ContourPositionInformation contourInfo;
+    contourInfo.contourNormal[0] = 0.0;
+    contourInfo.contourNormal[1] = 0.0;
+    contourInfo.contourNormal[2] = 1.0;
+    contourInfo.contourPoint[0] = 15.0;
+    contourInfo.contourPoint[1] = 15.0;
+    contourInfo.contourPoint[2] = 5.0;
+    CPPUNIT_ASSERT_MESSAGE("Contour not removed!", m_Controller->RemoveContour(contourInfo));
+    contourInfo.contourPoint[2] = 25.0;
+    CPPUNIT_ASSERT_MESSAGE("Contour not removed!", m_Controller->RemoveContour(contourInfo));
+
+    m_Controller->Interpolate();
+    CPPUNIT_ASSERT_MESSAGE("Interpolation result not reset!", m_Controller->GetInterpolationResult().IsNull());
+
+    m_Controller->RemoveInterpolationSession(segmentation);
+  }
+
   void TestSetCurrentInterpolationSession4D()
   {
     /*unsigned int testDimensions[] = {10, 10, 10, 5};
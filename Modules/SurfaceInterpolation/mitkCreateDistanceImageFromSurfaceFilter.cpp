@@ -24,9 +24,24 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkPolyData.h"
 
 #include "itkImageRegionIteratorWithIndex.h"
-#include "itkNeighborhoodIterator.h"
+#include "itkTimeProbe.h"
 
-#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  /** Wendland's C2 function, positive definite in 3D, for q = r / supportRadius */
+  inline double WendlandFunction(double q)
+  {
+    if (q >= 1.0)
+      return 0.0;
+    const double t = 1.0 - q;
+    const double t2 = t * t;
+    return t2 * t2 * (4.0 * q + 1.0);
+  }
+}
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateEmptyDistanceImage()
 {
@@ -112,6 +127,12 @@ mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImageFromSurfaceFilter
   m_DistanceImageVolume = 50000;
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 5;
+  m_Solver = DenseSolver;
+  m_SupportRadius = 0.0;
+  m_UsedSupportRadius = 0.0;
+  m_DistanceOffset = 0.0;
+  m_SolveTime = 0.0;
+  m_EvaluationTime = 0.0;
 
   mitk::Image::Pointer output = mitk::Image::New();
   this->SetNthOutput(0, output.GetPointer());
@@ -127,25 +148,74 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
   this->PreprocessContourPoints();
   this->CreateEmptyDistanceImage();
 
+  itk::TimeProbe solveTimer;
+  solveTimer.Start();
+
   //First of all we have to build the equation-system from the existing contour-edge-points
   this->CreateSolutionMatrixAndFunctionValues();
 
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(1);
 
-  m_Weights = m_SolutionMatrix.partialPivLu().solve(m_FunctionValues);
+  this->SolveEquationSystem();
+
+  solveTimer.Stop();
+  m_SolveTime = solveTimer.GetTotal();
 
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(2);
 
+  itk::TimeProbe evaluationTimer;
+  evaluationTimer.Start();
+
   //The last step is to create the distance map with the interpolated distance function
-  this->FillDistanceImage();
+  //This is skipped if the update has been aborted in the meantime
+  if (!this->GetAbortGenerateData())
+  {
+    this->PrepareDistanceEvaluation();
+    this->FillDistanceImage();
+  }
+
+  evaluationTimer.Stop();
+  m_EvaluationTime = evaluationTimer.GetTotal();
 
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(2);
 
   m_Centers.clear();
   m_Normals.clear();
+  m_CenterInputIndices.clear();
+  m_SparseSolutionMatrix.resize(0, 0);
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    m_EvaluationCenters[dim].clear();
+  m_EvaluationWeights.clear();
+  m_GridCellStart.clear();
+  m_GridCenterIndices.clear();
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveEquationSystem()
+{
+  if (m_Solver == DenseSolver)
+  {
+    m_Weights = m_SolutionMatrix.partialPivLu().solve(m_FunctionValues);
+    return;
+  }
+
+  // the offset makes the distance function positive outside of the support of all centers
+  Eigen::VectorXd offsetFunctionValues = m_FunctionValues.array() - m_DistanceOffset;
+
+  Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > solver;
+  solver.compute(m_SparseSolutionMatrix);
+  if (solver.info() == Eigen::Success)
+  {
+    m_Weights = solver.solve(offsetFunctionValues);
+  }
+
+  if (solver.info() != Eigen::Success)
+  {
+    MITK_ERROR << "mitk::CreateDistanceImageFromSurfaceFilter: Sparse equation system could not be solved!" << std::endl;
+    itkExceptionMacro("mitk::CreateDistanceImageFromSurfaceFilter: Sparse equation system could not be solved!");
+  }
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
@@ -213,6 +283,8 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
           m_Normals.push_back(normal);
 
           m_Centers.push_back(currentPoint);
+
+          m_CenterInputIndices.push_back(i);
         }
 
       }//end for all points
@@ -266,26 +338,190 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   //Now we have created all centers and all function values. Next step is to create the solution matrix
   numberOfCenters = m_Centers.size();
 
-  m_SolutionMatrix.resize(numberOfCenters, numberOfCenters);
-
   m_Weights.resize(numberOfCenters);
 
-  PointType p1;
-  PointType p2;
-  double norm;
+  if (m_Solver == CompactSupportSolver)
+  {
+    m_SolutionMatrix.resize(0, 0);
+    this->CreateSparseSolutionMatrix();
+    return;
+  }
 
-  for (unsigned int i = 0; i < numberOfCenters; i++)
+  m_SolutionMatrix.resize(numberOfCenters, numberOfCenters);
+
+  const int numberOfRows = static_cast<int>(numberOfCenters);
+#pragma omp parallel for
+  for (int i = 0; i < numberOfRows; i++)
   {
     for (unsigned int j = 0; j < numberOfCenters; j++)
     {
       //Calculate the RBF value. Currently using Phi(r) = r with r is the euclidian distance between two points
-      p1 = m_Centers.at(i);
-      p2 = m_Centers.at(j);
-      p1 = p1 - p2;
-      norm = p1.two_norm();
-      m_SolutionMatrix(i,j) = norm;
+      m_SolutionMatrix(i,j) = (m_Centers[i] - m_Centers[j]).two_norm();
+    }
+  }
+}
+
+double mitk::CreateDistanceImageFromSurfaceFilter::DetermineSupportRadius() const
+{
+  if (m_SupportRadius > 0.0)
+    return m_SupportRadius;
+
+  // the support has to bridge the gaps between neighboring contours
+  const int numberOfSurfaceCenters = static_cast<int>(m_CenterInputIndices.size());
+  double largestGap = 0.0;
+
+#pragma omp parallel
+  {
+    double threadLargestGap = 0.0;
+#pragma omp for
+    for (int i = 0; i < numberOfSurfaceCenters; ++i)
+    {
+      double nearestSquaredDistance = std::numeric_limits<double>::max();
+      for (int j = 0; j < numberOfSurfaceCenters; ++j)
+      {
+        if (m_CenterInputIndices[i] != m_CenterInputIndices[j])
+          nearestSquaredDistance = std::min(nearestSquaredDistance, (m_Centers[i] - m_Centers[j]).squared_magnitude());
+      }
+      if (nearestSquaredDistance < std::numeric_limits<double>::max())
+        threadLargestGap = std::max(threadLargestGap, std::sqrt(nearestSquaredDistance));
+    }
+#pragma omp critical
+    largestGap = std::max(largestGap, threadLargestGap);
+  }
+
+  if (largestGap == 0.0)
+  {
+    // a single contour, use the extent of the centers
+    PointType minPoint = m_Centers.front();
+    PointType maxPoint = m_Centers.front();
+    for (auto centerIter = m_Centers.begin(); centerIter != m_Centers.end(); ++centerIter)
+    {
+      for (unsigned int dim = 0; dim < 3; ++dim)
+      {
+        minPoint[dim] = std::min(minPoint[dim], (*centerIter)[dim]);
+        maxPoint[dim] = std::max(maxPoint[dim], (*centerIter)[dim]);
+      }
+    }
+    largestGap = (maxPoint - minPoint).two_norm();
+  }
+
+  return std::max(1.5 * largestGap, 4.0 * m_DistanceImageSpacing);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateSparseSolutionMatrix()
+{
+  m_UsedSupportRadius = this->DetermineSupportRadius();
+  m_DistanceOffset = 3.0 * m_DistanceImageSpacing;
+
+  // sort the centers into the grid, so that only the neighboring cells have to be searched
+  this->BuildCenterGrid();
+
+  const unsigned int numberOfCenters = m_Centers.size();
+  std::vector< std::vector< Eigen::Triplet<double> > > rowEntries(numberOfCenters);
+
+  const int numberOfRows = static_cast<int>(numberOfCenters);
+#pragma omp parallel for
+  for (int i = 0; i < numberOfRows; ++i)
+  {
+    const PointType& center = m_Centers[i];
+    long cell[3];
+    for (unsigned int dim = 0; dim < 3; ++dim)
+      cell[dim] = static_cast<long>((center[dim] - m_GridOrigin[dim]) / m_UsedSupportRadius);
+
+    for (long z = std::max(cell[2] - 1, 0L); z <= std::min(cell[2] + 1, m_GridSize[2] - 1); ++z)
+      for (long y = std::max(cell[1] - 1, 0L); y <= std::min(cell[1] + 1, m_GridSize[1] - 1); ++y)
+        for (long x = std::max(cell[0] - 1, 0L); x <= std::min(cell[0] + 1, m_GridSize[0] - 1); ++x)
+        {
+          const long cellIndex = (z * m_GridSize[1] + y) * m_GridSize[0] + x;
+          for (unsigned int k = m_GridCellStart[cellIndex]; k < m_GridCellStart[cellIndex + 1]; ++k)
+          {
+            const unsigned int j = m_GridCenterIndices[k];
+            const double value = WendlandFunction((center - m_Centers[j]).two_norm() / m_UsedSupportRadius);
+            if (value > 0.0)
+              rowEntries[i].push_back(Eigen::Triplet<double>(i, j, value));
+          }
+        }
+  }
+
+  std::vector< Eigen::Triplet<double> > entries;
+  for (auto rowIter = rowEntries.begin(); rowIter != rowEntries.end(); ++rowIter)
+    entries.insert(entries.end(), rowIter->begin(), rowIter->end());
+
+  m_SparseSolutionMatrix.resize(numberOfCenters, numberOfCenters);
+  m_SparseSolutionMatrix.setFromTriplets(entries.begin(), entries.end());
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::BuildCenterGrid()
+{
+  const unsigned int numberOfCenters = m_Centers.size();
+
+  PointType minPoint = m_Centers.front();
+  PointType maxPoint = m_Centers.front();
+  for (auto centerIter = m_Centers.begin(); centerIter != m_Centers.end(); ++centerIter)
+  {
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      minPoint[dim] = std::min(minPoint[dim], (*centerIter)[dim]);
+      maxPoint[dim] = std::max(maxPoint[dim], (*centerIter)[dim]);
     }
   }
+
+  for (unsigned int dim = 0; dim < 3; ++dim)
+  {
+    m_GridOrigin[dim] = minPoint[dim];
+    m_GridSize[dim] = static_cast<long>((maxPoint[dim] - minPoint[dim]) / m_UsedSupportRadius) + 1;
+  }
+
+  // counting sort of the centers by their cell
+  std::vector<long> cellOfCenter(numberOfCenters);
+  m_GridCellStart.assign(m_GridSize[0] * m_GridSize[1] * m_GridSize[2] + 1, 0);
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+  {
+    long cell[3];
+    for (unsigned int dim = 0; dim < 3; ++dim)
+      cell[dim] = std::min(static_cast<long>((m_Centers[i][dim] - m_GridOrigin[dim]) / m_UsedSupportRadius), m_GridSize[dim] - 1);
+    cellOfCenter[i] = (cell[2] * m_GridSize[1] + cell[1]) * m_GridSize[0] + cell[0];
+    ++m_GridCellStart[cellOfCenter[i] + 1];
+  }
+  for (std::size_t cellIndex = 1; cellIndex < m_GridCellStart.size(); ++cellIndex)
+    m_GridCellStart[cellIndex] += m_GridCellStart[cellIndex - 1];
+
+  m_GridCenterIndices.resize(numberOfCenters);
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    m_EvaluationCenters[dim].resize(numberOfCenters);
+
+  std::vector<unsigned int> nextPosition(m_GridCellStart.begin(), m_GridCellStart.end() - 1);
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+  {
+    const unsigned int position = nextPosition[cellOfCenter[i]]++;
+    m_GridCenterIndices[position] = i;
+    for (unsigned int dim = 0; dim < 3; ++dim)
+      m_EvaluationCenters[dim][position] = m_Centers[i][dim];
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::PrepareDistanceEvaluation()
+{
+  const unsigned int numberOfCenters = m_Centers.size();
+  m_EvaluationWeights.resize(numberOfCenters);
+
+  if (m_Solver == CompactSupportSolver)
+  {
+    // the centers have already been sorted into the grid by CreateSparseSolutionMatrix()
+    for (unsigned int position = 0; position < numberOfCenters; ++position)
+      m_EvaluationWeights[position] = m_Weights[m_GridCenterIndices[position]];
+    return;
+  }
+
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    m_EvaluationCenters[dim].resize(numberOfCenters);
+
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+  {
+    for (unsigned int dim = 0; dim < 3; ++dim)
+      m_EvaluationCenters[dim][i] = m_Centers[i][dim];
+    m_EvaluationWeights[i] = m_Weights[i];
+  }
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
@@ -302,9 +538,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   */
 
   typedef itk::ImageRegionIteratorWithIndex<DistanceImageType> ImageIterator;
-  typedef itk::NeighborhoodIterator<DistanceImageType> NeighborhoodImageIterator;
 
-  std::queue<DistanceImageType::IndexType> narrowbandPoints;
   PointType currentPoint = m_Centers.at(0);
   double distance = this->CalculateDistanceValue(currentPoint);
 
@@ -320,47 +554,73 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
 
   assert( m_DistanceImageITK->GetLargestPossibleRegion().IsInside(currentIndex) ); // we are quite certain this should hold
 
-  narrowbandPoints.push(currentIndex);
   m_DistanceImageITK->SetPixel(currentIndex, distance);
 
-  NeighborhoodImageIterator::RadiusType radius;
-  radius.Fill(1);
-  NeighborhoodImageIterator nIt(radius, m_DistanceImageITK, m_DistanceImageITK->GetLargestPossibleRegion());
-  unsigned int relativeNbIdx[] = {4, 10, 12, 14, 16, 22};
+  /*
+  * The band is grown step by step: all not yet visited 6-neighbors of the pixels added in the previous step are
+  * collected first, then their distances are calculated in parallel. Each pixel is evaluated only once.
+  */
+  const DistanceImageType::RegionType region = m_DistanceImageITK->GetLargestPossibleRegion();
+  std::vector<bool> visited(region.GetNumberOfPixels(), false);
+  visited[m_DistanceImageITK->ComputeOffset(currentIndex)] = true;
 
-  bool isInBounds = false;
-  while ( !narrowbandPoints.empty() )
-  {
+  std::vector<DistanceImageType::IndexType> bandFront(1, currentIndex);
+  std::vector<DistanceImageType::IndexType> candidates;
+  std::vector<double> candidateDistances;
 
-    nIt.SetLocation(narrowbandPoints.front());
-    narrowbandPoints.pop();
+  while ( !bandFront.empty() )
+  {
+    if (this->GetAbortGenerateData())
+      return;
 
-    unsigned int* relativeNb = &relativeNbIdx[0];
-    for (int i = 0; i < 6; i++)
+    candidates.clear();
+    for (auto frontIter = bandFront.begin(); frontIter != bandFront.end(); ++frontIter)
     {
-      nIt.GetPixel(*relativeNb, isInBounds);
-      if( isInBounds && nIt.GetPixel(*relativeNb) == m_DistanceImageDefaultBufferValue)
+      for (unsigned int dim = 0; dim < 3; ++dim)
       {
-        currentIndex = nIt.GetIndex(*relativeNb);
+        for (int step = -1; step <= 1; step += 2)
+        {
+          DistanceImageType::IndexType neighbor = *frontIter;
+          neighbor[dim] += step;
+          if ( !region.IsInside(neighbor) )
+            continue;
+
+          const DistanceImageType::OffsetValueType offset = m_DistanceImageITK->ComputeOffset(neighbor);
+          if ( visited[offset] )
+            continue;
+          visited[offset] = true;
+
+          if ( m_DistanceImageITK->GetPixel(neighbor) == m_DistanceImageDefaultBufferValue )
+            candidates.push_back(neighbor);
+        }
+      }
+    }
 
-        // Transform the currently checked point from index-coordinates to
-        // world-coordinates
-        m_DistanceImageITK->TransformIndexToPhysicalPoint( currentIndex, currentPointAsPoint );
+    candidateDistances.resize(candidates.size());
+    const int numberOfCandidates = static_cast<int>(candidates.size());
+#pragma omp parallel for
+    for (int i = 0; i < numberOfCandidates; ++i)
+    {
+      // Transform the currently checked point from index-coordinates to world-coordinates
+      DistanceImageType::PointType candidatePoint;
+      m_DistanceImageITK->TransformIndexToPhysicalPoint( candidates[i], candidatePoint );
 
-        // create a vnl_vector
-        currentPoint[0] = currentPointAsPoint[0];
-        currentPoint[1] = currentPointAsPoint[1];
-        currentPoint[2] = currentPointAsPoint[2];
+      PointType candidate;
+      candidate[0] = candidatePoint[0];
+      candidate[1] = candidatePoint[1];
+      candidate[2] = candidatePoint[2];
 
-        // and check the distance
-        distance = this->CalculateDistanceValue(currentPoint);
-        if ( std::fabs(distance) <= m_DistanceImageSpacing*2 )
-        {
-          nIt.SetPixel(*relativeNb, distance);
-          narrowbandPoints.push(currentIndex);
-        }
+      candidateDistances[i] = this->CalculateDistanceValue(candidate);
+    }
+
+    bandFront.clear();
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+    {
+      if ( std::fabs(candidateDistances[i]) <= m_DistanceImageSpacing*2 )
+      {
+        m_DistanceImageITK->SetPixel(candidates[i], candidateDistances[i]);
+        bandFront.push_back(candidates[i]);
       }
-      relativeNb++;
     }
   }
 
@@ -422,26 +682,67 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   CastToMitkImage(m_DistanceImageITK, resultImage);
 }
 
-double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointType p)
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(const PointType& p) const
 {
-  double distanceValue (0);
-  PointType p1;
-  PointType p2;
-  double norm;
+  const double* centerX = m_EvaluationCenters[0].data();
+  const double* centerY = m_EvaluationCenters[1].data();
+  const double* centerZ = m_EvaluationCenters[2].data();
+  const double* weights = m_EvaluationWeights.data();
+
+  if (m_Solver == DenseSolver)
+  {
+    // independent partial sums allow the compiler to vectorize the loop
+    double partialSums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    const std::size_t numberOfCenters = m_EvaluationWeights.size();
+    std::size_t i = 0;
+    for ( ; i + 4 <= numberOfCenters; i += 4)
+    {
+      for (unsigned int lane = 0; lane < 4; ++lane)
+      {
+        const double dx = p[0] - centerX[i + lane];
+        const double dy = p[1] - centerY[i + lane];
+        const double dz = p[2] - centerZ[i + lane];
+        partialSums[lane] += std::sqrt(dx*dx + dy*dy + dz*dz) * weights[i + lane];
+      }
+    }
+    for ( ; i < numberOfCenters; ++i)
+    {
+      const double dx = p[0] - centerX[i];
+      const double dy = p[1] - centerY[i];
+      const double dz = p[2] - centerZ[i];
+      partialSums[0] += std::sqrt(dx*dx + dy*dy + dz*dz) * weights[i];
+    }
+    return (partialSums[0] + partialSums[1]) + (partialSums[2] + partialSums[3]);
+  }
 
-  CenterList::iterator centerIter;
+  // only the centers in the neighboring cells of the grid are within the support radius
+  double distanceValue = m_DistanceOffset;
+  long cell[3];
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    cell[dim] = static_cast<long>(std::floor((p[dim] - m_GridOrigin[dim]) / m_UsedSupportRadius));
 
-  unsigned int count (0);
-  for ( centerIter=m_Centers.begin();
-    centerIter!=m_Centers.end();
-    centerIter++)
+  for (long z = std::max(cell[2] - 1, 0L); z <= std::min(cell[2] + 1, m_GridSize[2] - 1); ++z)
   {
-    p1 = *centerIter;
-    p2 = p-p1;
-    norm = p2.two_norm();
-    distanceValue = distanceValue + (norm * m_Weights[count]);
-    ++count;
+    for (long y = std::max(cell[1] - 1, 0L); y <= std::min(cell[1] + 1, m_GridSize[1] - 1); ++y)
+    {
+      // the cells of a row in x direction are contiguous
+      const long rowStart = (z * m_GridSize[1] + y) * m_GridSize[0];
+      const long firstX = std::max(cell[0] - 1, 0L);
+      const long lastX = std::min(cell[0] + 1, m_GridSize[0] - 1);
+      if (firstX > lastX)
+        continue;
+
+      const unsigned int end = m_GridCellStart[rowStart + lastX + 1];
+      for (unsigned int k = m_GridCellStart[rowStart + firstX]; k < end; ++k)
+      {
+        const double dx = p[0] - centerX[k];
+        const double dy = p[1] - centerY[k];
+        const double dz = p[2] - centerZ[k];
+        distanceValue += WendlandFunction(std::sqrt(dx*dx + dy*dy + dz*dz) / m_UsedSupportRadius) * weights[k];
+      }
+    }
   }
+
   return distanceValue;
 }
 
@@ -28,6 +28,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageBase.h"
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <vector>
 
 namespace mitk {
 
@@ -55,6 +58,19 @@ namespace mitk {
          Note that the obtained distance image has always an isotropig spacing. The size (in this case volume) of the image can be
          adjusted by calling SetDistanceImageVolume(unsigned int volume) which specifies the number ob pixels enclosed by the image.
 
+         The weights of the radial basis functions can be determined in two ways (see SetSolver()):
+         - DenseSolver (default): Phi(r) = r for all pairs of centers, solved by LU decomposition. The effort grows cubically
+           with the number of contour points.
+         - CompactSupportSolver: Wendland's compactly supported function Phi(r) = (1 - r/s)^4 (4r/s + 1) for r < s, which
+           results in a sparse, positive definite system that is solved by a sparse LDLT decomposition. The distance function
+           is offset by a positive constant, so that it is positive (i.e. outside) farther than the support radius s from all
+           centers. Thus, s must be larger than the gaps between the contours (see SetSupportRadius()).
+
+         The distance function is evaluated in a narrow band around the surface, which is grown from the first center.
+         The voxels of each growing step are evaluated in parallel.
+
+         An update can be aborted by SetAbortGenerateData(true) from another thread. The output is incomplete then.
+
   \ingroup Process
 
   $Author: fetzer$
@@ -74,6 +90,13 @@ namespace mitk {
 
     typedef std::vector<Surface::Pointer> SurfaceList;
 
+    /** \brief Methods to calculate the weights of the radial basis functions, see class documentation */
+    enum SolverType
+    {
+      DenseSolver,
+      CompactSupportSolver
+    };
+
 
     mitkClassMacro(CreateDistanceImageFromSurfaceFilter,ImageSource);
     itkFactorylessNewMacro(Self)
@@ -102,6 +125,25 @@ namespace mitk {
     */
     itkSetMacro(DistanceImageVolume, unsigned int);
 
+    /**
+    \brief Set the method used for the interpolation, DenseSolver by default.
+    */
+    itkSetMacro(Solver, SolverType);
+    itkGetConstMacro(Solver, SolverType);
+
+    /**
+    \brief Support radius (in mm) of the radial basis functions of the CompactSupportSolver.
+           If 0 (default), 1.5 times the largest distance of a contour point to the nearest point of another contour is used.
+    */
+    itkSetMacro(SupportRadius, double);
+    itkGetConstMacro(SupportRadius, double);
+
+    /**
+    \brief Seconds needed by the last update to set up and solve the equation system, and to evaluate the distance image.
+    */
+    itkGetConstMacro(SolveTime, double);
+    itkGetConstMacro(EvaluationTime, double);
+
     void PrintEquationSystem();
 
     //Resets the filter, i.e. removes all inputs and outputs
@@ -134,7 +176,22 @@ namespace mitk {
   private:
 
     void CreateSolutionMatrixAndFunctionValues();
-    double CalculateDistanceValue(PointType p);
+
+    void CreateSparseSolutionMatrix();
+
+    void SolveEquationSystem();
+
+    /** \brief Support radius to be used for the CompactSupportSolver */
+    double DetermineSupportRadius() const;
+
+    /** \brief Sorts the centers into a grid with cells of the size of the support radius (CompactSupportSolver only) */
+    void BuildCenterGrid();
+
+    /** \brief Arranges centers and weights for CalculateDistanceValue() */
+    void PrepareDistanceEvaluation();
+
+    /** \brief Thread-safe after PrepareDistanceEvaluation() */
+    double CalculateDistanceValue(const PointType& p) const;
 
     void FillDistanceImage ();
 
@@ -164,11 +221,32 @@ namespace mitk {
     //Datastructures for the interpolation
     CenterList m_Centers;
     NormalList m_Normals;
+    /** \brief Index of the input each center (on the surface) belongs to */
+    std::vector<unsigned int> m_CenterInputIndices;
 
     Eigen::MatrixXd m_SolutionMatrix;
+    Eigen::SparseMatrix<double> m_SparseSolutionMatrix;
     Eigen::VectorXd m_FunctionValues;
     Eigen::VectorXd m_Weights;
 
+    SolverType m_Solver;
+    double m_SupportRadius;
+    /** \brief Support radius and offset of the distance function of the last update (CompactSupportSolver only) */
+    double m_UsedSupportRadius;
+    double m_DistanceOffset;
+
+    //Centers and weights as separate arrays for the evaluation, in the order of the grid cells for the CompactSupportSolver
+    std::vector<double> m_EvaluationCenters[3];
+    std::vector<double> m_EvaluationWeights;
+    //Uniform grid with cells of the size of the support radius
+    double m_GridOrigin[3];
+    long m_GridSize[3];
+    std::vector<unsigned int> m_GridCellStart;
+    std::vector<unsigned int> m_GridCenterIndices;
+
+    double m_SolveTime;
+    double m_EvaluationTime;
+
     DistanceImageType::Pointer m_DistanceImageITK;
     itk::ImageBase<3>::Pointer m_ReferenceImage;
 
@@ -78,6 +78,13 @@ namespace mitk {
         itkSetMacro(StepSize, unsigned int);
         itkSetMacro(Tolerance, double);
 
+        /**
+          \brief Only the first n inputs are reduced, the remaining inputs are just considered for the
+          detection of intersection contours. If 0 (default), all inputs are reduced.
+        */
+        itkSetMacro(NumberOfInputsToReduce, unsigned int);
+        itkGetMacro(NumberOfInputsToReduce, unsigned int);
+
         itkGetMacro(NumberOfPointsAfterReduction, unsigned int);
 
         //Resets the filter, i.e. removes all inputs and outputs
@@ -128,6 +135,8 @@ namespace mitk {
 
         unsigned int m_NumberOfPointsAfterReduction;
 
+        unsigned int m_NumberOfInputsToReduce;
+
     };//class
 
 }//namespace
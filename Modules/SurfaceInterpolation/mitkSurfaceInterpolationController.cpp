@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include "vtkXMLPolyDataWriter.h"
 #include "vtkPolyDataWriter.h"
 
+#include <set>
+
 // Check whether the given contours are coplanar
 bool ContoursCoplanar(mitk::SurfaceInterpolationController::ContourPositionInformation leftHandSide, mitk::SurfaceInterpolationController::ContourPositionInformation rightHandSide)
 {
@@ -62,6 +64,15 @@ bool ContoursCoplanar(mitk::SurfaceInterpolationController::ContourPositionInfor
     return false;
 }
 
+// Check whether the planes of the given contours are parallel, contours in parallel planes cannot intersect
+bool ContoursParallel(const mitk::SurfaceInterpolationController::ContourPositionInformation& leftHandSide, const mitk::SurfaceInterpolationController::ContourPositionInformation& rightHandSide)
+{
+  double lengthLHS = leftHandSide.contourNormal.GetNorm();
+  double lengthRHS = rightHandSide.contourNormal.GetNorm();
+  double dot = leftHandSide.contourNormal * rightHandSide.contourNormal;
+  return mitk::Equal(fabs(lengthLHS*lengthRHS), fabs(dot), 0.001);
+}
+
 mitk::SurfaceInterpolationController::ContourPositionInformation CreateContourPositionInformation(mitk::Surface::Pointer contour)
 {
   mitk::SurfaceInterpolationController::ContourPositionInformation contourInfo;
@@ -76,7 +87,8 @@ mitk::SurfaceInterpolationController::ContourPositionInformation CreateContourPo
 }
 
 mitk::SurfaceInterpolationController::SurfaceInterpolationController()
-  :m_SelectedSegmentation(nullptr), m_CurrentTimeStep(0)
+  :m_SelectedSegmentation(nullptr), m_CurrentTimeStep(0), m_NumberOfPointsAfterReduction(0),
+   m_NumberOfRecentlyReducedContours(0), m_PreprocessedContoursOutdated(false), m_InterpolationAborted(false)
 {
   m_DistanceImageSpacing = 0.0;
   m_ReduceFilter = ReduceContourSetFilter::New();
@@ -154,7 +166,6 @@ void mitk::SurfaceInterpolationController::AddToInterpolationPipeline(ContourPos
     return;
   }
 
-  int pos (-1);
   unsigned int numTimeSteps = m_SelectedSegmentation->GetTimeSteps();
   if ( m_CurrentTimeStep >= numTimeSteps )
   {
@@ -162,35 +173,39 @@ void mitk::SurfaceInterpolationController::AddToInterpolationPipeline(ContourPos
     return;
   }
 
-  ContourPositionInformationVec2D currentContours = m_ListOfInterpolationSessions[m_SelectedSegmentation];
-  ContourPositionInformationList currentContourList = currentContours[m_CurrentTimeStep];
-
   mitk::Surface* newContour = contourInfo.contour;
+
+  //Don't save a new empty contour
+  if (newContour->GetVtkPolyData()->GetNumberOfPoints() == 0)
+  {
+    this->RemoveContour(contourInfo);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_ContourListMutex);
+  ContourPositionInformationList& currentContourList = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep];
+
+  int pos (-1);
   for (unsigned int i = 0; i < currentContourList.size(); i++)
   {
-    ContourPositionInformation contourFromList = currentContourList.at(i);
-    if (ContoursCoplanar(contourInfo, contourFromList))
+    if (ContoursCoplanar(contourInfo, currentContourList.at(i)))
     {
       pos = i;
       break;
     }
   }
 
-  //Don't save a new empty contour
-  if (pos == -1 && newContour->GetVtkPolyData()->GetNumberOfPoints() > 0)
+  if (pos == -1)
   {
-    m_ReduceFilter->SetInput(m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].size(), newContour);
-    m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].push_back(contourInfo);
+    currentContourList.push_back(contourInfo);
   }
-  else if (pos != -1 && newContour->GetVtkPolyData()->GetNumberOfPoints() > 0)
+  else
   {
-    m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].at(pos) = contourInfo;
-    m_ReduceFilter->SetInput(pos, newContour);
-  }
-  else if (newContour->GetVtkPolyData()->GetNumberOfPoints() == 0)
-  {
-    this->RemoveContour(contourInfo);
+    currentContourList.at(pos) = contourInfo;
   }
+
+  // A running interpolation is outdated now
+  this->AbortInterpolation();
 }
 
 bool mitk::SurfaceInterpolationController::RemoveContour(ContourPositionInformation contourInfo )
@@ -206,19 +221,29 @@ bool mitk::SurfaceInterpolationController::RemoveContour(ContourPositionInformat
     return false;
   }
 
-  auto it = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].begin();
-  while (it !=  m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].end())
+  bool contourRemoved (false);
   {
-    ContourPositionInformation currentContour = (*it);
-    if (ContoursCoplanar(currentContour, contourInfo))
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    ContourPositionInformationList& currentContourList = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep];
+    auto it = currentContourList.begin();
+    while (it != currentContourList.end())
     {
-      m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].erase(it);
-      this->ReinitializeInterpolation();
-      return true;
+      ContourPositionInformation currentContour = (*it);
+      if (ContoursCoplanar(currentContour, contourInfo))
+      {
+        currentContourList.erase(it);
+        contourRemoved = true;
+        break;
+      }
+      ++it;
     }
-    ++it;
   }
-  return false;
+
+  if (contourRemoved)
+  {
+    this->ReinitializeInterpolation();
+  }
+  return contourRemoved;
 }
 
 const mitk::Surface* mitk::SurfaceInterpolationController::GetContour(ContourPositionInformation contourInfo )
@@ -262,43 +287,75 @@ unsigned int mitk::SurfaceInterpolationController::GetNumberOfContours()
 
 void mitk::SurfaceInterpolationController::Interpolate()
 {
-  m_ReduceFilter->Update();
-
-  m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
-  if (m_CurrentNumberOfReducedContours == 1)
+  // Work on a copy of the contour list, so that contours can be added while the interpolation is running
+  mitk::Image::Pointer segmentation;
+  unsigned int timeStep (0);
+  ContourPositionInformationList contours;
   {
-      vtkPolyData* tmp = m_ReduceFilter->GetOutput(0)->GetVtkPolyData();
-      if (tmp == nullptr)
-      {
-          m_CurrentNumberOfReducedContours = 0;
-      }
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    m_InterpolationAborted = false;
+
+    segmentation = m_SelectedSegmentation;
+    timeStep = m_CurrentTimeStep;
+    if (segmentation.IsNull() || timeStep >= m_ListOfInterpolationSessions[m_SelectedSegmentation].size())
+    {
+      std::lock_guard<std::mutex> resultLock(m_InterpolationResultMutex);
+      m_InterpolationResult = nullptr;
+      return;
+    }
+    contours = m_ListOfInterpolationSessions[m_SelectedSegmentation][timeStep];
   }
 
   mitk::ImageTimeSelector::Pointer timeSelector = mitk::ImageTimeSelector::New();
-  timeSelector->SetInput( m_SelectedSegmentation );
-  timeSelector->SetTimeNr( m_CurrentTimeStep );
+  timeSelector->SetInput( segmentation );
+  timeSelector->SetTimeNr( timeStep );
   timeSelector->SetChannelNr( 0 );
   timeSelector->Update();
   mitk::Image::Pointer refSegImage = timeSelector->GetOutput();
 
-  m_NormalsFilter->SetSegmentationBinaryImage(refSegImage);
-  for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
+  //Setting up progress bar
+  mitk::ProgressBar::GetInstance()->AddStepsToDo(10);
+
+  // Only contours which are new or whose intersecting contours have changed are reduced again
+  std::vector<mitk::Surface::Pointer> reducedContours;
+  if (!this->PreprocessContours(contours, refSegImage, true, reducedContours))
   {
-    mitk::Surface::Pointer reducedContour = m_ReduceFilter->GetOutput(i);
-    reducedContour->DisconnectPipeline();
-    m_NormalsFilter->SetInput(i, reducedContour);
-    m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+    mitk::ProgressBar::GetInstance()->Progress(20);
+    return;
+  }
+
+  itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+  AccessFixedDimensionByItk_1( refSegImage, GetImageBase, 3, itkImage );
+
+  m_InterpolateSurfaceFilter->Reset();
+  m_InterpolateSurfaceFilter->SetReferenceImage(itkImage.GetPointer());
+  for (unsigned int i = 0; i < reducedContours.size(); i++)
+  {
+    m_InterpolateSurfaceFilter->SetInput(i, reducedContours.at(i));
   }
 
-  if (m_CurrentNumberOfReducedContours< 2)
+  if (reducedContours.size() < 2)
   {
     //If no interpolation is possible reset the interpolation result
-    m_InterpolationResult = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m_InterpolationResultMutex);
+      m_InterpolationResult = nullptr;
+    }
+    mitk::ProgressBar::GetInstance()->Progress(20);
     return;
   }
 
-  //Setting up progress bar
-  mitk::ProgressBar::GetInstance()->AddStepsToDo(10);
+  // An abort before the update would be reset by the filter
+  if (!m_InterpolationAborted)
+  {
+    m_InterpolateSurfaceFilter->Update();
+  }
+
+  if (m_InterpolationAborted)
+  {
+    mitk::ProgressBar::GetInstance()->Progress(20);
+    return;
+  }
 
   // create a surface from the distance-image
   mitk::ImageToSurfaceFilter::Pointer imageToSurfaceFilter = mitk::ImageToSurfaceFilter::New();
@@ -308,29 +365,160 @@ void mitk::SurfaceInterpolationController::Interpolate()
   imageToSurfaceFilter->SetSmoothIteration(20);
   imageToSurfaceFilter->Update();
 
+  if (m_InterpolationAborted)
+  {
+    mitk::ProgressBar::GetInstance()->Progress(20);
+    return;
+  }
+
   mitk::Surface::Pointer interpolationResult = mitk::Surface::New();
-  interpolationResult->SetVtkPolyData( imageToSurfaceFilter->GetOutput()->GetVtkPolyData(), m_CurrentTimeStep );
-  m_InterpolationResult = interpolationResult;
+  interpolationResult->SetVtkPolyData( imageToSurfaceFilter->GetOutput()->GetVtkPolyData(), timeStep );
+  interpolationResult->DisconnectPipeline();
 
   m_DistanceImageSpacing = m_InterpolateSurfaceFilter->GetDistanceImageSpacing();
 
   vtkSmartPointer<vtkAppendPolyData> polyDataAppender = vtkSmartPointer<vtkAppendPolyData>::New();
-  for (unsigned int i = 0; i < m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].size(); i++)
+  for (unsigned int i = 0; i < contours.size(); i++)
   {
-    polyDataAppender->AddInputData(m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].at(i).contour->GetVtkPolyData());
+    polyDataAppender->AddInputData(contours.at(i).contour->GetVtkPolyData());
   }
   polyDataAppender->Update();
   m_Contours->SetVtkPolyData(polyDataAppender->GetOutput());
 
+  {
+    std::lock_guard<std::mutex> lock(m_InterpolationResultMutex);
+    m_InterpolationResult = interpolationResult;
+  }
+
   //Last progress step
   mitk::ProgressBar::GetInstance()->Progress(20);
+}
 
-  m_InterpolationResult->DisconnectPipeline();
+void mitk::SurfaceInterpolationController::AbortInterpolation()
+{
+  m_InterpolationAborted = true;
+  m_InterpolateSurfaceFilter->SetAbortGenerateData(true);
+}
+
+mitk::SurfaceInterpolationController::PreprocessedContour mitk::SurfaceInterpolationController::PreprocessContour(unsigned int index, const ContourPositionInformationList& contours)
+{
+  const ContourPositionInformation& contourInfo = contours.at(index);
+
+  // The reduction keeps points where other contours intersect, which is impossible for parallel contours
+  std::vector<mitk::Surface::Pointer> intersectingContours;
+  for (unsigned int i = 0; i < contours.size(); i++)
+  {
+    if (i != index && !ContoursParallel(contourInfo, contours.at(i)))
+    {
+      intersectingContours.push_back(contours.at(i).contour);
+    }
+  }
+
+  auto cacheIter = m_PreprocessedContours.find(contourInfo.contour.GetPointer());
+  if (cacheIter != m_PreprocessedContours.end() && cacheIter->second.intersectingContours == intersectingContours)
+  {
+    return cacheIter->second;
+  }
+
+  ++m_NumberOfRecentlyReducedContours;
+
+  PreprocessedContour preprocessedContour;
+  preprocessedContour.contour = contourInfo.contour;
+  preprocessedContour.intersectingContours = intersectingContours;
+
+  m_ReduceFilter->Reset();
+  m_ReduceFilter->SetNumberOfInputsToReduce(1);
+  m_ReduceFilter->SetInput(0, contourInfo.contour);
+  for (unsigned int i = 0; i < intersectingContours.size(); i++)
+  {
+    m_ReduceFilter->SetInput(i + 1, intersectingContours.at(i));
+  }
+  m_ReduceFilter->Update();
+  preprocessedContour.numberOfReducedPoints = m_ReduceFilter->GetNumberOfPointsAfterReduction();
+
+  m_NormalsFilter->Reset();
+  unsigned int numberOfReducedContours (0);
+  for (unsigned int i = 0; i < m_ReduceFilter->GetNumberOfIndexedOutputs(); i++)
+  {
+    mitk::Surface::Pointer reducedContour = m_ReduceFilter->GetOutput(i);
+    if (reducedContour->GetVtkPolyData() == nullptr || reducedContour->GetVtkPolyData()->GetNumberOfPoints() == 0)
+      continue;
+
+    reducedContour->DisconnectPipeline();
+    m_NormalsFilter->SetInput(numberOfReducedContours, reducedContour);
+    ++numberOfReducedContours;
+  }
+
+  if (numberOfReducedContours > 0)
+  {
+    m_NormalsFilter->Update();
+    for (unsigned int i = 0; i < numberOfReducedContours; i++)
+    {
+      mitk::Surface::Pointer contourWithNormals = m_NormalsFilter->GetOutput(i);
+      contourWithNormals->DisconnectPipeline();
+      preprocessedContour.reducedContours.push_back(contourWithNormals);
+    }
+  }
+
+  m_PreprocessedContours[contourInfo.contour.GetPointer()] = preprocessedContour;
+  return preprocessedContour;
+}
+
+bool mitk::SurfaceInterpolationController::PreprocessContours(const ContourPositionInformationList& contours, mitk::Image* segmentation,
+                                                              bool interpolating, std::vector<Surface::Pointer>& reducedContours)
+{
+  std::lock_guard<std::mutex> lock(m_PreprocessingMutex);
+
+  if (m_PreprocessedContoursOutdated.exchange(false))
+  {
+    m_PreprocessedContours.clear();
+  }
+
+  m_NormalsFilter->SetSegmentationBinaryImage(segmentation);
+  m_NormalsFilter->SetUseProgressBar(interpolating);
+  m_NumberOfRecentlyReducedContours = 0;
+
+  std::set<const mitk::Surface*> currentContours;
+  unsigned int numberOfPointsAfterReduction (0);
+  for (unsigned int i = 0; i < contours.size(); i++)
+  {
+    if (interpolating && m_InterpolationAborted)
+      return false;
+
+    PreprocessedContour preprocessedContour = this->PreprocessContour(i, contours);
+    reducedContours.insert(reducedContours.end(), preprocessedContour.reducedContours.begin(), preprocessedContour.reducedContours.end());
+    numberOfPointsAfterReduction += preprocessedContour.numberOfReducedPoints;
+    currentContours.insert(preprocessedContour.contour.GetPointer());
+  }
+
+  // Forget contours which have been replaced or removed
+  auto cacheIter = m_PreprocessedContours.begin();
+  while (cacheIter != m_PreprocessedContours.end())
+  {
+    if (currentContours.find(cacheIter->first) == currentContours.end())
+    {
+      cacheIter = m_PreprocessedContours.erase(cacheIter);
+    }
+    else
+    {
+      ++cacheIter;
+    }
+  }
+
+  m_NumberOfPointsAfterReduction = numberOfPointsAfterReduction;
+  m_CurrentNumberOfReducedContours = reducedContours.size();
+  return true;
 }
 
 mitk::Surface::Pointer mitk::SurfaceInterpolationController::GetInterpolationResult()
 {
-    return m_InterpolationResult;
+  std::lock_guard<std::mutex> lock(m_InterpolationResultMutex);
+  return m_InterpolationResult;
+}
+
+unsigned int mitk::SurfaceInterpolationController::GetNumberOfRecentlyReducedContours()
+{
+  return m_NumberOfRecentlyReducedContours;
 }
 
 mitk::Surface* mitk::SurfaceInterpolationController::GetContoursAsSurface()
@@ -346,12 +534,14 @@ void mitk::SurfaceInterpolationController::SetDataStorage(DataStorage::Pointer d
 void mitk::SurfaceInterpolationController::SetMinSpacing(double minSpacing)
 {
   m_ReduceFilter->SetMinSpacing(minSpacing);
+  m_PreprocessedContoursOutdated = true;
 }
 
 void mitk::SurfaceInterpolationController::SetMaxSpacing(double maxSpacing)
 {
   m_ReduceFilter->SetMaxSpacing(maxSpacing);
   m_NormalsFilter->SetMaxSpacing(maxSpacing);
+  m_PreprocessedContoursOutdated = true;
 }
 
 void mitk::SurfaceInterpolationController::SetDistanceImageVolume(unsigned int distImgVolume)
@@ -371,7 +561,7 @@ mitk::Image* mitk::SurfaceInterpolationController::GetImage()
 
 double mitk::SurfaceInterpolationController::EstimatePortionOfNeededMemory()
 {
-  double numberOfPointsAfterReduction = m_ReduceFilter->GetNumberOfPointsAfterReduction()*3;
+  double numberOfPointsAfterReduction = m_NumberOfPointsAfterReduction*3;
   double sizeOfPoints = pow(numberOfPointsAfterReduction,2)*sizeof(double);
   double totalMem = mitk::MemoryUtilities::GetTotalSizeOfPhysicalRam();
   double percentage = sizeOfPoints/totalMem;
@@ -401,20 +591,33 @@ void mitk::SurfaceInterpolationController::SetCurrentInterpolationSession(mitk::
 
   if (currentSegmentationImage.IsNull())
   {
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
     m_SelectedSegmentation = nullptr;
     return;
   }
 
-  m_SelectedSegmentation = currentSegmentationImage.GetPointer();
+  bool newSession (false);
+  {
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    m_SelectedSegmentation = currentSegmentationImage.GetPointer();
 
-  auto it = m_ListOfInterpolationSessions.find(currentSegmentationImage.GetPointer());
-  // If the session does not exist yet create a new ContourPositionPairList otherwise reinitialize the interpolation pipeline
-  if (it == m_ListOfInterpolationSessions.end())
+    auto it = m_ListOfInterpolationSessions.find(currentSegmentationImage.GetPointer());
+    // If the session does not exist yet create a new ContourPositionPairList otherwise reinitialize the interpolation pipeline
+    if (it == m_ListOfInterpolationSessions.end())
+    {
+      ContourPositionInformationVec2D newList;
+      m_ListOfInterpolationSessions.insert(std::pair<mitk::Image*, ContourPositionInformationVec2D>(m_SelectedSegmentation, newList));
+      m_CurrentNumberOfReducedContours = 0;
+      newSession = true;
+    }
+  }
+
+  if (newSession)
   {
-    ContourPositionInformationVec2D newList;
-    m_ListOfInterpolationSessions.insert(std::pair<mitk::Image*, ContourPositionInformationVec2D>(m_SelectedSegmentation, newList));
-    m_InterpolationResult = nullptr;
-    m_CurrentNumberOfReducedContours = 0;
+    {
+      std::lock_guard<std::mutex> lock(m_InterpolationResultMutex);
+      m_InterpolationResult = nullptr;
+    }
 
     itk::MemberCommand<SurfaceInterpolationController>::Pointer command = itk::MemberCommand<SurfaceInterpolationController>::New();
     command->SetCallbackFunction(this, &SurfaceInterpolationController::OnSegmentationDeleted);
@@ -441,13 +644,19 @@ bool mitk::SurfaceInterpolationController::ReplaceInterpolationSession(mitk::Ima
     return false;
 
   ContourPositionInformationVec2D oldList = (*it).second;
-  m_ListOfInterpolationSessions.insert(std::pair<mitk::Image*, ContourPositionInformationVec2D>(newSession.GetPointer(), oldList));
+  {
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    m_ListOfInterpolationSessions.insert(std::pair<mitk::Image*, ContourPositionInformationVec2D>(newSession.GetPointer(), oldList));
+  }
   itk::MemberCommand<SurfaceInterpolationController>::Pointer command = itk::MemberCommand<SurfaceInterpolationController>::New();
   command->SetCallbackFunction(this, &SurfaceInterpolationController::OnSegmentationDeleted);
   m_SegmentationObserverTags.insert( std::pair<mitk::Image*, unsigned long>( newSession, newSession->AddObserver( itk::DeleteEvent(), command ) ) );
 
   if (m_SelectedSegmentation == oldSession)
+  {
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
     m_SelectedSegmentation = newSession;
+  }
 
   mitk::ImageTimeSelector::Pointer timeSelector = mitk::ImageTimeSelector::New();
   timeSelector->SetInput( m_SelectedSegmentation );
@@ -455,7 +664,10 @@ bool mitk::SurfaceInterpolationController::ReplaceInterpolationSession(mitk::Ima
   timeSelector->SetChannelNr( 0 );
   timeSelector->Update();
   mitk::Image::Pointer refSegImage = timeSelector->GetOutput();
-  m_NormalsFilter->SetSegmentationBinaryImage(refSegImage);
+  {
+    std::lock_guard<std::mutex> lock(m_PreprocessingMutex);
+    m_NormalsFilter->SetSegmentationBinaryImage(refSegImage);
+  }
 
   this->RemoveInterpolationSession(oldSession);
   return true;
@@ -472,7 +684,12 @@ void mitk::SurfaceInterpolationController::RemoveInterpolationSession(mitk::Imag
   {
     if (m_SelectedSegmentation == segmentationImage)
     {
+      std::lock_guard<std::mutex> lock(m_PreprocessingMutex);
       m_NormalsFilter->SetSegmentationBinaryImage(nullptr);
+    }
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    if (m_SelectedSegmentation == segmentationImage)
+    {
       m_SelectedSegmentation = nullptr;
     }
     m_ListOfInterpolationSessions.erase(segmentationImage);
@@ -498,6 +715,7 @@ void mitk::SurfaceInterpolationController::RemoveAllInterpolationSessions()
   }
 
   m_SegmentationObserverTags.clear();
+  std::lock_guard<std::mutex> lock(m_ContourListMutex);
   m_SelectedSegmentation = nullptr;
   m_ListOfInterpolationSessions.clear();
 }
@@ -618,69 +836,57 @@ void mitk::SurfaceInterpolationController::OnSegmentationDeleted(const itk::Obje
   {
     if (m_SelectedSegmentation == tempImage)
     {
+      std::lock_guard<std::mutex> lock(m_PreprocessingMutex);
       m_NormalsFilter->SetSegmentationBinaryImage(nullptr);
-      m_SelectedSegmentation = nullptr;
     }
     m_SegmentationObserverTags.erase(tempImage);
+    std::lock_guard<std::mutex> lock(m_ContourListMutex);
+    if (m_SelectedSegmentation == tempImage)
+    {
+      m_SelectedSegmentation = nullptr;
+    }
     m_ListOfInterpolationSessions.erase(tempImage);
   }
 }
 
 void mitk::SurfaceInterpolationController::ReinitializeInterpolation()
 {
-  // If session has changed reset the pipeline
-  m_ReduceFilter->Reset();
-  m_NormalsFilter->Reset();
-  m_InterpolateSurfaceFilter->Reset();
-
-  itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+  // A running interpolation is outdated now. The contours of the session are preprocessed right away,
+  // so that the memory needed by the interpolation can be estimated before it is started. The reference
+  // image of the interpolation is set by Interpolate().
+  this->AbortInterpolation();
 
   if ( m_SelectedSegmentation )
   {
-    mitk::ImageTimeSelector::Pointer timeSelector = mitk::ImageTimeSelector::New();
-    timeSelector->SetInput( m_SelectedSegmentation );
-    timeSelector->SetTimeNr( m_CurrentTimeStep );
-    timeSelector->SetChannelNr( 0 );
-    timeSelector->Update();
-    mitk::Image::Pointer refSegImage = timeSelector->GetOutput();
-    AccessFixedDimensionByItk_1( refSegImage, GetImageBase, 3, itkImage );
-    m_InterpolateSurfaceFilter->SetReferenceImage(itkImage.GetPointer());
-
     unsigned int numTimeSteps = m_SelectedSegmentation->GetTimeSteps();
-    unsigned int size = m_ListOfInterpolationSessions[m_SelectedSegmentation].size();
-    if ( size != numTimeSteps )
-    {
-      m_ListOfInterpolationSessions[m_SelectedSegmentation].resize( numTimeSteps );
-    }
-
-    if ( m_CurrentTimeStep < numTimeSteps )
+    ContourPositionInformationList contours;
     {
-      unsigned int numContours = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep].size();
-      for ( unsigned int c = 0; c < numContours; ++c )
+      std::lock_guard<std::mutex> lock(m_ContourListMutex);
+      unsigned int size = m_ListOfInterpolationSessions[m_SelectedSegmentation].size();
+      if ( size != numTimeSteps )
       {
-        m_ReduceFilter->SetInput(c, m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep][c].contour);
+        m_ListOfInterpolationSessions[m_SelectedSegmentation].resize( numTimeSteps );
       }
 
-      m_ReduceFilter->Update();
-
-      m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
-      if (m_CurrentNumberOfReducedContours == 1)
+      if ( m_CurrentTimeStep < numTimeSteps )
       {
-          vtkPolyData* tmp = m_ReduceFilter->GetOutput(0)->GetVtkPolyData();
-          if (tmp == nullptr)
-          {
-              m_CurrentNumberOfReducedContours = 0;
-          }
+        contours = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep];
       }
+    }
 
-      for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
-      {
-        m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
-        m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
-      }
+    if ( m_CurrentTimeStep < numTimeSteps )
+    {
+      mitk::ImageTimeSelector::Pointer timeSelector = mitk::ImageTimeSelector::New();
+      timeSelector->SetInput( m_SelectedSegmentation );
+      timeSelector->SetTimeNr( m_CurrentTimeStep );
+      timeSelector->SetChannelNr( 0 );
+      timeSelector->Update();
+      mitk::Image::Pointer refSegImage = timeSelector->GetOutput();
+
+      std::vector<mitk::Surface::Pointer> reducedContours;
+      this->PreprocessContours(contours, refSegImage, false, reducedContours);
     }
 
     Modified();
-
   }
 }
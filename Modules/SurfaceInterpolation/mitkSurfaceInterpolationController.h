@@ -48,6 +48,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkProgressBar.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace mitk
 {
 
@@ -129,11 +132,28 @@ namespace mitk
 
     /**
      * Interpolates the 3D surface from the given extracted contours
+     *
+     * The reduced contours and their normals are cached per contour, so that only contours which have
+     * been added or replaced since the last call have to be processed again. This method may be called
+     * from a background thread. It returns early, keeping the previous result, if the contours of the
+     * current session are changed or AbortInterpolation() is called meanwhile.
      */
     void Interpolate ();
 
+    /**
+     * @brief Aborts a running call of Interpolate(). The previous interpolation result is kept.
+     */
+    void AbortInterpolation();
+
     mitk::Surface::Pointer GetInterpolationResult();
 
+    /**
+     * @brief Returns the number of contours which were reduced when the contours of the current session were
+     *        preprocessed last, by Interpolate() or a change of the session. Unchanged contours are taken from
+     *        the cache and not counted.
+     */
+    unsigned int GetNumberOfRecentlyReducedContours();
+
     /**
      * Sets the minimum spacing of the current selected segmentation
      * This is needed since the contour points we reduced before they are used to interpolate the surface
@@ -235,6 +255,34 @@ namespace mitk
 
    void AddToInterpolationPipeline(ContourPositionInformation contourInfo );
 
+   /**
+    * A contour after the reduction of its points and the computation of the normals. As the reduction
+    * depends on the contours intersecting the contour, these are stored as well.
+    */
+   struct PreprocessedContour
+   {
+     Surface::Pointer contour;
+     std::vector<Surface::Pointer> intersectingContours;
+     std::vector<Surface::Pointer> reducedContours;
+     unsigned int numberOfReducedPoints;
+   };
+
+   typedef std::map<const Surface*, PreprocessedContour> PreprocessedContourMap;
+
+   /**
+    * Returns the cached preprocessed contour at the given index of contours or reduces the contour and
+    * computes its normals if it is not cached or its intersecting contours have changed
+    */
+   PreprocessedContour PreprocessContour(unsigned int index, const ContourPositionInformationList& contours);
+
+   /**
+    * Preprocesses all contours of the list and removes the contours which are not in the list anymore from the
+    * cache. If called by Interpolate(), the progress bar is updated and false is returned as soon as the
+    * interpolation is aborted.
+    */
+   bool PreprocessContours(const ContourPositionInformationList& contours, mitk::Image* segmentation,
+                           bool interpolating, std::vector<Surface::Pointer>& reducedContours);
+
     ReduceContourSetFilter::Pointer m_ReduceFilter;
     ComputeContourSetNormalsFilter::Pointer m_NormalsFilter;
     CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter;
@@ -258,6 +306,28 @@ namespace mitk
     std::map<mitk::Image*, unsigned long> m_SegmentationObserverTags;
 
     unsigned int m_CurrentTimeStep;
+
+    PreprocessedContourMap m_PreprocessedContours;
+
+    std::atomic<unsigned int> m_NumberOfPointsAfterReduction;
+
+    std::atomic<unsigned int> m_NumberOfRecentlyReducedContours;
+
+    // Set if the parameters of the reduction or of the normals have changed
+    std::atomic<bool> m_PreprocessedContoursOutdated;
+
+    std::atomic<bool> m_InterpolationAborted;
+
+    // Guards the contour lists of the sessions and the selected session, which are read by Interpolate()
+    // in a background thread
+    std::mutex m_ContourListMutex;
+
+    // Guards the reduce and normals filters and the cache, which are used by Interpolate() and when the
+    // session changes
+    std::mutex m_PreprocessingMutex;
+
+    // Guards m_InterpolationResult, which is set by Interpolate()
+    std::mutex m_InterpolationResultMutex;
  };
 }
 #endif
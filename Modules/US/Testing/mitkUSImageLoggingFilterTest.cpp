@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkUSImageLoggingFilter.h"
+#include "mitkUSImageStreamReader.h"
 #include <mitkTestingMacros.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingConfig.h>
@@ -25,11 +26,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIMimeTypeProvider.h>
 
 #include "mitkImageGenerator.h"
+#include <mitkImageReadAccessor.h>
 
 #include "itksys/SystemTools.hxx"
 
 #include "Poco/File.h"
 
+#include <cstring>
+
 class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkUSImageLoggingFilterTestSuite);
@@ -40,6 +44,7 @@ class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
   MITK_TEST(TestSavingAfterMupltipleUpdateCalls);
   MITK_TEST(TestFilterWithEmptyImages);
   MITK_TEST(TestFilterWithInvalidPath);
+  MITK_TEST(TestStreaming);
   //MITK_TEST(TestJpgFileExtension); //bug 19614
   CPPUNIT_TEST_SUITE_END();
 
@@ -162,6 +167,52 @@ public:
                                mitk::Exception);
   }
 
+  void TestStreaming()
+  {
+  std::string fileName = m_TemporaryTestDirectory + "/USImageLoggingFilterTest" + mitk::USImageStreamWriter::GetFileExtension();
+  m_TestFilter->StartStreaming(fileName);
+  CPPUNIT_ASSERT_MESSAGE("Testing if streaming is started",m_TestFilter->IsStreaming());
+
+  std::vector<mitk::Image::Pointer> frames;
+  for(int i=0; i<5; i++)
+    {
+    frames.push_back(mitk::ImageGenerator::GenerateRandomImage<float>(20, 30, 1, 1, 0.2, 0.3, 0.4));
+    m_TestFilter->SetInput(frames.back());
+    m_TestFilter->Update();
+    if (i == 2) m_TestFilter->AddMessageToCurrentImage("testmessage");
+    itksys::SystemTools::Delay(10);
+    }
+  m_TestFilter->StopStreaming();
+  CPPUNIT_ASSERT_MESSAGE("Testing if streaming is stopped",!m_TestFilter->IsStreaming());
+  CPPUNIT_ASSERT_MESSAGE("Testing number of streamed images",m_TestFilter->GetNumberOfStreamedImages() == 5);
+  CPPUNIT_ASSERT_MESSAGE("Testing number of dropped images",m_TestFilter->GetNumberOfDroppedImages() == 0);
+
+  mitk::USImageStreamReader::Pointer reader = mitk::USImageStreamReader::New();
+  reader->Open(fileName);
+  CPPUNIT_ASSERT_MESSAGE("Testing if the index was written",reader->HasIndex());
+  CPPUNIT_ASSERT_MESSAGE("Testing number of read frames",reader->GetNumberOfFrames() == 5);
+  CPPUNIT_ASSERT_MESSAGE("Testing number of timestamps",reader->GetTimeStamps().size() == 5);
+  CPPUNIT_ASSERT_MESSAGE("Testing if timestamps are increasing",reader->GetTimeStamps().at(0) < reader->GetTimeStamps().at(4));
+  CPPUNIT_ASSERT_MESSAGE("Testing message of the third frame",reader->GetMessages().size() == 1
+                         && reader->GetMessages().begin()->first == 2 && reader->GetMessages().begin()->second == "testmessage");
+
+  mitk::Image::Pointer image = reader->GetImage();
+  CPPUNIT_ASSERT_MESSAGE("Testing size of the read image",image->GetDimension(0) == 20 && image->GetDimension(1) == 30
+                         && image->GetDimension(3) == 5);
+  CPPUNIT_ASSERT_MESSAGE("Testing pixel type of the read image",image->GetPixelType() == frames.at(0)->GetPixelType());
+  for(unsigned int t=0; t<5; t++)
+    {
+    mitk::ImageReadAccessor frameAccessor(frames.at(t));
+    mitk::ImageReadAccessor readAccessor(image, image->GetVolumeData(t));
+    CPPUNIT_ASSERT_MESSAGE("Testing pixel data of the read frames",
+                           std::memcmp(frameAccessor.GetData(), readAccessor.GetData(), 20 * 30 * sizeof(float)) == 0);
+    }
+
+  //clean up
+  image = NULL;
+  std::remove(fileName.c_str());
+  }
+
   void TestJpgFileExtension()
   {
   CPPUNIT_ASSERT_MESSAGE("Testing setting of jpg extension.",m_TestFilter->SetImageFilesExtension(".jpg"));
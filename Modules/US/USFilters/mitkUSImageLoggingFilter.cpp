@@ -26,12 +26,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 mitk::USImageLoggingFilter::USImageLoggingFilter() : m_SystemTimeClock(RealTimeClock::New()),
-                                                     m_ImageExtension(".nrrd")
+                                                     m_ImageExtension(".nrrd"),
+                                                     m_StreamWriter(USImageStreamWriter::New())
 {
 }
 
 mitk::USImageLoggingFilter::~USImageLoggingFilter()
 {
+  this->StopStreaming();
 }
 
 void mitk::USImageLoggingFilter::GenerateData()
@@ -45,6 +47,13 @@ void mitk::USImageLoggingFilter::GenerateData()
     return;
     }
 
+  if (m_StreamWriter->IsOpen())
+    {
+    //the writer copies the pixel data, no clone is needed
+    m_StreamWriter->AddFrame(inputImage, m_SystemTimeClock->GetCurrentStamp());
+    return;
+    }
+
   //a clone is needed for a output and to store it.
   mitk::Image::Pointer inputClone = inputImage->Clone();
 
@@ -83,6 +92,11 @@ void mitk::USImageLoggingFilter::GenerateData()
 
 void mitk::USImageLoggingFilter::AddMessageToCurrentImage(std::string message)
 {
+  if (m_StreamWriter->IsOpen())
+    {
+    m_StreamWriter->AddMessageToLastFrame(message);
+    return;
+    }
   m_LoggedMessages.insert(std::make_pair(static_cast<int>(m_LoggedImages.size()-1),message));
 }
 
@@ -163,3 +177,33 @@ bool mitk::USImageLoggingFilter::SetImageFilesExtension(std::string extension)
   }
   return false;
  }
+
+void mitk::USImageLoggingFilter::StartStreaming(std::string fileName)
+{
+  m_StreamWriter->Open(fileName);
+}
+
+void mitk::USImageLoggingFilter::StopStreaming()
+{
+  m_StreamWriter->Close();
+}
+
+bool mitk::USImageLoggingFilter::IsStreaming() const
+{
+  return m_StreamWriter->IsOpen();
+}
+
+unsigned long long mitk::USImageLoggingFilter::GetNumberOfStreamedImages() const
+{
+  return m_StreamWriter->GetNumberOfFrames();
+}
+
+unsigned long long mitk::USImageLoggingFilter::GetNumberOfDroppedImages() const
+{
+  return m_StreamWriter->GetNumberOfDroppedFrames();
+}
+
+void mitk::USImageLoggingFilter::SetStreamQueueCapacity(unsigned int capacity)
+{
+  m_StreamWriter->SetQueueCapacity(capacity);
+}
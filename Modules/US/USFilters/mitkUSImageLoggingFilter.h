@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <MitkUSExports.h>
 #include <mitkImageToImageFilter.h>
 #include <mitkRealTimeClock.h>
+#include "mitkUSImageStreamWriter.h"
 
 
 namespace mitk {
@@ -29,6 +30,11 @@ namespace mitk {
    *  add messages. All data (images, timestamps and messages) is written to the harddisc when
    *  the method SaveImages(...) is called.
    *
+   *  For long acquisitions the filter can stream the images to disc instead (see StartStreaming()).
+   *  A USImageStreamWriter then writes the frames in a background thread to a single file, so
+   *  neither the memory usage grows nor Update() waits for the hard disc. The file can be opened
+   *  as 3D+t image with USImageStreamReader.
+   *
    *  Caution: only supports logging of one input at the moment, multiple inputs are ignored!
    *
    *  \ingroup US
@@ -76,6 +82,26 @@ namespace mitk {
      */
     bool SetImageFilesExtension(std::string extension);
 
+    /** Starts streaming all following images to the given file instead of keeping them in memory.
+     *  Images which were logged before are not affected and can still be saved with SaveImages(...).
+     *  @throw mitk::Exception Throws an exception if the file cannot be created or streaming is already started.
+     */
+    void StartStreaming(std::string fileName);
+
+    /** Waits until all streamed images are written and closes the stream file. */
+    void StopStreaming();
+
+    bool IsStreaming() const;
+
+    /** Number of images written (or waiting to be written) to the current or last stream file. */
+    unsigned long long GetNumberOfStreamedImages() const;
+
+    /** Number of images which were not streamed because the hard disc could not keep up. */
+    unsigned long long GetNumberOfDroppedImages() const;
+
+    /** Maximum number of images waiting to be written while streaming. Default is 32. */
+    void SetStreamQueueCapacity(unsigned int capacity);
+
 
   protected:
     USImageLoggingFilter();
@@ -89,6 +115,8 @@ namespace mitk {
     std::vector<double> m_LoggedMITKSystemTimes; ///< Logged system times for every logged image
     std::string m_ImageExtension; ///< stores the image extension, default is ".nrrd"
 
+    mitk::USImageStreamWriter::Pointer m_StreamWriter; ///< writes the images to disc while streaming
+
   };
 } // namespace mitk
 #endif /* MITKUSImageSource_H_HEADER_INCLUDED_ */
@@ -0,0 +1,273 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageStreamReader.h"
+#include <mitkArbitraryTimeGeometry.h>
+#include <mitkExceptionMacro.h>
+#include <mitkMemoryMappedFile.h>
+#include <mitkProportionalTimeGeometry.h>
+
+#include <itkRGBPixel.h>
+#include <itkRGBAPixel.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+  template <typename T>
+  bool ReadValue(std::istream& stream, T& value)
+  {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return stream.good();
+  }
+
+  template <typename T>
+  mitk::PixelType MakeStreamPixelType(unsigned int numberOfComponents)
+  {
+    switch (numberOfComponents)
+    {
+    case 1:
+      return mitk::MakeScalarPixelType<T>();
+    case 3:
+      return mitk::MakePixelType<T, itk::RGBPixel<T> >(3);
+    case 4:
+      return mitk::MakePixelType<T, itk::RGBAPixel<T> >(4);
+    default:
+      mitkThrow() << "Ultrasound stream files with " << numberOfComponents << " components are not supported.";
+    }
+  }
+}
+
+mitk::USImageStreamReader::USImageStreamReader()
+  : m_FrameSize(0),
+    m_NumberOfFrames(0),
+    m_NumberOfDroppedFrames(0),
+    m_HasIndex(false)
+{
+  std::memset(&m_Header, 0, sizeof(m_Header));
+}
+
+mitk::USImageStreamReader::~USImageStreamReader()
+{
+}
+
+void mitk::USImageStreamReader::Open(const std::string& fileName)
+{
+  m_FileName.clear();
+  m_NumberOfFrames = 0;
+  m_NumberOfDroppedFrames = 0;
+  m_TimeStamps.clear();
+  m_Messages.clear();
+  m_HasIndex = false;
+
+  std::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.good())
+  {
+    mitkThrow() << "Cannot open ultrasound stream file " << fileName << ".";
+  }
+
+  stream.seekg(0, std::ios::end);
+  unsigned long long fileSize = static_cast<unsigned long long>(stream.tellg());
+  stream.seekg(0, std::ios::beg);
+
+  if (fileSize < sizeof(m_Header) || !ReadValue(stream, m_Header)
+    || std::memcmp(m_Header.m_Magic, USImageStreamHeaderMagic, sizeof(USImageStreamHeaderMagic)) != 0)
+  {
+    mitkThrow() << fileName << " is not an ultrasound stream file.";
+  }
+  if (m_Header.m_Version != 1)
+  {
+    mitkThrow() << "Version " << m_Header.m_Version << " of ultrasound stream file " << fileName << " is not supported.";
+  }
+  if (m_Header.m_ByteOrderMark != 0x01020304)
+  {
+    mitkThrow() << "Ultrasound stream file " << fileName << " was written on a machine with different byte order.";
+  }
+
+  m_FrameSize = static_cast<std::size_t>(m_Header.m_Dimensions[0]) * m_Header.m_Dimensions[1] * m_Header.m_Dimensions[2]
+    * m_Header.m_NumberOfComponents * m_Header.m_BytesPerComponent;
+  if (m_FrameSize == 0)
+  {
+    mitkThrow() << "Ultrasound stream file " << fileName << " has an invalid header.";
+  }
+
+  m_HasIndex = this->ReadIndex(stream, fileSize);
+  if (!m_HasIndex)
+  {
+    // the writer was not closed, use all complete frames
+    m_NumberOfFrames = static_cast<unsigned int>((fileSize - sizeof(m_Header)) / m_FrameSize);
+    MITK_WARN << "Ultrasound stream file " << fileName << " has no index. Reading " << m_NumberOfFrames
+      << " frames without timestamps.";
+  }
+
+  m_FileName = fileName;
+}
+
+bool mitk::USImageStreamReader::ReadIndex(std::istream& stream, unsigned long long fileSize)
+{
+  const unsigned long long trailerSize = sizeof(unsigned long long) + sizeof(USImageStreamEndMagic);
+  if (fileSize < sizeof(m_Header) + trailerSize)
+    return false;
+
+  unsigned long long indexOffset = 0;
+  char magic[8];
+  stream.seekg(fileSize - trailerSize, std::ios::beg);
+  if (!ReadValue(stream, indexOffset) || !stream.read(magic, sizeof(magic))
+    || std::memcmp(magic, USImageStreamEndMagic, sizeof(USImageStreamEndMagic)) != 0 || indexOffset < sizeof(m_Header)
+    || indexOffset >= fileSize - trailerSize)
+  {
+    stream.clear();
+    return false;
+  }
+
+  unsigned long long numberOfFrames = 0;
+  stream.seekg(indexOffset, std::ios::beg);
+  if (!stream.read(magic, sizeof(magic)) || std::memcmp(magic, USImageStreamIndexMagic, sizeof(USImageStreamIndexMagic)) != 0
+    || !ReadValue(stream, numberOfFrames) || !ReadValue(stream, m_NumberOfDroppedFrames)
+    || sizeof(m_Header) + numberOfFrames * m_FrameSize > indexOffset)
+  {
+    stream.clear();
+    return false;
+  }
+
+  std::vector<double> timeStamps(numberOfFrames);
+  if (numberOfFrames > 0)
+    stream.read(reinterpret_cast<char*>(timeStamps.data()), numberOfFrames * sizeof(double));
+
+  unsigned int numberOfMessages = 0;
+  if (!ReadValue(stream, numberOfMessages))
+  {
+    stream.clear();
+    return false;
+  }
+
+  std::map<unsigned long long, std::string> messages;
+  for (unsigned int i = 0; i < numberOfMessages; i++)
+  {
+    unsigned long long frameIndex = 0;
+    unsigned int length = 0;
+    if (!ReadValue(stream, frameIndex) || !ReadValue(stream, length) || length > fileSize)
+    {
+      stream.clear();
+      return false;
+    }
+    std::string message(length, '\0');
+    if (length > 0 && !stream.read(&message[0], length))
+    {
+      stream.clear();
+      return false;
+    }
+    messages[frameIndex] = message;
+  }
+
+  m_NumberOfFrames = static_cast<unsigned int>(numberOfFrames);
+  m_TimeStamps.swap(timeStamps);
+  m_Messages.swap(messages);
+  return true;
+}
+
+mitk::PixelType mitk::USImageStreamReader::CreatePixelType() const
+{
+  const unsigned int components = m_Header.m_NumberOfComponents;
+  switch (m_Header.m_ComponentType)
+  {
+  case itk::ImageIOBase::UCHAR:
+    return MakeStreamPixelType<unsigned char>(components);
+  case itk::ImageIOBase::CHAR:
+    return MakeStreamPixelType<char>(components);
+  case itk::ImageIOBase::USHORT:
+    return MakeStreamPixelType<unsigned short>(components);
+  case itk::ImageIOBase::SHORT:
+    return MakeStreamPixelType<short>(components);
+  case itk::ImageIOBase::UINT:
+    return MakeStreamPixelType<unsigned int>(components);
+  case itk::ImageIOBase::INT:
+    return MakeStreamPixelType<int>(components);
+  case itk::ImageIOBase::FLOAT:
+    return MakeStreamPixelType<float>(components);
+  case itk::ImageIOBase::DOUBLE:
+    return MakeStreamPixelType<double>(components);
+  default:
+    mitkThrow() << "Component type " << m_Header.m_ComponentType << " of ultrasound stream file " << m_FileName
+      << " is not supported.";
+  }
+}
+
+mitk::Image::Pointer mitk::USImageStreamReader::GetImage()
+{
+  if (m_FileName.empty())
+  {
+    mitkThrow() << "No ultrasound stream file was opened.";
+  }
+  if (m_NumberOfFrames == 0)
+  {
+    mitkThrow() << "Ultrasound stream file " << m_FileName << " contains no frames.";
+  }
+
+  unsigned int dimensions[4] = { m_Header.m_Dimensions[0], m_Header.m_Dimensions[1], m_Header.m_Dimensions[2],
+    m_NumberOfFrames };
+
+  mitk::Image::Pointer image = mitk::Image::New();
+  image->Initialize(this->CreatePixelType(), 4, dimensions);
+
+  mitk::Vector3D spacing;
+  mitk::Point3D origin;
+  for (int i = 0; i < 3; i++)
+  {
+    spacing[i] = m_Header.m_Spacing[i];
+    origin[i] = m_Header.m_Origin[i];
+  }
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+
+  // the frames are not read, pages of the file are loaded when a time step is accessed
+  mitk::MemoryMappedFile::Pointer mapping = mitk::MemoryMappedFile::Open(m_FileName, sizeof(m_Header),
+    static_cast<unsigned long long>(m_NumberOfFrames) * m_FrameSize);
+  if (!image->SetMemoryMappedChannel(mapping))
+  {
+    mitkThrow() << "Cannot map the frames of ultrasound stream file " << m_FileName << ".";
+  }
+
+  bool increasingTimeStamps = m_TimeStamps.size() == m_NumberOfFrames;
+  for (std::size_t i = 1; increasingTimeStamps && i < m_TimeStamps.size(); i++)
+  {
+    increasingTimeStamps = m_TimeStamps[i] > m_TimeStamps[i - 1];
+  }
+
+  mitk::BaseGeometry::Pointer frameGeometry = image->GetGeometry(0)->Clone();
+  if (increasingTimeStamps)
+  {
+    // each frame is valid until the next one arrived, the last frame for the mean frame interval
+    double meanInterval = m_NumberOfFrames > 1
+      ? (m_TimeStamps.back() - m_TimeStamps.front()) / (m_NumberOfFrames - 1) : 1.0;
+    mitk::ArbitraryTimeGeometry::Pointer timeGeometry = mitk::ArbitraryTimeGeometry::New();
+    for (unsigned int i = 0; i < m_NumberOfFrames; i++)
+    {
+      double end = i + 1 < m_NumberOfFrames ? m_TimeStamps[i + 1] : m_TimeStamps[i] + meanInterval;
+      timeGeometry->AppendTimeStepClone(frameGeometry, end, m_TimeStamps[i]);
+    }
+    image->SetTimeGeometry(timeGeometry);
+  }
+  else
+  {
+    mitk::ProportionalTimeGeometry::Pointer timeGeometry = mitk::ProportionalTimeGeometry::New();
+    timeGeometry->Initialize(frameGeometry, m_NumberOfFrames);
+    image->SetTimeGeometry(timeGeometry);
+  }
+
+  return image;
+}
@@ -0,0 +1,83 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageStreamReader_H_HEADER_INCLUDED_
+#define MITKUSImageStreamReader_H_HEADER_INCLUDED_
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+#include "mitkUSImageStreamWriter.h"
+
+// ITK
+#include <itkObject.h>
+
+namespace mitk {
+  /** An object of this class opens an ultrasound stream file written by USImageStreamWriter.
+   *
+   *  GetImage() returns all frames as one 3D+t image whose data is memory mapped from the file.
+   *  No frame is read before it is accessed, so recordings larger than the physical memory can
+   *  be opened. The time geometry of the image uses the logged MITK system timestamps.
+   *
+   *  \ingroup US
+   */
+  class MITKUS_EXPORT USImageStreamReader : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageStreamReader, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /** Reads header and index of the file.
+     *  @throw mitk::Exception Throws an exception if the file cannot be read or is not an ultrasound stream file.
+     */
+    void Open(const std::string& fileName);
+
+    /** Returns the frames as 3D+t image. The image references the file, it must not be changed or deleted
+     *  while the image is in use.
+     *  @throw mitk::Exception Throws an exception if no file was opened or the file cannot be mapped.
+     */
+    mitk::Image::Pointer GetImage();
+
+    unsigned int GetNumberOfFrames() const { return m_NumberOfFrames; }
+    unsigned long long GetNumberOfDroppedFrames() const { return m_NumberOfDroppedFrames; }
+
+    /** MITK system timestamps of the frames. Empty if the file has no index. */
+    const std::vector<double>& GetTimeStamps() const { return m_TimeStamps; }
+    /** Messages of the frames, the key is the frame index. */
+    const std::map<unsigned long long, std::string>& GetMessages() const { return m_Messages; }
+
+    /** False if the writer was not closed properly, i.e. there are no timestamps and messages. */
+    bool HasIndex() const { return m_HasIndex; }
+
+  protected:
+    USImageStreamReader();
+    virtual ~USImageStreamReader();
+
+    bool ReadIndex(std::istream& stream, unsigned long long fileSize);
+    mitk::PixelType CreatePixelType() const;
+
+    std::string m_FileName;
+    USImageStreamHeader m_Header;
+    std::size_t m_FrameSize;
+    unsigned int m_NumberOfFrames;
+    unsigned long long m_NumberOfDroppedFrames;
+    std::vector<double> m_TimeStamps;
+    std::map<unsigned long long, std::string> m_Messages;
+    bool m_HasIndex;
+  };
+} // namespace mitk
+#endif /* MITKUSImageStreamReader_H_HEADER_INCLUDED_ */
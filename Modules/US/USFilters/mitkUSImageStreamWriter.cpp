@@ -0,0 +1,285 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageStreamWriter.h"
+#include <mitkImageReadAccessor.h>
+#include <mitkExceptionMacro.h>
+
+#include <cstring>
+
+namespace
+{
+  static_assert(sizeof(mitk::USImageStreamHeader) == 128, "USImageStreamHeader must not contain padding");
+
+  template <typename T>
+  void WriteValue(std::ostream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+}
+
+mitk::USImageStreamWriter::USImageStreamWriter()
+  : m_QueueCapacity(32),
+    m_StopThread(false),
+    m_WriteFailed(false),
+    m_HeaderInitialized(false),
+    m_FrameSize(0),
+    m_NumberOfFrames(0),
+    m_NumberOfDroppedFrames(0)
+{
+  std::memset(&m_Header, 0, sizeof(m_Header));
+}
+
+mitk::USImageStreamWriter::~USImageStreamWriter()
+{
+  this->Close();
+}
+
+void mitk::USImageStreamWriter::Open(const std::string& fileName)
+{
+  if (this->IsOpen())
+  {
+    mitkThrow() << "Stream writer is already writing to " << m_FileName << ". Close it first.";
+  }
+
+  m_Stream.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_Stream.good())
+  {
+    m_Stream.close();
+    mitkThrow() << "Cannot create ultrasound stream file " << fileName << ".";
+  }
+
+  m_FileName = fileName;
+  m_HeaderInitialized = false;
+  m_WriteFailed = false;
+  m_StopThread = false;
+  m_NumberOfFrames = 0;
+  m_NumberOfDroppedFrames = 0;
+  m_TimeStamps.clear();
+  m_Messages.clear();
+
+  m_Thread = std::thread(&USImageStreamWriter::WriterThread, this);
+}
+
+bool mitk::USImageStreamWriter::IsOpen() const
+{
+  return m_Thread.joinable();
+}
+
+void mitk::USImageStreamWriter::InitializeHeader(const mitk::Image* image)
+{
+  std::memcpy(m_Header.m_Magic, USImageStreamHeaderMagic, sizeof(USImageStreamHeaderMagic));
+  m_Header.m_Version = 1;
+  m_Header.m_ByteOrderMark = 0x01020304;
+
+  const mitk::PixelType pixelType = image->GetPixelType();
+  m_Header.m_ComponentType = pixelType.GetComponentType();
+  m_Header.m_PixelType = pixelType.GetPixelType();
+  m_Header.m_NumberOfComponents = static_cast<unsigned int>(pixelType.GetNumberOfComponents());
+  m_Header.m_BytesPerComponent = static_cast<unsigned int>(pixelType.GetSize() / pixelType.GetNumberOfComponents());
+
+  const mitk::BaseGeometry* geometry = image->GetGeometry();
+  for (int i = 0; i < 3; i++)
+  {
+    m_Header.m_Dimensions[i] = image->GetDimension(i);
+    m_Header.m_Spacing[i] = geometry->GetSpacing()[i];
+    m_Header.m_Origin[i] = geometry->GetOrigin()[i];
+  }
+
+  m_FrameSize = static_cast<std::size_t>(m_Header.m_Dimensions[0]) * m_Header.m_Dimensions[1] * m_Header.m_Dimensions[2]
+    * pixelType.GetSize();
+  m_HeaderInitialized = true;
+}
+
+bool mitk::USImageStreamWriter::AddFrame(const mitk::Image* image, double timeStamp)
+{
+  if (!this->IsOpen())
+  {
+    MITK_WARN << "Ultrasound stream writer is not open. Ignoring frame.";
+    return false;
+  }
+
+  if (image == nullptr || !image->IsInitialized() || image->GetDimension(3) > 1)
+  {
+    MITK_WARN << "Only initialized images with a single time step can be streamed. Dropping frame.";
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_NumberOfDroppedFrames;
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+
+  if (!m_HeaderInitialized)
+  {
+    this->InitializeHeader(image);
+  }
+  else if (image->GetDimension(0) != m_Header.m_Dimensions[0] || image->GetDimension(1) != m_Header.m_Dimensions[1]
+    || image->GetDimension(2) != m_Header.m_Dimensions[2]
+    || image->GetPixelType().GetComponentType() != m_Header.m_ComponentType
+    || image->GetPixelType().GetNumberOfComponents() != m_Header.m_NumberOfComponents)
+  {
+    MITK_WARN << "Frame does not match size and pixel type of the first streamed frame. Dropping frame.";
+    ++m_NumberOfDroppedFrames;
+    return false;
+  }
+
+  if (m_WriteFailed || m_Queue.size() >= m_QueueCapacity)
+  {
+    ++m_NumberOfDroppedFrames;
+    return false;
+  }
+
+  Frame frame;
+  if (!m_FreeBuffers.empty())
+  {
+    frame.m_Data.swap(m_FreeBuffers.back());
+    m_FreeBuffers.pop_back();
+  }
+  frame.m_TimeStamp = timeStamp;
+  lock.unlock();
+
+  // copy outside of the lock, the writer thread only needs the lock to take frames from the queue
+  frame.m_Data.resize(m_FrameSize);
+  {
+    mitk::ImageReadAccessor accessor(image, image->GetVolumeData(0));
+    std::memcpy(frame.m_Data.data(), accessor.GetData(), m_FrameSize);
+  }
+
+  lock.lock();
+  m_Queue.push_back(std::move(frame));
+  m_TimeStamps.push_back(timeStamp);
+  ++m_NumberOfFrames;
+  lock.unlock();
+
+  m_FrameAvailable.notify_one();
+  return true;
+}
+
+void mitk::USImageStreamWriter::AddMessageToLastFrame(const std::string& message)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (m_NumberOfFrames == 0)
+  {
+    MITK_WARN << "No frame was streamed yet. Ignoring message.";
+    return;
+  }
+  std::string& frameMessage = m_Messages[m_NumberOfFrames - 1];
+  frameMessage = frameMessage.empty() ? message : frameMessage + " " + message;
+}
+
+void mitk::USImageStreamWriter::WriterThread()
+{
+  bool headerWritten = false;
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while (true)
+  {
+    m_FrameAvailable.wait(lock, [this] { return m_StopThread || !m_Queue.empty(); });
+    if (m_Queue.empty())
+      break; // stop requested and everything is written
+
+    Frame frame = std::move(m_Queue.front());
+    m_Queue.pop_front();
+    lock.unlock();
+
+    if (!headerWritten)
+    {
+      // the header was initialized from the first frame before it was queued
+      m_Stream.write(reinterpret_cast<const char*>(&m_Header), sizeof(m_Header));
+      headerWritten = true;
+    }
+    m_Stream.write(frame.m_Data.data(), frame.m_Data.size());
+
+    lock.lock();
+    if (!m_Stream.good() && !m_WriteFailed)
+    {
+      MITK_ERROR << "Writing to ultrasound stream file " << m_FileName << " failed. Further frames are dropped.";
+      m_WriteFailed = true;
+    }
+    m_FreeBuffers.push_back(std::vector<char>());
+    m_FreeBuffers.back().swap(frame.m_Data);
+  }
+}
+
+void mitk::USImageStreamWriter::WriteIndex()
+{
+  unsigned long long indexOffset = static_cast<unsigned long long>(m_Stream.tellp());
+
+  m_Stream.write(USImageStreamIndexMagic, sizeof(USImageStreamIndexMagic));
+  WriteValue(m_Stream, m_NumberOfFrames);
+  WriteValue(m_Stream, m_NumberOfDroppedFrames);
+  if (!m_TimeStamps.empty())
+    m_Stream.write(reinterpret_cast<const char*>(m_TimeStamps.data()), m_TimeStamps.size() * sizeof(double));
+
+  unsigned int numberOfMessages = static_cast<unsigned int>(m_Messages.size());
+  WriteValue(m_Stream, numberOfMessages);
+  for (auto it = m_Messages.begin(); it != m_Messages.end(); ++it)
+  {
+    unsigned long long frameIndex = it->first;
+    unsigned int length = static_cast<unsigned int>(it->second.size());
+    WriteValue(m_Stream, frameIndex);
+    WriteValue(m_Stream, length);
+    m_Stream.write(it->second.data(), length);
+  }
+
+  WriteValue(m_Stream, indexOffset);
+  m_Stream.write(USImageStreamEndMagic, sizeof(USImageStreamEndMagic));
+}
+
+void mitk::USImageStreamWriter::Close()
+{
+  if (!this->IsOpen())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_StopThread = true;
+  }
+  m_FrameAvailable.notify_one();
+  m_Thread.join();
+
+  if (m_HeaderInitialized && m_NumberOfFrames > 0 && m_Stream.good())
+  {
+    this->WriteIndex();
+  }
+  m_Stream.close();
+
+  m_Queue.clear();
+  m_FreeBuffers.clear();
+
+  if (m_NumberOfDroppedFrames > 0)
+  {
+    MITK_WARN << m_NumberOfDroppedFrames << " ultrasound frames were dropped while streaming to " << m_FileName << ".";
+  }
+}
+
+unsigned long long mitk::USImageStreamWriter::GetNumberOfFrames() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_NumberOfFrames;
+}
+
+unsigned long long mitk::USImageStreamWriter::GetNumberOfDroppedFrames() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_NumberOfDroppedFrames;
+}
+
+unsigned int mitk::USImageStreamWriter::GetQueueSize() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return static_cast<unsigned int>(m_Queue.size());
+}
@@ -0,0 +1,153 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageStreamWriter_H_HEADER_INCLUDED_
+#define MITKUSImageStreamWriter_H_HEADER_INCLUDED_
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+
+// ITK
+#include <itkObject.h>
+
+// STL
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mitk {
+  /** Markers of the header, the index and the end of an ultrasound image stream file */
+  const char USImageStreamHeaderMagic[8] = { 'U', 'S', 'S', 'T', 'R', 'E', 'A', 'M' };
+  const char USImageStreamIndexMagic[8] = { 'U', 'S', 'S', 'T', 'R', 'I', 'D', 'X' };
+  const char USImageStreamEndMagic[8] = { 'U', 'S', 'S', 'T', 'R', 'E', 'N', 'D' };
+
+  /** Header of an ultrasound image stream file, see USImageStreamWriter for the layout of the file. */
+  struct USImageStreamHeader
+  {
+    char m_Magic[8];
+    unsigned int m_Version;
+    unsigned int m_ByteOrderMark;
+    int m_ComponentType;                ///< itk::ImageIOBase::IOComponentType
+    int m_PixelType;                    ///< itk::ImageIOBase::IOPixelType
+    unsigned int m_NumberOfComponents;
+    unsigned int m_BytesPerComponent;
+    unsigned int m_Dimensions[3];
+    unsigned int m_Padding;
+    double m_Spacing[3];
+    double m_Origin[3];
+    char m_Reserved[32];
+  };
+
+  /** An object of this class writes ultrasound frames to a single append-only stream file in a
+   *  background thread. AddFrame() only copies the pixel data into a buffer of a bounded queue,
+   *  so the acquisition is never blocked by the hard disc. If the queue is full, the frame is
+   *  dropped and counted.
+   *
+   *  File layout (values in the byte order of the writing machine):
+   *  - USImageStreamHeader (128 bytes) describing the pixel type and geometry of the frames
+   *  - the raw pixel data of all frames, one after the other, so they form the channel of a 3D+t image
+   *  - an index which is appended by Close(): "USSTRIDX", number of frames, number of dropped frames
+   *    (both 64 bit), the MITK system timestamp of every frame (double), the number of messages and
+   *    the messages (frame index, length, characters), followed by the offset of the index (64 bit)
+   *    and "USSTREND".
+   *
+   *  If the index is missing because the acquisition was not closed properly, USImageStreamReader
+   *  can still read all complete frames, but without timestamps.
+   *
+   *  All frames must have the pixel type and size of the first one, other frames are dropped.
+   *
+   *  \ingroup US
+   */
+  class MITKUS_EXPORT USImageStreamWriter : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageStreamWriter, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /** Maximum number of frames waiting to be written. Default is 32. Must be set before Open(). */
+    itkSetMacro(QueueCapacity, unsigned int);
+    itkGetMacro(QueueCapacity, unsigned int);
+
+    /** Creates the file and starts the writer thread. The header is written with the first frame.
+     *  @throw mitk::Exception Throws an exception if the file cannot be created or the writer is already open.
+     */
+    void Open(const std::string& fileName);
+
+    /** Waits until all queued frames are written, appends the index and closes the file. */
+    void Close();
+
+    bool IsOpen() const;
+
+    /** Copies the frame into the queue.
+     *  @return false if the frame was dropped because the queue is full, the frame does not match the
+     *          first frame or writing to the file failed.
+     */
+    bool AddFrame(const mitk::Image* image, double timeStamp);
+
+    /** Adds a message to the last frame which was accepted by AddFrame(). */
+    void AddMessageToLastFrame(const std::string& message);
+
+    /** Number of frames accepted by AddFrame() since Open(). */
+    unsigned long long GetNumberOfFrames() const;
+    unsigned long long GetNumberOfDroppedFrames() const;
+    /** Number of frames currently waiting to be written. */
+    unsigned int GetQueueSize() const;
+
+    static const char* GetFileExtension() { return ".usstream"; }
+
+  protected:
+    USImageStreamWriter();
+    virtual ~USImageStreamWriter();
+
+    struct Frame
+    {
+      std::vector<char> m_Data;
+      double m_TimeStamp;
+    };
+
+    void InitializeHeader(const mitk::Image* image);
+    void WriterThread();
+    void WriteIndex();
+
+    std::string m_FileName;
+    std::ofstream m_Stream;
+    std::thread m_Thread;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_FrameAvailable;
+    std::deque<Frame> m_Queue;
+    std::vector< std::vector<char> > m_FreeBuffers; ///< buffers of written frames, reused for new frames
+    unsigned int m_QueueCapacity;
+    bool m_StopThread;
+    bool m_WriteFailed;
+
+    bool m_HeaderInitialized;
+    USImageStreamHeader m_Header;
+    std::size_t m_FrameSize;
+
+    unsigned long long m_NumberOfFrames;
+    unsigned long long m_NumberOfDroppedFrames;
+    std::vector<double> m_TimeStamps;
+    std::map<unsigned long long, std::string> m_Messages;
+  };
+} // namespace mitk
+#endif /* MITKUSImageStreamWriter_H_HEADER_INCLUDED_ */